@@ -70,3 +70,30 @@ LOCAL_MODULE := libhalaudiodump_host
 $(call make_hal_dump_lib,host)
 LOCAL_STATIC_LIBRARIES := libaudio_comms_utilities_host
 include $(BUILD_HOST_STATIC_LIBRARY)
+
+
+# Component functional test
+#######################################################################
+hal_dump_fcttest_src_files := \
+    test/HalAudioDumpTest.cpp
+
+hal_dump_fcttest_c_includes_host := \
+    $(call include-path-for, libc-kernel) \
+    external/gtest/include
+
+hal_dump_fcttest_static_lib_host := \
+    libhalaudiodump_host \
+    libaudio_comms_utilities_host \
+    liblog \
+    libgtest_host \
+    libgtest_main_host
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := hal_audio_dump_fcttest_host
+LOCAL_SRC_FILES := $(hal_dump_fcttest_src_files)
+LOCAL_C_INCLUDES := $(hal_dump_includes_common) $(hal_dump_fcttest_c_includes_host)
+LOCAL_CFLAGS := $(hal_dump_cflags)
+LOCAL_STATIC_LIBRARIES := $(hal_dump_fcttest_static_lib_host)
+LOCAL_LDFLAGS += -pthread
+LOCAL_MODULE_TAGS := tests
+include $(BUILD_HOST_EXECUTABLE)
@@ -27,9 +27,12 @@
 
 #include <utilities/Log.hpp>
 #include <stdlib.h>
+#include <stdio.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <string.h>
+#include <errno.h>
 #include <utils/Errors.h>
 
 using namespace android;
@@ -39,23 +42,57 @@ using audio_comms::utilities::Log;
 const char *HalAudioDump::mStreamDirections[] = {
     "in", "out"
 };
-const char *HalAudioDump::mDumpDirPath = "/logs/audio_dumps";
+const char *HalAudioDump::mDefaultDumpDirPath = "/logs/audio_dumps";
 const uint32_t HalAudioDump::mMaxNumberOfFiles = 4;
 
-HalAudioDump::HalAudioDump()
-    : mDumpFile(0), mFileCount(0)
+HalAudioDump::HalAudioDump(const char *dumpDirPath, uint32_t ringSize)
+    : mDumpDirPath(dumpDirPath ? dumpDirPath : mDefaultDumpDirPath),
+      mNameContextSet(false),
+      mRing(NULL),
+      mRingSize(0),
+      mWritePosition(0),
+      mReadPosition(0),
+      mWakeupPending(0),
+      mOverrunCount(0),
+      mDroppedBytes(0),
+      mWriterStarted(false),
+      mStopRequested(false),
+      mCloseRequested(false),
+      mWakeup(0),
+      mCloseDone(0),
+      mDumpFd(-1),
+      mFileBytes(0),
+      mFileCount(0),
+      mBatch(NULL),
+      mBatchBytes(0)
 {
-    if (mkdir(mDumpDirPath, S_IRWXU | S_IRGRP | S_IROTH) != 0) {
+    memset(&mFileFormat, 0, sizeof(mFileFormat));
+
+    if (mkdir(mDumpDirPath.c_str(), S_IRWXU | S_IRGRP | S_IROTH) != 0 && errno != EEXIST) {
         Log::Error() << "Cannot create audio dumps directory at " << mDumpDirPath
                      << " : " << strerror(errno);
     }
+
+    // the ring positions wrap around 2^32, the size must divide it
+    mRingSize = 4096;
+    while (mRingSize < ringSize && mRingSize < (1u << 30)) {
+        mRingSize <<= 1;
+    }
+    mRing = new uint8_t[mRingSize];
+    mBatch = new uint8_t[mBatchSize];
+
+    if (pthread_create(&mWriterThread, NULL, writerThread, this) != 0) {
+        Log::Error() << __FUNCTION__ << ": Cannot start dump writer thread, dump disabled";
+        return;
+    }
+    mWriterStarted = true;
 }
 
 HalAudioDump::~HalAudioDump()
 {
-    if (mDumpFile) {
-        close();
-    }
+    stopWriter();
+    delete[] mRing;
+    delete[] mBatch;
 }
 
 void HalAudioDump::dumpAudioSamples(const void *buffer,
@@ -63,124 +100,315 @@ void HalAudioDump::dumpAudioSamples(const void *buffer,
                                     bool isOutput,
                                     uint32_t sRate,
                                     uint32_t chNb,
-                                    const std::string &nameContext)
-{
-    status_t write_status;
-
-    if (mDumpFile == NULL) {
-        char *audio_file_name;
-
-        /**
-         * A new dump file is created for each stream relevant to the dump needs
-         */
-        asprintf(&audio_file_name,
-                 "%s/audio_%s_%dKhz_%dch_%s_%d.pcm",
-                 mDumpDirPath,
-                 streamDirectionStr(isOutput),
-                 sRate,
-                 chNb,
-                 nameContext.c_str(),
-                 ++mFileCount);
-
-        if (!audio_file_name) {
-            return;
-        }
-
-        mDumpFile = fopen(audio_file_name, "wb");
+                                    const std::string &nameContext,
+                                    uint32_t sampleSize)
+{
+    if (!mWriterStarted || buffer == NULL || bytes <= 0) {
+        return;
+    }
+    if (!mNameContextSet) {
+        // published to the writer thread with the first record
+        mNameContext = nameContext;
+        mNameContextSet = true;
+    }
 
-        if (mDumpFile == NULL) {
-            Log::Error() << __FUNCTION__
-                         << ": Cannot open dump file " << audio_file_name
-                         << " errno " << errno << ", reason: " << strerror(errno);
-            free(audio_file_name);
-            return;
-        }
-        Log::Info() << __FUNCTION__
-                    << ": Audio " << streamDirectionStr(isOutput)
-                    << "put stream dump file " << audio_file_name
-                    << ", fh " << mDumpFile << " opened.";
-        free(audio_file_name);
+    uint32_t needed = sizeof(Record) + bytes;
+    uint32_t used = mWritePosition - __atomic_load_n(&mReadPosition, __ATOMIC_ACQUIRE);
+    if (needed > mRingSize - used) {
+        __atomic_fetch_add(&mOverrunCount, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&mDroppedBytes, (uint32_t)bytes, __ATOMIC_RELAXED);
+    } else {
+        Record record;
+        record.bytes = bytes;
+        record.samplingRate = sRate;
+        record.channelNb = chNb;
+        record.sampleSize = sampleSize;
+        record.isOutput = isOutput;
+        ringWrite(mWritePosition, &record, sizeof(record));
+        ringWrite(mWritePosition + sizeof(record), buffer, bytes);
+        __atomic_store_n(&mWritePosition, mWritePosition + needed, __ATOMIC_RELEASE);
+        used += needed;
     }
 
-    write_status = writeDumpFile(buffer, bytes);
+    // one wake up per batch, the writer thread also wakes up periodically
+    if (used >= mRingSize / mWakeupFillDivider
+        && !__atomic_exchange_n(&mWakeupPending, 1, __ATOMIC_ACQ_REL)) {
+        mWakeup.post();
+    }
+}
 
-    if (write_status == BAD_VALUE) {
+void HalAudioDump::close()
+{
+    if (!mWriterStarted) {
+        return;
+    }
+    __atomic_store_n(&mCloseRequested, true, __ATOMIC_RELEASE);
+    mWakeup.post();
+    mCloseDone.wait();
+}
 
-        /**
-         * Max file size reached. Close file to open another one
-         * Up to 4 dump files are dumped. When 4 dump files are
-         * reached the last file is reused circularly.
-         */
-        close();
+void HalAudioDump::stopWriter()
+{
+    if (!mWriterStarted) {
+        return;
     }
+    __atomic_store_n(&mStopRequested, true, __ATOMIC_RELEASE);
+    mWakeup.post();
+    pthread_join(mWriterThread, NULL);
+    mWriterStarted = false;
+}
 
-    /**
-     * Roll on 4 files, to keep at least the last audio dumps
-     * and to split dumps for more convenience.
-     */
-    if (write_status == INVALID_OPERATION) {
-        char *fileToRemove;
-
-        asprintf(&fileToRemove,
-                 "%s/audio_%s_%dKhz_%dch_%s_%d.pcm",
-                 mDumpDirPath,
-                 streamDirectionStr(isOutput),
-                 sRate,
-                 chNb,
-                 nameContext.c_str(),
-                 mFileCount);
-
-        if (!fileToRemove) {
-            return;
+uint32_t HalAudioDump::getOverrunCount() const
+{
+    return __atomic_load_n(&mOverrunCount, __ATOMIC_RELAXED);
+}
+
+uint32_t HalAudioDump::getDroppedBytes() const
+{
+    return __atomic_load_n(&mDroppedBytes, __ATOMIC_RELAXED);
+}
+
+const char *HalAudioDump::streamDirectionStr(bool isOut) const
+{
+    return mStreamDirections[isOut];
+}
+
+void HalAudioDump::ringWrite(uint32_t position, const void *buf, uint32_t bytes)
+{
+    uint32_t offset = position & (mRingSize - 1);
+    uint32_t first = min(bytes, mRingSize - offset);
+    memcpy(mRing + offset, buf, first);
+    memcpy(mRing, static_cast<const uint8_t *>(buf) + first, bytes - first);
+}
+
+void HalAudioDump::ringRead(uint32_t position, void *buf, uint32_t bytes) const
+{
+    uint32_t offset = position & (mRingSize - 1);
+    uint32_t first = min(bytes, mRingSize - offset);
+    memcpy(buf, mRing + offset, first);
+    memcpy(static_cast<uint8_t *>(buf) + first, mRing, bytes - first);
+}
+
+void *HalAudioDump::writerThread(void *dump)
+{
+    static_cast<HalAudioDump *>(dump)->writerLoop();
+    return NULL;
+}
+
+void HalAudioDump::writerLoop()
+{
+    uint32_t overrunsLogged = 0;
+    bool stop = false;
+
+    while (!stop) {
+        mWakeup.wait(static_cast<time_t>(mWriterPeriodMs));
+        __atomic_store_n(&mWakeupPending, 0, __ATOMIC_RELEASE);
+        // requests first: the samples queued before them are drained below
+        stop = __atomic_load_n(&mStopRequested, __ATOMIC_ACQUIRE);
+        bool close = __atomic_exchange_n(&mCloseRequested, false, __ATOMIC_ACQ_REL);
+
+        drain();
+
+        uint32_t overruns = getOverrunCount();
+        if (overruns != overrunsLogged) {
+            Log::Warning() << __FUNCTION__ << ": " << overruns - overrunsLogged
+                           << " buffers dropped, dump storage too slow ("
+                           << getDroppedBytes() << " bytes dropped in total)";
+            overrunsLogged = overruns;
+        }
+        if (stop || close) {
+            closeDumpFile();
+        }
+        if (close) {
+            mCloseDone.post();
         }
+    }
+}
+
+void HalAudioDump::drain()
+{
+    uint32_t writePosition = __atomic_load_n(&mWritePosition, __ATOMIC_ACQUIRE);
 
-        mFileCount--;
+    while (mReadPosition != writePosition) {
+        Record record;
+        ringRead(mReadPosition, &record, sizeof(record));
+        uint32_t position = mReadPosition + sizeof(record);
 
-        remove(fileToRemove);
-        free(fileToRemove);
-        close();
+        if (checkDumpFile(record) == OK) {
+            // samples may wrap around the end of the ring
+            uint32_t offset = position & (mRingSize - 1);
+            uint32_t first = min(record.bytes, mRingSize - offset);
+            writeDumpFile(mRing + offset, first);
+            if (first < record.bytes) {
+                writeDumpFile(mRing, record.bytes - first);
+            }
+            mFileBytes += record.bytes;
+        }
+        __atomic_store_n(&mReadPosition, position + record.bytes, __ATOMIC_RELEASE);
     }
+    flushBatch();
 }
 
-void HalAudioDump::close()
+status_t HalAudioDump::checkDumpFile(const Record &record)
 {
-    fclose(mDumpFile);
-    mDumpFile = NULL;
+    if (mDumpFd >= 0 && (record.samplingRate != mFileFormat.samplingRate
+                         || record.channelNb != mFileFormat.channelNb
+                         || record.sampleSize != mFileFormat.sampleSize
+                         || record.isOutput != mFileFormat.isOutput)) {
+        // a WAV file has one format
+        closeDumpFile();
+    }
+    if (mDumpFd >= 0 && mFileBytes + record.bytes > mMaxDumpFileSize - mWavHeaderSize) {
+        Log::Info() << __FUNCTION__ << ": Max size reached";
+        closeDumpFile();
+    }
+    if (mDumpFd < 0) {
+        openDumpFile(record);
+    }
+    return mDumpFd >= 0 ? OK : NO_INIT;
 }
 
-const char *HalAudioDump::streamDirectionStr(bool isOut) const
+/**
+ * Header of a PCM WAV file, the sizes are completed when the file is closed.
+ */
+static void makeWavHeader(uint8_t *header, uint32_t samplingRate, uint32_t channelNb,
+                          uint32_t sampleSize, uint32_t dataBytes)
 {
-    return mStreamDirections[isOut];
+    struct Field
+    {
+        static void le16(uint8_t *p, uint32_t value)
+        {
+            p[0] = value;
+            p[1] = value >> 8;
+        }
+        static void le32(uint8_t *p, uint32_t value)
+        {
+            le16(p, value);
+            le16(p + 2, value >> 16);
+        }
+    };
+    memcpy(header, "RIFF", 4);
+    Field::le32(header + 4, 36 + dataBytes);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    Field::le32(header + 16, 16);
+    Field::le16(header + 20, 1);   // integer PCM
+    Field::le16(header + 22, channelNb);
+    Field::le32(header + 24, samplingRate);
+    Field::le32(header + 28, samplingRate * channelNb * sampleSize);
+    Field::le16(header + 32, channelNb * sampleSize);
+    Field::le16(header + 34, sampleSize * 8);
+    memcpy(header + 36, "data", 4);
+    Field::le32(header + 40, dataBytes);
 }
 
-status_t HalAudioDump::checkDumpFile(ssize_t bytes)
+void HalAudioDump::openDumpFile(const Record &record)
 {
-    struct stat stDump;
-    if (mDumpFile && fstat(fileno(mDumpFile), &stDump) == 0
-        && (stDump.st_size + bytes) > mMaxDumpFileSize) {
-        Log::Error() << __FUNCTION__ << ": Max size reached";
-        return BAD_VALUE;
+    /**
+     * A new dump file is created for each stream relevant to the dump needs.
+     * Up to 4 dump files are dumped, to keep at least the last audio dumps
+     * and to split dumps for more convenience. When 4 dump files are
+     * reached the last file is reused circularly.
+     */
+    if (mFileCount < mMaxNumberOfFiles) {
+        mFileCount++;
     }
-    if (mFileCount >= mMaxNumberOfFiles) {
-        Log::Error() << __FUNCTION__ << ": Max number of allowed files reached";
-        return INVALID_OPERATION;
+
+    char *audio_file_name = NULL;
+    if (asprintf(&audio_file_name,
+                 "%s/audio_%s_%dKhz_%dch_%s_%d.wav",
+                 mDumpDirPath.c_str(),
+                 streamDirectionStr(record.isOutput),
+                 record.samplingRate,
+                 record.channelNb,
+                 mNameContext.c_str(),
+                 mFileCount) < 0 || !audio_file_name) {
+        return;
     }
-    return OK;
+
+    mDumpFd = ::open(audio_file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (mDumpFd < 0) {
+        Log::Error() << __FUNCTION__
+                     << ": Cannot open dump file " << audio_file_name
+                     << " errno " << errno << ", reason: " << strerror(errno);
+        free(audio_file_name);
+        return;
+    }
+    Log::Info() << __FUNCTION__
+                << ": Audio " << streamDirectionStr(record.isOutput)
+                << "put stream dump file " << audio_file_name
+                << ", fd " << mDumpFd << " opened.";
+    free(audio_file_name);
+
+    mFileFormat = record;
+    mFileBytes = 0;
+    uint8_t header[mWavHeaderSize];
+    makeWavHeader(header, record.samplingRate, record.channelNb, record.sampleSize, 0);
+    writeDumpFile(header, sizeof(header));
 }
 
-status_t HalAudioDump::writeDumpFile(const void *buffer, ssize_t bytes)
+void HalAudioDump::closeDumpFile()
 {
-    status_t ret;
+    if (mDumpFd < 0) {
+        return;
+    }
+    flushBatch();
 
-    ret = checkDumpFile(bytes);
-    if (ret != OK) {
+    // fix up the sizes of the header
+    uint8_t header[mWavHeaderSize];
+    makeWavHeader(header, mFileFormat.samplingRate, mFileFormat.channelNb,
+                  mFileFormat.sampleSize, mFileBytes);
+    if (pwrite(mDumpFd, header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+        Log::Error() << __FUNCTION__
+                     << ": Error writing WAV header in audio dump file : " << strerror(errno);
+    }
+    ::close(mDumpFd);
+    mDumpFd = -1;
+}
 
-        return ret;
+status_t HalAudioDump::writeDumpFile(const void *buffer, size_t bytes)
+{
+    if (mBatchBytes + bytes > mBatchSize) {
+        status_t ret = flushBatch();
+        if (ret != OK) {
+            return ret;
+        }
     }
-    if (fwrite(buffer, bytes, 1, mDumpFile) != 1) {
-        Log::Error() << __FUNCTION__
-                     << ": Error writing PCM in audio dump file : " << strerror(errno);
-        return BAD_VALUE;
+    if (bytes > mBatchSize) {
+        // large enough for a write of its own
+        return writeAll(buffer, bytes);
     }
+    memcpy(mBatch + mBatchBytes, buffer, bytes);
+    mBatchBytes += bytes;
     return OK;
 }
+
+status_t HalAudioDump::flushBatch()
+{
+    status_t ret = writeAll(mBatch, mBatchBytes);
+    mBatchBytes = 0;
+    return ret;
+}
+
+status_t HalAudioDump::writeAll(const void *buffer, size_t bytes)
+{
+    const uint8_t *data = static_cast<const uint8_t *>(buffer);
+    while (bytes > 0) {
+        ssize_t written = writeFile(mDumpFd, data, bytes);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            Log::Error() << __FUNCTION__
+                         << ": Error writing PCM in audio dump file : " << strerror(errno);
+            return BAD_VALUE;
+        }
+        data += written;
+        bytes -= written;
+    }
+    return OK;
+}
+
+ssize_t HalAudioDump::writeFile(int fd, const void *buf, size_t bytes)
+{
+    return ::write(fd, buf, bytes);
+}
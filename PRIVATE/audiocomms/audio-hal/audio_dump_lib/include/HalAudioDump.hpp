@@ -23,27 +23,47 @@
 
 #pragma once
 
+#include <Semaphore.hpp>
+#include <pthread.h>
 #include <stdint.h>
 #include <sys/types.h>
 #include <utils/Errors.h>
 #include <string>
 
+/**
+ * Dumps audio samples of a stream in WAV files, for debug purpose.
+ *
+ * dumpAudioSamples() is called from the audio thread of the stream: it only
+ * copies the samples in a lock-free single producer, single consumer ring
+ * and returns. A writer thread of the dump object drains the ring to the
+ * files, in batches. If the writer falls behind (slow storage), the samples
+ * which do not fit in the ring are dropped and counted as overruns, the
+ * audio thread never waits for the file system.
+ */
 class HalAudioDump
 {
 public:
-    HalAudioDump();
-    ~HalAudioDump();
+    /**
+     * @param[in] dumpDirPath directory of the dump files, NULL for the default one.
+     * @param[in] ringSize size of the ring in bytes, rounded up to a power of 2.
+     */
+    HalAudioDump(const char *dumpDirPath = NULL, uint32_t ringSize = mDefaultRingSize);
+    virtual ~HalAudioDump();
 
     /**
      * Dumps the raw audio samples in a file. The name of the
      * audio file contains the infos on the dump characteristics.
+     * Never blocks: the samples are queued for the writer thread, or dropped
+     * if the ring is full.
      *
      * @param[in] buf const pointer the buffer to be dumped.
      * @param[in] bytes size in bytes to be written.
      * @param[in] isOutput  boolean for direction of the stream.
      * @param[in] samplingRate sample rate of the stream.
      * @param[in] channelNb number of channels in the sample spec.
-     * @param[in] nameContext context of the dump to be appended in the name of the dump file.
+     * @param[in] nameContext context of the dump to be appended in the name of the dump file,
+     *                        taken on the first call only.
+     * @param[in] sampleSize size of a sample in bytes.
      *
      **/
     void dumpAudioSamples(const void *buf,
@@ -53,11 +73,53 @@ public:
                                                  // is unbound to the route manager, to
                                                  // avoid circular dependencies
                           uint32_t channelNb,
-                          const std::string &nameContext);
+                          const std::string &nameContext,
+                          uint32_t sampleSize = 2);
 
+    /**
+     * Writes the samples queued so far and closes the current dump file,
+     * with its WAV header completed. The next samples go to a new file.
+     * Must not be called from the audio thread.
+     */
     void close();
 
+    /**
+     * Number of dumpAudioSamples() calls whose samples were dropped as the ring was full.
+     */
+    uint32_t getOverrunCount() const;
+
+    /**
+     * Number of bytes of samples dropped as the ring was full.
+     */
+    uint32_t getDroppedBytes() const;
+
+protected:
+    /**
+     * Writes to a dump file, on the writer thread.
+     * Subclasses overriding it must call stopWriter() in their destructor.
+     *
+     * @return number of bytes written, or -1 with errno set.
+     */
+    virtual ssize_t writeFile(int fd, const void *buf, size_t bytes);
+
+    /**
+     * Writes the queued samples, closes the dump file and stops the writer thread.
+     */
+    void stopWriter();
+
 private:
+    /**
+     * Format of the samples of a dumpAudioSamples() call, in the ring before them.
+     */
+    struct Record
+    {
+        uint32_t bytes;
+        uint32_t samplingRate;
+        uint16_t channelNb;
+        uint8_t sampleSize;
+        uint8_t isOutput;
+    };
+
     /**
      * Returns the string of the stream direction.
      *
@@ -67,20 +129,32 @@ private:
      */
     const char *streamDirectionStr(bool isOut) const;
 
+    static void *writerThread(void *dump);
+    void writerLoop();
+
     /**
-     * Checks if dump file is ready for operation.
-     * It not only checks the validity and rights of the dump file, but also
-     * if the size will not reach the maximum allowed size.
+     * Copies from and to the ring, across its end.
+     */
+    void ringWrite(uint32_t position, const void *buf, uint32_t bytes);
+    void ringRead(uint32_t position, void *buf, uint32_t bytes) const;
+
+    /**
+     * Writes the records queued in the ring, on the writer thread.
+     */
+    void drain();
+
+    /**
+     * Checks if dump file is ready for operation: opens it if needed, or the next one
+     * if the size would reach the maximum allowed size.
      *
-     * @param[in] bytes size expected to be written in the dump file.
+     * @param[in] record format and size of the samples to be written in the dump file.
      *
      * @return OK if ready to write, error code otherwise.
      */
-    android::status_t checkDumpFile(ssize_t bytes);
+    android::status_t checkDumpFile(const Record &record);
 
     /**
-     * Writes the PCM samples in the dump file.
-     * Checks that file size does not exceed its maximum size.
+     * Writes the PCM samples in the dump file, through the batch buffer.
      *
      * @param[in] buf const pointer to the buffer to be dumped.
      * @param[in] bytes size in bytes to be written.
@@ -88,10 +162,44 @@ private:
      * @return error code.
      **/
     android::status_t writeDumpFile(const void *buf,
-                                    ssize_t bytes);
+                                    size_t bytes);
+
+    android::status_t flushBatch();
+    android::status_t writeAll(const void *buf, size_t bytes);
+    void openDumpFile(const Record &record);
+    void closeDumpFile();
+
+    std::string mDumpDirPath;
+    std::string mNameContext;   /**< set by the first dumpAudioSamples() call */
+    bool mNameContextSet;
+
+    /**
+     * Ring of records followed by their samples. mWritePosition and mReadPosition
+     * only increase, modulo 2^32; the producer owns mWritePosition, the writer
+     * thread mReadPosition.
+     */
+    uint8_t *mRing;
+    uint32_t mRingSize;
+    uint32_t mWritePosition;
+    uint32_t mReadPosition;
+    uint32_t mWakeupPending;    /**< writer thread already woken up */
+    uint32_t mOverrunCount;
+    uint32_t mDroppedBytes;
 
-    FILE *mDumpFile;
+    pthread_t mWriterThread;
+    bool mWriterStarted;
+    bool mStopRequested;
+    bool mCloseRequested;
+    audio_comms::utilities::Semaphore mWakeup;
+    audio_comms::utilities::Semaphore mCloseDone;
+
+    /** Writer thread state */
+    int mDumpFd;
+    Record mFileFormat;         /**< format of the samples in the dump file */
+    uint32_t mFileBytes;        /**< bytes of samples in the dump file */
     uint32_t mFileCount;
+    uint8_t *mBatch;
+    uint32_t mBatchBytes;
 
     /**
      * Maximum number of files per dump instance.
@@ -106,11 +214,30 @@ private:
     /**
      * Dump directory path to store audio dump files.
      */
-    static const char *mDumpDirPath;
+    static const char *mDefaultDumpDirPath;
 
     /**
      * Limit file size to about 20 MB for audio dump files
      * to avoid filling the mass storage to the brim.
      */
     static const uint32_t mMaxDumpFileSize = 20 * 1024 * 1024;
+
+    /**
+     * About 2.7 s of 48 kHz stereo 16 bits samples.
+     */
+    static const uint32_t mDefaultRingSize = 512 * 1024;
+
+    /**
+     * Size of the writes to the dump file.
+     */
+    static const uint32_t mBatchSize = 64 * 1024;
+
+    /**
+     * The writer thread is woken up when the ring is filled by this fraction,
+     * otherwise every mWriterPeriodMs.
+     */
+    static const uint32_t mWakeupFillDivider = 4;
+    static const uint32_t mWriterPeriodMs = 100;
+
+    static const uint32_t mWavHeaderSize = 44;
 };
@@ -0,0 +1,214 @@
+/*
+ * INTEL CONFIDENTIAL
+ * Copyright (c) 2014 Intel
+ * Corporation All Rights Reserved.
+ *
+ * The source code contained or described herein and all documents related to
+ * the source code ("Material") are owned by Intel Corporation or its suppliers
+ * or licensors. Title to the Material remains with Intel Corporation or its
+ * suppliers and licensors. The Material contains trade secrets and proprietary
+ * and confidential information of Intel or its suppliers and licensors. The
+ * Material is protected by worldwide copyright and trade secret laws and
+ * treaty provisions. No part of the Material may be used, copied, reproduced,
+ * modified, published, uploaded, posted, transmitted, distributed, or
+ * disclosed in any way without Intel's prior express written permission.
+ *
+ * No license under any patent, copyright, trade secret or other intellectual
+ * property right is granted to or conferred upon you by disclosure or delivery
+ * of the Materials, either expressly, by implication, inducement, estoppel or
+ * otherwise. Any license under such intellectual property rights must be
+ * express and approved by Intel in writing.
+ *
+ */
+
+#include <HalAudioDump.hpp>
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/**
+ * Dump object whose file writes take at least a given time, as a slow storage.
+ */
+class ThrottledDump : public HalAudioDump
+{
+public:
+    ThrottledDump(const char *dir, uint32_t ringSize, uint32_t writeDelayUs)
+        : HalAudioDump(dir, ringSize), mWriteDelayUs(writeDelayUs), mWrites(0)
+    {}
+
+    ~ThrottledDump()
+    {
+        stopWriter();
+    }
+
+    uint32_t mWriteDelayUs;
+    uint32_t mWrites;
+
+protected:
+    virtual ssize_t writeFile(int fd, const void *buf, size_t bytes)
+    {
+        usleep(mWriteDelayUs);
+        mWrites++;
+        return HalAudioDump::writeFile(fd, buf, bytes);
+    }
+};
+
+class HalAudioDumpTest : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        char dir[] = "/tmp/halaudiodumpXXXXXX";
+        ASSERT_TRUE(mkdtemp(dir) != NULL);
+        mDir = dir;
+    }
+
+    virtual void TearDown()
+    {
+        string command = "rm -rf " + mDir;
+        system(command.c_str());
+    }
+
+    string fileName(const char *direction, uint32_t rate, uint32_t channels, uint32_t index)
+    {
+        char name[256];
+        snprintf(name, sizeof(name), "%s/audio_%s_%dKhz_%dch_test_%d.wav",
+                 mDir.c_str(), direction, rate, channels, index);
+        return name;
+    }
+
+    static bool readFile(const string &name, vector<uint8_t> &content)
+    {
+        FILE *file = fopen(name.c_str(), "rb");
+        if (file == NULL) {
+            return false;
+        }
+        uint8_t buffer[4096];
+        size_t bytes;
+        content.clear();
+        while ((bytes = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            content.insert(content.end(), buffer, buffer + bytes);
+        }
+        fclose(file);
+        return true;
+    }
+
+    static uint32_t le32(const uint8_t *p)
+    {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    static uint16_t le16(const uint8_t *p)
+    {
+        return p[0] | (p[1] << 8);
+    }
+
+    static int64_t nowNs()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    string mDir;
+};
+
+TEST_F(HalAudioDumpTest, WavFile)
+{
+    HalAudioDump dump(mDir.c_str());
+    vector<int16_t> samples(48 * 2 * 10);
+    for (size_t i = 0; i < samples.size(); i++) {
+        samples[i] = i;
+    }
+    // 10 ms buffers, from the end of the ring to its start several times
+    const uint32_t buffers = 1000;
+    for (uint32_t i = 0; i < buffers; i++) {
+        dump.dumpAudioSamples(&samples[0], samples.size() * 2, true, 48000, 2, "test");
+        if ((i % 100) == 0) {
+            usleep(20000);
+        }
+    }
+    dump.close();
+
+    vector<uint8_t> content;
+    ASSERT_TRUE(readFile(fileName("out", 48000, 2, 1), content));
+    uint32_t dataBytes = buffers * samples.size() * 2 - dump.getDroppedBytes();
+    ASSERT_EQ(44 + dataBytes, content.size());
+    EXPECT_EQ(0, memcmp(&content[0], "RIFF", 4));
+    EXPECT_EQ(36 + dataBytes, le32(&content[4]));
+    EXPECT_EQ(0, memcmp(&content[8], "WAVEfmt ", 8));
+    EXPECT_EQ(1u, le16(&content[20]));
+    EXPECT_EQ(2u, le16(&content[22]));
+    EXPECT_EQ(48000u, le32(&content[24]));
+    EXPECT_EQ(48000u * 4, le32(&content[28]));
+    EXPECT_EQ(4u, le16(&content[32]));
+    EXPECT_EQ(16u, le16(&content[34]));
+    EXPECT_EQ(0, memcmp(&content[36], "data", 4));
+    EXPECT_EQ(dataBytes, le32(&content[40]));
+    // whole buffers only
+    ASSERT_EQ(0u, dataBytes % (samples.size() * 2));
+    for (uint32_t offset = 44; offset < content.size(); offset += samples.size() * 2) {
+        ASSERT_EQ(0, memcmp(&content[offset], &samples[0], samples.size() * 2));
+    }
+}
+
+TEST_F(HalAudioDumpTest, NewFileOnFormatChangeAndClose)
+{
+    HalAudioDump dump(mDir.c_str());
+    uint8_t samples[960] = { 0 };
+    dump.dumpAudioSamples(samples, sizeof(samples), false, 48000, 2, "test");
+    dump.dumpAudioSamples(samples, sizeof(samples), false, 16000, 1, "test");
+    dump.close();
+    dump.dumpAudioSamples(samples, sizeof(samples), false, 16000, 1, "test");
+    dump.close();
+
+    vector<uint8_t> content;
+    ASSERT_TRUE(readFile(fileName("in", 48000, 2, 1), content));
+    EXPECT_EQ(44u + sizeof(samples), content.size());
+    ASSERT_TRUE(readFile(fileName("in", 16000, 1, 2), content));
+    EXPECT_EQ(44u + sizeof(samples), content.size());
+    ASSERT_TRUE(readFile(fileName("in", 16000, 1, 3), content));
+    EXPECT_EQ(44u + sizeof(samples), content.size());
+}
+
+TEST_F(HalAudioDumpTest, BoundedCostOnThrottledFile)
+{
+    // storage writes 64 KB per 50 ms, about 1.3 MB/s, less than the 5.5 MB/s dumped
+    ThrottledDump dump(mDir.c_str(), 64 * 1024, 50000);
+    vector<uint8_t> samples(48 * 8 * 4 * 5);   // 5 ms of 48 kHz, 8 channels, 32 bits
+    const uint32_t buffers = 400;
+    int64_t maxNs = 0;
+    int64_t totalNs = 0;
+
+    for (uint32_t i = 0; i < buffers; i++) {
+        int64_t start = nowNs();
+        dump.dumpAudioSamples(&samples[0], samples.size(), true, 48000, 8, "test", 4);
+        int64_t elapsed = nowNs() - start;
+        totalNs += elapsed;
+        if (elapsed > maxNs) {
+            maxNs = elapsed;
+        }
+        usleep(5000);
+    }
+    printf("dumpAudioSamples of %u bytes: %.1f us on average, %.1f us at most, "
+           "%u of %u buffers dropped\n", (uint32_t)samples.size(), totalNs / 1000.0 / buffers,
+           maxNs / 1000.0, dump.getOverrunCount(), buffers);
+
+    // the file writes took seconds, the audio thread never waited for them
+    EXPECT_GT(dump.getOverrunCount(), 0u);
+    EXPECT_LT(dump.getOverrunCount(), buffers);
+    EXPECT_EQ(dump.getOverrunCount() * samples.size(), dump.getDroppedBytes());
+    EXPECT_LT(maxNs, 2000000);
+
+    dump.close();
+    vector<uint8_t> content;
+    ASSERT_TRUE(readFile(fileName("out", 48000, 8, 1), content));
+    EXPECT_EQ(44 + (buffers - dump.getOverrunCount()) * samples.size(), content.size());
+}
@@ -33,6 +33,7 @@ audio_route_manager_src_files :=  \
     AudioPortGroup.cpp \
     AudioRoute.cpp \
     AudioStreamRoute.cpp \
+    RouteSelector.cpp \
     AudioRouteManager.cpp \
     AudioRouteManagerObserver.cpp \
     RouteManagerInstance.cpp \
@@ -151,6 +152,40 @@ include $(BUILD_HOST_STATIC_LIBRARY)
 
 endif
 
+#######################################################################
+# Route selection functional test and reroute benchmark, on synthetic topologies
+
+ifeq ($(audiocomms_test_host),true)
+
+audio_route_manager_selector_test_src_files := \
+    RoutingElement.cpp \
+    AudioPort.cpp \
+    AudioPortGroup.cpp \
+    AudioRoute.cpp \
+    AudioStreamRoute.cpp \
+    RouteSelector.cpp \
+    test/RouteSelectorTest.cpp
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := route_selector_fcttest_host
+LOCAL_SRC_FILES := $(audio_route_manager_selector_test_src_files)
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH) \
+    $(audio_route_manager_includes_common) \
+    $(audio_route_manager_includes_dir_host) \
+    external/gtest/include
+LOCAL_CFLAGS := $(audio_route_manager_cflags)
+LOCAL_STATIC_LIBRARIES := \
+    $(audio_route_manager_static_lib_host) \
+    liblog \
+    libgtest_host \
+    libgtest_main_host
+LOCAL_LDFLAGS += -pthread
+LOCAL_MODULE_TAGS := tests
+include $(BUILD_HOST_EXECUTABLE)
+
+endif
+
 
 #######################################################################
 # Build for target to export headers
@@ -55,6 +55,13 @@ public:
      */
     void setBlocked(bool blocked);
 
+    /**
+     * Checks if a port is blocked.
+     *
+     * @return true if the port is blocked, false otherwise.
+     */
+    bool isBlocked() const { return mIsBlocked; }
+
     /**
      * Sets a port in use.
      *
@@ -140,6 +140,17 @@ public:
         mIsApplicable = isApplicable;
     }
 
+    /**
+     * Checks if a route is applicable according to the platform settings only, whatever the
+     * port strategy.
+     *
+     * @return true if the Route Parameter Manager declared this route applicable.
+     */
+    bool isPlatformApplicable() const
+    {
+        return mIsApplicable;
+    }
+
     /**
      * Checks if a route needs to be muted / unmuted.
      *
@@ -113,6 +113,7 @@ AudioRouteManager::AudioRouteManager()
     : mRouteInterface(this),
       mStreamInterface(this),
       mAudioPfwConnectorLogger(new CParameterMgrPlatformConnectorLogger),
+      mRouteSelector(mRouteMap, mPortMap, mStreamsList),
       mEventThread(new CEventThread(this)),
       mIsStarted(false)
 {
@@ -293,28 +294,28 @@ void AudioRouteManager::doReconsiderRouting()
     Log::Debug() << __FUNCTION__
                  << ": Route state:"
                  << "\n\t-Previously Enabled Route in Input = "
-                 << routeCriterionType()->getFormattedState(prevEnabledRoutes(Direction::Input))
+                 << getFormattedRoutes(prevEnabledRoutes(Direction::Input))
                  << "\n\t-Previously Enabled Route in Output = "
-                 << routeCriterionType()->getFormattedState(prevEnabledRoutes(Direction::Output))
+                 << getFormattedRoutes(prevEnabledRoutes(Direction::Output))
                  << "\n\t-Selected Route in Input = "
-                 << routeCriterionType()->getFormattedState(enabledRoutes(Direction::Input))
+                 << getFormattedRoutes(enabledRoutes(Direction::Input))
                  << "\n\t-Selected Route in Output = "
-                 << routeCriterionType()->getFormattedState(enabledRoutes(Direction::Output))
+                 << getFormattedRoutes(enabledRoutes(Direction::Output))
                  << (needReflowRoutes(Direction::Input) ?
         "\n\t-Route that need reconfiguration in Input = " +
-        routeCriterionType()->getFormattedState(needReflowRoutes(Direction::Input))
+        getFormattedRoutes(needReflowRoutes(Direction::Input))
         : "")
                  << (needReflowRoutes(Direction::Output) ?
         "\n\t-Route that need reconfiguration in Output = "
-        + routeCriterionType()->getFormattedState(needReflowRoutes(Direction::Output))
+        + getFormattedRoutes(needReflowRoutes(Direction::Output))
         : "")
                  << (needRepathRoutes(Direction::Input) ?
         "\n\t-Route that need rerouting in Input = " +
-        routeCriterionType()->getFormattedState(needRepathRoutes(Direction::Input))
+        getFormattedRoutes(needRepathRoutes(Direction::Input))
         : "")
                  << (needRepathRoutes(Direction::Output) ?
         "\n\t-Route that need rerouting in Output = "
-        + routeCriterionType()->getFormattedState(needRepathRoutes(Direction::Output))
+        + getFormattedRoutes(needRepathRoutes(Direction::Output))
         : "");
     executeRouting();
     Log::Debug() << __FUNCTION__ << ": DONE";
@@ -341,9 +342,6 @@ void AudioRouteManager::resetRouting()
         mRoutes[i].needReflow = 0;
         mRoutes[i].needRepath = 0;
     }
-
-    resetAvailability<AudioRoute>(mRouteMap);
-    resetAvailability<AudioPort>(mPortMap);
 }
 
 void AudioRouteManager::addStream(IoStream *stream)
@@ -366,11 +364,16 @@ bool AudioRouteManager::checkAndPrepareRouting()
 {
     resetRouting();
 
+    uint32_t selectedRoutes[Direction::_nbDirections];
+    mRouteSelector.select(selectedRoutes);
+    for (uint32_t i = 0; i < Direction::_nbDirections; i++) {
+        mRoutes[i].enabled = selectedRoutes[i];
+    }
+
     RouteMapIterator it;
     for (it = mRouteMap.begin(); it != mRouteMap.end(); ++it) {
 
         AudioRoute *route =  it->second;
-        prepareRoute(route);
         setBit(route->needReflow(), route->getId(), mRoutes[route->isOut()].needReflow);
         setBit(route->needRepath(), route->getId(), mRoutes[route->isOut()].needRepath);
     }
@@ -378,39 +381,14 @@ bool AudioRouteManager::checkAndPrepareRouting()
     return routingHasChanged<Direction::Output>() | routingHasChanged<Direction::Input>();
 }
 
-void AudioRouteManager::prepareRoute(AudioRoute *route)
+const string &AudioRouteManager::getFormattedRoutes(uint32_t routes)
 {
-    AUDIOCOMMS_ASSERT(route != NULL, "Failure, invalid route parameter");
-
-    bool isApplicable = route->isStreamRoute() ?
-                        setStreamForRoute(static_cast<AudioStreamRoute *>(route)) :
-                        route->isApplicable();
-    route->setUsed(isApplicable);
-    setBit(isApplicable, route->getId(), mRoutes[route->isOut()].enabled);
-}
-
-bool AudioRouteManager::setStreamForRoute(AudioStreamRoute *route)
-{
-    AUDIOCOMMS_ASSERT(route != NULL, "Failure, invalid route parameter");
-
-    bool isOut = route->isOut();
-
-    StreamListIterator it;
-    for (it = mStreamsList[isOut].begin(); it != mStreamsList[isOut].end(); ++it) {
-
-        IoStream *stream = *it;
-        if (stream->isStarted() && !stream->isNewRouteAvailable()) {
-
-            if (route->isApplicable(stream)) {
-                Log::Verbose() << __FUNCTION__
-                               << ": stream route " << route->getName() << " is applicable";
-                route->setStream(stream);
-                return true;
-            }
-        }
+    map<uint32_t, string>::iterator it = mFormattedRoutes.find(routes);
+    if (it == mFormattedRoutes.end()) {
+        it = mFormattedRoutes.insert(
+            make_pair(routes, routeCriterionType()->getFormattedState(routes))).first;
     }
-
-    return false;
+    return it->second;
 }
 
 void AudioRouteManager::executeMuteRoutingStage()
@@ -560,25 +538,15 @@ T *AudioRouteManager::getElement(const string &name, map<string, T *> &elementsM
 }
 
 template <typename T>
-T *AudioRouteManager::findElementByName(const std::string &name, map<string, T *> elementsMap)
+T *AudioRouteManager::findElementByName(const std::string &name,
+                                        const map<string, T *> &elementsMap) const
 {
     routingElementSupported<T>();
-    typename map<string, T *>::iterator it;
+    typename map<string, T *>::const_iterator it;
     it = elementsMap.find(name);
     return (it == elementsMap.end()) ? NULL : it->second;
 }
 
-template <typename T>
-void AudioRouteManager::resetAvailability(map<string, T *> elementsMap)
-{
-    routingElementSupported<T>();
-    typename map<string, T *>::iterator it;
-    for (it = elementsMap.begin(); it != elementsMap.end(); ++it) {
-
-        it->second->resetAvailability();
-    }
-}
-
 bool AudioRouteManager::onEvent(int)
 {
     return false;
@@ -742,11 +710,14 @@ void AudioRouteManager::updateStreamRouteConfig(const string &name,
 {
     AutoW lock(mRoutingLock);
     getElement<AudioStreamRoute>(name, mStreamRouteMap)->updateStreamRouteConfig(config);
+    // Applicability mask of the route is not part of the decision key
+    mRouteSelector.invalidate();
 }
 
 void AudioRouteManager::addRouteSupportedEffect(const string &name, const string &effect)
 {
     getElement<AudioStreamRoute>(name, mStreamRouteMap)->addEffectSupported(effect);
+    mRouteSelector.invalidate();
 }
 
 void AudioRouteManager::setPortBlocked(const string &name, bool isBlocked)
@@ -898,6 +869,7 @@ void AudioRouteManager::addRoute(const string &name,
                               "Fatal: route " << name << " already added to route list!");
             mRouteMap[name] = route;
         }
+        mRouteSelector.invalidate();
     }
 }
 
@@ -905,7 +877,9 @@ void AudioRouteManager::addPort(const string &name, uint32_t portId)
 {
     AutoW lock(mRoutingLock);
     Log::Debug() << __FUNCTION__ << ": Name=" << name;
-    addElement<AudioPort>(name, portId, mPortMap);
+    if (addElement<AudioPort>(name, portId, mPortMap)) {
+        mRouteSelector.invalidate();
+    }
 }
 
 void AudioRouteManager::addPortGroup(const string &name, int32_t groupId, const string &portMember)
@@ -918,6 +892,7 @@ void AudioRouteManager::addPortGroup(const string &name, int32_t groupId, const
 
         AudioPort *port = findElementByName<AudioPort>(portMember, mPortMap);
         portGroup->addPortToGroup(port);
+        mRouteSelector.invalidate();
     }
 }
 
@@ -28,6 +28,7 @@
 #include "AudioRoute.hpp"
 #include "EventThread.h"
 #include "RoutingStage.hpp"
+#include "RouteSelector.hpp"
 #include "RouteInterface.hpp"
 #include "IStreamInterface.hpp"
 #include <AudioCommsAssert.hpp>
@@ -706,27 +707,6 @@ private:
         doEnableRoutes(true);
     }
 
-    /**
-     * Before routing, prepares the attribute of an audio route.
-     *
-     * @param[in] route AudioRoute to prepare for routing.
-     */
-    void prepareRoute(AudioRoute *route);
-
-    /**
-     * Find and set a stream for an applicable route.
-     * It try to associate a streams that must be started and not already routed, with a stream
-     * route according to the applicability mask.
-     * This mask depends on the direction of the stream:
-     *      -Output stream: output Flags
-     *      -Input stream: input source.
-     *
-     * @param[in] route applicable route to be associated to a stream.
-     *
-     * @return true if a stream was found and attached to the route, false otherwise.
-     */
-    bool setStreamForRoute(AudioStreamRoute *route);
-
     /**
      * Add a routing element referred by its name and id to a map. Routing Elements are ports, port
      * groups, route and stream route. Compile time error generated if called with wrong type.
@@ -765,19 +745,8 @@ private:
      * @return valid pointer on element if found, NULL otherwise.
      */
     template <typename T>
-    T *findElementByName(const std::string &name, std::map<std::string, T *> elementsMap);
-
-    /**
-     * Reset the availability of routing elements belonging to a map. Routing Elements are ports,
-     * port, groups, route and stream route. Compile time error generated if called with wrong type.
-     *
-     * @tparam T type of routing element.
-     * @param[in] elementsMap maps of routing elements to search into.
-     *
-     * @return valid pointer on element if found, NULL otherwise.
-     */
-    template <typename T>
-    void resetAvailability(std::map<std::string, T *> elementsMap);
+    T *findElementByName(const std::string &name,
+                         const std::map<std::string, T *> &elementsMap) const;
 
     /**
      * Returns the route Criterion Type.
@@ -789,10 +758,18 @@ private:
         return mCriterionTypesMap[mRouteCriterionType];
     }
 
+    /**
+     * Returns the readable routes of a bitfield, formatted once per bitfield.
+     *
+     * @param[in] routes bitfield of routes.
+     *
+     * @return literal values of the route criterion type, separated with '|'.
+     */
+    const std::string &getFormattedRoutes(uint32_t routes);
+
     /**
      * Reset the routing conditions.
-     * It backup the enabled routes, resets the route criteria, resets the needReconfigure flags,
-     * resets the availability of the routes and ports.
+     * It backup the enabled routes, resets the route criteria, resets the needReconfigure flags.
      */
     void resetRouting();
 
@@ -852,6 +829,18 @@ private:
      */
     std::map<std::string, AudioPortGroup *> mPortGroupMap;
 
+    /**
+     * Selection of the enabled routes, caching the decisions taken for a platform state.
+     * Built on the maps of routes and ports and on the lists of streams.
+     */
+    RouteSelector mRouteSelector;
+
+    /**
+     * Readable routes by bitfield, as formatting walks the values of the route criterion type.
+     * Route criterion type is immutable once the service started.
+     */
+    std::map<uint32_t, std::string> mFormattedRoutes;
+
     CEventThread *mEventThread; /**< worker thread in which routing is running. */
 
     bool mIsStarted; /**< Started service flag. */
@@ -0,0 +1,252 @@
+/*
+ * INTEL CONFIDENTIAL
+ * Copyright (c) 2014 Intel
+ * Corporation All Rights Reserved.
+ *
+ * The source code contained or described herein and all documents related to
+ * the source code ("Material") are owned by Intel Corporation or its suppliers
+ * or licensors. Title to the Material remains with Intel Corporation or its
+ * suppliers and licensors. The Material contains trade secrets and proprietary
+ * and confidential information of Intel or its suppliers and licensors. The
+ * Material is protected by worldwide copyright and trade secret laws and
+ * treaty provisions. No part of the Material may be used, copied, reproduced,
+ * modified, published, uploaded, posted, transmitted, distributed, or
+ * disclosed in any way without Intel's prior express written permission.
+ *
+ * No license under any patent, copyright, trade secret or other intellectual
+ * property right is granted to or conferred upon you by disclosure or delivery
+ * of the Materials, either expressly, by implication, inducement, estoppel or
+ * otherwise. Any license under such intellectual property rights must be
+ * express and approved by Intel in writing.
+ *
+ */
+#define LOG_TAG "RouteManager/Selector"
+
+#include "RouteSelector.hpp"
+#include "AudioPort.hpp"
+#include "AudioRoute.hpp"
+#include "AudioStreamRoute.hpp"
+#include <IoStream.hpp>
+#include <AudioCommsAssert.hpp>
+#include <utilities/Log.hpp>
+
+using std::vector;
+using audio_comms::utilities::Direction;
+using audio_comms::utilities::Log;
+
+namespace intel_audio
+{
+
+RouteSelector::RouteSelector(const RouteMap &routes, const PortMap &ports,
+                             const StreamList (&streams)[Direction::_nbDirections],
+                             uint32_t cacheSize)
+    : mRoutes(routes),
+      mPorts(ports),
+      mStreams(streams),
+      mKeyHash(0),
+      mCacheSize(cacheSize),
+      mUseCount(0),
+      mHits(0),
+      mMisses(0)
+{
+    mDecisions.reserve(cacheSize);
+}
+
+void RouteSelector::select(uint32_t (&enabledRoutes)[Direction::_nbDirections])
+{
+    resetAvailability();
+    buildKey();
+
+    Decision *decision = findDecision();
+    if (decision != NULL) {
+        mHits++;
+        apply(*decision);
+    } else {
+        mMisses++;
+        decision = (mCacheSize == 0) ? &mUncachedDecision : &allocateDecision();
+        evaluate(*decision);
+    }
+    for (uint32_t i = 0; i < Direction::_nbDirections; i++) {
+        enabledRoutes[i] = decision->enabledRoutes[i];
+    }
+}
+
+void RouteSelector::invalidate()
+{
+    Log::Verbose() << __FUNCTION__ << ": dropping " << mDecisions.size() << " decisions";
+    mDecisions.clear();
+}
+
+void RouteSelector::resetAvailability()
+{
+    RouteMap::const_iterator routeIt;
+    for (routeIt = mRoutes.begin(); routeIt != mRoutes.end(); ++routeIt) {
+
+        routeIt->second->resetAvailability();
+    }
+    PortMap::const_iterator portIt;
+    for (portIt = mPorts.begin(); portIt != mPorts.end(); ++portIt) {
+
+        portIt->second->resetAvailability();
+    }
+}
+
+void RouteSelector::buildKey()
+{
+    mKey.clear();
+    mRouteIndex.clear();
+
+    // Applicability of routes then blocked state of ports, one bit each
+    uint32_t bitIndex = 0;
+    RouteMap::const_iterator routeIt;
+    for (routeIt = mRoutes.begin(); routeIt != mRoutes.end(); ++routeIt) {
+
+        mRouteIndex.push_back(routeIt->second);
+        appendBit(mKey, bitIndex, routeIt->second->isPlatformApplicable());
+    }
+    PortMap::const_iterator portIt;
+    for (portIt = mPorts.begin(); portIt != mPorts.end(); ++portIt) {
+
+        appendBit(mKey, bitIndex, portIt->second->isBlocked());
+    }
+
+    // Only started streams not yet routed may be selected: their count, then their attributes
+    for (uint32_t dir = 0; dir < Direction::_nbDirections; dir++) {
+
+        mStreamIndex[dir].clear();
+        StreamList::const_iterator it;
+        for (it = mStreams[dir].begin(); it != mStreams[dir].end(); ++it) {
+
+            IoStream *stream = *it;
+            if (stream->isStarted() && !stream->isNewRouteAvailable()) {
+                mStreamIndex[dir].push_back(stream);
+            }
+        }
+        mKey.push_back(mStreamIndex[dir].size());
+        for (uint32_t i = 0; i < mStreamIndex[dir].size(); i++) {
+
+            mKey.push_back(mStreamIndex[dir][i]->getApplicabilityMask());
+            mKey.push_back(mStreamIndex[dir][i]->getEffectRequested());
+        }
+    }
+    mKeyHash = hash(mKey);
+}
+
+void RouteSelector::evaluate(Decision &decision)
+{
+    for (uint32_t i = 0; i < Direction::_nbDirections; i++) {
+        decision.enabledRoutes[i] = 0;
+    }
+    decision.usedRoutes.clear();
+
+    for (uint32_t index = 0; index < mRouteIndex.size(); index++) {
+
+        AudioRoute *route = mRouteIndex[index];
+        int32_t streamIndex = -1;
+        bool isApplicable;
+        if (route->isStreamRoute()) {
+
+            AudioStreamRoute *streamRoute = static_cast<AudioStreamRoute *>(route);
+            streamIndex = findStreamForRoute(streamRoute);
+            isApplicable = streamIndex >= 0;
+            if (isApplicable) {
+                streamRoute->setStream(mStreamIndex[route->isOut()][streamIndex]);
+            }
+        } else {
+            isApplicable = route->isApplicable();
+        }
+        if (!isApplicable) {
+            continue;
+        }
+        route->setUsed(true);
+        decision.enabledRoutes[route->isOut()] |= route->getId();
+        decision.usedRoutes.push_back(UsedRoute(index, streamIndex));
+    }
+}
+
+int32_t RouteSelector::findStreamForRoute(const AudioStreamRoute *route) const
+{
+    const vector<IoStream *> &streams = mStreamIndex[route->isOut()];
+
+    for (uint32_t i = 0; i < streams.size(); i++) {
+
+        // A stream gets a new route when it was selected for a previous route
+        if (!streams[i]->isNewRouteAvailable() && route->isApplicable(streams[i])) {
+            Log::Verbose() << __FUNCTION__
+                           << ": stream route " << route->getName() << " is applicable";
+            return i;
+        }
+    }
+    return -1;
+}
+
+void RouteSelector::apply(const Decision &decision)
+{
+    for (uint32_t i = 0; i < decision.usedRoutes.size(); i++) {
+
+        AudioRoute *route = mRouteIndex[decision.usedRoutes[i].first];
+        int32_t streamIndex = decision.usedRoutes[i].second;
+        if (streamIndex >= 0) {
+            static_cast<AudioStreamRoute *>(route)->setStream(
+                mStreamIndex[route->isOut()][streamIndex]);
+        }
+        route->setUsed(true);
+    }
+}
+
+RouteSelector::Decision *RouteSelector::findDecision()
+{
+    for (uint32_t i = 0; i < mDecisions.size(); i++) {
+
+        Decision &decision = mDecisions[i];
+        if (decision.keyHash == mKeyHash && decision.key == mKey) {
+            decision.lastUse = ++mUseCount;
+            return &decision;
+        }
+    }
+    return NULL;
+}
+
+RouteSelector::Decision &RouteSelector::allocateDecision()
+{
+    uint32_t slot = mDecisions.size();
+    if (slot < mCacheSize) {
+        mDecisions.push_back(Decision());
+    } else {
+        // Least recently used decision is overwritten
+        slot = 0;
+        for (uint32_t i = 1; i < mDecisions.size(); i++) {
+            if (mDecisions[i].lastUse < mDecisions[slot].lastUse) {
+                slot = i;
+            }
+        }
+    }
+    Decision &decision = mDecisions[slot];
+    decision.key = mKey;
+    decision.keyHash = mKeyHash;
+    decision.lastUse = ++mUseCount;
+    return decision;
+}
+
+uint32_t RouteSelector::hash(const vector<uint32_t> &key)
+{
+    // FNV-1a on the key words
+    uint32_t value = 2166136261u;
+    for (uint32_t i = 0; i < key.size(); i++) {
+        value = (value ^ key[i]) * 16777619u;
+    }
+    return value;
+}
+
+void RouteSelector::appendBit(vector<uint32_t> &key, uint32_t &bitIndex, bool isSet)
+{
+    if (bitIndex % mBitsPerWord == 0) {
+        key.push_back(0);
+    }
+    if (isSet) {
+        key.back() |= 1u << (bitIndex % mBitsPerWord);
+    }
+    bitIndex++;
+}
+
+} // namespace intel_audio
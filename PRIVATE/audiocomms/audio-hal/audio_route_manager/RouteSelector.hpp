@@ -0,0 +1,176 @@
+/*
+ * INTEL CONFIDENTIAL
+ * Copyright (c) 2014 Intel
+ * Corporation All Rights Reserved.
+ *
+ * The source code contained or described herein and all documents related to
+ * the source code ("Material") are owned by Intel Corporation or its suppliers
+ * or licensors. Title to the Material remains with Intel Corporation or its
+ * suppliers and licensors. The Material contains trade secrets and proprietary
+ * and confidential information of Intel or its suppliers and licensors. The
+ * Material is protected by worldwide copyright and trade secret laws and
+ * treaty provisions. No part of the Material may be used, copied, reproduced,
+ * modified, published, uploaded, posted, transmitted, distributed, or
+ * disclosed in any way without Intel's prior express written permission.
+ *
+ * No license under any patent, copyright, trade secret or other intellectual
+ * property right is granted to or conferred upon you by disclosure or delivery
+ * of the Materials, either expressly, by implication, inducement, estoppel or
+ * otherwise. Any license under such intellectual property rights must be
+ * express and approved by Intel in writing.
+ *
+ */
+#pragma once
+
+#include <NonCopyable.hpp>
+#include <stdint.h>
+#include <Direction.hpp>
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace intel_audio
+{
+
+class AudioPort;
+class AudioRoute;
+class AudioStreamRoute;
+class IoStream;
+
+/**
+ * Selection of the routes to enable.
+ *
+ * It overrides the applicability of the Route Parameter Manager with the port strategy
+ * (mutual exclusive ports) and with the started streams: a stream route is selected only if
+ * a started stream is applicable on it.
+ *
+ * The selection only depends on a snapshot of the route applicability, of the ports blocked
+ * state and of the started streams attributes. The snapshot is kept as a compact bitset key,
+ * and the decision taken for it (routes used, stream attached to each stream route) is cached.
+ * On a known snapshot, the decision is replayed on the routes without evaluating them again.
+ * Cached decisions only need to be dropped when the topology or the route configurations
+ * change, which is told by invalidate().
+ */
+class RouteSelector : private audio_comms::utilities::NonCopyable
+{
+public:
+    typedef std::map<std::string, AudioRoute *> RouteMap;
+    typedef std::map<std::string, AudioPort *> PortMap;
+    typedef std::list<IoStream *> StreamList;
+
+    /**
+     * @param[in] routes: routes to select from, including the stream routes.
+     * @param[in] ports: ports used by the routes.
+     * @param[in] streams: streams per direction.
+     * @param[in] cacheSize: number of decisions kept, 0 to always evaluate the routes.
+     */
+    RouteSelector(const RouteMap &routes, const PortMap &ports,
+                  const StreamList (&streams)[audio_comms::utilities::Direction::_nbDirections],
+                  uint32_t cacheSize = mDefaultCacheSize);
+
+    /**
+     * Resets the availability of the routes and the ports, then selects the routes to enable.
+     * Selected routes are set in use, and a stream is set for each selected stream route.
+     *
+     * @param[out] enabledRoutes: bitfield of selected routes, per direction.
+     */
+    void select(uint32_t (&enabledRoutes)[audio_comms::utilities::Direction::_nbDirections]);
+
+    /**
+     * Drops the cached decisions.
+     * To be called when a route or port is added, or when a route configuration changes.
+     */
+    void invalidate();
+
+    /** @return number of selections served from the cache. */
+    uint32_t getHitCount() const { return mHits; }
+
+    /** @return number of selections which evaluated the routes. */
+    uint32_t getMissCount() const { return mMisses; }
+
+    static const uint32_t mDefaultCacheSize = 16;
+
+private:
+    /** Route used after a selection, by index in the route map. */
+    typedef std::pair<uint32_t, int32_t> UsedRoute; /**< route index, stream index or -1. */
+
+    struct Decision
+    {
+        std::vector<uint32_t> key;
+        uint32_t keyHash;
+        uint32_t lastUse;
+        uint32_t enabledRoutes[audio_comms::utilities::Direction::_nbDirections];
+        std::vector<UsedRoute> usedRoutes;
+    };
+
+    /** Resets the availability of the routes and the ports. */
+    void resetAvailability();
+
+    /**
+     * Builds the snapshot key of the selection inputs, and the indexes of routes and streams.
+     * The key holds the applicability of the routes and the blocked state of the ports as
+     * bits, then per direction the count of streams that may be routed and, for each of them,
+     * the applicability mask and the effects requested.
+     */
+    void buildKey();
+
+    /**
+     * Evaluates the applicability of each route in turn, and keeps the decision.
+     *
+     * @param[out] decision: routes used and bitfield of enabled routes.
+     */
+    void evaluate(Decision &decision);
+
+    /**
+     * Find a stream for an applicable stream route.
+     * It tries to associate a stream that must be started and not already routed, with a stream
+     * route according to the applicability mask.
+     * This mask depends on the direction of the stream:
+     *      -Output stream: output Flags
+     *      -Input stream: input source.
+     *
+     * @param[in] route: stream route to be associated to a stream.
+     *
+     * @return index of the stream in the streams of the direction of the route, -1 if none.
+     */
+    int32_t findStreamForRoute(const AudioStreamRoute *route) const;
+
+    /** Sets the routes of a decision in use, and their streams. */
+    void apply(const Decision &decision);
+
+    /** @return cached decision for the current key, NULL if none. */
+    Decision *findDecision();
+
+    /** @return decision to overwrite with the one for the current key. */
+    Decision &allocateDecision();
+
+    static uint32_t hash(const std::vector<uint32_t> &key);
+
+    static void appendBit(std::vector<uint32_t> &key, uint32_t &bitIndex, bool isSet);
+
+    const RouteMap &mRoutes;
+    const PortMap &mPorts;
+    const StreamList (&mStreams)[audio_comms::utilities::Direction::_nbDirections];
+
+    /** Routes by index in the route map, valid after buildKey(). */
+    std::vector<AudioRoute *> mRouteIndex;
+
+    /** Streams by index in their direction, valid after buildKey(). */
+    std::vector<IoStream *> mStreamIndex[audio_comms::utilities::Direction::_nbDirections];
+
+    std::vector<uint32_t> mKey; /**< Key of the current selection. */
+    uint32_t mKeyHash;
+
+    std::vector<Decision> mDecisions;
+    Decision mUncachedDecision; /**< Decision evaluated when there is no cache. */
+    uint32_t mCacheSize;
+    uint32_t mUseCount;
+    uint32_t mHits;
+    uint32_t mMisses;
+
+    static const uint32_t mBitsPerWord = 32;
+};
+
+} // namespace intel_audio
@@ -0,0 +1,408 @@
+/*
+ * INTEL CONFIDENTIAL
+ * Copyright (c) 2014 Intel
+ * Corporation All Rights Reserved.
+ *
+ * The source code contained or described herein and all documents related to
+ * the source code ("Material") are owned by Intel Corporation or its suppliers
+ * or licensors. Title to the Material remains with Intel Corporation or its
+ * suppliers and licensors. The Material contains trade secrets and proprietary
+ * and confidential information of Intel or its suppliers and licensors. The
+ * Material is protected by worldwide copyright and trade secret laws and
+ * treaty provisions. No part of the Material may be used, copied, reproduced,
+ * modified, published, uploaded, posted, transmitted, distributed, or
+ * disclosed in any way without Intel's prior express written permission.
+ *
+ * No license under any patent, copyright, trade secret or other intellectual
+ * property right is granted to or conferred upon you by disclosure or delivery
+ * of the Materials, either expressly, by implication, inducement, estoppel or
+ * otherwise. Any license under such intellectual property rights must be
+ * express and approved by Intel in writing.
+ *
+ */
+
+#include "AudioPort.hpp"
+#include "AudioPortGroup.hpp"
+#include "AudioRoute.hpp"
+#include "AudioStreamRoute.hpp"
+#include "RouteSelector.hpp"
+#include <IoStream.hpp>
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sstream>
+
+using namespace intel_audio;
+using audio_comms::utilities::Direction;
+using std::map;
+using std::string;
+using std::vector;
+
+/**
+ * Stream whose state is driven by the test, no audio device behind.
+ */
+class FakeStream : public IoStream
+{
+public:
+    FakeStream(bool isOut, uint32_t mask)
+        : mIsOut(isOut), mIsStarted(false), mMask(mask)
+    {}
+
+    virtual ~FakeStream() {}
+
+    virtual bool isOut() const { return mIsOut; }
+    virtual bool isStarted() const { return mIsStarted; }
+    virtual bool isRoutedByPolicy() const { return mIsStarted; }
+    virtual uint32_t getApplicabilityMask() const { return mMask; }
+    virtual uint32_t getBufferSizeInBytes() const { return 0; }
+    virtual size_t getBufferSizeInFrames() const { return 0; }
+
+    virtual android::status_t pcmReadFrames(void *, size_t, string &) const
+    {
+        return android::OK;
+    }
+
+    virtual android::status_t pcmWriteFrames(void *, ssize_t, string &) const
+    {
+        return android::OK;
+    }
+
+    virtual android::status_t pcmStop() const { return android::OK; }
+
+    virtual android::status_t getFramesAvailable(uint32_t &, struct timespec &) const
+    {
+        return android::OK;
+    }
+
+    bool mIsOut;
+    bool mIsStarted;
+    uint32_t mMask;
+};
+
+/**
+ * Silences the logs of the routing, printed on standard outputs on host, while in scope.
+ */
+class MuteLogs
+{
+public:
+    MuteLogs()
+    {
+        fflush(stdout);
+        fflush(stderr);
+        mStdout = dup(STDOUT_FILENO);
+        mStderr = dup(STDERR_FILENO);
+        int devNull = open("/dev/null", O_WRONLY);
+        dup2(devNull, STDOUT_FILENO);
+        dup2(devNull, STDERR_FILENO);
+        close(devNull);
+    }
+
+    ~MuteLogs()
+    {
+        fflush(stdout);
+        fflush(stderr);
+        dup2(mStdout, STDOUT_FILENO);
+        dup2(mStderr, STDERR_FILENO);
+        close(mStdout);
+        close(mStderr);
+    }
+
+private:
+    int mStdout;
+    int mStderr;
+};
+
+/**
+ * Stream route telling which stream it selected.
+ */
+class TestStreamRoute : public AudioStreamRoute
+{
+public:
+    TestStreamRoute(const string &name, uint32_t routeIndex)
+        : AudioStreamRoute(name, routeIndex)
+    {}
+
+    const IoStream *getNewStream() const { return mNewStream; }
+};
+
+/**
+ * Synthetic platform: ports grouped by pairs of mutual exclusive ports, routes between two
+ * ports, half of them stream routes, and streams in both directions.
+ */
+class Platform
+{
+public:
+    Platform(uint32_t nbRoutes, uint32_t nbStreams, uint32_t cacheSize)
+        : mSelector(mRouteMap, mPortMap, mStreams, cacheSize)
+    {
+        MuteLogs mute;
+        uint32_t nbPorts = nbRoutes / 2 + 2;
+        for (uint32_t i = 0; i < nbPorts; i++) {
+            AudioPort *port = new AudioPort(getName("port", i), i);
+            mPorts.push_back(port);
+            mPortMap[port->getName()] = port;
+        }
+        for (uint32_t i = 0; i + 1 < nbPorts; i += 2) {
+            AudioPortGroup *group = new AudioPortGroup(getName("group", i), i);
+            group->addPortToGroup(mPorts[i]);
+            group->addPortToGroup(mPorts[i + 1]);
+            mGroups.push_back(group);
+        }
+        StreamRouteConfig config = StreamRouteConfig();
+        for (uint32_t i = 0; i < nbRoutes; i++) {
+            bool isStreamRoute = (i % 2) == 0;
+            AudioRoute *route;
+            if (isStreamRoute) {
+                TestStreamRoute *streamRoute = new TestStreamRoute(getName("stream", i), 1 << i);
+                config.applicabilityMask = 1 << (i % 3);
+                streamRoute->updateStreamRouteConfig(config);
+                if (i % 4 == 0) {
+                    streamRoute->addEffectSupported("Acoustic Echo Canceller");
+                }
+                route = streamRoute;
+            } else {
+                route = new AudioRoute(getName("route", i), 1 << i);
+            }
+            route->setDirection(i % 3 != 0);
+            route->addPort(mPorts[i % nbPorts]);
+            route->addPort(mPorts[(i * 7 + 3) % nbPorts]);
+            mRoutes.push_back(route);
+            mRouteMap[route->getName()] = route;
+        }
+        for (uint32_t i = 0; i < nbStreams; i++) {
+            FakeStream *stream = new FakeStream(i % 2, 1 << (i % 3));
+            mStreamObjects.push_back(stream);
+            mStreams[stream->isOut()].push_back(stream);
+        }
+    }
+
+    ~Platform()
+    {
+        for (uint32_t i = 0; i < mRoutes.size(); i++) {
+            delete mRoutes[i];
+        }
+        for (uint32_t i = 0; i < mGroups.size(); i++) {
+            delete mGroups[i];
+        }
+        for (uint32_t i = 0; i < mPorts.size(); i++) {
+            delete mPorts[i];
+        }
+        for (uint32_t i = 0; i < mStreamObjects.size(); i++) {
+            delete mStreamObjects[i];
+        }
+    }
+
+    /**
+     * Applies a platform state: bits of the state select the applicable routes, the started
+     * streams, the effects requested and a blocked port.
+     */
+    void setState(uint32_t state)
+    {
+        for (uint32_t i = 0; i < mRoutes.size(); i++) {
+            mRoutes[i]->setApplicable(((state >> (i % 11)) & 1) || i % 5 == 0);
+        }
+        for (uint32_t i = 0; i < mStreamObjects.size(); i++) {
+            mStreamObjects[i]->mIsStarted = (state >> (i % 7)) & 1;
+            if ((state >> 12) & 1) {
+                mStreamObjects[i]->addRequestedEffect(1);
+            } else {
+                mStreamObjects[i]->removeRequestedEffect(1);
+            }
+        }
+        for (uint32_t i = 0; i < mPorts.size(); i++) {
+            mPorts[i]->setBlocked(((state >> 13) & 3) == 3 && i == (state >> 15) % mPorts.size());
+        }
+    }
+
+    /** Selects the routes, returns a readable routing to compare between platforms. */
+    string select()
+    {
+        uint32_t enabledRoutes[Direction::_nbDirections];
+        {
+            MuteLogs mute;
+            mSelector.select(enabledRoutes);
+        }
+
+        std::ostringstream routing;
+        routing << enabledRoutes[Direction::Input] << "/" << enabledRoutes[Direction::Output];
+        for (uint32_t i = 0; i < mRoutes.size(); i++) {
+            routing << " " << mRoutes[i]->isUsed();
+            if (mRoutes[i]->isStreamRoute()) {
+                routing << ":" << getStreamIndex(static_cast<TestStreamRoute *>(mRoutes[i]));
+            }
+        }
+        return routing.str();
+    }
+
+    /** @return index of the stream selected by a stream route, -1 if none. */
+    int32_t getStreamIndex(const TestStreamRoute *route) const
+    {
+        for (uint32_t i = 0; i < mStreamObjects.size(); i++) {
+            if (route->getNewStream() == mStreamObjects[i]) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    static string getName(const char *prefix, uint32_t index)
+    {
+        std::ostringstream name;
+        name << prefix << (index < 10 ? "0" : "") << index;
+        return name.str();
+    }
+
+    vector<AudioPort *> mPorts;
+    vector<AudioPortGroup *> mGroups;
+    vector<AudioRoute *> mRoutes;
+    vector<FakeStream *> mStreamObjects;
+    map<string, AudioRoute *> mRouteMap;
+    map<string, AudioPort *> mPortMap;
+    std::list<IoStream *> mStreams[Direction::_nbDirections];
+    RouteSelector mSelector;
+};
+
+static uint64_t getNowUs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+TEST(RouteSelector, SameRoutingAsEvaluated)
+{
+    Platform cached(24, 6, RouteSelector::mDefaultCacheSize);
+    Platform evaluated(24, 6, 0);
+
+    srand(42);
+    for (uint32_t i = 0; i < 2000; i++) {
+        // Few states, so that most of them are cached
+        uint32_t state = rand() % 64;
+        state |= (rand() % 2) << 12 | (rand() % 4) << 13 | (rand() % 32) << 15;
+        cached.setState(state);
+        evaluated.setState(state);
+        ASSERT_EQ(evaluated.select(), cached.select()) << "state " << state;
+    }
+    EXPECT_GT(cached.mSelector.getHitCount(), 0u);
+    EXPECT_EQ(0u, evaluated.mSelector.getHitCount());
+}
+
+TEST(RouteSelector, StreamChanges)
+{
+    Platform platform(8, 4, RouteSelector::mDefaultCacheSize);
+
+    // Using a port blocks its mutual exclusive ports until unblocked, so the state is applied
+    // again before each selection
+    platform.setState(0x3f);
+    string routing = platform.select();
+    EXPECT_EQ(1u, platform.mSelector.getMissCount());
+    platform.setState(0x3f);
+    EXPECT_EQ(routing, platform.select());
+    EXPECT_EQ(1u, platform.mSelector.getHitCount());
+
+    // Stream attributes are part of the key
+    platform.setState(0x3f);
+    platform.mStreamObjects[0]->mMask = 1 << 2;
+    platform.select();
+    EXPECT_EQ(2u, platform.mSelector.getMissCount());
+
+    platform.setState(0x3f);
+    platform.mStreamObjects[0]->mIsStarted = false;
+    platform.select();
+    EXPECT_EQ(3u, platform.mSelector.getMissCount());
+
+    // Removing a stream changes the key
+    platform.setState(0x3f);
+    platform.mStreams[Direction::Output].pop_back();
+    platform.select();
+    EXPECT_EQ(4u, platform.mSelector.getMissCount());
+    EXPECT_EQ(1u, platform.mSelector.getHitCount());
+}
+
+TEST(RouteSelector, InvalidateOnConfigurationChange)
+{
+    Platform platform(8, 4, RouteSelector::mDefaultCacheSize);
+
+    platform.setState(0x3f);
+    platform.select();
+    platform.setState(0x3f);
+    platform.select();
+    EXPECT_EQ(1u, platform.mSelector.getMissCount());
+
+    // Route configuration is not part of the key
+    StreamRouteConfig config = StreamRouteConfig();
+    config.applicabilityMask = 0;
+    for (uint32_t i = 0; i < platform.mRoutes.size(); i++) {
+        if (platform.mRoutes[i]->isStreamRoute()) {
+            static_cast<AudioStreamRoute *>(platform.mRoutes[i])->updateStreamRouteConfig(config);
+        }
+    }
+    platform.mSelector.invalidate();
+    platform.setState(0x3f);
+    string routing = platform.select();
+    EXPECT_EQ(2u, platform.mSelector.getMissCount());
+    for (uint32_t i = 0; i < platform.mRoutes.size(); i++) {
+        if (platform.mRoutes[i]->isStreamRoute()) {
+            EXPECT_FALSE(platform.mRoutes[i]->isUsed()) << routing;
+        }
+    }
+}
+
+TEST(RouteSelector, LeastRecentlyUsedEvicted)
+{
+    Platform platform(8, 4, 2);
+
+    platform.setState(1);
+    platform.select();
+    platform.setState(2);
+    platform.select();
+    platform.setState(1);
+    platform.select();
+    EXPECT_EQ(1u, platform.mSelector.getHitCount());
+
+    // Evicts the decision of state 2
+    platform.setState(3);
+    platform.select();
+    platform.setState(1);
+    platform.select();
+    EXPECT_EQ(2u, platform.mSelector.getHitCount());
+    platform.setState(2);
+    platform.select();
+    EXPECT_EQ(4u, platform.mSelector.getMissCount());
+}
+
+/**
+ * Times bursts of reroutes, as when criteria change in a row, cycling on a few states,
+ * with and without cached decisions.
+ */
+TEST(RouteSelector, RerouteBurstBenchmark)
+{
+    static const uint32_t topologies[][2] = {
+        { 8, 4 }, { 16, 8 }, { 32, 16 }
+    };
+    static const uint32_t nbReroutes = 2000;
+    static const uint32_t nbStates = 8;
+
+    for (uint32_t t = 0; t < sizeof(topologies) / sizeof(topologies[0]); t++) {
+        uint64_t elapsedUs[2];
+        for (uint32_t isCached = 0; isCached < 2; isCached++) {
+            Platform platform(topologies[t][0], topologies[t][1],
+                              isCached ? RouteSelector::mDefaultCacheSize : 0);
+            uint32_t enabledRoutes[Direction::_nbDirections];
+            MuteLogs mute;
+            uint64_t startUs = getNowUs();
+            for (uint32_t i = 0; i < nbReroutes; i++) {
+                platform.setState((i % nbStates) * 0x1111);
+                platform.mSelector.select(enabledRoutes);
+            }
+            elapsedUs[isCached] = getNowUs() - startUs;
+        }
+        printf("%2u routes, %2u streams: %u reroutes in %llu us evaluated, %llu us cached\n",
+               topologies[t][0], topologies[t][1], nbReroutes,
+               static_cast<unsigned long long>(elapsedUs[0]),
+               static_cast<unsigned long long>(elapsedUs[1]));
+    }
+}
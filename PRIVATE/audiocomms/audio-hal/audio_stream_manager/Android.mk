@@ -34,6 +34,7 @@ audio_stream_manager_src_files :=  \
     src/Device.cpp \
     src/StreamIn.cpp \
     src/StreamOut.cpp \
+    src/PreProcessing.cpp \
     src/AudioParameterHandler.cpp
 
 audio_stream_manager_includes_dir := \
@@ -171,6 +172,26 @@ LOCAL_MODULE := libaudio_stream_manager_static_host
 include $(OPTIONAL_QUALITY_COVERAGE_JUMPER)
 include $(BUILD_HOST_STATIC_LIBRARY)
 
+# Pre-processing host test, with fake effects
+include $(CLEAR_VARS)
+LOCAL_MODULE := pre_processing_fcttest_host
+LOCAL_SRC_FILES := \
+    src/PreProcessing.cpp \
+    test/PreProcessingTest.cpp
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/src \
+    $(audio_stream_manager_includes_dir_host) \
+    external/gtest/include
+LOCAL_CFLAGS := $(audio_stream_manager_cflags)
+LOCAL_STATIC_LIBRARIES := \
+    libaudio_comms_utilities_host \
+    liblog \
+    libgtest_host \
+    libgtest_main_host
+LOCAL_LDFLAGS += -pthread
+LOCAL_MODULE_TAGS := tests
+include $(BUILD_HOST_EXECUTABLE)
+
 endif
 
 # Component functional test
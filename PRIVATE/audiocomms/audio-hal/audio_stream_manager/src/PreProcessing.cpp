@@ -0,0 +1,378 @@
+/*
+ * INTEL CONFIDENTIAL
+ * Copyright (c) 2013-2014 Intel
+ * Corporation All Rights Reserved.
+ *
+ * The source code contained or described herein and all documents related to
+ * the source code ("Material") are owned by Intel Corporation or its suppliers
+ * or licensors. Title to the Material remains with Intel Corporation or its
+ * suppliers and licensors. The Material contains trade secrets and proprietary
+ * and confidential information of Intel or its suppliers and licensors. The
+ * Material is protected by worldwide copyright and trade secret laws and
+ * treaty provisions. No part of the Material may be used, copied, reproduced,
+ * modified, published, uploaded, posted, transmitted, distributed, or
+ * disclosed in any way without Intel's prior express written permission.
+ *
+ * No license under any patent, copyright, trade secret or other intellectual
+ * property right is granted to or conferred upon you by disclosure or delivery
+ * of the Materials, either expressly, by implication, inducement, estoppel or
+ * otherwise. Any license under such intellectual property rights must be
+ * express and approved by Intel in writing.
+ *
+ */
+#define LOG_TAG "AudioStreamIn/PreProcessing"
+
+#include "PreProcessing.hpp"
+#include <AudioCommsAssert.hpp>
+#include <audio_effects/effect_aec.h>
+#include <utilities/Log.hpp>
+#include <algorithm>
+#include <string.h>
+
+using namespace std;
+using android::status_t;
+using audio_comms::utilities::Log;
+
+namespace intel_audio
+{
+
+PreProcessing::PreProcessing(Source &source)
+    : mSource(source),
+      mFrameSize(0),
+      mEchoDelayUs(0)
+{
+    mProcessing.buffer = NULL;
+    mProcessing.capacity = mProcessing.first = mProcessing.frames = 0;
+    mReference.buffer = NULL;
+    mReference.capacity = mReference.first = mReference.frames = 0;
+}
+
+PreProcessing::~PreProcessing()
+{
+    release(mProcessing);
+    release(mReference);
+}
+
+status_t PreProcessing::plan(size_t frameSize, size_t framesPerRead)
+{
+    AUDIOCOMMS_ASSERT(frameSize != 0, "Invalid frame size");
+    if (frameSize != mFrameSize) {
+        // Frames kept are in the former format
+        release(mProcessing);
+        release(mReference);
+        mFrameSize = frameSize;
+    }
+    size_t capacity = framesPerRead * mReadsPerWindow;
+    if (capacity == mProcessing.capacity && capacity == mReference.capacity) {
+        return android::OK;
+    }
+    status_t status = resize(mProcessing, capacity);
+    if (status != android::OK) {
+        return status;
+    }
+    status = resize(mReference, capacity);
+    if (status != android::OK) {
+        return status;
+    }
+    Log::Debug() << __FUNCTION__ << ": " << framesPerRead << " frames per read, windows of "
+                 << capacity << " frames (i.e. " << capacity * mFrameSize << " bytes)";
+    return android::OK;
+}
+
+status_t PreProcessing::addEffect(effect_handle_t effect, struct echo_reference_itfe *reference)
+{
+    AUDIOCOMMS_ASSERT(effect != NULL, "NULL effect context");
+    AUDIOCOMMS_ASSERT(*effect != NULL, "NULL effect interface");
+
+    // audio effects processing is very costy in term of CPU,
+    // so useless to add the same effect more than one time
+    vector<Effect>::const_iterator it;
+    for (it = mEffects.begin(); it != mEffects.end(); ++it) {
+        if (it->preprocessor == effect) {
+            Log::Warning() << __FUNCTION__ << ": (effect=" << effect
+                           << "): it is useless to add again the same effect";
+            return android::OK;
+        }
+    }
+    Effect added;
+    added.preprocessor = effect;
+    added.echoReference = reference;
+    mEffects.push_back(added);
+    Log::Debug() << __FUNCTION__ << ": (effect=" << effect
+                 << "): effect added. number of stored effects is " << mEffects.size();
+    return android::OK;
+}
+
+status_t PreProcessing::removeEffect(effect_handle_t effect,
+                                     struct echo_reference_itfe *&reference)
+{
+    AUDIOCOMMS_ASSERT(effect != NULL, "NULL effect context");
+    AUDIOCOMMS_ASSERT(*effect != NULL, "NULL effect interface");
+
+    bool hasReference = false;
+    vector<Effect>::iterator removed = mEffects.end();
+    vector<Effect>::iterator it;
+    for (it = mEffects.begin(); it != mEffects.end(); ++it) {
+        if (it->preprocessor == effect) {
+            removed = it;
+        } else if (it->echoReference != NULL) {
+            hasReference = true;
+        }
+    }
+    if (removed == mEffects.end()) {
+        return android::BAD_VALUE;
+    }
+    reference = removed->echoReference;
+    mEffects.erase(removed);
+    if (!hasReference) {
+        // Reference frames are not read any more, the ones kept would be late
+        mReference.first = mReference.frames = 0;
+    }
+    Log::Debug() << __FUNCTION__ << " (effect=" << effect
+                 << "): effect removed. number of effects after erase " << mEffects.size();
+    return android::OK;
+}
+
+status_t PreProcessing::process(void *buffer, size_t frames, ssize_t *processedFrames)
+{
+    // first reload enough frames at the end of the processing window
+    if (mProcessing.frames < frames) {
+
+        if (mProcessing.capacity < frames) {
+
+            // The client reads more frames than planned for the route
+            Log::Warning() << __FUNCTION__ << ": (frames=" << frames << "): planned for "
+                           << mProcessing.capacity / mReadsPerWindow << " frames per read";
+            status_t ret = plan(mFrameSize, frames);
+            if (ret != android::OK) {
+
+                return ret;
+            }
+        }
+        size_t readFrames = frames - mProcessing.frames;
+        char *readBuffer = reserve(mProcessing, readFrames);
+        AUDIOCOMMS_ASSERT(readBuffer != NULL, "Processing window too small");
+
+        status_t status = mSource.readFrames(readBuffer, readFrames, processedFrames);
+        if (status < 0) {
+
+            return status;
+        }
+        /* OK, we have to process all read frames */
+        mProcessing.frames += readFrames;
+    }
+
+    size_t processed = 0;
+    int processingReturn = processEffects(static_cast<char *>(buffer), frames, processed);
+    if (processingReturn != 0) {
+
+        // Effects processing failed
+        // at least, it is necessary to return the read HW frames
+        Log::Debug() << __FUNCTION__ << ": unable to apply any effect, ret=" << processingReturn;
+        size_t rawFrames = min(frames - processed, mProcessing.frames);
+        memcpy(static_cast<char *>(buffer) + processed * mFrameSize, getFront(mProcessing),
+               rawFrames * mFrameSize);
+        consume(mProcessing, rawFrames);
+        processed += rawFrames;
+    }
+    // Frames not consumed by the effects are kept in the window. Currently, the configuration
+    // imposes working with 160 frames and effects library works with 80 frames per cycle
+    // (10 ms), but effects library processing could be not more multiple of HW read frames.
+    *processedFrames = processed;
+    return android::OK;
+}
+
+int PreProcessing::processEffects(char *buffer, size_t frames, size_t &processedFrames)
+{
+    int ret = 0;
+
+    audio_buffer_t inBuf;
+    audio_buffer_t outBuf;
+
+    while ((processedFrames < frames) && (mProcessing.frames > 0) && (ret == 0)) {
+
+        size_t referenceConsumed = 0;
+        vector<Effect>::const_iterator it;
+        for (it = mEffects.begin(); it != mEffects.end(); ++it) {
+
+            if (it->echoReference != NULL) {
+
+                referenceConsumed = max(referenceConsumed, pushEchoReference(*it));
+            }
+            // in_buf.frameCount and out_buf.frameCount indicate respectively
+            // the maximum number of frames to be consumed and produced by process()
+            inBuf.frameCount = mProcessing.frames;
+            inBuf.raw = getFront(mProcessing);
+            outBuf.frameCount = frames - processedFrames;
+            outBuf.raw = buffer + processedFrames * mFrameSize;
+
+            ret = (*(it->preprocessor))->process(it->preprocessor, &inBuf, &outBuf);
+            if (ret != 0) {
+
+                // Failure is not hidden by the result of the next effects
+                break;
+            }
+            // Note: it is useless to recopy the output of effect processing as input
+            // for the next effect processing because it is done in webrtc::audio_processing
+
+            // process() has updated the number of frames consumed and produced in
+            // in_buf.frameCount and out_buf.frameCount respectively
+            consume(mProcessing, inBuf.frameCount);
+            processedFrames += outBuf.frameCount;
+        }
+        // All the effects were given the same reference frames
+        consume(mReference, referenceConsumed);
+    }
+    return ret;
+}
+
+size_t PreProcessing::pushEchoReference(const Effect &effect)
+{
+    effect_handle_t preprocessor = effect.preprocessor;
+    struct echo_reference_itfe *reference = effect.echoReference;
+    AUDIOCOMMS_ASSERT(preprocessor != NULL, "Null preproc pointer");
+    AUDIOCOMMS_ASSERT(*preprocessor != NULL, "Null preproc");
+    AUDIOCOMMS_ASSERT(reference != NULL, "Null reference");
+
+    /* read frames from echo reference buffer and update echo delay */
+    if (mReference.frames < mProcessing.frames) {
+
+        struct echo_reference_buffer b;
+        b.delay_ns = 0;
+        b.frame_count = mProcessing.frames - mReference.frames;
+        b.raw = reserve(mReference, b.frame_count);
+        if (b.raw == NULL) {
+            // Reference not consumed by the effects, restart from the latest frames
+            Log::Warning() << __FUNCTION__ << ": reference window full, dropping "
+                           << mReference.frames << " frames";
+            mReference.first = mReference.frames = 0;
+            b.frame_count = min(mProcessing.frames, mReference.capacity);
+            b.raw = mReference.buffer;
+        }
+        mSource.getCaptureDelay(&b);
+
+        if (reference->read(reference, &b) == 0) {
+
+            mReference.frames += b.frame_count;
+            mEchoDelayUs = b.delay_ns / 1000;
+        } else {
+            Log::Warning() << __FUNCTION__ << ": NOT enough frames to read ref buffer";
+        }
+    }
+
+    if ((*preprocessor)->process_reverse == NULL) {
+        Log::Warning() << __FUNCTION__ << ": process_reverse is NULL";
+        return 0;
+    }
+
+    audio_buffer_t buf;
+    buf.frameCount = mReference.frames;
+    buf.raw = getFront(mReference);
+
+    // Frames consumed are counted whatever process_reverse() returns
+    (*preprocessor)->process_reverse(preprocessor, &buf, NULL);
+    // Delay of the latest frames read, the reference may already hold the frames to process
+    setPreprocessorEchoDelay(preprocessor, mEchoDelayUs);
+    return buf.frameCount;
+}
+
+status_t PreProcessing::setPreprocessorParam(effect_handle_t effect, effect_param_t *param)
+{
+    AUDIOCOMMS_ASSERT(effect != NULL, "NULL effect context");
+    AUDIOCOMMS_ASSERT(*effect != NULL, "NULL effect interface");
+    AUDIOCOMMS_ASSERT(param != NULL, "Null param");
+
+    status_t ret;
+    uint32_t size = sizeof(int);
+    AUDIOCOMMS_ASSERT(param->psize >= 1, "Invalid parameter size");
+    uint32_t psize = ((param->psize - 1) / sizeof(int) + 1) * sizeof(int) + param->vsize;
+
+    ret = (*effect)->command(effect,
+                             EFFECT_CMD_SET_PARAM,
+                             sizeof(effect_param_t) + psize,
+                             param,
+                             &size,
+                             &param->status);
+
+    return ret == 0 ? param->status : ret;
+}
+
+status_t PreProcessing::setPreprocessorEchoDelay(effect_handle_t effect, int32_t delayUs)
+{
+    AUDIOCOMMS_ASSERT(effect != NULL, "NULL effect context");
+    AUDIOCOMMS_ASSERT(*effect != NULL, "NULL effect interface");
+    /** effect_param_t contains extensible field "data"
+     * in our case, it is necessary to "allocate" memory to store
+     * AEC_PARAM_ECHO_DELAY and delay_us as uint32_t
+     * so, computation of "allocated" memory is size of
+     * effect_param_t in uint32_t + 2
+     */
+    uint32_t buf[sizeof(effect_param_t) / sizeof(uint32_t) + 2];
+    effect_param_t *param = reinterpret_cast<effect_param_t *>(buf);
+
+    param->psize = sizeof(uint32_t);
+    param->vsize = sizeof(uint32_t);
+
+    struct delay
+    {
+        uint32_t aecEchoDelay;
+        uint32_t delayUs;
+    };
+    delay *data = reinterpret_cast<delay *>(param->data);
+
+    data->aecEchoDelay = AEC_PARAM_ECHO_DELAY;
+    data->delayUs = delayUs;
+
+    return setPreprocessorParam(effect, param);
+}
+
+status_t PreProcessing::resize(FrameWindow &window, size_t capacity)
+{
+    if (window.frames > capacity) {
+        // Latest frames are kept
+        consume(window, window.frames - capacity);
+    }
+    char *buffer = new char[capacity * mFrameSize];
+    if (buffer == NULL) {
+        Log::Error() << __FUNCTION__ << ": (capacity=" << capacity << "): allocation failed";
+        return android::NO_MEMORY;
+    }
+    if (window.frames != 0) {
+        memcpy(buffer, getFront(window), window.frames * mFrameSize);
+    }
+    delete[] window.buffer;
+    window.buffer = buffer;
+    window.capacity = capacity;
+    window.first = 0;
+    return android::OK;
+}
+
+char *PreProcessing::reserve(FrameWindow &window, size_t frames)
+{
+    if (window.frames + frames > window.capacity) {
+        return NULL;
+    }
+    if (window.first + window.frames + frames > window.capacity) {
+        // No room left at the back
+        memmove(window.buffer, getFront(window), window.frames * mFrameSize);
+        window.first = 0;
+    }
+    return getFront(window) + window.frames * mFrameSize;
+}
+
+void PreProcessing::consume(FrameWindow &window, size_t frames)
+{
+    AUDIOCOMMS_ASSERT(frames <= window.frames, "Consuming more frames than kept");
+    window.frames -= frames;
+    // An empty window restarts at the front of its buffer
+    window.first = (window.frames == 0) ? 0 : window.first + frames;
+}
+
+void PreProcessing::release(FrameWindow &window)
+{
+    delete[] window.buffer;
+    window.buffer = NULL;
+    window.capacity = window.first = window.frames = 0;
+}
+
+} // namespace intel_audio
@@ -0,0 +1,229 @@
+/*
+ * INTEL CONFIDENTIAL
+ * Copyright (c) 2013-2014 Intel
+ * Corporation All Rights Reserved.
+ *
+ * The source code contained or described herein and all documents related to
+ * the source code ("Material") are owned by Intel Corporation or its suppliers
+ * or licensors. Title to the Material remains with Intel Corporation or its
+ * suppliers and licensors. The Material contains trade secrets and proprietary
+ * and confidential information of Intel or its suppliers and licensors. The
+ * Material is protected by worldwide copyright and trade secret laws and
+ * treaty provisions. No part of the Material may be used, copied, reproduced,
+ * modified, published, uploaded, posted, transmitted, distributed, or
+ * disclosed in any way without Intel's prior express written permission.
+ *
+ * No license under any patent, copyright, trade secret or other intellectual
+ * property right is granted to or conferred upon you by disclosure or delivery
+ * of the Materials, either expressly, by implication, inducement, estoppel or
+ * otherwise. Any license under such intellectual property rights must be
+ * express and approved by Intel in writing.
+ *
+ */
+#pragma once
+
+#include <NonCopyable.hpp>
+#include <audio_utils/echo_reference.h>
+#include <hardware/audio_effect.h>
+#include <utils/Errors.h>
+#include <sys/types.h>
+#include <vector>
+
+namespace intel_audio
+{
+
+/**
+ * Software pre-processing of the frames captured by an input stream.
+ *
+ * The scratch memory of the pre-processing is planned once per route configuration: the
+ * frames waiting to be processed and the echo reference frames are each kept in a window
+ * on a buffer sized for the frames read by the stream, so that reading, processing and
+ * consuming frames neither allocates nor copies them. The echo reference frames are read
+ * once per processing cycle and given as is to all the effects processing the reference.
+ */
+class PreProcessing : private audio_comms::utilities::NonCopyable
+{
+public:
+    /** Provider of the captured frames, implemented by the input stream. */
+    class Source
+    {
+    public:
+        virtual ~Source() {}
+
+        /**
+         * Read audio frames into the buffer.
+         *
+         * @param[out] buffer memory in which it will copy the frames.
+         * @param[in] frames requested frames to read.
+         * @param[out] processedFrames number of frames processed if successful.
+         *
+         * @return 0 if success, negative error code otherwise.
+         */
+        virtual android::status_t readFrames(void *buffer, size_t frames,
+                                             ssize_t *processedFrames) = 0;
+
+        /**
+         * Get the capture delay of the frames read from the echo reference.
+         *
+         * @param[in,out] buffer echo reference structure.
+         */
+        virtual void getCaptureDelay(struct echo_reference_buffer *buffer) = 0;
+    };
+
+    PreProcessing(Source &source);
+    ~PreProcessing();
+
+    /**
+     * Size the scratch memory for a route configuration.
+     * Frames waiting to be processed are kept if the frame size does not change.
+     *
+     * @param[in] frameSize size of a frame of the stream, in bytes.
+     * @param[in] framesPerRead number of frames read at once by the stream client.
+     *
+     * @return OK if successful allocation, error code otherwise.
+     */
+    android::status_t plan(size_t frameSize, size_t framesPerRead);
+
+    /**
+     * Add an effect to the pre-processing.
+     *
+     * @param[in] effect handle on the effect.
+     * @param[in] reference echo reference to process, NULL if the effect does not need it.
+     *
+     * @return OK, even if the effect was already added.
+     */
+    android::status_t addEffect(effect_handle_t effect, struct echo_reference_itfe *reference);
+
+    /**
+     * Remove an effect from the pre-processing.
+     *
+     * @param[in] effect handle on the effect.
+     * @param[out] reference echo reference the effect was processing, NULL if none.
+     *
+     * @return OK if the effect was removed, BAD_VALUE if not found.
+     */
+    android::status_t removeEffect(effect_handle_t effect,
+                                   struct echo_reference_itfe *&reference);
+
+    bool hasEffects() const
+    {
+        return !mEffects.empty();
+    }
+
+    /**
+     * Read frames from the source and process them into the buffer.
+     * Frames not consumed by the effects are kept for the next call.
+     *
+     * @param[out] buffer memory in which it will copy the processed frames.
+     * @param[in] frames requested frames to read.
+     * @param[out] processedFrames number of frames processed if successful.
+     *
+     * @return 0 if success, negative error code otherwise.
+     */
+    android::status_t process(void *buffer, size_t frames, ssize_t *processedFrames);
+
+    /** @return number of frames read from the source and not processed yet. */
+    size_t getPendingFrames() const
+    {
+        return mProcessing.frames;
+    }
+
+private:
+    struct Effect
+    {
+        effect_handle_t preprocessor;
+        struct echo_reference_itfe *echoReference;
+    };
+
+    /**
+     * Frames kept in a buffer allocated once. Frames are consumed from the front and appended
+     * at the back, they are moved to the front of the buffer only when there is no room left
+     * at the back.
+     */
+    struct FrameWindow
+    {
+        char *buffer;
+        size_t capacity; /**< Size of the buffer, in frames. */
+        size_t first;    /**< Index of the first frame kept. */
+        size_t frames;   /**< Number of frames kept. */
+    };
+
+    /**
+     * Apply the effects until the buffer is filled or the frames to process are consumed.
+     *
+     * @param[out] buffer memory in which it will copy the processed frames.
+     * @param[in] frames requested frames.
+     * @param[in,out] processedFrames number of frames processed.
+     *
+     * @return 0 if success, error code of the last effect which failed otherwise.
+     */
+    int processEffects(char *buffer, size_t frames, size_t &processedFrames);
+
+    /**
+     * Read frames from echo reference, up to the frames to process, and give them to a
+     * preprocessor with the echo delay. Frames are not consumed from the reference window.
+     *
+     * @param[in] effect preprocessor and its echo reference.
+     *
+     * @return number of frames of the reference window consumed by the preprocessor.
+     */
+    size_t pushEchoReference(const Effect &effect);
+
+    /**
+     * Set preprocessor echo delay.
+     *
+     * @param[out] effect preprocessor handle.
+     * @param[out] delayUs delay of the echo in micro seconds.
+     *
+     * @return OK if successful operation, error code otherwise.
+     */
+    static android::status_t setPreprocessorEchoDelay(effect_handle_t effect, int32_t delayUs);
+
+    /**
+     * Set preprocessor parameters.
+     *
+     * @param[out] effect preprocessor handle
+     * @param[out] param parameters to send to the preprocessor.
+     *
+     * @return OK if successful operation, error code otherwise.
+     */
+    static android::status_t setPreprocessorParam(effect_handle_t effect, effect_param_t *param);
+
+    /**
+     * Reallocate the buffer of a window, keeping its frames.
+     *
+     * @return OK if successful allocation, NO_MEMORY otherwise.
+     */
+    android::status_t resize(FrameWindow &window, size_t capacity);
+
+    /** @return room for frames appended at the back of a window, NULL if it does not fit. */
+    char *reserve(FrameWindow &window, size_t frames);
+
+    char *getFront(const FrameWindow &window) const
+    {
+        return window.buffer + window.first * mFrameSize;
+    }
+
+    static void consume(FrameWindow &window, size_t frames);
+
+    static void release(FrameWindow &window);
+
+    Source &mSource;
+
+    std::vector<Effect> mEffects;
+
+    size_t mFrameSize;
+
+    /** Frames read from the source, used as input of the effects. */
+    FrameWindow mProcessing;
+
+    /** Frames read from the echo reference of the effects, shared by all the effects. */
+    FrameWindow mReference;
+
+    int32_t mEchoDelayUs; /**< Echo delay of the latest frames read from the reference. */
+
+    /** Windows capacity, in reads of the stream client, so that moving frames is rare. */
+    static const size_t mReadsPerWindow = 2;
+};
+
+} // namespace intel_audio
@@ -33,6 +33,8 @@
 #include "Property.h"
 #include <AudioConversion.hpp>
 #include <HalAudioDump.hpp>
+#include <errno.h>
+#include <unistd.h>
 #include <string>
 
 using android::status_t;
@@ -393,18 +395,18 @@ void Stream::initAudioDump()
     }
 }
 
-bool Stream::safeSleep(uint32_t sleepTimeUs)
+status_t Stream::dump(int fd) const
 {
-    struct timespec tim;
-
-    if (sleepTimeUs > mMaxSleepTime) {
-        sleepTimeUs = mMaxSleepTime;
+    std::string stats = dumpRecoveryStats();
+    if (stats.empty()) {
+        return android::OK;
     }
-
-    tim.tv_sec = 0;
-    tim.tv_nsec = sleepTimeUs * mNsecPerUsec;
-
-    return nanosleep(&tim, NULL) > 0;
+    std::string out = std::string(isOut() ? "Output" : "Input") + " stream pcm recoveries:\n"
+                      + stats;
+    if (write(fd, out.c_str(), out.size()) < 0) {
+        return -errno;
+    }
+    return android::OK;
 }
 
 } // namespace intel_audio
@@ -66,8 +66,8 @@ public:
     virtual audio_format_t getFormat() const;
     virtual android::status_t setFormat(audio_format_t format);
     virtual android::status_t standby();
-    /** @note API not implemented in our Audio HAL */
-    virtual android::status_t dump(int) const { return android::OK; }
+    /** Writes the recovery statistics of the pcm transfers. */
+    virtual android::status_t dump(int fd) const;
     virtual audio_devices_t getDevice() const;
     virtual android::status_t setDevice(audio_devices_t device);
     /** @note API not implemented in stream base class, input specific implementation only. */
@@ -209,25 +209,6 @@ protected:
         return mDumpAfterConv;
     }
 
-    /**
-     * Used to sleep on the current thread.
-     *
-     * This function is used to get a POSIX-compliant way
-     * to accurately sleep the current thread.
-     *
-     * If function is successful, zero is returned
-     * and request has been honored, if function fails,
-     * EINTR has been raised by the system and -1 is returned.
-     *
-     * The other two errors considered by standard
-     * are not applicable in our context (EINVAL, ENOSYS)
-     *
-     * @param[in] sleepTimeUs: desired to sleep, in microseconds.
-     *
-     * @return on success true is returned, false otherwise.
-     */
-    bool safeSleep(uint32_t sleepTimeUs);
-
     Device *mParent; /**< Audio HAL singleton handler. */
 
     /**
@@ -239,15 +220,6 @@ protected:
      */
     android::RWLock mPreProcEffectLock;
 
-    /**
-     * maximum number of read/write retries.
-     *
-     * This constant is used to set maximum number of retries to do
-     * on write/read operations before stating that error is not
-     * recoverable and reset media server.
-     */
-    static const uint32_t mMaxReadWriteRetried = 50;
-
 private:
     /**
      * Configures the conversion chain.
@@ -312,11 +284,5 @@ private:
      * Array of property names after conversion
      */
     static const std::string dumpAfterConvProps[audio_comms::utilities::Direction::_nbDirections];
-
-    /** maximum sleep time to be allowed by HAL, in microseconds. */
-    static const uint32_t mMaxSleepTime = 1000000UL;
-
-    /** Ratio between nanoseconds and microseconds */
-    static const uint32_t mNsecPerUsec = 1000;
 };
 } // namespace intel_audio
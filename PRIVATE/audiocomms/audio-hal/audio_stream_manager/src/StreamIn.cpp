@@ -44,13 +44,7 @@ StreamIn::StreamIn(Device *parent, audio_source_t source)
     : Stream(parent),
       mFramesLost(0),
       mFramesIn(0),
-      mProcessingFramesIn(0),
-      mProcessingBuffer(NULL),
-      mProcessingBufferSizeInFrames(0),
-      mReferenceFramesIn(0),
-      mReferenceBuffer(NULL),
-      mReferenceBufferSizeInFrames(0),
-      mPreprocessorsHandlerList(),
+      mPreProcessing(*this),
       mHwBuffer(NULL)
 {
     setInputSource(source);
@@ -82,39 +76,19 @@ status_t StreamIn::getNextBuffer(AudioBufferProvider::Buffer *buffer,
 
 status_t StreamIn::readHwFrames(void *buffer, size_t frames)
 {
-    uint32_t retryCount = 0;
-    status_t ret;
+    std::string error;
+    status_t ret = pcmReadFrames(buffer, frames, error);
 
-    do {
-        std::string error;
+    if (ret != android::OK) {
+        Log::Error() << __FUNCTION__ << ": read error: " << error << " - requested " << frames
+                     << " (bytes=" << streamSampleSpec().convertFramesToBytes(frames)
+                     << ") frames";
 
-        ret = pcmReadFrames(buffer, frames, error);
-
-        if (ret < 0) {
-            Log::Error() << __FUNCTION__ << ": read error: " << error << " - requested " << frames
-                         << " (bytes=" << streamSampleSpec().convertFramesToBytes(frames)
-                         << ") frames";
-
-            if (error.find(strerror(EBADFD)) != std::string::npos) {
-                return android::DEAD_OBJECT;
-            }
-
-            AUDIOCOMMS_ASSERT(++retryCount < mMaxReadWriteRetried,
-                              "Hardware not responding, restarting media server");
-
-            // Get the number of microseconds to sleep, inferred from the number of
-            // frames to write.
-            size_t sleepUSecs = routeSampleSpec().convertFramesToUsec(frames);
-
-            // Go sleeping before trying I/O operation again.
-            if (safeSleep(sleepUSecs)) {
-                // If some error arises when trying to sleep, try I/O operation anyway.
-                // Error counter will provoke the restart of mediaserver.
-                Log::Error() << __FUNCTION__ << ":  Error while calling nanosleep interface";
-            }
+        if (ret == android::DEAD_OBJECT) {
+            return ret;
         }
-
-    } while (ret < 0);
+    }
+    AUDIOCOMMS_ASSERT(ret == android::OK, "Hardware not responding, restarting media server");
 
     // Dump audio input before eventual conversions
     // FOR DEBUG PURPOSE ONLY
@@ -124,7 +98,8 @@ status_t StreamIn::readHwFrames(void *buffer, size_t frames)
                                                     isOut(),
                                                     routeSampleSpec().getSampleRate(),
                                                     routeSampleSpec().getChannelCount(),
-                                                    "before_conversion");
+                                                    "before_conversion",
+                                                    audio_bytes_per_sample(routeSampleSpec().getFormat()));
     }
 
     return ret;
@@ -159,124 +134,14 @@ status_t StreamIn::readFrames(void *buffer, size_t frames, ssize_t *processedFra
                                                    isOut(),
                                                    streamSampleSpec().getSampleRate(),
                                                    streamSampleSpec().getChannelCount(),
-                                                   "after_conversion");
+                                                   "after_conversion",
+                                                   audio_bytes_per_sample(streamSampleSpec().getFormat()));
     }
 
     *processedFrames = frames;
     return status;
 }
 
-int StreamIn::doProcessFrames(const void *buffer, ssize_t frames,
-                              ssize_t *processedFrames,
-                              ssize_t *processingFramesIn)
-{
-    int ret = 0;
-
-    audio_buffer_t inBuf;
-    audio_buffer_t outBuf;
-
-    while ((*processedFrames < frames) && (*processingFramesIn > 0) && (ret == 0)) {
-
-        vector<AudioEffectHandle>::const_iterator it;
-        for (it = mPreprocessorsHandlerList.begin(); it != mPreprocessorsHandlerList.end(); ++it) {
-
-            if (it->mEchoReference != NULL) {
-
-                pushEchoReference(*processingFramesIn, it->mPreprocessor, it->mEchoReference);
-            }
-            // in_buf.frameCount and out_buf.frameCount indicate respectively
-            // the maximum number of frames to be consumed and produced by process()
-            inBuf.frameCount = *processingFramesIn;
-            inBuf.s16 = (int16_t *)((char *)mProcessingBuffer +
-                                    streamSampleSpec().convertFramesToBytes(*processedFrames));
-            outBuf.frameCount = frames - *processedFrames;
-            outBuf.s16 = (int16_t *)((char *)buffer +
-                                     streamSampleSpec().convertFramesToBytes(*processedFrames));
-
-            ret = (*(it->mPreprocessor))->process(it->mPreprocessor, &inBuf, &outBuf);
-            if (ret == 0) {
-                // Note: it is useless to recopy the output of effect processing as input
-                // for the next effect processing because it is done in webrtc::audio_processing
-
-                // process() has updated the number of frames consumed and produced in
-                // in_buf.frameCount and out_buf.frameCount respectively
-                *processingFramesIn -= inBuf.frameCount;
-                *processedFrames += outBuf.frameCount;
-            }
-        }
-    }
-    return ret;
-}
-
-status_t StreamIn::processFrames(void *buffer, ssize_t frames, ssize_t *processedFrames)
-{
-    // first reload enough frames at the end of process input buffer
-    if (mProcessingFramesIn < frames) {
-
-        if (mProcessingBufferSizeInFrames < frames) {
-
-            status_t ret = allocateProcessingMemory(frames);
-            if (ret != android::OK) {
-
-                return ret;
-            }
-        }
-
-        ssize_t read_frames = frames - mProcessingFramesIn;
-
-        status_t status = readFrames((char *)mProcessingBuffer +
-                                     streamSampleSpec().convertFramesToBytes(
-                                         mProcessingFramesIn),
-                                     read_frames, processedFrames);
-        if (status < 0) {
-
-            return status;
-        }
-        /* OK, we have to process all read frames */
-        mProcessingFramesIn += read_frames;
-        AUDIOCOMMS_ASSERT(mProcessingFramesIn >= frames, "Not enough frames");
-
-    }
-
-    *processedFrames = 0;
-    ssize_t processingFramesIn = mProcessingFramesIn;
-    int processingReturn = 0;
-
-    // Then process the frames
-    processingReturn = doProcessFrames(buffer, frames, processedFrames, &processingFramesIn);
-    if (processingReturn != 0) {
-
-        // Effects processing failed
-        // at least, it is necessary to return the read HW frames
-        Log::Debug() << __FUNCTION__ << ": unable to apply any effect, ret=" << processingReturn;
-        memcpy(buffer,
-               mProcessingBuffer,
-               streamSampleSpec().convertFramesToBytes(mProcessingFramesIn));
-        *processedFrames = mProcessingFramesIn;
-    } else {
-
-        // move remaining frames to the beginning of mProccesingBuffer because currently,
-        // the configuration imposes working with 160 frames and effects library works
-        // with 80 frames per cycle (10 ms), i.e. the processing of 160 read HW frames
-        // requests two calls to effects library (which are done by while loop. In future or
-        // if configuration changed, effects library processing could be not more multiple of
-        // HW read frames, so it is necessary to realign the buffer
-        if (processingFramesIn != 0) {
-
-            AUDIOCOMMS_ASSERT(processingFramesIn > 0, "Not enough frames");
-            memmove(mProcessingBuffer,
-                    (char *)mProcessingBuffer +
-                    streamSampleSpec().convertFramesToBytes(mProcessingFramesIn -
-                                                            processingFramesIn),
-                    streamSampleSpec().convertFramesToBytes(processingFramesIn));
-        }
-    }
-    // at the end, we keep remainder frames not cosumed by effect processor.
-    mProcessingFramesIn = processingFramesIn;
-
-    return android::OK;
-}
-
 status_t StreamIn::read(void *buffer, size_t &bytes)
 {
     setStandby(false);
@@ -301,9 +166,9 @@ status_t StreamIn::read(void *buffer, size_t &bytes)
     // Take the effect lock while processing
     mPreProcEffectLock.readLock();
 
-    if (!mPreprocessorsHandlerList.empty()) {
+    if (mPreProcessing.hasEffects()) {
 
-        status = processFrames(buffer, frames, &received_frames);
+        status = mPreProcessing.process(buffer, frames, &received_frames);
     } else {
 
         status = readFrames(buffer, frames, &received_frames);
@@ -377,7 +242,14 @@ status_t StreamIn::attachRouteL()
 
         return status;
     }
-    return allocateHwBuffer();
+    status = allocateHwBuffer();
+    if (status != android::OK) {
+
+        return status;
+    }
+    // Pre-processing buffers are sized for the frames read by the client on this route
+    return mPreProcessing.plan(streamSampleSpec().getFrameSize(),
+                               streamSampleSpec().convertBytesToFrames(getBufferSize()));
 }
 
 status_t StreamIn::detachRouteL()
@@ -514,52 +386,24 @@ status_t StreamIn::removeAudioEffect(effect_handle_t effect)
 status_t StreamIn::addSwAudioEffectL(effect_handle_t effect,
                                      echo_reference_itfe *reference)
 {
-    AUDIOCOMMS_ASSERT(effect != NULL, "NULL effect context");
-    AUDIOCOMMS_ASSERT(*effect != NULL, "NULL effect interface");
-
-    // audio effects processing is very costy in term of CPU,
-    // so useless to add the same effect more than one time
-    vector<AudioEffectHandle>::const_iterator it;
-    it = std::find_if(mPreprocessorsHandlerList.begin(), mPreprocessorsHandlerList.end(),
-                      std::bind2nd(MatchEffect(), effect));
-    if (it != mPreprocessorsHandlerList.end()) {
-        Log::Warning() << __FUNCTION__ << ": (effect=" << effect
-                       << "): it is useless to add again the same effect";
-        return android::OK;
-    }
-    mPreprocessorsHandlerList.push_back(AudioEffectHandle(effect, reference));
-    Log::Debug() << __FUNCTION__ << ": (effect=" << effect
-                 << "): effect added. number of stored effects is"
-                 << effect, mPreprocessorsHandlerList.size();
-    return android::OK;
+    return mPreProcessing.addEffect(effect, reference);
 }
 
 status_t StreamIn::removeSwAudioEffectL(effect_handle_t effect)
 {
-    AUDIOCOMMS_ASSERT(effect != NULL, "NULL effect context");
-    AUDIOCOMMS_ASSERT(*effect != NULL, "NULL effect interface");
+    struct echo_reference_itfe *reference;
+    status_t status = mPreProcessing.removeEffect(effect, reference);
+    if (status != android::OK) {
 
-    vector<AudioEffectHandle>::iterator it;
-    it = std::find_if(mPreprocessorsHandlerList.begin(), mPreprocessorsHandlerList.end(),
-                      std::bind2nd(MatchEffect(), effect));
-    if (it != mPreprocessorsHandlerList.end()) {
-        Log::Debug() << __FUNCTION__ << ": (effect=" << effect
-                     << "): effect has been found. number of effects before erase "
-                     << mPreprocessorsHandlerList.size();
-        if (it->mEchoReference != NULL) {
-
-            /* stop reading from echo reference */
-            it->mEchoReference->read(it->mEchoReference, NULL);
-            mParent->resetEchoReference(it->mEchoReference);
-            it->mEchoReference = NULL;
-        }
-        mPreprocessorsHandlerList.erase(it);
-        Log::Debug() << __FUNCTION__ << " (effect=" << effect
-                     << "): effect has been found. number of effects after erase "
-                     << mPreprocessorsHandlerList.size();
-        return android::OK;
+        return status;
+    }
+    if (reference != NULL) {
+
+        /* stop reading from echo reference */
+        reference->read(reference, NULL);
+        mParent->resetEchoReference(reference);
     }
-    return android::BAD_VALUE;
+    return android::OK;
 }
 
 status_t StreamIn::getAudioEffectNameFromHandle(effect_handle_t effect,
@@ -628,7 +472,8 @@ void StreamIn::getCaptureDelay(struct echo_reference_buffer *buffer)
     // read frames available in audio HAL input buffer
     // add number of frames being read as we want the capture time of first sample
     // in current buffer.
-    buf_delay = streamSampleSpec().convertFramesToUsec(mFramesIn + mProcessingFramesIn);
+    buf_delay = streamSampleSpec().convertFramesToUsec(mFramesIn +
+                                                       mPreProcessing.getPendingFrames());
 
     // add delay introduced by kernel
     kernel_delay = routeSampleSpec().convertFramesToUsec(kernel_frames);
@@ -643,158 +488,4 @@ void StreamIn::getCaptureDelay(struct echo_reference_buffer *buffer)
                    << "], kernel_frames:[" << kernel_frames << "]";
 }
 
-int32_t StreamIn::updateEchoReference(ssize_t frames,
-                                      struct echo_reference_itfe *reference)
-{
-    struct echo_reference_buffer b;
-
-    AUDIOCOMMS_ASSERT(reference != NULL, "Null reference handle");
-
-    b.delay_ns = 0;
-
-    if (mReferenceFramesIn < frames) {
-
-        if (mReferenceBufferSizeInFrames < frames) {
-
-            mReferenceBufferSizeInFrames = frames;
-            int16_t *referenceBuffer = (int16_t *)realloc(mReferenceBuffer,
-                                                          streamSampleSpec().convertFramesToBytes(
-                                                              mReferenceBufferSizeInFrames));
-            if (referenceBuffer == NULL) {
-                Log::Error() << __FUNCTION__ << ": (frames=" << frames << "): realloc failed";
-                return android::NO_MEMORY;
-            }
-            mReferenceBuffer = referenceBuffer;
-        }
-
-        b.frame_count = frames - mReferenceFramesIn;
-        b.raw = (void *)((char *)mReferenceBuffer +
-                         streamSampleSpec().convertFramesToBytes(mReferenceFramesIn));
-
-        getCaptureDelay(&b);
-
-        if (reference->read(reference, &b) == 0) {
-
-            mReferenceFramesIn += b.frame_count;
-        } else {
-            Log::Warning() << __FUNCTION__ << ": NOT enough frames to read ref buffer";
-        }
-    }
-    return b.delay_ns;
-}
-
-status_t StreamIn::pushEchoReference(ssize_t frames, effect_handle_t preprocessor,
-                                     struct echo_reference_itfe *reference)
-{
-    /* read frames from echo reference buffer and update echo delay
-     * mReferenceFramesIn is updated with frames available in mReferenceBuffer */
-    int32_t delay_us = updateEchoReference(frames, reference) / 1000;
-
-    AUDIOCOMMS_ASSERT(preprocessor != NULL, "Null preproc pointer");
-    AUDIOCOMMS_ASSERT(*preprocessor != NULL, "Null preproc");
-    AUDIOCOMMS_ASSERT(reference != NULL, "Null eference");
-
-    if (mReferenceFramesIn < frames) {
-
-        frames = mReferenceFramesIn;
-    }
-
-    if ((*preprocessor)->process_reverse == NULL) {
-        Log::Warning() << __FUNCTION__ << ": (frames " << frames << ": process_reverse is NULL";
-        return android::BAD_VALUE;
-    }
-
-    audio_buffer_t buf;
-
-    buf.frameCount = mReferenceFramesIn;
-    buf.s16 = mReferenceBuffer;
-
-    status_t processingReturn = (*preprocessor)->process_reverse(preprocessor,
-                                                                 &buf,
-                                                                 NULL);
-    setPreprocessorEchoDelay(preprocessor, delay_us);
-    mReferenceFramesIn -= buf.frameCount;
-
-    if (mReferenceFramesIn > 0) {
-
-        memcpy(mReferenceBuffer,
-               (char *)mReferenceBuffer + streamSampleSpec().convertFramesToBytes(buf.frameCount),
-               streamSampleSpec().convertFramesToBytes(mReferenceFramesIn));
-    }
-
-    return processingReturn;
-}
-
-status_t StreamIn::setPreprocessorParam(effect_handle_t effect, effect_param_t *param)
-{
-    AUDIOCOMMS_ASSERT(effect != NULL, "NULL effect context");
-    AUDIOCOMMS_ASSERT(*effect != NULL, "NULL effect interface");
-    AUDIOCOMMS_ASSERT(param != NULL, "Null param");
-
-    status_t ret;
-    uint32_t size = sizeof(int);
-    AUDIOCOMMS_ASSERT(param->psize >= 1, "Invalid parameter size");
-    uint32_t psize = ((param->psize - 1) / sizeof(int) + 1) * sizeof(int) + param->vsize;
-
-    ret = (*effect)->command(effect,
-                             EFFECT_CMD_SET_PARAM,
-                             sizeof(effect_param_t) + psize,
-                             param,
-                             &size,
-                             &param->status);
-
-    return ret == 0 ? param->status : ret;
-}
-
-status_t StreamIn::setPreprocessorEchoDelay(effect_handle_t effect, int32_t delayInUs)
-{
-    AUDIOCOMMS_ASSERT(effect != NULL, "NULL effect context");
-    AUDIOCOMMS_ASSERT(*effect != NULL, "NULL effect interface");
-    /** effect_param_t contains extensible field "data"
-     * in our case, it is necessary to "allocate" memory to store
-     * AEC_PARAM_ECHO_DELAY and delay_us as uint32_t
-     * so, computation of "allocated" memory is size of
-     * effect_param_t in uint32_t + 2
-     */
-    uint32_t buf[sizeof(effect_param_t) / sizeof(uint32_t) + 2];
-    effect_param_t *param = reinterpret_cast<effect_param_t *>(buf);
-
-    param->psize = sizeof(uint32_t);
-    param->vsize = sizeof(uint32_t);
-
-    struct delay
-    {
-        uint32_t aecEchoDelay;
-        uint32_t delayUs;
-    };
-    delay *data = reinterpret_cast<delay *>(param->data);
-
-    data->aecEchoDelay = AEC_PARAM_ECHO_DELAY;
-    data->delayUs = delayInUs;
-
-    return setPreprocessorParam(effect, param);
-}
-
-status_t StreamIn::allocateProcessingMemory(ssize_t frames)
-{
-    mProcessingBufferSizeInFrames = frames;
-
-    int16_t *processingBuffer = (int16_t *)realloc(mProcessingBuffer,
-                                                   streamSampleSpec().convertFramesToBytes(
-                                                       mProcessingBufferSizeInFrames));
-    if (processingBuffer == NULL) {
-        Log::Error() << __FUNCTION__ << ": (frames=" << frames
-                     << "): realloc failed errno = " << strerror(errno) << "!";
-        return android::NO_MEMORY;
-    }
-    mProcessingBuffer = processingBuffer;
-    Log::Debug() << __FUNCTION__ << ": (frames=" << frames
-                 << "): mProcessingBuffer=" << mProcessingBuffer
-                 << " size extended to " << mProcessingBufferSizeInFrames
-                 << " frames (i.e. "
-                 << streamSampleSpec().convertFramesToBytes(mProcessingBufferSizeInFrames)
-                 << " bytes)";
-    return android::OK;
-}
-
 } // namespace intel_audio
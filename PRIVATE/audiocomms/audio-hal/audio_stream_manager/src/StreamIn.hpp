@@ -23,6 +23,7 @@
 #pragma once
 
 #include "Device.hpp"
+#include "PreProcessing.hpp"
 #include "Stream.hpp"
 #include <StreamInterface.hpp>
 #include <media/AudioBufferProvider.h>
@@ -33,7 +34,7 @@ namespace intel_audio
 {
 
 class StreamIn : public StreamInInterface, public Stream,
-                 public android::AudioBufferProvider
+                 public android::AudioBufferProvider, private PreProcessing::Source
 {
 private:
     typedef std::list<effect_handle_t>::iterator AudioEffectsListIterator;
@@ -162,32 +163,6 @@ private:
      */
     bool isAecEffect(effect_handle_t effect);
 
-    class AudioEffectHandle
-    {
-    public:
-        effect_handle_t mPreprocessor;
-        struct echo_reference_itfe *mEchoReference;
-        AudioEffectHandle()
-            : mPreprocessor(NULL), mEchoReference(NULL) {}
-        AudioEffectHandle(effect_handle_t effect, struct echo_reference_itfe *reference)
-            : mPreprocessor(effect), mEchoReference(reference) {}
-        ~AudioEffectHandle() {}
-    };
-
-    /**
-     * Function to be used as the predicate in find_if call.
-     */
-    struct MatchEffect : public std::binary_function<AudioEffectHandle, effect_handle_t, bool>
-    {
-
-        bool operator()(const AudioEffectHandle &effectHandle,
-                        const effect_handle_t &effect) const
-        {
-
-            return effectHandle.mPreprocessor == effect;
-        }
-    };
-
     /**
      * Reset the amount of input frames lost in the audio driver since the last call of
      * getInputFramesLost.
@@ -203,22 +178,13 @@ private:
      *
      * @return 0 if success, negative error code otherwise.
      */
-    android::status_t readFrames(void *buffer, size_t frames, ssize_t *processedFrames);
+    virtual android::status_t readFrames(void *buffer, size_t frames, ssize_t *processedFrames);
 
     /**
      * Free internal buffers allocated for read / processing operations.
      */
     void freeAllocatedBuffers();
 
-    /**
-     * Allocate memory to process a certain amount of frames.
-     *
-     * @param[in] frames number of frame that we may process.
-     *
-     * @return OK if successful allocation, error code otherwise.
-     */
-    android::status_t allocateProcessingMemory(ssize_t frames);
-
     /**
      * Allocate the buffer in which it reads the samples from the audio device.
      *
@@ -226,73 +192,6 @@ private:
      */
     inline android::status_t allocateHwBuffer();
 
-    /**
-     * Process audio frames into the buffer.
-     *
-     * @param[out] buffer memory in which it will copy the processed frames.
-     * @param[in] frames requested frames to read.
-     * @param[out] processedFrames number of frames processed if successful.
-     *
-     * @return 0 if success, negative error code otherwise.
-     */
-    android::status_t processFrames(void *buffer, ssize_t frames, ssize_t *processedFrames);
-
-    /**
-     * Process audio frames into the buffer.
-     *
-     * @param[out] buffer memory in which it will copy the processed frames.
-     * @param[in] frames requested frames to read.
-     * @param[out] processed_frames number of frames processed.
-     * @param[out] processing_frames_in remaining frames to process.
-     *
-     * @return 0 if success, negative error code otherwise.
-     */
-    int doProcessFrames(const void *buffer, ssize_t frames,
-                        ssize_t *processed_frames,
-                        ssize_t *processing_frames_in);
-
-    /**
-     * Read frames from echo reference buffer and update echo delay.
-     *
-     * @param[in] frames to read from echo reference.
-     * @param[in] preprocessor handle on AEC preprocessor.
-     * @param[in] reference echo reference structure.
-     *
-     * @return OK if successful operation, error code otherwise.
-     */
-    android::status_t pushEchoReference(ssize_t frames, effect_handle_t preprocessor,
-                                        struct echo_reference_itfe *reference);
-
-    /**
-     * Update the echo reference with the frames read from the audio device.
-     *
-     * @param[in] frames number of frames ready to process by AEC.
-     * @param[in] reference echo reference handle.
-     *
-     * @return 0 if successful operation, error code otherwise.
-     */
-    int32_t updateEchoReference(ssize_t frames, struct echo_reference_itfe *reference);
-
-    /**
-     * Set preprocessor echo delay.
-     *
-     * @param[out] effect preprocessor handle.
-     * @param[out] delay_us delay of the echo in micro seconds.
-     *
-     * @return OK if successful operation, error code otherwise.
-     */
-    android::status_t setPreprocessorEchoDelay(effect_handle_t effect, int32_t delay_us);
-
-    /**
-     * Set preprocessor parameters.
-     *
-     * @param[out] effect preprocessor handle
-     * @param[out] param parameters to send to the preprocessor.
-     *
-     * @return OK if successful operation, error code otherwise.
-     */
-    android::status_t setPreprocessorParam(effect_handle_t effect, effect_param_t *param);
-
     /**
      * Get the capture delay.
      * It computes the time between the data were read and retrieved and sets the value in the
@@ -300,7 +199,7 @@ private:
      *
      * @param[in,out] buffer echo reference structure.
      */
-    void getCaptureDelay(struct echo_reference_buffer *buffer);
+    virtual void getCaptureDelay(struct echo_reference_buffer *buffer);
 
     /**
      * amount of input frames lost in the audio driver (i.e. not provided on time to client).
@@ -309,42 +208,8 @@ private:
 
     ssize_t mFramesIn; /**< frames available in stream input buffer. */
 
-    /**
-     * This variable represents the number of frames of in mProcessingBuffer.
-     */
-    ssize_t mProcessingFramesIn;
-
-    /**
-     * This variable is a dynamic buffer and contains raw data read from input device.
-     * It is used as input buffer before application of SW accoustics effects.
-     */
-    int16_t *mProcessingBuffer;
-
-    /**
-     * This variable represents the size in frames of in mProcessingBuffer.
-     */
-    ssize_t mProcessingBufferSizeInFrames;
-
-    /**
-     * This variable represents the number of frames of in mReferenceBuffer.
-     */
-    ssize_t mReferenceFramesIn;
-
-    /**
-     * This variable is a dynamic buffer and contains the data used as reference for AEC and
-     * which are read from AudioEffectHandle::mEchoReference.
-     */
-    int16_t *mReferenceBuffer;
-
-    /**
-     * This variable represents the size in frames of in mReferenceBuffer.
-     */
-    ssize_t mReferenceBufferSizeInFrames;
-
-    /**
-     * It is vector which contains the handlers to accoustics SW effects.
-     */
-    std::vector<AudioEffectHandle> mPreprocessorsHandlerList;
+    /** Software effects applied on the frames read, with their buffers. */
+    PreProcessing mPreProcessing;
 
     char *mHwBuffer; /**< buffer in which samples are read from audio device. */
     ssize_t mHwBufferSize; /**< Size of the buffer in which samples are read from audio device. */
@@ -73,7 +73,6 @@ status_t StreamOut::write(const void *buffer, size_t &bytes)
     ssize_t srcFrames = streamSampleSpec().convertBytesToFrames(bytes);
     size_t dstFrames = 0;
     char *dstBuf = NULL;
-    uint32_t retryCount = 0;
 
     pushEchoReference(buffer, srcFrames);
 
@@ -85,7 +84,8 @@ status_t StreamOut::write(const void *buffer, size_t &bytes)
                                                     isOut(),
                                                     streamSampleSpec().getSampleRate(),
                                                     streamSampleSpec().getChannelCount(),
-                                                    "before_conversion");
+                                                    "before_conversion",
+                                                    audio_bytes_per_sample(streamSampleSpec().getFormat()));
     }
 
     status = applyAudioConversion(buffer, (void **)&dstBuf, srcFrames, &dstFrames);
@@ -97,43 +97,27 @@ status_t StreamOut::write(const void *buffer, size_t &bytes)
     Log::Verbose() << __FUNCTION__ << ": srcFrames=" << srcFrames << ", bytes=" << bytes
                    << " dstFrames=" << dstFrames;
 
-    do {
-        std::string error;
+    std::string error;
+    status = pcmWriteFrames(dstBuf, dstFrames, error);
 
-        status = pcmWriteFrames(dstBuf, dstFrames, error);
-
-        if (status < 0) {
-            Log::Error() << __FUNCTION__ << ": write error: " << error
-                         << " - requested " << srcFrames
-                         << " (bytes=" << streamSampleSpec().convertFramesToBytes(srcFrames)
-                         << ") frames";
-
-            if (error.find(strerror(EIO)) != std::string::npos) {
-                // Dump hw registers debug file info in console
-                mParent->printPlatformFwErrorInfo();
-
-            } else if (error.find(strerror(EBADFD)) != std::string::npos) {
-                mStreamLock.unlock();
-                Log::Error() << __FUNCTION__ << ": execute device recovery";
-                setStandby(true);
-                return -EBADFD;
-            }
-
-            AUDIOCOMMS_ASSERT(++retryCount < mMaxReadWriteRetried,
-                              "Hardware not responding, restarting media server");
-
-            // Get the number of microseconds to sleep, inferred from the number of
-            // frames to write.
-            size_t sleepUsecs = routeSampleSpec().convertFramesToUsec(dstFrames);
-
-            // Go sleeping before trying I/O operation again.
-            if (safeSleep(sleepUsecs)) {
-                // If some error arises when trying to sleep, try I/O operation anyway.
-                // Error counter will provoke the restart of mediaserver.
-                Log::Error() << __FUNCTION__ << ":  Error while calling nanosleep interface";
-            }
+    if (error.find(strerror(EIO)) != std::string::npos) {
+        // Dump hw registers debug file info in console
+        mParent->printPlatformFwErrorInfo();
+    }
+    if (status != android::OK) {
+        Log::Error() << __FUNCTION__ << ": write error: " << error
+                     << " - requested " << srcFrames
+                     << " (bytes=" << streamSampleSpec().convertFramesToBytes(srcFrames)
+                     << ") frames";
+
+        if (status == android::DEAD_OBJECT) {
+            mStreamLock.unlock();
+            Log::Error() << __FUNCTION__ << ": execute device recovery";
+            setStandby(true);
+            return -EBADFD;
         }
-    } while (status < 0);
+    }
+    AUDIOCOMMS_ASSERT(status == android::OK, "Hardware not responding, restarting media server");
 
     Log::Verbose() << __FUNCTION__ << ": returns " << streamSampleSpec().convertFramesToBytes(
         AudioUtils::convertSrcToDstInFrames(status, routeSampleSpec(), streamSampleSpec()));
@@ -147,7 +131,8 @@ status_t StreamOut::write(const void *buffer, size_t &bytes)
                                                    isOut(),
                                                    routeSampleSpec().getSampleRate(),
                                                    routeSampleSpec().getChannelCount(),
-                                                   "after_conversion");
+                                                   "after_conversion",
+                                                   audio_bytes_per_sample(routeSampleSpec().getFormat()));
     }
     bytes = streamSampleSpec().convertFramesToBytes(
         AudioUtils::convertSrcToDstInFrames(dstFrames, routeSampleSpec(), streamSampleSpec()));
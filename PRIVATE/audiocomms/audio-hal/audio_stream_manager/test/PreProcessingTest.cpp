@@ -0,0 +1,362 @@
+/*
+ * INTEL CONFIDENTIAL
+ * Copyright (c) 2014 Intel
+ * Corporation All Rights Reserved.
+ *
+ * The source code contained or described herein and all documents related to
+ * the source code ("Material") are owned by Intel Corporation or its suppliers
+ * or licensors. Title to the Material remains with Intel Corporation or its
+ * suppliers and licensors. The Material contains trade secrets and proprietary
+ * and confidential information of Intel or its suppliers and licensors. The
+ * Material is protected by worldwide copyright and trade secret laws and
+ * treaty provisions. No part of the Material may be used, copied, reproduced,
+ * modified, published, uploaded, posted, transmitted, distributed, or
+ * disclosed in any way without Intel's prior express written permission.
+ *
+ * No license under any patent, copyright, trade secret or other intellectual
+ * property right is granted to or conferred upon you by disclosure or delivery
+ * of the Materials, either expressly, by implication, inducement, estoppel or
+ * otherwise. Any license under such intellectual property rights must be
+ * express and approved by Intel in writing.
+ *
+ */
+
+#include "PreProcessing.hpp"
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+using intel_audio::PreProcessing;
+using std::vector;
+
+static const size_t gBlockFrames = 80; /**< Frames processed at once by the effects. */
+
+static uint64_t nowUs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+ * Effects of a session, processing blocks of frames as the webrtc pre-processing: the first
+ * effect of a cycle takes the input frames, the last one gives the processed frames, and
+ * only the first reference given in a cycle is consumed.
+ */
+struct FakeSession
+{
+    FakeSession()
+        : enabledMask(0), processedMask(0), framesIn(0), firstOut(0), framesOut(0),
+          hasReverse(false), reverseFrames(0)
+    {}
+
+    uint32_t enabledMask;
+    uint32_t processedMask;
+    int16_t in[gBlockFrames];
+    size_t framesIn;
+    int16_t out[gBlockFrames];
+    size_t firstOut;
+    size_t framesOut;
+    bool hasReverse;      /**< Reference consumed in this cycle. */
+    size_t reverseFrames; /**< Reference frames consumed by the session. */
+};
+
+class FakeEffect
+{
+public:
+    FakeEffect(FakeSession &session, uint32_t id, bool hasReverse)
+        : mEchoDelayUs(0), mSession(session), mMask(1 << id), mFailure(0)
+    {
+        mInterface.process = process;
+        mInterface.command = command;
+        mInterface.get_descriptor = NULL;
+        mInterface.process_reverse = hasReverse ? processReverse : NULL;
+        mHandle.itfe = &mInterface;
+        mHandle.effect = this;
+        session.enabledMask |= mMask;
+    }
+
+    effect_handle_t getHandle() { return &mHandle.itfe; }
+
+    /** Process fails with this code when not 0. */
+    void setFailure(int failure) { mFailure = failure; }
+
+    vector<const void *> mReverseBuffers; /**< Reference frames given to process_reverse. */
+    uint32_t mEchoDelayUs;
+
+private:
+    struct Handle
+    {
+        struct effect_interface_s *itfe; /**< Handle on the effect points to it. */
+        FakeEffect *effect;
+    };
+
+    static FakeEffect *fromHandle(effect_handle_t self)
+    {
+        return reinterpret_cast<Handle *>(self)->effect;
+    }
+
+    static int32_t process(effect_handle_t self, audio_buffer_t *in, audio_buffer_t *out)
+    {
+        FakeEffect *effect = fromHandle(self);
+        FakeSession &session = effect->mSession;
+        if (effect->mFailure != 0) {
+            return effect->mFailure;
+        }
+        size_t frames = 0;
+        if (session.processedMask == 0) {
+            frames = std::min(in->frameCount, gBlockFrames - session.framesIn);
+            memcpy(session.in + session.framesIn, in->s16, frames * sizeof(int16_t));
+            session.framesIn += frames;
+        }
+        in->frameCount = frames;
+        session.processedMask |= effect->mMask;
+        if (session.processedMask != session.enabledMask) {
+            out->frameCount = 0;
+            return 0;
+        }
+        session.processedMask = 0;
+        session.hasReverse = false;
+        if (session.framesIn == gBlockFrames && session.framesOut == 0) {
+            for (size_t i = 0; i < gBlockFrames; i++) {
+                session.out[i] = -session.in[i];
+            }
+            session.framesIn = 0;
+            session.firstOut = 0;
+            session.framesOut = gBlockFrames;
+        }
+        frames = std::min(out->frameCount, session.framesOut);
+        memcpy(out->s16, session.out + session.firstOut, frames * sizeof(int16_t));
+        session.firstOut += frames;
+        session.framesOut -= frames;
+        out->frameCount = frames;
+        return 0;
+    }
+
+    static int32_t processReverse(effect_handle_t self, audio_buffer_t *in,
+                                  audio_buffer_t * /*out*/)
+    {
+        FakeEffect *effect = fromHandle(self);
+        FakeSession &session = effect->mSession;
+        effect->mReverseBuffers.push_back(in->raw);
+        size_t frames = 0;
+        if (!session.hasReverse) {
+            frames = std::min(in->frameCount, gBlockFrames);
+            session.hasReverse = true;
+        }
+        session.reverseFrames += frames;
+        in->frameCount = frames;
+        return 0;
+    }
+
+    static int32_t command(effect_handle_t self, uint32_t code, uint32_t /*size*/, void *data,
+                           uint32_t * /*replySize*/, void * /*reply*/)
+    {
+        if (code == EFFECT_CMD_SET_PARAM) {
+            const effect_param_t *param = static_cast<const effect_param_t *>(data);
+            fromHandle(self)->mEchoDelayUs = reinterpret_cast<const uint32_t *>(param->data)[1];
+        }
+        return 0;
+    }
+
+    Handle mHandle;
+    struct effect_interface_s mInterface;
+    FakeSession &mSession;
+    uint32_t mMask;
+    int mFailure;
+};
+
+/** Capture and echo reference of ramps of samples. */
+class FakeSource : public PreProcessing::Source
+{
+public:
+    FakeSource() : mNextSample(0), mNextReference(0), mReferenceFrames(0)
+    {
+        mReference.itfe.read = readReference;
+        mReference.itfe.write = NULL;
+        mReference.source = this;
+    }
+
+    virtual android::status_t readFrames(void *buffer, size_t frames, ssize_t *processedFrames)
+    {
+        int16_t *samples = static_cast<int16_t *>(buffer);
+        for (size_t i = 0; i < frames; i++) {
+            samples[i] = mNextSample++;
+        }
+        *processedFrames = frames;
+        return android::OK;
+    }
+
+    virtual void getCaptureDelay(struct echo_reference_buffer *buffer)
+    {
+        buffer->delay_ns = mDelayNs;
+    }
+
+    struct echo_reference_itfe *getReference() { return &mReference.itfe; }
+
+    static const int32_t mDelayNs = 2000000;
+
+    int16_t mNextSample;
+    int16_t mNextReference;
+    size_t mReferenceFrames; /**< Frames read from the echo reference. */
+
+private:
+    struct Reference
+    {
+        struct echo_reference_itfe itfe;
+        FakeSource *source;
+    };
+
+    static int readReference(struct echo_reference_itfe *reference,
+                             struct echo_reference_buffer *buffer)
+    {
+        FakeSource *source = reinterpret_cast<Reference *>(reference)->source;
+        if (buffer == NULL) {
+            return 0;
+        }
+        int16_t *samples = static_cast<int16_t *>(buffer->raw);
+        for (size_t i = 0; i < buffer->frame_count; i++) {
+            samples[i] = source->mNextReference++;
+        }
+        source->mReferenceFrames += buffer->frame_count;
+        return 0;
+    }
+
+    Reference mReference;
+};
+
+class PreProcessingTest : public ::testing::Test
+{
+protected:
+    PreProcessingTest()
+        : mPreProcessing(mSource),
+          mAec(mSession, 0, true),
+          mNs(mSession, 1, false),
+          mAgc(mSession, 2, false),
+          mExpectedSample(0)
+    {}
+
+    virtual void SetUp()
+    {
+        ASSERT_EQ(android::OK, mPreProcessing.plan(sizeof(int16_t), mFramesPerRead));
+        mPreProcessing.addEffect(mAec.getHandle(), mSource.getReference());
+        mPreProcessing.addEffect(mNs.getHandle(), NULL);
+        mPreProcessing.addEffect(mAgc.getHandle(), NULL);
+    }
+
+    /**
+     * Reads and checks processed frames follow the captured ramp.
+     *
+     * @return number of frames processed.
+     */
+    size_t read(size_t frames)
+    {
+        vector<int16_t> buffer(frames);
+        ssize_t processedFrames = -1;
+        EXPECT_EQ(android::OK, mPreProcessing.process(&buffer[0], frames, &processedFrames));
+        EXPECT_LE(processedFrames, static_cast<ssize_t>(frames));
+        for (ssize_t i = 0; i < processedFrames; i++) {
+            EXPECT_EQ(-mExpectedSample, buffer[i]) << "frame " << i;
+            mExpectedSample++;
+        }
+        return processedFrames;
+    }
+
+    static const size_t mFramesPerRead = 160;
+
+    FakeSource mSource;
+    PreProcessing mPreProcessing;
+    FakeSession mSession;
+    FakeEffect mAec;
+    FakeEffect mNs;
+    FakeEffect mAgc;
+    int16_t mExpectedSample;
+};
+
+const size_t PreProcessingTest::mFramesPerRead;
+
+TEST_F(PreProcessingTest, ProcessAllFrames)
+{
+    for (uint32_t i = 0; i < 100; i++) {
+        ASSERT_EQ(mFramesPerRead, read(mFramesPerRead));
+    }
+    EXPECT_EQ(0u, mPreProcessing.getPendingFrames());
+    EXPECT_EQ(100 * mFramesPerRead, mSession.reverseFrames);
+    EXPECT_EQ(static_cast<uint32_t>(FakeSource::mDelayNs / 1000), mAec.mEchoDelayUs);
+}
+
+TEST_F(PreProcessingTest, ReadsNotAlignedOnEffectBlocks)
+{
+    // Frames not consumed are kept for the next read
+    const size_t reads[] = { 100, 60, 300, 20, 160, 50 };
+    for (uint32_t i = 0; i < sizeof(reads) / sizeof(reads[0]); i++) {
+        read(reads[i]);
+        EXPECT_EQ(mSource.mNextSample, static_cast<int16_t>(mExpectedSample + mSession.framesIn +
+                                                            mSession.framesOut +
+                                                            mPreProcessing.getPendingFrames()));
+    }
+    EXPECT_LE(mSession.reverseFrames, mSource.mReferenceFrames);
+}
+
+TEST_F(PreProcessingTest, EchoReferenceSharedWithoutCopy)
+{
+    FakeEffect secondAec(mSession, 3, true);
+    mPreProcessing.addEffect(secondAec.getHandle(), mSource.getReference());
+
+    for (uint32_t i = 0; i < 10; i++) {
+        ASSERT_EQ(mFramesPerRead, read(mFramesPerRead));
+    }
+    // Both effects were given the same frames, which were read once
+    ASSERT_EQ(mAec.mReverseBuffers.size(), secondAec.mReverseBuffers.size());
+    EXPECT_TRUE(mAec.mReverseBuffers == secondAec.mReverseBuffers);
+    EXPECT_EQ(10 * mFramesPerRead, mSource.mReferenceFrames);
+    EXPECT_EQ(10 * mFramesPerRead, mSession.reverseFrames);
+
+    struct echo_reference_itfe *reference = NULL;
+    EXPECT_EQ(android::OK, mPreProcessing.removeEffect(secondAec.getHandle(), reference));
+    EXPECT_EQ(mSource.getReference(), reference);
+    EXPECT_EQ(android::BAD_VALUE, mPreProcessing.removeEffect(secondAec.getHandle(), reference));
+}
+
+TEST_F(PreProcessingTest, RawFramesOnEffectFailure)
+{
+    mAec.setFailure(-EINVAL);
+    vector<int16_t> buffer(mFramesPerRead);
+    ssize_t processedFrames = -1;
+    ASSERT_EQ(android::OK, mPreProcessing.process(&buffer[0], mFramesPerRead, &processedFrames));
+    ASSERT_EQ(static_cast<ssize_t>(mFramesPerRead), processedFrames);
+    // Captured frames are given as is
+    EXPECT_EQ(0, buffer[0]);
+    EXPECT_EQ(static_cast<int16_t>(mFramesPerRead - 1), buffer[mFramesPerRead - 1]);
+    EXPECT_EQ(0u, mPreProcessing.getPendingFrames());
+}
+
+TEST_F(PreProcessingTest, ReadsLargerThanPlanned)
+{
+    EXPECT_EQ(mFramesPerRead, read(mFramesPerRead));
+    EXPECT_EQ(4 * mFramesPerRead, read(4 * mFramesPerRead));
+    EXPECT_EQ(mFramesPerRead, read(mFramesPerRead));
+    EXPECT_EQ(0u, mPreProcessing.getPendingFrames());
+}
+
+TEST_F(PreProcessingTest, Throughput)
+{
+    const uint32_t reads = 20000;
+    vector<int16_t> buffer(mFramesPerRead);
+    ssize_t processedFrames;
+    size_t frames = 0;
+
+    uint64_t start = nowUs();
+    for (uint32_t i = 0; i < reads; i++) {
+        mPreProcessing.process(&buffer[0], mFramesPerRead, &processedFrames);
+        frames += processedFrames;
+    }
+    uint64_t elapsedUs = nowUs() - start;
+
+    EXPECT_EQ(reads * mFramesPerRead, frames);
+    printf("%zu frames processed in %llu us: %.1f frames per us\n", frames,
+           static_cast<unsigned long long>(elapsedUs),
+           elapsedUs ? static_cast<double>(frames) / elapsedUs : 0.);
+}
@@ -27,6 +27,7 @@ LOCAL_PATH := $(call my-dir)
 
 stream_lib_src_files :=  \
     IoStream.cpp \
+    PcmRecovery.cpp \
     TinyAlsaAudioDevice.cpp \
     StreamLib.cpp \
     TinyAlsaIoStream.cpp
@@ -131,6 +132,25 @@ $(call make_stream_lib_test_lib,host)
 LOCAL_MODULE := libstream_static_host
 include $(BUILD_HOST_STATIC_LIBRARY)
 
+# Recovery functional test, on a fake pcm injecting faults
+include $(CLEAR_VARS)
+LOCAL_MODULE := pcm_recovery_fcttest_host
+LOCAL_SRC_FILES := test/PcmRecoveryTest.cpp
+LOCAL_C_INCLUDES := \
+    $(stream_lib_includes_common) \
+    $(call include-path-for, libc-kernel) \
+    external/gtest/include
+LOCAL_CFLAGS := $(stream_lib_cflags)
+LOCAL_STATIC_LIBRARIES := \
+    libstream_static_host \
+    libaudio_comms_utilities_host \
+    liblog \
+    libgtest_host \
+    libgtest_main_host
+LOCAL_LDFLAGS += -pthread
+LOCAL_MODULE_TAGS := tests
+include $(BUILD_HOST_EXECUTABLE)
+
 endif
 
 # Build for target (Inconditionnal)
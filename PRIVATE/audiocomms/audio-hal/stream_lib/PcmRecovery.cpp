@@ -0,0 +1,248 @@
+/*
+ * INTEL CONFIDENTIAL
+ * Copyright (c) 2014 Intel
+ * Corporation All Rights Reserved.
+ *
+ * The source code contained or described herein and all documents related to
+ * the source code ("Material") are owned by Intel Corporation or its suppliers
+ * or licensors. Title to the Material remains with Intel Corporation or its
+ * suppliers and licensors. The Material contains trade secrets and proprietary
+ * and confidential information of Intel or its suppliers and licensors. The
+ * Material is protected by worldwide copyright and trade secret laws and
+ * treaty provisions. No part of the Material may be used, copied, reproduced,
+ * modified, published, uploaded, posted, transmitted, distributed, or
+ * disclosed in any way without Intel's prior express written permission.
+ *
+ * No license under any patent, copyright, trade secret or other intellectual
+ * property right is granted to or conferred upon you by disclosure or delivery
+ * of the Materials, either expressly, by implication, inducement, estoppel or
+ * otherwise. Any license under such intellectual property rights must be
+ * express and approved by Intel in writing.
+ *
+ */
+#define LOG_TAG "PcmRecovery"
+
+#include "PcmRecovery.hpp"
+#include <utilities/Log.hpp>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <sstream>
+
+using audio_comms::utilities::Log;
+using android::status_t;
+using std::string;
+
+namespace intel_audio
+{
+
+PcmRecovery::PcmRecovery()
+{
+    resetStats();
+}
+
+status_t PcmRecovery::transfer(PcmBackend &pcm, void *buffer, size_t frames, uint32_t bufferUs,
+                               string &error)
+{
+    error.clear();
+    int ret = pcm.transfer(buffer, frames, error);
+    if (ret >= 0) {
+        return android::OK;
+    }
+
+    Error firstError = classify(error);
+    Error current = firstError;
+    string retryError;
+    uint64_t startUs = getNowUs();
+    uint64_t deadlineUs = startUs + static_cast<uint64_t>(mMaxRecoveryPeriods) * bufferUs;
+    uint64_t maxBackoffUs = bufferUs > mMinBackoffUs ? bufferUs : mMinBackoffUs;
+    uint64_t backoffUs = mMinBackoffUs;
+    uint64_t lastRetryUs = 0;
+
+    for (;;) {
+        if (current == BadState) {
+            if (firstError != BadState) {
+                Log::Error() << __FUNCTION__ << ": pcm in bad state after "
+                             << getErrorName(firstError);
+            }
+            addFailed(firstError);
+            return android::DEAD_OBJECT;
+        }
+        uint64_t nowUs = getNowUs();
+        if (nowUs >= deadlineUs) {
+            Log::Error() << __FUNCTION__ << ": not recovered from " << getErrorName(firstError)
+                         << " in " << nowUs - startUs << " us, last error: " << retryError;
+            addFailed(firstError);
+            return android::TIMED_OUT;
+        }
+        if (lastRetryUs != 0 && nowUs - lastRetryUs < backoffUs) {
+            uint64_t delayUs = lastRetryUs + backoffUs - nowUs;
+            sleepUs(delayUs < deadlineUs - nowUs ? delayUs : deadlineUs - nowUs);
+            continue;
+        }
+
+        switch (current) {
+        case Xrun:
+            pcm.prepare();
+            break;
+        case Suspended:
+            // Preparing fails until the device is resumed
+            if (pcm.prepare() < 0) {
+                lastRetryUs = getNowUs();
+                backoffUs = backoffUs * 2 < maxBackoffUs ? backoffUs * 2 : maxBackoffUs;
+                continue;
+            }
+            break;
+        default: {
+            uint64_t waitUs = deadlineUs - nowUs < bufferUs ? deadlineUs - nowUs : bufferUs;
+            int waited = pcm.wait((waitUs + mUsecPerMsec - 1) / mUsecPerMsec);
+            if (waited < 0 && classify(-waited) != Other) {
+                // The pcm told why it is not ready
+                current = classify(-waited);
+                continue;
+            }
+            break;
+        }
+        }
+
+        ret = pcm.transfer(buffer, frames, retryError);
+        if (ret >= 0) {
+            uint64_t recoveryUs = getNowUs() - startUs;
+            Log::Warning() << __FUNCTION__ << ": recovered from " << getErrorName(firstError)
+                           << " in " << recoveryUs << " us";
+            addRecovered(firstError, recoveryUs);
+            return android::OK;
+        }
+        current = classify(retryError);
+        if (lastRetryUs != 0) {
+            backoffUs = backoffUs * 2 < maxBackoffUs ? backoffUs * 2 : maxBackoffUs;
+        }
+        lastRetryUs = getNowUs();
+    }
+}
+
+PcmRecovery::Error PcmRecovery::classify(const string &error)
+{
+    // Tiny alsa keeps errno only in the readable error
+    static const int errnums[] = {
+        EPIPE, ESTRPIPE, EBADFD, ENODEV
+    };
+    for (size_t i = 0; i < sizeof(errnums) / sizeof(errnums[0]); i++) {
+        if (error.find(strerror(errnums[i])) != string::npos) {
+            return classify(errnums[i]);
+        }
+    }
+    return Other;
+}
+
+PcmRecovery::Error PcmRecovery::classify(int errnum)
+{
+    switch (errnum) {
+    case EPIPE:
+        return Xrun;
+    case ESTRPIPE:
+        return Suspended;
+    case EBADFD:
+    case ENODEV:
+        return BadState;
+    default:
+        return Other;
+    }
+}
+
+const char *PcmRecovery::getErrorName(Error error)
+{
+    static const char *const names[_nbErrors] = {
+        "xrun", "suspend", "bad state", "other error"
+    };
+    return error < _nbErrors ? names[error] : "unknown error";
+}
+
+PcmRecovery::Stats PcmRecovery::getStats(Error error) const
+{
+    Stats stats;
+    const Stats &source = mStats[error];
+    stats.recovered = __atomic_load_n(&source.recovered, __ATOMIC_RELAXED);
+    stats.failed = __atomic_load_n(&source.failed, __ATOMIC_RELAXED);
+    for (uint32_t bucket = 0; bucket < mHistogramBuckets; bucket++) {
+        stats.histogram[bucket] = __atomic_load_n(&source.histogram[bucket], __ATOMIC_RELAXED);
+    }
+    return stats;
+}
+
+string PcmRecovery::dump() const
+{
+    std::ostringstream out;
+    for (uint32_t error = 0; error < _nbErrors; error++) {
+        Stats stats = getStats(static_cast<Error>(error));
+        if (stats.recovered == 0 && stats.failed == 0) {
+            continue;
+        }
+        out << getErrorName(static_cast<Error>(error)) << ": recovered " << stats.recovered
+            << ", failed " << stats.failed << ", recovery us:";
+        for (uint32_t bucket = 0; bucket < mHistogramBuckets; bucket++) {
+            if (stats.histogram[bucket] == 0) {
+                continue;
+            }
+            out << " [" << (bucket == 0 ? 0 : 1u << bucket) << ",";
+            if (bucket == mHistogramBuckets - 1) {
+                out << "..)";
+            } else {
+                out << (2u << bucket) << ")";
+            }
+            out << "=" << stats.histogram[bucket];
+        }
+        out << "\n";
+    }
+    return out.str();
+}
+
+void PcmRecovery::resetStats()
+{
+    for (uint32_t error = 0; error < _nbErrors; error++) {
+        __atomic_store_n(&mStats[error].recovered, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&mStats[error].failed, 0, __ATOMIC_RELAXED);
+        for (uint32_t bucket = 0; bucket < mHistogramBuckets; bucket++) {
+            __atomic_store_n(&mStats[error].histogram[bucket], 0, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+uint64_t PcmRecovery::getNowUs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+uint32_t PcmRecovery::getBucket(uint64_t recoveryUs)
+{
+    uint32_t bucket = 0;
+    while (recoveryUs > 1 && bucket < mHistogramBuckets - 1) {
+        recoveryUs >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void PcmRecovery::sleepUs(uint64_t us)
+{
+    struct timespec delay;
+    delay.tv_sec = us / 1000000;
+    delay.tv_nsec = (us % 1000000) * 1000;
+    while (nanosleep(&delay, &delay) != 0 && errno == EINTR) {
+    }
+}
+
+void PcmRecovery::addRecovered(Error error, uint64_t recoveryUs)
+{
+    __atomic_add_fetch(&mStats[error].recovered, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&mStats[error].histogram[getBucket(recoveryUs)], 1, __ATOMIC_RELAXED);
+}
+
+void PcmRecovery::addFailed(Error error)
+{
+    __atomic_add_fetch(&mStats[error].failed, 1, __ATOMIC_RELAXED);
+}
+
+} // namespace intel_audio
@@ -34,6 +34,42 @@ using android::OK;
 namespace intel_audio
 {
 
+/**
+ * Transfers of a stream on its tiny alsa pcm device.
+ */
+class TinyAlsaPcm : public PcmBackend
+{
+public:
+    TinyAlsaPcm(pcm *pcmDevice, bool isOut, uint32_t bytes)
+        : mPcmDevice(pcmDevice), mIsOut(isOut), mBytes(bytes)
+    {}
+
+    virtual int transfer(void *buffer, size_t /*frames*/, string &error)
+    {
+        int ret = mIsOut ? pcm_write(mPcmDevice, buffer, mBytes) :
+                  pcm_read(mPcmDevice, buffer, mBytes);
+        if (ret < 0) {
+            error = pcm_get_error(mPcmDevice);
+        }
+        return ret;
+    }
+
+    virtual int wait(int timeoutMs)
+    {
+        return pcm_wait(mPcmDevice, timeoutMs);
+    }
+
+    virtual int prepare()
+    {
+        return pcm_prepare(mPcmDevice);
+    }
+
+private:
+    pcm *mPcmDevice;
+    bool mIsOut;
+    uint32_t mBytes;
+};
+
 pcm *TinyAlsaIoStream::getPcmDevice() const
 {
     AUDIOCOMMS_ASSERT(mDevice != NULL, "Null audio device attached to stream");
@@ -56,34 +92,18 @@ android::status_t TinyAlsaIoStream::detachRouteL()
 
 status_t TinyAlsaIoStream::pcmReadFrames(void *buffer, size_t frames, string &error) const
 {
-    status_t ret;
+    TinyAlsaPcm pcm(getPcmDevice(), false, routeSampleSpec().convertFramesToBytes(frames));
 
-    ret = pcm_read(getPcmDevice(),
-                   (char *)buffer,
-                   routeSampleSpec().convertFramesToBytes(frames));
-
-    if (ret < 0) {
-        error = pcm_get_error(getPcmDevice());
-        return ret;
-    }
-
-    return OK;
+    return mRecovery.transfer(pcm, buffer, frames,
+                              routeSampleSpec().convertFramesToUsec(frames), error);
 }
 
 status_t TinyAlsaIoStream::pcmWriteFrames(void *buffer, ssize_t frames, string &error) const
 {
-    status_t ret;
+    TinyAlsaPcm pcm(getPcmDevice(), true, pcm_frames_to_bytes(getPcmDevice(), frames));
 
-    ret = pcm_write(getPcmDevice(),
-                    (char *)buffer,
-                    pcm_frames_to_bytes(getPcmDevice(), frames));
-
-    if (ret < 0) {
-        error = pcm_get_error(getPcmDevice());
-        return ret;
-    }
-
-    return OK;
+    return mRecovery.transfer(pcm, buffer, frames,
+                              routeSampleSpec().convertFramesToUsec(frames), error);
 }
 
 uint32_t TinyAlsaIoStream::getBufferSizeInBytes() const
@@ -0,0 +1,180 @@
+/*
+ * INTEL CONFIDENTIAL
+ * Copyright (c) 2014 Intel
+ * Corporation All Rights Reserved.
+ *
+ * The source code contained or described herein and all documents related to
+ * the source code ("Material") are owned by Intel Corporation or its suppliers
+ * or licensors. Title to the Material remains with Intel Corporation or its
+ * suppliers and licensors. The Material contains trade secrets and proprietary
+ * and confidential information of Intel or its suppliers and licensors. The
+ * Material is protected by worldwide copyright and trade secret laws and
+ * treaty provisions. No part of the Material may be used, copied, reproduced,
+ * modified, published, uploaded, posted, transmitted, distributed, or
+ * disclosed in any way without Intel's prior express written permission.
+ *
+ * No license under any patent, copyright, trade secret or other intellectual
+ * property right is granted to or conferred upon you by disclosure or delivery
+ * of the Materials, either expressly, by implication, inducement, estoppel or
+ * otherwise. Any license under such intellectual property rights must be
+ * express and approved by Intel in writing.
+ *
+ */
+#pragma once
+
+#include <utils/Errors.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <string>
+
+namespace intel_audio
+{
+
+/**
+ * Pcm operations needed to recover from a failed transfer.
+ * Implemented on a tiny alsa pcm device by the stream, or by tests to inject faults.
+ */
+class PcmBackend
+{
+public:
+    virtual ~PcmBackend() {}
+
+    /**
+     * Read frames from a capture pcm or write frames to a playback pcm.
+     *
+     * @param[in,out] buffer: samples to write or to fill.
+     * @param[in] frames: number of frames to transfer.
+     * @param[out] error: readable error, set on failure.
+     *
+     * @return 0 on success, negative value on failure.
+     */
+    virtual int transfer(void *buffer, size_t frames, std::string &error) = 0;
+
+    /**
+     * Wait for the pcm to be ready for a transfer (as pcm_wait).
+     *
+     * @param[in] timeoutMs: maximum time to wait, in milliseconds.
+     *
+     * @return 1 if ready, 0 on timeout, negated errno on failure (-EPIPE on xrun,
+     *         -ESTRPIPE if suspended, -ENODEV if disconnected).
+     */
+    virtual int wait(int timeoutMs) = 0;
+
+    /**
+     * Prepare the pcm again after an xrun or a suspend.
+     *
+     * @return 0 on success, negative value on failure.
+     */
+    virtual int prepare() = 0;
+};
+
+/**
+ * Recovery of a pcm transfer failure.
+ *
+ * When a transfer fails, the error is classified. An xrun is recovered by preparing the
+ * pcm again, a suspend by preparing it once resumed, and other errors by waiting for
+ * the pcm to be ready. The transfer is then retried at once, so the recovery time is no
+ * longer a multiple of the buffer duration. Retries are spaced by a backoff growing up
+ * to the buffer duration, so a pcm that fails at once does not spin. The recovery gives
+ * up on a bad state pcm, or after mMaxRecoveryPeriods buffer durations.
+ *
+ * The recovery times are kept in histograms per error class, with buckets of powers
+ * of two microseconds.
+ */
+class PcmRecovery
+{
+public:
+    enum Error
+    {
+        Xrun = 0,  /**< EPIPE: the ring buffer overran or underran. */
+        Suspended, /**< ESTRPIPE: the device was suspended. */
+        BadState,  /**< EBADFD or ENODEV: the pcm cannot be used any more. */
+        Other      /**< Others, mainly EIO when the device did not progress. */
+    };
+
+    static const uint32_t _nbErrors = 4;
+
+    static const uint32_t mHistogramBuckets = 16;
+
+    struct Stats
+    {
+        uint32_t recovered; /**< Transfers which succeeded after the error. */
+        uint32_t failed;    /**< Transfers given up. */
+        /**
+         * Recovery times: bucket 0 below 2 us, bucket n from 2^n to 2^(n+1) us,
+         * the last bucket above 2^(mHistogramBuckets - 1) us.
+         */
+        uint32_t histogram[mHistogramBuckets];
+    };
+
+    PcmRecovery();
+
+    /**
+     * Transfer frames, recovering from failures.
+     *
+     * @param[in] pcm: pcm to transfer with.
+     * @param[in,out] buffer: samples to write or to fill.
+     * @param[in] frames: number of frames to transfer.
+     * @param[in] bufferUs: duration of the frames, in microseconds.
+     * @param[out] error: readable error of the first failure, even if recovered from,
+     *                    empty if the transfer succeeded at once.
+     *
+     * @return OK if the transfer succeeded, possibly after a recovery,
+     *         DEAD_OBJECT if the pcm is in bad state,
+     *         TIMED_OUT if not recovered within mMaxRecoveryPeriods buffer durations.
+     */
+    android::status_t transfer(PcmBackend &pcm, void *buffer, size_t frames, uint32_t bufferUs,
+                               std::string &error);
+
+    /**
+     * @param[in] error: readable error of a failed transfer (as pcm_get_error).
+     *
+     * @return class of the error.
+     */
+    static Error classify(const std::string &error);
+
+    /**
+     * @param[in] errnum: errno value.
+     *
+     * @return class of the error.
+     */
+    static Error classify(int errnum);
+
+    static const char *getErrorName(Error error);
+
+    /**
+     * Get a copy of the statistics of an error class.
+     * May be called from another thread than the transferring one.
+     */
+    Stats getStats(Error error) const;
+
+    /**
+     * @return readable statistics, one line per error class that occurred.
+     */
+    std::string dump() const;
+
+    void resetStats();
+
+private:
+    static uint64_t getNowUs();
+
+    static uint32_t getBucket(uint64_t recoveryUs);
+
+    static void sleepUs(uint64_t us);
+
+    void addRecovered(Error error, uint64_t recoveryUs);
+
+    void addFailed(Error error);
+
+    Stats mStats[_nbErrors];
+
+    /** Recovery deadline, in buffer durations, as the former count of retries. */
+    static const uint32_t mMaxRecoveryPeriods = 50;
+
+    /** First backoff between two failed retries, in microseconds. */
+    static const uint32_t mMinBackoffUs = 1000;
+
+    static const uint32_t mUsecPerMsec = 1000;
+};
+
+} // namespace intel_audio
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "IoStream.hpp"
+#include "PcmRecovery.hpp"
 #include <SampleSpec.hpp>
 #include <utils/RWLock.h>
 
@@ -42,8 +43,22 @@ public:
 
     virtual size_t getBufferSizeInFrames() const;
 
+    /**
+     * Read frames, recovering from xrun, suspend and device errors.
+     * The error is set if a failure occurred, even if recovered from.
+     *
+     * @return OK if read, DEAD_OBJECT if the pcm is in bad state,
+     *         TIMED_OUT if the device did not recover.
+     */
     virtual android::status_t pcmReadFrames(void *buffer, size_t frames, std::string &error) const;
 
+    /**
+     * Write frames, recovering from xrun, suspend and device errors.
+     * The error is set if a failure occurred, even if recovered from.
+     *
+     * @return OK if written, DEAD_OBJECT if the pcm is in bad state,
+     *         TIMED_OUT if the device did not recover.
+     */
     virtual android::status_t pcmWriteFrames(void *buffer, ssize_t frames,
                                              std::string &error) const;
 
@@ -58,6 +73,14 @@ public:
      */
     virtual android::status_t getFramesAvailable(uint32_t &avail, struct timespec &tStamp) const;
 
+    /**
+     * @return readable recovery statistics of the pcm transfers of this stream.
+     */
+    std::string dumpRecoveryStats() const
+    {
+        return mRecovery.dump();
+    }
+
 protected:
     /**
      * Attach the stream to its route.
@@ -88,6 +111,9 @@ private:
 
     TinyAlsaAudioDevice *mDevice;
 
+    /** Recovery of the transfers, with its statistics. */
+    mutable PcmRecovery mRecovery;
+
     /** Ratio between microseconds and milliseconds */
     static const uint32_t mUsecPerMsec = 1000;
 };
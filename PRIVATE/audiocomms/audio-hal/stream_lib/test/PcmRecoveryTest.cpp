@@ -0,0 +1,314 @@
+/*
+ * INTEL CONFIDENTIAL
+ * Copyright (c) 2014 Intel
+ * Corporation All Rights Reserved.
+ *
+ * The source code contained or described herein and all documents related to
+ * the source code ("Material") are owned by Intel Corporation or its suppliers
+ * or licensors. Title to the Material remains with Intel Corporation or its
+ * suppliers and licensors. The Material contains trade secrets and proprietary
+ * and confidential information of Intel or its suppliers and licensors. The
+ * Material is protected by worldwide copyright and trade secret laws and
+ * treaty provisions. No part of the Material may be used, copied, reproduced,
+ * modified, published, uploaded, posted, transmitted, distributed, or
+ * disclosed in any way without Intel's prior express written permission.
+ *
+ * No license under any patent, copyright, trade secret or other intellectual
+ * property right is granted to or conferred upon you by disclosure or delivery
+ * of the Materials, either expressly, by implication, inducement, estoppel or
+ * otherwise. Any license under such intellectual property rights must be
+ * express and approved by Intel in writing.
+ *
+ */
+
+#include <PcmRecovery.hpp>
+#include <gtest/gtest.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+using intel_audio::PcmBackend;
+using intel_audio::PcmRecovery;
+using std::string;
+
+static uint64_t nowUs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+ * Pcm whose faults are injected by the test, behaving as the tiny alsa pcm of the state.
+ */
+class FakePcm : public PcmBackend
+{
+public:
+    enum State
+    {
+        Running,
+        Xrun,      /**< Fails with EPIPE until prepared. */
+        Suspended, /**< Fails with ESTRPIPE, cannot be prepared until resumed. */
+        Stalled,   /**< Fails with EIO until ready, waiting blocks until then. */
+        Broken,    /**< Fails with EIO, but always tells it is ready. */
+        Bad        /**< Fails with EBADFD. */
+    };
+
+    FakePcm()
+        : mState(Running), mUntilUs(0), mTransfers(0), mWaits(0), mPrepares(0)
+    {}
+
+    /** Injects a fault, lasting durationUs for suspend and stall. */
+    void inject(State state, uint64_t durationUs = 0)
+    {
+        mState = state;
+        mUntilUs = nowUs() + durationUs;
+    }
+
+    virtual int transfer(void * /*buffer*/, size_t /*frames*/, string &error)
+    {
+        mTransfers++;
+        int errnum = 0;
+        switch (mState) {
+        case Running:
+            return 0;
+        case Xrun:
+            errnum = EPIPE;
+            break;
+        case Suspended:
+            errnum = ESTRPIPE;
+            break;
+        case Stalled:
+            if (nowUs() >= mUntilUs) {
+                mState = Running;
+                return 0;
+            }
+            errnum = EIO;
+            break;
+        case Broken:
+            errnum = EIO;
+            break;
+        case Bad:
+            errnum = EBADFD;
+            break;
+        }
+        error = string("cannot read stream data: ") + strerror(errnum);
+        return -1;
+    }
+
+    virtual int wait(int timeoutMs)
+    {
+        mWaits++;
+        switch (mState) {
+        case Xrun:
+            return -EPIPE;
+        case Suspended:
+            return -ESTRPIPE;
+        case Bad:
+            return -ENODEV;
+        case Stalled: {
+            uint64_t now = nowUs();
+            uint64_t timeoutUs = static_cast<uint64_t>(timeoutMs) * 1000;
+            if (now + timeoutUs < mUntilUs) {
+                usleep(timeoutUs);
+                return 0;
+            }
+            if (now < mUntilUs) {
+                usleep(mUntilUs - now);
+            }
+            return 1;
+        }
+        default:
+            return 1;
+        }
+    }
+
+    virtual int prepare()
+    {
+        mPrepares++;
+        switch (mState) {
+        case Xrun:
+            mState = Running;
+            return 0;
+        case Suspended:
+            if (nowUs() < mUntilUs) {
+                return -1;
+            }
+            mState = Running;
+            return 0;
+        case Bad:
+            return -1;
+        default:
+            return 0;
+        }
+    }
+
+    State mState;
+    uint64_t mUntilUs;
+    uint32_t mTransfers;
+    uint32_t mWaits;
+    uint32_t mPrepares;
+};
+
+class PcmRecoveryTest : public ::testing::Test
+{
+protected:
+    /** Transfers a buffer, 20 ms by default, returns the time taken in microseconds. */
+    uint64_t transfer(android::status_t expected, uint32_t bufferUs = mBufferUs)
+    {
+        char buffer[64];
+        uint64_t start = nowUs();
+        EXPECT_EQ(expected, mRecovery.transfer(mPcm, buffer, 16, bufferUs, mError));
+        return nowUs() - start;
+    }
+
+    uint32_t getRecoveredBelow(PcmRecovery::Error error, uint64_t us)
+    {
+        PcmRecovery::Stats stats = mRecovery.getStats(error);
+        uint32_t count = 0;
+        for (uint32_t bucket = 0; bucket < PcmRecovery::mHistogramBuckets; bucket++) {
+            if ((2ull << bucket) <= us) {
+                count += stats.histogram[bucket];
+            }
+        }
+        return count;
+    }
+
+    static const uint32_t mBufferUs = 20000;
+
+    FakePcm mPcm;
+    PcmRecovery mRecovery;
+    string mError;
+};
+
+TEST_F(PcmRecoveryTest, NoFailure)
+{
+    transfer(android::OK);
+    EXPECT_TRUE(mError.empty());
+    EXPECT_EQ(1u, mPcm.mTransfers);
+    EXPECT_EQ(0u, mPcm.mWaits);
+    EXPECT_TRUE(mRecovery.dump().empty());
+}
+
+TEST_F(PcmRecoveryTest, XrunRecoveredAtOnce)
+{
+    mPcm.inject(FakePcm::Xrun);
+    uint64_t elapsedUs = transfer(android::OK);
+
+    EXPECT_NE(string::npos, mError.find(strerror(EPIPE)));
+    EXPECT_EQ(2u, mPcm.mTransfers);
+    EXPECT_EQ(1u, mPcm.mPrepares);
+    EXPECT_LT(elapsedUs, 1000u);
+    EXPECT_EQ(1u, mRecovery.getStats(PcmRecovery::Xrun).recovered);
+    EXPECT_EQ(1u, getRecoveredBelow(PcmRecovery::Xrun, 1024));
+}
+
+TEST_F(PcmRecoveryTest, StallRecoveredWhenReady)
+{
+    // The former retry slept a whole buffer duration
+    mPcm.inject(FakePcm::Stalled, 3000);
+    uint64_t elapsedUs = transfer(android::OK);
+
+    EXPECT_NE(string::npos, mError.find(strerror(EIO)));
+    EXPECT_GE(elapsedUs, 3000u);
+    EXPECT_LT(elapsedUs, 10000u);
+    EXPECT_EQ(1u, mPcm.mWaits);
+    EXPECT_EQ(1u, mRecovery.getStats(PcmRecovery::Other).recovered);
+    EXPECT_EQ(1u, getRecoveredBelow(PcmRecovery::Other, 16384));
+}
+
+TEST_F(PcmRecoveryTest, StallLongerThanBuffer)
+{
+    mPcm.inject(FakePcm::Stalled, 25000);
+    uint64_t elapsedUs = transfer(android::OK);
+
+    EXPECT_GE(elapsedUs, 25000u);
+    EXPECT_LT(elapsedUs, 35000u);
+    EXPECT_EQ(2u, mPcm.mWaits);
+}
+
+TEST_F(PcmRecoveryTest, SuspendRecoveredOnResume)
+{
+    mPcm.inject(FakePcm::Suspended, 5000);
+    uint64_t elapsedUs = transfer(android::OK);
+
+    EXPECT_NE(string::npos, mError.find(strerror(ESTRPIPE)));
+    EXPECT_GE(elapsedUs, 5000u);
+    EXPECT_LT(elapsedUs, 15000u);
+    // Preparing is retried with a backoff, not in a loop
+    EXPECT_LE(mPcm.mPrepares, 5u);
+    EXPECT_EQ(1u, mRecovery.getStats(PcmRecovery::Suspended).recovered);
+}
+
+TEST_F(PcmRecoveryTest, BadStateGivesUpAtOnce)
+{
+    mPcm.inject(FakePcm::Bad);
+    transfer(android::DEAD_OBJECT);
+
+    EXPECT_NE(string::npos, mError.find(strerror(EBADFD)));
+    EXPECT_EQ(1u, mPcm.mTransfers);
+    EXPECT_EQ(0u, mPcm.mWaits);
+    EXPECT_EQ(1u, mRecovery.getStats(PcmRecovery::BadState).failed);
+}
+
+TEST_F(PcmRecoveryTest, DisconnectedWhileStalled)
+{
+    // Fails with EIO, then tells on wait it is disconnected
+    class DisconnectingPcm : public FakePcm
+    {
+        virtual int wait(int /*timeoutMs*/)
+        {
+            mWaits++;
+            return -ENODEV;
+        }
+    } pcm;
+    char buffer[64];
+
+    pcm.inject(FakePcm::Broken);
+    EXPECT_EQ(android::DEAD_OBJECT, mRecovery.transfer(pcm, buffer, 16, mBufferUs, mError));
+    EXPECT_EQ(1u, pcm.mTransfers);
+    EXPECT_EQ(1u, mRecovery.getStats(PcmRecovery::Other).failed);
+}
+
+TEST_F(PcmRecoveryTest, DeadlineOnBrokenDevice)
+{
+    const uint32_t bufferUs = 1000;
+    mPcm.inject(FakePcm::Broken);
+    uint64_t elapsedUs = transfer(android::TIMED_OUT, bufferUs);
+
+    // Given up after 50 buffer durations, without spinning on the failing transfer
+    EXPECT_GE(elapsedUs, 50u * bufferUs);
+    EXPECT_LT(elapsedUs, 100u * bufferUs);
+    EXPECT_LE(mPcm.mTransfers, 52u);
+    EXPECT_EQ(1u, mRecovery.getStats(PcmRecovery::Other).failed);
+}
+
+TEST_F(PcmRecoveryTest, Classify)
+{
+    EXPECT_EQ(PcmRecovery::Xrun, PcmRecovery::classify(string("cannot read stream data: ") +
+                                                       strerror(EPIPE)));
+    EXPECT_EQ(PcmRecovery::Suspended, PcmRecovery::classify(strerror(ESTRPIPE)));
+    EXPECT_EQ(PcmRecovery::BadState, PcmRecovery::classify(strerror(EBADFD)));
+    EXPECT_EQ(PcmRecovery::BadState, PcmRecovery::classify(ENODEV));
+    EXPECT_EQ(PcmRecovery::Other, PcmRecovery::classify(strerror(EIO)));
+    EXPECT_EQ(PcmRecovery::Other, PcmRecovery::classify(string()));
+}
+
+TEST_F(PcmRecoveryTest, Dump)
+{
+    mPcm.inject(FakePcm::Xrun);
+    transfer(android::OK);
+    mPcm.inject(FakePcm::Xrun);
+    transfer(android::OK);
+    mPcm.inject(FakePcm::Bad);
+    transfer(android::DEAD_OBJECT);
+
+    string dump = mRecovery.dump();
+    EXPECT_NE(string::npos, dump.find("xrun: recovered 2, failed 0, recovery us: ["));
+    EXPECT_NE(string::npos, dump.find("bad state: recovered 0, failed 1"));
+    EXPECT_EQ(string::npos, dump.find("suspend"));
+
+    mRecovery.resetStats();
+    EXPECT_TRUE(mRecovery.dump().empty());
+}
@@ -69,7 +69,9 @@ include $(BUILD_HOST_STATIC_LIBRARY)
 
 include $(CLEAR_VARS)
 
-LOCAL_SRC_FILES += test/KeyValuePairsTest.cpp \
+LOCAL_SRC_FILES += \
+    test/KeyValuePairsTest.cpp \
+    test/KeyValuePairsBenchmark.cpp \
 
 LOCAL_C_INCLUDES := \
 
@@ -25,24 +25,25 @@
 
 #include <convert.hpp>
 #include <string>
-#include <map>
+#include <vector>
 #include <utils/Errors.h>
+#include <sys/types.h>
 
 namespace intel_audio
 {
 
 /**
  * Helper class to parse / retrieve a semi-colon separated string of {key, value} pairs.
+ *
+ * Keys and values are stored back to back in a single arena string, and the pairs are kept
+ * as a vector of offsets in this arena, sorted by key. Parsing a string of pairs does not
+ * create any intermediate string, integral and boolean values are read from and written to
+ * the arena without going through a string.
  */
 class KeyValuePairs
 {
-private:
-    typedef std::map<std::string, std::string> Map;
-    typedef Map::iterator MapIterator;
-    typedef Map::const_iterator MapConstIterator;
-
 public:
-    KeyValuePairs() {}
+    KeyValuePairs() : mGarbage(0) {}
     KeyValuePairs(const std::string &keyValuePairs);
     virtual ~KeyValuePairs();
 
@@ -51,7 +52,7 @@ public:
      *
      * @return semi-colon separated string of {key, value} pairs
      */
-    std::string toString();
+    std::string toString() const;
 
     /**
      * Add all pairs contained in a semi-colon separated string of {key, value} to the collection.
@@ -80,11 +81,26 @@ public:
     template <typename T>
     android::status_t add(const std::string &key, const T &value)
     {
-        std::string literal;
-        if (!audio_comms::utilities::convertTo(value, literal)) {
+        char literal[mMaxLiteralSize];
+        ssize_t length = format(value, literal);
+        if (length < 0) {
             return android::BAD_VALUE;
         }
-        return addLiteral(key, literal);
+        return addLiteral(key.data(), key.size(), literal, length);
+    }
+
+    /**
+     * Add a new value pair to the collection, the value being a literal.
+     *
+     * @param[in] key to add.
+     * @param[in] value to add.
+     *
+     * @return OK if the key was added with its corresponding value.
+     * @return ALREADY_EXISTS if the key was already added, the value is updated however.
+     */
+    android::status_t add(const std::string &key, const std::string &value)
+    {
+        return addLiteral(key.data(), key.size(), value.data(), value.size());
     }
 
     /**
@@ -110,12 +126,12 @@ public:
     template <typename T>
     android::status_t get(const std::string &key, T &value) const
     {
-        std::string literalValue;
-        android::status_t status = getLiteral(key, literalValue);
-        if (status != android::OK) {
-            return status;
+        size_t index;
+        if (!find(key.data(), key.size(), index)) {
+            return android::BAD_VALUE;
         }
-        if (!audio_comms::utilities::convertTo(literalValue, value)) {
+        const Pair &pair = mPairs[index];
+        if (!parse(mArena.data() + pair.valueOffset, pair.valueLength, value)) {
             return android::BAD_VALUE;
         }
         return android::OK;
@@ -124,38 +140,106 @@ public:
     /**
      * @return the number of {key, value} pairs found in the collection.
      */
-    size_t size()
+    size_t size() const
     {
-        return mMap.size();
+        return mPairs.size();
     }
 
 private:
+    /** {key, value} pair, as offsets in the arena. */
+    struct Pair
+    {
+        uint32_t keyOffset;
+        uint32_t keyLength;
+        uint32_t valueOffset;
+        uint32_t valueLength;
+    };
+
     /**
      * Add a new value pair to the collection.
      *
      * @param[in] key to add.
+     * @param[in] keyLength length of the key.
      * @param[in] value to add (as literal).
+     * @param[in] valueLength length of the value.
      *
      * @return OK if the key was added with its corresponding value.
-     * @return error code otherwise.
+     * @return ALREADY_EXISTS if the key was already added, the value is updated however.
      */
-    android::status_t addLiteral(const std::string &key, const std::string &value);
+    android::status_t addLiteral(const char *key, size_t keyLength,
+                                 const char *value, size_t valueLength);
 
     /**
-     * Get a literal value from a given key from the collection.
+     * Find a key in the collection.
      *
-     * @param[in] key associated to the value to get.
-     * @param[out] value to get.
+     * @param[in] key to find.
+     * @param[in] keyLength length of the key.
+     * @param[out] index of the pair if found, of the pair to insert before otherwise.
      *
-     * @return OK if the key was found and the value is returned into value parameter.
-     * @return error code otherwise.
+     * @return true if the key was found, false otherwise.
+     */
+    bool find(const char *key, size_t keyLength, size_t &index) const;
+
+    /** Copies the pairs in a new arena, dropping the literals no more referenced. */
+    void compact();
+
+    /**
+     * Parse a literal value.
+     * Integral and boolean types are read in place, with the rules of convertTo, other types
+     * are converted from a string.
+     *
+     * @return true if the whole literal was parsed, false otherwise.
      */
-    android::status_t getLiteral(const std::string &key, std::string &value) const;
+    static bool parse(const char *literal, size_t length, std::string &value);
+    static bool parse(const char *literal, size_t length, bool &value);
+    static bool parse(const char *literal, size_t length, uint64_t &value);
+    static bool parse(const char *literal, size_t length, int64_t &value);
+    static bool parse(const char *literal, size_t length, uint32_t &value);
+    static bool parse(const char *literal, size_t length, int32_t &value);
+    static bool parse(const char *literal, size_t length, uint16_t &value);
+    static bool parse(const char *literal, size_t length, int16_t &value);
+
+    template <typename T>
+    static bool parse(const char *literal, size_t length, T &value)
+    {
+        return audio_comms::utilities::convertTo(std::string(literal, length), value);
+    }
+
+    static const size_t mMaxLiteralSize = 32; /**< Longest formatted number, sign included. */
+
+    /**
+     * Format a value as a literal.
+     * Integral and boolean types are written in place, other types are converted to a string.
+     *
+     * @return length of the literal, negative value on failure.
+     */
+    static ssize_t format(bool value, char (&literal)[mMaxLiteralSize]);
+    static ssize_t format(uint64_t value, char (&literal)[mMaxLiteralSize]);
+    static ssize_t format(int64_t value, char (&literal)[mMaxLiteralSize]);
+    static ssize_t format(uint32_t value, char (&literal)[mMaxLiteralSize]);
+    static ssize_t format(int32_t value, char (&literal)[mMaxLiteralSize]);
+
+    template <typename T>
+    static ssize_t format(const T &value, char (&literal)[mMaxLiteralSize])
+    {
+        std::string converted;
+        if (!audio_comms::utilities::convertTo(value, converted) ||
+            converted.size() > mMaxLiteralSize) {
+            return -1;
+        }
+        converted.copy(literal, converted.size());
+        return converted.size();
+    }
+
+    std::string mArena; /**< Keys and values, back to back. */
+    std::vector<Pair> mPairs; /**< value pair collection sorted by key. */
+    size_t mGarbage; /**< Bytes of the arena no more referenced by any pair. */
 
-    std::map<std::string, std::string> mMap; /**< value pair collection Map indexed by the key. */
+    static const char mPairDelimiter = ';'; /**< Delimiter between {key, value} pairs. */
+    static const char mPairAssociator = '='; /**< key value Pair token. */
 
-    static const char *const mPairDelimiter; /**< Delimiter between {key, value} pairs. */
-    static const char *const mPairAssociator; /**< key value Pair token. */
+    /** Arena is compacted when more than half of it, and at least this size, is garbage. */
+    static const size_t mMinGarbageToCompact = 256;
 };
 
 }   // namespace intel_audio
@@ -24,107 +24,310 @@
 #define LOG_TAG "KeyValuePairs"
 
 #include "KeyValuePairs.hpp"
-#include <AudioCommsAssert.hpp>
+#include <limits>
+#include <stdio.h>
 #include <string.h>
-#include <stdlib.h>
 
-using namespace audio_comms::utilities;
 using namespace std;
 
 namespace intel_audio
 {
 
-const char *const KeyValuePairs::mPairDelimiter = ";";
-const char *const KeyValuePairs::mPairAssociator = "=";
+/**
+ * Parse an integer literal with the rules of convertTo: no white space, no sign for unsigned
+ * types, hexadecimal when starting with 0x, and the whole literal must fit in the type.
+ */
+template <typename T>
+static bool parseInteger(const char *literal, size_t length, T &value)
+{
+    if (!numeric_limits<T>::is_signed && memchr(literal, '-', length) != NULL) {
+        return false;
+    }
+    const char *end = literal + length;
+    uint32_t base = 10;
+    bool isNegative = false;
+    if (length >= 2 && literal[0] == '0' && literal[1] == 'x') {
+        base = 16;
+        literal += 2;
+    } else if (length >= 1 && (literal[0] == '-' || literal[0] == '+')) {
+        isNegative = literal[0] == '-';
+        literal++;
+    }
+    if (literal == end) {
+        return false;
+    }
+    uint64_t limit = static_cast<uint64_t>(numeric_limits<T>::max()) + (isNegative ? 1 : 0);
+    uint64_t magnitude = 0;
+    for (; literal != end; ++literal) {
+        uint32_t digit;
+        if (*literal >= '0' && *literal <= '9') {
+            digit = *literal - '0';
+        } else if (*literal >= 'a' && *literal <= 'f') {
+            digit = *literal - 'a' + 10;
+        } else if (*literal >= 'A' && *literal <= 'F') {
+            digit = *literal - 'A' + 10;
+        } else {
+            return false;
+        }
+        if (digit >= base || magnitude > (limit - digit) / base) {
+            return false;
+        }
+        magnitude = magnitude * base + digit;
+    }
+    value = static_cast<T>(isNegative ? 0 - magnitude : magnitude);
+    return true;
+}
+
+static bool isLiteral(const char *literal, size_t length, const char *expected)
+{
+    return length == strlen(expected) && memcmp(literal, expected, length) == 0;
+}
 
 KeyValuePairs::KeyValuePairs(const string &pairs)
+    : mGarbage(0)
 {
     add(pairs);
 }
 
 KeyValuePairs::~KeyValuePairs()
 {
-    mMap.clear();
 }
 
-string KeyValuePairs::toString()
+string KeyValuePairs::toString() const
 {
+    if (mPairs.empty()) {
+        return string();
+    }
+    size_t length = mPairs.size() * 2 - 1; // Associators and delimiters
+    vector<Pair>::const_iterator it;
+    for (it = mPairs.begin(); it != mPairs.end(); ++it) {
+        length += it->keyLength + it->valueLength;
+    }
     string keyValueList;
-    MapConstIterator it;
-    for (it = mMap.begin(); it != mMap.end(); ++it) {
-        keyValueList += it->first + mPairAssociator + it->second;
-        if (it->first != mMap.rbegin()->first) {
+    keyValueList.reserve(length);
+    const char *arena = mArena.data();
+    for (it = mPairs.begin(); it != mPairs.end(); ++it) {
+        if (it != mPairs.begin()) {
             keyValueList += mPairDelimiter;
         }
+        keyValueList.append(arena + it->keyOffset, it->keyLength);
+        keyValueList += mPairAssociator;
+        keyValueList.append(arena + it->valueOffset, it->valueLength);
     }
     return keyValueList;
 }
 
 android::status_t KeyValuePairs::remove(const string &key)
 {
-    if (mMap.find(key) == mMap.end()) {
+    size_t index;
+    if (!find(key.data(), key.size(), index)) {
         return android::BAD_VALUE;
     }
-    mMap.erase(key);
+    mGarbage += mPairs[index].keyLength + mPairs[index].valueLength;
+    mPairs.erase(mPairs.begin() + index);
+    if (mPairs.empty()) {
+        mArena.clear();
+        mGarbage = 0;
+    }
     return android::OK;
 }
 
 android::status_t KeyValuePairs::add(const string &keyValuePairs)
 {
     android::status_t status = android::OK;
-    char *pairs = strdup(keyValuePairs.c_str());
-    char *context;
-    char *pair = strtok_r(pairs, mPairDelimiter, &context);
-    while (pair != NULL) {
-        if (strlen(pair) != 0) {
-            string key;
-            string value;
+    // Parsed pairs take at most the size of the string in the arena
+    mArena.reserve(mArena.size() + keyValuePairs.size());
+
+    const char *pair = keyValuePairs.data();
+    const char *end = pair + keyValuePairs.size();
+    while (pair < end) {
+        const char *pairEnd = static_cast<const char *>(memchr(pair, mPairDelimiter, end - pair));
+        if (pairEnd == NULL) {
+            pairEnd = end;
+        }
+        if (pairEnd != pair) {
             // An audio parameter can be constructed with key;key or key=value;key=value
-            if (strchr(pair, *mPairAssociator) != NULL) {
-                if (strcspn(pair, mPairAssociator) == 0) {
-                    // No key provided, bailing out
-                    free(pairs);
-                    return android::BAD_VALUE;
+            const char *keyEnd =
+                static_cast<const char *>(memchr(pair, mPairAssociator, pairEnd - pair));
+            const char *value = pairEnd;
+            const char *valueEnd = pairEnd;
+            if (keyEnd == pair) {
+                // No key provided, bailing out
+                return android::BAD_VALUE;
+            }
+            if (keyEnd == NULL) {
+                keyEnd = pairEnd;
+            } else {
+                // Value is the literal following the associators, up to the next associator
+                for (value = keyEnd; value != pairEnd && *value == mPairAssociator; ++value) {
                 }
-                char *tmp = strtok(pair, mPairAssociator);
-                AUDIOCOMMS_ASSERT(tmp != NULL, "No key nor value provided");
-                key = tmp;
-                tmp = strtok(NULL, mPairAssociator);
-                if (tmp != NULL) {
-                    value = tmp;
+                valueEnd = static_cast<const char *>(
+                    memchr(value, mPairAssociator, pairEnd - value));
+                if (valueEnd == NULL) {
+                    valueEnd = pairEnd;
                 }
-            } else {
-                key = pair;
             }
-            android::status_t res = addLiteral(key, value);
+            android::status_t res = addLiteral(pair, keyEnd - pair, value, valueEnd - value);
             if (res != android::OK) {
                 status = res;
             }
         }
-        pair = strtok_r(NULL, mPairDelimiter, &context);
+        pair = pairEnd + 1;
     }
-    free(pairs);
     return status;
 }
 
-android::status_t KeyValuePairs::addLiteral(const string &key, const string &value)
+android::status_t KeyValuePairs::addLiteral(const char *key, size_t keyLength,
+                                            const char *value, size_t valueLength)
 {
-    if (mMap.find(key) != mMap.end()) {
-        mMap[key] = value;
+    size_t index;
+    if (find(key, keyLength, index)) {
+        Pair &pair = mPairs[index];
+        if (valueLength <= pair.valueLength) {
+            // Overwritten in place
+            mArena.replace(pair.valueOffset, valueLength, value, valueLength);
+            mGarbage += pair.valueLength - valueLength;
+        } else {
+            mGarbage += pair.valueLength;
+            pair.valueOffset = mArena.size();
+            mArena.append(value, valueLength);
+        }
+        pair.valueLength = valueLength;
+        if (mGarbage >= mMinGarbageToCompact && mGarbage > mArena.size() / 2) {
+            compact();
+        }
         return android::ALREADY_EXISTS;
     }
-    mMap[key] = value;
+    Pair pair;
+    pair.keyOffset = mArena.size();
+    pair.keyLength = keyLength;
+    mArena.append(key, keyLength);
+    pair.valueOffset = mArena.size();
+    pair.valueLength = valueLength;
+    mArena.append(value, valueLength);
+    mPairs.insert(mPairs.begin() + index, pair);
     return android::OK;
 }
 
-android::status_t KeyValuePairs::getLiteral(const string &key, string &value) const
+bool KeyValuePairs::find(const char *key, size_t keyLength, size_t &index) const
 {
-    MapConstIterator it = mMap.find(key);
-    if (it == mMap.end()) {
-        return android::BAD_VALUE;
+    // Keys are ordered as strings are, by bytes then by length
+    const char *arena = mArena.data();
+    size_t first = 0;
+    size_t last = mPairs.size();
+    while (first < last) {
+        size_t middle = first + (last - first) / 2;
+        const Pair &pair = mPairs[middle];
+        int comparison = memcmp(arena + pair.keyOffset, key, min<size_t>(pair.keyLength,
+                                                                          keyLength));
+        if (comparison == 0) {
+            if (pair.keyLength == keyLength) {
+                index = middle;
+                return true;
+            }
+            comparison = pair.keyLength < keyLength ? -1 : 1;
+        }
+        if (comparison < 0) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
     }
-    value = it->second;
-    return android::OK;
+    index = first;
+    return false;
+}
+
+void KeyValuePairs::compact()
+{
+    string arena;
+    arena.reserve(mArena.size() - mGarbage);
+    vector<Pair>::iterator it;
+    for (it = mPairs.begin(); it != mPairs.end(); ++it) {
+        uint32_t keyOffset = arena.size();
+        arena.append(mArena, it->keyOffset, it->keyLength);
+        uint32_t valueOffset = arena.size();
+        arena.append(mArena, it->valueOffset, it->valueLength);
+        it->keyOffset = keyOffset;
+        it->valueOffset = valueOffset;
+    }
+    mArena.swap(arena);
+    mGarbage = 0;
+}
+
+bool KeyValuePairs::parse(const char *literal, size_t length, string &value)
+{
+    value.assign(literal, length);
+    return true;
+}
+
+bool KeyValuePairs::parse(const char *literal, size_t length, bool &value)
+{
+    if (isLiteral(literal, length, "0") || isLiteral(literal, length, "FALSE") ||
+        isLiteral(literal, length, "false")) {
+        value = false;
+        return true;
+    }
+    if (isLiteral(literal, length, "1") || isLiteral(literal, length, "TRUE") ||
+        isLiteral(literal, length, "true")) {
+        value = true;
+        return true;
+    }
+    return false;
+}
+
+bool KeyValuePairs::parse(const char *literal, size_t length, uint64_t &value)
+{
+    return parseInteger(literal, length, value);
+}
+
+bool KeyValuePairs::parse(const char *literal, size_t length, int64_t &value)
+{
+    return parseInteger(literal, length, value);
+}
+
+bool KeyValuePairs::parse(const char *literal, size_t length, uint32_t &value)
+{
+    return parseInteger(literal, length, value);
+}
+
+bool KeyValuePairs::parse(const char *literal, size_t length, int32_t &value)
+{
+    return parseInteger(literal, length, value);
+}
+
+bool KeyValuePairs::parse(const char *literal, size_t length, uint16_t &value)
+{
+    return parseInteger(literal, length, value);
+}
+
+bool KeyValuePairs::parse(const char *literal, size_t length, int16_t &value)
+{
+    return parseInteger(literal, length, value);
+}
+
+ssize_t KeyValuePairs::format(bool value, char (&literal)[mMaxLiteralSize])
+{
+    return snprintf(literal, mMaxLiteralSize, "%s", value ? "true" : "false");
+}
+
+ssize_t KeyValuePairs::format(uint64_t value, char (&literal)[mMaxLiteralSize])
+{
+    return snprintf(literal, mMaxLiteralSize, "%llu", static_cast<unsigned long long>(value));
+}
+
+ssize_t KeyValuePairs::format(int64_t value, char (&literal)[mMaxLiteralSize])
+{
+    return snprintf(literal, mMaxLiteralSize, "%lld", static_cast<long long>(value));
+}
+
+ssize_t KeyValuePairs::format(uint32_t value, char (&literal)[mMaxLiteralSize])
+{
+    return snprintf(literal, mMaxLiteralSize, "%u", value);
+}
+
+ssize_t KeyValuePairs::format(int32_t value, char (&literal)[mMaxLiteralSize])
+{
+    return snprintf(literal, mMaxLiteralSize, "%d", value);
 }
 
 }   // namespace intel_audio
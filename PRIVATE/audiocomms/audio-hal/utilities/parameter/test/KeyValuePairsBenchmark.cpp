@@ -0,0 +1,175 @@
+/*
+ * INTEL CONFIDENTIAL
+ *
+ * Copyright (c) 2014 Intel Corporation All Rights Reserved.
+ *
+ * The source code contained or described herein and all documents related to
+ * the source code ("Material") are owned by Intel Corporation or its suppliers
+ * or licensors.
+ *
+ * Title to the Material remains with Intel Corporation or its suppliers and
+ * licensors. The Material contains trade secrets and proprietary and
+ * confidential information of Intel or its suppliers and licensors. The
+ * Material is protected by worldwide copyright and trade secret laws and treaty
+ * provisions. No part of the Material may be used, copied, reproduced,
+ * modified, published, uploaded, posted, transmitted, distributed, or disclosed
+ * in any way without Intel's prior express written permission.
+ *
+ * No license under any patent, copyright, trade secret or other intellectual
+ * property right is granted to or conferred upon you by disclosure or delivery
+ * of the Materials, either expressly, by implication, inducement, estoppel or
+ * otherwise. Any license under such intellectual property rights must be
+ * express and approved by Intel in writing.
+ */
+
+#include <KeyValuePairs.hpp>
+#include <convert.hpp>
+#include <gtest/gtest.h>
+#include <map>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+using namespace intel_audio;
+using namespace std;
+
+/**
+ * Former implementation of the key value pairs, as reference: a map of strings filled by
+ * tokenizing a copy of the string of pairs.
+ */
+class MapKeyValuePairs
+{
+public:
+    MapKeyValuePairs(const string &keyValuePairs) { add(keyValuePairs); }
+
+    string toString() const
+    {
+        string keyValueList;
+        map<string, string>::const_iterator it;
+        for (it = mMap.begin(); it != mMap.end(); ++it) {
+            keyValueList += it->first + "=" + it->second;
+            if (it->first != mMap.rbegin()->first) {
+                keyValueList += ";";
+            }
+        }
+        return keyValueList;
+    }
+
+    android::status_t add(const string &keyValuePairs)
+    {
+        android::status_t status = android::OK;
+        char *pairs = strdup(keyValuePairs.c_str());
+        char *context;
+        char *pair = strtok_r(pairs, ";", &context);
+        while (pair != NULL) {
+            string key;
+            string value;
+            if (strchr(pair, '=') != NULL) {
+                if (strcspn(pair, "=") == 0) {
+                    free(pairs);
+                    return android::BAD_VALUE;
+                }
+                key = strtok(pair, "=");
+                char *tmp = strtok(NULL, "=");
+                if (tmp != NULL) {
+                    value = tmp;
+                }
+            } else {
+                key = pair;
+            }
+            android::status_t res = addLiteral(key, value);
+            if (res != android::OK) {
+                status = res;
+            }
+            pair = strtok_r(NULL, ";", &context);
+        }
+        free(pairs);
+        return status;
+    }
+
+    template <typename T>
+    android::status_t add(const string &key, const T &value)
+    {
+        string literal;
+        if (!audio_comms::utilities::convertTo(value, literal)) {
+            return android::BAD_VALUE;
+        }
+        return addLiteral(key, literal);
+    }
+
+    template <typename T>
+    android::status_t get(const string &key, T &value) const
+    {
+        map<string, string>::const_iterator it = mMap.find(key);
+        if (it == mMap.end() || !audio_comms::utilities::convertTo(it->second, value)) {
+            return android::BAD_VALUE;
+        }
+        return android::OK;
+    }
+
+private:
+    android::status_t addLiteral(const string &key, const string &value)
+    {
+        bool isFound = mMap.find(key) != mMap.end();
+        mMap[key] = value;
+        return isFound ? android::ALREADY_EXISTS : android::OK;
+    }
+
+    map<string, string> mMap;
+};
+
+static uint64_t nowUs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+ * Mimics the parameters traffic of a stream: parse a set of parameters, read the routing
+ * and the input source, then answer a get with a few updated values.
+ */
+template <class Pairs>
+static uint64_t runParametersTraffic(uint32_t iterations, string &lastAnswer)
+{
+    const string parameters =
+        "routing=2;input_source=1;format=1;channels=12;frame_count=960;sampling_rate=48000;"
+        "screen_state=on;bt_headset_nrec=off;lpal_device=-2147483644;stream_flags=16";
+    uint64_t start = nowUs();
+    for (uint32_t i = 0; i < iterations; i++) {
+        Pairs pairs(parameters);
+        int32_t routing = 0;
+        uint32_t inputSource = 0;
+        uint32_t samplingRate = 0;
+        bool isBtNrecOn = false;
+        EXPECT_EQ(android::OK, pairs.get("routing", routing));
+        EXPECT_EQ(android::OK, pairs.get("input_source", inputSource));
+        EXPECT_EQ(android::OK, pairs.get("sampling_rate", samplingRate));
+        EXPECT_EQ(android::BAD_VALUE, pairs.get("bt_headset_nrec", isBtNrecOn));
+        pairs.template add<int32_t>("routing", routing + i % 2);
+        pairs.template add<uint32_t>("sampling_rate", samplingRate / 3);
+        pairs.add("screen_state", true);
+        lastAnswer = pairs.toString();
+    }
+    return nowUs() - start;
+}
+
+TEST(KeyValuePairsBenchmark, ParametersTraffic)
+{
+    const uint32_t iterations = 20000;
+    string answer;
+    string referenceAnswer;
+
+    // Warm up both, then measure
+    runParametersTraffic<KeyValuePairs>(iterations / 10, answer);
+    runParametersTraffic<MapKeyValuePairs>(iterations / 10, referenceAnswer);
+    uint64_t elapsedUs = runParametersTraffic<KeyValuePairs>(iterations, answer);
+    uint64_t referenceUs = runParametersTraffic<MapKeyValuePairs>(iterations, referenceAnswer);
+
+    EXPECT_EQ(referenceAnswer, answer);
+    printf("%u parameters round trips: %llu us (map of strings: %llu us)\n", iterations,
+           static_cast<unsigned long long>(elapsedUs),
+           static_cast<unsigned long long>(referenceUs));
+}
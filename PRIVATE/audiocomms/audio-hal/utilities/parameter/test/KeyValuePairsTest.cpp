@@ -266,6 +266,110 @@ TEST(KeyValuePairsTest, WrongConversion)
     EXPECT_EQ(android::BAD_VALUE, parameter.get(keyToTest, numericalValue));
 }
 
+TEST(KeyValuePairsTest, IntegerConversion)
+{
+    const string key = "dummykey";
+    KeyValuePairs parameter;
+
+    int32_t signedValue = 0;
+    parameter.add(key, string("-2147483648"));
+    ASSERT_EQ(android::OK, parameter.get(key, signedValue));
+    EXPECT_EQ(std::numeric_limits<int32_t>::min(), signedValue);
+    parameter.add(key, string("2147483648"));
+    EXPECT_EQ(android::BAD_VALUE, parameter.get(key, signedValue));
+
+    uint32_t unsignedValue = 0;
+    parameter.add(key, string("0x8000000A"));
+    ASSERT_EQ(android::OK, parameter.get(key, unsignedValue));
+    EXPECT_EQ(0x8000000Au, unsignedValue);
+    parameter.add(key, string("-1"));
+    EXPECT_EQ(android::BAD_VALUE, parameter.get(key, unsignedValue));
+    parameter.add(key, string("0x"));
+    EXPECT_EQ(android::BAD_VALUE, parameter.get(key, unsignedValue));
+    parameter.add(key, string(" 1"));
+    EXPECT_EQ(android::BAD_VALUE, parameter.get(key, unsignedValue));
+
+    int16_t shortValue = 0;
+    parameter.add(key, string("-32768"));
+    ASSERT_EQ(android::OK, parameter.get(key, shortValue));
+    EXPECT_EQ(-32768, shortValue);
+    parameter.add(key, string("32768"));
+    EXPECT_EQ(android::BAD_VALUE, parameter.get(key, shortValue));
+
+    int64_t longValue = 0;
+    ASSERT_EQ(android::ALREADY_EXISTS,
+              parameter.add(key, std::numeric_limits<int64_t>::min()));
+    ASSERT_EQ(android::OK, parameter.get(key, longValue));
+    EXPECT_EQ(std::numeric_limits<int64_t>::min(), longValue);
+}
+
+TEST(KeyValuePairsTest, BoolConversion)
+{
+    const string key = "dummykey";
+    KeyValuePairs parameter;
+    bool isSet = false;
+
+    ASSERT_EQ(android::OK, parameter.add(key, true));
+    EXPECT_EQ("dummykey=true", parameter.toString());
+    ASSERT_EQ(android::OK, parameter.get(key, isSet));
+    EXPECT_TRUE(isSet);
+
+    parameter.add(key, string("0"));
+    ASSERT_EQ(android::OK, parameter.get(key, isSet));
+    EXPECT_FALSE(isSet);
+    parameter.add(key, string("TRUE"));
+    ASSERT_EQ(android::OK, parameter.get(key, isSet));
+    EXPECT_TRUE(isSet);
+    parameter.add(key, string("True"));
+    EXPECT_EQ(android::BAD_VALUE, parameter.get(key, isSet));
+}
+
+TEST(KeyValuePairsTest, ParseLikeTokenizer)
+{
+    KeyValuePairs pairs;
+
+    // Empty pairs are skipped, the value ends at the next associator
+    EXPECT_EQ(android::OK, pairs.add(";;b==2=3;a;;c=1;"));
+    EXPECT_EQ(3u, pairs.size());
+    EXPECT_EQ("a=;b=2;c=1", pairs.toString());
+
+    // Pairs before an empty key are kept
+    EXPECT_EQ(android::BAD_VALUE, pairs.add("d=4;=5;e=6"));
+    EXPECT_EQ("a=;b=2;c=1;d=4", pairs.toString());
+}
+
+TEST(KeyValuePairsTest, UpdateValues)
+{
+    KeyValuePairs pairs;
+    for (uint32_t i = 0; i < 100; i++) {
+        ASSERT_EQ(android::OK, pairs.add<uint32_t>(string("key") + char('a' + i % 26) +
+                                                   char('a' + i / 26), i));
+    }
+    // Growing and shrinking values, so that the arena is compacted
+    for (uint32_t round = 0; round < 20; round++) {
+        for (uint32_t i = 0; i < 100; i += 3) {
+            string key = string("key") + char('a' + i % 26) + char('a' + i / 26);
+            EXPECT_EQ(android::ALREADY_EXISTS,
+                      pairs.add(key, string(round % 2 ? 1 : 40, 'v')));
+        }
+    }
+    EXPECT_EQ(100u, pairs.size());
+    for (uint32_t i = 0; i < 100; i++) {
+        string key = string("key") + char('a' + i % 26) + char('a' + i / 26);
+        if (i % 3 == 0) {
+            string value;
+            ASSERT_EQ(android::OK, pairs.get(key, value));
+            EXPECT_EQ("v", value);
+        } else {
+            uint32_t value;
+            ASSERT_EQ(android::OK, pairs.get(key, value));
+            EXPECT_EQ(i, value);
+        }
+    }
+    KeyValuePairs copy(pairs.toString());
+    EXPECT_EQ(pairs.toString(), copy.toString());
+}
+
 TEST_P(KeyValuePairsTestInt, uint32_t)
 {
     const string key = "dummykey";
@@ -68,6 +68,10 @@ AAAThread::AAAThread(ICallbackAAA *aaaDone, UltraLowLight *ull, I3AControls *aaa
     }
     mFaceState.num_faces = 0;
     CLEAR(mCachedStatsEventMsg);
+
+    // only the statistics of the most recent frame are read, a new stats
+    // event supersedes any pending one
+    mMessageQueue.setCoalescing(MESSAGE_ID_NEW_STATS_READY);
 }
 
 AAAThread::~AAAThread()
@@ -21,6 +21,11 @@ ifeq ($(USE_CAMERA_IO_BREAKDOWN),true)
 LOCAL_CFLAGS += -DUSE_CAMERA_IO_BREAKDOWN
 endif
 
+# per thread recorder underneath the performance traces
+ifeq ($(USE_CAMERA_TRACE_RECORDER),true)
+LOCAL_CFLAGS += -DCAMERA_TRACE_RECORDER
+endif
+
 # Intel camera extras (HDR, face detection, etc.)
 ifeq ($(USE_INTEL_CAMERA_EXTRAS),true)
 LOCAL_CFLAGS += -DENABLE_INTEL_EXTRAS
@@ -50,6 +55,7 @@ LOCAL_SRC_FILES := \
 	MemoryUtils.cpp \
 	PlatformData.cpp \
 	CameraProfiles.cpp \
+	CameraProfilesSnapshot.cpp \
 	IntelParameters.cpp \
 	exif/ExifCreater.cpp \
 	HALVideoStabilization.cpp \
@@ -59,6 +65,7 @@ LOCAL_SRC_FILES := \
 	FaceDetector.cpp \
 	nv12rotation.cpp \
 	CameraDump.cpp \
+	CameraDumpWriter.cpp \
 	CameraAreas.cpp \
 	BracketManager.cpp \
 	OnlineBracket.cpp \
@@ -86,6 +93,11 @@ LOCAL_SRC_FILES += \
 	JpegHwEncoder.cpp
 endif
 
+ifeq ($(USE_CAMERA_TRACE_RECORDER),true)
+LOCAL_SRC_FILES += \
+	TraceRecorder.cpp
+endif
+
 ifeq ($(BOARD_GRAPHIC_IS_GEN), true)
 LOCAL_SRC_FILES += \
 	VAScaler.cpp
@@ -228,6 +240,8 @@ LOCAL_MULTILIB := 32
 
 include $(BUILD_SHARED_LIBRARY)
 
+include $(LOCAL_PATH)/test/Android.mk
+
 endif  #ifeq ($(USE_CAMERA_HAL2),true)
 endif #ifeq ($(USE_CSS_1_5),true)
 endif #ifeq ($(USE_CAMERA_STUB),false)
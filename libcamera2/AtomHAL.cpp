@@ -449,6 +449,7 @@ static int ATOM_CloseCameraHardware(hw_device_t* device)
 
     PERFORMANCE_TRACES_BREAKDOWN_STEP("Close_HAL_Done");
     PERFORMANCE_TRACES_IO_STOP();
+    PERFORMANCE_TRACES_EXPORT();
     return 0;
 }
 
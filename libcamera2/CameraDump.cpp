@@ -50,6 +50,8 @@ bool CameraDump::sNeedDumpPreview = false;
 bool CameraDump::sNeedDumpSnapshot = false;
 bool CameraDump::sNeedDumpVideo = false;
 bool CameraDump::sNeedDump3aStat = false;
+Mutex CameraDump::sWriterLock;
+sp<CameraDumpWriter> CameraDump::sWriter;
 
 CameraDump::CameraDump(int cameraId)
 {
@@ -60,6 +62,7 @@ CameraDump::CameraDump(int cameraId)
     mDelayDump.height = 0;
     mCameraId = cameraId;
     mNeedDumpFlush = false;
+    mRawDataPath[0] = '\0';
 }
 
 CameraDump::~CameraDump()
@@ -77,6 +80,41 @@ CameraDump::~CameraDump()
         free(mDelayDump.buffer_raw);
         mDelayDump.buffer_raw = NULL;
     }
+    // the writer is shared by both cameras
+    if (sInstance == NULL && sInstance_1 == NULL)
+        stopWriter();
+}
+
+/**
+ * Dumps are written by a background thread, started on first use, so
+ * that dumping costs the camera threads a copy and no file I/O.
+ */
+sp<CameraDumpWriter> CameraDump::getWriter()
+{
+    Mutex::Autolock lock(sWriterLock);
+    if (sWriter == NULL) {
+        sWriter = new CameraDumpWriter();
+        if (sWriter->run() != NO_ERROR) {
+            ALOGE("failed to start dump writer");
+            sWriter.clear();
+        }
+    }
+    return sWriter;
+}
+
+void CameraDump::stopWriter()
+{
+    LOG1("@%s", __FUNCTION__);
+    sp<CameraDumpWriter> writer;
+    {
+        Mutex::Autolock lock(sWriterLock);
+        writer = sWriter;
+        sWriter.clear();
+    }
+    if (writer != NULL) {
+        writer->requestExitAndWait();
+        writer->dumpStats();
+    }
 }
 
 void CameraDump::setDumpDataFlag(void)
@@ -212,26 +250,30 @@ int CameraDump::dumpImage2File(camera_delay_dumpImage_T *aDumpImage, const char
     unsigned int bpl = aDumpImage->bpl;
     char filename[80];
     static unsigned int count = 0;
-    size_t bytes;
-    FILE *fp;
     ia_binary_data *uMknData = NULL;
     char rawdpp[100];
     int ret;
+    sp<CameraDumpWriter> writer;
 
     if ((NULL == data) || (0 == size) || (0 == width) || (0 == height) || (NULL == name)
         || (NULL == m3AControls))
         return -ERR_D2F_EVALUE;
 
     LOG2("%s filename is %s", __func__, name);
-    /* media server may not have the access to SD card */
-    showMediaServerGroup();
-
-    ret = getRawDataPath(rawdpp);
-    LOG2("RawDataPath is %s", rawdpp);
-    if(-ERR_D2F_NOPATH == ret) {
-        ALOGE("%s No valid mem for rawdata", __func__);
-        return ret;
+    // look the destination up once, not for every frame
+    if (mRawDataPath[0] == '\0') {
+        /* media server may not have the access to SD card */
+        showMediaServerGroup();
+
+        ret = getRawDataPath(mRawDataPath);
+        LOG2("RawDataPath is %s", mRawDataPath);
+        if(-ERR_D2F_NOPATH == ret) {
+            ALOGE("%s No valid mem for rawdata", __func__);
+            mRawDataPath[0] = '\0';
+            return ret;
+        }
     }
+    strcpy(rawdpp, mRawDataPath);
     if ((strcmp(name, "raw.bayer") == 0) && (m3AControls != NULL))
     {
         /* Only RAW image will have same file name as JPEG */
@@ -287,27 +329,21 @@ int CameraDump::dumpImage2File(camera_delay_dumpImage_T *aDumpImage, const char
         strncat(rawdpp, filename, strlen(filename));
     }
 
-    fp = fopen (rawdpp, "w+");
-    if (fp == NULL) {
-        ALOGE("open file %s failed %s", rawdpp, strerror(errno));
-        if (uMknData) {
-            // Delete Maker note data
-            m3AControls->put3aMakerNote(uMknData);
-        }
-        return -ERR_D2F_EOPEN;
-    }
+    LOG1("Queue image %s", filename);
 
-    LOG1("Begin write image %s", filename);
-
-    if (uMknData && uMknData->size > 0)
-    {
-        if ((bytes = fwrite(uMknData->data, uMknData->size, 1, fp)) < (size_t)uMknData->size)
-            ALOGW("Write less mkn bytes to %s: %d, %d", filename, uMknData->size, bytes);
+    // the maker note goes first in the file, the writer copies both
+    ret = -ERR_D2F_NOMEM;
+    writer = getWriter();
+    if (writer != NULL) {
+        if (uMknData && uMknData->size > 0) {
+            if (writer->queue(rawdpp, data, size, uMknData->data, uMknData->size) == NO_ERROR)
+                ret = ERR_D2F_SUCESS;
+        } else {
+            if (writer->queue(rawdpp, data, size) == NO_ERROR)
+                ret = ERR_D2F_SUCESS;
+        }
     }
 
-    if ((bytes = fwrite(data, size, 1, fp)) < (size_t)size)
-        ALOGW("Write less raw bytes to %s: %d, %d", filename, size, bytes);
-
     count++;
 
     if (uMknData)
@@ -316,9 +352,7 @@ int CameraDump::dumpImage2File(camera_delay_dumpImage_T *aDumpImage, const char
         m3AControls->put3aMakerNote(uMknData);
     }
 
-    fclose (fp);
-
-    return ERR_D2F_SUCESS;
+    return ret;
 }
 
 int CameraDump::dumpImage2FileFlush(bool bufflag)
@@ -364,23 +398,14 @@ int CameraDump::dumpImage2FileFlush(bool bufflag)
  */
 int CameraDump::dumpAtom2File(const AtomBuffer *b, const char *name)
 {
-    int bytes = 0;
-
     ALOGE("Dumping %s resolution (%dx%d) format %s",name,b->width, b->height,v4l2Fmt2Str(b->fourcc));
 
-    FILE *fd = fopen(name, "wb+");
-
-    if(fd == NULL) {
-        ALOGE("%s could not open dump file ",__FUNCTION__);
+    sp<CameraDumpWriter> writer = getWriter();
+    if (writer == NULL || writer->queue(name, b->dataPtr, b->size) != NO_ERROR) {
+        ALOGE("%s could not queue dump %s",__FUNCTION__, name);
         return -1;
     }
 
-    bytes = fwrite(b->dataPtr, 1, b->size, fd);
-    if (bytes != b->size) {
-        ALOGE("ERROR DUMPING %s written %d size %d",name, bytes, b->size);
-    }
-
-    fclose(fd);
     return 0;
 }
 
@@ -451,8 +476,6 @@ void CameraDump::setAtomISP(AtomISP *atomISP)
 void CameraDump::dumpMkn2File()
 {
     LOG1("@%s", __FUNCTION__);
-    FILE *fp;
-    size_t size;
     String8 fileName;
 
     if (!m3AControls || !mISP) {
@@ -466,15 +489,11 @@ void CameraDump::dumpMkn2File()
         fileName = mISP->getFileInjectionFileName();
         fileName += ".mkn";
         LOG2("filename:%s",  fileName.string());
-        fp = fopen (fileName.string(), "w+");
-        if (fp == NULL) {
-            ALOGE("open file %s failed %s", fileName.string(), strerror(errno));
-            m3AControls->put3aMakerNote(aaaMkNote);
-            return;
-        }
-        if ((size = fwrite(aaaMkNote->data, aaaMkNote->size, 1, fp)) < (size_t)aaaMkNote->size)
-            ALOGW("Makernote not fully written to %s: %d, %d", fileName.string(), aaaMkNote->size, size);
-        fclose (fp);
+        sp<CameraDumpWriter> writer = getWriter();
+        if (writer == NULL ||
+            writer->queue(fileName.string(), aaaMkNote->data, aaaMkNote->size) != NO_ERROR)
+            ALOGW("Makernote not written to %s", fileName.string());
+        m3AControls->put3aMakerNote(aaaMkNote);
     }
 }
 
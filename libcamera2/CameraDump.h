@@ -17,8 +17,10 @@
 #ifndef ANDROID_HARDWARE_CAMERA_DUMP_H
 #define ANDROID_HARDWARE_CAMERA_DUMP_H
 
+#include <utils/threads.h>
 #include "I3AControls.h"
 #include "LogHelper.h"
+#include "CameraDumpWriter.h"
 
 namespace android {
 
@@ -100,6 +102,8 @@ namespace android {
         CameraDump(int cameraId);
         int getRawDataPath(char *ppath);
         void showMediaServerGroup(void);
+        static sp<CameraDumpWriter> getWriter();
+        static void stopWriter();
         static CameraDump *sInstance;
         static CameraDump *sInstance_1;
         static raw_data_format_E sRawDataFormat;
@@ -107,11 +111,14 @@ namespace android {
         static bool sNeedDumpSnapshot;
         static bool sNeedDumpVideo;
         static bool sNeedDump3aStat;
+        static Mutex sWriterLock;
+        static sp<CameraDumpWriter> sWriter;
         bool mNeedDumpFlush;
         I3AControls* m3AControls;
         AtomISP*    mISP;
         camera_delay_dumpImage_T mDelayDump;
         int mCameraId;
+        char mRawDataPath[DUMPIMAGE_RAWDPPATHSIZE];  // empty until found
     };// class CameraDump
 
 }; // namespace android
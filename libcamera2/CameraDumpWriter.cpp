@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "Camera_DumpWriter"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utils/Log.h>
+#include "LogHelper.h"
+#include "CameraDumpWriter.h"
+
+namespace android {
+
+static status_t writeAll(int fd, const char *data, size_t size)
+{
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -errno;
+        }
+        data += n;
+        size -= n;
+    }
+    return NO_ERROR;
+}
+
+CameraDumpWriter::CameraDumpWriter(int numSlots, size_t budget) :
+    Thread(false)
+    ,mSlots(NULL)
+    ,mNumSlots(numSlots > 0 ? numSlots : 1)
+    ,mSlotSize((budget / mNumSlots) & ~(ALIGNMENT - 1))
+    ,mNextSequence(0)
+    ,mDirectIo(true)
+{
+    LOG1("@%s: %d slots of %u bytes", __FUNCTION__, mNumSlots, (unsigned) mSlotSize);
+    mSlots = new Slot[mNumSlots];
+    memset(mSlots, 0, sizeof(Slot) * mNumSlots);
+    memset(&mStats, 0, sizeof(mStats));
+
+    // all the memory up front, queue() never allocates
+    for (int i = 0; i < mNumSlots && mSlotSize > 0; i++) {
+        void *buffer = NULL;
+        if (posix_memalign(&buffer, ALIGNMENT, mSlotSize) != 0) {
+            ALOGE("no memory for %d dump slots of %u bytes", mNumSlots, (unsigned) mSlotSize);
+            for (int j = 0; j < i; j++) {
+                free(mSlots[j].buffer);
+                mSlots[j].buffer = NULL;
+            }
+            mSlotSize = 0;  // every dump is refused
+            break;
+        }
+        mSlots[i].buffer = (char *) buffer;
+    }
+}
+
+CameraDumpWriter::~CameraDumpWriter()
+{
+    LOG1("@%s", __FUNCTION__);
+    for (int i = 0; i < mNumSlots; i++)
+        free(mSlots[i].buffer);
+    delete [] mSlots;
+    mSlots = NULL;
+}
+
+status_t CameraDumpWriter::run()
+{
+    if (mSlotSize == 0)
+        return NO_MEMORY;
+    return Thread::run("CamHAL_DUMP");
+}
+
+status_t CameraDumpWriter::requestExitAndWait()
+{
+    LOG1("@%s", __FUNCTION__);
+    // pending dumps are written before the thread exits
+    mLock.lock();
+    requestExit();
+    mPendingCondition.signal();
+    mLock.unlock();
+
+    return Thread::requestExitAndWait();
+}
+
+CameraDumpWriter::Slot *CameraDumpWriter::oldestLocked(SlotState state)
+{
+    Slot *oldest = NULL;
+    for (int i = 0; i < mNumSlots; i++) {
+        Slot *slot = &mSlots[i];
+        if (slot->state == state &&
+            (oldest == NULL || (int32_t) (slot->sequence - oldest->sequence) < 0))
+            oldest = slot;
+    }
+    return oldest;
+}
+
+bool CameraDumpWriter::busyLocked()
+{
+    for (int i = 0; i < mNumSlots; i++) {
+        if (mSlots[i].state != SLOT_FREE)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Picks a free slot, or steals the oldest pending one.
+ */
+CameraDumpWriter::Slot *CameraDumpWriter::reserveSlotLocked(size_t size)
+{
+    // checked before stealing, a dump which can't be stored must not cost
+    // the pending one its slot
+    if (size > mSlotSize)
+        return NULL;
+
+    Slot *slot = oldestLocked(SLOT_FREE);
+    if (slot == NULL) {
+        slot = oldestLocked(SLOT_PENDING);
+        if (slot == NULL)
+            return NULL;    // all slots being filled or written
+        LOG1("dropping dump %s", slot->path);
+        mStats.dropped++;
+    }
+
+    slot->state = SLOT_FILLING;
+    slot->sequence = mNextSequence++;
+    return slot;
+}
+
+status_t CameraDumpWriter::queue(const char *path, const void *data, size_t size,
+                                 const void *header, size_t headerSize)
+{
+    LOG2("@%s: %s, %u bytes", __FUNCTION__, path, (unsigned) (headerSize + size));
+
+    if (path == NULL || data == NULL || size == 0 || (headerSize && header == NULL))
+        return BAD_VALUE;
+
+    if (strlen(path) >= sizeof(mSlots[0].path)) {
+        ALOGE("dump path too long: %s", path);
+        return BAD_VALUE;
+    }
+
+    mLock.lock();
+    Slot *slot = reserveSlotLocked(headerSize + size);
+    if (slot == NULL) {
+        mStats.dropped++;
+        mLock.unlock();
+        ALOGW("no room for dump %s (%u bytes)", path, (unsigned) (headerSize + size));
+        return NO_MEMORY;
+    }
+    mLock.unlock();
+
+    // the slot is ours until it is marked pending
+    strcpy(slot->path, path);
+    if (headerSize)
+        memcpy(slot->buffer, header, headerSize);
+    memcpy(slot->buffer + headerSize, data, size);
+    slot->size = headerSize + size;
+
+    Mutex::Autolock lock(mLock);
+    slot->state = SLOT_PENDING;
+    mStats.queued++;
+    mPendingCondition.signal();
+    return NO_ERROR;
+}
+
+void CameraDumpWriter::flush()
+{
+    LOG1("@%s", __FUNCTION__);
+    Mutex::Autolock lock(mLock);
+    while (busyLocked())
+        mIdleCondition.wait(mLock);
+}
+
+CameraDumpWriter::Stats CameraDumpWriter::getStats()
+{
+    Mutex::Autolock lock(mLock);
+    return mStats;
+}
+
+void CameraDumpWriter::dumpStats()
+{
+    Stats s = getStats();
+    ALOGD("dumps: %u queued, %u written, %u dropped, %u failed, %llu bytes, "
+          "write avg %lld ms max %lld ms",
+          s.queued, s.written, s.dropped, s.failed, (unsigned long long) s.bytes,
+          (long long) (s.written ? s.writeTotal / s.written / 1000000 : 0),
+          (long long) (s.writeMax / 1000000));
+}
+
+/**
+ * Writes the page aligned part of the slot with O_DIRECT and the tail
+ * with buffered I/O, direct I/O cannot write a partial block.
+ */
+status_t CameraDumpWriter::writeSlot(Slot *slot)
+{
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+    int fd = -1;
+    bool direct = mDirectIo;
+
+    if (direct) {
+        fd = open(slot->path, flags | O_DIRECT, 0666);
+        if (fd < 0 && errno == EINVAL) {
+            LOG1("O_DIRECT not supported for %s", slot->path);
+            mDirectIo = false;
+            direct = false;
+        }
+    }
+    if (!direct)
+        fd = open(slot->path, flags, 0666);
+    if (fd < 0) {
+        ALOGE("open file %s failed %s", slot->path, strerror(errno));
+        return -errno;
+    }
+
+    size_t head = direct ? slot->size & ~(ALIGNMENT - 1) : 0;
+    status_t status = writeAll(fd, slot->buffer, head);
+    if (status == NO_ERROR && head < slot->size) {
+        if (direct)
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+        status = writeAll(fd, slot->buffer + head, slot->size - head);
+    }
+    if (status != NO_ERROR)
+        ALOGE("write file %s failed %s", slot->path, strerror(-status));
+
+    close(fd);
+    return status;
+}
+
+bool CameraDumpWriter::threadLoop()
+{
+    mLock.lock();
+    Slot *slot;
+    while ((slot = oldestLocked(SLOT_PENDING)) == NULL && !exitPending())
+        mPendingCondition.wait(mLock);
+    if (slot == NULL) {
+        mLock.unlock();
+        return false;
+    }
+    slot->state = SLOT_WRITING;
+    mLock.unlock();
+
+    nsecs_t start = systemTime();
+    status_t status = writeSlot(slot);
+    nsecs_t elapsed = systemTime() - start;
+
+    mLock.lock();
+    if (status == NO_ERROR) {
+        mStats.written++;
+        mStats.bytes += slot->size;
+    } else {
+        mStats.failed++;
+    }
+    mStats.writeTotal += elapsed;
+    if (elapsed > mStats.writeMax)
+        mStats.writeMax = elapsed;
+    slot->state = SLOT_FREE;
+    mIdleCondition.broadcast();
+    mLock.unlock();
+
+    return true;
+}
+
+}; // namespace android
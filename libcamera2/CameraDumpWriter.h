@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBCAMERA_CAMERA_DUMP_WRITER_H
+#define ANDROID_LIBCAMERA_CAMERA_DUMP_WRITER_H
+
+#include <stdint.h>
+#include <utils/threads.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+/**
+ * Background writer for debug dumps.
+ *
+ * queue() copies a dump into one of a small ring of slots and returns,
+ * the file is written by the writer thread. The budget is split evenly
+ * between the slots and allocated by the constructor, so a dump costs one
+ * memcpy on the camera thread and no allocation nor file I/O. A dump
+ * bigger than a slot is refused.
+ *
+ * When every slot is pending the oldest pending dump is dropped to make
+ * room for the new one: the most recent frames are the interesting ones
+ * and the camera threads must never wait for the storage.
+ *
+ * Files are written with O_DIRECT from page aligned slots where the file
+ * system supports it, so big raw dumps do not evict the page cache.
+ */
+class CameraDumpWriter : public Thread {
+
+// public types
+public:
+    struct Stats {
+        uint32_t queued;        // dumps accepted by queue()
+        uint32_t written;       // dumps written to a file
+        uint32_t dropped;       // dumps replaced or refused for lack of a slot
+        uint32_t failed;        // dumps that could not be written
+        uint64_t bytes;         // bytes written
+        nsecs_t writeTotal;     // time spent writing files
+        nsecs_t writeMax;
+    };
+
+// constructor/destructor
+public:
+    CameraDumpWriter(int numSlots = DEFAULT_SLOTS, size_t budget = DEFAULT_BUDGET);
+    virtual ~CameraDumpWriter();
+
+// public methods
+public:
+    /**
+     * Copies @header followed by @data into a slot and schedules it to be
+     * written to @path.
+     * \return NO_ERROR if queued, NO_MEMORY if the dump was dropped
+     */
+    status_t queue(const char *path, const void *data, size_t size,
+                   const void *header = NULL, size_t headerSize = 0);
+
+    /**
+     * Waits until everything queued so far is on the file system.
+     */
+    void flush();
+
+    Stats getStats();
+    void dumpStats();
+
+    status_t run();                 // override, NO_MEMORY without slots
+    status_t requestExitAndWait();  // override
+
+// private types
+private:
+    enum SlotState {
+        SLOT_FREE,
+        SLOT_FILLING,
+        SLOT_PENDING,
+        SLOT_WRITING,
+    };
+
+    struct Slot {
+        SlotState state;
+        uint32_t sequence;      // queue order
+        char path[128];
+        char *buffer;           // mSlotSize bytes, page aligned
+        size_t size;
+    };
+
+// private methods
+private:
+    virtual bool threadLoop();
+    Slot *reserveSlotLocked(size_t size);
+    Slot *oldestLocked(SlotState state);
+    bool busyLocked();
+    status_t writeSlot(Slot *slot);
+
+// constants
+public:
+    static const int DEFAULT_SLOTS = 4;
+    static const size_t DEFAULT_BUDGET = 64 << 20;   // bytes for all slots
+    static const size_t ALIGNMENT = 4096;            // O_DIRECT granularity
+
+// private data
+private:
+    Mutex mLock;
+    Condition mPendingCondition;    // a slot became pending, or exit
+    Condition mIdleCondition;       // a slot became free
+    Slot *mSlots;
+    int mNumSlots;
+    size_t mSlotSize;               // 0 if the slots could not be allocated
+    uint32_t mNextSequence;
+    bool mDirectIo;                 // cleared once O_DIRECT is refused
+    Stats mStats;
+}; // class CameraDumpWriter
+
+}; // namespace android
+
+#endif // ANDROID_LIBCAMERA_CAMERA_DUMP_WRITER_H
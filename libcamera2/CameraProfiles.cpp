@@ -18,9 +18,11 @@
 
 #include "LogHelper.h"
 #include <string.h>
+#include <sys/stat.h>
 #include <libexpat/expat.h>
 #include "PlatformData.h"
 #include "CameraProfiles.h"
+#include "CameraProfilesSnapshot.h"
 #include "IntelParameters.h"
 
 namespace android {
@@ -33,6 +35,7 @@ CameraProfiles::CameraProfiles(const Vector<SensorNameAndPort>& sensorNames)
     mCurrentDataField = FIELD_INVALID;
     mSensorNum = 0;
     pCurrentCam = NULL;
+    mSnapshotRecorder = NULL;
 
     // Assumption: Driver enumeration order will match the CameraId
     // CameraId in camera_profiles.xml. Main camera is always at
@@ -473,6 +476,9 @@ void CameraProfiles::startElement(void *userData, const char *name, const char *
 {
     CameraProfiles *profiles = (CameraProfiles *)userData;
 
+    if (profiles->mSnapshotRecorder)
+        profiles->mSnapshotRecorder->recordStart(name, atts);
+
     if (profiles->mCurrentDataField == FIELD_INVALID) {
         profiles->checkField(profiles, name, atts);
         return;
@@ -507,6 +513,9 @@ void CameraProfiles::endElement(void *userData, const char *name)
 
     CameraProfiles *profiles = (CameraProfiles *)userData;
 
+    if (profiles->mSnapshotRecorder)
+        profiles->mSnapshotRecorder->recordEnd(name);
+
     if (strcmp(name, "Profiles") == 0) {
         profiles->mCurrentDataField = FIELD_INVALID;
         if (profiles->pCurrentCam) {
@@ -586,18 +595,25 @@ void CameraProfiles::endElement(void *userData, const char *name)
  * Get camera configuration from xml file
  *
  * The function will read the xml configuration file firstly.
- * Then it will parse out the camera settings.
+ * If the snapshot of a previous parse was taken from the same xml
+ * content, its elements are replayed. Otherwise the xml is parsed and
+ * the snapshot is written for the next time.
  * The camera setting is stored inside this CameraProfiles class.
  *
  */
 void CameraProfiles::getDataFromXmlFile(void)
 {
-    int done;
-    void *pBuf = NULL;
+    char *pBuf = NULL;
     FILE *fp = NULL;
+    struct stat st;
+    size_t len;
+    uint64_t key;
+    bool parsed;
+    CameraProfilesSnapshot snapshot;
     LOG1("@%s", __FUNCTION__);
 
     static const char *defaultXmlFile = "/etc/camera_profiles.xml";
+    static const char *defaultSnapshotFile = "/data/misc/media/camera_profiles.bin";
 
     fp = ::fopen(defaultXmlFile, "r");
     if (NULL == fp) {
@@ -605,44 +621,72 @@ void CameraProfiles::getDataFromXmlFile(void)
         return;
     }
 
-    XML_Parser parser = ::XML_ParserCreate(NULL);
-    if (NULL == parser) {
-        ALOGE("@%s, line:%d, parser is NULL", __func__, __LINE__);
+    if (fstat(fileno(fp), &st) != 0 || st.st_size <= 0) {
+        ALOGE("@%s, line:%d, cannot stat %s", __func__, __LINE__, defaultXmlFile);
         goto exit;
     }
-    ::XML_SetUserData(parser, this);
-    ::XML_SetElementHandler(parser, startElement, endElement);
 
-    pBuf = malloc(mBufSize);
+    pBuf = (char *)malloc(st.st_size);
     if (NULL == pBuf) {
         ALOGE("@%s, line:%d, pBuf is NULL", __func__, __LINE__);
         goto exit;
     }
 
-    do {
-        int len = (int)::fread(pBuf, 1, mBufSize, fp);
-        if (!len) {
-            if (ferror(fp)) {
-                clearerr(fp);
-                goto exit;
-            }
-        }
-        done = len < mBufSize;
-        if (XML_Parse(parser, (const char *)pBuf, len, done) == XML_STATUS_ERROR) {
-            ALOGE("@%s, line:%d, XML_Parse error", __func__, __LINE__);
-            goto exit;
-        }
-    } while (!done);
+    len = ::fread(pBuf, 1, st.st_size, fp);
+    if (len != (size_t)st.st_size) {
+        ALOGE("@%s, line:%d, cannot read %s", __func__, __LINE__, defaultXmlFile);
+        goto exit;
+    }
+
+    key = CameraProfilesSnapshot::hash(pBuf, len);
+    if (snapshot.load(defaultSnapshotFile, key) == NO_ERROR) {
+        LOG1("@%s: replaying %u elements from %s", __FUNCTION__,
+             (unsigned)snapshot.elementCount(), defaultSnapshotFile);
+        snapshot.replay(this, startElement, endElement);
+        goto exit;
+    }
+
+    mSnapshotRecorder = &snapshot;
+    parsed = parseXml(pBuf, len);
+    mSnapshotRecorder = NULL;
+    if (parsed)
+        snapshot.save(defaultSnapshotFile, key);
 
 exit:
-    if (parser)
-        ::XML_ParserFree(parser);
     if (pBuf)
         free(pBuf);
     if (fp)
     ::fclose(fp);
 }
 
+/**
+ * Parses the whole xml content with expat
+ *
+ * \param xml: the content of the xml file.
+ * \param size: its size in bytes.
+ * \return true if the xml was parsed to the end
+ */
+bool CameraProfiles::parseXml(const char *xml, size_t size)
+{
+    bool ok = true;
+
+    XML_Parser parser = ::XML_ParserCreate(NULL);
+    if (NULL == parser) {
+        ALOGE("@%s, line:%d, parser is NULL", __func__, __LINE__);
+        return false;
+    }
+    ::XML_SetUserData(parser, this);
+    ::XML_SetElementHandler(parser, startElement, endElement);
+
+    if (XML_Parse(parser, xml, size, true) == XML_STATUS_ERROR) {
+        ALOGE("@%s, line:%d, XML_Parse error", __func__, __LINE__);
+        ok = false;
+    }
+
+    ::XML_ParserFree(parser);
+    return ok;
+}
+
 void CameraProfiles::dump(void)
 {
     for (unsigned i = 0; i < getSensorNum(); i++) {
@@ -41,12 +41,16 @@ extern "C" {
 
 namespace android {
 
+class CameraProfilesSnapshot;
+
 /**
  * \class CameraProfiles
  *
  * This class is used to parse the camera configuration file.
  * The configuration file is xml format.
  * This class will use the expat lib to do the xml parser.
+ * The parsed elements are kept in a CameraProfilesSnapshot, which is
+ * replayed instead of parsing again as long as the xml does not change.
  */
 class CameraProfiles : public PlatformBase {
 public:
@@ -74,11 +78,13 @@ private:
 
     Vector<SensorNameAndPort> mSensorNames;
 
-    static const int mBufSize = 4*1024;
+    CameraProfilesSnapshot *mSnapshotRecorder;  // set while expat parses
+
     static void startElement(void *userData, const char *name, const char **atts);
     static void endElement(void *userData, const char *name);
 
     void getDataFromXmlFile(void);
+    bool parseXml(const char *xml, size_t size);
     void checkField(CameraProfiles *profiles, const char *name, const char **atts);
 
     void handleSensor(CameraProfiles *profiles, const char *name, const char **atts);
@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2014 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define LOG_TAG "Camera_ProfilesSnapshot"
+
+#include "LogHelper.h"
+#include "CameraProfilesSnapshot.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace android {
+
+const uint32_t CameraProfilesSnapshot::MAGIC;
+const uint32_t CameraProfilesSnapshot::VERSION;
+const int CameraProfilesSnapshot::MAX_ATTRIBUTES;
+const uint32_t CameraProfilesSnapshot::RECORD_END;
+
+CameraProfilesSnapshot::CameraProfilesSnapshot() :
+    mStringCount(0)
+    ,mOverflow(false)
+    ,mMap(NULL)
+    ,mMapSize(0)
+    ,mRecords(NULL)
+    ,mRecordCount(0)
+    ,mStrings(NULL)
+    ,mElementCount(0)
+{
+}
+
+CameraProfilesSnapshot::~CameraProfilesSnapshot()
+{
+    clear();
+}
+
+void CameraProfilesSnapshot::clear()
+{
+    mRecordTable.clear();
+    mStringPool.clear();
+    mStringIndex.clear();
+    mStringCount = 0;
+    mOverflow = false;
+
+    if (mMap != NULL)
+        munmap(mMap, mMapSize);
+    mMap = NULL;
+    mMapSize = 0;
+    mRecords = NULL;
+    mRecordCount = 0;
+    mStrings = NULL;
+    mElementCount = 0;
+}
+
+uint64_t CameraProfilesSnapshot::hash(const void *data, size_t size)
+{
+    const unsigned char *p = (const unsigned char *) data;
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/**
+ * Doubles the string index, which is kept at most half full.
+ */
+void CameraProfilesSnapshot::growIndex()
+{
+    size_t size = mStringIndex.isEmpty() ? 256 : mStringIndex.size() * 2;
+    Vector<uint32_t> index;
+    index.insertAt(0, 0, size);
+
+    for (size_t i = 0; i < mStringIndex.size(); i++) {
+        uint32_t entry = mStringIndex[i];
+        if (entry == 0)
+            continue;
+        const char *str = mStringPool.array() + entry - 1;
+        size_t slot = hash(str, strlen(str)) & (size - 1);
+        while (index[slot] != 0)
+            slot = (slot + 1) & (size - 1);
+        index.editItemAt(slot) = entry;
+    }
+    mStringIndex = index;
+}
+
+/**
+ * Returns the offset of @str in the string pool, adding it if needed.
+ * Element and attribute names repeat for every profile, and most values
+ * are "value", "true" or "false", so the pool stays small.
+ */
+uint32_t CameraProfilesSnapshot::addString(const char *str)
+{
+    if ((mStringCount + 1) * 2 > mStringIndex.size())
+        growIndex();
+
+    size_t len = strlen(str);
+    size_t mask = mStringIndex.size() - 1;
+    size_t slot = hash(str, len) & mask;
+    while (mStringIndex[slot] != 0) {
+        uint32_t offset = mStringIndex[slot] - 1;
+        if (strcmp(mStringPool.array() + offset, str) == 0)
+            return offset;
+        slot = (slot + 1) & mask;
+    }
+
+    uint32_t offset = mStringPool.size();
+    mStringPool.appendArray(str, len + 1);
+    mStringIndex.editItemAt(slot) = offset + 1;
+    mStringCount++;
+    return offset;
+}
+
+void CameraProfilesSnapshot::recordStart(const char *name, const char **atts)
+{
+    uint32_t count = 0;
+    while (atts[count * 2] != NULL)
+        count++;
+    if (count > (uint32_t) MAX_ATTRIBUTES) {
+        ALOGW("@%s: %s has %u attributes, cannot be recorded", __FUNCTION__, name, count);
+        mOverflow = true;
+        return;
+    }
+
+    mRecordTable.add(count << 1);
+    mRecordTable.add(addString(name));
+    for (uint32_t i = 0; i < count * 2; i++)
+        mRecordTable.add(addString(atts[i]));
+    mElementCount++;
+}
+
+void CameraProfilesSnapshot::recordEnd(const char *name)
+{
+    mRecordTable.add(RECORD_END);
+    mRecordTable.add(addString(name));
+}
+
+static bool writeAll(int fd, const void *data, size_t size)
+{
+    const char *p = (const char *) data;
+    while (size > 0) {
+        ssize_t n = ::write(fd, p, size);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+status_t CameraProfilesSnapshot::save(const char *path, uint64_t key) const
+{
+    LOG1("@%s: %s, %u elements", __FUNCTION__, path, (unsigned) mElementCount);
+
+    if (mOverflow || mRecordTable.isEmpty())
+        return INVALID_OPERATION;
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.key = key;
+    header.recordCount = mRecordTable.size();
+    header.stringSize = mStringPool.size();
+    header.elementCount = mElementCount;
+
+    char tmpPath[PATH_MAX];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.%d", path, getpid());
+    int fd = ::open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0640);
+    if (fd < 0) {
+        LOG1("@%s: cannot create %s: %s", __FUNCTION__, tmpPath, strerror(errno));
+        return UNKNOWN_ERROR;
+    }
+
+    bool ok = writeAll(fd, &header, sizeof(header))
+           && writeAll(fd, mRecordTable.array(), mRecordTable.size() * sizeof(uint32_t))
+           && writeAll(fd, mStringPool.array(), mStringPool.size())
+           && fsync(fd) == 0;
+    ::close(fd);
+
+    if (!ok || ::rename(tmpPath, path) != 0) {
+        ALOGW("@%s: cannot write %s: %s", __FUNCTION__, path, strerror(errno));
+        ::unlink(tmpPath);
+        return UNKNOWN_ERROR;
+    }
+    return NO_ERROR;
+}
+
+status_t CameraProfilesSnapshot::load(const char *path, uint64_t key)
+{
+    LOG1("@%s: %s", __FUNCTION__, path);
+    clear();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return NAME_NOT_FOUND;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(Header)) {
+        ::close(fd);
+        return BAD_VALUE;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+        return BAD_VALUE;
+    mMap = map;
+    mMapSize = st.st_size;
+
+    const Header *header = (const Header *) map;
+    if (header->magic != MAGIC || header->version != VERSION) {
+        LOG1("@%s: %s has another format", __FUNCTION__, path);
+        clear();
+        return BAD_VALUE;
+    }
+    if (header->key != key) {
+        LOG1("@%s: %s is stale", __FUNCTION__, path);
+        clear();
+        return BAD_VALUE;
+    }
+
+    uint64_t expected = sizeof(Header) + (uint64_t) header->recordCount * sizeof(uint32_t)
+                      + header->stringSize;
+    const uint32_t *records = (const uint32_t *) (header + 1);
+    const char *strings = (const char *) (records + header->recordCount);
+    if (expected != mMapSize || header->stringSize == 0
+        || strings[header->stringSize - 1] != '\0') {
+        ALOGW("@%s: %s is damaged", __FUNCTION__, path);
+        clear();
+        return BAD_VALUE;
+    }
+
+    // check every record once, so that replay() can trust them
+    uint32_t elements = 0;
+    uint32_t i = 0;
+    while (i < header->recordCount) {
+        uint32_t tag = records[i];
+        uint32_t count = tag == RECORD_END ? 1 : (tag >> 1) * 2 + 1;
+        if ((tag != RECORD_END && ((tag & 1) || (tag >> 1) > (uint32_t) MAX_ATTRIBUTES))
+            || count > header->recordCount - i - 1) {
+            ALOGW("@%s: %s is damaged", __FUNCTION__, path);
+            clear();
+            return BAD_VALUE;
+        }
+        for (uint32_t j = 1; j <= count; j++) {
+            if (records[i + j] >= header->stringSize) {
+                ALOGW("@%s: %s is damaged", __FUNCTION__, path);
+                clear();
+                return BAD_VALUE;
+            }
+        }
+        if (tag != RECORD_END)
+            elements++;
+        i += count + 1;
+    }
+
+    mRecords = records;
+    mRecordCount = header->recordCount;
+    mStrings = strings;
+    mElementCount = elements;
+    return NO_ERROR;
+}
+
+void CameraProfilesSnapshot::replay(void *userData, StartElementHandler start,
+                                    EndElementHandler end) const
+{
+    const char *atts[MAX_ATTRIBUTES * 2 + 1];
+    uint32_t i = 0;
+
+    while (i < mRecordCount) {
+        uint32_t tag = mRecords[i];
+        const char *name = mStrings + mRecords[i + 1];
+        if (tag == RECORD_END) {
+            end(userData, name);
+            i += 2;
+            continue;
+        }
+        uint32_t count = (tag >> 1) * 2;
+        for (uint32_t j = 0; j < count; j++)
+            atts[j] = mStrings + mRecords[i + 2 + j];
+        atts[count] = NULL;
+        start(userData, name, atts);
+        i += count + 2;
+    }
+}
+
+} // namespace android
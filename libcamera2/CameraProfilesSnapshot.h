@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2014 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBCAMERA_CAMERA_PROFILES_SNAPSHOT_H
+#define ANDROID_LIBCAMERA_CAMERA_PROFILES_SNAPSHOT_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <utils/Errors.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+/**
+ * \class CameraProfilesSnapshot
+ *
+ * Binary snapshot of the elements of camera_profiles.xml.
+ *
+ * While expat parses the XML, every element start and end is recorded
+ * with its attributes into a table of records and a pool of unique
+ * strings, which save() writes to a file. On the next start, load() maps
+ * that file and replay() feeds the very same elements to the
+ * CameraProfiles handlers, without tokenizing the XML again.
+ *
+ * The snapshot holds elements rather than CameraInfo fields, so it does
+ * not depend on the layout of CameraInfo nor on the sensors found at run
+ * time, only on the XML: it is keyed by hash() of the XML content and a
+ * snapshot with another key or another format version is refused.
+ *
+ * File layout: a Header, Header::recordCount 32 bit records, then
+ * Header::stringSize bytes of NUL terminated strings. An element start
+ * is (attribute count << 1), the name and the attribute names and values
+ * as offsets in the strings; an element end is RECORD_END and the name.
+ */
+class CameraProfilesSnapshot {
+
+// public types
+public:
+    typedef void (*StartElementHandler)(void *userData, const char *name, const char **atts);
+    typedef void (*EndElementHandler)(void *userData, const char *name);
+
+    static const uint32_t MAGIC = 0x4e535043;  // "CPSN"
+    static const uint32_t VERSION = 1;
+    static const int MAX_ATTRIBUTES = 16;      // name/value pairs per element
+
+// constructor/destructor
+public:
+    CameraProfilesSnapshot();
+    ~CameraProfilesSnapshot();
+
+// public methods
+public:
+    /**
+     * 64 bit FNV-1a hash, used as the key of the snapshot of an XML file.
+     */
+    static uint64_t hash(const void *data, size_t size);
+
+    /**
+     * Records an element, with the arguments of the expat handlers.
+     */
+    void recordStart(const char *name, const char **atts);
+    void recordEnd(const char *name);
+
+    /**
+     * Writes what was recorded to @path, through a temporary file renamed
+     * over @path so that a reader never sees a partial snapshot.
+     */
+    status_t save(const char *path, uint64_t key) const;
+
+    /**
+     * Maps the snapshot at @path and checks it completely.
+     * \return NO_ERROR if it can be replayed, NAME_NOT_FOUND if there is
+     *         none, BAD_VALUE if it is stale or damaged
+     */
+    status_t load(const char *path, uint64_t key);
+
+    /**
+     * Calls @start and @end for every element of the loaded snapshot,
+     * in document order.
+     */
+    void replay(void *userData, StartElementHandler start, EndElementHandler end) const;
+
+    size_t elementCount() const { return mElementCount; }
+
+    void clear();
+
+// private types
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint32_t recordCount;
+        uint32_t stringSize;
+        uint32_t elementCount;
+        uint32_t reserved;
+    };
+
+    static const uint32_t RECORD_END = 1;
+
+// private methods
+private:
+    uint32_t addString(const char *str);
+    void growIndex();
+
+// prevent copy constructor and assignment operator
+private:
+    CameraProfilesSnapshot(const CameraProfilesSnapshot& other);
+    CameraProfilesSnapshot& operator=(const CameraProfilesSnapshot& other);
+
+// private data
+private:
+    // recorded elements
+    Vector<uint32_t> mRecordTable;
+    Vector<char> mStringPool;
+    Vector<uint32_t> mStringIndex;  // open addressing, offset + 1 or 0
+    size_t mStringCount;
+    bool mOverflow;                 // an element did not fit in the format
+
+    // loaded snapshot
+    void *mMap;
+    size_t mMapSize;
+    const uint32_t *mRecords;
+    uint32_t mRecordCount;
+    const char *mStrings;
+
+    size_t mElementCount;
+};
+
+} // namespace android
+
+#endif // ANDROID_LIBCAMERA_CAMERA_PROFILES_SNAPSHOT_H
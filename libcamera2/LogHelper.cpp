@@ -91,6 +91,12 @@ void android::LogHelper::setDebugLevel(void)
         if (gPerfLevel & CAMERA_DEBUG_LOG_PERF_IO_MEMORY) {
             PerformanceTraces::IOBreakdown::enableMemInfo(true);
         }
+
+#ifdef CAMERA_TRACE_RECORDER
+        if (gPerfLevel & CAMERA_DEBUG_LOG_PERF_TRACES_RECORDER) {
+            TraceRecorder::enable(true);
+        }
+#endif
     }
 
     //Power property
@@ -17,35 +17,116 @@
 #ifndef MESSAGE_QUEUE
 #define MESSAGE_QUEUE
 
+#include <sched.h>
+#include <cutils/atomic.h>
 #include <utils/Errors.h>
 #include <utils/Timers.h>
 #include <utils/threads.h>
 #include <utils/Log.h>
-#include <utils/List.h>
 #include <utils/Vector.h>
+#include <utils/List.h>
 
 // By default MessageQueue::receive() waits infinitely for a new message
 #define MESSAGE_QUEUE_RECEIVE_TIMEOUT_MSEC_INFINITE 0
 
+// Default number of messages per priority lane kept in the lock-free ring,
+// power of two. A lane holding more spills the extra ones to a list.
+#define MESSAGE_QUEUE_DEFAULT_CAPACITY 64
+
 namespace android {
 
+/**
+ * Lock-free message queue between camera threads.
+ *
+ * Messages are copied into preallocated cells of one of the priority
+ * lanes, so send() and receive() neither allocate nor take a lock while
+ * the lane has room; the sleep mutex is only used to put an idle receiver
+ * to sleep and wake it up. Each lane is a bounded multi-producer/
+ * multi-consumer ring where every cell carries a sequence number
+ * (D. Vyukov's bounded queue).
+ *
+ * Like the list based queue it replaces, the queue is unbounded: a message
+ * which does not fit in a full ring is appended to the spill list of the
+ * lane, under mSpillMutex. Until the spill list is drained, later messages
+ * of the lane follow it there, so the order within a lane is kept.
+ *
+ * On top of FIFO order within a lane:
+ *  - setPriority() moves a message id to a higher or lower lane, receive()
+ *    always serves the highest non-empty lane first,
+ *  - setCoalescing() keeps only the newest pending message of an id, an
+ *    older one still in the queue is dropped when a new one is sent. Only
+ *    use it for messages which do not carry ownership of anything.
+ *
+ * remove() and coalescing mark cells as removed instead of unlinking them,
+ * the receiver skips removed cells. A cell state holds the ring position
+ * the message was sent at, so a stale removal can only hit a recycled cell
+ * after 2^30 more messages went through the lane.
+ *
+ * Any number of threads may send() and remove(), but only one thread may
+ * receive(): there is a single sleeping flag, a second sleeping receiver
+ * could miss its wakeup.
+ *
+ * Per id settings need numReply > 0: ids are expected to be below numReply,
+ * which all users set to MESSAGE_ID_MAX.
+ */
 template <class MessageType, class MessageId>
 class MessageQueue {
 
+    // public types
+public:
+    enum Priority {
+        PRIORITY_HIGH = 0,
+        PRIORITY_NORMAL,
+        PRIORITY_LOW,
+        PRIORITY_NUM
+    };
+
     // constructor / destructor
 public:
     MessageQueue(const char *name, // for debugging
-            int numReply = 0) :    // set numReply only if you need synchronous messages
+            int numReply = 0,      // set numReply only if you need synchronous messages
+            int capacity = MESSAGE_QUEUE_DEFAULT_CAPACITY) :
         mName(name)
+        ,mCount(0)
+        ,mSleeping(0)
         ,mNumReply(numReply)
         ,mReplyMutex(NULL)
         ,mReplyCondition(NULL)
         ,mReplyStatus(NULL)
+        ,mIdPriority(NULL)
+        ,mIdCoalescing(NULL)
+        ,mIdLatest(NULL)
     {
+        int size = 1;
+        while (size < capacity)
+            size <<= 1;
+
+        for (int i = 0; i < PRIORITY_NUM; i++) {
+            Lane &lane = mLanes[i];
+            lane.cells = new Cell[size];
+            lane.mask = size - 1;
+            lane.enqueuePos = 0;
+            lane.dequeuePos = 0;
+            lane.spilled = 0;
+            for (int j = 0; j < size; j++) {
+                lane.cells[j].sequence = j;
+                lane.cells[j].state = 0;
+            }
+        }
+
         if (mNumReply > 0) {
             mReplyMutex = new Mutex[numReply];
             mReplyCondition = new Condition[numReply];
             mReplyStatus = new status_t[numReply];
+            mIdPriority = new int32_t[numReply];
+            mIdCoalescing = new bool[numReply];
+            mIdLatest = new volatile int32_t[numReply];
+            for (int i = 0; i < numReply; i++) {
+                mIdPriority[i] = PRIORITY_NORMAL;
+                mIdCoalescing[i] = false;
+                // already dequeued position, never matches a pending cell
+                mIdLatest[i] = -1;
+            }
         }
     }
 
@@ -59,6 +140,11 @@ public:
             ALOGE("Atom_MessageQueue error: %s queue should be empty. Find the bug.", mName);
         }
 
+        for (int i = 0; i < PRIORITY_NUM; i++) {
+            delete [] mLanes[i].cells;
+            mLanes[i].cells = NULL;
+        }
+
         if (mNumReply > 0) {
             delete [] mReplyMutex;
             mReplyMutex = NULL;
@@ -66,12 +152,32 @@ public:
             mReplyCondition = NULL;
             delete [] mReplyStatus;
             mReplyStatus = NULL;
+            delete [] mIdPriority;
+            mIdPriority = NULL;
+            delete [] mIdCoalescing;
+            mIdCoalescing = NULL;
+            delete [] mIdLatest;
+            mIdLatest = NULL;
         }
     }
 
     // public methods
 public:
 
+    // Configure the lane messages of @id go to. Call before the queue is used.
+    void setPriority(MessageId id, Priority priority)
+    {
+        if (validId(id))
+            mIdPriority[id] = priority;
+    }
+
+    // Keep only the newest pending message of @id. Call before the queue is used.
+    void setCoalescing(MessageId id, bool enable = true)
+    {
+        if (validId(id))
+            mIdCoalescing[id] = enable;
+    }
+
     // Push a message onto the queue. If replyId is not -1 function will block until
     // the caller is signalled with a reply. Caller is unblocked when reply method is
     // called with the corresponding message id.
@@ -85,14 +191,27 @@ public:
             return BAD_VALUE;
         }
 
-        mQueueMutex.lock();
-        MessageType data = *msg;
-        mList.push_front(data);
         if (replyId != -1) {
+            mReplyMutex[replyId].lock();
             mReplyStatus[replyId] = WOULD_BLOCK;
+            mReplyMutex[replyId].unlock();
         }
-        mQueueCondition.signal();
-        mQueueMutex.unlock();
+
+        int laneIndex = validId(msg->id) ? mIdPriority[msg->id] : (int) PRIORITY_NORMAL;
+        int32_t pos;
+        bool queued = false;
+        // once the lane spilled, follow the spilled messages until they are received
+        if (android_atomic_acquire_load(&mLanes[laneIndex].spilled) == 0) {
+            while (!(queued = enqueue(laneIndex, *msg, &pos)) && reclaim(laneIndex))
+                ;
+        }
+
+        if (!queued)
+            spill(laneIndex, *msg);
+        else if (coalescing(msg->id))
+            coalesce(msg->id, pos);
+
+        wakeReceiver();
 
         if (replyId >= 0 && status == NO_ERROR) {
             mReplyMutex[replyId].lock();
@@ -117,20 +236,49 @@ public:
         if(isEmpty())
             return status;
 
-        mQueueMutex.lock();
-        typename List<MessageType>::iterator it = mList.begin();
-        while (it != mList.end()) {
-            MessageType msg = *it;
-            if (msg.id == id) {
+        // oldest first, like the order receive() would have returned them
+        for (int i = 0; i < PRIORITY_NUM; i++) {
+            Lane &lane = mLanes[i];
+            int32_t head = android_atomic_acquire_load(&lane.dequeuePos);
+            int32_t tail = android_atomic_acquire_load(&lane.enqueuePos);
+            for (int32_t pos = head; pos != tail; pos++) {
+                Cell &cell = lane.cells[pos & lane.mask];
+                int32_t state = android_atomic_acquire_load(&cell.state);
+                // the id is only trusted if the cell still holds the same
+                // message when it is claimed below
+                if (!(state & STATE_READY) || android_atomic_acquire_load(&cell.id) != (int32_t) id)
+                    continue;
+                int32_t removed = state & ~(STATE_READY | STATE_BUSY);
+                if (!vect) {
+                    if (android_atomic_release_cas(state, removed, &cell.state) == 0)
+                        android_atomic_dec(&mCount);
+                    continue;
+                }
+                // busy keeps the cell from being recycled while it is copied
+                if (android_atomic_acquire_cas(state, removed | STATE_BUSY, &cell.state) == 0) {
+                    android_atomic_dec(&mCount);
+                    vect->push(cell.data);
+                    android_atomic_release_store(removed, &cell.state);
+                }
+            }
+            // spilled messages are younger than the ones in the ring
+            if (android_atomic_acquire_load(&lane.spilled) == 0)
+                continue;
+            Mutex::Autolock lock(mSpillMutex);
+            typename List<MessageType>::iterator it = lane.spill.begin();
+            while (it != lane.spill.end()) {
+                if (it->id != id) {
+                    ++it;
+                    continue;
+                }
                 if (vect) {
-                    vect->push(msg);
+                    vect->push(*it);
                 }
-                it = mList.erase(it); // returns pointer to next item in list
-            } else {
-                it++;
+                it = lane.spill.erase(it);
+                android_atomic_dec(&lane.spilled);
+                android_atomic_dec(&mCount);
             }
         }
-        mQueueMutex.unlock();
 
         // unblock caller if waiting
         if (mNumReply > 0) {
@@ -145,30 +293,39 @@ public:
             unsigned int timeout_ms = MESSAGE_QUEUE_RECEIVE_TIMEOUT_MSEC_INFINITE)
     {
         status_t status = NO_ERROR;
-        nsecs_t timeout_val = 0;
-        mQueueMutex.lock();
-        while (isEmptyLocked()) {
+        // a wakeup without a message for us must not restart the timeout
+        nsecs_t deadline = timeout_ms ? systemTime() + nsecs_t(timeout_ms) * 1000000LL : 0;
+
+        while (!dequeue(msg)) {
+            mSleepMutex.lock();
+            // announce we sleep, then check again: a sender either sees
+            // the flag or its message is seen here (both are full barriers)
+            if (android_atomic_or(1, &mSleeping))
+                ALOGE("Atom_MessageQueue error: %s has more than one receiver", mName);
+            if (dequeue(msg)) {
+                android_atomic_and(0, &mSleeping);
+                mSleepMutex.unlock();
+                return NO_ERROR;
+            }
             if (timeout_ms) {
-                timeout_val = nsecs_t(timeout_ms) * 1000000LL;
-                status = mQueueCondition.waitRelative(mQueueMutex,timeout_val);
+                nsecs_t remaining = deadline - systemTime();
+                if (remaining > 0)
+                    status = mSleepCondition.waitRelative(mSleepMutex, remaining);
+                else
+                    status = TIMED_OUT;
             } else {
-                mQueueCondition.wait(mQueueMutex);
+                mSleepCondition.wait(mSleepMutex);
             }
-            // wait() should never complete without a message being
-            // available, but for diagnostic purposes let's check it.
-            if (status == TIMED_OUT) {
-                mQueueMutex.unlock();
+            android_atomic_and(0, &mSleeping);
+            mSleepMutex.unlock();
+
+            if (status == TIMED_OUT && !dequeue(msg))
                 return status;
-            }
-            if (isEmptyLocked()) {
-                ALOGE("Atom_MessageQueue - woke with mCount == 0\n");
-            }
+            if (status == TIMED_OUT)
+                return NO_ERROR;
         }
 
-        *msg = *(--mList.end());
-        mList.erase(--mList.end());
-        mQueueMutex.unlock();
-        return status;
+        return NO_ERROR;
     }
 
     // Unblock the caller of send and indicate the status of the received message
@@ -190,32 +347,254 @@ public:
 
     // Return true if the queue is empty
     bool isEmpty() {
-        Mutex::Autolock lock(mQueueMutex);
-        return sizeLocked() == 0;
+        return size() == 0;
     }
 
     int size() {
-        Mutex::Autolock lock(mQueueMutex);
-        return sizeLocked();
+        return android_atomic_acquire_load(&mCount);
     }
 
+    // private types
+private:
+    enum {
+        // cell state: position the message was sent at << 2 | busy | ready
+        STATE_READY = 1,
+        // removed, remove() still copies the message out
+        STATE_BUSY = 2,
+    };
+
+    struct Cell {
+        volatile int32_t sequence;
+        volatile int32_t state;
+        // id of data, readable without owning the cell
+        volatile int32_t id;
+        MessageType data;
+    };
+
+    struct Lane {
+        Cell *cells;
+        int32_t mask;
+        volatile int32_t enqueuePos;
+        volatile int32_t dequeuePos;
+        // messages sent while the ring was full, guarded by mSpillMutex
+        List<MessageType> spill;
+        volatile int32_t spilled;
+    };
+
+    // private methods
 private:
 
-    // Return true if the queue is empty, must be called
-    // with mQueueMutex taken
-    inline bool isEmptyLocked() { return sizeLocked() == 0; }
+    inline bool validId(int id) const { return id >= 0 && id < mNumReply; }
 
-    inline int sizeLocked() { return mList.size(); }
+    inline bool coalescing(int id) const { return validId(id) && mIdCoalescing[id]; }
 
+    static inline int32_t readyState(int32_t pos)
+    {
+        return (int32_t) (((uint32_t) pos << 2) | STATE_READY);
+    }
+
+    // returns false if the lane is full, the position used otherwise
+    bool enqueue(int laneIndex, const MessageType &msg, int32_t *enqueued)
+    {
+        Lane &lane = mLanes[laneIndex];
+        Cell *cell;
+        int32_t pos = android_atomic_acquire_load(&lane.enqueuePos);
+
+        for (;;) {
+            cell = &lane.cells[pos & lane.mask];
+            int32_t dif = android_atomic_acquire_load(&cell->sequence) - pos;
+            if (dif == 0) {
+                if (android_atomic_release_cas(pos, pos + 1, &lane.enqueuePos) == 0)
+                    break;
+                pos = android_atomic_acquire_load(&lane.enqueuePos);
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = android_atomic_acquire_load(&lane.enqueuePos);
+            }
+        }
+
+        // the cell is ours until the sequence is published
+        cell->data = msg;
+        android_atomic_release_store((int32_t) msg.id, &cell->id);
+        android_atomic_inc(&mCount);
+        android_atomic_release_store(readyState(pos), &cell->state);
+        android_atomic_release_store(pos + 1, &cell->sequence);
+
+        *enqueued = pos;
+        return true;
+    }
+
+    // append to the spill list of a full lane
+    void spill(int laneIndex, const MessageType &msg)
+    {
+        Lane &lane = mLanes[laneIndex];
+        Mutex::Autolock lock(mSpillMutex);
+
+        if (lane.spill.empty())
+            ALOGW("Atom_MessageQueue: %s lane %d full, spilling", mName, laneIndex);
+
+        if (coalescing(msg.id)) {
+            drop(msg.id, android_atomic_acquire_load(&mIdLatest[msg.id]));
+            typename List<MessageType>::iterator it = lane.spill.begin();
+            while (it != lane.spill.end()) {
+                if (it->id == msg.id) {
+                    it = lane.spill.erase(it);
+                    android_atomic_dec(&lane.spilled);
+                    android_atomic_dec(&mCount);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        lane.spill.push_back(msg);
+        android_atomic_inc(&mCount);
+        android_atomic_inc(&lane.spilled);
+    }
+
+    // take the oldest spilled message, once the ring of the lane is empty
+    bool unspill(Lane &lane, MessageType *msg)
+    {
+        Mutex::Autolock lock(mSpillMutex);
+        if (lane.spill.empty())
+            return false;
+        *msg = *lane.spill.begin();
+        lane.spill.erase(lane.spill.begin());
+        android_atomic_dec(&lane.spilled);
+        android_atomic_dec(&mCount);
+        return true;
+    }
+
+    // mCount is not used as a shortcut: removed cells still have to be
+    // walked over to be recycled, even when nothing is pending
+    bool dequeue(MessageType *msg)
+    {
+        for (int i = 0; i < PRIORITY_NUM; i++) {
+            Lane &lane = mLanes[i];
+            for (;;) {
+                Cell *cell;
+                int32_t pos = android_atomic_acquire_load(&lane.dequeuePos);
+                for (;;) {
+                    cell = &lane.cells[pos & lane.mask];
+                    int32_t dif = android_atomic_acquire_load(&cell->sequence) - (pos + 1);
+                    if (dif == 0) {
+                        if (android_atomic_release_cas(pos, pos + 1, &lane.dequeuePos) == 0)
+                            break;
+                        pos = android_atomic_acquire_load(&lane.dequeuePos);
+                    } else if (dif < 0) {
+                        cell = NULL;
+                        break;
+                    } else {
+                        pos = android_atomic_acquire_load(&lane.dequeuePos);
+                    }
+                }
+                if (cell == NULL)
+                    break; // ring empty
+
+                // removed or coalesced cells are only recycled here
+                bool taken = false;
+                for (;;) {
+                    int32_t state = android_atomic_acquire_load(&cell->state);
+                    if (state & STATE_BUSY) {
+                        sched_yield(); // remove() is copying the message
+                        continue;
+                    }
+                    if (state & STATE_READY) {
+                        if (android_atomic_acquire_cas(state, state & ~STATE_READY, &cell->state) != 0)
+                            continue;
+                        *msg = cell->data;
+                        android_atomic_dec(&mCount);
+                        taken = true;
+                    }
+                    break;
+                }
+                android_atomic_release_store(pos + lane.mask + 1, &cell->sequence);
+                if (taken)
+                    return true;
+            }
+            if (android_atomic_acquire_load(&lane.spilled) && unspill(lane, msg))
+                return true;
+        }
+        return false;
+    }
+
+    // Recycle the oldest cell of a full lane if it was removed, so that
+    // remove() and coalescing free room even while nobody receives
+    bool reclaim(int laneIndex)
+    {
+        Lane &lane = mLanes[laneIndex];
+        int32_t pos = android_atomic_acquire_load(&lane.dequeuePos);
+        Cell *cell = &lane.cells[pos & lane.mask];
+        if (android_atomic_acquire_load(&cell->sequence) != pos + 1 ||
+            (android_atomic_acquire_load(&cell->state) & (STATE_READY | STATE_BUSY)))
+            return false;
+        // the cell can only become ready again once recycled
+        if (android_atomic_release_cas(pos, pos + 1, &lane.dequeuePos) != 0)
+            return true; // someone else moved the head, retry
+        android_atomic_release_store(pos + lane.mask + 1, &cell->sequence);
+        return true;
+    }
+
+    // keep the newest of the message of @id just sent at @pos and the
+    // latest one recorded, drop the other. Racing senders of the same id
+    // may record their positions out of order: the older one must lose.
+    void coalesce(MessageId id, int32_t pos)
+    {
+        for (;;) {
+            int32_t old = android_atomic_acquire_load(&mIdLatest[id]);
+            if ((int32_t) ((uint32_t) pos - (uint32_t) old) < 0) {
+                drop(id, pos);
+                return;
+            }
+            if (android_atomic_release_cas(old, pos, &mIdLatest[id]) == 0) {
+                drop(id, old);
+                return;
+            }
+        }
+    }
+
+    // mark the message of @id sent at @pos as removed, if still pending
+    void drop(MessageId id, int32_t pos)
+    {
+        Lane &lane = mLanes[mIdPriority[id]];
+        Cell &cell = lane.cells[pos & lane.mask];
+        int32_t state = readyState(pos);
+        if (android_atomic_acquire_load(&cell.state) == state &&
+            android_atomic_release_cas(state, state & ~STATE_READY, &cell.state) == 0) {
+            android_atomic_dec(&mCount);
+        }
+    }
+
+    void wakeReceiver()
+    {
+        // read-modify-write, orders the publish before the check
+        if (android_atomic_or(0, &mSleeping)) {
+            mSleepMutex.lock();
+            mSleepCondition.signal();
+            mSleepMutex.unlock();
+        }
+    }
+
+    // private data
+private:
     const char *mName;
-    Mutex mQueueMutex;
-    Condition mQueueCondition;
-    List<MessageType> mList;
+    Lane mLanes[PRIORITY_NUM];
+    volatile int32_t mCount;
+
+    Mutex mSleepMutex;
+    Condition mSleepCondition;
+    volatile int32_t mSleeping;
+
+    Mutex mSpillMutex;
 
     int mNumReply;
     Mutex *mReplyMutex;
     Condition *mReplyCondition;
     status_t *mReplyStatus;
+    int32_t *mIdPriority;
+    bool *mIdCoalescing;
+    volatile int32_t *mIdLatest;
 
 }; // class MessageQueue
 
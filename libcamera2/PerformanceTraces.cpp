@@ -35,12 +35,14 @@ namespace PerformanceTraces {
 class PerformanceTimer {
 
 public:
+    const char *mName;       //!< name of the span in the TraceRecorder
     nsecs_t mStartAt;
     nsecs_t mLastRead;
     bool mFilled;            //!< timestamp has been taken
     bool mRequested;         //!< trace is requested/enabled
 
-    PerformanceTimer(void) :
+    PerformanceTimer(const char *name) :
+        mName(name),
         mStartAt(0),
         mLastRead(0),
         mFilled(false),
@@ -76,22 +78,41 @@ public:
     void start(void) {
         mStartAt = mLastRead = systemTime();
         mFilled = true;
+        CAMERA_TRACE_EVENT(TraceRecorder::EVENT_ASYNC_BEGIN, mName, NULL, -1);
     }
 
-    void stop(void) { mFilled = false; }
+    void stop(void) {
+        if (mFilled)
+            CAMERA_TRACE_EVENT(TraceRecorder::EVENT_ASYNC_END, mName, NULL, -1);
+        mFilled = false;
+    }
 
 };
 
-static PerformanceTimer gLaunch2Preview;
-static PerformanceTimer gLaunch2FocusLock;
-static PerformanceTimer gFaceLock;
-static PerformanceTimer gShot2Shot;
-static PerformanceTimer gShutterLag;
-static PerformanceTimer gSwitchCameras;
-static PerformanceTimer gAAAProfiler;
-static PerformanceTimer gPnPBreakdown;
-static PerformanceTimer gHDRShot2Preview;
-static PerformanceTimer gIOBreakdown;
+/**
+ * True when the trace points go to the TraceRecorder instead of the log
+ */
+static inline bool recording(void)
+{
+#ifdef CAMERA_TRACE_RECORDER
+    return TraceRecorder::isEnabled();
+#else
+    return false;
+#endif
+}
+
+static const char *TRACE_RECORDER_FILE = "/data/camera_trace.json";
+
+static PerformanceTimer gLaunch2Preview("Launch2Preview");
+static PerformanceTimer gLaunch2FocusLock("Launch2FocusLock");
+static PerformanceTimer gFaceLock("FaceLock");
+static PerformanceTimer gShot2Shot("Shot2Shot");
+static PerformanceTimer gShutterLag("ShutterLag");
+static PerformanceTimer gSwitchCameras("SwitchCameras");
+static PerformanceTimer gAAAProfiler("AAAProfiler");
+static PerformanceTimer gPnPBreakdown("PnPBreakdown");
+static PerformanceTimer gHDRShot2Preview("HDRShot2Preview");
+static PerformanceTimer gIOBreakdown("IOBreakdown");
 
 static int gFaceLockFrame = -1;
 static bool gHDRCalled = false;
@@ -129,7 +150,20 @@ void reset(void)
     gShutterLag.mRequested = false;
     gSwitchCameras.mRequested = false;
     gLaunch2FocusLock.mRequested = false;
+#ifdef CAMERA_TRACE_RECORDER
+    TraceRecorder::enable(false);
+#endif
+}
 
+/**
+ * Writes the events of the TraceRecorder out, if it is recording
+ */
+void exportTraces(void)
+{
+#ifdef CAMERA_TRACE_RECORDER
+    if (recording())
+        TraceRecorder::exportJson(TRACE_RECORDER_FILE);
+#endif
 }
 /**
  * Controls trace state
@@ -453,6 +487,10 @@ void PnPBreakdown::start(void)
 void PnPBreakdown::step(const char *func, const char* note, const int mFrameNum)
 {
     if (gPnPBreakdown.isRunning()) {
+        if (recording()) {
+            CAMERA_TRACE_EVENT(TraceRecorder::EVENT_INSTANT, func, note, mFrameNum);
+            return;
+        }
         if (!note)
             note = "";
         if (mFrameNum < 0)
@@ -522,11 +560,20 @@ void HDRShot2Preview::stop(void)
  *
  * @arg func, the function name which called it.
  * @arg note, a string printed with IOCTL information.
+ * @arg enabled, false makes the object a no-op.
  */
-IOBreakdown::IOBreakdown(const char *func, const char *note):
+IOBreakdown::IOBreakdown(const char *func, const char *note, bool enabled):
  mFuncName(func)
 ,mNote(note)
-{
+,mEnabled(enabled)
+,mRecorded(enabled && recording())
+{
+    if (!mEnabled)
+        return;
+    if (mRecorded) {
+        CAMERA_TRACE_EVENT(TraceRecorder::EVENT_BEGIN, func, note, -1);
+        return;
+    }
     if (gIOBreakdown.isRunning()) {
         gIOBreakdown.timeUs();
         gIOBreakdown.lastTimeUs();
@@ -536,6 +583,8 @@ IOBreakdown::IOBreakdown(const char *func, const char *note):
 IOBreakdown::~IOBreakdown()
 {
     char memData[MEM_DATA_LEN]={0};
+    if (!mEnabled)
+        return;
     if (!mNote)
         mNote = "";
     if (mMemInfoEnabled) {
@@ -558,8 +607,11 @@ IOBreakdown::~IOBreakdown()
         mMemMutex.unlock();
     }
 
-    ALOGD("IOBreakdown-step %s:%s, Time: %lld us, Diff: %lld us",
-             mFuncName, mNote, gIOBreakdown.timeUs(), gIOBreakdown.lastTimeUs());
+    if (mRecorded)
+        CAMERA_TRACE_EVENT(TraceRecorder::EVENT_END, mFuncName, NULL, -1);
+    else
+        ALOGD("IOBreakdown-step %s:%s, Time: %lld us, Diff: %lld us",
+                 mFuncName, mNote, gIOBreakdown.timeUs(), gIOBreakdown.lastTimeUs());
 }
 
 /**
@@ -20,6 +20,7 @@
 #include <utils/threads.h>
 #include "LogHelper.h"
 #include "PlatformData.h"
+#include "TraceRecorder.h"
 
 namespace android {
 
@@ -36,6 +37,9 @@ namespace android {
  * to be postprocessed for analysis.
  *
  * This code should be disabled in product builds.
+ *
+ * With the TraceRecorder enabled, the spans and steps of these traces
+ * are recorded there instead of being logged, see exportTraces().
  */
 namespace PerformanceTraces {
 
@@ -115,7 +119,7 @@ namespace PerformanceTraces {
 
   class IOBreakdown {
   public:
-    IOBreakdown(const char*, const char*);
+    IOBreakdown(const char*, const char*, bool enabled = true);
     ~IOBreakdown();
   public:
     static void start(void);
@@ -125,6 +129,8 @@ namespace PerformanceTraces {
   private:
     const char *mFuncName;
     const char *mNote;
+    bool mEnabled;
+    bool mRecorded;
     static bool mMemInfoEnabled;
     static int mPipeFD;
     static int mDbgFD;
@@ -138,6 +144,12 @@ namespace PerformanceTraces {
    */
   void reset(void);
 
+  /**
+   * Helper function to write the events of the TraceRecorder to
+   * /data/camera_trace.json, when it is recording
+   */
+  void exportTraces(void);
+
  /**
    * Helper macro to call PerformanceTraces::Breakdown::step() with
    * the proper function name, and pass additional arguments.
@@ -223,11 +235,16 @@ namespace PerformanceTraces {
   #define PERFORMANCE_TRACES_IO_STOP() \
       PerformanceTraces::IOBreakdown::stop();
 
+  #define PERFORMANCE_TRACES_EXPORT() \
+      PerformanceTraces::exportTraces();
+
+  /**
+   * Helper macro to trace an IO call, from here to the end of the
+   * enclosing block: put it in the same block as the call.
+   */
   #define PERFORMANCE_TRACES_IO_BREAKDOWN(note) \
-  { \
-      if (gPerfLevel & CAMERA_DEBUG_LOG_PERF_IO_BREAKDOWN) \
-          PerformanceTraces::IOBreakdown p(__FUNCTION__, note); \
-  }
+      PerformanceTraces::IOBreakdown _ioBreakdown(__FUNCTION__, note, \
+              (gPerfLevel & CAMERA_DEBUG_LOG_PERF_IO_BREAKDOWN) != 0)
 }; // ns PerformanceTraces
 }; // ns android
 
@@ -2130,9 +2130,15 @@ void PreviewThread::copyPreviewBuffer(AtomBuffer* src, AtomBuffer* dst)
                        (const char*)src->dataPtr,               // source image
                        (char *)dst->dataPtr);                 // target image
         break;
+    case 180:
     case 270:
-        // TODO: Not handled, waiting for Semi
-        ALOGE("@%s: 270 case not handled", __FUNCTION__);
+        nv12rotate(mRotation,
+                   src->width,
+                   src->height,
+                   src->bpl,
+                   dst->bpl,
+                   (const char*)src->dataPtr,
+                   (char *)dst->dataPtr);
         break;
     case 0:
         memcpy((char *)dst->dataPtr, (const char*)src->dataPtr, dst->size);
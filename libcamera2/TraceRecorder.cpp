@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2014 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define LOG_TAG "Camera_TraceRecorder"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <cutils/atomic.h>
+#include <utils/threads.h>
+#include <utils/Timers.h>
+#include "LogHelper.h"
+#include "TraceRecorder.h"
+
+namespace android {
+
+struct TraceRecorder::Event {
+    nsecs_t timestamp;
+    const char *name;
+    const char *note;
+    int32_t value;
+    int32_t tid;
+    char type;
+};
+
+/**
+ * Only the owner thread writes events and mHead. The exporter reads them
+ * concurrently and drops what may have been overwritten while it copied,
+ * so a ring which wrapped exports its last RING_SIZE - 1 events.
+ * Rings are never freed: the ring of a thread which exited is given to a
+ * new thread, once exported or when there are MAX_RINGS rings already.
+ */
+struct TraceRecorder::Ring {
+    volatile int32_t mHead;     // events recorded, wraps at 2^32
+    uint32_t mExported;         // mHead at the previous export
+    int32_t mTid;
+    bool mAttached;
+    char mThreadName[17];
+    Ring *mNext;
+    Event mEvents[RING_SIZE];
+};
+
+static const int MAX_RINGS = 64;
+
+bool TraceRecorder::sEnabled = false;
+const uint32_t TraceRecorder::RING_SIZE;
+
+static pthread_once_t sKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t sRingKey;
+static Mutex sRingsLock;                 // protects the list and mAttached
+static TraceRecorder::Ring *sRings = NULL;
+static int sRingCount = 0;
+
+void TraceRecorder::createKey()
+{
+    pthread_key_create(&sRingKey, detachRing);
+}
+
+void TraceRecorder::enable(bool set)
+{
+    if (set)
+        pthread_once(&sKeyOnce, createKey);
+    sEnabled = set;
+}
+
+/**
+ * Gives a ring to the calling thread, the first time it records.
+ */
+TraceRecorder::Ring *TraceRecorder::attachRing()
+{
+    Mutex::Autolock _l(sRingsLock);
+
+    // keep the events of exited threads until exported, if possible
+    Ring *ring = NULL;
+    Ring *detached = NULL;
+    for (Ring *r = sRings; r != NULL && ring == NULL; r = r->mNext) {
+        if (r->mAttached)
+            continue;
+        if (r->mExported == (uint32_t) r->mHead)
+            ring = r;
+        else if (detached == NULL)
+            detached = r;
+    }
+    if (ring == NULL && sRingCount >= MAX_RINGS)
+        ring = detached;
+
+    if (ring == NULL) {
+        ring = (Ring *) calloc(1, sizeof(Ring));
+        if (ring == NULL) {
+            ALOGE("@%s: no memory for a trace ring", __FUNCTION__);
+            return NULL;
+        }
+        ring->mNext = sRings;
+        sRings = ring;
+        sRingCount++;
+    }
+
+    ring->mAttached = true;
+    ring->mTid = (int32_t) syscall(__NR_gettid);
+    memset(ring->mThreadName, 0, sizeof(ring->mThreadName));
+    prctl(PR_GET_NAME, (unsigned long) ring->mThreadName, 0, 0, 0);
+    pthread_setspecific(sRingKey, ring);
+    return ring;
+}
+
+/**
+ * pthread key destructor, the thread exits.
+ */
+void TraceRecorder::detachRing(void *ring)
+{
+    Mutex::Autolock _l(sRingsLock);
+    ((Ring *) ring)->mAttached = false;
+}
+
+void TraceRecorder::record(char type, const char *name, const char *note, int32_t value)
+{
+    Ring *ring = (Ring *) pthread_getspecific(sRingKey);
+    if (ring == NULL) {
+        ring = attachRing();
+        if (ring == NULL)
+            return;
+    }
+
+    uint32_t head = (uint32_t) ring->mHead;
+    Event &e = ring->mEvents[head & (RING_SIZE - 1)];
+    e.timestamp = systemTime();
+    e.name = name;
+    e.note = note;
+    e.value = value;
+    e.tid = ring->mTid;
+    e.type = type;
+    android_atomic_release_store((int32_t) (head + 1), &ring->mHead);
+}
+
+static void writeString(FILE *fp, const char *str)
+{
+    fputc('"', fp);
+    for (; *str; str++) {
+        unsigned char c = *str;
+        if (c == '"' || c == '\\')
+            fprintf(fp, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(fp, "\\u%04x", c);
+        else
+            fputc(c, fp);
+    }
+    fputc('"', fp);
+}
+
+int TraceRecorder::exportJson(const char *path)
+{
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL) {
+        ALOGE("@%s: cannot open %s", __FUNCTION__, path);
+        return UNKNOWN_ERROR;
+    }
+
+    Mutex::Autolock _l(sRingsLock);
+    Event *copy = (Event *) malloc(RING_SIZE * sizeof(Event));
+    if (copy == NULL) {
+        fclose(fp);
+        return NO_MEMORY;
+    }
+
+    const int pid = getpid();
+    const char *separator = "";
+    int count = 0;
+    fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+    for (Ring *ring = sRings; ring != NULL; ring = ring->mNext) {
+        uint32_t head = (uint32_t) android_atomic_acquire_load(&ring->mHead);
+        uint32_t start = head - ring->mExported > RING_SIZE ? head - RING_SIZE : ring->mExported;
+        for (uint32_t i = start; i != head; i++)
+            copy[i - start] = ring->mEvents[i & (RING_SIZE - 1)];
+
+        // the owner may have overwritten the oldest ones meanwhile
+        uint32_t first = start;
+        uint32_t after = (uint32_t) android_atomic_acquire_load(&ring->mHead);
+        if (after - start >= RING_SIZE)
+            first = after - RING_SIZE + 1;
+        ring->mExported = head;
+
+        fprintf(fp, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                "\"args\":{\"name\":", separator, pid, ring->mTid);
+        writeString(fp, ring->mThreadName);
+        fprintf(fp, "}}");
+        separator = ",";
+
+        for (uint32_t i = first; (int32_t) (head - i) > 0; i++) {
+            const Event &e = copy[i - start];
+            fprintf(fp, "%s\n{\"name\":", separator);
+            writeString(fp, e.name ? e.name : "");
+            fprintf(fp, ",\"cat\":\"camera\",\"ph\":\"%c\",\"ts\":%lld.%03d,\"pid\":%d,\"tid\":%d",
+                    e.type, (long long) (e.timestamp / 1000), (int) (e.timestamp % 1000),
+                    pid, e.tid);
+            switch (e.type) {
+            case EVENT_ASYNC_BEGIN:
+            case EVENT_ASYNC_END:
+                fprintf(fp, ",\"id\":");
+                writeString(fp, e.name ? e.name : "");
+                break;
+            case EVENT_INSTANT:
+                fprintf(fp, ",\"s\":\"t\"");
+                break;
+            case EVENT_COUNTER:
+                fprintf(fp, ",\"args\":{\"value\":%d}}", e.value);
+                separator = ",";
+                count++;
+                continue;
+            default:
+                break;
+            }
+            if (e.note != NULL || e.value >= 0) {
+                fprintf(fp, ",\"args\":{");
+                if (e.note != NULL) {
+                    fprintf(fp, "\"note\":");
+                    writeString(fp, e.note);
+                }
+                if (e.value >= 0)
+                    fprintf(fp, "%s\"frame\":%d", e.note != NULL ? "," : "", e.value);
+                fputc('}', fp);
+            }
+            fputc('}', fp);
+            separator = ",";
+            count++;
+        }
+    }
+
+    fprintf(fp, "\n]}\n");
+    free(copy);
+    if (fclose(fp) != 0) {
+        ALOGE("@%s: cannot write %s", __FUNCTION__, path);
+        return UNKNOWN_ERROR;
+    }
+    LOG1("@%s: %d events to %s", __FUNCTION__, count, path);
+    return count;
+}
+
+} // namespace android
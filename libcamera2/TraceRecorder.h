@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2014 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBCAMERA_TRACE_RECORDER_H
+#define ANDROID_LIBCAMERA_TRACE_RECORDER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <utils/Errors.h>
+
+namespace android {
+
+/**
+ * \class TraceRecorder
+ *
+ * Per thread ring buffers of timestamped trace events, the common
+ * recorder underneath PerformanceTraces.
+ *
+ * record() stores one event into the ring of the calling thread: no lock,
+ * no allocation once the thread has its ring, no formatting. When a ring
+ * is full the oldest events of that thread are overwritten. Names and
+ * notes are not copied, they must be string literals or __FUNCTION__.
+ *
+ * exportJson() writes the events recorded since the previous export in
+ * the Chrome trace event format, which chrome://tracing and the Perfetto
+ * UI open directly.
+ *
+ * The recorder only exists in builds with CAMERA_TRACE_RECORDER defined
+ * (USE_CAMERA_TRACE_RECORDER := true); elsewhere the CAMERA_TRACE_*
+ * macros compile to nothing. At run time it is enabled by the
+ * CAMERA_DEBUG_LOG_PERF_TRACES_RECORDER bit of camera.hal.perf.
+ */
+class TraceRecorder {
+
+// public types
+public:
+    enum EventType {
+        EVENT_BEGIN = 'B',          // span on one thread, nests
+        EVENT_END = 'E',
+        EVENT_ASYNC_BEGIN = 'b',    // span which may end on another thread,
+        EVENT_ASYNC_END = 'e',      // matched by name
+        EVENT_INSTANT = 'i',
+        EVENT_COUNTER = 'C'
+    };
+
+    static const uint32_t RING_SIZE = 4096;  // events per thread, power of 2
+
+    struct Event;   // private to TraceRecorder.cpp
+    struct Ring;
+
+// public methods
+public:
+    static void enable(bool set);
+    static bool isEnabled() { return sEnabled; }
+
+    /**
+     * Records an event of @type on the calling thread.
+     * \param note optional text shown with the event, or NULL
+     * \param value counter value, or frame number of the event
+     */
+    static void record(char type, const char *name, const char *note = NULL,
+                       int32_t value = -1);
+
+    /**
+     * Writes the events recorded since the previous export to @path.
+     * \return number of events written, or a negative error
+     */
+    static int exportJson(const char *path);
+
+// private methods
+private:
+    static Ring *attachRing();
+    static void detachRing(void *ring);
+    static void createKey();
+
+// private data
+private:
+    static bool sEnabled;
+};
+
+/**
+ * \class TraceScope
+ *
+ * Records a span for the lifetime of the object, see CAMERA_TRACE_SCOPE.
+ */
+class TraceScope {
+public:
+    TraceScope(const char *name, const char *note = NULL) :
+        mName(TraceRecorder::isEnabled() ? name : NULL) {
+        if (mName)
+            TraceRecorder::record(TraceRecorder::EVENT_BEGIN, mName, note);
+    }
+    ~TraceScope() {
+        if (mName)
+            TraceRecorder::record(TraceRecorder::EVENT_END, mName);
+    }
+private:
+    const char *mName;
+};
+
+#define CAMERA_TRACE_CONCAT2(a, b) a##b
+#define CAMERA_TRACE_CONCAT(a, b) CAMERA_TRACE_CONCAT2(a, b)
+
+#ifdef CAMERA_TRACE_RECORDER
+
+#define CAMERA_TRACE_EVENT(type, name, note, value) \
+    do { \
+        if (TraceRecorder::isEnabled()) \
+            TraceRecorder::record(type, name, note, value); \
+    } while (0)
+
+/**
+ * Span from here to the end of the enclosing block.
+ */
+#define CAMERA_TRACE_SCOPE(name) \
+    TraceScope CAMERA_TRACE_CONCAT(_traceScope, __LINE__)(name)
+
+#else
+
+#define CAMERA_TRACE_EVENT(type, name, note, value) do { } while (0)
+#define CAMERA_TRACE_SCOPE(name) do { } while (0)
+
+#endif // CAMERA_TRACE_RECORDER
+
+#define CAMERA_TRACE_INSTANT(name) \
+    CAMERA_TRACE_EVENT(TraceRecorder::EVENT_INSTANT, name, NULL, -1)
+
+#define CAMERA_TRACE_COUNTER(name, value) \
+    CAMERA_TRACE_EVENT(TraceRecorder::EVENT_COUNTER, name, NULL, value)
+
+} // namespace android
+
+#endif // ANDROID_LIBCAMERA_TRACE_RECORDER_H
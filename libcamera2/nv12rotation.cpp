@@ -13,393 +13,455 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
-// TODO:
-// 1. add macroblock support for UV
-// 2. test optimal reading direction for top & right when (ROWS|COLUMNS)%MACROBLOCK
+
+#define LOG_TAG "Camera_NV12Rotation"
+
+#include <stdint.h>
+#include <pthread.h>
+#include <utils/Log.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#define NV12_ROTATION_X86 1
+#endif
+
 #include "nv12rotation.h"
-#include "AtomCommon.h"
-#include <cstdlib>
-
-#define STRIZE2(s) #s
-#define STRIZE(s) STRIZE2(s)
-
-
-bool genericRotateBy90(const int   width,
-                        const int   height,
-                        const int   rstride,
-                        const int   wstride,
-                        const char* sptr,
-                        char*       dptr);
-
-#define NV12_ROTATION_STRIDES(RSTRIDE, WSTRIDE, MACROBLOCK) \
-static void rotateXx4x##RSTRIDE##x##WSTRIDE##Y \
-    (const unsigned char* source, unsigned char* target, int columns) \
-    __attribute__ ((noinline)); \
-static void rotateXx4x##RSTRIDE##x##WSTRIDE##Y \
-    (const unsigned char* source, unsigned char* target, int columns) \
-{ \
-    const unsigned char* terminator = source + columns; \
- \
-    asm /*volatile*/ ( "\
-                    mov %0, %%esi;            \
-                    mov %1, %%edi;            \
-                    mov %2, %%ecx;            \
-                    .align 16;                \
-                    1:                        \
-                    movdqu                    (%%esi), %%xmm0; \
-                    movdqu "STRIZE(  RSTRIDE)"(%%esi), %%xmm1; \
-                    movdqu "STRIZE(2*RSTRIDE)"(%%esi), %%xmm2; \
-                    movdqu "STRIZE(3*RSTRIDE)"(%%esi), %%xmm3; \
-                                              \
-                    prefetchnta                     64(%%esi);  \
-                    prefetchnta "STRIZE(  RSTRIDE+64)"(%%esi);  \
-                    prefetchnta "STRIZE(2*RSTRIDE+64)"(%%esi);  \
-                    prefetchnta "STRIZE(3*RSTRIDE+64)"(%%esi);  \
-                                              \
-                    add $16, %%esi;           \
-                                              \
-                                              \
-                    movdqa %%xmm1, %%xmm4;    \
-                    movdqa %%xmm3, %%xmm5;    \
-                    punpcklbw %%xmm0, %%xmm4; \
-                    punpcklbw %%xmm2, %%xmm5; \
-                                              \
-                    movdqa %%xmm1, %%xmm6;    \
-                    movdqa %%xmm3, %%xmm7;    \
-                    punpckhbw %%xmm0, %%xmm6; \
-                    punpckhbw %%xmm2, %%xmm7; \
-                                              \
-                    movdqa %%xmm5, %%xmm0;    \
-                    punpckhwd %%xmm4, %%xmm5; \
-                    punpcklwd %%xmm4, %%xmm0; \
-                                              \
-                    movdqa %%xmm7, %%xmm2;    \
-                    punpckhwd %%xmm6, %%xmm7; \
-                    punpcklwd %%xmm6, %%xmm2; \
-                                              \
-                                              \
-                    movd %%xmm0,                     (%%edi); \
-                    movd %%xmm5, "STRIZE( 4*WSTRIDE)"(%%edi); \
-                    movd %%xmm2, "STRIZE( 8*WSTRIDE)"(%%edi); \
-                    movd %%xmm7, "STRIZE(12*WSTRIDE)"(%%edi); \
-                    psrldq $4, %%xmm0;        \
-                    psrldq $4, %%xmm5;        \
-                    psrldq $4, %%xmm2;        \
-                    psrldq $4, %%xmm7;        \
-                    movd %%xmm0, "STRIZE(   WSTRIDE)"(%%edi); \
-                    movd %%xmm5, "STRIZE( 5*WSTRIDE)"(%%edi); \
-                    movd %%xmm2, "STRIZE( 9*WSTRIDE)"(%%edi); \
-                    movd %%xmm7, "STRIZE(13*WSTRIDE)"(%%edi); \
-                    psrldq $4, %%xmm0;        \
-                    psrldq $4, %%xmm5;        \
-                    psrldq $4, %%xmm2;        \
-                    psrldq $4, %%xmm7;        \
-                    movd %%xmm0, "STRIZE( 2*WSTRIDE)"(%%edi); \
-                    movd %%xmm5, "STRIZE( 6*WSTRIDE)"(%%edi); \
-                    movd %%xmm2, "STRIZE(10*WSTRIDE)"(%%edi); \
-                    movd %%xmm7, "STRIZE(14*WSTRIDE)"(%%edi); \
-                    psrldq $4, %%xmm0;        \
-                    psrldq $4, %%xmm5;        \
-                    psrldq $4, %%xmm2;        \
-                    psrldq $4, %%xmm7;        \
-                    movd %%xmm0, "STRIZE( 3*WSTRIDE)"(%%edi); \
-                    movd %%xmm5, "STRIZE( 7*WSTRIDE)"(%%edi); \
-                    movd %%xmm2, "STRIZE(11*WSTRIDE)"(%%edi); \
-                    movd %%xmm7, "STRIZE(15*WSTRIDE)"(%%edi); \
-                                              \
-                                              \
-                    cmp %%esi, %%ecx;         \
-                    lea "STRIZE(16*WSTRIDE)"(%%edi), %%edi;   \
-                                              \
-                    jne 1b;                   \
-                    " \
-                 : \
-                 : "g"(source), "g"(target), "m"(terminator) \
-                 : "%ecx", "%esi", "%edi", "memory" \
-                 ); \
+
+// The image is rotated plane by plane: the luma plane as 1 byte elements,
+// the interleaved chroma plane as 2 byte UV elements of half the size, so
+// the same code moves both.
+//
+// 90 and 270 degree rotations transpose square tiles of 16 bytes per row
+// (16x16 luma or 8x8 chroma elements) in SIMD registers. Tiles are walked
+// in blocks of BLOCK x BLOCK elements so that the source rows and target
+// columns of a block stay in L1. Rows and columns which do not fill a tile
+// are done with the scalar code.
+
+namespace {
+
+const int BLOCK = 64;   // elements, multiple of every tile size
+
+typedef void (*PlaneRotator)(int degrees, int w, int h,
+                             const uint8_t* src, int sstride,
+                             uint8_t* dst, int dstride);
+
+template <int E>
+inline void copyElement(uint8_t* d, const uint8_t* s)
+{
+    d[0] = s[0];
+    if (E == 2)
+        d[1] = s[1];
 }
-#include "nv12rotationgeometry.h"
-
-
-#define NV12_ROTATION_STRIDES(RSTRIDE, WSTRIDE, MACROBLOCK) \
-static void rotateXx4x##RSTRIDE##x##WSTRIDE##UV \
-    (const unsigned char* source, unsigned char* target) \
-    __attribute__ ((noinline)); \
-static void rotateXx4x##RSTRIDE##x##WSTRIDE##UV \
-    (const unsigned char* source, unsigned char* target, size_t columns) \
-{ \
-    const unsigned char* terminator = source + columns; \
- \
-    asm /*volatile*/ ( "\
-                    mov %0, %%esi;            \
-                    mov %1, %%edi;            \
-                    mov %2, %%ecx;            \
-                                              \
-                    .align 16;                \
-                    1:                        \
-                    movdqu    (%%esi), %%xmm0; \
-                    movdqu " STRIZE(RSTRIDE) "(%%esi), %%xmm1; \
-                                              \
-                    prefetchnta 64(%%esi);   \
-                    prefetchnta "STRIZE(RSTRIDE+64)"(%%esi);   \
-                                              \
-                    add $16, %%esi;           \
-                                              \
-                    movdqa %%xmm0, %%xmm3;    \
-                    movdqa %%xmm1, %%xmm2;    \
-                                              \
-                    punpcklwd %%xmm0, %%xmm1; \
-                    punpckhwd %%xmm3, %%xmm2; \
-                    movd %%xmm1,                    (%%edi); \
-                    movd %%xmm2, "STRIZE(4*WSTRIDE)"(%%edi); \
-                                              \
-                    psrldq $4, %%xmm1;        \
-                    psrldq $4, %%xmm2;        \
-                    movd %%xmm1, "STRIZE(  WSTRIDE)"(%%edi); \
-                    movd %%xmm2, "STRIZE(5*WSTRIDE)"(%%edi); \
-                                              \
-                    psrldq $4, %%xmm1;        \
-                    psrldq $4, %%xmm2;        \
-                    movd %%xmm1, "STRIZE(2*WSTRIDE)"(%%edi); \
-                    movd %%xmm2, "STRIZE(6*WSTRIDE)"(%%edi); \
-                                              \
-                    psrldq $4, %%xmm1;        \
-                    psrldq $4, %%xmm2;        \
-                    movd %%xmm1, "STRIZE(3*WSTRIDE)"(%%edi); \
-                    movd %%xmm2, "STRIZE(7*WSTRIDE)"(%%edi); \
-                                              \
-                    cmp %%esi, %%ecx;         \
-                    lea "STRIZE(8*WSTRIDE)"(%%edi), %%edi;   \
-                                              \
-                    jne 1b;                   \
-                    " \
-                 : \
-                 : "g"(source), "g"(target), "m"(terminator) \
-                 : "%ecx", "%esi", "%edi", "memory" \
-                 ); \
+
+// Rotates the source elements in [x0, x1) x [y0, y1) of a w x h plane
+template <int E>
+void rotateRegion(int degrees, int w, int h,
+                  const uint8_t* src, int sstride, uint8_t* dst, int dstride,
+                  int x0, int y0, int x1, int y1)
+{
+    for (int y = y0; y < y1; ++y) {
+        const uint8_t* s = src + y * sstride + x0 * E;
+        uint8_t* d;
+        int dstep;
+
+        switch (degrees) {
+        case 90:
+            d = dst + x0 * dstride + (h - 1 - y) * E;
+            dstep = dstride;
+            break;
+        case 180:
+            d = dst + (h - 1 - y) * dstride + (w - 1 - x0) * E;
+            dstep = -E;
+            break;
+        default: // 270
+            d = dst + (w - 1 - x0) * dstride + y * E;
+            dstep = -dstride;
+            break;
+        }
+
+        for (int x = x0; x < x1; ++x) {
+            copyElement<E>(d, s);
+            s += E;
+            d += dstep;
+        }
+    }
+}
+
+// Same, walking the region in blocks so that the target lines touched by
+// a block stay in cache
+template <int E>
+void rotateRegionBlocked(int degrees, int w, int h,
+                         const uint8_t* src, int sstride, uint8_t* dst, int dstride,
+                         int x0, int y0, int x1, int y1)
+{
+    for (int by = y0; by < y1; by += BLOCK) {
+        for (int bx = x0; bx < x1; bx += BLOCK) {
+            rotateRegion<E>(degrees, w, h, src, sstride, dst, dstride, bx, by,
+                            bx + BLOCK < x1 ? bx + BLOCK : x1,
+                            by + BLOCK < y1 ? by + BLOCK : y1);
+        }
+    }
+}
+
+template <int E>
+void rotatePlane_c(int degrees, int w, int h,
+                   const uint8_t* src, int sstride, uint8_t* dst, int dstride)
+{
+    if (degrees == 180)
+        rotateRegion<E>(degrees, w, h, src, sstride, dst, dstride, 0, 0, w, h);
+    else
+        rotateRegionBlocked<E>(degrees, w, h, src, sstride, dst, dstride, 0, 0, w, h);
+}
+
+#ifdef NV12_ROTATION_X86
+
+#define SSSE3 __attribute__((target("ssse3")))
+#define AVX2 __attribute__((target("avx2")))
+
+// Register transposes. One round of unpacks with in[i] and in[i + N/2]
+// rotates the bits of (register index, element index) by one, log2(N)
+// rounds swap them: the rows become the columns.
+
+SSSE3 inline void transpose16x16_u8(__m128i* r)
+{
+    __m128i o[16];
+    for (int round = 0; round < 4; ++round) {
+        for (int i = 0; i < 8; ++i) {
+            o[2 * i] = _mm_unpacklo_epi8(r[i], r[i + 8]);
+            o[2 * i + 1] = _mm_unpackhi_epi8(r[i], r[i + 8]);
+        }
+        for (int i = 0; i < 16; ++i)
+            r[i] = o[i];
+    }
 }
-#include "nv12rotationgeometry.h"
-
-
-#define NV12_ROTATION_STRIDES(RSTRIDE, WSTRIDE, MACROBLOCK) \
-static void rotate##MACROBLOCK##x4x##RSTRIDE##x##WSTRIDE##Y \
-    (const unsigned char* source, unsigned char* target) \
-    __attribute__ ((noinline)); \
-static void rotate##MACROBLOCK##x4x##RSTRIDE##x##WSTRIDE##Y \
-    (const unsigned char* source, unsigned char* target) \
-{ \
-    const unsigned char* terminator = source + MACROBLOCK; \
- \
-    asm /*volatile*/ ( "\
-                    mov %0, %%esi;            \
-                    mov %1, %%edi;            \
-                    mov %2, %%ecx;            \
-                    .align 16;                \
-                    1:                        \
-                    movdqu                    (%%esi), %%xmm0; \
-                    movdqu "STRIZE(  RSTRIDE)"(%%esi), %%xmm1; \
-                    movdqu "STRIZE(2*RSTRIDE)"(%%esi), %%xmm2; \
-                    movdqu "STRIZE(3*RSTRIDE)"(%%esi), %%xmm3; \
-                                              \
-                    prefetchnta                     64(%%esi);  \
-                    prefetchnta "STRIZE(  RSTRIDE+64)"(%%esi);  \
-                    prefetchnta "STRIZE(2*RSTRIDE+64)"(%%esi);  \
-                    prefetchnta "STRIZE(3*RSTRIDE+64)"(%%esi);  \
-                                              \
-                    add $16, %%esi;           \
-                                              \
-                                              \
-                    movdqa %%xmm1, %%xmm4;    \
-                    movdqa %%xmm3, %%xmm5;    \
-                    punpcklbw %%xmm0, %%xmm4; \
-                    punpcklbw %%xmm2, %%xmm5; \
-                                              \
-                    movdqa %%xmm1, %%xmm6;    \
-                    movdqa %%xmm3, %%xmm7;    \
-                    punpckhbw %%xmm0, %%xmm6; \
-                    punpckhbw %%xmm2, %%xmm7; \
-                                              \
-                    movdqa %%xmm5, %%xmm0;    \
-                    punpckhwd %%xmm4, %%xmm5; \
-                    punpcklwd %%xmm4, %%xmm0; \
-                                              \
-                    movdqa %%xmm7, %%xmm2;    \
-                    punpckhwd %%xmm6, %%xmm7; \
-                    punpcklwd %%xmm6, %%xmm2; \
-                                              \
-                                              \
-                    movd %%xmm0,                     (%%edi); \
-                    movd %%xmm5, "STRIZE( 4*WSTRIDE)"(%%edi); \
-                    movd %%xmm2, "STRIZE( 8*WSTRIDE)"(%%edi); \
-                    movd %%xmm7, "STRIZE(12*WSTRIDE)"(%%edi); \
-                    psrldq $4, %%xmm0;        \
-                    psrldq $4, %%xmm5;        \
-                    psrldq $4, %%xmm2;        \
-                    psrldq $4, %%xmm7;        \
-                    movd %%xmm0, "STRIZE(   WSTRIDE)"(%%edi); \
-                    movd %%xmm5, "STRIZE( 5*WSTRIDE)"(%%edi); \
-                    movd %%xmm2, "STRIZE( 9*WSTRIDE)"(%%edi); \
-                    movd %%xmm7, "STRIZE(13*WSTRIDE)"(%%edi); \
-                    psrldq $4, %%xmm0;        \
-                    psrldq $4, %%xmm5;        \
-                    psrldq $4, %%xmm2;        \
-                    psrldq $4, %%xmm7;        \
-                    movd %%xmm0, "STRIZE( 2*WSTRIDE)"(%%edi); \
-                    movd %%xmm5, "STRIZE( 6*WSTRIDE)"(%%edi); \
-                    movd %%xmm2, "STRIZE(10*WSTRIDE)"(%%edi); \
-                    movd %%xmm7, "STRIZE(14*WSTRIDE)"(%%edi); \
-                    psrldq $4, %%xmm0;        \
-                    psrldq $4, %%xmm5;        \
-                    psrldq $4, %%xmm2;        \
-                    psrldq $4, %%xmm7;        \
-                    movd %%xmm0, "STRIZE( 3*WSTRIDE)"(%%edi); \
-                    movd %%xmm5, "STRIZE( 7*WSTRIDE)"(%%edi); \
-                    movd %%xmm2, "STRIZE(11*WSTRIDE)"(%%edi); \
-                    movd %%xmm7, "STRIZE(15*WSTRIDE)"(%%edi); \
-                                              \
-                                              \
-                    cmp %%esi, %%ecx;         \
-                    lea "STRIZE(16*WSTRIDE)"(%%edi), %%edi;   \
-                                              \
-                    jne 1b;                   \
-                    "\
-                 :\
-                 : "g"(source), "g"(target), "m"(terminator)\
-                 : "%ecx", "%esi", "%edi", "memory"\
-                 );\
+
+SSSE3 inline void transpose8x8_u16(__m128i* r)
+{
+    __m128i o[8];
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 4; ++i) {
+            o[2 * i] = _mm_unpacklo_epi16(r[i], r[i + 4]);
+            o[2 * i + 1] = _mm_unpackhi_epi16(r[i], r[i + 4]);
+        }
+        for (int i = 0; i < 8; ++i)
+            r[i] = o[i];
+    }
 }
-#include "nv12rotationgeometry.h"
-
-
-#define NV12_ROTATION_STRIDES(RSTRIDE, WSTRIDE, MACROBLOCK) \
-static void rotate##MACROBLOCK##x##MACROBLOCK##x##RSTRIDE##x##WSTRIDE##Y \
-    (const unsigned char* source, unsigned char* target) \
-{ \
-    const unsigned char* s = source + (MACROBLOCK - 4) * RSTRIDE; \
-    unsigned char*       t = target; \
- \
-    for (int slices = MACROBLOCK / 4; slices > 0; --slices) { \
-        rotate##MACROBLOCK##x4x##RSTRIDE##x##WSTRIDE##Y(s, t); \
-        s -= 4 * RSTRIDE; \
-        t += 4; \
-    } \
+
+// lane-wise: two independent tiles side by side
+AVX2 inline void transpose16x16_u8_x2(__m256i* r)
+{
+    __m256i o[16];
+    for (int round = 0; round < 4; ++round) {
+        for (int i = 0; i < 8; ++i) {
+            o[2 * i] = _mm256_unpacklo_epi8(r[i], r[i + 8]);
+            o[2 * i + 1] = _mm256_unpackhi_epi8(r[i], r[i + 8]);
+        }
+        for (int i = 0; i < 16; ++i)
+            r[i] = o[i];
+    }
 }
-#include "nv12rotationgeometry.h"
-
-
-#define NV12_ROTATION_GEOMETRY(COLUMNS, ROWS, RSTRIDE, WSTRIDE, MACROBLOCK) \
-static void rotate##COLUMNS##x##ROWS##x##RSTRIDE##x##WSTRIDE##x##MACROBLOCK \
-    (const unsigned char* source, unsigned char* target) \
-{ \
-    const unsigned char* s; \
-    unsigned char*       t; \
- \
-    for (int row = 0; row < ROWS/MACROBLOCK; ++row) { \
-        s = source + ROWS * RSTRIDE - ((row + 1) * MACROBLOCK * RSTRIDE); \
-        t = target + row * MACROBLOCK; \
-        for (int col = 0; col < COLUMNS/MACROBLOCK; ++col) { \
-            rotate##MACROBLOCK##x##MACROBLOCK##x##RSTRIDE##x##WSTRIDE##Y(s, t); \
-            s += MACROBLOCK; \
-            t += MACROBLOCK * WSTRIDE; \
-        } \
-    } \
- \
-    if (ROWS % MACROBLOCK) { \
-        s = source; \
-        t = target + ROWS - 4; \
-        \
-        for (int row = 0; row < (ROWS % MACROBLOCK) / 4; ++row) { \
-            rotateXx4x##RSTRIDE##x##WSTRIDE##Y(s, t, COLUMNS); \
-            s += 4 * RSTRIDE; \
-            t -= 4; \
-        } \
-    } \
- \
-    if (COLUMNS % MACROBLOCK) { \
-        s = source \
-          + (ROWS % MACROBLOCK) * RSTRIDE + (COLUMNS - COLUMNS % MACROBLOCK); \
-        t = target \
-          + (COLUMNS - COLUMNS % MACROBLOCK) * WSTRIDE \
-          + (ROWS - ROWS % MACROBLOCK - 4); \
-        \
-        for (int row = 0; row < (ROWS - ROWS % MACROBLOCK) / 4; ++row) { \
-            rotateXx4x##RSTRIDE##x##WSTRIDE##Y(s, t, COLUMNS % MACROBLOCK); \
-            s += 4 * RSTRIDE; \
-            t -= 4; \
-        } \
-    } \
- \
-    s = source + RSTRIDE * ROWS; \
-    t = target + COLUMNS * WSTRIDE + (ROWS - 4); \
-    for (int rows = ROWS / 4; rows > 0; --rows) { \
-        rotateXx4x##RSTRIDE##x##WSTRIDE##UV(s, t, COLUMNS); \
-        s += 4 * RSTRIDE / 2; \
-        t -= 4; \
-    } \
+
+AVX2 inline void transpose8x8_u16_x2(__m256i* r)
+{
+    __m256i o[8];
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 4; ++i) {
+            o[2 * i] = _mm256_unpacklo_epi16(r[i], r[i + 4]);
+            o[2 * i + 1] = _mm256_unpackhi_epi16(r[i], r[i + 4]);
+        }
+        for (int i = 0; i < 8; ++i)
+            r[i] = o[i];
+    }
 }
-#include "nv12rotationgeometry.h"
 
+// Tile kernels: load T rows of 16 bytes from s, stepping sstep, and store
+// the T transposed rows at d, stepping dstep. The wide kernels do two
+// tiles side by side, the second one is stored T rows further.
 
-bool nv12rotateBy90(const int   width,
-                    const int   height,
-                    const int   rstride,
-                    const int   wstride,
-                    const char* sptr,
-                    char*       dptr)
+template <int E>
+SSSE3 void tile_ssse3(const uint8_t* s, int sstep, uint8_t* d, int dstep)
+{
+    const int T = 16 / E;
+    __m128i r[T];
+    for (int i = 0; i < T; ++i)
+        r[i] = _mm_loadu_si128((const __m128i*)(s + i * sstep));
+    if (E == 1)
+        transpose16x16_u8(r);
+    else
+        transpose8x8_u16(r);
+    for (int i = 0; i < T; ++i)
+        _mm_storeu_si128((__m128i*)(d + i * dstep), r[i]);
+}
+
+template <int E>
+AVX2 void wideTile_avx2(const uint8_t* s, int sstep, uint8_t* d, int dstep)
 {
-    bool rotated;
-
-#define NV12_ROTATION_GEOMETRY(COLUMNS, ROWS, RSTRIDE, WSTRIDE, MACROBLOCK) \
-    if (width == COLUMNS && height == ROWS && rstride == RSTRIDE && wstride == WSTRIDE) { \
-        rotate##COLUMNS##x##ROWS##x##RSTRIDE##x##WSTRIDE##x##MACROBLOCK \
-            ((const unsigned char*)sptr, (unsigned char*)dptr); \
-        rotated = true; \
-    } else
-#include "nv12rotationgeometry.h"
-    {
-         rotated = genericRotateBy90(width, height, rstride, wstride, sptr, dptr);
+    const int T = 16 / E;
+    __m256i r[T];
+    for (int i = 0; i < T; ++i)
+        r[i] = _mm256_loadu_si256((const __m256i*)(s + i * sstep));
+    if (E == 1)
+        transpose16x16_u8_x2(r);
+    else
+        transpose8x8_u16_x2(r);
+    for (int i = 0; i < T; ++i) {
+        _mm_storeu_si128((__m128i*)(d + i * dstep), _mm256_castsi256_si128(r[i]));
+        _mm_storeu_si128((__m128i*)(d + (T + i) * dstep), _mm256_extracti128_si256(r[i], 1));
     }
+}
+
+// Reverse kernels for 180 degrees: reverse the order of the elements of
+// 16 (or 32) bytes
 
-    return rotated;
+template <int E>
+SSSE3 void reverse_ssse3(const uint8_t* s, uint8_t* d)
+{
+    const __m128i mask = E == 1 ?
+        _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0) :
+        _mm_setr_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1);
+    __m128i v = _mm_loadu_si128((const __m128i*)s);
+    _mm_storeu_si128((__m128i*)d, _mm_shuffle_epi8(v, mask));
 }
 
-/**
- * Fall back rotation algorithm in case the resolution requested is not
- * optimized
- **/
-bool genericRotateBy90(const int   width,
-                        const int   height,
-                        const int   rstride,
-                        const int   wstride,
-                        const char* sptr,
-                        char*       dptr)
+template <int E>
+AVX2 void reverse_avx2(const uint8_t* s, uint8_t* d)
 {
-    int i,j;
-    char* a = (char*) sptr;
-    char* b = dptr;
+    const __m256i mask = E == 1 ?
+        _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                         15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0) :
+        _mm256_setr_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1,
+                         14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1);
+    __m256i v = _mm256_loadu_si256((const __m256i*)s);
+    v = _mm256_shuffle_epi8(v, mask);
+    _mm256_storeu_si256((__m256i*)d, _mm256_permute4x64_epi64(v, 0x4e));
+}
 
-    ALOGW("Unoptimized CPU rotation! "
-         "Disable overlay or optimize for this resolution(%dx%d)",width, height);
+typedef void (*TileKernel)(const uint8_t* s, int sstep, uint8_t* d, int dstep);
 
-    // Luma rotation
-    for (i = 0; i < width; i++) {
-        for (j = height-1; j >= 0 ; j--) {
-            b[height - j -1] = a[i + j*rstride];
+// Rotation by 90 or 270 degrees with tile kernels, @wide may be NULL.
+// The tile rows are laid out so that the target columns they write start
+// on a tile boundary, the leftover source rows are on the top for 90
+// degrees and on the bottom for 270 degrees.
+template <int E>
+void rotateTiles(int degrees, int w, int h,
+                 const uint8_t* src, int sstride, uint8_t* dst, int dstride,
+                 TileKernel tile, TileKernel wide)
+{
+    const int T = 16 / E;
+    const int wt = w - w % T;
+    const int y0 = degrees == 90 ? h % T : 0;
+    const int y1 = y0 + h - h % T;
+
+    for (int by = y0; by < y1; by += BLOCK) {
+        const int yEnd = by + BLOCK < y1 ? by + BLOCK : y1;
+        for (int bx = 0; bx < wt; bx += BLOCK) {
+            const int xEnd = bx + BLOCK < wt ? bx + BLOCK : wt;
+            for (int y = by; y < yEnd; y += T) {
+                // 90: read the rows bottom up, the first target row is column x
+                // 270: read the rows top down, the first target row is w - 1 - x
+                const uint8_t* s;
+                int sstep, dstep;
+                uint8_t* d;
+                int x = bx;
+                if (degrees == 90) {
+                    s = src + (y + T - 1) * sstride;
+                    sstep = -sstride;
+                    d = dst + (h - T - y) * E;
+                    dstep = dstride;
+                } else {
+                    s = src + y * sstride;
+                    sstep = sstride;
+                    d = dst + y * E;
+                    dstep = -dstride;
+                }
+                if (wide) {
+                    for (; x + 2 * T <= xEnd; x += 2 * T) {
+                        wide(s + x * E, sstep,
+                             d + (degrees == 90 ? x : w - 1 - x) * dstride, dstep);
+                    }
+                }
+                for (; x < xEnd; x += T) {
+                    tile(s + x * E, sstep,
+                         d + (degrees == 90 ? x : w - 1 - x) * dstride, dstep);
+                }
+            }
         }
-        b += wstride;
     }
 
-    a += rstride*height;
+    // leftover columns, then leftover rows
+    if (wt < w)
+        rotateRegionBlocked<E>(degrees, w, h, src, sstride, dst, dstride, wt, 0, w, h);
+    if (y0 > 0)
+        rotateRegionBlocked<E>(degrees, w, h, src, sstride, dst, dstride, 0, 0, wt, y0);
+    if (y1 < h)
+        rotateRegionBlocked<E>(degrees, w, h, src, sstride, dst, dstride, 0, y1, wt, h);
+}
+
+// 180 degrees: every row is reversed into the mirrored row
+template <int E>
+SSSE3 void rotate180_ssse3(int w, int h, const uint8_t* src, int sstride, uint8_t* dst, int dstride)
+{
+    const int N = 16 / E;
+    const int x0 = w % N;   // the target rows are written from their start
+
+    for (int y = 0; y < h; ++y) {
+        const uint8_t* s = src + y * sstride;
+        uint8_t* d = dst + (h - 1 - y) * dstride;
+        for (int x = x0; x < w; x += N)
+            reverse_ssse3<E>(s + x * E, d + (w - N - x) * E);
+    }
+    if (x0 > 0)
+        rotateRegion<E>(180, w, h, src, sstride, dst, dstride, 0, 0, x0, h);
+}
+
+template <int E>
+AVX2 void rotate180_avx2(int w, int h, const uint8_t* src, int sstride, uint8_t* dst, int dstride)
+{
+    const int N = 32 / E;
+    const int x0 = w % N;
 
-    //Chroma rotation
-    for (i = 0; i < width; i+=2) {
-        for (j = height; j > 0 ; j-=2) {
-            b[height -j] = a[i + (j/2-1)*rstride]; //U
-            b[height -j +1] = a[i+1 + (j/2 -1)*rstride]; //V
+    for (int y = 0; y < h; ++y) {
+        const uint8_t* s = src + y * sstride;
+        uint8_t* d = dst + (h - 1 - y) * dstride;
+        for (int x = x0; x < w; x += N)
+            reverse_avx2<E>(s + x * E, d + (w - N - x) * E);
+    }
+    if (x0 > 0)
+        rotate180_ssse3<E>(x0, h, src, sstride, dst + (w - x0) * E, dstride);
+}
+
+template <int E>
+void rotatePlane_ssse3(int degrees, int w, int h,
+                       const uint8_t* src, int sstride, uint8_t* dst, int dstride)
+{
+    if (degrees == 180)
+        rotate180_ssse3<E>(w, h, src, sstride, dst, dstride);
+    else
+        rotateTiles<E>(degrees, w, h, src, sstride, dst, dstride, tile_ssse3<E>, NULL);
+}
+
+template <int E>
+void rotatePlane_avx2(int degrees, int w, int h,
+                      const uint8_t* src, int sstride, uint8_t* dst, int dstride)
+{
+    if (degrees == 180)
+        rotate180_avx2<E>(w, h, src, sstride, dst, dstride);
+    else
+        rotateTiles<E>(degrees, w, h, src, sstride, dst, dstride, tile_ssse3<E>, wideTile_avx2<E>);
+}
+
+#endif // NV12_ROTATION_X86
+
+struct RotationKernels {
+    int isa;
+    const char* name;
+    PlaneRotator luma;
+    PlaneRotator chroma;
+};
+
+const RotationKernels sKernels[NV12_ROTATION_ISA_NUM] = {
+    { NV12_ROTATION_ISA_C, "c", rotatePlane_c<1>, rotatePlane_c<2> },
+#ifdef NV12_ROTATION_X86
+    { NV12_ROTATION_ISA_SSSE3, "ssse3", rotatePlane_ssse3<1>, rotatePlane_ssse3<2> },
+    { NV12_ROTATION_ISA_AVX2, "avx2", rotatePlane_avx2<1>, rotatePlane_avx2<2> },
+#endif
+};
+
+bool isaSupported(int isa)
+{
+    switch (isa) {
+    case NV12_ROTATION_ISA_C:
+        return true;
+#ifdef NV12_ROTATION_X86
+    case NV12_ROTATION_ISA_SSSE3:
+        return __builtin_cpu_supports("ssse3");
+    case NV12_ROTATION_ISA_AVX2:
+        // the AVX2 kernels finish rows with the SSSE3 tiles
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("ssse3");
+#endif
+    default:
+        return false;
+    }
+}
 
+pthread_once_t sKernelsOnce = PTHREAD_ONCE_INIT;
+const RotationKernels* sBestKernels = &sKernels[NV12_ROTATION_ISA_C];
 
+void selectKernels()
+{
+#ifdef NV12_ROTATION_X86
+    __builtin_cpu_init();
+#endif
+    for (int isa = NV12_ROTATION_ISA_NUM - 1; isa > NV12_ROTATION_ISA_C; --isa) {
+        if (isaSupported(isa)) {
+            sBestKernels = &sKernels[isa];
+            break;
         }
-        b = b + wstride;
     }
+    ALOGD("NV12 rotation kernels: %s", sBestKernels->name);
+}
+
+bool rotate(const RotationKernels* k, int degrees, int width, int height,
+            int rstride, int wstride, const char* sptr, char* dptr)
+{
+    if ((degrees != 90 && degrees != 180 && degrees != 270) ||
+        width <= 0 || height <= 0 || (width | height) & 1 || !sptr || !dptr) {
+        ALOGE("cannot rotate %dx%d by %d degrees", width, height, degrees);
+        return false;
+    }
+
+    const int dwidth = degrees == 180 ? width : height;
+    const int dheight = degrees == 180 ? height : width;
+    if (rstride < width || wstride < dwidth) {
+        ALOGE("bad strides %d, %d for %dx%d", rstride, wstride, width, height);
+        return false;
+    }
+
+    const uint8_t* src = (const uint8_t*) sptr;
+    uint8_t* dst = (uint8_t*) dptr;
+
+    k->luma(degrees, width, height, src, rstride, dst, wstride);
+    k->chroma(degrees, width / 2, height / 2,
+              src + rstride * height, rstride, dst + wstride * dheight, wstride);
     return true;
 }
+
+} // namespace
+
+bool nv12rotate(const int   degrees,
+                const int   width,
+                const int   height,
+                const int   rstride,
+                const int   wstride,
+                const char* sptr,
+                char*       dptr)
+{
+    pthread_once(&sKernelsOnce, selectKernels);
+    return rotate(sBestKernels, degrees, width, height, rstride, wstride, sptr, dptr);
+}
+
+bool nv12rotateIsa(const int   isa,
+                   const int   degrees,
+                   const int   width,
+                   const int   height,
+                   const int   rstride,
+                   const int   wstride,
+                   const char* sptr,
+                   char*       dptr)
+{
+    pthread_once(&sKernelsOnce, selectKernels);
+    if (isa < 0 || isa >= NV12_ROTATION_ISA_NUM || !isaSupported(isa))
+        return false;
+    return rotate(&sKernels[isa], degrees, width, height, rstride, wstride, sptr, dptr);
+}
+
+bool nv12rotateBy90(const int   width,
+                    const int   height,
+                    const int   rstride,
+                    const int   wstride,
+                    const char* sptr,
+                    char*       dptr)
+{
+    return nv12rotate(90, width, height, rstride, wstride, sptr, dptr);
+}
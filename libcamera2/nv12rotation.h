@@ -16,10 +16,40 @@
 #ifndef NV12ROTATION_H
 #define NV12ROTATION_H
 
-// nv12rotateBy90() is an optimized 90 degree rotation for a select
-// set of NV12 images. Since it can only rotate some image geometries,
-// the return value indicates whether the rotation was done or not.
-// Width, height, rstride and wstride parameters are in pixels.
+enum NV12RotationIsa {
+    NV12_ROTATION_ISA_C = 0,
+    NV12_ROTATION_ISA_SSSE3,
+    NV12_ROTATION_ISA_AVX2,
+    NV12_ROTATION_ISA_NUM
+};
+
+// nv12rotate() rotates an NV12 image clockwise by 90, 180 or 270 degrees,
+// with the best kernels the CPU supports (picked once on first use).
+// Any even width and height are supported. Width, height, rstride and
+// wstride parameters are in pixels. The chroma plane of the target image
+// follows its luma plane: wstride * width bytes after dptr for 90 and 270
+// degrees, wstride * height bytes for 180 degrees.
+// Returns false if the parameters are not supported.
+bool nv12rotate(const int   degrees, // 90, 180 or 270
+                const int   width,   // width of the source image
+                const int   height,  // height of the source image
+                const int   rstride, // scanline stride of the source image
+                const int   wstride, // scanline stride of the target image
+                const char* sptr,    // source image
+                char*       dptr);   // target image
+
+// Same as nv12rotate() with the kernels of a given NV12RotationIsa,
+// returns false if the CPU or the build does not support it.
+bool nv12rotateIsa(const int   isa,
+                   const int   degrees,
+                   const int   width,
+                   const int   height,
+                   const int   rstride,
+                   const int   wstride,
+                   const char* sptr,
+                   char*       dptr);
+
+// nv12rotateBy90() is nv12rotate() by 90 degrees, kept for existing users.
 bool nv12rotateBy90(const int   width,   // width of the source image
                     const int   height,  // height of the source image
                     const int   rstride, // scanline stride of the source image
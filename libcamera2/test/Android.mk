@@ -0,0 +1,105 @@
+# Build the MessageQueue contention benchmark.
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+	MessageQueueBenchmark.cpp
+
+LOCAL_SHARED_LIBRARIES := \
+	libcutils \
+	libutils \
+	liblog
+
+LOCAL_CFLAGS += -Wunused-variable -Werror -Wno-unused-parameter
+
+LOCAL_MODULE := camera_messagequeue_benchmark
+LOCAL_MODULE_TAGS := tests
+LOCAL_MULTILIB := 32
+
+include $(BUILD_EXECUTABLE)
+
+# host test of the background dump writer
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+	CameraDumpWriterTest.cpp \
+	../CameraDumpWriter.cpp
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+
+LOCAL_STATIC_LIBRARIES := \
+	libutils \
+	libcutils \
+	liblog
+
+LOCAL_LDLIBS := -lpthread
+
+LOCAL_MODULE := camera_dumpwriter_test
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# host test and benchmark of the NV12 rotation kernels
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+	NV12RotationTest.cpp \
+	../nv12rotation.cpp
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+
+LOCAL_STATIC_LIBRARIES := \
+	liblog
+
+LOCAL_LDLIBS := -lpthread
+
+LOCAL_MODULE := camera_nv12rotation_test
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# host test and benchmark of the camera profiles snapshot
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+	CameraProfilesSnapshotTest.cpp \
+	../CameraProfilesSnapshot.cpp
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/.. \
+	external/expat/lib
+
+LOCAL_STATIC_LIBRARIES := \
+	libexpat \
+	libutils \
+	libcutils \
+	liblog
+
+LOCAL_MODULE := camera_profiles_snapshot_test
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# host test and benchmark of the performance trace recorder
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+	TraceRecorderBenchmark.cpp \
+	../TraceRecorder.cpp
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+
+LOCAL_CFLAGS += -DCAMERA_TRACE_RECORDER
+
+LOCAL_STATIC_LIBRARIES := \
+	libutils \
+	libcutils \
+	liblog
+
+LOCAL_LDLIBS := -lpthread
+
+LOCAL_MODULE := camera_tracerecorder_benchmark
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_HOST_EXECUTABLE)
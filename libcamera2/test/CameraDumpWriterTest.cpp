@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host test of the background dump writer.
+ *
+ * Synthetic NV12 frames are dumped through CameraDumpWriter and read back,
+ * a burst larger than the ring checks that the oldest dumps are the ones
+ * dropped, a dump over the memory budget must not cost a pending dump its
+ * slot, and the cost of a dump on the calling thread is compared with
+ * the synchronous fopen/fwrite/fclose CameraDump used to do.
+ *
+ * usage: camera_dumpwriter_test [directory]
+ */
+
+#define LOG_TAG "Camera_DumpWriterTest"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../CameraDumpWriter.h"
+
+// normally defined by LogHelper.cpp
+int32_t gLogLevel = 0;
+int32_t gPerfLevel = 0;
+int32_t gPowerLevel = 0;
+int32_t gControlLevel = 0;
+
+using namespace android;
+
+static const int WIDTH = 1920;
+static const int HEIGHT = 1080;
+static const size_t FRAME_SIZE = WIDTH * HEIGHT * 3 / 2;
+
+static void fillFrame(unsigned char *frame, size_t size, int seed)
+{
+    for (size_t i = 0; i < size; i++)
+        frame[i] = (unsigned char) (i * 7 + seed);
+}
+
+static bool checkFile(const char *path, const unsigned char *header, size_t headerSize,
+                      const unsigned char *frame, size_t size)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        printf("%s: missing\n", path);
+        return false;
+    }
+
+    bool ok = true;
+    unsigned char *content = (unsigned char *) malloc(headerSize + size + 1);
+    size_t n = fread(content, 1, headerSize + size + 1, fp);
+    if (n != headerSize + size) {
+        printf("%s: %u bytes, expected %u\n", path, (unsigned) n, (unsigned) (headerSize + size));
+        ok = false;
+    } else if (memcmp(content, header, headerSize) || memcmp(content + headerSize, frame, size)) {
+        printf("%s: content differs\n", path);
+        ok = false;
+    }
+
+    free(content);
+    fclose(fp);
+    return ok;
+}
+
+// frames and a maker note like header come back intact, whatever their
+// size relative to the O_DIRECT block
+static int testContent(const char *dir)
+{
+    int errors = 0;
+    static const size_t sizes[] = { FRAME_SIZE, 4096, 4096 * 3 + 17, 1 };
+    const int count = sizeof(sizes) / sizeof(sizes[0]);
+    unsigned char header[1000];
+    unsigned char *frames[count];
+    char path[128];
+
+    fillFrame(header, sizeof(header), 99);
+
+    sp<CameraDumpWriter> writer = new CameraDumpWriter();
+    writer->run();
+    for (int i = 0; i < count; i++) {
+        frames[i] = (unsigned char *) malloc(sizes[i]);
+        fillFrame(frames[i], sizes[i], i);
+        snprintf(path, sizeof(path), "%s/dump_content_%d.nv12", dir, i);
+        // odd ones with a header
+        if (writer->queue(path, frames[i], sizes[i], i & 1 ? header : NULL,
+                          i & 1 ? sizeof(header) : 0) != NO_ERROR) {
+            printf("queue %s failed\n", path);
+            errors++;
+        }
+    }
+    writer->flush();
+
+    for (int i = 0; i < count; i++) {
+        snprintf(path, sizeof(path), "%s/dump_content_%d.nv12", dir, i);
+        if (!checkFile(path, header, i & 1 ? sizeof(header) : 0, frames[i], sizes[i]))
+            errors++;
+        unlink(path);
+        free(frames[i]);
+    }
+
+    CameraDumpWriter::Stats s = writer->getStats();
+    if (s.written != (uint32_t) count || s.dropped || s.failed) {
+        printf("content: %u written, %u dropped, %u failed\n", s.written, s.dropped, s.failed);
+        errors++;
+    }
+    writer->requestExitAndWait();
+
+    return errors;
+}
+
+// a burst faster than the storage loses old dumps, never the newest one
+static int testDropOldest(const char *dir)
+{
+    int errors = 0;
+    const int burst = 50;
+    char path[128];
+    unsigned char *frame = (unsigned char *) malloc(FRAME_SIZE);
+
+    sp<CameraDumpWriter> writer = new CameraDumpWriter(2);
+    writer->run();
+    for (int i = 0; i < burst; i++) {
+        fillFrame(frame, FRAME_SIZE, i);
+        snprintf(path, sizeof(path), "%s/dump_burst_%d.nv12", dir, i);
+        writer->queue(path, frame, FRAME_SIZE);
+    }
+    writer->requestExitAndWait();
+
+    CameraDumpWriter::Stats s = writer->getStats();
+    printf("burst of %d: %u written, %u dropped\n", burst, s.written, s.dropped);
+    if (s.written + s.dropped != (uint32_t) burst || s.failed) {
+        printf("burst: %u written + %u dropped != %d\n", s.written, s.dropped, burst);
+        errors++;
+    }
+
+    snprintf(path, sizeof(path), "%s/dump_burst_%d.nv12", dir, burst - 1);
+    if (!checkFile(path, NULL, 0, frame, FRAME_SIZE))
+        errors++;
+
+    for (int i = 0; i < burst; i++) {
+        snprintf(path, sizeof(path), "%s/dump_burst_%d.nv12", dir, i);
+        unlink(path);
+    }
+    free(frame);
+
+    return errors;
+}
+
+// a dump over the memory budget is refused without dropping the pending
+// dump it would have replaced
+static int testBudget(const char *dir)
+{
+    int errors = 0;
+    const size_t small = CameraDumpWriter::ALIGNMENT;
+    unsigned char *frame = (unsigned char *) malloc(small * 3);
+    char keptPath[128], bigPath[128], lastPath[128];
+
+    fillFrame(frame, small * 3, 5);
+    snprintf(keptPath, sizeof(keptPath), "%s/dump_budget_kept.nv12", dir);
+    snprintf(bigPath, sizeof(bigPath), "%s/dump_budget_big.nv12", dir);
+    snprintf(lastPath, sizeof(lastPath), "%s/dump_budget_last.nv12", dir);
+
+    // one slot, room for two blocks, nothing written before run()
+    sp<CameraDumpWriter> writer = new CameraDumpWriter(1, small * 2);
+    if (writer->queue(keptPath, frame, small) != NO_ERROR) {
+        printf("budget: small dump refused\n");
+        errors++;
+    }
+    if (writer->queue(bigPath, frame, small * 3) != NO_MEMORY) {
+        printf("budget: dump over the budget accepted\n");
+        errors++;
+    }
+    CameraDumpWriter::Stats s = writer->getStats();
+    if (s.queued != 1 || s.dropped != 1) {
+        printf("budget: %u queued, %u dropped after the refused dump\n", s.queued, s.dropped);
+        errors++;
+    }
+
+    writer->run();
+    writer->flush();
+    if (!checkFile(keptPath, NULL, 0, frame, small))
+        errors++;
+
+    // the slot is free again and big enough for a dump which fits
+    if (writer->queue(lastPath, frame, small * 2) != NO_ERROR) {
+        printf("budget: dump within the budget refused\n");
+        errors++;
+    }
+    writer->requestExitAndWait();
+    if (!checkFile(lastPath, NULL, 0, frame, small * 2))
+        errors++;
+
+    s = writer->getStats();
+    if (s.written != 2 || s.dropped != 1 || s.failed) {
+        printf("budget: %u written, %u dropped, %u failed\n", s.written, s.dropped, s.failed);
+        errors++;
+    }
+
+    // a budget too small for a block per slot leaves the writer unusable
+    sp<CameraDumpWriter> tiny = new CameraDumpWriter(4, small);
+    if (tiny->run() != NO_MEMORY || tiny->queue(keptPath, frame, 1) != NO_MEMORY) {
+        printf("budget: writer without slots accepted work\n");
+        errors++;
+    }
+
+    unlink(keptPath);
+    unlink(bigPath);
+    unlink(lastPath);
+    free(frame);
+
+    return errors;
+}
+
+// time spent on the calling thread per 1080p frame
+static void benchmark(const char *dir)
+{
+    const int frames = 30;
+    char path[128];
+    unsigned char *frame = (unsigned char *) malloc(FRAME_SIZE);
+    fillFrame(frame, FRAME_SIZE, 0);
+
+    nsecs_t syncMax = 0;
+    nsecs_t start = systemTime();
+    for (int i = 0; i < frames; i++) {
+        nsecs_t t = systemTime();
+        snprintf(path, sizeof(path), "%s/dump_sync_%d.nv12", dir, i);
+        FILE *fp = fopen(path, "w+");
+        if (fp) {
+            fwrite(frame, FRAME_SIZE, 1, fp);
+            fclose(fp);
+        }
+        t = systemTime() - t;
+        if (t > syncMax)
+            syncMax = t;
+    }
+    nsecs_t syncTotal = systemTime() - start;
+
+    sp<CameraDumpWriter> writer = new CameraDumpWriter();
+    writer->run();
+    nsecs_t asyncMax = 0;
+    nsecs_t asyncTotal = 0;
+    for (int i = 0; i < frames; i++) {
+        nsecs_t t = systemTime();
+        snprintf(path, sizeof(path), "%s/dump_async_%d.nv12", dir, i);
+        writer->queue(path, frame, FRAME_SIZE);
+        t = systemTime() - t;
+        asyncTotal += t;
+        if (t > asyncMax)
+            asyncMax = t;
+        usleep(33000);  // 30 fps
+    }
+    writer->requestExitAndWait();
+
+    CameraDumpWriter::Stats s = writer->getStats();
+    printf("1080p NV12, %d frames at 30 fps\n", frames);
+    printf("  fwrite    per frame avg %6lld us max %6lld us\n",
+           (long long) (syncTotal / frames / 1000), (long long) (syncMax / 1000));
+    printf("  writer    per frame avg %6lld us max %6lld us, %u dropped, "
+           "background write avg %lld us\n",
+           (long long) (asyncTotal / frames / 1000), (long long) (asyncMax / 1000), s.dropped,
+           (long long) (s.written ? s.writeTotal / s.written / 1000 : 0));
+
+    for (int i = 0; i < frames; i++) {
+        snprintf(path, sizeof(path), "%s/dump_sync_%d.nv12", dir, i);
+        unlink(path);
+        snprintf(path, sizeof(path), "%s/dump_async_%d.nv12", dir, i);
+        unlink(path);
+    }
+    free(frame);
+}
+
+int main(int argc, char **argv)
+{
+    const char *dir = argc > 1 ? argv[1] : "/tmp";
+    int errors = 0;
+
+    errors += testContent(dir);
+    errors += testDropOldest(dir);
+    errors += testBudget(dir);
+    benchmark(dir);
+
+    printf("%s\n", errors ? "FAILED" : "PASSED");
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2014 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host test and benchmark of the camera profiles snapshot.
+ *
+ * A camera_profiles.xml (the one given, or a generated one of the usual
+ * size) is parsed with expat while recording a snapshot. The snapshot is
+ * saved, loaded and replayed, and the replayed elements must be exactly
+ * the parsed ones. Stale, missing and damaged snapshots must be refused.
+ * Then the time of an expat parse is compared with the time of what
+ * CameraProfiles does instead when the snapshot is fresh: hash the XML,
+ * load and replay.
+ *
+ * usage: camera_profiles_snapshot_test [camera_profiles.xml [iterations]]
+ */
+
+#define LOG_TAG "Camera_ProfilesSnapshotTest"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <expat.h>
+#include <utils/String8.h>
+#include <utils/Timers.h>
+#include "../CameraProfilesSnapshot.h"
+
+// normally defined by LogHelper.cpp
+int32_t gLogLevel = 0;
+int32_t gPerfLevel = 0;
+int32_t gPowerLevel = 0;
+int32_t gControlLevel = 0;
+
+using namespace android;
+
+static const char *SNAPSHOT = "/tmp/camera_profiles_snapshot_test.bin";
+
+// what the handlers saw, to compare a replay with a parse
+struct Events {
+    uint64_t hash;
+    int starts;
+    int ends;
+    CameraProfilesSnapshot *recorder;
+};
+
+static void mix(Events *e, const char *str)
+{
+    e->hash = (e->hash ^ CameraProfilesSnapshot::hash(str, strlen(str) + 1)) * 0x100000001b3ULL;
+}
+
+static void startElement(void *userData, const char *name, const char **atts)
+{
+    Events *e = (Events *) userData;
+    if (e->recorder)
+        e->recorder->recordStart(name, atts);
+    e->starts++;
+    mix(e, name);
+    for (int i = 0; atts[i]; i++)
+        mix(e, atts[i]);
+    mix(e, "");
+}
+
+static void endElement(void *userData, const char *name)
+{
+    Events *e = (Events *) userData;
+    if (e->recorder)
+        e->recorder->recordEnd(name);
+    e->ends++;
+    mix(e, name);
+}
+
+static bool parse(const String8 &xml, Events *e)
+{
+    XML_Parser parser = XML_ParserCreate(NULL);
+    XML_SetUserData(parser, e);
+    XML_SetElementHandler(parser, startElement, endElement);
+    bool ok = XML_Parse(parser, xml.string(), xml.length(), true) != XML_STATUS_ERROR;
+    XML_ParserFree(parser);
+    return ok;
+}
+
+// a camera_profiles.xml with three sensors of about a hundred settings
+static String8 generateXml()
+{
+    String8 xml("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<CameraSettings>\n");
+    static const char *names[] = { "imx135", "ov5693", "ov8858" };
+
+    for (int cam = 0; cam < 3; cam++) {
+        xml.appendFormat("    <Profiles cameraId=\"%d\" name=\"%s\">\n", cam & 1, names[cam]);
+        for (int i = 0; i < 110; i++) {
+            if (i % 3 == 0)
+                xml.appendFormat("        <setting%d value=\"true\"/>\n", i);
+            else if (i % 3 == 1)
+                xml.appendFormat("        <setting%d value=\"%d\"/>\n", i, i * 10);
+            else
+                xml.appendFormat("        <setting%d value=\"320x240,640x480,1280x720,"
+                                 "1920x1080,2048x1536,3264x2448\"/> <!-- sizes -->\n", i);
+        }
+        xml.append("        <flipping value=\"SENSOR_FLIP_H\" value_v=\"SENSOR_FLIP_V\"/>\n");
+        xml.append("    </Profiles>\n");
+    }
+    xml.append("    <Common>\n");
+    for (int i = 0; i < 25; i++)
+        xml.appendFormat("        <common%d value=\"%d\"/>\n", i, i);
+    xml.append("    </Common>\n</CameraSettings>\n");
+    return xml;
+}
+
+static String8 readFile(const char *path)
+{
+    String8 content;
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+        return content;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+        content.append(buf, n);
+    fclose(fp);
+    return content;
+}
+
+static void writeFile(const char *path, const char *data, size_t size)
+{
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL)
+        return;
+    fwrite(data, 1, size, fp);
+    fclose(fp);
+}
+
+static int testSnapshot(const String8 &xml)
+{
+    int errors = 0;
+    uint64_t key = CameraProfilesSnapshot::hash(xml.string(), xml.length());
+
+    Events parsed = { 0, 0, 0, NULL };
+    CameraProfilesSnapshot recorder;
+    parsed.recorder = &recorder;
+    if (!parse(xml, &parsed)) {
+        printf("xml does not parse\n");
+        return 1;
+    }
+    unlink(SNAPSHOT);
+    if (recorder.save(SNAPSHOT, key) != NO_ERROR) {
+        printf("save failed\n");
+        return 1;
+    }
+
+    CameraProfilesSnapshot snapshot;
+    if (snapshot.load(SNAPSHOT, key) != NO_ERROR) {
+        printf("load failed\n");
+        return 1;
+    }
+    Events replayed = { 0, 0, 0, NULL };
+    snapshot.replay(&replayed, startElement, endElement);
+    printf("%d elements, replayed %d\n", parsed.starts, replayed.starts);
+    if (replayed.hash != parsed.hash || replayed.starts != parsed.starts
+        || replayed.ends != parsed.ends || (int) snapshot.elementCount() != parsed.starts) {
+        printf("replayed elements differ from the parsed ones\n");
+        errors++;
+    }
+
+    // another xml content
+    if (snapshot.load(SNAPSHOT, key + 1) != BAD_VALUE) {
+        printf("stale snapshot accepted\n");
+        errors++;
+    }
+
+    if (snapshot.load("/tmp/no_such_camera_profiles.bin", key) != NAME_NOT_FOUND) {
+        printf("missing snapshot not reported\n");
+        errors++;
+    }
+
+    // damaged files: truncated, then a record pointing out of the strings
+    String8 good = readFile(SNAPSHOT);
+    writeFile(SNAPSHOT, good.string(), good.length() - 3);
+    if (snapshot.load(SNAPSHOT, key) != BAD_VALUE) {
+        printf("truncated snapshot accepted\n");
+        errors++;
+    }
+
+    char *damaged = (char *) malloc(good.length());
+    memcpy(damaged, good.string(), good.length());
+    memset(damaged + 32 + 4, 0xff, 4);  // name of the first element
+    writeFile(SNAPSHOT, damaged, good.length());
+    free(damaged);
+    if (snapshot.load(SNAPSHOT, key) != BAD_VALUE) {
+        printf("damaged snapshot accepted\n");
+        errors++;
+    }
+
+    unlink(SNAPSHOT);
+    return errors;
+}
+
+static void benchmark(const String8 &xml, int iterations)
+{
+    uint64_t key = CameraProfilesSnapshot::hash(xml.string(), xml.length());
+    Events e = { 0, 0, 0, NULL };
+    CameraProfilesSnapshot recorder;
+    e.recorder = &recorder;
+    parse(xml, &e);
+    recorder.save(SNAPSHOT, key);
+    e.recorder = NULL;
+
+    nsecs_t start = systemTime();
+    for (int i = 0; i < iterations; i++)
+        parse(xml, &e);
+    nsecs_t parseNs = (systemTime() - start) / iterations;
+
+    start = systemTime();
+    for (int i = 0; i < iterations; i++) {
+        CameraProfilesSnapshot snapshot;
+        if (snapshot.load(SNAPSHOT, CameraProfilesSnapshot::hash(xml.string(), xml.length()))
+            == NO_ERROR)
+            snapshot.replay(&e, startElement, endElement);
+    }
+    nsecs_t loadNs = (systemTime() - start) / iterations;
+
+    start = systemTime();
+    for (int i = 0; i < iterations; i++)
+        key ^= CameraProfilesSnapshot::hash(xml.string(), xml.length());
+    nsecs_t hashNs = (systemTime() - start) / iterations;
+
+    printf("%u bytes of xml, %d iterations\n", (unsigned) xml.length(), iterations);
+    printf("  expat parse            %7.1f us\n", parseNs / 1e3);
+    printf("  hash + load + replay   %7.1f us (hash %.1f us)\n", loadNs / 1e3, hashNs / 1e3);
+    unlink(SNAPSHOT);
+}
+
+int main(int argc, char **argv)
+{
+    String8 xml = argc > 1 ? readFile(argv[1]) : generateXml();
+    int iterations = argc > 2 ? atoi(argv[2]) : 200;
+    int errors = 0;
+
+    if (xml.isEmpty()) {
+        printf("cannot read %s\n", argv[1]);
+        return 1;
+    }
+
+    errors += testSnapshot(xml);
+    if (iterations > 0)
+        benchmark(xml, iterations);
+
+    printf("%s\n", errors ? "FAILED" : "PASSED");
+    return errors ? 1 : 0;
+}
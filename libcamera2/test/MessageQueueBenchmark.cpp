@@ -0,0 +1,471 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Contention benchmark of the camera MessageQueue.
+ *
+ * N producer threads send timestamped messages to one receiver, the way
+ * the HAL threads feed ControlThread. The same load is run through the
+ * lock-free MessageQueue and through the previous mutex + List queue,
+ * kept below as the reference, and the send cost, the send-to-receive
+ * latency and the throughput are printed for both. Per producer FIFO
+ * order is checked on the way, followed by sanity checks of priority,
+ * coalescing, remove(), lanes overflowing their ring and receive()
+ * timeouts.
+ *
+ * usage: camera_messagequeue_benchmark [producers] [messages per producer]
+ */
+
+#define LOG_TAG "Camera_MessageQueueBenchmark"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <utils/List.h>
+#include "../MessageQueue.h"
+
+using namespace android;
+
+enum MessageId {
+    MESSAGE_ID_EXIT = 0,
+    MESSAGE_ID_DATA,
+    MESSAGE_ID_STATS,
+    MESSAGE_ID_URGENT,
+    MESSAGE_ID_MAX
+};
+
+struct Message {
+    MessageId id;
+    int producer;
+    int sequence;
+    nsecs_t sent;
+};
+
+/**
+ * The mutex protected queue MessageQueue used to be, for reference.
+ */
+template <class MessageType, class MessageId>
+class LockedMessageQueue {
+public:
+    LockedMessageQueue(const char *name, int numReply = 0) : mName(name) {}
+
+    status_t send(MessageType *msg, MessageId replyId = (MessageId) -1)
+    {
+        mQueueMutex.lock();
+        mList.push_front(*msg);
+        mQueueCondition.signal();
+        mQueueMutex.unlock();
+        return NO_ERROR;
+    }
+
+    status_t receive(MessageType *msg, unsigned int timeout_ms = 0)
+    {
+        mQueueMutex.lock();
+        while (mList.size() == 0)
+            mQueueCondition.wait(mQueueMutex);
+        *msg = *(--mList.end());
+        mList.erase(--mList.end());
+        mQueueMutex.unlock();
+        return NO_ERROR;
+    }
+
+private:
+    const char *mName;
+    Mutex mQueueMutex;
+    Condition mQueueCondition;
+    List<MessageType> mList;
+};
+
+struct Result {
+    nsecs_t elapsed;
+    nsecs_t sendTotal;
+    nsecs_t sendMax;
+    nsecs_t latencyTotal;
+    nsecs_t latencyMax;
+    int received;
+    int errors;
+};
+
+template <class Queue>
+struct Producer {
+    Queue *queue;
+    int index;
+    int count;
+    nsecs_t sendTotal;
+    nsecs_t sendMax;
+
+    static void *run(void *arg)
+    {
+        Producer *p = (Producer *) arg;
+        Message msg;
+        p->sendTotal = 0;
+        p->sendMax = 0;
+        for (int i = 0; i < p->count; i++) {
+            msg.id = MESSAGE_ID_DATA;
+            msg.producer = p->index;
+            msg.sequence = i;
+            msg.sent = systemTime();
+            p->queue->send(&msg);
+            nsecs_t cost = systemTime() - msg.sent;
+            p->sendTotal += cost;
+            if (cost > p->sendMax)
+                p->sendMax = cost;
+        }
+        return NULL;
+    }
+};
+
+template <class Queue>
+static Result runContention(Queue *queue, int producers, int count)
+{
+    Result r;
+    memset(&r, 0, sizeof(r));
+
+    Producer<Queue> *p = new Producer<Queue>[producers];
+    pthread_t *threads = new pthread_t[producers];
+    int *next = new int[producers];
+
+    nsecs_t start = systemTime();
+    for (int i = 0; i < producers; i++) {
+        p[i].queue = queue;
+        p[i].index = i;
+        p[i].count = count;
+        next[i] = 0;
+        pthread_create(&threads[i], NULL, Producer<Queue>::run, &p[i]);
+    }
+
+    Message msg;
+    for (int n = 0; n < producers * count; n++) {
+        queue->receive(&msg);
+        nsecs_t latency = systemTime() - msg.sent;
+        r.latencyTotal += latency;
+        if (latency > r.latencyMax)
+            r.latencyMax = latency;
+        if (msg.sequence != next[msg.producer])
+            r.errors++;
+        next[msg.producer] = msg.sequence + 1;
+        r.received++;
+    }
+    r.elapsed = systemTime() - start;
+
+    for (int i = 0; i < producers; i++) {
+        pthread_join(threads[i], NULL);
+        r.sendTotal += p[i].sendTotal;
+        if (p[i].sendMax > r.sendMax)
+            r.sendMax = p[i].sendMax;
+    }
+
+    delete [] p;
+    delete [] threads;
+    delete [] next;
+    return r;
+}
+
+static void printResult(const char *name, const Result &r)
+{
+    printf("%-10s %8.0f msg/s  send avg %6lld ns max %8lld ns  "
+           "latency avg %8lld ns max %9lld ns  %d out of order\n",
+           name, r.received * 1e9 / r.elapsed,
+           (long long) (r.sendTotal / r.received), (long long) r.sendMax,
+           (long long) (r.latencyTotal / r.received), (long long) r.latencyMax,
+           r.errors);
+}
+
+template <class Queue>
+struct Waker {
+    Queue *queue;
+    volatile int32_t stop;
+
+    // wake the receiver up with messages gone before it looks
+    static void *run(void *arg)
+    {
+        Waker *w = (Waker *) arg;
+        Message msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.id = MESSAGE_ID_URGENT;
+        while (!android_atomic_acquire_load(&w->stop)) {
+            w->queue->send(&msg);
+            w->queue->remove(MESSAGE_ID_URGENT);
+            usleep(2000);
+        }
+        return NULL;
+    }
+};
+
+// receive() must give up at the timeout, even when woken up in between
+template <class Queue>
+static int checkTimeout(Queue &queue)
+{
+    Waker<Queue> w;
+    w.queue = &queue;
+    w.stop = 0;
+    pthread_t thread;
+    pthread_create(&thread, NULL, Waker<Queue>::run, &w);
+
+    int errors = 0;
+    Message msg;
+    nsecs_t end = systemTime() + seconds(1);
+    while (systemTime() < end) {
+        nsecs_t start = systemTime();
+        queue.receive(&msg, 20);
+        nsecs_t elapsed = systemTime() - start;
+        if (elapsed > milliseconds(60)) {
+            printf("receive: 20 ms timeout took %lld ms\n", (long long) (elapsed / 1000000));
+            errors++;
+            break;
+        }
+    }
+
+    android_atomic_release_store(1, &w.stop);
+    pthread_join(thread, NULL);
+    queue.remove(MESSAGE_ID_URGENT);
+    return errors;
+}
+
+template <class Queue>
+struct Sender {
+    Queue *queue;
+    MessageId id;
+    int count;
+    volatile int32_t *running;
+
+    static void *run(void *arg)
+    {
+        Sender *s = (Sender *) arg;
+        Message msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.id = s->id;
+        for (int i = 0; i < s->count; i++) {
+            msg.sequence = i;
+            s->queue->send(&msg);
+        }
+        android_atomic_dec(s->running);
+        return NULL;
+    }
+};
+
+template <class Queue>
+struct Remover {
+    Queue *queue;
+    volatile int32_t stop;
+    int removed;
+
+    static void *run(void *arg)
+    {
+        Remover *r = (Remover *) arg;
+        Vector<Message> vect;
+        r->removed = 0;
+        while (!android_atomic_acquire_load(&r->stop)) {
+            vect.clear();
+            r->queue->remove(MESSAGE_ID_DATA, &vect);
+            r->removed += vect.size();
+        }
+        return NULL;
+    }
+};
+
+// racing senders of a coalesced id, and remove() racing the receiver
+static int checkRaces()
+{
+    const int senders = 4;
+    const int count = 20000;
+    int errors = 0;
+    Sender<MessageQueue<Message, MessageId> > s[senders];
+    pthread_t threads[senders];
+    volatile int32_t running = senders;
+
+    MessageQueue<Message, MessageId> coalesced("coalesced", (int) MESSAGE_ID_MAX);
+    coalesced.setCoalescing(MESSAGE_ID_STATS);
+    for (int i = 0; i < senders; i++) {
+        s[i].queue = &coalesced;
+        s[i].id = MESSAGE_ID_STATS;
+        s[i].count = count;
+        s[i].running = &running;
+        pthread_create(&threads[i], NULL, Sender<MessageQueue<Message, MessageId> >::run, &s[i]);
+    }
+    for (int i = 0; i < senders; i++)
+        pthread_join(threads[i], NULL);
+
+    // the one left was sent last by one of the senders
+    Message msg;
+    if (coalesced.size() != 1) {
+        printf("coalescing race: size %d, expected 1\n", coalesced.size());
+        errors++;
+    }
+    if (coalesced.receive(&msg, 10) != NO_ERROR || msg.sequence != count - 1) {
+        printf("coalescing race: got seq %d, expected %d\n", msg.sequence, count - 1);
+        errors++;
+    }
+    coalesced.remove(MESSAGE_ID_STATS);
+
+    // every message is either received or removed, exactly once
+    MessageQueue<Message, MessageId> removing("removing", (int) MESSAGE_ID_MAX, 8);
+    Remover<MessageQueue<Message, MessageId> > r;
+    pthread_t remover;
+    r.queue = &removing;
+    r.stop = 0;
+    pthread_create(&remover, NULL, Remover<MessageQueue<Message, MessageId> >::run, &r);
+    running = senders;
+    for (int i = 0; i < senders; i++) {
+        s[i].queue = &removing;
+        s[i].id = MESSAGE_ID_DATA;
+        s[i].count = count;
+        pthread_create(&threads[i], NULL, Sender<MessageQueue<Message, MessageId> >::run, &s[i]);
+    }
+    int received = 0;
+    while (android_atomic_acquire_load(&running) > 0) {
+        if (removing.receive(&msg, 10) == NO_ERROR)
+            received++;
+    }
+    for (int i = 0; i < senders; i++)
+        pthread_join(threads[i], NULL);
+    android_atomic_release_store(1, &r.stop);
+    pthread_join(remover, NULL);
+    while (removing.receive(&msg, 1) == NO_ERROR)
+        received++;
+    if (received + r.removed != senders * count) {
+        printf("remove race: %d received + %d removed, expected %d\n",
+               received, r.removed, senders * count);
+        errors++;
+    }
+
+    return errors;
+}
+
+static int checkSemantics()
+{
+    int errors = 0;
+    MessageQueue<Message, MessageId> queue("check", (int) MESSAGE_ID_MAX, 8);
+    queue.setPriority(MESSAGE_ID_URGENT, MessageQueue<Message, MessageId>::PRIORITY_HIGH);
+    queue.setCoalescing(MESSAGE_ID_STATS);
+
+    Message msg;
+    memset(&msg, 0, sizeof(msg));
+    for (int i = 0; i < 3; i++) {
+        msg.id = MESSAGE_ID_DATA;
+        msg.sequence = i;
+        queue.send(&msg);
+        msg.id = MESSAGE_ID_STATS;
+        queue.send(&msg);
+    }
+    msg.id = MESSAGE_ID_URGENT;
+    msg.sequence = 100;
+    queue.send(&msg);
+
+    // 3 data + newest stats + urgent
+    if (queue.size() != 5) {
+        printf("coalescing: size %d, expected 5\n", queue.size());
+        errors++;
+    }
+
+    queue.receive(&msg);
+    if (msg.id != MESSAGE_ID_URGENT) {
+        printf("priority: got id %d first, expected urgent\n", msg.id);
+        errors++;
+    }
+
+    Vector<Message> removed;
+    queue.remove(MESSAGE_ID_DATA, &removed);
+    if (removed.size() != 3 || removed[0].sequence != 0 || removed[2].sequence != 2) {
+        printf("remove: got %d messages\n", (int) removed.size());
+        errors++;
+    }
+
+    queue.receive(&msg);
+    if (msg.id != MESSAGE_ID_STATS || msg.sequence != 2) {
+        printf("coalescing: got id %d seq %d, expected newest stats\n", msg.id, msg.sequence);
+        errors++;
+    }
+
+    if (queue.receive(&msg, 10) != TIMED_OUT) {
+        printf("receive: did not time out on an empty queue\n");
+        errors++;
+    }
+
+    // removed cells are recycled: fill and drain the lanes a few times
+    for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < 8; i++) {
+            msg.id = MESSAGE_ID_DATA;
+            queue.send(&msg);
+        }
+        queue.remove(MESSAGE_ID_DATA);
+    }
+    if (!queue.isEmpty()) {
+        printf("remove: %d messages left\n", queue.size());
+        errors++;
+    }
+
+    // more than the ring holds, nobody receiving: send() must not block
+    for (int i = 0; i < 100; i++) {
+        msg.id = MESSAGE_ID_DATA;
+        msg.sequence = i;
+        queue.send(&msg);
+        if (i == 50 || i == 99) {
+            msg.id = MESSAGE_ID_STATS;
+            queue.send(&msg);
+        }
+    }
+    // 100 data + newest stats
+    if (queue.size() != 101) {
+        printf("overflow: size %d, expected 101\n", queue.size());
+        errors++;
+    }
+    for (int i = 0; i < 101; i++) {
+        queue.receive(&msg);
+        bool stats = i == 100;
+        if ((msg.id == MESSAGE_ID_STATS) != stats || msg.sequence != (stats ? 99 : i)) {
+            printf("overflow: got id %d seq %d at %d\n", msg.id, msg.sequence, i);
+            errors++;
+            break;
+        }
+    }
+
+    errors += checkTimeout(queue);
+
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    int producers = argc > 1 ? atoi(argv[1]) : 4;
+    int count = argc > 2 ? atoi(argv[2]) : 200000;
+    int errors = 0;
+
+    if (producers <= 0 || count <= 0) {
+        printf("usage: %s [producers] [messages per producer]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%d producers x %d messages, 1 receiver\n", producers, count);
+
+    LockedMessageQueue<Message, MessageId> locked("locked");
+    Result r = runContention(&locked, producers, count);
+    printResult("mutex", r);
+    errors += r.errors;
+
+    MessageQueue<Message, MessageId> lockFree("lockfree", (int) MESSAGE_ID_MAX);
+    r = runContention(&lockFree, producers, count);
+    printResult("lock-free", r);
+    errors += r.errors;
+
+    errors += checkSemantics();
+    errors += checkRaces();
+
+    printf("%s\n", errors ? "FAILED" : "PASSED");
+    return errors ? 1 : 0;
+}
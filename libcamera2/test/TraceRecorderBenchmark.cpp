@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2014 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host test and benchmark of the TraceRecorder.
+ *
+ * Threads record known numbers of events, which must all be exported,
+ * once; a ring which wrapped exports exactly its last RING_SIZE - 1 events;
+ * exporting while threads record must only lose overwritten events.
+ * Then the cost of a trace point is measured, recorder enabled and
+ * disabled.
+ *
+ * usage: camera_tracerecorder_benchmark [events]
+ */
+
+#define LOG_TAG "Camera_TraceRecorderBenchmark"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <utils/Timers.h>
+#include "../TraceRecorder.h"
+
+// normally defined by LogHelper.cpp
+int32_t gLogLevel = 0;
+int32_t gPerfLevel = 0;
+int32_t gPowerLevel = 0;
+int32_t gControlLevel = 0;
+
+using namespace android;
+
+static const char *TRACE_FILE = "/tmp/camera_trace_test.json";
+
+// occurrences of @pattern in the exported file
+static int countInTrace(const char *pattern)
+{
+    FILE *fp = fopen(TRACE_FILE, "r");
+    if (fp == NULL)
+        return -1;
+    int count = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), fp))
+        if (strstr(line, pattern))
+            count++;
+    fclose(fp);
+    return count;
+}
+
+struct Worker {
+    int events;
+    volatile bool *stop;
+};
+
+static void *recordEvents(void *arg)
+{
+    Worker *w = (Worker *) arg;
+    for (int i = 0; i < w->events || (w->stop && !*w->stop); i++) {
+        CAMERA_TRACE_SCOPE("worker");
+        CAMERA_TRACE_COUNTER("queue", i);
+    }
+    return NULL;
+}
+
+static int testThreads()
+{
+    const int threads = 4;
+    const int events = 1000;    // spans, two events each, plus a counter
+    int errors = 0;
+    pthread_t t[threads];
+    Worker w = { events, NULL };
+
+    TraceRecorder::exportJson(TRACE_FILE);   // forget older events
+    for (int i = 0; i < threads; i++)
+        pthread_create(&t[i], NULL, recordEvents, &w);
+    for (int i = 0; i < threads; i++)
+        pthread_join(t[i], NULL);
+
+    int n = TraceRecorder::exportJson(TRACE_FILE);
+    int begins = countInTrace("\"ph\":\"B\"");
+    int counters = countInTrace("\"ph\":\"C\"");
+    if (n != threads * events * 3 || begins != threads * events || counters != threads * events) {
+        printf("threads: %d events exported, %d begins, %d counters, expected %d, %d, %d\n",
+               n, begins, counters, threads * events * 3, threads * events, threads * events);
+        errors++;
+    }
+
+    // exported once only
+    n = TraceRecorder::exportJson(TRACE_FILE);
+    if (n != 0) {
+        printf("threads: %d events exported again\n", n);
+        errors++;
+    }
+    return errors;
+}
+
+static int testWrap()
+{
+    int errors = 0;
+    const int events = TraceRecorder::RING_SIZE * 2 + 5;
+
+    for (int i = 0; i < events; i++)
+        CAMERA_TRACE_COUNTER("wrap", i);
+    int n = TraceRecorder::exportJson(TRACE_FILE);
+
+    // the last event is there, the first kept one is RING_SIZE - 2 before it
+    const int kept = TraceRecorder::RING_SIZE - 1;
+    char last[64], first[64], dropped[64];
+    snprintf(last, sizeof(last), "\"value\":%d}", events - 1);
+    snprintf(first, sizeof(first), "\"value\":%d}", events - kept);
+    snprintf(dropped, sizeof(dropped), "\"value\":%d}", events - kept - 1);
+    if (n != kept || countInTrace(last) != 1 || countInTrace(first) != 1
+        || countInTrace(dropped) != 0) {
+        printf("wrap: %d events exported, expected the last %d\n", n, kept);
+        errors++;
+    }
+    return errors;
+}
+
+static int testConcurrentExport()
+{
+    int errors = 0;
+    volatile bool stop = false;
+    Worker w = { 0, &stop };
+    pthread_t t;
+
+    pthread_create(&t, NULL, recordEvents, &w);
+    int total = 0;
+    for (int i = 0; i < 50; i++) {
+        int n = TraceRecorder::exportJson(TRACE_FILE);
+        if (n < 0 || n > (int) TraceRecorder::RING_SIZE) {
+            printf("concurrent export: %d events\n", n);
+            errors++;
+        }
+        total += n;
+        usleep(1000);
+    }
+    stop = true;
+    pthread_join(t, NULL);
+    printf("concurrent export: %d events in 50 exports\n", total);
+    return errors;
+}
+
+static void benchmark(int events)
+{
+    nsecs_t start = systemTime();
+    for (int i = 0; i < events; i++)
+        CAMERA_TRACE_INSTANT("bench");
+    nsecs_t enabled = systemTime() - start;
+
+    start = systemTime();
+    for (int i = 0; i < events / 2; i++) {
+        CAMERA_TRACE_SCOPE("bench");
+    }
+    nsecs_t scope = systemTime() - start;
+
+    TraceRecorder::enable(false);
+    start = systemTime();
+    for (int i = 0; i < events; i++)
+        CAMERA_TRACE_INSTANT("bench");
+    nsecs_t disabled = systemTime() - start;
+
+    start = systemTime();
+    for (int i = 0; i < events; i++)
+        systemTime();
+    nsecs_t clock = systemTime() - start;
+
+    printf("%d events\n", events);
+    printf("  enabled event     %6.1f ns\n", (double) enabled / events);
+    printf("  enabled scope     %6.1f ns (two events)\n", (double) scope / (events / 2));
+    printf("  disabled event    %6.1f ns\n", (double) disabled / events);
+    printf("  clock read alone  %6.1f ns\n", (double) clock / events);
+}
+
+int main(int argc, char **argv)
+{
+    int events = argc > 1 ? atoi(argv[1]) : 10000000;
+    int errors = 0;
+
+    TraceRecorder::enable(true);
+    errors += testThreads();
+    errors += testWrap();
+    errors += testConcurrentExport();
+    if (events > 0)
+        benchmark(events);
+    unlink(TRACE_FILE);
+
+    printf("%s\n", errors ? "FAILED" : "PASSED");
+    return errors ? 1 : 0;
+}
@@ -15,11 +15,13 @@ LOCAL_SRC_FILES := \
 	VideoThread.cpp \
 	PipeThread.cpp \
 	CameraDriver.cpp \
+	V4L2BufferStrategy.cpp \
 	DebugFrameRate.cpp \
 	Callbacks.cpp \
 	CallbacksThread.cpp \
 	CameraHAL.cpp \
 	ColorConverter.cpp \
+	ColorConvertKernels.cpp \
         VAConvertor.cpp \
         EXIFFields.cpp \
 	JpegCompressor.cpp \
@@ -52,6 +52,7 @@ class ControlThread;
 class ICameraBufferAllocator;
 class GEMFlinkAllocator;
 class CameraMemoryAllocator;
+class V4L2MappedAllocator;
 
 class CameraBuffer {
 
@@ -160,6 +161,7 @@ private:
     friend class GEMFlinkAllocator;
     friend class CameraMemoryAllocator;
     friend class CamGraphicBufferAllocator;
+    friend class V4L2MappedAllocator;
 };
 
 }//namespace
@@ -25,6 +25,7 @@
 #include "IntelMetadataBuffer.h"
 #include "CameraBuffer.h"
 #include "LogHelper.h"
+#include "V4L2BufferStrategy.h"
 #define BATCH_SIZE      0x80000
 
 namespace android
@@ -233,4 +234,77 @@ bool GEMFlinkAllocator::bufferOwnsThisData (const CameraBuffer* buf, void* data)
             || buf->mData == data;
 }
 
+V4L2MappedAllocator::V4L2MappedAllocator(V4L2BufferStrategy* strategy, Callbacks* callbacks) :
+    mStrategy(strategy),
+    mCallbacks(callbacks)
+{
+}
+
+V4L2MappedAllocator::~V4L2MappedAllocator()
+{
+}
+
+void* V4L2MappedAllocator::map(CameraBuffer* buf)
+{
+    V4L2BufferStrategy::Buffer* vbuf = (V4L2BufferStrategy::Buffer*) buf->mAllocPrivate;
+    if (vbuf == 0)
+        return 0;
+    buf->mData = vbuf->data;
+    return buf->mData;
+}
+
+int V4L2MappedAllocator::allocateMemory(CameraBuffer* buf, unsigned int size,
+        Callbacks* callbacks, int w, int h, int format)
+{
+    V4L2BufferStrategy::Buffer* vbuf = mStrategy->getBuffer(buf->mID);
+    if (vbuf == 0 || vbuf->data == 0)
+        return -1;
+
+    buf->mCamMem = 0; // only created if a consumer needs a copy
+    buf->mAllocPrivate = vbuf;
+    buf->mAlloc = this;
+    buf->mSize = vbuf->length;
+    buf->mData = vbuf->data;
+    buf->mFormat = format;
+    buf->mWidth = (uint32_t)w;
+    buf->mHeight = (uint32_t)h;
+    return vbuf->length;
+}
+
+int V4L2MappedAllocator::releaseMemory(CameraBuffer* buf)
+{
+    // the mapping itself goes away with the strategy
+    if (buf->mCamMem != 0)
+        buf->mCamMem->release(buf->mCamMem);
+    buf->mCamMem = 0;
+    buf->mAllocPrivate = 0;
+    buf->mData = 0;
+    return 0;
+}
+
+int V4L2MappedAllocator::toMetaDataStream(CameraBuffer* buf)
+{
+    if (buf->mData == 0 || buf->mSize <= 0)
+        return -1;
+
+    if (buf->mCamMem == 0) {
+        V4L2BufferStrategy::Buffer* vbuf = (V4L2BufferStrategy::Buffer*) buf->mAllocPrivate;
+        buf->mCamMem = mCallbacks->allocateMemory(vbuf ? vbuf->length : buf->mSize);
+        if (buf->mCamMem == 0 || buf->mCamMem->data == 0) {
+            buf->mCamMem = 0;
+            return -1;
+        }
+    }
+
+    memcpy(buf->mCamMem->data, buf->mData, buf->mSize);
+    mStrategy->countCopy(buf->mSize);
+    return buf->mSize;
+}
+
+bool V4L2MappedAllocator::bufferOwnsThisData (const CameraBuffer* buf, void* data)
+{
+    return ( buf->mCamMem !=0 && buf->mCamMem->data == data)
+            || buf->mData == data;
+}
+
 }//namespace
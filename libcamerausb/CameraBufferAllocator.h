@@ -26,6 +26,7 @@ extern "C"
 namespace android {
 
 class CameraBuffer;
+class V4L2BufferStrategy;
 
 /**
  * ICameraBufferAllocator allocates/deallocates, maps/unmaps buffers to be used by camera driver
@@ -137,5 +138,33 @@ private:
     drm_intel_bufmgr *mDRMBufMgr;
 };
 
+/**
+ * Wraps capture buffers the V4L2 driver allocated (MMAP or DMABUF export)
+ * into CameraBuffers, so consumers read frames straight from driver memory.
+ *
+ * The mapping is owned by the V4L2BufferStrategy. A camera_memory_t copy is
+ * only made when a consumer asks for getCameraMem(), and it is counted in
+ * the strategy statistics.
+ */
+class V4L2MappedAllocator: public ICameraBufferAllocator
+{
+public:
+    V4L2MappedAllocator(V4L2BufferStrategy* strategy, Callbacks* callbacks);
+    virtual ~V4L2MappedAllocator();
+
+    // size is ignored, the buffer is the driver buffer with index buf->mID
+    virtual int allocateMemory(CameraBuffer* buf,
+            unsigned int size, Callbacks* callbacks, int w = 0, int h =0, int format = 0);
+
+private:
+    virtual void* map(CameraBuffer* buf);
+    virtual int releaseMemory(CameraBuffer* buf);
+    virtual int toMetaDataStream(CameraBuffer* buf);
+    bool bufferOwnsThisData (const CameraBuffer* buf, void* data);
+
+    V4L2BufferStrategy* mStrategy;
+    Callbacks* mCallbacks;
+};
+
 };//namespace
 #endif /* CAMERABUFFERALLOCATOR_H_ */
@@ -68,6 +68,8 @@ CameraDriver::CameraDriver(int cameraId) :
     ,mCameraId(cameraId)
     ,mFormat(V4L2_PIX_FMT_YUYV)
     ,mBufAlloc(CameraMemoryAllocator::instance())
+    ,mBufferStrategy(NULL)
+    ,mMappedAlloc(NULL)
     ,mJpegDecoder(NULL)
 {
     LOG1("@%s", __FUNCTION__);
@@ -591,6 +593,11 @@ void CameraDriver::stopDevice()
     if (ret < 0) {
         ALOGE("VIDIOC_STREAMOFF returned: %d (%s)", ret, strerror(errno));
     }
+
+    if (mBufferStrategy) {
+        mBufferStrategy->dumpStats(LOG_TAG);
+        mBufferStrategy->resetStats();
+    }
 }
 
 int CameraDriver::openDevice()
@@ -663,26 +670,31 @@ CameraBuffer* CameraDriver::findBuffer(void* findMe) const
 
 status_t CameraDriver::allocateBuffer(int fd, int index, int w, int h, int format)
 {
-    struct v4l2_buffer *vbuf = &mBufferPool.bufs[index].vBuff;
     CameraBuffer *camBuf = &mBufferPool.bufs[index].camBuff;
-    int ret;
+    status_t status;
 
-    // query for buffer info
-    vbuf->flags = 0x0;
-    vbuf->index = index;
-    vbuf->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    vbuf->memory = V4L2_MEMORY_USERPTR;
-    ret = ioctl(fd, VIDIOC_QUERYBUF, vbuf);
-    if (ret < 0) {
-        ALOGE("VIDIOC_QUERYBUF failed: %s", strerror(errno));
-        return UNKNOWN_ERROR;
+    camBuf->mID = index;
+    if (mBufferStrategy->getMemory() == V4L2BufferStrategy::MEMORY_USERPTR) {
+        // allocate memory
+        size_t length = mBufferStrategy->getBufferLength(index);
+        if (mBufAlloc->allocateMemory(camBuf, length, mCallbacks.get(), w, h, format) < 0)
+            status = NO_MEMORY;
+        else
+            status = mBufferStrategy->setupBuffer(index, camBuf->getData(), length);
+    } else {
+        // map the driver's memory, no allocation on our side
+        status = mBufferStrategy->setupBuffer(index, NULL, 0);
+        if (status == NO_ERROR &&
+            mMappedAlloc->allocateMemory(camBuf, 0, mCallbacks.get(), w, h, format) < 0)
+            status = NO_MEMORY;
     }
 
-    // allocate memory
-    mBufAlloc->allocateMemory(camBuf, vbuf->length, mCallbacks.get(), w, h, format);
-    camBuf->mID = index;
-    vbuf->m.userptr = (unsigned int) camBuf->getData();
-    LOG1("alloc mem addr=%p, index=%d size=%d", camBuf->getData(), index, vbuf->length);
+    if (status != NO_ERROR) {
+        ALOGE("failed to set up %s buffer %d",
+             V4L2BufferStrategy::memoryName(mBufferStrategy->getMemory()), index);
+        return status;
+    }
+    LOG1("alloc mem addr=%p, index=%d size=%d", camBuf->getData(), index, camBuf->getDataSize());
 
     return NO_ERROR;
 }
@@ -694,25 +706,21 @@ status_t CameraDriver::allocateBuffers(int numBuffers, int w, int h, int format)
         return UNKNOWN_ERROR;
     }
 
-    int ret;
     int fd = mCameraSensor[mCameraId]->fd;
-    struct v4l2_requestbuffers reqBuf;
-    reqBuf.count = numBuffers;
-    reqBuf.memory = V4L2_MEMORY_USERPTR;
-    reqBuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    int memory = V4L2BufferStrategy::pickMemory(fd, mCameraSensor[mCameraId]->memory);
 
-    LOG1("VIDIOC_REQBUFS, count=%d", reqBuf.count);
-    ret = ioctl(fd, VIDIOC_REQBUFS, &reqBuf);
+    mBufferStrategy = V4L2BufferStrategy::create(fd, memory);
+    if (mBufferStrategy == NULL)
+        return NO_MEMORY;
+    mMappedAlloc = new V4L2MappedAllocator(mBufferStrategy, mCallbacks.get());
+    LOG1("capture buffers: %s", V4L2BufferStrategy::memoryName(memory));
 
-    if (ret < 0) {
-        ALOGE("VIDIOC_REQBUFS(%d) returned: %d (%s)",
-            numBuffers, ret, strerror(errno));
-        return UNKNOWN_ERROR;
-    }
+    status_t status = mBufferStrategy->requestBuffers(&numBuffers);
+    if (status != NO_ERROR)
+        goto fail;
 
     mBufferPool.bufs = new DriverBuffer[numBuffers];
 
-    status_t status = NO_ERROR;
     for (int i = 0; i < numBuffers; i++) {
         status = allocateBuffer(fd, i, w, h, format);
         if (status != NO_ERROR)
@@ -732,6 +740,12 @@ fail:
     delete [] mBufferPool.bufs;
     memset(&mBufferPool, 0, sizeof(mBufferPool));
 
+    mBufferStrategy->releaseBuffers();
+    delete mBufferStrategy;
+    mBufferStrategy = NULL;
+    delete mMappedAlloc;
+    mMappedAlloc = NULL;
+
     return status;
 }
 
@@ -749,29 +763,21 @@ status_t CameraDriver::freeBuffers()
         return NO_ERROR; // This is okay, just print an error
     }
 
-    int ret;
-    int fd = mCameraSensor[mCameraId]->fd;
-    struct v4l2_requestbuffers reqBuf;
-    reqBuf.count = 0;
-    reqBuf.memory = V4L2_MEMORY_USERPTR;
-    reqBuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-
     for (int i = 0; i < mBufferPool.numBuffers; i++) {
         freeBuffer(i);
     }
 
-    LOG1("VIDIOC_REQBUFS, count=%d", reqBuf.count);
-    ret = ioctl(fd, VIDIOC_REQBUFS, &reqBuf);
-
-    if (ret < 0) {
-        // Just print an error and continue with dealloc logic
-        ALOGE("VIDIOC_REQBUFS returned: %d (%s)",
-                ret, strerror(errno));
-    }
+    // Errors are printed, continue with dealloc logic
+    mBufferStrategy->releaseBuffers();
 
     delete [] mBufferPool.bufs;
     memset(&mBufferPool, 0, sizeof(mBufferPool));
 
+    delete mBufferStrategy;
+    mBufferStrategy = NULL;
+    delete mMappedAlloc;
+    mMappedAlloc = NULL;
+
     return NO_ERROR;
 }
 
@@ -783,16 +789,9 @@ status_t CameraDriver::queueBuffer(CameraBuffer *buff, bool init)
             return DEAD_OBJECT;
     }
 
-    int ret;
-    int fd = mCameraSensor[mCameraId]->fd;
-    struct v4l2_buffer *vbuff = &mBufferPool.bufs[buff->getID()].vBuff;
-
-    ret = ioctl(fd, VIDIOC_QBUF, vbuff);
-    if (ret < 0) {
-        ALOGE("VIDIOC_QBUF index %d failed: %s",
-             buff->getID(), strerror(errno));
-        return UNKNOWN_ERROR;
-    }
+    status_t status = mBufferStrategy->queueBuffer(buff->getID());
+    if (status != NO_ERROR)
+        return status;
 
     mBufferPool.numBuffersQueued++;
 
@@ -800,19 +799,14 @@ status_t CameraDriver::queueBuffer(CameraBuffer *buff, bool init)
 }
 status_t CameraDriver::dequeueBuffer(CameraBuffer **driverbuff, CameraBuffer *yuvbuff, nsecs_t *timestamp, bool forJpeg)
 {
-    int ret;
-    int fd = mCameraSensor[mCameraId]->fd;
-    struct v4l2_buffer vbuff;
+    int index;
     RenderTarget *cur_target = yuvbuff->mDecTargetBuf;
 
-    vbuff.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    vbuff.memory = V4L2_MEMORY_USERPTR;
-
-    ret = ioctl(fd, VIDIOC_DQBUF, &vbuff);
-    if (ret < 0) {
+    if (mBufferStrategy->dequeueBuffer(&index) != NO_ERROR) {
         ALOGE("error dequeuing buffers");
         return UNKNOWN_ERROR;
     }
+    struct v4l2_buffer &vbuff = mBufferStrategy->getBuffer(index)->vbuf;
 
     CameraBuffer *camBuff = &mBufferPool.bufs[vbuff.index].camBuff;
     camBuff->mID = vbuff.index;
@@ -1550,6 +1544,7 @@ static const char *PROP_NUMBER = "number";
 static const char *PROP_DEVNAME = "devname";
 static const char *PROP_FACING = "facing";
 static const char *PROP_ORIENTATION = "orientation";
+static const char *PROP_MEMORY = "memory";
 static const char *PROP_FACING_FRONT = "front";
 static const char *PROP_FACING_BACK = "back";
 
@@ -1646,6 +1641,12 @@ int CameraDriver::enumerateCameras(){
 
         newDev->fd = -1;
 
+        // optional: userptr, mmap or dmabuf capture buffers
+        snprintf(propKey, sizeof(propKey), "%s.%d.%s", PROP_PREFIX, i, PROP_MEMORY);
+        newDev->memory = -1;
+        if (property_get(propKey, propVal, 0) > 0)
+            newDev->memory = V4L2BufferStrategy::parseMemory(propVal);
+
         //It seems we get all info of a new camera
         ALOGD("%s: Detected camera (%d) %s %s %d",
                 __FUNCTION__, i, newDev->devName,
@@ -26,6 +26,7 @@
 #include <camera/CameraParameters.h>
 #include <JPEGDecoder.h>
 #include "CameraCommon.h"
+#include "V4L2BufferStrategy.h"
 
 namespace android {
 
@@ -218,20 +219,18 @@ private:
         char *devName;              // device node's name, e.g. /dev/video0
         struct camera_info info;    // camera info defined by Android
         int fd;                     // the file descriptor of device at run time
+        int memory;                 // preferred V4L2BufferStrategy memory, -1 to pick
 
         /* more fields will be added when we find more 'per camera' data*/
     };
 
 
     struct DriverBuffer {
-        CameraBuffer camBuff;
-        struct v4l2_buffer vBuff; /** this will have user pointer
-                                   * or handle specific to camBuff.MemoryType
-                                   * current plan:
-                                   * user pointer will be used for FLINK, USER,
-                                   * GRALLOC, DRM_PRIME_FD
-                                   * How to handle ION? preferrable also
-                                   * map to user pointer
+        CameraBuffer camBuff;     /** the v4l2_buffer lives in mBufferStrategy
+                                   * under the same index.
+                                   * USERPTR: memory from mBufAlloc
+                                   * MMAP/DMABUF: driver memory wrapped by
+                                   * mMappedAlloc
                                    */
     };
 
@@ -342,6 +341,9 @@ private:
 
     ICameraBufferAllocator* mBufAlloc;
 
+    V4L2BufferStrategy* mBufferStrategy;
+    ICameraBufferAllocator* mMappedAlloc;
+
     String8 mPicSizes;
     String8 mBestPicSize;
     String8 mVidSizes;
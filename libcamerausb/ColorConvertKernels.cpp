@@ -0,0 +1,1171 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#define COLOR_CONVERT_X86 1
+#endif
+
+#include "ColorConvertKernels.h"
+
+namespace android {
+
+inline unsigned char clamp(int x){
+    if (x < 0 )
+        x = 0;
+    else if (x > 255)
+        x = 255;
+    return (x & 0xFF);
+}
+
+void YUYVToNV21(int width, int height, void *src, void *dst)
+{
+    unsigned char *pSrcY = (unsigned char *) src;
+    unsigned char *pSrcU = pSrcY + 1;
+    unsigned char *pSrcV = pSrcY + 3;
+
+    unsigned char *pDstY = (unsigned char *) dst;
+    unsigned char *pDstUV = pDstY + width * height;
+
+    // YUYV format is: yuyvyuyvyuyv...yuyv
+    // NV12 format is: yyyy...yyyyuvuv...uvuvuv
+    for (int i = 0; i < height; i++) {
+        for (int j = 0; j < width / 2; j++) { // 2 y-pixels at a time
+            *pDstY++ = *pSrcY;
+            pSrcY += 2;
+            *pDstY++ = *pSrcY;
+            pSrcY += 2;
+
+            // 4:2:2 chroma has 1/2 the horizontal and FULL vertical resolution of full image
+            // 4:2:0 chroma has 1/2 the horizontal and 1/2 vertical resolution of full image
+            // so skip odd numbered rows
+            if ((i % 2) == 0) {
+                *pDstUV++ = *pSrcV;
+                *pDstUV++ = *pSrcU;
+            }
+            pSrcU += 4;
+            pSrcV += 4;
+        }
+    }
+}
+
+void YUYVToNV12(int width, int height, void *src, void *dst)
+{
+    unsigned char *pSrcY = (unsigned char *) src;
+    unsigned char *pSrcU = pSrcY + 1;
+    unsigned char *pSrcV = pSrcY + 3;
+
+    unsigned char *pDstY = (unsigned char *) dst;
+    unsigned char *pDstUV = pDstY + width * height;
+
+    // YUYV format is: yuyvyuyvyuyv...yuyv
+    // NV12 format is: yyyy...yyyyuvuv...uvuvuv
+    for (int i = 0; i < height; i++) {
+        for (int j = 0; j < width / 2; j++) { // 2 y-pixels at a time
+            *pDstY++ = *pSrcY;
+            pSrcY += 2;
+            *pDstY++ = *pSrcY;
+            pSrcY += 2;
+
+            // 4:2:2 chroma has 1/2 the horizontal and FULL vertical resolution of full image
+            // 4:2:0 chroma has 1/2 the horizontal and 1/2 vertical resolution of full image
+            // so skip odd numbered rows
+            if ((i % 2) == 0) {
+                *pDstUV++ = *pSrcU;
+                *pDstUV++ = *pSrcV;
+            }
+            pSrcU += 4;
+            pSrcV += 4;
+        }
+    }
+}
+
+void YUYVToRGB8888(int width, int height, void *src, void *dst)
+{
+    int len = width * height * 2;
+    int i = 0;
+    unsigned char *pYUV = (unsigned char *)src;   //four bytes of two pixels
+    unsigned char *pRGB = (unsigned char *)dst;       //6 rgb bytes for two pixels
+    int C, D, E;
+    len -= len % 4;
+    for (i = 0; i < len; i += 4) {
+        unsigned char y1 = *(pYUV++);
+        unsigned char u = *(pYUV++);
+        unsigned char y2 = *(pYUV++);
+        unsigned char v = *(pYUV++);
+//calculate 1st pixel
+        C = y1 - 16;
+        D = u - 128;
+        E = v -128;
+        *(pRGB++) = clamp((C * 298 + E * 409 + 128) >> 8);
+        *(pRGB++) = clamp((C * 298 - D * 100 - E * 208 + 128) >> 8);
+        *(pRGB++) = clamp((C * 298 + D * 516 + 128) >> 8);
+        //alpha
+        *(pRGB++) = 0xFF;
+//calculate 2nd pixel
+        C = y2 -16;
+        *(pRGB++) = clamp((C * 298 + E * 409 + 128) >> 8);
+        *(pRGB++) = clamp((C * 298 - D * 100 - E * 208 + 128) >> 8);
+        *(pRGB++) = clamp((C * 298 + D * 516 + 128) >> 8);
+        //alpha
+        *(pRGB++) = 0xFF;
+
+    }
+}
+
+void YUYVToRGB565(int width, int height, void *src, void *dst)
+{
+
+    unsigned char *yuvs = (unsigned char *) src;
+    unsigned char *rgbs = (unsigned char *) dst;
+
+    //points to the next luminance value pair
+    int lumPtr = 0;
+    //points to the next chromiance value pair
+    int chrPtr = 1;
+    //points to the next byte output pair of RGB565 value
+    int outPtr = 0;
+
+    while (true) {
+
+        if (lumPtr == width * height * 2) // our work is done here!
+            break;
+
+        //read the luminance
+        int Y1 = yuvs[lumPtr] & 0xff;
+        lumPtr += 2;
+        int Y2 = yuvs[lumPtr] & 0xff;
+        lumPtr += 2;
+
+        //read the chroma
+        int Cb = (yuvs[chrPtr] & 0xff) - 128;
+        chrPtr += 2;
+        int Cr = (yuvs[chrPtr] & 0xff) - 128;
+        chrPtr += 2;
+        int R, G, B;
+
+        //generate first RGB components
+        B = clamp(Y1 + ((454 * Cb) >> 8));
+        G = clamp(Y1 - ((88 * Cb + 183 * Cr) >> 8));
+        R = clamp(Y1 + ((359 * Cr) >> 8));
+        //NOTE: this assume little-endian encoding
+        rgbs[outPtr++]  = (unsigned char) (((G & 0x3c) << 3) | (B >> 3));
+        rgbs[outPtr++]  = (unsigned char) ((R & 0xf8) | (G >> 5));
+
+        //generate second RGB components
+        B = clamp(Y2 + ((454 * Cb) >> 8));
+        G = clamp(Y2 - ((88 * Cb + 183 * Cr) >> 8));
+        R = clamp(Y2 + ((359 * Cr) >> 8));
+        //NOTE: this assume little-endian encoding
+        rgbs[outPtr++]  = (unsigned char) (((G & 0x3c) << 3) | (B >> 3));
+        rgbs[outPtr++]  = (unsigned char) ((R & 0xf8) | (G >> 5));
+    }
+}
+
+void NV12ToRGB565(int width, int height, void *src, void *dst)
+{
+
+    unsigned char *yuvs = (unsigned char *) src;
+    unsigned char *rgbs = (unsigned char *) dst;
+
+    //the end of the luminance data
+    int lumEnd = width * height;
+    //points to the next luminance value pair
+    int lumPtr = 0;
+    //points to the next chromiance value pair
+    int chrPtr = lumEnd;
+    //points to the next byte output pair of RGB565 value
+    int outPtr = 0;
+    //the end of the current luminance scanline
+    int lineEnd = width;
+
+    while (true) {
+        //skip back to the start of the chromiance values when necessary
+        if (lumPtr == lineEnd) {
+            if (lumPtr == lumEnd) break; //we've reached the end
+            //division here is a bit expensive, but's only done once per scanline
+            chrPtr = lumEnd + ((lumPtr  >> 1) / width) * width;
+            lineEnd += width;
+        }
+        //read the luminance and chromiance values
+        int Y1 = yuvs[lumPtr++] & 0xff;
+        int Y2 = yuvs[lumPtr++] & 0xff;
+        int Cb = (yuvs[chrPtr++] & 0xff) - 128;
+        int Cr = (yuvs[chrPtr++] & 0xff) - 128;
+        int R, G, B;
+
+        //generate first RGB components
+        B = Y1 + ((454 * Cb) >> 8);
+        if(B < 0) B = 0; else if(B > 255) B = 255;
+        G = Y1 - ((88 * Cb + 183 * Cr) >> 8);
+        if(G < 0) G = 0; else if(G > 255) G = 255;
+        R = Y1 + ((359 * Cr) >> 8);
+        if(R < 0) R = 0; else if(R > 255) R = 255;
+        //NOTE: this assume little-endian encoding
+        rgbs[outPtr++]  = (unsigned char) (((G & 0x3c) << 3) | (B >> 3));
+        rgbs[outPtr++]  = (unsigned char) ((R & 0xf8) | (G >> 5));
+
+        //generate second RGB components
+        B = Y2 + ((454 * Cb) >> 8);
+        if(B < 0) B = 0; else if(B > 255) B = 255;
+        G = Y2 - ((88 * Cb + 183 * Cr) >> 8);
+        if(G < 0) G = 0; else if(G > 255) G = 255;
+        R = Y2 + ((359 * Cr) >> 8);
+        if(R < 0) R = 0; else if(R > 255) R = 255;
+        //NOTE: this assume little-endian encoding
+        rgbs[outPtr++]  = (unsigned char) (((G & 0x3c) << 3) | (B >> 3));
+        rgbs[outPtr++]  = (unsigned char) ((R & 0xf8) | (G >> 5));
+    }
+}
+
+void NV12ToRGB565withStride(int width, int height,int stride,int alignheight, void *src, void *dst)
+{
+
+    unsigned char *yuvs = (unsigned char *) src;
+    unsigned char *rgbs = (unsigned char *) dst;
+
+    //the end of the luminance data
+    int lumEnd = stride * alignheight;
+    //points to the next luminance value pair
+    int lumPtr = 0;
+    //points to the next chromiance value pair
+    int chrPtr = lumEnd;
+    //points to the next byte output pair of RGB565 value
+    int outPtr = 0;
+    //the end of the current luminance scanline
+    int lineEnd = width;
+    int diff = stride-width;
+    int actLumEnd = stride*height;
+    while (true) {
+        //skip back to the start of the chromiance values when necessary
+        if (lumPtr == lineEnd) {
+            if (lumPtr == (actLumEnd-diff)) break; //we've reached the end
+            //division here is a bit expensive, but's only done once per scanline
+            lumPtr += diff;
+            chrPtr = lumEnd + ((lumPtr  >> 1) / stride) * stride;
+            lineEnd += stride;
+        }
+        //read the luminance and chromiance values
+        int Y1 = yuvs[lumPtr++] & 0xff;
+        int Y2 = yuvs[lumPtr++] & 0xff;
+        int Cb = (yuvs[chrPtr++] & 0xff) - 128;
+        int Cr = (yuvs[chrPtr++] & 0xff) - 128;
+        int R, G, B;
+
+        //generate first RGB components
+        B = Y1 + ((454 * Cb) >> 8);
+        if(B < 0) B = 0; else if(B > 255) B = 255;
+        G = Y1 - ((88 * Cb + 183 * Cr) >> 8);
+        if(G < 0) G = 0; else if(G > 255) G = 255;
+        R = Y1 + ((359 * Cr) >> 8);
+        if(R < 0) R = 0; else if(R > 255) R = 255;
+        //NOTE: this assume little-endian encoding
+        rgbs[outPtr++]  = (unsigned char) (((G & 0x3c) << 3) | (B >> 3));
+        rgbs[outPtr++]  = (unsigned char) ((R & 0xf8) | (G >> 5));
+
+        //generate second RGB components
+        B = Y2 + ((454 * Cb) >> 8);
+        if(B < 0) B = 0; else if(B > 255) B = 255;
+        G = Y2 - ((88 * Cb + 183 * Cr) >> 8);
+        if(G < 0) G = 0; else if(G > 255) G = 255;
+        R = Y2 + ((359 * Cr) >> 8);
+        if(R < 0) R = 0; else if(R > 255) R = 255;
+        //NOTE: this assume little-endian encoding
+        rgbs[outPtr++]  = (unsigned char) (((G & 0x3c) << 3) | (B >> 3));
+        rgbs[outPtr++]  = (unsigned char) ((R & 0xf8) | (G >> 5));
+    }
+}
+
+void YV12ToBGR565(int width, int height, int stride, void *src, void *dst)
+{
+    unsigned char *yuvs = (unsigned char *)src;
+    unsigned char *rgbs = (unsigned char *)dst;
+
+    //the end of the luminance data
+    int lumEnd = stride * height;
+    //points to the next luminance value pair
+    int lumPtr = 0;
+    //points to the next chromiance value pair
+    int chrPtrU = 0, chrPtrV = 0;
+
+    for (int i = 0; i < height; i += 2) {
+        lumPtr = i * stride;
+        chrPtrV = i / 2 * stride / 2 + lumEnd;
+        chrPtrU = i / 2 * stride / 2 + lumEnd + (stride / 2 * height / 2);
+        unsigned char *rgbStart = rgbs;
+        for (int j = 0; j < width; j += 2 ) {
+            //read the luminance and chromiance values
+            int Cb = (yuvs[chrPtrU ++] & 0xff) - 128;
+            int Cr = (yuvs[chrPtrV ++] & 0xff) - 128;
+
+            for (int m = 0; m < 2; m ++) { // m
+                int lumLine = lumPtr + m * stride;
+                unsigned char* pxlrgb = rgbStart + m * width * 2;
+                for (int n = 0; n < 2; n ++) { // n
+                    int Y = yuvs[lumLine ++] & 0xff;
+                    int R, G, B;
+                    B = Y + ((454 * Cb) >> 8);
+                    if(B < 0) B = 0; else if(B > 255) B = 255;
+                    G = Y - ((88 * Cb + 183 * Cr) >> 8);
+                    if(G < 0) G = 0; else if(G > 255) G = 255;
+                    R = Y + ((359 * Cr) >> 8);
+                    if(R < 0) R = 0; else if(R > 255) R = 255;
+
+                    unsigned short *p = (unsigned short *)pxlrgb;
+                    *p = (B>>3) | ((G>>2)<<5) | ((R>>3)<<11);
+                    pxlrgb += 2;
+                } // n
+            } // m
+            lumPtr += 2;
+            rgbStart += 4;
+        } // j
+        rgbs += 4 * width; // 2 lines
+   } // i
+}
+
+void interleaveUVRow(const unsigned char *u, const unsigned char *v, unsigned char *dst, int n)
+{
+    for (int i = 0; i < n; i++) {
+        *dst++ = u[i];
+        *dst++ = v[i];
+    }
+}
+
+void deinterleaveUVRow(const unsigned char *src, unsigned char *u, unsigned char *v, int n)
+{
+    for (int i = 0; i < n; i++) {
+        u[i] = *src++;
+        v[i] = *src++;
+    }
+}
+
+void swapUVRow(const unsigned char *src, unsigned char *dst, int n)
+{
+    for (int i = 0; i < n * 2; i += 2) {
+        dst[i] = src[i + 1];
+        dst[i + 1] = src[i];
+    }
+}
+
+void averageRows(const unsigned char *a, const unsigned char *b, unsigned char *dst, int n)
+{
+    for (int i = 0; i < n; i++)
+        dst[i] = (a[i] + b[i]) / 2;
+}
+
+void planarToYUYVRow(const unsigned char *y, const unsigned char *u, const unsigned char *v,
+                     unsigned char *dst, int n)
+{
+    for (int i = 0; i < n; i++) {
+        *dst++ = *y++; // Y
+        *dst++ = u[i]; // U
+        *dst++ = *y++; // Y
+        *dst++ = v[i]; // V
+    }
+}
+
+// Per pixel helpers matching the scalar kernels above, used for the
+// tails the vector loops leave over.
+static inline void yuvToRGBA(int y, int u, int v, unsigned char *rgba)
+{
+    int C = y - 16;
+    int D = u - 128;
+    int E = v - 128;
+    rgba[0] = clamp((C * 298 + E * 409 + 128) >> 8);
+    rgba[1] = clamp((C * 298 - D * 100 - E * 208 + 128) >> 8);
+    rgba[2] = clamp((C * 298 + D * 516 + 128) >> 8);
+    rgba[3] = 0xFF;
+}
+
+static inline void yuvToRGB565(int y, int cb, int cr, unsigned char *rgb)
+{
+    int B = clamp(y + ((454 * cb) >> 8));
+    int G = clamp(y - ((88 * cb + 183 * cr) >> 8));
+    int R = clamp(y + ((359 * cr) >> 8));
+    rgb[0] = (unsigned char) (((G & 0x3c) << 3) | (B >> 3));
+    rgb[1] = (unsigned char) ((R & 0xf8) | (G >> 5));
+}
+
+#ifdef COLOR_CONVERT_X86
+
+#define SSSE3 __attribute__((target("ssse3")))
+#define AVX2 __attribute__((target("avx2")))
+
+/*
+ * SSSE3 kernels, 8 or 16 pixels per iteration.
+ *
+ * The RGB math keeps the exact integer rounding of the scalar code:
+ * products which can exceed 16 bits are done with pmaddwd in 32 bits,
+ * single coefficient terms use pmulhw on a pre-shifted operand, which
+ * gives the same floor as the arithmetic shift.
+ */
+
+// YUYV byte shuffles, per 16 byte lane
+#define SHUF_YUYV_Y16   0, -1, 2, -1, 4, -1, 6, -1, 8, -1, 10, -1, 12, -1, 14, -1
+#define SHUF_YUYV_U16   1, -1, 1, -1, 5, -1, 5, -1, 9, -1, 9, -1, 13, -1, 13, -1
+#define SHUF_YUYV_V16   3, -1, 3, -1, 7, -1, 7, -1, 11, -1, 11, -1, 15, -1, 15, -1
+// 16 bit interleaved UV words to duplicated U / V words
+#define SHUF_UV16_U     0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13
+#define SHUF_UV16_V     2, 3, 2, 3, 6, 7, 6, 7, 10, 11, 10, 11, 14, 15, 14, 15
+// YUYV to 8 Y bytes followed by 4 UV (or VU) pairs
+#define SHUF_YUYV_NV12  0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15
+#define SHUF_YUYV_NV21  0, 2, 4, 6, 8, 10, 12, 14, 3, 1, 7, 5, 11, 9, 15, 13
+
+SSSE3 static void yuyvToNVRow_ssse3(const unsigned char *src, unsigned char *dstY,
+                                    unsigned char *dstUV, int width, bool nv21)
+{
+    const __m128i shuf = nv21 ? _mm_setr_epi8(SHUF_YUYV_NV21) : _mm_setr_epi8(SHUF_YUYV_NV12);
+    int j = 0;
+
+    for (; j + 16 <= width; j += 16) {
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + j * 2)), shuf);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + j * 2 + 16)), shuf);
+        _mm_storeu_si128((__m128i *)(dstY + j), _mm_unpacklo_epi64(a, b));
+        if (dstUV)
+            _mm_storeu_si128((__m128i *)(dstUV + j), _mm_unpackhi_epi64(a, b));
+    }
+
+    for (; j + 1 < width; j += 2) {
+        dstY[j] = src[j * 2];
+        dstY[j + 1] = src[j * 2 + 2];
+        if (dstUV) {
+            dstUV[j] = nv21 ? src[j * 2 + 3] : src[j * 2 + 1];
+            dstUV[j + 1] = nv21 ? src[j * 2 + 1] : src[j * 2 + 3];
+        }
+    }
+}
+
+SSSE3 static void yuyvToNV_ssse3(int width, int height, void *src, void *dst, bool nv21)
+{
+    const unsigned char *pSrc = (const unsigned char *) src;
+    unsigned char *pDstY = (unsigned char *) dst;
+    unsigned char *pDstUV = pDstY + width * height;
+    int rowWidth = width & ~1;
+
+    for (int i = 0; i < height; i++) {
+        yuyvToNVRow_ssse3(pSrc, pDstY, (i % 2) == 0 ? pDstUV : NULL, rowWidth, nv21);
+        pSrc += rowWidth * 2;
+        pDstY += rowWidth;
+        if ((i % 2) == 0)
+            pDstUV += rowWidth;
+    }
+}
+
+SSSE3 static void YUYVToNV12_ssse3(int width, int height, void *src, void *dst)
+{
+    yuyvToNV_ssse3(width, height, src, dst, false);
+}
+
+SSSE3 static void YUYVToNV21_ssse3(int width, int height, void *src, void *dst)
+{
+    yuyvToNV_ssse3(width, height, src, dst, true);
+}
+
+// 8 pixels of 16 bit Y, U, V to 8 RGBA pixels
+SSSE3 static inline void yuv16ToRGBA_ssse3(__m128i y, __m128i u, __m128i v, unsigned char *dst)
+{
+    const __m128i c298_409 = _mm_setr_epi16(298, 409, 298, 409, 298, 409, 298, 409);
+    const __m128i c298_m100 = _mm_setr_epi16(298, -100, 298, -100, 298, -100, 298, -100);
+    const __m128i cm208_1 = _mm_setr_epi16(-208, 1, -208, 1, -208, 1, -208, 1);
+    const __m128i c298_516 = _mm_setr_epi16(298, 516, 298, 516, 298, 516, 298, 516);
+    const __m128i round = _mm_set1_epi32(128);
+    const __m128i round16 = _mm_set1_epi16(128);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(255);
+
+    __m128i C = _mm_sub_epi16(y, _mm_set1_epi16(16));
+    __m128i D = _mm_sub_epi16(u, round16);
+    __m128i E = _mm_sub_epi16(v, round16);
+
+    __m128i CElo = _mm_unpacklo_epi16(C, E), CEhi = _mm_unpackhi_epi16(C, E);
+    __m128i CDlo = _mm_unpacklo_epi16(C, D), CDhi = _mm_unpackhi_epi16(C, D);
+    __m128i E1lo = _mm_unpacklo_epi16(E, round16), E1hi = _mm_unpackhi_epi16(E, round16);
+
+    __m128i R = _mm_packs_epi32(
+            _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(CElo, c298_409), round), 8),
+            _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(CEhi, c298_409), round), 8));
+    __m128i G = _mm_packs_epi32(
+            _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(CDlo, c298_m100),
+                                         _mm_madd_epi16(E1lo, cm208_1)), 8),
+            _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(CDhi, c298_m100),
+                                         _mm_madd_epi16(E1hi, cm208_1)), 8));
+    __m128i B = _mm_packs_epi32(
+            _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(C, D), c298_516), round), 8),
+            _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(C, D), c298_516), round), 8));
+
+    R = _mm_min_epi16(_mm_max_epi16(R, zero), max);
+    G = _mm_min_epi16(_mm_max_epi16(G, zero), max);
+    B = _mm_min_epi16(_mm_max_epi16(B, zero), max);
+
+    __m128i RG = _mm_or_si128(R, _mm_slli_epi16(G, 8));
+    __m128i BA = _mm_or_si128(B, _mm_set1_epi16((short)0xFF00));
+    _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(RG, BA));
+    _mm_storeu_si128((__m128i *)(dst + 16), _mm_unpackhi_epi16(RG, BA));
+}
+
+// 8 pixels of 16 bit Y, Cb, Cr to 8 RGB565 pixels
+SSSE3 static inline __m128i yuv16ToRGB565_ssse3(__m128i y, __m128i u, __m128i v)
+{
+    const __m128i c88_183 = _mm_setr_epi16(88, 183, 88, 183, 88, 183, 88, 183);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(255);
+
+    __m128i cb = _mm_sub_epi16(u, _mm_set1_epi16(128));
+    __m128i cr = _mm_sub_epi16(v, _mm_set1_epi16(128));
+
+    // (454 * cb) >> 8 == ((cb << 7) * 908) >> 16
+    __m128i tb = _mm_mulhi_epi16(_mm_slli_epi16(cb, 7), _mm_set1_epi16(908));
+    __m128i tr = _mm_mulhi_epi16(_mm_slli_epi16(cr, 7), _mm_set1_epi16(718));
+    __m128i tg = _mm_packs_epi32(
+            _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(cb, cr), c88_183), 8),
+            _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(cb, cr), c88_183), 8));
+
+    __m128i B = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(y, tb), zero), max);
+    __m128i G = _mm_min_epi16(_mm_max_epi16(_mm_sub_epi16(y, tg), zero), max);
+    __m128i R = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(y, tr), zero), max);
+
+    return _mm_or_si128(_mm_or_si128(
+                _mm_slli_epi16(_mm_and_si128(R, _mm_set1_epi16(0xf8)), 8),
+                _mm_slli_epi16(_mm_and_si128(G, _mm_set1_epi16(0xfc)), 3)),
+                _mm_srli_epi16(B, 3));
+}
+
+SSSE3 static void YUYVToRGB8888_ssse3(int width, int height, void *src, void *dst)
+{
+    const __m128i shufY = _mm_setr_epi8(SHUF_YUYV_Y16);
+    const __m128i shufU = _mm_setr_epi8(SHUF_YUYV_U16);
+    const __m128i shufV = _mm_setr_epi8(SHUF_YUYV_V16);
+    const unsigned char *pYUV = (const unsigned char *) src;
+    unsigned char *pRGB = (unsigned char *) dst;
+    int pixels = (width * height) & ~1;
+    int i = 0;
+
+    for (; i + 8 <= pixels; i += 8) {
+        __m128i in = _mm_loadu_si128((const __m128i *)(pYUV + i * 2));
+        yuv16ToRGBA_ssse3(_mm_shuffle_epi8(in, shufY),
+                          _mm_shuffle_epi8(in, shufU),
+                          _mm_shuffle_epi8(in, shufV),
+                          pRGB + i * 4);
+    }
+
+    for (; i < pixels; i += 2) {
+        const unsigned char *p = pYUV + i * 2;
+        yuvToRGBA(p[0], p[1], p[3], pRGB + i * 4);
+        yuvToRGBA(p[2], p[1], p[3], pRGB + i * 4 + 4);
+    }
+}
+
+SSSE3 static void YUYVToRGB565_ssse3(int width, int height, void *src, void *dst)
+{
+    const __m128i shufY = _mm_setr_epi8(SHUF_YUYV_Y16);
+    const __m128i shufU = _mm_setr_epi8(SHUF_YUYV_U16);
+    const __m128i shufV = _mm_setr_epi8(SHUF_YUYV_V16);
+    const unsigned char *yuvs = (const unsigned char *) src;
+    unsigned char *rgbs = (unsigned char *) dst;
+    int pixels = (width * height) & ~1;
+    int i = 0;
+
+    for (; i + 8 <= pixels; i += 8) {
+        __m128i in = _mm_loadu_si128((const __m128i *)(yuvs + i * 2));
+        __m128i out = yuv16ToRGB565_ssse3(_mm_shuffle_epi8(in, shufY),
+                                          _mm_shuffle_epi8(in, shufU),
+                                          _mm_shuffle_epi8(in, shufV));
+        _mm_storeu_si128((__m128i *)(rgbs + i * 2), out);
+    }
+
+    for (; i < pixels; i += 2) {
+        const unsigned char *p = yuvs + i * 2;
+        yuvToRGB565(p[0], p[1] - 128, p[3] - 128, rgbs + i * 2);
+        yuvToRGB565(p[2], p[1] - 128, p[3] - 128, rgbs + i * 2 + 2);
+    }
+}
+
+SSSE3 static void nv12ToRGB565Row_ssse3(const unsigned char *y, const unsigned char *uv,
+                                        unsigned char *rgbs, int width)
+{
+    const __m128i shufU = _mm_setr_epi8(SHUF_UV16_U);
+    const __m128i shufV = _mm_setr_epi8(SHUF_UV16_V);
+    const __m128i zero = _mm_setzero_si128();
+    int j = 0;
+
+    for (; j + 8 <= width; j += 8) {
+        __m128i y16 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(y + j)), zero);
+        __m128i uv16 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(uv + j)), zero);
+        __m128i out = yuv16ToRGB565_ssse3(y16,
+                                          _mm_shuffle_epi8(uv16, shufU),
+                                          _mm_shuffle_epi8(uv16, shufV));
+        _mm_storeu_si128((__m128i *)(rgbs + j * 2), out);
+    }
+
+    for (; j + 1 < width; j += 2) {
+        yuvToRGB565(y[j], uv[j] - 128, uv[j + 1] - 128, rgbs + j * 2);
+        yuvToRGB565(y[j + 1], uv[j] - 128, uv[j + 1] - 128, rgbs + j * 2 + 2);
+    }
+}
+
+SSSE3 static void NV12ToRGB565withStride_ssse3(int width, int height, int stride, int alignheight, void *src, void *dst)
+{
+    const unsigned char *yuvs = (const unsigned char *) src;
+    const unsigned char *chroma = yuvs + stride * alignheight;
+    unsigned char *rgbs = (unsigned char *) dst;
+
+    for (int i = 0; i < height; i++) {
+        nv12ToRGB565Row_ssse3(yuvs + i * stride, chroma + (i >> 1) * stride,
+                              rgbs, width);
+        rgbs += width * 2;
+    }
+}
+
+SSSE3 static void NV12ToRGB565_ssse3(int width, int height, void *src, void *dst)
+{
+    NV12ToRGB565withStride_ssse3(width, height, width, height, src, dst);
+}
+
+SSSE3 static void yv12ToRGB565Row_ssse3(const unsigned char *y, const unsigned char *u,
+                                        const unsigned char *v, unsigned char *rgbs, int width)
+{
+    const __m128i shufU = _mm_setr_epi8(SHUF_UV16_U);
+    const __m128i shufV = _mm_setr_epi8(SHUF_UV16_V);
+    const __m128i zero = _mm_setzero_si128();
+    int j = 0;
+
+    for (; j + 16 <= width; j += 16) {
+        __m128i y8 = _mm_loadu_si128((const __m128i *)(y + j));
+        __m128i uv8 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(u + j / 2)),
+                                        _mm_loadl_epi64((const __m128i *)(v + j / 2)));
+        __m128i uv16 = _mm_unpacklo_epi8(uv8, zero);
+        __m128i out = yuv16ToRGB565_ssse3(_mm_unpacklo_epi8(y8, zero),
+                                          _mm_shuffle_epi8(uv16, shufU),
+                                          _mm_shuffle_epi8(uv16, shufV));
+        _mm_storeu_si128((__m128i *)(rgbs + j * 2), out);
+        uv16 = _mm_unpackhi_epi8(uv8, zero);
+        out = yuv16ToRGB565_ssse3(_mm_unpackhi_epi8(y8, zero),
+                                  _mm_shuffle_epi8(uv16, shufU),
+                                  _mm_shuffle_epi8(uv16, shufV));
+        _mm_storeu_si128((__m128i *)(rgbs + j * 2 + 16), out);
+    }
+
+    // like the C kernel, an odd width still writes the pixel pair
+    for (; j < width; j += 2) {
+        yuvToRGB565(y[j], u[j / 2] - 128, v[j / 2] - 128, rgbs + j * 2);
+        yuvToRGB565(y[j + 1], u[j / 2] - 128, v[j / 2] - 128, rgbs + j * 2 + 2);
+    }
+}
+
+SSSE3 static void YV12ToBGR565_ssse3(int width, int height, int stride, void *src, void *dst)
+{
+    const unsigned char *yuvs = (const unsigned char *) src;
+    unsigned char *rgbs = (unsigned char *) dst;
+    int lumEnd = stride * height;
+
+    for (int i = 0; i < height; i += 2) {
+        const unsigned char *v = yuvs + i / 2 * stride / 2 + lumEnd;
+        const unsigned char *u = v + stride / 2 * height / 2;
+        // bottom row first: with an odd width the C kernel lets the top
+        // row spill its last pixel over the first one of the bottom row
+        yv12ToRGB565Row_ssse3(yuvs + (i + 1) * stride, u, v, rgbs + width * 2, width);
+        yv12ToRGB565Row_ssse3(yuvs + i * stride, u, v, rgbs, width);
+        rgbs += 4 * width;
+    }
+}
+
+/*
+ * Row kernels of the planar / semi-planar converters, plain byte
+ * shuffles, 16 output pairs per iteration.
+ */
+
+SSSE3 static void interleaveUVRow_ssse3(const unsigned char *u, const unsigned char *v,
+                                        unsigned char *dst, int n)
+{
+    int i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(u + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(v + i));
+        _mm_storeu_si128((__m128i *)(dst + i * 2), _mm_unpacklo_epi8(a, b));
+        _mm_storeu_si128((__m128i *)(dst + i * 2 + 16), _mm_unpackhi_epi8(a, b));
+    }
+
+    for (; i < n; i++) {
+        dst[i * 2] = u[i];
+        dst[i * 2 + 1] = v[i];
+    }
+}
+
+SSSE3 static void deinterleaveUVRow_ssse3(const unsigned char *src, unsigned char *u,
+                                          unsigned char *v, int n)
+{
+    // even bytes then odd bytes, the same split as YUYV to Y and UV
+    const __m128i shuf = _mm_setr_epi8(SHUF_YUYV_NV12);
+    int i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + i * 2)), shuf);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + i * 2 + 16)), shuf);
+        _mm_storeu_si128((__m128i *)(u + i), _mm_unpacklo_epi64(a, b));
+        _mm_storeu_si128((__m128i *)(v + i), _mm_unpackhi_epi64(a, b));
+    }
+
+    for (; i < n; i++) {
+        u[i] = src[i * 2];
+        v[i] = src[i * 2 + 1];
+    }
+}
+
+SSSE3 static void swapUVRow_ssse3(const unsigned char *src, unsigned char *dst, int n)
+{
+    const __m128i shuf = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    int i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(src + i * 2));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + i * 2 + 16));
+        _mm_storeu_si128((__m128i *)(dst + i * 2), _mm_shuffle_epi8(a, shuf));
+        _mm_storeu_si128((__m128i *)(dst + i * 2 + 16), _mm_shuffle_epi8(b, shuf));
+    }
+
+    for (; i < n; i++) {
+        dst[i * 2] = src[i * 2 + 1];
+        dst[i * 2 + 1] = src[i * 2];
+    }
+}
+
+SSSE3 static void averageRows_ssse3(const unsigned char *a, const unsigned char *b,
+                                    unsigned char *dst, int n)
+{
+    // pavgb rounds up, take the carry back off when the sum is odd
+    const __m128i one = _mm_set1_epi8(1);
+    int i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        __m128i odd = _mm_and_si128(_mm_xor_si128(x, y), one);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_sub_epi8(_mm_avg_epu8(x, y), odd));
+    }
+
+    for (; i < n; i++)
+        dst[i] = (a[i] + b[i]) / 2;
+}
+
+SSSE3 static void planarToYUYVRow_ssse3(const unsigned char *y, const unsigned char *u,
+                                        const unsigned char *v, unsigned char *dst, int n)
+{
+    int i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i y0 = _mm_loadu_si128((const __m128i *)(y + i * 2));
+        __m128i y1 = _mm_loadu_si128((const __m128i *)(y + i * 2 + 16));
+        __m128i cu = _mm_loadu_si128((const __m128i *)(u + i));
+        __m128i cv = _mm_loadu_si128((const __m128i *)(v + i));
+        __m128i uvLo = _mm_unpacklo_epi8(cu, cv);
+        __m128i uvHi = _mm_unpackhi_epi8(cu, cv);
+        _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_unpacklo_epi8(y0, uvLo));
+        _mm_storeu_si128((__m128i *)(dst + i * 4 + 16), _mm_unpackhi_epi8(y0, uvLo));
+        _mm_storeu_si128((__m128i *)(dst + i * 4 + 32), _mm_unpacklo_epi8(y1, uvHi));
+        _mm_storeu_si128((__m128i *)(dst + i * 4 + 48), _mm_unpackhi_epi8(y1, uvHi));
+    }
+
+    for (; i < n; i++) {
+        dst[i * 4] = y[i * 2];
+        dst[i * 4 + 1] = u[i];
+        dst[i * 4 + 2] = y[i * 2 + 1];
+        dst[i * 4 + 3] = v[i];
+    }
+}
+
+/*
+ * AVX2 kernels, twice the SSSE3 width. All shuffles and packs are in
+ * lane, so each 128 bit lane runs the SSSE3 algorithm on its own half of
+ * the pixels and only the final stores need a cross lane permute.
+ */
+
+AVX2 static void yuyvToNVRow_avx2(const unsigned char *src, unsigned char *dstY,
+                                  unsigned char *dstUV, int width, bool nv21)
+{
+    const __m256i shuf = nv21 ?
+            _mm256_setr_epi8(SHUF_YUYV_NV21, SHUF_YUYV_NV21) :
+            _mm256_setr_epi8(SHUF_YUYV_NV12, SHUF_YUYV_NV12);
+    int j = 0;
+
+    for (; j + 32 <= width; j += 32) {
+        __m256i a = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(src + j * 2)), shuf);
+        __m256i b = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(src + j * 2 + 32)), shuf);
+        // lanes hold [a0 b0 | a1 b1], reorder 64 bit quarters to a0 a1 b0 b1
+        __m256i y = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a, b), 0xd8);
+        _mm256_storeu_si256((__m256i *)(dstY + j), y);
+        if (dstUV) {
+            __m256i uv = _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(a, b), 0xd8);
+            _mm256_storeu_si256((__m256i *)(dstUV + j), uv);
+        }
+    }
+
+    if (j < width)
+        yuyvToNVRow_ssse3(src + j * 2, dstY + j, dstUV ? dstUV + j : NULL, width - j, nv21);
+}
+
+AVX2 static void yuyvToNV_avx2(int width, int height, void *src, void *dst, bool nv21)
+{
+    const unsigned char *pSrc = (const unsigned char *) src;
+    unsigned char *pDstY = (unsigned char *) dst;
+    unsigned char *pDstUV = pDstY + width * height;
+    int rowWidth = width & ~1;
+
+    for (int i = 0; i < height; i++) {
+        yuyvToNVRow_avx2(pSrc, pDstY, (i % 2) == 0 ? pDstUV : NULL, rowWidth, nv21);
+        pSrc += rowWidth * 2;
+        pDstY += rowWidth;
+        if ((i % 2) == 0)
+            pDstUV += rowWidth;
+    }
+}
+
+AVX2 static void YUYVToNV12_avx2(int width, int height, void *src, void *dst)
+{
+    yuyvToNV_avx2(width, height, src, dst, false);
+}
+
+AVX2 static void YUYVToNV21_avx2(int width, int height, void *src, void *dst)
+{
+    yuyvToNV_avx2(width, height, src, dst, true);
+}
+
+#define DUP8(a, b) a, b, a, b, a, b, a, b
+#define DUP16(a, b) DUP8(a, b), DUP8(a, b)
+
+// 16 pixels of 16 bit Y, U, V to 16 RGBA pixels
+AVX2 static inline void yuv16ToRGBA_avx2(__m256i y, __m256i u, __m256i v, unsigned char *dst)
+{
+    const __m256i c298_409 = _mm256_setr_epi16(DUP16(298, 409));
+    const __m256i c298_m100 = _mm256_setr_epi16(DUP16(298, -100));
+    const __m256i cm208_1 = _mm256_setr_epi16(DUP16(-208, 1));
+    const __m256i c298_516 = _mm256_setr_epi16(DUP16(298, 516));
+    const __m256i round = _mm256_set1_epi32(128);
+    const __m256i round16 = _mm256_set1_epi16(128);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi16(255);
+
+    __m256i C = _mm256_sub_epi16(y, _mm256_set1_epi16(16));
+    __m256i D = _mm256_sub_epi16(u, round16);
+    __m256i E = _mm256_sub_epi16(v, round16);
+
+    __m256i CElo = _mm256_unpacklo_epi16(C, E), CEhi = _mm256_unpackhi_epi16(C, E);
+    __m256i CDlo = _mm256_unpacklo_epi16(C, D), CDhi = _mm256_unpackhi_epi16(C, D);
+    __m256i E1lo = _mm256_unpacklo_epi16(E, round16), E1hi = _mm256_unpackhi_epi16(E, round16);
+
+    __m256i R = _mm256_packs_epi32(
+            _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(CElo, c298_409), round), 8),
+            _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(CEhi, c298_409), round), 8));
+    __m256i G = _mm256_packs_epi32(
+            _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(CDlo, c298_m100),
+                                               _mm256_madd_epi16(E1lo, cm208_1)), 8),
+            _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(CDhi, c298_m100),
+                                               _mm256_madd_epi16(E1hi, cm208_1)), 8));
+    __m256i B = _mm256_packs_epi32(
+            _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(CDlo, c298_516), round), 8),
+            _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(CDhi, c298_516), round), 8));
+
+    R = _mm256_min_epi16(_mm256_max_epi16(R, zero), max);
+    G = _mm256_min_epi16(_mm256_max_epi16(G, zero), max);
+    B = _mm256_min_epi16(_mm256_max_epi16(B, zero), max);
+
+    __m256i RG = _mm256_or_si256(R, _mm256_slli_epi16(G, 8));
+    __m256i BA = _mm256_or_si256(B, _mm256_set1_epi16((short)0xFF00));
+    __m256i lo = _mm256_unpacklo_epi16(RG, BA);
+    __m256i hi = _mm256_unpackhi_epi16(RG, BA);
+    _mm256_storeu_si256((__m256i *)dst, _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256((__m256i *)(dst + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+// 16 pixels of 16 bit Y, Cb, Cr to 16 RGB565 pixels
+AVX2 static inline __m256i yuv16ToRGB565_avx2(__m256i y, __m256i u, __m256i v)
+{
+    const __m256i c88_183 = _mm256_setr_epi16(DUP16(88, 183));
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi16(255);
+
+    __m256i cb = _mm256_sub_epi16(u, _mm256_set1_epi16(128));
+    __m256i cr = _mm256_sub_epi16(v, _mm256_set1_epi16(128));
+
+    __m256i tb = _mm256_mulhi_epi16(_mm256_slli_epi16(cb, 7), _mm256_set1_epi16(908));
+    __m256i tr = _mm256_mulhi_epi16(_mm256_slli_epi16(cr, 7), _mm256_set1_epi16(718));
+    __m256i tg = _mm256_packs_epi32(
+            _mm256_srai_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(cb, cr), c88_183), 8),
+            _mm256_srai_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(cb, cr), c88_183), 8));
+
+    __m256i B = _mm256_min_epi16(_mm256_max_epi16(_mm256_add_epi16(y, tb), zero), max);
+    __m256i G = _mm256_min_epi16(_mm256_max_epi16(_mm256_sub_epi16(y, tg), zero), max);
+    __m256i R = _mm256_min_epi16(_mm256_max_epi16(_mm256_add_epi16(y, tr), zero), max);
+
+    return _mm256_or_si256(_mm256_or_si256(
+                _mm256_slli_epi16(_mm256_and_si256(R, _mm256_set1_epi16(0xf8)), 8),
+                _mm256_slli_epi16(_mm256_and_si256(G, _mm256_set1_epi16(0xfc)), 3)),
+                _mm256_srli_epi16(B, 3));
+}
+
+AVX2 static void YUYVToRGB8888_avx2(int width, int height, void *src, void *dst)
+{
+    const __m256i shufY = _mm256_setr_epi8(SHUF_YUYV_Y16, SHUF_YUYV_Y16);
+    const __m256i shufU = _mm256_setr_epi8(SHUF_YUYV_U16, SHUF_YUYV_U16);
+    const __m256i shufV = _mm256_setr_epi8(SHUF_YUYV_V16, SHUF_YUYV_V16);
+    const unsigned char *pYUV = (const unsigned char *) src;
+    unsigned char *pRGB = (unsigned char *) dst;
+    int pixels = (width * height) & ~1;
+    int i = 0;
+
+    for (; i + 16 <= pixels; i += 16) {
+        __m256i in = _mm256_loadu_si256((const __m256i *)(pYUV + i * 2));
+        yuv16ToRGBA_avx2(_mm256_shuffle_epi8(in, shufY),
+                         _mm256_shuffle_epi8(in, shufU),
+                         _mm256_shuffle_epi8(in, shufV),
+                         pRGB + i * 4);
+    }
+
+    for (; i < pixels; i += 2) {
+        const unsigned char *p = pYUV + i * 2;
+        yuvToRGBA(p[0], p[1], p[3], pRGB + i * 4);
+        yuvToRGBA(p[2], p[1], p[3], pRGB + i * 4 + 4);
+    }
+}
+
+AVX2 static void YUYVToRGB565_avx2(int width, int height, void *src, void *dst)
+{
+    const __m256i shufY = _mm256_setr_epi8(SHUF_YUYV_Y16, SHUF_YUYV_Y16);
+    const __m256i shufU = _mm256_setr_epi8(SHUF_YUYV_U16, SHUF_YUYV_U16);
+    const __m256i shufV = _mm256_setr_epi8(SHUF_YUYV_V16, SHUF_YUYV_V16);
+    const unsigned char *yuvs = (const unsigned char *) src;
+    unsigned char *rgbs = (unsigned char *) dst;
+    int pixels = (width * height) & ~1;
+    int i = 0;
+
+    for (; i + 16 <= pixels; i += 16) {
+        __m256i in = _mm256_loadu_si256((const __m256i *)(yuvs + i * 2));
+        __m256i out = yuv16ToRGB565_avx2(_mm256_shuffle_epi8(in, shufY),
+                                         _mm256_shuffle_epi8(in, shufU),
+                                         _mm256_shuffle_epi8(in, shufV));
+        _mm256_storeu_si256((__m256i *)(rgbs + i * 2), out);
+    }
+
+    for (; i < pixels; i += 2) {
+        const unsigned char *p = yuvs + i * 2;
+        yuvToRGB565(p[0], p[1] - 128, p[3] - 128, rgbs + i * 2);
+        yuvToRGB565(p[2], p[1] - 128, p[3] - 128, rgbs + i * 2 + 2);
+    }
+}
+
+AVX2 static void NV12ToRGB565withStride_avx2(int width, int height, int stride, int alignheight, void *src, void *dst)
+{
+    const __m256i shufU = _mm256_setr_epi8(SHUF_UV16_U, SHUF_UV16_U);
+    const __m256i shufV = _mm256_setr_epi8(SHUF_UV16_V, SHUF_UV16_V);
+    const unsigned char *yuvs = (const unsigned char *) src;
+    const unsigned char *chroma = yuvs + stride * alignheight;
+    unsigned char *rgbs = (unsigned char *) dst;
+
+    for (int i = 0; i < height; i++) {
+        const unsigned char *y = yuvs + i * stride;
+        const unsigned char *uv = chroma + (i >> 1) * stride;
+        int j = 0;
+
+        for (; j + 16 <= width; j += 16) {
+            __m256i y16 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(y + j)));
+            __m256i uv16 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(uv + j)));
+            __m256i out = yuv16ToRGB565_avx2(y16,
+                                             _mm256_shuffle_epi8(uv16, shufU),
+                                             _mm256_shuffle_epi8(uv16, shufV));
+            _mm256_storeu_si256((__m256i *)(rgbs + j * 2), out);
+        }
+
+        if (j < width)
+            nv12ToRGB565Row_ssse3(y + j, uv + j, rgbs + j * 2, width - j);
+
+        rgbs += width * 2;
+    }
+}
+
+AVX2 static void NV12ToRGB565_avx2(int width, int height, void *src, void *dst)
+{
+    NV12ToRGB565withStride_avx2(width, height, width, height, src, dst);
+}
+
+AVX2 static void YV12ToBGR565_avx2(int width, int height, int stride, void *src, void *dst)
+{
+    const __m256i shufU = _mm256_setr_epi8(SHUF_UV16_U, SHUF_UV16_U);
+    const __m256i shufV = _mm256_setr_epi8(SHUF_UV16_V, SHUF_UV16_V);
+    const unsigned char *yuvs = (const unsigned char *) src;
+    unsigned char *rgbs = (unsigned char *) dst;
+    int lumEnd = stride * height;
+
+    for (int i = 0; i < height; i += 2) {
+        const unsigned char *v = yuvs + i / 2 * stride / 2 + lumEnd;
+        const unsigned char *u = v + stride / 2 * height / 2;
+
+        // bottom row first, see YV12ToBGR565_ssse3
+        for (int m = 1; m >= 0; m--) {
+            const unsigned char *y = yuvs + (i + m) * stride;
+            unsigned char *out = rgbs + m * width * 2;
+            int j = 0;
+
+            for (; j + 16 <= width; j += 16) {
+                __m256i y16 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(y + j)));
+                __m256i uv16 = _mm256_cvtepu8_epi16(
+                        _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(u + j / 2)),
+                                          _mm_loadl_epi64((const __m128i *)(v + j / 2))));
+                __m256i rgb = yuv16ToRGB565_avx2(y16,
+                                                 _mm256_shuffle_epi8(uv16, shufU),
+                                                 _mm256_shuffle_epi8(uv16, shufV));
+                _mm256_storeu_si256((__m256i *)(out + j * 2), rgb);
+            }
+
+            if (j < width)
+                yv12ToRGB565Row_ssse3(y + j, u + j / 2, v + j / 2, out + j * 2, width - j);
+        }
+        rgbs += 4 * width;
+    }
+}
+
+AVX2 static void interleaveUVRow_avx2(const unsigned char *u, const unsigned char *v,
+                                      unsigned char *dst, int n)
+{
+    int i = 0;
+
+    for (; i + 32 <= n; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(u + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(v + i));
+        __m256i lo = _mm256_unpacklo_epi8(a, b);
+        __m256i hi = _mm256_unpackhi_epi8(a, b);
+        _mm256_storeu_si256((__m256i *)(dst + i * 2), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i *)(dst + i * 2 + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+
+    if (i < n)
+        interleaveUVRow_ssse3(u + i, v + i, dst + i * 2, n - i);
+}
+
+AVX2 static void swapUVRow_avx2(const unsigned char *src, unsigned char *dst, int n)
+{
+    const __m256i shuf = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                          1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    int i = 0;
+
+    for (; i + 32 <= n; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(src + i * 2));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src + i * 2 + 32));
+        _mm256_storeu_si256((__m256i *)(dst + i * 2), _mm256_shuffle_epi8(a, shuf));
+        _mm256_storeu_si256((__m256i *)(dst + i * 2 + 32), _mm256_shuffle_epi8(b, shuf));
+    }
+
+    if (i < n)
+        swapUVRow_ssse3(src + i * 2, dst + i * 2, n - i);
+}
+
+AVX2 static void averageRows_avx2(const unsigned char *a, const unsigned char *b,
+                                  unsigned char *dst, int n)
+{
+    const __m256i one = _mm256_set1_epi8(1);
+    int i = 0;
+
+    for (; i + 32 <= n; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+        __m256i odd = _mm256_and_si256(_mm256_xor_si256(x, y), one);
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_sub_epi8(_mm256_avg_epu8(x, y), odd));
+    }
+
+    if (i < n)
+        averageRows_ssse3(a + i, b + i, dst + i, n - i);
+}
+
+#endif // COLOR_CONVERT_X86
+
+static const ColorConvertKernels sKernels[COLOR_CONVERT_ISA_NUM] = {
+    {
+        COLOR_CONVERT_ISA_C, "c",
+        YUYVToNV21, YUYVToNV12, YUYVToRGB8888, YUYVToRGB565,
+        NV12ToRGB565, NV12ToRGB565withStride, YV12ToBGR565,
+        interleaveUVRow, deinterleaveUVRow, swapUVRow, averageRows, planarToYUYVRow,
+    },
+#ifdef COLOR_CONVERT_X86
+    {
+        COLOR_CONVERT_ISA_SSSE3, "ssse3",
+        YUYVToNV21_ssse3, YUYVToNV12_ssse3, YUYVToRGB8888_ssse3, YUYVToRGB565_ssse3,
+        NV12ToRGB565_ssse3, NV12ToRGB565withStride_ssse3, YV12ToBGR565_ssse3,
+        interleaveUVRow_ssse3, deinterleaveUVRow_ssse3, swapUVRow_ssse3, averageRows_ssse3,
+        planarToYUYVRow_ssse3,
+    },
+    {
+        COLOR_CONVERT_ISA_AVX2, "avx2",
+        YUYVToNV21_avx2, YUYVToNV12_avx2, YUYVToRGB8888_avx2, YUYVToRGB565_avx2,
+        NV12ToRGB565_avx2, NV12ToRGB565withStride_avx2, YV12ToBGR565_avx2,
+        // on whole frames the 256 bit deinterleave and YUYV packing lose
+        // to the SSSE3 ones
+        interleaveUVRow_avx2, deinterleaveUVRow_ssse3, swapUVRow_avx2, averageRows_avx2,
+        planarToYUYVRow_ssse3,
+    },
+#endif
+};
+
+static bool isaSupported(int isa)
+{
+    switch (isa) {
+    case COLOR_CONVERT_ISA_C:
+        return true;
+#ifdef COLOR_CONVERT_X86
+    case COLOR_CONVERT_ISA_SSSE3:
+        return __builtin_cpu_supports("ssse3");
+    case COLOR_CONVERT_ISA_AVX2:
+        // the AVX2 tails fall back to the SSSE3 row kernels
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("ssse3");
+#endif
+    default:
+        return false;
+    }
+}
+
+static pthread_once_t sKernelsOnce = PTHREAD_ONCE_INIT;
+static const ColorConvertKernels *sBestKernels = &sKernels[COLOR_CONVERT_ISA_C];
+
+static void selectKernels()
+{
+#ifdef COLOR_CONVERT_X86
+    __builtin_cpu_init();
+#endif
+    for (int isa = COLOR_CONVERT_ISA_NUM - 1; isa > COLOR_CONVERT_ISA_C; isa--) {
+        if (isaSupported(isa)) {
+            sBestKernels = &sKernels[isa];
+            break;
+        }
+    }
+}
+
+const ColorConvertKernels *getColorConvertKernels()
+{
+    pthread_once(&sKernelsOnce, selectKernels);
+    return sBestKernels;
+}
+
+const ColorConvertKernels *getColorConvertKernels(int isa)
+{
+    pthread_once(&sKernelsOnce, selectKernels);
+    if (isa < 0 || isa >= COLOR_CONVERT_ISA_NUM || !isaSupported(isa))
+        return NULL;
+    return &sKernels[isa];
+}
+
+}; // namespace android
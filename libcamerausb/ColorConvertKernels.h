@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBCAMERA_COLOR_CONVERT_KERNELS_H
+#define ANDROID_LIBCAMERA_COLOR_CONVERT_KERNELS_H
+
+namespace android {
+
+// Scalar reference kernels. These define the expected output, the SIMD
+// kernels must be bit exact with them.
+void YUYVToNV21(int width, int height, void *src, void *dst);
+void YUYVToNV12(int width, int height, void *src, void *dst);
+void YUYVToRGB8888(int width, int height, void *src, void *dst);
+void YUYVToRGB565(int width, int height, void *src, void *dst);
+void NV12ToRGB565(int width, int height, void *src, void *dst);
+void NV12ToRGB565withStride(int width, int height, int stride, int alignheight, void *src, void *dst);
+void YV12ToBGR565(int width, int height, int stride, void *src, void *dst);
+
+// Scalar reference row kernels of the planar / semi-planar converters,
+// @n counts output pairs (or YUYV macro pixels, or averaged bytes).
+// dst[2i] = u[i], dst[2i + 1] = v[i]
+void interleaveUVRow(const unsigned char *u, const unsigned char *v, unsigned char *dst, int n);
+// u[i] = src[2i], v[i] = src[2i + 1]
+void deinterleaveUVRow(const unsigned char *src, unsigned char *u, unsigned char *v, int n);
+// dst[2i] = src[2i + 1], dst[2i + 1] = src[2i]
+void swapUVRow(const unsigned char *src, unsigned char *dst, int n);
+// dst[i] = (a[i] + b[i]) / 2, truncated
+void averageRows(const unsigned char *a, const unsigned char *b, unsigned char *dst, int n);
+// Y plane (2n bytes), U and V planes (n bytes) to n YUYV macro pixels
+void planarToYUYVRow(const unsigned char *y, const unsigned char *u, const unsigned char *v,
+                     unsigned char *dst, int n);
+
+enum ColorConvertIsa {
+    COLOR_CONVERT_ISA_C = 0,
+    COLOR_CONVERT_ISA_SSSE3,
+    COLOR_CONVERT_ISA_AVX2,
+    COLOR_CONVERT_ISA_NUM,
+};
+
+struct ColorConvertKernels {
+    int isa;
+    const char *name;
+    void (*yuyvToNV21)(int width, int height, void *src, void *dst);
+    void (*yuyvToNV12)(int width, int height, void *src, void *dst);
+    void (*yuyvToRGB8888)(int width, int height, void *src, void *dst);
+    void (*yuyvToRGB565)(int width, int height, void *src, void *dst);
+    void (*nv12ToRGB565)(int width, int height, void *src, void *dst);
+    void (*nv12ToRGB565withStride)(int width, int height, int stride, int alignheight, void *src, void *dst);
+    void (*yv12ToBGR565)(int width, int height, int stride, void *src, void *dst);
+    void (*interleaveUVRow)(const unsigned char *u, const unsigned char *v, unsigned char *dst, int n);
+    void (*deinterleaveUVRow)(const unsigned char *src, unsigned char *u, unsigned char *v, int n);
+    void (*swapUVRow)(const unsigned char *src, unsigned char *dst, int n);
+    void (*averageRows)(const unsigned char *a, const unsigned char *b, unsigned char *dst, int n);
+    void (*planarToYUYVRow)(const unsigned char *y, const unsigned char *u, const unsigned char *v,
+                            unsigned char *dst, int n);
+};
+
+// kernels of the best instruction set supported by the running CPU,
+// picked once on first use
+const ColorConvertKernels *getColorConvertKernels();
+
+// kernels of a given instruction set, NULL if the CPU or the build does
+// not support it
+const ColorConvertKernels *getColorConvertKernels(int isa);
+
+}; // namespace android
+
+#endif // ANDROID_LIBCAMERA_COLOR_CONVERT_KERNELS_H
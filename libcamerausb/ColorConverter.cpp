@@ -20,273 +20,9 @@
 #include "ColorConverter.h"
 #include "LogHelper.h"
 #include "VAConvertor.h"
+#include "ColorConvertKernels.h"
 namespace android {
 
-inline unsigned char clamp(int x){
-    if (x < 0 )
-        x = 0;
-    else if (x > 255)
-        x = 255;
-    return (x & 0xFF);
-}
-
-void YUYVToNV21(int width, int height, void *src, void *dst)
-{
-    unsigned char *pSrcY = (unsigned char *) src;
-    unsigned char *pSrcU = pSrcY + 1;
-    unsigned char *pSrcV = pSrcY + 3;
-
-    unsigned char *pDstY = (unsigned char *) dst;
-    unsigned char *pDstUV = pDstY + width * height;
-
-    // YUYV format is: yuyvyuyvyuyv...yuyv
-    // NV12 format is: yyyy...yyyyuvuv...uvuvuv
-    for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width / 2; j++) { // 2 y-pixels at a time
-            *pDstY++ = *pSrcY;
-            pSrcY += 2;
-            *pDstY++ = *pSrcY;
-            pSrcY += 2;
-
-            // 4:2:2 chroma has 1/2 the horizontal and FULL vertical resolution of full image
-            // 4:2:0 chroma has 1/2 the horizontal and 1/2 vertical resolution of full image
-            // so skip odd numbered rows
-            if ((i % 2) == 0) {
-                *pDstUV++ = *pSrcV;
-                *pDstUV++ = *pSrcU;
-            }
-            pSrcU += 4;
-            pSrcV += 4;
-        }
-    }
-}
-
-void YUYVToNV12(int width, int height, void *src, void *dst)
-{
-    unsigned char *pSrcY = (unsigned char *) src;
-    unsigned char *pSrcU = pSrcY + 1;
-    unsigned char *pSrcV = pSrcY + 3;
-
-    unsigned char *pDstY = (unsigned char *) dst;
-    unsigned char *pDstUV = pDstY + width * height;
-
-    // YUYV format is: yuyvyuyvyuyv...yuyv
-    // NV12 format is: yyyy...yyyyuvuv...uvuvuv
-    for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width / 2; j++) { // 2 y-pixels at a time
-            *pDstY++ = *pSrcY;
-            pSrcY += 2;
-            *pDstY++ = *pSrcY;
-            pSrcY += 2;
-
-            // 4:2:2 chroma has 1/2 the horizontal and FULL vertical resolution of full image
-            // 4:2:0 chroma has 1/2 the horizontal and 1/2 vertical resolution of full image
-            // so skip odd numbered rows
-            if ((i % 2) == 0) {
-                *pDstUV++ = *pSrcU;
-                *pDstUV++ = *pSrcV;
-            }
-            pSrcU += 4;
-            pSrcV += 4;
-        }
-    }
-}
-
-void YUYVToRGB8888(int width, int height, void *src, void *dst)
-{
-    int len = width * height * 2;
-    int i = 0;
-    unsigned char *pYUV = (unsigned char *)src;   //four bytes of two pixels
-    unsigned char *pRGB = (unsigned char *)dst;       //6 rgb bytes for two pixels
-    int C, D, E;
-    len -= len % 4;
-    for (i = 0; i < len; i += 4) {
-        unsigned char y1 = *(pYUV++);
-        unsigned char u = *(pYUV++);
-        unsigned char y2 = *(pYUV++);
-        unsigned char v = *(pYUV++);
-//calculate 1st pixel
-        C = y1 - 16;
-        D = u - 128;
-        E = v -128;
-        *(pRGB++) = clamp((C * 298 + E * 409 + 128) >> 8);
-        *(pRGB++) = clamp((C * 298 - D * 100 - E * 208 + 128) >> 8);
-        *(pRGB++) = clamp((C * 298 + D * 516 + 128) >> 8);
-        //alpha
-        *(pRGB++) = 0xFF;
-//calculate 2nd pixel
-        C = y2 -16;
-        *(pRGB++) = clamp((C * 298 + E * 409 + 128) >> 8);
-        *(pRGB++) = clamp((C * 298 - D * 100 - E * 208 + 128) >> 8);
-        *(pRGB++) = clamp((C * 298 + D * 516 + 128) >> 8);
-        //alpha
-        *(pRGB++) = 0xFF;
-
-    }
-}
-
-void YUYVToRGB565(int width, int height, void *src, void *dst)
-{
-
-    unsigned char *yuvs = (unsigned char *) src;
-    unsigned char *rgbs = (unsigned char *) dst;
-
-    //points to the next luminance value pair
-    int lumPtr = 0;
-    //points to the next chromiance value pair
-    int chrPtr = 1;
-    //points to the next byte output pair of RGB565 value
-    int outPtr = 0;
-
-    while (true) {
-
-        if (lumPtr == width * height * 2) // our work is done here!
-            break;
-
-        //read the luminance
-        int Y1 = yuvs[lumPtr] & 0xff;
-        lumPtr += 2;
-        int Y2 = yuvs[lumPtr] & 0xff;
-        lumPtr += 2;
-
-        //read the chroma
-        int Cb = (yuvs[chrPtr] & 0xff) - 128;
-        chrPtr += 2;
-        int Cr = (yuvs[chrPtr] & 0xff) - 128;
-        chrPtr += 2;
-        int R, G, B;
-
-        //generate first RGB components
-        B = clamp(Y1 + ((454 * Cb) >> 8));
-        G = clamp(Y1 - ((88 * Cb + 183 * Cr) >> 8));
-        R = clamp(Y1 + ((359 * Cr) >> 8));
-        //NOTE: this assume little-endian encoding
-        rgbs[outPtr++]  = (unsigned char) (((G & 0x3c) << 3) | (B >> 3));
-        rgbs[outPtr++]  = (unsigned char) ((R & 0xf8) | (G >> 5));
-
-        //generate second RGB components
-        B = clamp(Y2 + ((454 * Cb) >> 8));
-        G = clamp(Y2 - ((88 * Cb + 183 * Cr) >> 8));
-        R = clamp(Y2 + ((359 * Cr) >> 8));
-        //NOTE: this assume little-endian encoding
-        rgbs[outPtr++]  = (unsigned char) (((G & 0x3c) << 3) | (B >> 3));
-        rgbs[outPtr++]  = (unsigned char) ((R & 0xf8) | (G >> 5));
-    }
-}
-
-void NV12ToRGB565(int width, int height, void *src, void *dst)
-{
-
-    unsigned char *yuvs = (unsigned char *) src;
-    unsigned char *rgbs = (unsigned char *) dst;
-
-    //the end of the luminance data
-    int lumEnd = width * height;
-    //points to the next luminance value pair
-    int lumPtr = 0;
-    //points to the next chromiance value pair
-    int chrPtr = lumEnd;
-    //points to the next byte output pair of RGB565 value
-    int outPtr = 0;
-    //the end of the current luminance scanline
-    int lineEnd = width;
-
-    while (true) {
-        //skip back to the start of the chromiance values when necessary
-        if (lumPtr == lineEnd) {
-            if (lumPtr == lumEnd) break; //we've reached the end
-            //division here is a bit expensive, but's only done once per scanline
-            chrPtr = lumEnd + ((lumPtr  >> 1) / width) * width;
-            lineEnd += width;
-        }
-        //read the luminance and chromiance values
-        int Y1 = yuvs[lumPtr++] & 0xff;
-        int Y2 = yuvs[lumPtr++] & 0xff;
-        int Cb = (yuvs[chrPtr++] & 0xff) - 128;
-        int Cr = (yuvs[chrPtr++] & 0xff) - 128;
-        int R, G, B;
-
-        //generate first RGB components
-        B = Y1 + ((454 * Cb) >> 8);
-        if(B < 0) B = 0; else if(B > 255) B = 255;
-        G = Y1 - ((88 * Cb + 183 * Cr) >> 8);
-        if(G < 0) G = 0; else if(G > 255) G = 255;
-        R = Y1 + ((359 * Cr) >> 8);
-        if(R < 0) R = 0; else if(R > 255) R = 255;
-        //NOTE: this assume little-endian encoding
-        rgbs[outPtr++]  = (unsigned char) (((G & 0x3c) << 3) | (B >> 3));
-        rgbs[outPtr++]  = (unsigned char) ((R & 0xf8) | (G >> 5));
-
-        //generate second RGB components
-        B = Y2 + ((454 * Cb) >> 8);
-        if(B < 0) B = 0; else if(B > 255) B = 255;
-        G = Y2 - ((88 * Cb + 183 * Cr) >> 8);
-        if(G < 0) G = 0; else if(G > 255) G = 255;
-        R = Y2 + ((359 * Cr) >> 8);
-        if(R < 0) R = 0; else if(R > 255) R = 255;
-        //NOTE: this assume little-endian encoding
-        rgbs[outPtr++]  = (unsigned char) (((G & 0x3c) << 3) | (B >> 3));
-        rgbs[outPtr++]  = (unsigned char) ((R & 0xf8) | (G >> 5));
-    }
-}
-
-void NV12ToRGB565withStride(int width, int height,int stride,int alignheight, void *src, void *dst)
-{
-
-    unsigned char *yuvs = (unsigned char *) src;
-    unsigned char *rgbs = (unsigned char *) dst;
-
-    //the end of the luminance data
-    int lumEnd = stride * alignheight;
-    //points to the next luminance value pair
-    int lumPtr = 0;
-    //points to the next chromiance value pair
-    int chrPtr = lumEnd;
-    //points to the next byte output pair of RGB565 value
-    int outPtr = 0;
-    //the end of the current luminance scanline
-    int lineEnd = width;
-    int diff = stride-width;
-    int actLumEnd = stride*height;
-    while (true) {
-        //skip back to the start of the chromiance values when necessary
-        if (lumPtr == lineEnd) {
-            if (lumPtr == (actLumEnd-diff)) break; //we've reached the end
-            //division here is a bit expensive, but's only done once per scanline
-            lumPtr += diff;
-            chrPtr = lumEnd + ((lumPtr  >> 1) / stride) * stride;
-            lineEnd += stride;
-        }
-        //read the luminance and chromiance values
-        int Y1 = yuvs[lumPtr++] & 0xff;
-        int Y2 = yuvs[lumPtr++] & 0xff;
-        int Cb = (yuvs[chrPtr++] & 0xff) - 128;
-        int Cr = (yuvs[chrPtr++] & 0xff) - 128;
-        int R, G, B;
-
-        //generate first RGB components
-        B = Y1 + ((454 * Cb) >> 8);
-        if(B < 0) B = 0; else if(B > 255) B = 255;
-        G = Y1 - ((88 * Cb + 183 * Cr) >> 8);
-        if(G < 0) G = 0; else if(G > 255) G = 255;
-        R = Y1 + ((359 * Cr) >> 8);
-        if(R < 0) R = 0; else if(R > 255) R = 255;
-        //NOTE: this assume little-endian encoding
-        rgbs[outPtr++]  = (unsigned char) (((G & 0x3c) << 3) | (B >> 3));
-        rgbs[outPtr++]  = (unsigned char) ((R & 0xf8) | (G >> 5));
-
-        //generate second RGB components
-        B = Y2 + ((454 * Cb) >> 8);
-        if(B < 0) B = 0; else if(B > 255) B = 255;
-        G = Y2 - ((88 * Cb + 183 * Cr) >> 8);
-        if(G < 0) G = 0; else if(G > 255) G = 255;
-        R = Y2 + ((359 * Cr) >> 8);
-        if(R < 0) R = 0; else if(R > 255) R = 255;
-        //NOTE: this assume little-endian encoding
-        rgbs[outPtr++]  = (unsigned char) (((G & 0x3c) << 3) | (B >> 3));
-        rgbs[outPtr++]  = (unsigned char) ((R & 0xf8) | (G >> 5));
-    }
-}
 /*
 convert YUV422H to NV12, the yuv422h is placed as Y(stride * alignheight),U(stride * alignheight),V(stride * alignheight)
 the valid data for U/V is width/2 * alignheight
@@ -300,11 +36,11 @@ void YUV422PToNV12withStride(int width, int height,int stride,int alignheight, v
     int planeSizeY = stride * alignheight;
     int planeSizeU = planeSizeY;
     int i = 0;
-    int j = 0;
     unsigned char *srcPtr = (unsigned char *) src;
     unsigned char *srcPtrU = (unsigned char *) src + planeSizeY;
     unsigned char *srcPtrV = (unsigned char *) srcPtrU + planeSizeU;
     unsigned char *dstPtr = (unsigned char *) dst;
+    const ColorConvertKernels *k = getColorConvertKernels();
     // copy the entire Y plane
     if(width == stride)
     {
@@ -324,10 +60,8 @@ void YUV422PToNV12withStride(int width, int height,int stride,int alignheight, v
     int vertical = height/2;
     int horizontal = width / 2;
     for(i = 0; i < vertical; i++) {
-        for (j = 0; j < horizontal; j++) {
-            *dstPtr++ = srcPtrU[j];
-            *dstPtr++ = srcPtrV[j];
-        }
+        k->interleaveUVRow(srcPtrU, srcPtrV, dstPtr, horizontal);
+        dstPtr += horizontal * 2;
         srcPtrV += stride << 1;
         srcPtrU += stride << 1;
     }
@@ -347,7 +81,6 @@ void YUV422PToNV21withStride(int width, int height,int stride,int alignheight, v
     int planeSizeY = stride * alignheight;
     int planeSizeU = planeSizeY;
     int i = 0;
-    int j = 0;
     unsigned char *srcPtr = (unsigned char *) src;
     unsigned char *srcPtrU = (unsigned char *) src + planeSizeY;
     unsigned char *srcPtrV = (unsigned char *) srcPtrU + planeSizeU;
@@ -369,13 +102,12 @@ void YUV422PToNV21withStride(int width, int height,int stride,int alignheight, v
       }
    }
     // deinterlace the VU data
+    const ColorConvertKernels *k = getColorConvertKernels();
     int vertical = height / 2;
     int horizontal = width / 2;
     for(i = 0; i < vertical; i++) {
-        for (j = 0; j < horizontal; j++) {
-            *dstPtrVU++ = srcPtrV[j];
-            *dstPtrVU++ = srcPtrU[j];
-        }
+        k->interleaveUVRow(srcPtrV, srcPtrU, dstPtrVU, horizontal);
+        dstPtrVU += horizontal * 2;
         srcPtrV += stride << 1;
         srcPtrU += stride << 1;
     }
@@ -430,61 +162,12 @@ void YUV422PToYV12withStride(int width, int height,int stride,int alignheight, v
     }
 
 }
-static void YV12ToBGR565(int width, int height, int stride, void *src, void *dst)
-{
-    unsigned char *yuvs = (unsigned char *)src;
-    unsigned char *rgbs = (unsigned char *)dst;
-
-    //the end of the luminance data
-    int lumEnd = stride * height;
-    //points to the next luminance value pair
-    int lumPtr = 0;
-    //points to the next chromiance value pair
-    int chrPtrU = 0, chrPtrV = 0;
-
-    for (int i = 0; i < height; i += 2) {
-        lumPtr = i * stride;
-        chrPtrV = i / 2 * stride / 2 + lumEnd;
-        chrPtrU = i / 2 * stride / 2 + lumEnd + (stride / 2 * height / 2);
-        unsigned char *rgbStart = rgbs;
-        for (int j = 0; j < width; j += 2 ) {
-            //read the luminance and chromiance values
-            int Cb = (yuvs[chrPtrU ++] & 0xff) - 128;
-            int Cr = (yuvs[chrPtrV ++] & 0xff) - 128;
-
-            for (int m = 0; m < 2; m ++) { // m
-                int lumLine = lumPtr + m * stride;
-                unsigned char* pxlrgb = rgbStart + m * width * 2;
-                for (int n = 0; n < 2; n ++) { // n
-                    int Y = yuvs[lumLine ++] & 0xff;
-                    int R, G, B;
-                    B = Y + ((454 * Cb) >> 8);
-                    if(B < 0) B = 0; else if(B > 255) B = 255;
-                    G = Y - ((88 * Cb + 183 * Cr) >> 8);
-                    if(G < 0) G = 0; else if(G > 255) G = 255;
-                    R = Y + ((359 * Cr) >> 8);
-                    if(R < 0) R = 0; else if(R > 255) R = 255;
-
-                    unsigned short *p = (unsigned short *)pxlrgb;
-                    *p = (B>>3) | ((G>>2)<<5) | ((R>>3)<<11);
-                    pxlrgb += 2;
-                } // n
-            } // m
-            lumPtr += 2;
-            rgbStart += 4;
-        } // j
-        rgbs += 4 * width; // 2 lines
-   } // i
-}
-
-
 // covert NV12 (Y plane, interlaced UV bytes) to
 // NV21 (Y plane, interlaced VU bytes)
 void NV12ToNV21(int width, int height, void *src, void *dst)
 {
     int planeSizeY = width * height;
     int planeSizeUV = planeSizeY / 2;
-    int i = 0;
     unsigned char *srcPtr = (unsigned char *) src;
     unsigned char *dstPtr = (unsigned char *) dst;
 
@@ -492,17 +175,14 @@ void NV12ToNV21(int width, int height, void *src, void *dst)
     memcpy(dstPtr, src, planeSizeY);
 
     // byte swap the UV data
-    for(i=planeSizeY; i<(planeSizeY+planeSizeUV); i=i+2)
-    {
-        dstPtr[i] = srcPtr[i + 1];
-        dstPtr[i + 1] = srcPtr[i];
-    }
+    getColorConvertKernels()->swapUVRow(srcPtr + planeSizeY, dstPtr + planeSizeY,
+                                        (planeSizeUV + 1) / 2);
 }
 
 // P411's Y, U, V are seperated. But the NV12's U and V are interleaved.
 void NV12ToP411(int width, int height, void *src, void *dst)
 {
-    int i, j, p, q;
+    int i, p, q;
     unsigned char *pdstU, *pdstV;
     unsigned char *psrcUV;
 
@@ -512,17 +192,15 @@ void NV12ToP411(int width, int height, void *src, void *dst)
     psrcUV = (unsigned char *)src + width * height;
     pdstU = (unsigned char *)dst + width * height;
     pdstV = pdstU + width * height / 4;
+    const ColorConvertKernels *k = getColorConvertKernels();
     p = q = 0;
     for (i = 0; i < height / 2; i++) {
-        for (j = 0; j < width; j++) {
-            if (j % 2 == 0) {
-                pdstU[p]= (psrcUV[i * width + j] & 0xFF) ;
-                p++;
-           } else {
-                pdstV[q]= (psrcUV[i * width + j] & 0xFF);
-                q++;
-            }
-        }
+        k->deinterleaveUVRow(psrcUV + i * width, pdstU + p, pdstV + q, width / 2);
+        p += width / 2;
+        q += width / 2;
+        // the last byte of an odd width row is a U sample
+        if (width % 2)
+            pdstU[p++] = psrcUV[i * width + width - 1];
     }
 }
 
@@ -537,12 +215,7 @@ int planeSizeUV = planeSizeY / 2;
     unsigned char *dstPtr = (unsigned char *) dst;
 
 // interleave: YUYV a macro pixel
-    for  (int i = 0; i < planeSizeUV; i ++) {
-        * dstPtr ++ = *srcPtrY ++; // Y
-        * dstPtr ++ = *srcPtrU ++; // U
-        * dstPtr ++ = *srcPtrY ++; // Y
-        * dstPtr ++ = *srcPtrV ++; // V
-    }
+    getColorConvertKernels()->planarToYUYVRow(srcPtrY, srcPtrU, srcPtrV, dstPtr, planeSizeUV);
 }
 
 void YU16ToYV12(int width, int height, void *src, void *dst)
@@ -552,7 +225,6 @@ void YU16ToYV12(int width, int height, void *src, void *dst)
     int planeSizeV = planeSizeY / 2;
     int newPlaneSizeV = planeSizeY / 4;
     int i = 0;
-    int j = 0;
     unsigned char *srcPtr = (unsigned char *) src;
     unsigned char *srcPtrU = (unsigned char *) src + planeSizeY;
     unsigned char *srcPtrV = (unsigned char *) src + planeSizeY + planeSizeU;
@@ -567,18 +239,19 @@ void YU16ToYV12(int width, int height, void *src, void *dst)
     memcpy(dstPtr, srcPtr, planeSizeY);
 
     // handle the V data
+    const ColorConvertKernels *k = getColorConvertKernels();
     int vertical = height / 2;
     int horizontal = width / 2;
     for(i = 0; i < vertical; i++) {
         pTmp = srcPtrV + 2 * i * horizontal;
-        for (j = 0; j < horizontal; j++)
-            *dstPtrV++ = (pTmp[j] + (pTmp + horizontal)[j]) / 2;
+        k->averageRows(pTmp, pTmp + horizontal, dstPtrV, horizontal);
+        dstPtrV += horizontal;
     }
     // handle the U data
     for(i = 0; i < vertical; i++) {
         pTmp = srcPtrU + 2 * i * horizontal;
-        for (j = 0; j < horizontal; j++)
-            *dstPtrU++ = (pTmp[j] + (pTmp + horizontal)[j]) / 2;
+        k->averageRows(pTmp, pTmp + horizontal, dstPtrU, horizontal);
+        dstPtrU += horizontal;
     }
 }
 
@@ -587,7 +260,6 @@ void YU16ToNV12(int width, int height, void *src, void *dst)
     int planeSizeY = width * height;
     int planeSizeU = planeSizeY / 2;
     int i = 0;
-    int j = 0;
     unsigned char *srcPtr = (unsigned char *) src;
     unsigned char *srcPtrU = (unsigned char *) src + planeSizeY;
     unsigned char *srcPtrV = (unsigned char *) srcPtrU + planeSizeU;
@@ -598,13 +270,13 @@ void YU16ToNV12(int width, int height, void *src, void *dst)
     dstPtr += planeSizeY;
 
     // deinterlace the UV data
+    const ColorConvertKernels *k = getColorConvertKernels();
     int vertical = height / 2;
     int horizontal = width / 2;
     for(i = 0; i < vertical; i++) {
-        for (j = 0; j < horizontal; j++) {
-            *dstPtr++ = srcPtrU[2 * i * horizontal + j];
-            *dstPtr++ = srcPtrV[2 * i * horizontal + j];
-        }
+        k->interleaveUVRow(srcPtrU + 2 * i * horizontal, srcPtrV + 2 * i * horizontal,
+                           dstPtr, horizontal);
+        dstPtr += horizontal * 2;
     }
 }
 void YU16ToNV21(int width, int height, void *src, void *dst)
@@ -612,7 +284,6 @@ void YU16ToNV21(int width, int height, void *src, void *dst)
     int planeSizeY = width * height;
     int planeSizeU = planeSizeY / 2;
     int i = 0;
-    int j = 0;
     unsigned char *srcPtr = (unsigned char *) src;
     unsigned char *srcPtrU = (unsigned char *) src + planeSizeY;
     unsigned char *srcPtrV = (unsigned char *) srcPtrU + planeSizeU;
@@ -623,13 +294,13 @@ void YU16ToNV21(int width, int height, void *src, void *dst)
     dstPtr += planeSizeY;
 
     // deinterlace the UV data
+    const ColorConvertKernels *k = getColorConvertKernels();
     int vertical = height / 2;
     int horizontal = width / 2;
     for(i = 0; i < vertical; i++) {
-        for (j = 0; j < horizontal; j++) {
-            *dstPtr++ = srcPtrV[2 * i * horizontal + j];
-            *dstPtr++ = srcPtrU[2 * i * horizontal + j];
-        }
+        k->interleaveUVRow(srcPtrV + 2 * i * horizontal, srcPtrU + 2 * i * horizontal,
+                           dstPtr, horizontal);
+        dstPtr += horizontal * 2;
     }
 }
 
@@ -641,7 +312,6 @@ void NV12ToYV12(int width, int height, void *src, void *dst)
     int planeSizeY = width * height;
     int planeSizeUV = planeSizeY / 2;
     int planeUOffset = planeSizeUV / 2;
-    int i = 0;
     unsigned char *srcPtr = (unsigned char *) src;
     unsigned char *dstPtr = (unsigned char *) dst;
     unsigned char *dstPtrV = (unsigned char *) dst + planeSizeY;
@@ -651,11 +321,8 @@ void NV12ToYV12(int width, int height, void *src, void *dst)
     memcpy(dstPtr, src, planeSizeY);
 
     // deinterlace the UV data
-    for(i=planeSizeY; i<(planeSizeY+planeSizeUV); i=i+2)
-    {
-        *dstPtrV++ = srcPtr[i + 1];
-        *dstPtrU++ = srcPtr[i];
-    }
+    getColorConvertKernels()->deinterleaveUVRow(srcPtr + planeSizeY, dstPtrU, dstPtrV,
+                                                (planeSizeUV + 1) / 2);
 }
 
 void YV12ToNV12(int width, int height, void *src, void *dst)
@@ -663,7 +330,6 @@ void YV12ToNV12(int width, int height, void *src, void *dst)
     int planeSizeY = width * height;
     int planeSizeV = planeSizeY / 4;
     int newPlaneSizeUV = planeSizeY / 2;
-    int i = 0;
     unsigned char *srcPtr = (unsigned char *) src;
     unsigned char *srcPtrV = (unsigned char *) src + planeSizeY;
     unsigned char *srcPtrU = (unsigned char *) srcPtrV + planeSizeV;
@@ -674,17 +340,13 @@ void YV12ToNV12(int width, int height, void *src, void *dst)
     dstPtr += planeSizeY;
 
     // deinterlace the UV data
-    for(i = 0; i < planeSizeV; i++) {
-        *dstPtr++ = srcPtrU[i];
-        *dstPtr++ = srcPtrV[i];
-    }
+    getColorConvertKernels()->interleaveUVRow(srcPtrU, srcPtrV, dstPtr, planeSizeV);
 }
 void YV12ToNV21(int width, int height, void *src, void *dst)
 {
     int planeSizeY = width * height;
     int planeSizeV = planeSizeY / 4;
     int newPlaneSizeUV = planeSizeY / 2;
-    int i = 0;
     unsigned char *srcPtr = (unsigned char *) src;
     unsigned char *srcPtrV = (unsigned char *) src + planeSizeY;
     unsigned char *srcPtrU = (unsigned char *) srcPtrV + planeSizeV;
@@ -695,10 +357,7 @@ void YV12ToNV21(int width, int height, void *src, void *dst)
     dstPtr += planeSizeY;
 
     // deinterlace the UV data
-    for(i = 0; i < planeSizeV; i++) {
-        *dstPtr++ = srcPtrV[i];
-        *dstPtr++ = srcPtrU[i];
-    }
+    getColorConvertKernels()->interleaveUVRow(srcPtrV, srcPtrU, dstPtr, planeSizeV);
 }
 /*
 convert YV12 to NV21
@@ -714,7 +373,6 @@ void YV12ToNV21withStride(int width, int height,int stride,int alignheight, void
     int planeSizeV = stride * alignheight / 4;
     int newPlaneSizeY = width * height;
     int i = 0;
-    int j = 0;
     unsigned char *srcPtr = (unsigned char *) src;
     unsigned char *srcPtrV = (unsigned char *) src + planeSizeY;
     unsigned char *srcPtrU = (unsigned char *) srcPtrV + planeSizeV;
@@ -737,13 +395,12 @@ void YV12ToNV21withStride(int width, int height,int stride,int alignheight, void
       }
    }
     // deinterlace the UV data
+    const ColorConvertKernels *k = getColorConvertKernels();
     int vertical = height / 2;
     int horizontal = width / 2;
     for(i = 0; i < vertical; i++) {
-        for( j = 0; j < horizontal; j ++) {
-        *dstPtr++ = srcPtrV[j];
-        *dstPtr++ = srcPtrU[j];
-       }
+        k->interleaveUVRow(srcPtrV, srcPtrU, dstPtr, horizontal);
+        dstPtr += horizontal * 2;
         srcPtrV += stride/2;
         srcPtrU += stride/2;
     }
@@ -802,18 +459,20 @@ void RepaddingYV12(int width, int height, int srcStride, int dstStride,int align
 
 static status_t colorConvertYUYV(int dstFormat, int width, int height, void *src, void *dst)
 {
+    const ColorConvertKernels *k = getColorConvertKernels();
+
     switch (dstFormat) {
     case V4L2_PIX_FMT_NV12:
-        YUYVToNV12(width, height, src, dst);
+        k->yuyvToNV12(width, height, src, dst);
         break;
     case V4L2_PIX_FMT_NV21:
-        YUYVToNV21(width, height, src, dst);
+        k->yuyvToNV21(width, height, src, dst);
         break;
     case V4L2_PIX_FMT_RGB565:
-        YUYVToRGB565(width, height, src, dst);
+        k->yuyvToRGB565(width, height, src, dst);
         break;
     case V4L2_PIX_FMT_RGB32:
-        YUYVToRGB8888(width, height, src, dst);
+        k->yuyvToRGB8888(width, height, src, dst);
         break;
     default:
         ALOGE("Invalid color format (dest)");
@@ -833,7 +492,7 @@ static status_t colorConvertNV12(int dstFormat, int width, int height, void *src
         NV12ToYV12(width, height, src, dst);
         break;
     case V4L2_PIX_FMT_RGB565:
-        NV12ToRGB565(width, height, src, dst);
+        getColorConvertKernels()->nv12ToRGB565(width, height, src, dst);
         break;
     default:
         ALOGE("Invalid color format (dest)");
@@ -853,7 +512,7 @@ static status_t colorConvertYUV420(int dstFormat, int width, int height, void *s
         YV12ToNV12(width, height, src, dst);
         break;
     case V4L2_PIX_FMT_RGB565:
-        YV12ToBGR565(width, height,width,src, dst);
+        getColorConvertKernels()->yv12ToBGR565(width, height,width,src, dst);
         break;
     case V4L2_PIX_FMT_YUV420:
         stride = ALIGN(width,16);
@@ -894,7 +553,7 @@ static status_t colorConvertNV12withStride(int dstFormat, int stride,int width,
 {
     switch (dstFormat) {
     case V4L2_PIX_FMT_RGB565:
-        NV12ToRGB565withStride(width, height,stride,alignheight, src, dst);
+        getColorConvertKernels()->nv12ToRGB565withStride(width, height,stride,alignheight, src, dst);
         break;
     default:
         ALOGE("Invalid color format (dest)");
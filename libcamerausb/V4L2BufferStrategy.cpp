@@ -0,0 +1,460 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define LOG_TAG "Camera_V4L2Buffers"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include "LogHelper.h"
+#include "V4L2BufferStrategy.h"
+
+#define CLEAR(x) memset (&(x), 0, sizeof (x))
+
+#ifndef V4L2_BUF_FLAG_TIMESTAMP_MASK
+#define V4L2_BUF_FLAG_TIMESTAMP_MASK        0xe000
+#define V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC   0x2000
+#endif
+
+// dma-buf CPU access sync, from linux/dma-buf.h which older kernel
+// headers do not have
+struct camera_dma_buf_sync {
+    uint64_t flags;
+};
+#define CAMERA_DMA_BUF_SYNC_READ    (1 << 0)
+#define CAMERA_DMA_BUF_SYNC_START   (0 << 2)
+#define CAMERA_DMA_BUF_SYNC_END     (1 << 2)
+#define CAMERA_DMA_BUF_IOCTL_SYNC   _IOW('b', 0, struct camera_dma_buf_sync)
+
+namespace android {
+
+static const char *sMemoryNames[V4L2BufferStrategy::MEMORY_NUM] = {
+    "userptr",
+    "mmap",
+    "dmabuf",
+};
+
+////////////////////////////////////////////////////////////////////
+//                          STRATEGIES
+////////////////////////////////////////////////////////////////////
+
+class UserPtrBufferStrategy : public V4L2BufferStrategy {
+public:
+    UserPtrBufferStrategy(int fd) :
+        V4L2BufferStrategy(fd, MEMORY_USERPTR, V4L2_MEMORY_USERPTR) {}
+
+    virtual status_t setupBuffer(int index, void *userData, size_t userLength)
+    {
+        Buffer *buf = getBuffer(index);
+        if (buf == 0 || userData == 0 || userLength < buf->vbuf.length) {
+            ALOGE("invalid user buffer %d: %p, %u bytes", index, userData, (unsigned) userLength);
+            return BAD_VALUE;
+        }
+        buf->vbuf.m.userptr = (unsigned long) userData;
+        buf->data = userData;
+        buf->length = userLength;
+        return NO_ERROR;
+    }
+};
+
+class MmapBufferStrategy : public V4L2BufferStrategy {
+public:
+    MmapBufferStrategy(int fd) :
+        V4L2BufferStrategy(fd, MEMORY_MMAP, V4L2_MEMORY_MMAP) {}
+
+    virtual status_t setupBuffer(int index, void *userData, size_t userLength)
+    {
+        Buffer *buf = getBuffer(index);
+        if (buf == 0)
+            return BAD_VALUE;
+
+        void *data = mmap(NULL, buf->vbuf.length, PROT_READ | PROT_WRITE,
+                          MAP_SHARED, mFd, buf->vbuf.m.offset);
+        if (data == MAP_FAILED) {
+            ALOGE("mmap of buffer %d failed: %s", index, strerror(errno));
+            return NO_MEMORY;
+        }
+        buf->data = data;
+        buf->length = buf->vbuf.length;
+        return NO_ERROR;
+    }
+
+protected:
+    MmapBufferStrategy(int fd, int memory) :
+        V4L2BufferStrategy(fd, memory, V4L2_MEMORY_MMAP) {}
+
+    virtual void releaseBuffer(Buffer *buf)
+    {
+        if (buf->data)
+            munmap(buf->data, buf->length);
+        buf->data = 0;
+        buf->length = 0;
+    }
+};
+
+class DmabufBufferStrategy : public MmapBufferStrategy {
+public:
+    DmabufBufferStrategy(int fd) :
+        MmapBufferStrategy(fd, MEMORY_DMABUF), mExportFailed(false) {}
+
+    virtual status_t setupBuffer(int index, void *userData, size_t userLength)
+    {
+        Buffer *buf = getBuffer(index);
+        if (buf == 0)
+            return BAD_VALUE;
+
+#ifdef VIDIOC_EXPBUF
+        struct v4l2_exportbuffer expbuf;
+        CLEAR(expbuf);
+        expbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        expbuf.index = index;
+        expbuf.flags = O_CLOEXEC | O_RDWR;
+        if (!mExportFailed && ioctl(mFd, VIDIOC_EXPBUF, &expbuf) == 0) {
+            void *data = mmap(NULL, buf->vbuf.length, PROT_READ | PROT_WRITE,
+                              MAP_SHARED, expbuf.fd, 0);
+            if (data == MAP_FAILED) {
+                ALOGE("mmap of dma-buf %d failed: %s", index, strerror(errno));
+                close(expbuf.fd);
+                return NO_MEMORY;
+            }
+            buf->dmabufFd = expbuf.fd;
+            buf->data = data;
+            buf->length = buf->vbuf.length;
+            return NO_ERROR;
+        }
+#endif
+        // the device streams MMAP but can't export, keep going without fds
+        if (!mExportFailed)
+            ALOGI("dma-buf export not supported, using plain mmap");
+        mExportFailed = true;
+        return MmapBufferStrategy::setupBuffer(index, userData, userLength);
+    }
+
+protected:
+    virtual void releaseBuffer(Buffer *buf)
+    {
+        MmapBufferStrategy::releaseBuffer(buf);
+        if (buf->dmabufFd >= 0)
+            close(buf->dmabufFd);
+        buf->dmabufFd = -1;
+    }
+
+    virtual void beginCpuAccess(Buffer *buf)
+    {
+        if (buf->dmabufFd < 0)
+            return;
+        struct camera_dma_buf_sync sync;
+        sync.flags = CAMERA_DMA_BUF_SYNC_START | CAMERA_DMA_BUF_SYNC_READ;
+        ioctl(buf->dmabufFd, CAMERA_DMA_BUF_IOCTL_SYNC, &sync);
+    }
+
+    virtual void endCpuAccess(Buffer *buf)
+    {
+        if (buf->dmabufFd < 0)
+            return;
+        struct camera_dma_buf_sync sync;
+        sync.flags = CAMERA_DMA_BUF_SYNC_END | CAMERA_DMA_BUF_SYNC_READ;
+        ioctl(buf->dmabufFd, CAMERA_DMA_BUF_IOCTL_SYNC, &sync);
+    }
+
+private:
+    bool mExportFailed;
+};
+
+////////////////////////////////////////////////////////////////////
+//                          PUBLIC METHODS
+////////////////////////////////////////////////////////////////////
+
+V4L2BufferStrategy* V4L2BufferStrategy::create(int fd, int memory)
+{
+    switch (memory) {
+    case MEMORY_USERPTR:
+        return new UserPtrBufferStrategy(fd);
+    case MEMORY_MMAP:
+        return new MmapBufferStrategy(fd);
+    case MEMORY_DMABUF:
+        return new DmabufBufferStrategy(fd);
+    default:
+        ALOGE("invalid buffer memory %d", memory);
+        return 0;
+    }
+}
+
+V4L2BufferStrategy::V4L2BufferStrategy(int fd, int memory, int v4l2Memory) :
+    mFd(fd)
+    ,mMemory(memory)
+    ,mV4L2Memory(v4l2Memory)
+    ,mNumBuffers(0)
+    ,mBuffers(0)
+{
+    resetStats();
+}
+
+V4L2BufferStrategy::~V4L2BufferStrategy()
+{
+    if (mBuffers) {
+        ALOGE("strategy destroyed with buffers still requested");
+        releaseBuffers();
+    }
+}
+
+static bool deviceSupports(int fd, int v4l2Memory)
+{
+    struct v4l2_requestbuffers reqBuf;
+    CLEAR(reqBuf);
+    reqBuf.count = 0;
+    reqBuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    reqBuf.memory = v4l2Memory;
+    return ioctl(fd, VIDIOC_REQBUFS, &reqBuf) == 0;
+}
+
+int V4L2BufferStrategy::pickMemory(int fd, int preferred)
+{
+    bool mmapOk = deviceSupports(fd, V4L2_MEMORY_MMAP);
+    bool userPtrOk = deviceSupports(fd, V4L2_MEMORY_USERPTR);
+
+    switch (preferred) {
+    case MEMORY_USERPTR:
+        if (userPtrOk)
+            return MEMORY_USERPTR;
+        break;
+    case MEMORY_MMAP:
+    case MEMORY_DMABUF:
+        // export support is only known once buffers exist
+        if (mmapOk)
+            return preferred;
+        break;
+    default:
+        break;
+    }
+
+    if (mmapOk)
+        return MEMORY_MMAP;
+    return MEMORY_USERPTR;
+}
+
+int V4L2BufferStrategy::parseMemory(const char *name)
+{
+    for (int i = 0; i < MEMORY_NUM; i++) {
+        if (name && !strcasecmp(name, sMemoryNames[i]))
+            return i;
+    }
+    return -1;
+}
+
+const char* V4L2BufferStrategy::memoryName(int memory)
+{
+    if (memory < 0 || memory >= MEMORY_NUM)
+        return "unknown";
+    return sMemoryNames[memory];
+}
+
+status_t V4L2BufferStrategy::requestBuffers(int *count)
+{
+    if (mBuffers) {
+        ALOGE("buffers already requested");
+        return INVALID_OPERATION;
+    }
+
+    struct v4l2_requestbuffers reqBuf;
+    CLEAR(reqBuf);
+    reqBuf.count = *count;
+    reqBuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    reqBuf.memory = mV4L2Memory;
+
+    LOG1("VIDIOC_REQBUFS, count=%d, memory=%s", reqBuf.count, memoryName(mMemory));
+    if (ioctl(mFd, VIDIOC_REQBUFS, &reqBuf) < 0) {
+        ALOGE("VIDIOC_REQBUFS(%d) returned: %s", *count, strerror(errno));
+        return UNKNOWN_ERROR;
+    }
+
+    if (reqBuf.count == 0) {
+        ALOGE("VIDIOC_REQBUFS granted no buffers");
+        return NO_MEMORY;
+    }
+
+    mNumBuffers = reqBuf.count;
+    mBuffers = new Buffer[mNumBuffers];
+    memset(mBuffers, 0, sizeof(Buffer) * mNumBuffers);
+    for (int i = 0; i < mNumBuffers; i++) {
+        mBuffers[i].dmabufFd = -1;
+        status_t status = queryBuffer(i);
+        if (status != NO_ERROR) {
+            releaseBuffers();
+            return status;
+        }
+    }
+
+    *count = mNumBuffers;
+    return NO_ERROR;
+}
+
+status_t V4L2BufferStrategy::releaseBuffers()
+{
+    if (!mBuffers)
+        return NO_ERROR;
+
+    for (int i = 0; i < mNumBuffers; i++)
+        releaseBuffer(&mBuffers[i]);
+
+    delete [] mBuffers;
+    mBuffers = 0;
+    mNumBuffers = 0;
+
+    struct v4l2_requestbuffers reqBuf;
+    CLEAR(reqBuf);
+    reqBuf.count = 0;
+    reqBuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    reqBuf.memory = mV4L2Memory;
+
+    LOG1("VIDIOC_REQBUFS, count=%d", reqBuf.count);
+    if (ioctl(mFd, VIDIOC_REQBUFS, &reqBuf) < 0) {
+        // Just print an error, the buffers are gone on our side anyway
+        ALOGE("VIDIOC_REQBUFS returned: %s", strerror(errno));
+        return UNKNOWN_ERROR;
+    }
+
+    return NO_ERROR;
+}
+
+V4L2BufferStrategy::Buffer* V4L2BufferStrategy::getBuffer(int index)
+{
+    if (index < 0 || index >= mNumBuffers)
+        return 0;
+    return &mBuffers[index];
+}
+
+size_t V4L2BufferStrategy::getBufferLength(int index)
+{
+    Buffer *buf = getBuffer(index);
+    return buf ? buf->vbuf.length : 0;
+}
+
+status_t V4L2BufferStrategy::queueBuffer(int index)
+{
+    Buffer *buf = getBuffer(index);
+    if (buf == 0)
+        return BAD_VALUE;
+
+    endCpuAccess(buf);
+
+    if (ioctl(mFd, VIDIOC_QBUF, &buf->vbuf) < 0) {
+        ALOGE("VIDIOC_QBUF index %d failed: %s", index, strerror(errno));
+        return UNKNOWN_ERROR;
+    }
+
+    return NO_ERROR;
+}
+
+status_t V4L2BufferStrategy::dequeueBuffer(int *index)
+{
+    struct v4l2_buffer vbuf;
+    CLEAR(vbuf);
+    vbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    vbuf.memory = mV4L2Memory;
+
+    if (ioctl(mFd, VIDIOC_DQBUF, &vbuf) < 0) {
+        ALOGE("VIDIOC_DQBUF failed: %s", strerror(errno));
+        return UNKNOWN_ERROR;
+    }
+
+    Buffer *buf = getBuffer(vbuf.index);
+    if (buf == 0) {
+        ALOGE("driver returned unknown buffer %d", vbuf.index);
+        return UNKNOWN_ERROR;
+    }
+
+    nsecs_t dequeued = systemTime();
+    buf->vbuf.bytesused = vbuf.bytesused;
+    buf->vbuf.flags = vbuf.flags;
+    buf->vbuf.field = vbuf.field;
+    buf->vbuf.timestamp = vbuf.timestamp;
+    buf->vbuf.sequence = vbuf.sequence;
+    beginCpuAccess(buf);
+    nsecs_t ready = systemTime();
+
+    mStats.frames++;
+    mStats.readyTotal += ready - dequeued;
+    if (ready - dequeued > mStats.readyMax)
+        mStats.readyMax = ready - dequeued;
+
+    // systemTime() is CLOCK_MONOTONIC, same as the driver's timestamp
+    if ((vbuf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+        nsecs_t captured = seconds_to_nanoseconds(vbuf.timestamp.tv_sec) +
+                           microseconds_to_nanoseconds(vbuf.timestamp.tv_usec);
+        nsecs_t latency = ready - captured;
+        mStats.latencySamples++;
+        mStats.latencyTotal += latency;
+        if (latency > mStats.latencyMax)
+            mStats.latencyMax = latency;
+    }
+
+    *index = vbuf.index;
+    return NO_ERROR;
+}
+
+void V4L2BufferStrategy::countCopy(size_t bytes)
+{
+    mStats.copies++;
+    mStats.copyBytes += bytes;
+}
+
+void V4L2BufferStrategy::resetStats()
+{
+    memset(&mStats, 0, sizeof(mStats));
+}
+
+void V4L2BufferStrategy::dumpStats(const char *tag) const
+{
+    const Stats &s = mStats;
+    if (s.frames == 0)
+        return;
+
+    ALOGD("%s: %s buffers, %u frames, %.2f copies/frame (%llu bytes), "
+          "ready avg %lld us max %lld us, latency avg %lld us max %lld us",
+          tag, memoryName(mMemory), s.frames,
+          (float) s.copies / s.frames, (unsigned long long) s.copyBytes,
+          (long long) nanoseconds_to_microseconds(s.readyTotal / s.frames),
+          (long long) nanoseconds_to_microseconds(s.readyMax),
+          (long long) (s.latencySamples ?
+                nanoseconds_to_microseconds(s.latencyTotal / s.latencySamples) : -1),
+          (long long) (s.latencySamples ? nanoseconds_to_microseconds(s.latencyMax) : -1));
+}
+
+////////////////////////////////////////////////////////////////////
+//                          PROTECTED METHODS
+////////////////////////////////////////////////////////////////////
+
+status_t V4L2BufferStrategy::queryBuffer(int index)
+{
+    struct v4l2_buffer *vbuf = &mBuffers[index].vbuf;
+
+    CLEAR(*vbuf);
+    vbuf->index = index;
+    vbuf->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    vbuf->memory = mV4L2Memory;
+    if (ioctl(mFd, VIDIOC_QUERYBUF, vbuf) < 0) {
+        ALOGE("VIDIOC_QUERYBUF failed: %s", strerror(errno));
+        return UNKNOWN_ERROR;
+    }
+
+    return NO_ERROR;
+}
+
+}; // namespace android
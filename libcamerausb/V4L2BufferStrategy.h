@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBCAMERA_V4L2_BUFFER_STRATEGY_H
+#define ANDROID_LIBCAMERA_V4L2_BUFFER_STRATEGY_H
+
+#include <stdint.h>
+#include <linux/videodev2.h>
+#include <utils/Errors.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+/**
+ * V4L2BufferStrategy owns the capture buffers shared with a V4L2 device
+ * and hides how they are shared:
+ *
+ *  - USERPTR: the caller allocates the memory and hands it to the driver,
+ *  - MMAP:    the driver allocates the memory, it is mapped into the HAL,
+ *  - DMABUF:  MMAP buffers additionally exported as dma-buf fds, so they
+ *             can be imported by the JPEG encoder or VA without a copy.
+ *             CPU access is bracketed with dma-buf cache sync.
+ *
+ * With MMAP and DMABUF, consumers read the frame straight from driver
+ * memory; copies only happen when a consumer needs the frame in its own
+ * memory, and are reported with countCopy().
+ */
+class V4L2BufferStrategy {
+
+// public types
+public:
+    enum Memory {
+        MEMORY_USERPTR,
+        MEMORY_MMAP,
+        MEMORY_DMABUF,
+        MEMORY_NUM,
+    };
+
+    struct Buffer {
+        struct v4l2_buffer vbuf;
+        void *data;             // CPU address of the frame
+        size_t length;          // size of the mapping in bytes
+        int dmabufFd;           // exported dma-buf, -1 if none
+    };
+
+    struct Stats {
+        uint32_t frames;        // frames dequeued
+        uint32_t copies;        // frames copied out of driver memory
+        uint64_t copyBytes;
+        nsecs_t readyTotal;     // DQBUF returned to frame readable by CPU
+        nsecs_t readyMax;
+        nsecs_t latencyTotal;   // capture timestamp to frame readable
+        nsecs_t latencyMax;
+        uint32_t latencySamples;// only drivers with monotonic timestamps
+    };
+
+// constructor/destructor
+public:
+    static V4L2BufferStrategy* create(int fd, int memory);
+    virtual ~V4L2BufferStrategy();
+
+// public methods
+public:
+    /**
+     * Picks the memory type for a device: @preferred if the device
+     * supports it, otherwise MMAP, otherwise USERPTR.
+     * @param preferred MEMORY_* or -1 for no preference
+     */
+    static int pickMemory(int fd, int preferred);
+    static int parseMemory(const char *name);
+    static const char* memoryName(int memory);
+
+    int getMemory() const { return mMemory; }
+    int getNumBuffers() const { return mNumBuffers; }
+
+    /**
+     * VIDIOC_REQBUFS, @count is updated with the number of buffers the
+     * driver granted.
+     */
+    status_t requestBuffers(int *count);
+
+    /**
+     * Prepares buffer @index for streaming. USERPTR takes the caller's
+     * memory in @userData / @userLength, the other strategies ignore them
+     * and map driver memory.
+     */
+    virtual status_t setupBuffer(int index, void *userData, size_t userLength) = 0;
+
+    /**
+     * Unmaps everything and gives the buffers back to the driver.
+     */
+    status_t releaseBuffers();
+
+    Buffer* getBuffer(int index);
+    size_t getBufferLength(int index);
+
+    status_t queueBuffer(int index);
+    status_t dequeueBuffer(int *index);
+
+    void countCopy(size_t bytes);
+    const Stats& getStats() const { return mStats; }
+    void resetStats();
+    void dumpStats(const char *tag) const;
+
+// protected methods
+protected:
+    V4L2BufferStrategy(int fd, int memory, int v4l2Memory);
+
+    status_t queryBuffer(int index);
+    virtual void releaseBuffer(Buffer *buf) {}
+    // bracket CPU access to a dequeued buffer
+    virtual void beginCpuAccess(Buffer *buf) {}
+    virtual void endCpuAccess(Buffer *buf) {}
+
+// protected members
+protected:
+    int mFd;
+    int mMemory;
+    int mV4L2Memory;
+    int mNumBuffers;
+    Buffer *mBuffers;
+    Stats mStats;
+}; // class V4L2BufferStrategy
+
+}; // namespace android
+
+#endif // ANDROID_LIBCAMERA_V4L2_BUFFER_STRATEGY_H
@@ -35,4 +35,29 @@ $(foreach file,$(test_src_files), \
     $(eval include $(BUILD_EXECUTABLE)) \
 )
 
+# Color converter kernels, bit exactness against the C reference and
+# 1080p throughput of each instruction set.
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := \
+    camtest_ColorConvert.cpp \
+    ../ColorConvertKernels.cpp
+LOCAL_SHARED_LIBRARIES := $(shared_libraries)
+LOCAL_STATIC_LIBRARIES := $(static_libraries)
+LOCAL_C_INCLUDES := $(c_includes)
+LOCAL_MODULE := camtest_ColorConvert
+LOCAL_MODULE_TAGS := tests
+include $(BUILD_EXECUTABLE)
+
+# Capture buffer strategies, streams from vivid or CAMTEST_V4L2_DEVICE
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := \
+    camtest_CaptureBuffers.cpp \
+    ../V4L2BufferStrategy.cpp
+LOCAL_SHARED_LIBRARIES := $(shared_libraries) liblog
+LOCAL_STATIC_LIBRARIES := $(static_libraries)
+LOCAL_C_INCLUDES := $(c_includes)
+LOCAL_MODULE := camtest_CaptureBuffers
+LOCAL_MODULE_TAGS := tests
+include $(BUILD_EXECUTABLE)
+
 include $(call all-makefiles-under, $(LOCAL_PATH))
@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <gtest/gtest.h>
+#include <linux/videodev2.h>
+
+#define LOG_TAG "CameraCaptureBuffers"
+#include <utils/Log.h>
+
+#include "../V4L2BufferStrategy.h"
+
+namespace android {
+
+// Streams from a V4L2 capture device with every buffer strategy and
+// reports copies and latency per frame. Meant to run against the vivid
+// virtual driver (modprobe vivid), or the device named by
+// CAMTEST_V4L2_DEVICE. Without a device the tests are skipped.
+class CaptureBuffers : public testing::Test {
+protected:
+    static const int NUM_BUFFERS = 4;
+    static const int NUM_FRAMES = 60;
+    static const int WIDTH = 640;
+    static const int HEIGHT = 480;
+
+    virtual void SetUp()
+    {
+        mFd = -1;
+
+        const char *dev = getenv("CAMTEST_V4L2_DEVICE");
+        if (dev) {
+            mFd = openCapture(dev, NULL);
+        } else {
+            // the first vivid instance
+            char name[32];
+            for (int i = 0; i < 64 && mFd < 0; i++) {
+                snprintf(name, sizeof(name), "/dev/video%d", i);
+                mFd = openCapture(name, "vivid");
+            }
+        }
+
+        if (mFd < 0)
+            printf("no V4L2 capture device, set CAMTEST_V4L2_DEVICE or load vivid\n");
+    }
+
+    virtual void TearDown()
+    {
+        if (mFd >= 0)
+            close(mFd);
+    }
+
+    static int openCapture(const char *name, const char *driver)
+    {
+        int fd = open(name, O_RDWR);
+        if (fd < 0)
+            return -1;
+
+        struct v4l2_capability cap;
+        memset(&cap, 0, sizeof(cap));
+        if (ioctl(fd, VIDIOC_QUERYCAP, &cap) < 0 ||
+            !(cap.capabilities & V4L2_CAP_VIDEO_CAPTURE) ||
+            !(cap.capabilities & V4L2_CAP_STREAMING) ||
+            (driver && strcmp((const char *) cap.driver, driver))) {
+            close(fd);
+            return -1;
+        }
+
+        struct v4l2_format fmt;
+        memset(&fmt, 0, sizeof(fmt));
+        fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        fmt.fmt.pix.width = WIDTH;
+        fmt.fmt.pix.height = HEIGHT;
+        fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_YUYV;
+        fmt.fmt.pix.field = V4L2_FIELD_NONE;
+        if (ioctl(fd, VIDIOC_S_FMT, &fmt) < 0) {
+            close(fd);
+            return -1;
+        }
+
+        printf("capturing from %s (%s)\n", name, cap.driver);
+        return fd;
+    }
+
+    // streams NUM_FRAMES frames, reading every frame where it lies the
+    // way the color converters do
+    void stream(int memory)
+    {
+        V4L2BufferStrategy *strategy = V4L2BufferStrategy::create(mFd, memory);
+        ASSERT_TRUE(strategy != NULL);
+
+        int count = NUM_BUFFERS;
+        void *userMem[NUM_BUFFERS * 2];
+        memset(userMem, 0, sizeof(userMem));
+
+        ASSERT_EQ(NO_ERROR, strategy->requestBuffers(&count));
+        ASSERT_LE(count, NUM_BUFFERS * 2);
+        for (int i = 0; i < count; i++) {
+            size_t length = strategy->getBufferLength(i);
+            if (memory == V4L2BufferStrategy::MEMORY_USERPTR) {
+                ASSERT_EQ(0, posix_memalign(&userMem[i], getpagesize(), length));
+            }
+            ASSERT_EQ(NO_ERROR, strategy->setupBuffer(i, userMem[i], length));
+            ASSERT_EQ(NO_ERROR, strategy->queueBuffer(i));
+        }
+
+        enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        ASSERT_EQ(0, ioctl(mFd, VIDIOC_STREAMON, &type));
+
+        unsigned int checksum = 0;
+        for (int n = 0; n < NUM_FRAMES; n++) {
+            int index = -1;
+            ASSERT_EQ(NO_ERROR, strategy->dequeueBuffer(&index));
+            V4L2BufferStrategy::Buffer *buf = strategy->getBuffer(index);
+            ASSERT_TRUE(buf != NULL && buf->data != NULL);
+            ASSERT_GT(buf->vbuf.bytesused, 0u);
+
+            const unsigned char *p = (const unsigned char *) buf->data;
+            for (unsigned int i = 0; i < buf->vbuf.bytesused; i += 64)
+                checksum += p[i];
+
+            ASSERT_EQ(NO_ERROR, strategy->queueBuffer(index));
+        }
+
+        ioctl(mFd, VIDIOC_STREAMOFF, &type);
+
+        const V4L2BufferStrategy::Stats &s = strategy->getStats();
+        EXPECT_EQ((uint32_t) NUM_FRAMES, s.frames);
+        // nothing asked for a private copy
+        EXPECT_EQ(0u, s.copies);
+
+        printf("  %-8s %d buffers, %u frames, %.2f copies/frame, "
+               "ready avg %lld us max %lld us, latency avg %lld us max %lld us (checksum %x)\n",
+               V4L2BufferStrategy::memoryName(memory), count, s.frames,
+               (float) s.copies / s.frames,
+               (long long) (s.readyTotal / s.frames / 1000), (long long) (s.readyMax / 1000),
+               (long long) (s.latencySamples ? s.latencyTotal / s.latencySamples / 1000 : -1),
+               (long long) (s.latencySamples ? s.latencyMax / 1000 : -1),
+               checksum);
+
+        EXPECT_EQ(NO_ERROR, strategy->releaseBuffers());
+        delete strategy;
+
+        for (int i = 0; i < count; i++)
+            free(userMem[i]);
+    }
+
+    int mFd;
+};
+
+TEST_F(CaptureBuffers, PickMemory)
+{
+    if (mFd < 0)
+        return;
+
+    int picked = V4L2BufferStrategy::pickMemory(mFd, -1);
+    EXPECT_TRUE(picked == V4L2BufferStrategy::MEMORY_MMAP ||
+                picked == V4L2BufferStrategy::MEMORY_USERPTR);
+    EXPECT_EQ(V4L2BufferStrategy::MEMORY_DMABUF,
+              V4L2BufferStrategy::parseMemory("dmabuf"));
+    EXPECT_EQ(-1, V4L2BufferStrategy::parseMemory("bogus"));
+    printf("picked %s\n", V4L2BufferStrategy::memoryName(picked));
+}
+
+TEST_F(CaptureBuffers, UserPtr)
+{
+    if (mFd < 0)
+        return;
+    if (V4L2BufferStrategy::pickMemory(mFd, V4L2BufferStrategy::MEMORY_USERPTR) !=
+            V4L2BufferStrategy::MEMORY_USERPTR) {
+        printf("device does not support USERPTR\n");
+        return;
+    }
+    stream(V4L2BufferStrategy::MEMORY_USERPTR);
+}
+
+TEST_F(CaptureBuffers, Mmap)
+{
+    if (mFd < 0)
+        return;
+    stream(V4L2BufferStrategy::MEMORY_MMAP);
+}
+
+TEST_F(CaptureBuffers, Dmabuf)
+{
+    if (mFd < 0)
+        return;
+    stream(V4L2BufferStrategy::MEMORY_DMABUF);
+}
+
+}; // namespace android
@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../ColorConvertKernels.h"
+
+namespace android {
+
+// Checks every SIMD kernel set against the scalar reference kernels and
+// reports the 1080p throughput of each set.
+class ColorConvert : public testing::Test {
+protected:
+    typedef std::vector<unsigned char> Buffer;
+
+    static void fill(Buffer& buf)
+    {
+        unsigned int seed = 0x12345678;
+        for (size_t i = 0; i < buf.size(); i++) {
+            seed = seed * 1103515245 + 12345;
+            buf[i] = (unsigned char) (seed >> 16);
+        }
+        // make sure the clamping ranges are hit
+        if (buf.size() >= 8) {
+            memset(&buf[0], 0, 4);
+            memset(&buf[4], 0xff, 4);
+        }
+    }
+
+    // 1080p frames through the row kernels of sKernels, laid out as the
+    // ColorConverter.cpp planar converters do
+    static const ColorConvertKernels *sKernels;
+
+    static void yv12ToNV21(int width, int height, void *src, void *dst)
+    {
+        const unsigned char *v = (const unsigned char *) src + width * height;
+        unsigned char *out = (unsigned char *) dst;
+        memcpy(out, src, width * height);
+        sKernels->interleaveUVRow(v, v + width * height / 4, out + width * height,
+                                  width * height / 4);
+    }
+
+    static void yv12ToBGR565(int width, int height, void *src, void *dst)
+    {
+        sKernels->yv12ToBGR565(width, height, width, src, dst);
+    }
+
+    static void nv12ToYV12(int width, int height, void *src, void *dst)
+    {
+        unsigned char *v = (unsigned char *) dst + width * height;
+        memcpy(dst, src, width * height);
+        sKernels->deinterleaveUVRow((const unsigned char *) src + width * height,
+                                    v + width * height / 4, v, width * height / 4);
+    }
+
+    static void yu16ToYV12(int width, int height, void *src, void *dst)
+    {
+        const unsigned char *u = (const unsigned char *) src + width * height;
+        unsigned char *v = (unsigned char *) dst + width * height;
+        int half = width / 2;
+        memcpy(dst, src, width * height);
+        for (int i = 0; i < height / 2; i++) {
+            sKernels->averageRows(u + width * height / 2 + i * width,
+                                  u + width * height / 2 + i * width + half, v + i * half, half);
+            sKernels->averageRows(u + i * width, u + i * width + half,
+                                  v + width * height / 4 + i * half, half);
+        }
+    }
+
+    static void yu16ToYUYV(int width, int height, void *src, void *dst)
+    {
+        const unsigned char *y = (const unsigned char *) src;
+        sKernels->planarToYUYVRow(y, y + width * height, y + width * height * 3 / 2,
+                                  (unsigned char *) dst, width * height / 2);
+    }
+
+    static int64_t nowNs()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    // yuyv input converted by @isa must match the C kernels byte for byte
+    static void checkYUYV(const ColorConvertKernels *k, int width, int height)
+    {
+        const ColorConvertKernels *ref = getColorConvertKernels(COLOR_CONVERT_ISA_C);
+        Buffer src(width * height * 2 + 64);
+        fill(src);
+
+        const size_t outSize = width * height * 4 + 64;
+        Buffer expect(outSize, 0xaa), actual(outSize, 0xaa);
+
+        ref->yuyvToNV12(width, height, &src[0], &expect[0]);
+        k->yuyvToNV12(width, height, &src[0], &actual[0]);
+        EXPECT_TRUE(expect == actual) << k->name << " yuyvToNV12 " << width << "x" << height;
+
+        ref->yuyvToNV21(width, height, &src[0], &expect[0]);
+        k->yuyvToNV21(width, height, &src[0], &actual[0]);
+        EXPECT_TRUE(expect == actual) << k->name << " yuyvToNV21 " << width << "x" << height;
+
+        ref->yuyvToRGB565(width, height, &src[0], &expect[0]);
+        k->yuyvToRGB565(width, height, &src[0], &actual[0]);
+        EXPECT_TRUE(expect == actual) << k->name << " yuyvToRGB565 " << width << "x" << height;
+
+        ref->yuyvToRGB8888(width, height, &src[0], &expect[0]);
+        k->yuyvToRGB8888(width, height, &src[0], &actual[0]);
+        EXPECT_TRUE(expect == actual) << k->name << " yuyvToRGB8888 " << width << "x" << height;
+    }
+
+    static void checkNV12(const ColorConvertKernels *k, int width, int height,
+                          int stride, int alignheight)
+    {
+        const ColorConvertKernels *ref = getColorConvertKernels(COLOR_CONVERT_ISA_C);
+        Buffer src(stride * alignheight * 2 + 64);
+        fill(src);
+
+        const size_t outSize = width * height * 2 + 64;
+        Buffer expect(outSize, 0xaa), actual(outSize, 0xaa);
+
+        if (stride == width && alignheight == height) {
+            ref->nv12ToRGB565(width, height, &src[0], &expect[0]);
+            k->nv12ToRGB565(width, height, &src[0], &actual[0]);
+            EXPECT_TRUE(expect == actual) << k->name << " nv12ToRGB565 " << width << "x" << height;
+        }
+
+        ref->nv12ToRGB565withStride(width, height, stride, alignheight, &src[0], &expect[0]);
+        k->nv12ToRGB565withStride(width, height, stride, alignheight, &src[0], &actual[0]);
+        EXPECT_TRUE(expect == actual) << k->name << " nv12ToRGB565withStride "
+                                      << width << "x" << height << " stride " << stride;
+    }
+
+    static void checkYV12(const ColorConvertKernels *k, int width, int height, int stride)
+    {
+        const ColorConvertKernels *ref = getColorConvertKernels(COLOR_CONVERT_ISA_C);
+        // the C kernel reads and writes a row pair, even for an odd height
+        Buffer src(stride * (height + 1) * 2 + 64);
+        fill(src);
+
+        const size_t outSize = (width + 1) * (height + 1) * 2 + 64;
+        Buffer expect(outSize, 0xaa), actual(outSize, 0xaa);
+
+        ref->yv12ToBGR565(width, height, stride, &src[0], &expect[0]);
+        k->yv12ToBGR565(width, height, stride, &src[0], &actual[0]);
+        EXPECT_TRUE(expect == actual) << k->name << " yv12ToBGR565 "
+                                      << width << "x" << height << " stride " << stride;
+    }
+
+    // the row kernels, at every length around the vector widths and with
+    // unaligned pointers
+    static void checkRows(const ColorConvertKernels *k)
+    {
+        const ColorConvertKernels *ref = getColorConvertKernels(COLOR_CONVERT_ISA_C);
+        Buffer src(4 * 256 + 64);
+        fill(src);
+        const unsigned char *a = &src[1], *b = &src[300], *c = &src[700];
+
+        for (int n = 0; n <= 80; n++) {
+            Buffer expect(4 * n + 64, 0xaa), actual(4 * n + 64, 0xaa);
+
+            ref->interleaveUVRow(a, b, &expect[1], n);
+            k->interleaveUVRow(a, b, &actual[1], n);
+            EXPECT_TRUE(expect == actual) << k->name << " interleaveUVRow " << n;
+
+            ref->deinterleaveUVRow(a, &expect[1], &expect[n + 17], n);
+            k->deinterleaveUVRow(a, &actual[1], &actual[n + 17], n);
+            EXPECT_TRUE(expect == actual) << k->name << " deinterleaveUVRow " << n;
+
+            ref->swapUVRow(a, &expect[1], n);
+            k->swapUVRow(a, &actual[1], n);
+            EXPECT_TRUE(expect == actual) << k->name << " swapUVRow " << n;
+
+            ref->averageRows(a, b, &expect[1], n);
+            k->averageRows(a, b, &actual[1], n);
+            EXPECT_TRUE(expect == actual) << k->name << " averageRows " << n;
+
+            ref->planarToYUYVRow(a, b, c, &expect[1], n);
+            k->planarToYUYVRow(a, b, c, &actual[1], n);
+            EXPECT_TRUE(expect == actual) << k->name << " planarToYUYVRow " << n;
+        }
+    }
+};
+
+const ColorConvertKernels *ColorConvert::sKernels;
+
+TEST_F(ColorConvert, BitExact)
+{
+    static const int sizes[][2] = {
+        { 2, 2 }, { 6, 3 }, { 16, 2 }, { 34, 7 }, { 62, 5 },
+        { 176, 144 }, { 322, 242 }, { 640, 480 },
+    };
+
+    for (int isa = 0; isa < COLOR_CONVERT_ISA_NUM; isa++) {
+        const ColorConvertKernels *k = getColorConvertKernels(isa);
+        if (!k) {
+            printf("%d: not supported, skipped\n", isa);
+            continue;
+        }
+        for (size_t n = 0; n < sizeof(sizes) / sizeof(sizes[0]); n++) {
+            int w = sizes[n][0], h = sizes[n][1];
+            checkYUYV(k, w, h);
+            checkNV12(k, w, h, w, h);
+            checkNV12(k, w, h, (w + 63) & ~63, (h + 31) & ~31);
+            checkYV12(k, w, h, w);
+            checkYV12(k, w, h, (w + 63) & ~63);
+        }
+        checkRows(k);
+    }
+}
+
+TEST_F(ColorConvert, Dispatch)
+{
+    const ColorConvertKernels *best = getColorConvertKernels();
+    ASSERT_TRUE(best != NULL);
+    EXPECT_EQ(best, getColorConvertKernels(best->isa));
+    EXPECT_TRUE(getColorConvertKernels(COLOR_CONVERT_ISA_C) != NULL);
+    EXPECT_TRUE(getColorConvertKernels(COLOR_CONVERT_ISA_NUM) == NULL);
+    printf("selected kernels: %s\n", best->name);
+}
+
+TEST_F(ColorConvert, Throughput1080p)
+{
+    const int width = 1920, height = 1080, frames = 20;
+    Buffer src(width * height * 2);
+    Buffer dst(width * height * 4);
+    fill(src);
+
+    for (int isa = 0; isa < COLOR_CONVERT_ISA_NUM; isa++) {
+        const ColorConvertKernels *k = getColorConvertKernels(isa);
+        if (!k)
+            continue;
+        sKernels = k;
+
+        struct {
+            const char *name;
+            void (*fn)(int, int, void *, void *);
+        } cases[] = {
+            { "yuyvToNV21", k->yuyvToNV21 },
+            { "yuyvToRGB565", k->yuyvToRGB565 },
+            { "yuyvToRGB8888", k->yuyvToRGB8888 },
+            { "nv12ToRGB565", k->nv12ToRGB565 },
+            { "yv12ToNV21", yv12ToNV21 },
+            { "yv12ToBGR565", yv12ToBGR565 },
+            { "nv12ToYV12", nv12ToYV12 },
+            { "yu16ToYV12", yu16ToYV12 },
+            { "yu16ToYUYV", yu16ToYUYV },
+        };
+
+        for (size_t n = 0; n < sizeof(cases) / sizeof(cases[0]); n++) {
+            int64_t start = nowNs();
+            for (int i = 0; i < frames; i++)
+                cases[n].fn(width, height, &src[0], &dst[0]);
+            int64_t perFrame = (nowNs() - start) / frames;
+            printf("  %-6s %-14s %7.3f ms/frame %8.1f fps\n", k->name, cases[n].name,
+                   perFrame / 1e6, perFrame ? 1e9 / perFrame : 0.0);
+        }
+    }
+}
+
+}; // namespace android
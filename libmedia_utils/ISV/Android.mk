@@ -43,4 +43,6 @@ endif
 
 include $(BUILD_SHARED_LIBRARY)
 
+include $(LOCAL_PATH)/test/Android.mk
+
 endif
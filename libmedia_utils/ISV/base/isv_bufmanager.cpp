@@ -15,6 +15,7 @@
  *
  */
 
+#include <string.h>
 #include <media/hardware/HardwareAPI.h>
 #include "isv_bufmanager.h"
 #ifndef TARGET_VPP_USE_GEN
@@ -100,16 +101,90 @@ status_t ISVBuffer::initBufferInfo()
     return OK;
 }
 
+uint32_t ISVBufferManager::homeSlot(unsigned long handle) const
+{
+    // handles are pointers: drop the alignment bits, keep the top bits of
+    // the product
+    uint32_t key = (uint32_t)(handle >> 4) ^ (uint32_t)(handle >> 20);
+    return (key * 0x9E3779B1u) >> mIndexShift;
+}
+
+ssize_t ISVBufferManager::findSlot(unsigned long handle) const
+{
+    if (mBuffers == NULL)
+        return -1;
+
+    uint32_t mask = (1u << (32 - mIndexShift)) - 1;
+    for (uint32_t i = homeSlot(handle); mBuffers[i] != NULL; i = (i + 1) & mask) {
+        if (mBuffers[i]->getHandle() == handle)
+            return i;
+    }
+    return -1;
+}
+
+void ISVBufferManager::insertBuffer(ISVBuffer* isvBuffer)
+{
+    uint32_t mask = (1u << (32 - mIndexShift)) - 1;
+    uint32_t i = homeSlot(isvBuffer->getHandle());
+
+    while (mBuffers[i] != NULL)
+        i = (i + 1) & mask;
+    mBuffers[i] = isvBuffer;
+}
+
+void ISVBufferManager::removeSlot(uint32_t slot)
+{
+    uint32_t mask = (1u << (32 - mIndexShift)) - 1;
+    uint32_t hole = slot;
+
+    // shift back the following entries of the cluster which can not be
+    // reached from their home slot anymore
+    mBuffers[hole] = NULL;
+    for (uint32_t i = (slot + 1) & mask; mBuffers[i] != NULL; i = (i + 1) & mask) {
+        uint32_t home = homeSlot(mBuffers[i]->getHandle());
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            mBuffers[hole] = mBuffers[i];
+            mBuffers[i] = NULL;
+            hole = i;
+        }
+    }
+}
+
+void ISVBufferManager::resizeIndex(uint32_t maxBuffers)
+{
+    ISVBuffer** oldBuffers = mBuffers;
+    uint32_t oldSize = (oldBuffers != NULL) ? 1u << (32 - mIndexShift) : 0;
+    uint32_t size = 8;
+
+    mIndexShift = 29;
+    while (size < 2 * maxBuffers) {
+        size <<= 1;
+        mIndexShift--;
+    }
+
+    mBuffers = new ISVBuffer*[size];
+    memset(mBuffers, 0, size * sizeof(ISVBuffer*));
+    for (uint32_t i = 0; i < oldSize; i++) {
+        if (oldBuffers[i] != NULL)
+            insertBuffer(oldBuffers[i]);
+    }
+    delete[] oldBuffers;
+}
+
 status_t ISVBufferManager::setBufferCount(int32_t size)
 {
     Mutex::Autolock autoLock(mBufferLock);
 #if 0
-    if (!mBuffers.isEmpty()) {
+    if (mNumBuffers != 0) {
         ALOGE("%s: the buffer queue should be empty before we set its size", __func__);
         return STATUS_ERROR;
     }
 #endif
-    mBuffers.setCapacity(size);
+    if (size < 0)
+        return BAD_VALUE;
+
+    mMaxBuffers = size;
+    resizeIndex(mMaxBuffers > mNumBuffers ? mMaxBuffers : mNumBuffers);
 
     return OK;
 }
@@ -117,15 +192,14 @@ status_t ISVBufferManager::setBufferCount(int32_t size)
 status_t ISVBufferManager::freeBuffer(unsigned long handle)
 {
     Mutex::Autolock autoLock(mBufferLock);
-    for (uint32_t i = 0; i < mBuffers.size(); i++) {
-        ISVBuffer* isvBuffer = mBuffers.itemAt(i);
-        if (isvBuffer->getHandle() == handle) {
-            delete isvBuffer;
-            mBuffers.removeAt(i);
-            ALOGD_IF(ISV_BUFFER_MANAGER_DEBUG, "%s: remove handle 0x%08x, and then mBuffers.size() %d", __func__,
-                    handle, mBuffers.size());
-            return OK;
-        }
+    ssize_t slot = findSlot(handle);
+    if (slot >= 0) {
+        delete mBuffers[slot];
+        removeSlot(slot);
+        mNumBuffers--;
+        ALOGD_IF(ISV_BUFFER_MANAGER_DEBUG, "%s: remove handle 0x%08x, and then mNumBuffers %d", __func__,
+                handle, mNumBuffers);
+        return OK;
     }
 
     ALOGW("%s: can't find buffer %u", __func__, handle);
@@ -135,22 +209,20 @@ status_t ISVBufferManager::freeBuffer(unsigned long handle)
 status_t ISVBufferManager::useBuffer(unsigned long handle)
 {
     Mutex::Autolock autoLock(mBufferLock);
-    if (handle == 0 || mBuffers.size() >= mBuffers.capacity())
+    if (handle == 0 || mNumBuffers >= mMaxBuffers)
         return BAD_VALUE;
 
-    for (uint32_t i = 0; i < mBuffers.size(); i++) {
-        ISVBuffer* isvBuffer = mBuffers.itemAt(i);
-        if (isvBuffer->getHandle() == handle) {
-            ALOGE("%s: this buffer 0x%08x has already been registered", __func__, handle);
-            return UNKNOWN_ERROR;
-        }
+    if (findSlot(handle) >= 0) {
+        ALOGE("%s: this buffer 0x%08x has already been registered", __func__, handle);
+        return UNKNOWN_ERROR;
     }
 
     ISVBuffer* isvBuffer = new ISVBuffer(mWorker, handle, mMetaDataMode ? ISVBuffer::ISV_BUFFER_METADATA : ISVBuffer::ISV_BUFFER_GRALLOC);
-   
-    ALOGD_IF(ISV_BUFFER_MANAGER_DEBUG, "%s: add handle 0x%08x, and then mBuffers.size() %d", __func__,
-            handle, mBuffers.size());
-    mBuffers.push_back(isvBuffer);
+
+    ALOGD_IF(ISV_BUFFER_MANAGER_DEBUG, "%s: add handle 0x%08x, and then mNumBuffers %d", __func__,
+            handle, mNumBuffers);
+    insertBuffer(isvBuffer);
+    mNumBuffers++;
     return OK;
 
 }
@@ -158,15 +230,12 @@ status_t ISVBufferManager::useBuffer(unsigned long handle)
 status_t ISVBufferManager::useBuffer(const sp<ANativeWindowBuffer> nativeBuffer)
 {
     Mutex::Autolock autoLock(mBufferLock);
-    if (nativeBuffer == NULL || mBuffers.size() >= mBuffers.capacity())
+    if (nativeBuffer == NULL || mNumBuffers >= mMaxBuffers)
         return BAD_VALUE;
 
-    for (uint32_t i = 0; i < mBuffers.size(); i++) {
-        ISVBuffer* isvBuffer = mBuffers.itemAt(i);
-        if (isvBuffer->getHandle() == (unsigned long)nativeBuffer->handle) {
-            ALOGE("%s: this buffer 0x%08x has already been registered", __func__, nativeBuffer->handle);
-            return UNKNOWN_ERROR;
-        }
+    if (findSlot((unsigned long)nativeBuffer->handle) >= 0) {
+        ALOGE("%s: this buffer 0x%08x has already been registered", __func__, nativeBuffer->handle);
+        return UNKNOWN_ERROR;
     }
 
     ISVBuffer* isvBuffer = new ISVBuffer(mWorker,
@@ -175,20 +244,16 @@ status_t ISVBufferManager::useBuffer(const sp<ANativeWindowBuffer> nativeBuffer)
             nativeBuffer->stride, nativeBuffer->format,
             mMetaDataMode ? ISVBuffer::ISV_BUFFER_METADATA : ISVBuffer::ISV_BUFFER_GRALLOC);
 
-    ALOGD_IF(ISV_BUFFER_MANAGER_DEBUG, "%s: add handle 0x%08x, and then mBuffers.size() %d", __func__,
-            nativeBuffer->handle, mBuffers.size());
-    mBuffers.push_back(isvBuffer);
+    ALOGD_IF(ISV_BUFFER_MANAGER_DEBUG, "%s: add handle 0x%08x, and then mNumBuffers %d", __func__,
+            nativeBuffer->handle, mNumBuffers);
+    insertBuffer(isvBuffer);
+    mNumBuffers++;
     return OK;
 }
 
 ISVBuffer* ISVBufferManager::mapBuffer(unsigned long handle)
 {
     Mutex::Autolock autoLock(mBufferLock);
-    for (uint32_t i = 0; i < mBuffers.size(); i++) {
-        ISVBuffer* isvBuffer = mBuffers.itemAt(i);
-        if (isvBuffer->getHandle() == handle)
-            return isvBuffer;
-    }
-    return NULL;
+    ssize_t slot = findSlot(handle);
+    return (slot >= 0) ? mBuffers[slot] : NULL;
 }
-
@@ -16,7 +16,9 @@
  */
 
 #include <math.h>
+#include <stdlib.h>
 #include <utils/Errors.h>
+#include <cutils/properties.h>
 #include "isv_processor.h"
 #include "isv_profile.h"
 #include "isv_omxcomponent.h"
@@ -41,7 +43,11 @@ ISVProcessor::ISVProcessor(bool canCallJava,
     mBufferManager(bufferManager),
     mOutputProcIdx(0),
     mInputProcIdx(0),
-    mNumTaskInProcesing(0),
+    mSubmitWaiting(0),
+    mFillThread(NULL),
+    mMaxTasks(0),
+    mFillWaiting(0),
+    mFillPaused(false),
     mNumRetry(0),
     mLastTimeStamp(0),
     mError(false),
@@ -69,6 +75,11 @@ ISVProcessor::ISVProcessor(bool canCallJava,
     mFilterParam.srcHeight = mFilterParam.dstHeight = height;
     mOutputBuffers.clear();
     mInputBuffers.clear();
+
+    // 0 lets getMaxTasks() follow the forward references
+    char propValueString[PROPERTY_VALUE_MAX];
+    property_get("vpp.isv.tasks", propValueString, "0");
+    mMaxTasks = atoi(propValueString);
 }
 
 ISVProcessor::~ISVProcessor() {
@@ -101,6 +112,8 @@ void ISVProcessor::start()
 
     mBufferManager->setWorker(mISVWorker);
 
+    mFillThread = new ISVFillThread(this);
+    mFillThread->run("ISVFillThread", ANDROID_PRIORITY_NORMAL);
     this->run("ISVProcessor", ANDROID_PRIORITY_NORMAL);
     mThreadRunning = true;
     return;
@@ -112,11 +125,19 @@ void ISVProcessor::stop()
 
     if(mThreadRunning) {
         this->requestExit();
+        mFillThread->requestExit();
         {
             Mutex::Autolock autoLock(mLock);
             mRunCond.signal();
         }
+        {
+            Mutex::Autolock autoLock(mFillLock);
+            mFillCond.broadcast();
+        }
         this->requestExitAndWait();
+        mFillThread->requestExitAndWait();
+        mFillThread = NULL;
+        mTasks.clear();
         mThreadRunning = false;
     }
 
@@ -127,52 +148,24 @@ void ISVProcessor::stop()
     return;
 }
 
-bool ISVProcessor::getBufForFirmwareOutput(Vector<ISVBuffer*> *fillBufList,uint32_t *fillBufNum){
-    uint32_t i = 0;
-    // output buffer number for filling
-    *fillBufNum = 0;
-    uint32_t needFillNum = 0;
-    OMX_BUFFERHEADERTYPE *outputBuffer;
-
-    //output data available
-    needFillNum = mISVWorker->getFillBufCount();
-    if (mOutputProcIdx < needFillNum ||
-            mInputProcIdx < 1) {
-        ALOGE("%s: no enough input or output buffer which need to be sync", __func__);
-        return false;
-    }
-
-    if ((needFillNum == 0) || (needFillNum > 4))
-       return false;
-
-    Mutex::Autolock autoLock(mOutputLock);
-    for (i = 0; i < needFillNum; i++) {
-        //fetch the render buffer from the top of output buffer queue
-        outputBuffer = mOutputBuffers.itemAt(i);
-        unsigned long fillHandle = reinterpret_cast<unsigned long>(outputBuffer->pBuffer);
-        ISVBuffer* fillBuf = mBufferManager->mapBuffer(fillHandle);
-        fillBufList->push_back(fillBuf);
-    }
-
-    *fillBufNum  = i;
-    return true;
-}
-
-
 status_t ISVProcessor::updateFirmwareOutputBufStatus(uint32_t fillBufNum) {
     int64_t timeUs;
     OMX_BUFFERHEADERTYPE *outputBuffer;
     OMX_BUFFERHEADERTYPE *inputBuffer;
     OMX_ERRORTYPE err;
 
-    if (mInputBuffers.empty()) {
-        ALOGE("%s: input buffer queue is empty. no buffer need to be sync", __func__);
-        return UNKNOWN_ERROR;
-    }
+    {
+        Mutex::Autolock inputLock(mInputLock);
+        Mutex::Autolock outputLock(mOutputLock);
+        if (mInputBuffers.empty()) {
+            ALOGE("%s: input buffer queue is empty. no buffer need to be sync", __func__);
+            return UNKNOWN_ERROR;
+        }
 
-    if (mOutputBuffers.size() < fillBufNum) {
-        ALOGE("%s: no enough output buffer which need to be sync", __func__);
-        return UNKNOWN_ERROR;
+        if (mOutputBuffers.size() < fillBufNum) {
+            ALOGE("%s: no enough output buffer which need to be sync", __func__);
+            return UNKNOWN_ERROR;
+        }
     }
     // remove one buffer from intput buffer queue
     {
@@ -279,8 +272,11 @@ status_t ISVProcessor::updateFirmwareInputBufStatus(uint32_t procBufNum)
     OMX_BUFFERHEADERTYPE *outputBuffer;
     OMX_BUFFERHEADERTYPE *inputBuffer;
 
-    inputBuffer = mInputBuffers.itemAt(mInputProcIdx);
-    mInputProcIdx++;
+    {
+        Mutex::Autolock autoLock(mInputLock);
+        inputBuffer = mInputBuffers.itemAt(mInputProcIdx);
+        mInputProcIdx++;
+    }
 
     Mutex::Autolock autoLock(mOutputLock);
     for(uint32_t i = 0; i < procBufNum; i++) {
@@ -302,6 +298,11 @@ bool ISVProcessor::isReadytoRun()
 {
     ALOGD_IF(ISV_THREAD_DEBUG, "%s: mISVWorker->getProcBufCount() return %d", __func__,
             mISVWorker->getProcBufCount());
+    if (mTasks.size() >= getMaxTasks())
+        return false;
+
+    Mutex::Autolock inputLock(mInputLock);
+    Mutex::Autolock outputLock(mOutputLock);
     if (mInputProcIdx < mInputBuffers.size() 
             && (mOutputBuffers.size() - mOutputProcIdx) >= mISVWorker->getProcBufCount())
        return true;
@@ -309,77 +310,180 @@ bool ISVProcessor::isReadytoRun()
        return false;
 }
 
+bool ISVProcessor::isReadytoFill()
+{
+    // the tasks of the forward references are filled once newer tasks
+    // have been submitted
+    uint32_t numTasks = mTasks.size();
+    return (numTasks > 0) && numTasks >= mISVWorker->mNumForwardReferences;
+}
+
+uint32_t ISVProcessor::getMaxTasks()
+{
+    // forward references, plus one task in the VSP, plus one being submitted
+    uint32_t minTasks = mISVWorker->mNumForwardReferences + 1;
+    uint32_t maxTasks = (mMaxTasks != 0) ? mMaxTasks : minTasks + 1;
+
+    if (maxTasks < minTasks)
+        maxTasks = minTasks;
+    return (maxTasks > ISV_MAX_TASKS) ? ISV_MAX_TASKS : maxTasks;
+}
+
+void ISVProcessor::pauseFill()
+{
+    Mutex::Autolock autoLock(mFillLock);
+    mFillPaused = true;
+    mFillCond.broadcast();
+    while (!android_atomic_acquire_load(&mFillWaiting) && !mError)
+        mFillCond.wait(mFillLock);
+}
+
+void ISVProcessor::resumeFill()
+{
+    Mutex::Autolock autoLock(mFillLock);
+    mFillPaused = false;
+    mFillCond.broadcast();
+}
 
 bool ISVProcessor::threadLoop() {
-    uint32_t procBufNum = 0, fillBufNum = 0;
+    uint32_t procBufNum = 0;
     ISVBuffer* inputBuf;
     Vector<ISVBuffer*> procBufList;
-    Vector<ISVBuffer*> fillBufList;
     uint32_t flags = 0;
-    bool bGetBufSuccess = true;
 
-    Mutex::Autolock autoLock(mLock);
+    if (mError)
+        return false;
 
-    if (!isReadytoRun() && !mbFlush) {
-        mRunCond.wait(mLock);
+    {
+        Mutex::Autolock autoLock(mLock);
+        if (!mbFlush && !isReadytoRun()) {
+            // the fill stage signals only a waiting thread
+            android_atomic_or(1, &mSubmitWaiting);
+            if (!mbFlush && !isReadytoRun() && !exitPending() && !mError)
+                mRunCond.wait(mLock);
+            android_atomic_and(0, &mSubmitWaiting);
+        }
     }
 
-    if (isReadytoRun() || mbFlush) {
-        procBufList.clear();
+    if (mbFlush) {
+        // park the fill stage, the tasks in flight are flushed
+        pauseFill();
         bool bGetInBuf = getBufForFirmwareInput(&procBufList, &inputBuf, &procBufNum);
         if (bGetInBuf) {
-            if (!mbFlush)
-                flags = mInputBuffers[mInputProcIdx]->nFlags;
             status_t ret = mISVWorker->process(inputBuf, procBufList, procBufNum, mbFlush, flags);
             if (ret == STATUS_OK) {
                 // for seek and EOS
-                if (mbFlush) {
-                    mISVWorker->reset();
-                    flush();
+                mISVWorker->reset();
+                flush();
 
-                    mNumTaskInProcesing = 0;
-                    mInputProcIdx = 0;
-                    mOutputProcIdx = 0;
+                mTasks.clear();
+                mInputProcIdx = 0;
+                mOutputProcIdx = 0;
 
-                    mbFlush = false;
+                mbFlush = false;
+                resumeFill();
 
-                    Mutex::Autolock endLock(mEndLock);
-                    mEndCond.signal();
-                    return true;
-                }
-                mNumTaskInProcesing++;
+                Mutex::Autolock endLock(mEndLock);
+                mEndCond.signal();
+                return true;
+            }
+            mbBypass = true;
+            flush();
+            mTasks.clear();
+            mInputProcIdx = 0;
+            mOutputProcIdx = 0;
+            ALOGE("VSP process error %d .... ISV changes to bypass mode", __LINE__);
+        }
+        resumeFill();
+        return true;
+    }
+
+    if (isReadytoRun()) {
+        bool bGetInBuf = getBufForFirmwareInput(&procBufList, &inputBuf, &procBufNum);
+        if (bGetInBuf) {
+            {
+                Mutex::Autolock autoLock(mInputLock);
+                flags = mInputBuffers[mInputProcIdx]->nFlags;
+            }
+            status_t ret = mISVWorker->process(inputBuf, procBufList, procBufNum, false, flags);
+            if (ret == STATUS_OK) {
                 updateFirmwareInputBufStatus(procBufNum);
+
+                // hand the task over to the fill stage
+                ISVTask* task = mTasks.back();
+                task->fillBufList = procBufList;
+                task->fillBufNum = procBufNum;
+                mTasks.push();
+                ALOGV("tasks in flight %d", mTasks.size());
+                // the push is a barrier, see fillLoop()
+                if (android_atomic_acquire_load(&mFillWaiting)) {
+                    Mutex::Autolock autoLock(mFillLock);
+                    mFillCond.broadcast();
+                }
             } else {
+                pauseFill();
                 mbBypass = true;
                 flush();
+                mTasks.clear();
+                mInputProcIdx = 0;
+                mOutputProcIdx = 0;
+                resumeFill();
                 ALOGE("VSP process error %d .... ISV changes to bypass mode", __LINE__);
             }
         }
     }
 
-    ALOGV("mNumTaskInProcesing %d", mNumTaskInProcesing);
-    while ((mNumTaskInProcesing > 0) && mNumTaskInProcesing >= mISVWorker->mNumForwardReferences && bGetBufSuccess ) {
-        fillBufList.clear();
-        bGetBufSuccess = getBufForFirmwareOutput(&fillBufList, &fillBufNum);
-        ALOGD_IF(ISV_THREAD_DEBUG, "%s: bGetOutput %d, buf num %d", __func__,
-                bGetBufSuccess, fillBufNum);
-        if (bGetBufSuccess) {
-            status_t ret = mISVWorker->fill(fillBufList, fillBufNum);
-            if (ret == STATUS_OK) {
-                mNumTaskInProcesing--;
-                ALOGV("mNumTaskInProcesing: %d ...", mNumTaskInProcesing);
-                updateFirmwareOutputBufStatus(fillBufNum);
-            } else {
-                mError = true;
-                ALOGE("ISV read firmware data error! Thread EXIT...");
+    return true;
+}
+
+bool ISVProcessor::fillLoop() {
+    {
+        Mutex::Autolock autoLock(mFillLock);
+        while (mFillPaused || !isReadytoFill()) {
+            if (mFillThread->exitPending())
                 return false;
-            }
+            // set before checking again, a task pushed meanwhile sees it
+            android_atomic_or(1, &mFillWaiting);
+            if (!mFillPaused && isReadytoFill())
+                break;
+            mFillCond.broadcast();
+            mFillCond.wait(mFillLock);
         }
+        android_atomic_and(0, &mFillWaiting);
     }
 
+    ISVTask* task = mTasks.front();
+    ALOGD_IF(ISV_THREAD_DEBUG, "%s: tasks in flight %d, buf num %d", __func__,
+            mTasks.size(), task->fillBufNum);
+    status_t ret = mISVWorker->fill(task->fillBufList, task->fillBufNum);
+    if (ret != STATUS_OK) {
+        ALOGE("ISV read firmware data error! Thread EXIT...");
+        {
+            Mutex::Autolock autoLock(mFillLock);
+            mError = true;
+            mFillCond.broadcast();
+        }
+        // the submit stage may wait for a free task slot
+        Mutex::Autolock autoLock(mLock);
+        mRunCond.signal();
+        return false;
+    }
+    updateFirmwareOutputBufStatus(task->fillBufNum);
+    task->fillBufList.clear();
+    mTasks.pop();
+
+    // the pop is a barrier, see threadLoop()
+    if (android_atomic_acquire_load(&mSubmitWaiting)) {
+        Mutex::Autolock autoLock(mLock);
+        mRunCond.signal();
+    }
     return true;
 }
 
+bool ISVFillThread::threadLoop() {
+    return mProcessor->fillLoop();
+}
+
 bool ISVProcessor::isCurrentThread() const {
     return mThreadId == androidGetThreadId();
 }
@@ -497,7 +601,7 @@ void ISVProcessor::addOutput(OMX_BUFFERHEADERTYPE* output)
         return;
     }
 
-    if (mbBypass || mOutputBuffers.size() >= MIN_OUTPUT_NUM) {
+    if (mbBypass) {
         // return this buffer to decoder
         mpOwner->releaseBuffer(kPortIndexInput, output, false);
         return;
@@ -509,6 +613,12 @@ void ISVProcessor::addOutput(OMX_BUFFERHEADERTYPE* output)
         Mutex::Autolock autoLock(mOutputLock);
         ALOGD_IF(ISV_COMPONENT_LOCK_DEBUG, "%s: acqired mOutputLock", __func__);
 
+        // the fill stage shrinks the queue meanwhile
+        if (mOutputBuffers.size() >= MIN_OUTPUT_NUM) {
+            mpOwner->releaseBuffer(kPortIndexInput, output, false);
+            return;
+        }
+
         mOutputBuffers.push_back(output);
         ALOGD_IF(ISV_THREAD_DEBUG, "%s: hold pBuffer %u in output buffer queue. Input queue size is %d, mInputProIdx %d.\
                 Output queue size is %d, mOutputProcIdx %d", __func__,
@@ -526,9 +636,13 @@ void ISVProcessor::addOutput(OMX_BUFFERHEADERTYPE* output)
 
 void ISVProcessor::notifyFlush()
 {
-    if (mInputBuffers.empty() && mOutputBuffers.empty()) {
-        ALOGD_IF(ISV_THREAD_DEBUG, "%s: input and ouput buffer queue is empty, nothing need to do", __func__);
-        return;
+    {
+        Mutex::Autolock inputLock(mInputLock);
+        Mutex::Autolock outputLock(mOutputLock);
+        if (mInputBuffers.empty() && mOutputBuffers.empty()) {
+            ALOGD_IF(ISV_THREAD_DEBUG, "%s: input and ouput buffer queue is empty, nothing need to do", __func__);
+            return;
+        }
     }
 
     Mutex::Autolock autoLock(mLock);
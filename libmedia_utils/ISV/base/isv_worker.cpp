@@ -14,6 +14,7 @@
  * limitations under the License.
  *
  */
+#include <unistd.h>
 #include <cutils/properties.h>
 #include "isv_worker.h"
 #ifndef TARGET_VPP_USE_GEN
@@ -24,6 +25,9 @@
 #undef LOG_TAG
 #define LOG_TAG "isv-omxil"
 
+// poll period of syncSurface(), short against the 16 ms of a 60 fps frame
+#define ISV_SYNC_POLL_US 500
+
 #define CHECK_VASTATUS(str) \
     do { \
         if (vaStatus != VA_STATUS_SUCCESS) { \
@@ -690,6 +694,9 @@ status_t ISVWorker::process(ISVBuffer* inputBuffer, Vector<ISVBuffer*> outputBuf
 
     mPrevInput = input;
 
+    // the fill thread may be waiting for a former task
+    Mutex::Autolock vaLock(mVALock);
+
     // create pipeline parameter buffer
     vaStatus = vaCreateBuffer(mVADisplay,
             mVAContext,
@@ -846,14 +853,15 @@ status_t ISVWorker::fill(Vector<ISVBuffer*> outputBuffer, uint32_t outputCount)
             vaStatus = STATUS_ERROR;
         }
 #endif
-        vaStatus = vaSyncSurface(mVADisplay, output[i]);
-        CHECK_VASTATUS("vaSyncSurface");
+        if (syncSurface(output[i]) != STATUS_OK)
+            return STATUS_ERROR;
         vaStatus = STATUS_OK;
         mOutputCount++;
         //dumpYUVFrameData(output[i]);
     }
 
     {
+        Mutex::Autolock vaLock(mVALock);
         Mutex::Autolock autoLock(mPipelineBufferLock);
         if (vaStatus == STATUS_OK) {
             VABufferID pipelineBuffer = mPipelineBuffers.itemAt(0);
@@ -870,6 +878,30 @@ status_t ISVWorker::fill(Vector<ISVBuffer*> outputBuffer, uint32_t outputCount)
     return vaStatus;
 }
 
+// libva does not promise that calls on one VADisplay can be made from several
+// threads at once, so process() and fill() take mVALock for their VA calls.
+// vaSyncSurface() would keep it for the whole task and stall the submission
+// of the next one: the status is polled instead, the lock being released
+// between the polls.
+status_t ISVWorker::syncSurface(VASurfaceID surface) {
+    VAStatus vaStatus;
+    VASurfaceStatus surStatus;
+
+    for (;;) {
+        {
+            Mutex::Autolock vaLock(mVALock);
+            vaStatus = vaQuerySurfaceStatus(mVADisplay, surface, &surStatus);
+            CHECK_VASTATUS("vaQuerySurfaceStatus");
+            if (surStatus != VASurfaceRendering) {
+                vaStatus = vaSyncSurface(mVADisplay, surface);
+                CHECK_VASTATUS("vaSyncSurface");
+                return STATUS_OK;
+            }
+        }
+        usleep(ISV_SYNC_POLL_US);
+    }
+}
+
 // Debug only
 #define FRAME_OUTPUT_FILE_NV12 "/storage/sdcard0/vpp_output.nv12"
 status_t ISVWorker::dumpYUVFrameData(VASurfaceID surfaceID) {
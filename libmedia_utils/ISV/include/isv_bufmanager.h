@@ -116,10 +116,14 @@ class ISVBufferManager: public RefBase
 public:
     ISVBufferManager()
         :mWorker(NULL),
-        mMetaDataMode(false) {}
-
-    ~ISVBufferManager() {}
-    // set mBuffers size
+        mMetaDataMode(false),
+        mBuffers(NULL),
+        mNumBuffers(0),
+        mMaxBuffers(0),
+        mIndexShift(32) {}
+
+    ~ISVBufferManager() { delete[] mBuffers; }
+    // set the max number of registered buffers
     status_t setBufferCount(int32_t size);
 
     // register/unregister ISVBuffers to mBuffers
@@ -127,7 +131,7 @@ public:
     status_t useBuffer(unsigned long handle);
     status_t freeBuffer(unsigned long handle);
 
-    // Map to ISVBuffer
+    // Map to ISVBuffer, in O(1)
     ISVBuffer* mapBuffer(unsigned long handle);
     // set isv worker
     void setWorker(sp<ISVWorker> worker) { mWorker = worker; }
@@ -138,10 +142,20 @@ private:
         META_DATA_MODE = 1,
     } ISV_WORK_MODE;
 
+    // slot of handle in mBuffers, -1 if it is not registered
+    ssize_t findSlot(unsigned long handle) const;
+    uint32_t homeSlot(unsigned long handle) const;
+    void insertBuffer(ISVBuffer* isvBuffer);
+    void removeSlot(uint32_t slot);
+    void resizeIndex(uint32_t maxBuffers);
+
     sp<ISVWorker> mWorker;
     bool mMetaDataMode;
-    // VPP buffer queue
-    Vector<ISVBuffer*> mBuffers;
+    // VPP buffers, open addressed by handle and kept at most half full
+    ISVBuffer** mBuffers;
+    uint32_t mNumBuffers;
+    uint32_t mMaxBuffers;
+    uint32_t mIndexShift; // 32 - log2 of the table size
     Mutex mBufferLock; // to protect access to mBuffers
 };
 
@@ -24,10 +24,14 @@
 #include <utils/Mutex.h>
 #include <utils/threads.h>
 #include <utils/Errors.h>
+#include <cutils/atomic.h>
 #include "isv_bufmanager.h"
 #define ISV_COMPONENT_LOCK_DEBUG 0
 #define ISV_THREAD_DEBUG 0
 
+// max tasks in flight between the submit and the fill stages, a power of two
+#define ISV_MAX_TASKS 8
+
 using namespace android;
 
 typedef enum {
@@ -42,6 +46,61 @@ public:
     virtual OMX_ERRORTYPE releaseBuffer(PORT_INDEX index, OMX_BUFFERHEADERTYPE* pBuffer, bool bFlush) = 0;
 };
 
+// a task submitted to the VSP, waiting to be filled
+typedef struct {
+    Vector<ISVBuffer*> fillBufList;
+    uint32_t fillBufNum;
+} ISVTask;
+
+// Single producer, single consumer ring of the tasks in flight. The submit
+// stage writes the back slot in place then pushes it, the fill stage reads
+// the front slot then pops it. The count publishes the slots.
+class ISVTaskQueue
+{
+public:
+    ISVTaskQueue()
+        :mHead(0),
+        mTail(0),
+        mCount(0) {}
+
+    uint32_t size() const { return android_atomic_acquire_load(&mCount); }
+
+    // producer side
+    ISVTask* back() { return &mTasks[mTail & (ISV_MAX_TASKS - 1)]; }
+    void push() { mTail++; android_atomic_inc(&mCount); }
+
+    // consumer side
+    ISVTask* front() { return &mTasks[mHead & (ISV_MAX_TASKS - 1)]; }
+    void pop() { mHead++; android_atomic_dec(&mCount); }
+
+    // drop all the tasks, the consumer must be paused
+    void clear() { mHead = mTail; android_atomic_release_store(0, &mCount); }
+
+private:
+    ISVTask mTasks[ISV_MAX_TASKS];
+    uint32_t mHead;
+    uint32_t mTail;
+    volatile int32_t mCount;
+};
+
+class ISVProcessor;
+
+// fill stage of the processor, blocks on the VSP for the submitted tasks
+class ISVFillThread : public Thread
+{
+public:
+    ISVFillThread(ISVProcessor* processor)
+        :Thread(false),
+        mProcessor(processor) {}
+
+private:
+    virtual bool threadLoop();
+
+    ISVProcessor* mProcessor;
+};
+
+// Submit stage of the VSP pipeline. The thread submits the tasks, up to
+// getMaxTasks() in flight, and ISVFillThread waits for them in order.
 class ISVProcessor : public Thread
 {
 public:
@@ -69,10 +128,20 @@ public:
     //notify flush and wait flush finish
     void notifyFlush();
     void waitFlushFinished();
+    //set the max tasks in flight, 0 follows the forward references
+    void setMaxTasks(uint32_t maxTasks) { mMaxTasks = maxTasks; }
 
 private:
-    bool getBufForFirmwareOutput(Vector<ISVBuffer*> *fillBufList,
-            uint32_t *fillBufNum);
+    friend class ISVFillThread;
+
+    // one pass of the fill stage, returns false to exit
+    bool fillLoop();
+    bool isReadytoFill();
+    // max tasks in flight, configured by vpp.isv.tasks
+    uint32_t getMaxTasks();
+    // park and resume the fill stage, to flush the tasks in flight
+    void pauseFill();
+    void resumeFill();
     status_t updateFirmwareOutputBufStatus(uint32_t fillBufNum);
     bool getBufForFirmwareInput(Vector<ISVBuffer*> *procBufList,
             ISVBuffer **inputBuf,
@@ -106,12 +175,21 @@ private:
     // conditon for thread running
     Mutex mLock;
     Condition mRunCond;
+    volatile int32_t mSubmitWaiting;
+
+    // tasks in flight and the fill stage waiting for them
+    sp<ISVFillThread> mFillThread;
+    ISVTaskQueue mTasks;
+    uint32_t mMaxTasks;
+    Mutex mFillLock;
+    Condition mFillCond;
+    volatile int32_t mFillWaiting;
+    bool mFillPaused;
 
     // condition for seek finish
     Mutex mEndLock;
     Condition mEndCond;
 
-    uint32_t mNumTaskInProcesing;
     uint32_t mNumRetry;
     int64_t mLastTimeStamp;
     bool mError;
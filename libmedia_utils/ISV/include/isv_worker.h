@@ -101,7 +101,9 @@ class ISVWorker : public RefBase
         // Get output buffer number needed for filling
         uint32_t getFillBufCount();
 
-        // Send input and output buffers to VSP to begin processing
+        // Send input and output buffers to VSP to begin processing. process()
+        // and fill() run on the submit and fill threads of ISVProcessor, their
+        // VA calls are serialized by mVALock
         status_t process(ISVBuffer* input, Vector<ISVBuffer*> output, uint32_t outputCount, bool isEOS, uint32_t flags);
 
         // Fill output buffers given, it's a blocking call
@@ -142,6 +144,10 @@ class ISVWorker : public RefBase
         // Setup pipeline caps
         status_t setupPipelineCaps();
 
+        // Wait for the VSP to be done with a surface, without holding mVALock
+        // while it renders
+        status_t syncSurface(VASurfaceID surface);
+
         //check if the input fps is suportted in array fpsSet.
         bool isFpsSupport(int32_t fps, int32_t *fpsSet, int32_t fpsSetCnt);
 
@@ -168,6 +174,7 @@ class ISVWorker : public RefBase
         // Forward References Surfaces
         Vector<VABufferID> mPipelineBuffers;
         Mutex mPipelineBufferLock; // to protect access to mPipelineBuffers
+        Mutex mVALock; // taken before mPipelineBufferLock
         VASurfaceID *mForwardReferences;
         VASurfaceID mPrevInput;
         VASurfaceID mPrevOutput;
@@ -0,0 +1,28 @@
+LOCAL_PATH := $(call my-dir)
+
+# host benchmark of the processor pipeline on a mock ISVWorker
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+	isv_processor_benchmark.cpp \
+	../base/isv_processor.cpp \
+	../base/isv_bufmanager.cpp
+
+LOCAL_MODULE_TAGS := tests
+LOCAL_MODULE := isv_processor_benchmark
+
+LOCAL_STATIC_LIBRARIES := \
+	libutils \
+	libcutils \
+	liblog
+
+LOCAL_LDLIBS := -lpthread -lrt
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/../include \
+	$(call include-path-for, frameworks-openmax) \
+	$(TARGET_OUT_HEADERS)/khronos/openmax \
+	$(TARGET_OUT_HEADERS)/libva \
+	$(TARGET_OUT_HEADERS)/pvr/hal
+
+include $(BUILD_HOST_EXECUTABLE)
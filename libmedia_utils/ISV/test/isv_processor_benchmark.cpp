@@ -0,0 +1,408 @@
+/*
+ * Copyright (C) 2014 Intel Corporation.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Host benchmark of ISVProcessor on a mock ISVWorker.
+ *
+ * The mock VSP runs the tasks one at a time in submission order: process()
+ * spins for the submit time, then queues the task on the VSP, and fill()
+ * sleeps until the VSP has completed it. A feeder thread plays the decoder
+ * and the renderer, it gives each buffer the processor releases back at
+ * once. The frames/s are printed for each in flight depth, one task in
+ * flight being the former submit-then-fill schedule. The handle lookup of
+ * ISVBufferManager is timed against the former linear scan.
+ *
+ * usage: isv_processor_benchmark [frames] [submit us] [vsp us] [outputs per task]
+ *                                [forward references]
+ */
+
+#define LOG_TAG "isv-benchmark"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <utils/Log.h>
+#include <utils/List.h>
+#include "isv_processor.h"
+#include "isv_omxcomponent.h"
+
+using namespace android;
+
+#define NUM_INPUTS      6   // decoded buffers
+#define NUM_OUTPUTS     8   // VPP buffers, below MIN_OUTPUT_NUM
+#define NUM_LOOKUPS     1000000
+
+static uint32_t gSubmitUs = 2000;
+static uint32_t gVspUs = 6000;
+static uint32_t gOutputsPerTask = 1;
+static uint32_t gNumForwardReferences = 0;
+
+static nsecs_t now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * mock VSP, the end time of the tasks queued in order
+ */
+static Mutex gVspLock;
+static Vector<nsecs_t> gVspTasks;
+static nsecs_t gVspFreeAt;
+
+ISVWorker::ISVWorker()
+    :mNumForwardReferences(0) {}
+
+status_t ISVWorker::init(uint32_t width, uint32_t height)
+{
+    mNumForwardReferences = gNumForwardReferences;
+    return STATUS_OK;
+}
+
+status_t ISVWorker::deinit()
+{
+    return reset();
+}
+
+status_t ISVWorker::configFilters(uint32_t filters, const FilterParam* filterParam)
+{
+    return STATUS_OK;
+}
+
+uint32_t ISVWorker::getProcBufCount()
+{
+    return gOutputsPerTask;
+}
+
+uint32_t ISVWorker::getFillBufCount()
+{
+    return gOutputsPerTask;
+}
+
+status_t ISVWorker::process(ISVBuffer* input, Vector<ISVBuffer*> output,
+        uint32_t outputCount, bool isEOS, uint32_t flags)
+{
+    if (isEOS)
+        return STATUS_OK;
+
+    // driver work of vaBeginPicture() to vaEndPicture()
+    nsecs_t end = now() + gSubmitUs * 1000LL;
+    while (now() < end)
+        ;
+
+    Mutex::Autolock autoLock(gVspLock);
+    nsecs_t start = now();
+    if (start < gVspFreeAt)
+        start = gVspFreeAt;
+    gVspFreeAt = start + gVspUs * 1000LL;
+    gVspTasks.push_back(gVspFreeAt);
+    return STATUS_OK;
+}
+
+status_t ISVWorker::fill(Vector<ISVBuffer*> output, uint32_t outputCount)
+{
+    nsecs_t done;
+    {
+        Mutex::Autolock autoLock(gVspLock);
+        if (gVspTasks.isEmpty())
+            return STATUS_ERROR;
+        done = gVspTasks.itemAt(0);
+        gVspTasks.removeAt(0);
+    }
+
+    // vaSyncSurface()
+    struct timespec ts;
+    ts.tv_sec = done / 1000000000LL;
+    ts.tv_nsec = done % 1000000000LL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+        ;
+    return STATUS_OK;
+}
+
+status_t ISVWorker::reset()
+{
+    Mutex::Autolock autoLock(gVspLock);
+    gVspTasks.clear();
+    return STATUS_OK;
+}
+
+status_t ISVWorker::allocSurface(uint32_t* width, uint32_t* height,
+        uint32_t stride, uint32_t format, unsigned long handle, int32_t* surfaceId)
+{
+    return STATUS_OK;
+}
+
+status_t ISVWorker::freeSurface(int32_t* surfaceId)
+{
+    return STATUS_OK;
+}
+
+/*
+ * profile enabling the VPP filters only
+ */
+ISVProfile::ISVProfile(const uint32_t width, const uint32_t height) {}
+ISVProfile::~ISVProfile() {}
+FRC_RATE ISVProfile::getFRCRate(uint32_t inputFps) { return FRC_RATE_1X; }
+uint32_t ISVProfile::getFilterStatus() { return FilterNoiseReduction | FilterSharpening; }
+bool ISVProfile::isVPPOn() { return true; }
+bool ISVProfile::isFRCOn() { return false; }
+
+/*
+ * decoder and renderer, returns the released buffers to the processor
+ */
+class Feeder;
+
+class FeederThread : public Thread
+{
+public:
+    FeederThread(Feeder* feeder)
+        :Thread(false),
+        mFeeder(feeder) {}
+
+private:
+    virtual bool threadLoop();
+
+    Feeder* mFeeder;
+};
+
+class Feeder : public ISVProcessorObserver
+{
+public:
+    Feeder()
+        :mRendered(0),
+        mRunning(false) {}
+
+    void run()
+    {
+        mThread = new FeederThread(this);
+        mThread->run("Feeder");
+    }
+
+    void stop()
+    {
+        mThread->requestExitAndWait();
+        mThread = NULL;
+    }
+
+    virtual OMX_ERRORTYPE releaseBuffer(PORT_INDEX index, OMX_BUFFERHEADERTYPE* pBuffer, bool bFlush)
+    {
+        Mutex::Autolock autoLock(mLock);
+        if (!mRunning)
+            return OMX_ErrorNone;
+        if (index == kPortIndexOutput)
+            mRendered++;
+        mReleased.push_back(Release(index, pBuffer));
+        mCond.signal();
+        return OMX_ErrorNone;
+    }
+
+    void begin(sp<ISVProcessor> processor)
+    {
+        Mutex::Autolock autoLock(mLock);
+        mProcessor = processor;
+        mRendered = 0;
+        mRunning = true;
+    }
+
+    // returns once frames have been rendered
+    void waitRendered(uint32_t frames)
+    {
+        Mutex::Autolock autoLock(mLock);
+        while (mRendered < frames)
+            mDoneCond.wait(mLock);
+        mRunning = false;
+        mReleased.clear();
+        mProcessor = NULL;
+    }
+
+private:
+    friend class FeederThread;
+    typedef std::pair<PORT_INDEX, OMX_BUFFERHEADERTYPE*> Release;
+    typedef List<Release> ReleaseList;
+
+    bool feedLoop()
+    {
+        Release release;
+        sp<ISVProcessor> processor;
+        {
+            Mutex::Autolock autoLock(mLock);
+            mDoneCond.signal();
+            while (mReleased.empty() && !mThread->exitPending())
+                mCond.waitRelative(mLock, 10000000LL);
+            if (mReleased.empty())
+                return true;
+            release = *mReleased.begin();
+            mReleased.erase(mReleased.begin());
+            processor = mProcessor;
+        }
+
+        // a decoded buffer goes back through the decoder
+        if (release.first == kPortIndexInput) {
+            release.second->nTimeStamp += 16667;
+            processor->addInput(release.second);
+        } else
+            processor->addOutput(release.second);
+        return true;
+    }
+
+    sp<FeederThread> mThread;
+    Mutex mLock;
+    Condition mCond;
+    Condition mDoneCond;
+    ReleaseList mReleased;
+    sp<ISVProcessor> mProcessor;
+    uint32_t mRendered;
+    bool mRunning;
+};
+
+bool FeederThread::threadLoop()
+{
+    return mFeeder->feedLoop();
+}
+
+static OMX_BUFFERHEADERTYPE gHeaders[NUM_INPUTS + NUM_OUTPUTS];
+static unsigned long gHandles[NUM_INPUTS + NUM_OUTPUTS];
+
+static double runPipeline(sp<ISVBufferManager> bufferManager, sp<Feeder> feeder,
+        uint32_t maxTasks, uint32_t frames)
+{
+    sp<ISVProcessor> processor = new ISVProcessor(false, bufferManager, feeder, 1920, 1080);
+    processor->setMaxTasks(maxTasks);
+    processor->start();
+    feeder->begin(processor);
+
+    nsecs_t start = now();
+    for (uint32_t i = 0; i < NUM_OUTPUTS; i++)
+        processor->addOutput(&gHeaders[NUM_INPUTS + i]);
+    for (uint32_t i = 0; i < NUM_INPUTS; i++) {
+        gHeaders[i].nTimeStamp = i * 16667;
+        processor->addInput(&gHeaders[i]);
+    }
+    feeder->waitRendered(frames);
+    nsecs_t elapsed = now() - start;
+
+    // seek with tasks in flight, as the component does
+    processor->notifyFlush();
+    processor->waitFlushFinished();
+    processor->stop();
+    return frames * 1E9 / elapsed;
+}
+
+static void benchPipeline(uint32_t frames)
+{
+    sp<ISVBufferManager> bufferManager = new ISVBufferManager();
+    sp<Feeder> feeder = new Feeder();
+
+    bufferManager->setBufferCount(NUM_INPUTS + NUM_OUTPUTS);
+    for (uint32_t i = 0; i < NUM_INPUTS + NUM_OUTPUTS; i++) {
+        memset(&gHeaders[i], 0, sizeof(gHeaders[i]));
+        gHeaders[i].pBuffer = reinterpret_cast<OMX_U8*>(&gHandles[i]);
+        bufferManager->useBuffer(reinterpret_cast<unsigned long>(&gHandles[i]));
+    }
+    feeder->run();
+
+    printf("%u frames, submit %u us, VSP %u us, %u outputs per task, %u references:\n",
+            frames, gSubmitUs, gVspUs, gOutputsPerTask, gNumForwardReferences);
+    // the former schedule is one task in flight without forward references
+    for (uint32_t maxTasks = gNumForwardReferences + 1;
+            maxTasks <= gNumForwardReferences + 4; maxTasks++) {
+        double fps = runPipeline(bufferManager, feeder, maxTasks, frames);
+        printf("  %u tasks in flight %8.1f frames/s%s\n", maxTasks,
+                fps, maxTasks == 1 ? " (former schedule)" : "");
+    }
+
+    feeder->stop();
+    for (uint32_t i = 0; i < NUM_INPUTS + NUM_OUTPUTS; i++)
+        bufferManager->freeBuffer(reinterpret_cast<unsigned long>(&gHandles[i]));
+}
+
+static void benchLookup()
+{
+    // decoder buffers plus the VPP ones
+    const uint32_t numBuffers = MIN_ISV_BUFFER_NUM + 8;
+    sp<ISVBufferManager> bufferManager = new ISVBufferManager();
+    Vector<ISVBuffer*> buffers;
+    unsigned long *handles = new unsigned long[numBuffers];
+    volatile unsigned long sink = 0;
+    Mutex lock;
+
+    bufferManager->setBufferCount(numBuffers);
+    for (uint32_t i = 0; i < numBuffers; i++) {
+        unsigned long handle = reinterpret_cast<unsigned long>(&handles[i]);
+        bufferManager->useBuffer(handle);
+        buffers.push_back(bufferManager->mapBuffer(handle));
+    }
+
+    printf("handle lookups among %u buffers:\n", numBuffers);
+
+    // former linear scan, under the lock as well
+    nsecs_t start = now();
+    for (uint32_t i = 0; i < NUM_LOOKUPS; i++) {
+        unsigned long handle = reinterpret_cast<unsigned long>(&handles[(i * 7) % numBuffers]);
+        Mutex::Autolock autoLock(lock);
+        for (uint32_t j = 0; j < buffers.size(); j++) {
+            if (buffers.itemAt(j)->getHandle() == handle) {
+                sink += j;
+                break;
+            }
+        }
+    }
+    printf("  linear scan %8.1f ns/lookup\n", (double)(now() - start) / NUM_LOOKUPS);
+
+    start = now();
+    for (uint32_t i = 0; i < NUM_LOOKUPS; i++) {
+        unsigned long handle = reinterpret_cast<unsigned long>(&handles[(i * 7) % numBuffers]);
+        ISVBuffer* isvBuffer = bufferManager->mapBuffer(handle);
+        if (isvBuffer == NULL || isvBuffer->getHandle() != handle) {
+            printf("  mapBuffer failed for handle %lx\n", handle);
+            exit(EXIT_FAILURE);
+        }
+        sink += isvBuffer->getHandle();
+    }
+    printf("  hashed      %8.1f ns/lookup\n", (double)(now() - start) / NUM_LOOKUPS);
+
+    for (uint32_t i = 0; i < numBuffers; i++) {
+        if (bufferManager->freeBuffer(reinterpret_cast<unsigned long>(&handles[i])) != OK ||
+                bufferManager->mapBuffer(reinterpret_cast<unsigned long>(&handles[i])) != NULL) {
+            printf("  freeBuffer failed for handle %u\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    delete[] handles;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t frames = argc > 1 ? atoi(argv[1]) : 300;
+
+    if (argc > 2)
+        gSubmitUs = atoi(argv[2]);
+    if (argc > 3)
+        gVspUs = atoi(argv[3]);
+    if (argc > 4)
+        gOutputsPerTask = atoi(argv[4]);
+    if (argc > 5)
+        gNumForwardReferences = atoi(argv[5]);
+
+    benchPipeline(frames);
+    benchLookup();
+
+    return EXIT_SUCCESS;
+}
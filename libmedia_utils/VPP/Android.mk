@@ -52,6 +52,7 @@ LOCAL_COPY_HEADERS := \
     VPPBuffer.h \
     VPPProcThread.h \
     VPPProcessorBase.h \
+    VPPStageStats.h \
     NuPlayerVPPProcessor.h
 
 ifeq ($(TARGET_HAS_MULTIPLE_DISPLAY),true)
@@ -79,5 +80,7 @@ LOCAL_MODULE_TAGS := optional
 
 include $(BUILD_STATIC_LIBRARY)
 
+include $(LOCAL_PATH)/test/Android.mk
+
 endif
 
@@ -47,7 +47,8 @@ NuPlayerVPPProcessor::NuPlayerVPPProcessor(
       mACodec(NULL),
       mEOS(false),
       mLastInputTimeUs(-1),
-      mMds(NULL) {
+      mMds(NULL),
+      mOutputWaitStats("VPP output wait") {
 
 #ifdef TARGET_HAS_MULTIPLE_DISPLAY
     mMds = new VPPMDSListener(this);
@@ -74,6 +75,7 @@ NuPlayerVPPProcessor::~NuPlayerVPPProcessor() {
 #endif
     mNuPlayerVPPProcessor = NULL;
     ALOGI("===== VPPInputCount = %d  =====", mInputCount);
+    mOutputWaitStats.dump();
 }
 
 //static
@@ -100,11 +102,10 @@ NuPlayerVPPProcessor* NuPlayerVPPProcessor::getInstance(
 }
 
 void NuPlayerVPPProcessor::invokeThreads() {
-    if (!mThreadRunning)
-        return;
-
-    // invoke thread as many as possible
-    mProcThread->mRunCond.signal();
+    /*
+     * Nothing to do: VPPProcThread is woken up by setBufferToVPP and
+     * onFreeBuffer when an input or an output buffer becomes available.
+     */
 }
 
 status_t NuPlayerVPPProcessor::canSetBufferToVPP() {
@@ -148,11 +149,13 @@ status_t NuPlayerVPPProcessor::setBufferToVPP(const sp<ABuffer> &buffer, const s
     mInput[mInputLoadPoint].mTimeUs = timeBuf;
     notifyConsumed->setInt32("vppInput", true);
     mInput[mInputLoadPoint].mCodecMsg = notifyConsumed;
+    mInput[mInputLoadPoint].mStageTime = systemTime();
     mInput[mInputLoadPoint].mStatus = VPP_BUFFER_LOADED;
 
     mInputLoadPoint = (mInputLoadPoint + 1) % mInputBufferNum;
     mInputCount ++;
     mLastInputTimeUs = timeBuf;
+    mProcThread->notify(VPPProcThread::EVENT_INPUT_LOADED);
 
     return VPP_OK;
 }
@@ -186,6 +189,7 @@ void NuPlayerVPPProcessor::getBufferFromVPP() {
         ALOGV("vpp output buffer index = %d, buffer = %p, timeUs = %lld",
                 mOutputLoadPoint, mOutput[mOutputLoadPoint].mGraphicBuffer.get(), mOutput[mOutputLoadPoint].mTimeUs);
 
+        mOutputWaitStats.add(mOutput[mOutputLoadPoint].mStageTime);
         mOutput[mOutputLoadPoint].mStatus = VPP_BUFFER_RENDERING;
         mOutputLoadPoint = (mOutputLoadPoint + 1) % mOutputBufferNum;
     }
@@ -236,6 +240,7 @@ void NuPlayerVPPProcessor::onFreeBuffer(const sp<AMessage> &msg) {
             CHECK(info != NULL);
             mOutput[index].resetBuffer(info->mGraphicBuffer);
         }
+        mProcThread->notify(VPPProcThread::EVENT_OUTPUT_FREE);
     }
 
 }
@@ -453,10 +458,7 @@ void NuPlayerVPPProcessor::quitThread() {
     ALOGI("quitThread");
     if (mThreadRunning) {
         mProcThread->requestExit();
-        {
-            Mutex::Autolock autoLock(mProcThread->mLock);
-            mProcThread->mRunCond.signal();
-        }
+        mProcThread->notify(VPPProcThread::EVENT_CONTROL);
         mProcThread->requestExitAndWait();
         mProcThread.clear();
     }
@@ -479,7 +481,7 @@ void NuPlayerVPPProcessor::seek() {
             }
             mProcThread->mSeek = true;
             ALOGV("set proc seek ");
-            mProcThread->mRunCond.signal();
+            mProcThread->notify(VPPProcThread::EVENT_CONTROL);
             ALOGV("wake up proc thread");
         }
         Mutex::Autolock endLock(mProcThread->mEndLock);
@@ -544,7 +546,7 @@ void NuPlayerVPPProcessor::setEOS() {
     ALOGI("set eos");
     mEOS = true;
     if (mProcThread != NULL) {
-        mProcThread->mEOS = true;
+        mProcThread->notifyEOS();
     }
 
 }
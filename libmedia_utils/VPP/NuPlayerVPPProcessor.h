@@ -20,6 +20,7 @@
 #include "VPPBuffer.h"
 #include "VPPProcThread.h"
 #include "VPPSetting.h"
+#include "VPPStageStats.h"
 #include <media/stagefright/foundation/AHandler.h>
 #include <media/stagefright/NativeWindowWrapper.h>
 #include <media/stagefright/ACodec.h>
@@ -65,7 +66,8 @@ public:
     status_t validateVideoInfo(VPPVideoInfo *videoInfo);
 
     /*
-     * invoke VPPProcThread
+     * invoke VPPProcThread, no longer needed: the thread is woken up when
+     * a buffer is set to vpp or an output buffer is freed
      */
     void invokeThreads();
 
@@ -167,6 +169,8 @@ private:
 
     sp<ACodec> mACodec;
     sp<VPPMDSListener> mMds;
+    // READY to RENDERING
+    VPPStageStats mOutputWaitStats;
 
 private:
     NuPlayerVPPProcessor(const sp<AMessage> &notify,
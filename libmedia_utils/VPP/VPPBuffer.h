@@ -20,6 +20,7 @@
 
 #include <ui/GraphicBuffer.h>
 #include <stdint.h>
+#include <utils/Timers.h>
 #include <media/stagefright/foundation/AMessage.h>
 
 namespace android {
@@ -66,6 +67,7 @@ public:
     {
         mGraphicBuffer = buffer;
         mTimeUs = 0;
+        mStageTime = 0;
         mCodecMsg = NULL;
         mStatus = VPP_BUFFER_FREE;
     }
@@ -75,6 +77,7 @@ public:
     VPPBufferStatus mStatus;
     int64_t mTimeUs;
     uint32_t mFlags;
+    nsecs_t mStageTime;      // entry time in the current status, for stats
     sp<AMessage> mCodecMsg;  // only used by NuPlayerVPPProcessor
 
 private:
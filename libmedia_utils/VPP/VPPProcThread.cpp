@@ -20,6 +20,12 @@
 #include "VPPProcThread.h"
 #include <utils/Log.h>
 
+// max output buffers of one task, FRC 4x
+#define MAX_TASK_OUTPUT 4
+// VSP has no completion event, a task still rendering is queried again
+// after this delay unless an event comes first
+#define VSP_POLL_TIMEOUT_NS 1000000ll
+
 namespace android {
 
 VPPProcThread::VPPProcThread(bool canCallJava, VPPWorker* vppWorker,
@@ -41,10 +47,17 @@ VPPProcThread::VPPProcThread(bool canCallJava, VPPWorker* vppWorker,
     mOutputFillIdx(0),
     mbFlushPipelineInProcessing(false),
     mFrcChange(false),
-    mNeedCheckFrc(false) {
+    mNeedCheckFrc(false),
+    mPendingEvents(0),
+    mInputWaitStats("VPP input wait"),
+    mVspStats("VPP VSP") {
+    // the lists are sized once, a task uses their first entries
+    mProcBufList.insertAt(0, MAX_TASK_OUTPUT);
+    mFillBufList.insertAt(0, MAX_TASK_OUTPUT);
 }
 
 VPPProcThread::~VPPProcThread() {
+    dumpStats();
     ALOGV("VPPProcThread is deleted");
 }
 
@@ -55,7 +68,7 @@ status_t VPPProcThread::readyToRun() {
 }
 
 
-bool VPPProcThread::getBufForFirmwareOutput(Vector< sp<GraphicBuffer> > *fillBufList,uint32_t *fillBufNum){
+bool VPPProcThread::getBufForFirmwareOutput(uint32_t *fillBufNum){
     uint32_t i = 0;
     bool  bRet =true;
     // output buffer number for filling
@@ -65,13 +78,12 @@ bool VPPProcThread::getBufForFirmwareOutput(Vector< sp<GraphicBuffer> > *fillBuf
 
     //output data available
     needFillNum = mVPPWorker->getFillBufCount();
-    if ((needFillNum == 0) || (needFillNum > 4))
+    if ((needFillNum == 0) || (needFillNum > MAX_TASK_OUTPUT))
        return false;
 
     if (mOutput[mOutputFillIdx].mStatus == VPP_BUFFER_END_FLAG) {
        *fillBufNum = 1;
-       sp<GraphicBuffer> fillBuf = mOutput[mOutputFillIdx].mGraphicBuffer.get();
-       fillBufList->push_back(fillBuf);
+       mFillBufList.editItemAt(0) = mOutput[mOutputFillIdx].mGraphicBuffer;
        ALOGV("End flag %d", __LINE__);
        return true;
     }
@@ -79,8 +91,7 @@ bool VPPProcThread::getBufForFirmwareOutput(Vector< sp<GraphicBuffer> > *fillBuf
     for (i = 0; i < needFillNum; i++) {
         uint32_t fillPos = (mOutputFillIdx + i) % mOutputBufferNum;
         if (mOutput[fillPos].mStatus == VPP_BUFFER_PROCESSING) {
-            sp<GraphicBuffer> fillBuf = mOutput[fillPos].mGraphicBuffer.get();
-            fillBufList->push_back(fillBuf);
+            mFillBufList.editItemAt(i) = mOutput[fillPos].mGraphicBuffer;
         } else {
             ALOGV(" buffer status error %d line %d ...", mOutput[fillPos].mStatus, __LINE__);
             break;
@@ -97,10 +108,10 @@ bool VPPProcThread::getBufForFirmwareOutput(Vector< sp<GraphicBuffer> > *fillBuf
 }
 
 
-int VPPProcThread::updateFirmwareOutputBufStatus(Vector< sp<GraphicBuffer> > fillBufList,
-                                        uint32_t fillBufNum) {
+int VPPProcThread::updateFirmwareOutputBufStatus(uint32_t fillBufNum) {
     int64_t timeUs;
     bool bPipelineFlushCompleted = false;
+    nsecs_t now = systemTime();
 
     if (mFirstInputFrame) {
         mFirstInputFrame = false;
@@ -122,8 +133,10 @@ int VPPProcThread::updateFirmwareOutputBufStatus(Vector< sp<GraphicBuffer> > fil
        }
        ALOGV("End flag  finished %d", __LINE__);
     } else if (mOutput[mOutputFillIdx].mStatus == VPP_BUFFER_PROCESSING) {
+        mVspStats.add(mOutput[mOutputFillIdx].mStageTime);
         for(uint32_t i = 0; i < fillBufNum; i++) {
             uint32_t outputVppPos = (mOutputFillIdx + i) % mOutputBufferNum;
+            mOutput[outputVppPos].mStageTime = now;
             mOutput[outputVppPos].mStatus = VPP_BUFFER_READY;
             if (fillBufNum > 1) {
                 // frc is enabled, output fps is 60, change timeStamp
@@ -141,8 +154,7 @@ int VPPProcThread::updateFirmwareOutputBufStatus(Vector< sp<GraphicBuffer> > fil
 }
 
 
-bool VPPProcThread::getBufForFirmwareInput(Vector< sp<GraphicBuffer> > *procBufList,
-                                   sp<GraphicBuffer> *inputBuf,
+bool VPPProcThread::getBufForFirmwareInput(sp<GraphicBuffer> *inputBuf,
                                    bool bFlushPipeline,
                                    uint32_t *procBufNum) {
     uint32_t needProcNum = 0;
@@ -151,12 +163,12 @@ bool VPPProcThread::getBufForFirmwareInput(Vector< sp<GraphicBuffer> > *procBufL
 
     *procBufNum = 0;
     needProcNum = mVPPWorker->getProcBufCount();
-    if ((needProcNum == 0) || (needProcNum > 4)) {
+    if ((needProcNum == 0) || (needProcNum > MAX_TASK_OUTPUT)) {
        return false;
     }
 
     if (!bFlushPipeline) {
-        *inputBuf = mInput[mInputProcIdx].mGraphicBuffer.get();
+        *inputBuf = mInput[mInputProcIdx].mGraphicBuffer;
     } else {
         needProcNum = 1;
         *inputBuf = NULL;
@@ -169,8 +181,7 @@ bool VPPProcThread::getBufForFirmwareInput(Vector< sp<GraphicBuffer> > *procBufL
     do {
         procPos = (mOutputProcIdx + i) % mOutputBufferNum;
         if (mOutput[procPos].mStatus == VPP_BUFFER_FREE) {
-            sp<GraphicBuffer> procBuf = mOutput[procPos].mGraphicBuffer.get();
-            procBufList->push_back(procBuf);
+            mProcBufList.editItemAt(i) = mOutput[procPos].mGraphicBuffer;
             i++;
         } else {
             ALOGV("mOutputProcIdx %d i %d buf status %d", mOutputProcIdx,
@@ -190,16 +201,19 @@ bool VPPProcThread::getBufForFirmwareInput(Vector< sp<GraphicBuffer> > *procBufL
 }
 
 
-int VPPProcThread::updateFirmwareInputBufStatus(Vector< sp<GraphicBuffer> > procBufList,
-                                         uint32_t procBufNum, int64_t timeUs,
+int VPPProcThread::updateFirmwareInputBufStatus(uint32_t procBufNum, int64_t timeUs,
                                          bool bFlushPipeline) {
      if (!bFlushPipeline) {
+         nsecs_t now = systemTime();
+
+         mInputWaitStats.add(mInput[mInputProcIdx].mStageTime);
          mInput[mInputProcIdx].mStatus = VPP_BUFFER_PROCESSING;
          mInputProcIdx = (mInputProcIdx + 1) % mInputBufferNum;
 
          for(uint32_t i = 0; i < procBufNum; i++) {
              uint32_t procPos = (mOutputProcIdx + i) % mOutputBufferNum;
              mOutput[procPos].mStatus = VPP_BUFFER_PROCESSING;
+             mOutput[procPos].mStageTime = now;
              // set output buffer timestamp as the same as input
              mOutput[procPos].mTimeUs = timeUs;
          }
@@ -244,9 +258,6 @@ bool VPPProcThread::isOutputBufFree() {
 bool VPPProcThread::threadLoop() {
     uint32_t procBufNum = 0, fillBufNum = 0;
     sp<GraphicBuffer> inputBuf;
-    Vector< sp<GraphicBuffer> > procBufList;
-
-    Vector< sp<GraphicBuffer> > fillBufList;
     int64_t timeUs = 0ll;
     bool bInputReady = false;
     bool bOutputBufFree = true;
@@ -254,9 +265,17 @@ bool VPPProcThread::threadLoop() {
     bool bPendingOnFirmware = false;
     bool bFlushPipeline = false;
     bool bGetBufSuccess = true;
+    bool bProgress = false;
 
     Mutex::Autolock autoLock(mLock);
 
+    // the state is checked below, the events signalled from now on
+    // will prevent the wait
+    {
+        Mutex::Autolock eventLock(mEventLock);
+        mPendingEvents = 0;
+    }
+
     if (mNeedCheckFrc) {
         bool frcOn;
         FRC_RATE frcRate;
@@ -274,17 +293,18 @@ bool VPPProcThread::threadLoop() {
 
     ALOGV("mNumTaskInProcesing %d", mNumTaskInProcesing);
     while ((mNumTaskInProcesing > 0 && (!bPendingOnFirmware || mbFlushPipelineInProcessing)) && bGetBufSuccess ) {
-        fillBufList.clear();
-        bGetBufSuccess = getBufForFirmwareOutput(&fillBufList, &fillBufNum);
+        bGetBufSuccess = getBufForFirmwareOutput(&fillBufNum);
         ALOGV("bGetOutput %d, buf num %d", bGetBufSuccess, fillBufNum);
         if (bGetBufSuccess) {
-            status_t ret = mVPPWorker->fill(fillBufList, fillBufNum);
+            status_t ret = mVPPWorker->fill(mFillBufList, fillBufNum);
             if (ret == STATUS_OK) {
                 mNumTaskInProcesing--;
+                bProgress = true;
                 ALOGV("mNumTaskInProcesing: %d ...", mNumTaskInProcesing);
-                bool bPipelineFlusheCompleted = updateFirmwareOutputBufStatus(fillBufList, fillBufNum);
+                bool bPipelineFlusheCompleted = updateFirmwareOutputBufStatus(fillBufNum);
                 if (bPipelineFlusheCompleted) {
                     ALOGI("bPipelineFlusheCompleted");
+                    dumpStats();
                     mSeek = false;
                     mEOS = false;
                     if (mFrcChange &&
@@ -322,31 +342,25 @@ bool VPPProcThread::threadLoop() {
     bOutputBufFree = isOutputBufFree();
     bFlushPipeline = ((!bInputReady && (mEOS || mSeek)) || mFrcChange) && (!mbFlushPipelineInProcessing);
 
-    mWait = (!bInputReady || !bOutputBufFree) && (!mSeek && !mEOS && !mFrcChange);
-    if (mWait) {
-        ALOGV("wait for input/outpu ...");
-        mRunCond.wait(mLock);
-        ALOGV("wake up from mLock ...");
-    }
-
     ALOGV("before send: bInputReady %d flush: %d flushinProcess %d", bInputReady, bFlushPipeline, mbFlushPipelineInProcessing);
 
     if (((bInputReady && bOutputBufFree) || bFlushPipeline) && !mbFlushPipelineInProcessing ) {
-        bool bGetInBuf = getBufForFirmwareInput(&procBufList, &inputBuf, bFlushPipeline, &procBufNum);
+        bool bGetInBuf = getBufForFirmwareInput(&inputBuf, bFlushPipeline, &procBufNum);
         if (bGetInBuf) {
             if (!bFlushPipeline) {
                 flags = mInput[mInputProcIdx].mFlags;
                 // get input buffer timestamp
                 timeUs = mInput[mInputProcIdx].mTimeUs;
             }
-            status_t ret = mVPPWorker->process(inputBuf, procBufList, procBufNum, bFlushPipeline, flags);
+            status_t ret = mVPPWorker->process(inputBuf, mProcBufList, procBufNum, bFlushPipeline, flags);
             if (ret == STATUS_OK) {
                 mNumTaskInProcesing++;
+                bProgress = true;
                 if (bFlushPipeline) {
                     mbFlushPipelineInProcessing = true;
                     ALOGI("Vpp FlushPipeline set to driver");
                 }
-                updateFirmwareInputBufStatus(procBufList, procBufNum, timeUs, bFlushPipeline);
+                updateFirmwareInputBufStatus(procBufNum, timeUs, bFlushPipeline);
             } else {
                 ALOGE("process error %d ...", __LINE__);
             }
@@ -355,6 +369,30 @@ bool VPPProcThread::threadLoop() {
 
     ALOGV("Process End: bInputReady %d  tasks %d outbufFree %d", bInputReady, mNumTaskInProcesing, bOutputBufFree);
 
+    /*
+     * Nothing was submitted nor filled: sleep until an input is loaded,
+     * an output is returned or a control event comes. Only a task still
+     * rendering on VSP, which signals nothing, bounds the wait.
+     */
+    mWait = !bProgress && !exitPending();
+    if (mWait) {
+        bool bPendingOnVsp = mNumTaskInProcesing > 0;
+        ALOGV("wait for input/output ...");
+        mLock.unlock();
+        {
+            Mutex::Autolock eventLock(mEventLock);
+            if (mPendingEvents == 0 && !exitPending()) {
+                if (bPendingOnVsp)
+                    mEventCond.waitRelative(mEventLock, VSP_POLL_TIMEOUT_NS);
+                else
+                    mEventCond.wait(mEventLock);
+            }
+        }
+        mLock.lock();
+        mWait = false;
+        ALOGV("wake up from mLock ...");
+    }
+
    return true;
 }
 
@@ -364,7 +402,34 @@ bool VPPProcThread::isCurrentThread() const {
 }
 
 void VPPProcThread::notifyCheckFrc() {
-    mNeedCheckFrc = true;
+    {
+        Mutex::Autolock autoLock(mLock);
+        mNeedCheckFrc = true;
+    }
+    notify(EVENT_CONTROL);
+}
+
+void VPPProcThread::notify(uint32_t events) {
+    // never takes mLock: the processors notify from MediaBuffer release
+    // callbacks, some of them run with mLock held by seek()
+    Mutex::Autolock eventLock(mEventLock);
+    mPendingEvents |= events;
+    mEventCond.signal();
+}
+
+void VPPProcThread::notifyEOS() {
+    {
+        Mutex::Autolock autoLock(mLock);
+        mEOS = true;
+    }
+    notify(EVENT_CONTROL);
+}
+
+void VPPProcThread::dumpStats() {
+    mInputWaitStats.dump();
+    mVspStats.dump();
+    mInputWaitStats.reset();
+    mVspStats.reset();
 }
 
 } /* namespace android */
@@ -20,6 +20,7 @@
 
 #include <media/stagefright/MetaData.h>
 #include "VPPBuffer.h"
+#include "VPPStageStats.h"
 #ifdef USE_IVP
 #include "ivp/VPPWorker.h"
 #else
@@ -55,11 +56,22 @@ class VPPProcThread : public Thread {
         bool isReadytoRun();
         void notifyCheckFrc();
 
+        // events waking the thread up
+        enum {
+            EVENT_INPUT_LOADED  = 1 << 0,   // an input buffer became LOADED
+            EVENT_OUTPUT_FREE   = 1 << 1,   // an output buffer became FREE
+            EVENT_CONTROL       = 1 << 2,   // seek, EOS, FRC change or exit
+        };
+        // signal events to the thread, mLock may be held or not
+        void notify(uint32_t events);
+        // set EOS and wake the thread up to flush the pipeline
+        void notifyEOS();
+
     public:
         Mutex mLock;
         Mutex mEndLock;
-        // main thread send this condition to VPPProcThread,
-        // VPPProcThread wait this condition to run
+        // VPPProcThread sleeps on this condition while VSP flushes
+        // the pipeline
         Condition mRunCond;
         Condition mEndCond;
         bool mWait;
@@ -70,18 +82,15 @@ class VPPProcThread : public Thread {
     private:
         VPPProcThread(const VPPProcThread &);
         VPPProcThread &operator=(const VPPProcThread &);
-        bool getBufForFirmwareOutput(Vector< sp<GraphicBuffer> > *fillBufList,
-                             uint32_t *fillBufNum);
-        int updateFirmwareOutputBufStatus(Vector< sp<GraphicBuffer> > fillBufList,
-                                    uint32_t fillBufNum);
-        bool getBufForFirmwareInput(Vector< sp<GraphicBuffer> > *procBufList,
-                            sp<GraphicBuffer> *inputBuf,
+        bool getBufForFirmwareOutput(uint32_t *fillBufNum);
+        int updateFirmwareOutputBufStatus(uint32_t fillBufNum);
+        bool getBufForFirmwareInput(sp<GraphicBuffer> *inputBuf,
                             bool bFlushPipeline,
                             uint32_t *procBufNum );
-        int updateFirmwareInputBufStatus(Vector< sp<GraphicBuffer> > procBufList,
-                                   uint32_t procBufNum, int64_t timeUs,
+        int updateFirmwareInputBufStatus(uint32_t procBufNum, int64_t timeUs,
                                    bool bFlushPipeline);
         bool isOutputBufFree();
+        void dumpStats();
 
     private:
         android_thread_id_t mThreadId;
@@ -100,6 +109,18 @@ class VPPProcThread : public Thread {
         bool mbFlushPipelineInProcessing;
         bool mFrcChange;
         bool mNeedCheckFrc;
+        // events signalled since the last check, under mEventLock. The
+        // thread waits mEventCond, without mLock, when it has nothing to
+        // submit nor to fill
+        Mutex mEventLock;
+        Condition mEventCond;
+        uint32_t mPendingEvents;
+        // output buffers of the current task, set in place from the slots
+        Vector< sp<GraphicBuffer> > mProcBufList;
+        Vector< sp<GraphicBuffer> > mFillBufList;
+        // LOADED to PROCESSING, and PROCESSING to READY
+        VPPStageStats mInputWaitStats;
+        VPPStageStats mVspStats;
 };
 
 } /* END namespace android */
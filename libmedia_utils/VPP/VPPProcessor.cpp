@@ -41,7 +41,7 @@ VPPProcessor::VPPProcessor(const sp<ANativeWindow> &native, OMXCodec *codec)
          mBufferInfos(NULL),
          mThreadRunning(false), mEOS(false), mIsEosRead(false),
          mTotalDecodedCount(0), mInputCount(0), mVPPProcCount(0), mVPPRenderCount(0),
-         mMds(NULL) {
+         mMds(NULL), mOutputWaitStats("VPP output wait") {
     ALOGI("construction");
     memset(mInput, 0, VPPBuffer::MAX_VPP_BUFFER_NUMBER * sizeof(VPPBuffer));
     memset(mOutput, 0, VPPBuffer::MAX_VPP_BUFFER_NUMBER * sizeof(VPPBuffer));
@@ -54,7 +54,6 @@ VPPProcessor::VPPProcessor(const sp<ANativeWindow> &native, OMXCodec *codec)
 
 VPPProcessor::~VPPProcessor() {
     quitThread();
-    mThreadRunning = false;
 
     if (mWorker != NULL) {
         delete mWorker;
@@ -173,9 +172,6 @@ bool VPPProcessor::canSetDecoderBufferToVPP() {
     // put VPP output which still in output array to RenderList
     CHECK(updateRenderList() == VPP_OK);
 
-    // invoke VPPProcThread as many as possible
-    mProcThread->mRunCond.signal();
-
     // release obsolete input buffers
     clearInput();
 
@@ -203,9 +199,12 @@ status_t VPPProcessor::setDecoderBufferToVPP(MediaBuffer *buff) {
             mInput[mInputLoadPoint].mFlags = info->mFlags;
             mInput[mInputLoadPoint].mGraphicBuffer = buff->graphicBuffer();
             mInput[mInputLoadPoint].mTimeUs = getBufferTimestamp(buff);
+            mInput[mInputLoadPoint].mStageTime = systemTime();
             mInput[mInputLoadPoint].mStatus = VPP_BUFFER_LOADED;
             mInputLoadPoint = (mInputLoadPoint + 1) % mInputBufferNum;
             mInputCount ++;
+            if (mThreadRunning)
+                mProcThread->notify(VPPProcThread::EVENT_INPUT_LOADED);
             return VPP_OK;
         }
     }
@@ -251,7 +250,8 @@ void VPPProcessor::printRenderList() {
 status_t VPPProcessor::read(MediaBuffer **buffer) {
     printBuffers();
     printRenderList();
-    if (mProcThread->mError) {
+    // the thread is gone if an earlier reset failed
+    if (mProcThread == NULL || mProcThread->mError) {
         if (reset() != VPP_OK)
             return VPP_FAIL;
     }
@@ -265,6 +265,8 @@ status_t VPPProcessor::read(MediaBuffer **buffer) {
 
         ALOGD("======mTotalDecodedCount=%d, mInputCount=%d, mVPPProcCount=%d, mVPPRenderCount=%d======",
             mTotalDecodedCount, mInputCount, mVPPProcCount, mVPPRenderCount);
+        mOutputWaitStats.dump();
+        mOutputWaitStats.reset();
         mEOS = false;
         mIsEosRead = true;
         return ERROR_END_OF_STREAM;
@@ -301,7 +303,7 @@ void VPPProcessor::seek() {
              }
              mProcThread->mSeek = true;
              ALOGV("set proc seek ");
-             mProcThread->mRunCond.signal();
+             mProcThread->notify(VPPProcThread::EVENT_CONTROL);
              ALOGI("wake up proc thread");
         }
         ALOGI("try to get mEnd lock");
@@ -339,13 +341,12 @@ void VPPProcessor::quitThread() {
     ALOGI("quitThread");
     if(mThreadRunning) {
         mProcThread->requestExit();
-        {
-            Mutex::Autolock autoLock(mProcThread->mLock);
-            mProcThread->mRunCond.signal();
-        }
+        mProcThread->notify(VPPProcThread::EVENT_CONTROL);
         mProcThread->requestExitAndWait();
         mProcThread.clear();
     }
+    // buffers returned from now on go back to the native window
+    mThreadRunning = false;
     return;
 }
 
@@ -478,6 +479,7 @@ status_t VPPProcessor::updateRenderList() {
             return VPP_FAIL;
         //set timestamp from VPPBuffer to MediaBuffer
         buff->meta_data()->setInt64(kKeyTime, timeBuffer);
+        mOutputWaitStats.add(mOutput[mOutputLoadPoint].mStageTime);
 
         List<MediaBuffer*>::iterator it;
         int64_t timeRenderList = 0;
@@ -637,6 +639,7 @@ void VPPProcessor::signalBufferReturned(MediaBuffer *buff) {
             for (uint32_t i = 0; i < mOutputBufferNum; i++) {
                 if (buff->graphicBuffer() == mOutput[i].mGraphicBuffer) {
                     mOutput[i].resetBuffer(mediaBuffer->graphicBuffer());
+                    mProcThread->notify(VPPProcThread::EVENT_OUTPUT_FREE);
                     break;
                 }
             }
@@ -647,6 +650,7 @@ void VPPProcessor::signalBufferReturned(MediaBuffer *buff) {
             for (uint32_t i = 0; i < mOutputBufferNum; i++) {
                 if (buff->graphicBuffer() == mOutput[i].mGraphicBuffer) {
                     mOutput[i].resetBuffer(mOutput[i].mGraphicBuffer);
+                    mProcThread->notify(VPPProcThread::EVENT_OUTPUT_FREE);
                     break;
                 }
             }
@@ -708,7 +712,7 @@ void VPPProcessor::setEOS()
     mEOS = true;
 
     if ((mProcThread != NULL) && mThreadRunning) {
-        mProcThread->mEOS = true;
+        mProcThread->notifyEOS();
     } else {
         ALOGW("VPP processs thread is not running");
     }
@@ -21,6 +21,7 @@
 #include "VPPBuffer.h"
 #include "VPPProcThread.h"
 #include "VPPSetting.h"
+#include "VPPStageStats.h"
 #include "VPPMds.h"
 
 #ifdef USE_IVP
@@ -81,7 +82,8 @@ public:
     /*
      * Check whether there is empty input buffer to put decoder buffer in,
      * or RenderList is empty. Input buffer, output buffer and RenderList
-     * will also be updated in it.
+     * will also be updated in it. VPPThread needs no invoking here, it is
+     * woken up by setDecoderBufferToVPP and signalBufferReturned.
      * @return:
      *     true: need to set data into VPP
      *     false: NO need to set data into VPP
@@ -214,6 +216,8 @@ private:
     bool mIsEosRead;
     uint32_t mTotalDecodedCount, mInputCount, mVPPProcCount, mVPPRenderCount;
     sp<VPPMDSListener> mMds;
+    // READY to RenderList
+    VPPStageStats mOutputWaitStats;
 };
 
 } /* namespace android */
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2014 Intel Corporation.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef __VPP_STAGE_STATS_H
+#define __VPP_STAGE_STATS_H
+
+#include <stdint.h>
+#include <utils/Log.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+/*
+ * Latency of one stage of the VPP pipeline. The jitter is the mean
+ * difference between the latencies of two consecutive frames.
+ * Not thread safe, a stage is recorded and dumped by one thread.
+ */
+class VPPStageStats {
+public:
+    VPPStageStats(const char *name)
+        :mName(name) {
+        reset();
+    }
+
+    void reset() {
+        mCount = 0;
+        mTotal = 0;
+        mMin = 0;
+        mMax = 0;
+        mLast = 0;
+        mJitter = 0;
+    }
+
+    // add the latency of one frame, from the start time of the stage
+    void add(nsecs_t startTime) {
+        if (startTime <= 0)
+            return;
+        nsecs_t latency = systemTime() - startTime;
+        if (mCount == 0 || latency < mMin)
+            mMin = latency;
+        if (latency > mMax)
+            mMax = latency;
+        if (mCount > 0)
+            mJitter += (latency > mLast) ? latency - mLast : mLast - latency;
+        mLast = latency;
+        mTotal += latency;
+        mCount++;
+    }
+
+    uint32_t count() const { return mCount; }
+    nsecs_t average() const { return mCount ? mTotal / mCount : 0; }
+    nsecs_t jitter() const { return mCount > 1 ? mJitter / (mCount - 1) : 0; }
+
+    void dump() const {
+        if (mCount == 0)
+            return;
+        ALOGI("%s: %u frames, latency avg %lld min %lld max %lld us, jitter %lld us",
+                mName, mCount,
+                (long long)ns2us(average()), (long long)ns2us(mMin),
+                (long long)ns2us(mMax), (long long)ns2us(jitter()));
+    }
+
+private:
+    const char *mName;
+    uint32_t mCount;
+    nsecs_t mTotal;
+    nsecs_t mMin;
+    nsecs_t mMax;
+    nsecs_t mLast;
+    nsecs_t mJitter;
+};
+
+} /* namespace android */
+
+#endif /* __VPP_STAGE_STATS_H */
@@ -802,7 +802,7 @@ status_t VPPWorker::setupPipelineCaps() {
 }
 
 status_t VPPWorker::process(sp<GraphicBuffer> inputGraphicBuffer,
-                             Vector< sp<GraphicBuffer> > outputGraphicBuffer,
+                             const Vector< sp<GraphicBuffer> > &outputGraphicBuffer,
                              uint32_t outputCount, bool isEOS, uint32_t flags) {
     ALOGV("process: outputCount=%d, mInputIndex=%d", outputCount, mInputIndex);
     VASurfaceID input;
@@ -943,7 +943,7 @@ status_t VPPWorker::process(sp<GraphicBuffer> inputGraphicBuffer,
     return STATUS_OK;
 }
 
-status_t VPPWorker::fill(Vector< sp<GraphicBuffer> > outputGraphicBuffer, uint32_t outputCount) {
+status_t VPPWorker::fill(const Vector< sp<GraphicBuffer> > &outputGraphicBuffer, uint32_t outputCount) {
     ALOGV("fill, outputCount=%d, mOutputIndex=%d",outputCount, mOutputIndex);
     // get output surface
     VASurfaceID output[MAX_FRC_OUTPUT];
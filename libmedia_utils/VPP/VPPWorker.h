@@ -91,10 +91,10 @@ class VPPWorker {
         uint32_t getFillBufCount();
 
         // Send input and output buffers to VSP to begin processing
-        status_t process(sp<GraphicBuffer> input, Vector< sp<GraphicBuffer> > output, uint32_t outputCount, bool isEOS, uint32_t flags);
+        status_t process(sp<GraphicBuffer> input, const Vector< sp<GraphicBuffer> > &output, uint32_t outputCount, bool isEOS, uint32_t flags);
 
         // Fill output buffers given, it's a blocking call
-        status_t fill(Vector< sp<GraphicBuffer> > outputGraphicBuffer, uint32_t outputCount);
+        status_t fill(const Vector< sp<GraphicBuffer> > &outputGraphicBuffer, uint32_t outputCount);
 
         // Initialize graphic configuration buffer
         status_t setGraphicBufferConfig(sp<GraphicBuffer> graphicBuffer);
@@ -0,0 +1,28 @@
+LOCAL_PATH := $(call my-dir)
+
+# host test of the VPP thread scheduling on a stub VPPWorker
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+	VPPProcThreadTest.cpp \
+	../VPPProcThread.cpp
+
+LOCAL_MODULE_TAGS := tests
+LOCAL_MODULE := VPPProcThreadTest
+
+LOCAL_CFLAGS += -DTARGET_HAS_VPP -Wno-non-virtual-dtor
+
+LOCAL_STATIC_LIBRARIES := \
+	libutils \
+	libcutils \
+	liblog
+
+LOCAL_LDLIBS := -lpthread -lrt
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/.. \
+	$(call include-path-for, frameworks-av) \
+	$(call include-path-for, frameworks-native) \
+	$(TARGET_OUT_HEADERS)/libva
+
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,490 @@
+/*
+ * Copyright (C) 2014 Intel Corporation.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Host test of VPPProcThread on a stub VPPWorker.
+ *
+ * The stub VSP completes the tasks in submission order, each one gVspUs
+ * after the previous one, and fill() returns STATUS_DATA_RENDERING before.
+ * The Player below plays the NuPlayerVPPProcessor flows on the VPPBuffer
+ * arrays: setBufferToVPP, getBufferFromVPP, onFreeBuffer once the renderer
+ * has held an output for gRenderUs, seek and EOS. The test checks the
+ * frames come out once and in order, the pipeline is flushed at seek and
+ * EOS, and the thread sleeps when it has nothing to do.
+ *
+ * usage: VPPProcThreadTest
+ */
+
+#define LOG_TAG "VPPProcThreadTest"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <utils/List.h>
+#include <utils/Log.h>
+#include "VPPProcThread.h"
+
+using namespace android;
+
+#define NUM_FRAMES      60
+#define FRAME_US        33333ll
+
+static const nsecs_t gVspUs = 3000;
+static const nsecs_t gRenderUs = 8000;
+
+static int gFailures;
+
+#define EXPECT(exp) do { \
+        if (!(exp)) { \
+            fprintf(stderr, "%s:%d check failed: %s\n", __FILE__, __LINE__, \
+                    #exp); \
+            gFailures++; \
+        } \
+} while (0)
+
+/*
+ * stub VSP, the end time of the tasks queued in order
+ */
+static Mutex gVspLock;
+static List<nsecs_t> gVspTasks;
+static nsecs_t gVspFreeAt;
+static uint32_t gNumProcess;
+static uint32_t gNumFill;
+static uint32_t gNumRendering;
+
+static void vspCounters(uint32_t *process, uint32_t *fill, uint32_t *rendering)
+{
+    Mutex::Autolock autoLock(gVspLock);
+    *process = gNumProcess;
+    *fill = gNumFill;
+    *rendering = gNumRendering;
+}
+
+VPPWorker* VPPWorker::mVPPWorker = NULL;
+sp<ANativeWindow> VPPWorker::mNativeWindow = NULL;
+
+VPPWorker::VPPWorker(const sp<ANativeWindow> &nativeWindow)
+    :mNumForwardReferences(0),
+     mFrcRate(FRC_RATE_1X),
+     mFrcOn(false),
+     mUpdatedFrcRate(FRC_RATE_1X),
+     mUpdatedFrcOn(false),
+     bNeedCheckFrc(false),
+     mInputIndex(0),
+     mOutputIndex(0) {
+}
+
+VPPWorker::~VPPWorker()
+{
+    mVPPWorker = NULL;
+}
+
+VPPWorker* VPPWorker::getInstance(const sp<ANativeWindow> &nativeWindow)
+{
+    if (mVPPWorker == NULL)
+        mVPPWorker = new VPPWorker(nativeWindow);
+    return mVPPWorker;
+}
+
+uint32_t VPPWorker::getOutputBufCount(uint32_t index)
+{
+    uint32_t bufCount = 1;
+    if (mFrcOn && index > 0)
+            bufCount = mFrcRate - (((mFrcRate == FRC_RATE_2_5X) ? (index & 1): 0));
+    return bufCount;
+}
+
+uint32_t VPPWorker::getProcBufCount()
+{
+    return getOutputBufCount(mInputIndex);
+}
+
+uint32_t VPPWorker::getFillBufCount()
+{
+    return getOutputBufCount(mOutputIndex);
+}
+
+status_t VPPWorker::process(sp<GraphicBuffer> input,
+                            const Vector< sp<GraphicBuffer> > &output,
+                            uint32_t outputCount, bool isEOS, uint32_t flags)
+{
+    if (outputCount < 1 || (input == NULL && !isEOS))
+        return STATUS_ERROR;
+    for (uint32_t i = 0; i < outputCount; i++) {
+        if (output[i] == NULL)
+            return STATUS_ERROR;
+    }
+
+    Mutex::Autolock autoLock(gVspLock);
+    nsecs_t start = systemTime();
+    if (start < gVspFreeAt)
+        start = gVspFreeAt;
+    gVspFreeAt = start + us2ns(gVspUs);
+    gVspTasks.push_back(gVspFreeAt);
+    gNumProcess++;
+    mInputIndex++;
+    return STATUS_OK;
+}
+
+status_t VPPWorker::fill(const Vector< sp<GraphicBuffer> > &outputGraphicBuffer,
+                         uint32_t outputCount)
+{
+    Mutex::Autolock autoLock(gVspLock);
+    gNumFill++;
+    if (outputCount < 1 || gVspTasks.empty())
+        return STATUS_ERROR;
+    if (systemTime() < *gVspTasks.begin()) {
+        gNumRendering++;
+        return STATUS_DATA_RENDERING;
+    }
+    gVspTasks.erase(gVspTasks.begin());
+    mOutputIndex++;
+    return STATUS_OK;
+}
+
+status_t VPPWorker::reset()
+{
+    Mutex::Autolock autoLock(gVspLock);
+    mInputIndex = 0;
+    mOutputIndex = 0;
+    gVspTasks.clear();
+    return STATUS_OK;
+}
+
+status_t VPPWorker::calculateFrc(bool *frcOn, FRC_RATE *rate)
+{
+    *frcOn = mFrcOn;
+    *rate = mFrcRate;
+    return STATUS_OK;
+}
+
+/*
+ * NuPlayerVPPProcessor on the VPPBuffer arrays, the renderer returns the
+ * outputs with reuse set
+ */
+class Player {
+public:
+    Player(uint32_t numForwardReferences, FRC_RATE frcRate)
+        :mInputLoadPoint(0), mOutputLoadPoint(0),
+         mNumReturnedInputs(0),
+         mOutputWaitStats("VPP output wait") {
+        {
+            Mutex::Autolock autoLock(gVspLock);
+            gVspFreeAt = 0;
+            gNumProcess = 0;
+            gNumFill = 0;
+            gNumRendering = 0;
+        }
+        mWorker = VPPWorker::getInstance(NULL);
+        mWorker->mNumForwardReferences = numForwardReferences;
+        mWorker->mFrcOn = frcRate != FRC_RATE_1X;
+        mWorker->mFrcRate = frcRate;
+        mInputBufferNum = numForwardReferences + 3;
+        mOutputBufferNum = 1 + (numForwardReferences + 2) * frcRate;
+
+        for (uint32_t i = 0; i < mInputBufferNum; i++)
+            mInput[i].resetBuffer(NULL);
+        for (uint32_t i = 0; i < mOutputBufferNum; i++)
+            mOutput[i].resetBuffer(new GraphicBuffer());
+
+        mProcThread = new VPPProcThread(false, mWorker,
+                mInput, mInputBufferNum,
+                mOutput, mOutputBufferNum);
+        mProcThread->run("VPPProcThread", ANDROID_PRIORITY_NORMAL);
+    }
+
+    ~Player() {
+        mProcThread->requestExit();
+        mProcThread->notify(VPPProcThread::EVENT_CONTROL);
+        mProcThread->requestExitAndWait();
+        mProcThread.clear();
+        for (uint32_t i = 0; i < mInputBufferNum; i++)
+            mInput[i].resetBuffer(NULL);
+        for (uint32_t i = 0; i < mOutputBufferNum; i++)
+            mOutput[i].resetBuffer(NULL);
+        delete mWorker;
+    }
+
+    // canSetBufferToVPP and setBufferToVPP
+    bool setBufferToVPP(int64_t timeUs) {
+        if (mInput[mInputLoadPoint].mStatus != VPP_BUFFER_FREE)
+            return false;
+        mInput[mInputLoadPoint].mFlags = 0;
+        mInput[mInputLoadPoint].mGraphicBuffer = new GraphicBuffer();
+        mInput[mInputLoadPoint].mTimeUs = timeUs;
+        mInput[mInputLoadPoint].mStageTime = systemTime();
+        mInput[mInputLoadPoint].mStatus = VPP_BUFFER_LOADED;
+        mInputLoadPoint = (mInputLoadPoint + 1) % mInputBufferNum;
+        mProcThread->notify(VPPProcThread::EVENT_INPUT_LOADED);
+        return true;
+    }
+
+    // READY outputs to the renderer, READY inputs back to the decoder
+    void getBufferFromVPP() {
+        while (mOutput[mOutputLoadPoint].mStatus == VPP_BUFFER_READY) {
+            mRendered.push_back(mOutput[mOutputLoadPoint].mTimeUs);
+            mOutputWaitStats.add(mOutput[mOutputLoadPoint].mStageTime);
+            mOutput[mOutputLoadPoint].mStatus = VPP_BUFFER_RENDERING;
+            mRenderQueue.push_back(RenderEntry(mOutputLoadPoint,
+                    systemTime() + us2ns(gRenderUs)));
+            mOutputLoadPoint = (mOutputLoadPoint + 1) % mOutputBufferNum;
+        }
+
+        for (uint32_t i = 0; i < mInputBufferNum; i++) {
+            if (mInput[i].mStatus == VPP_BUFFER_READY)
+                postAndResetInput(i);
+        }
+    }
+
+    // onFreeBuffer of the outputs the renderer is done with
+    void render() {
+        nsecs_t now = systemTime();
+        while (!mRenderQueue.empty() && mRenderQueue.begin()->releaseTime <= now) {
+            uint32_t index = mRenderQueue.begin()->index;
+            mRenderQueue.erase(mRenderQueue.begin());
+            mOutput[index].resetBuffer(mOutput[index].mGraphicBuffer);
+            mProcThread->notify(VPPProcThread::EVENT_OUTPUT_FREE);
+        }
+    }
+
+    void step() {
+        getBufferFromVPP();
+        render();
+        usleep(200);
+    }
+
+    void setEOS() {
+        mProcThread->notifyEOS();
+    }
+
+    bool isFlushing() {
+        Mutex::Autolock autoLock(mProcThread->mLock);
+        return mProcThread->mEOS || mProcThread->mSeek;
+    }
+
+    bool isWaiting() {
+        Mutex::Autolock autoLock(mProcThread->mLock);
+        return mProcThread->mWait;
+    }
+
+    // the renderer is flushed first, then VPP as NuPlayerVPPProcessor::seek
+    void seek() {
+        mRenderQueue.clear();
+        {
+            Mutex::Autolock procLock(mProcThread->mLock);
+            if (!hasProcessingBuffer())
+                return;
+            mProcThread->mSeek = true;
+            mProcThread->notify(VPPProcThread::EVENT_CONTROL);
+        }
+        Mutex::Autolock endLock(mProcThread->mEndLock);
+        EXPECT(mProcThread->mEndCond.waitRelative(mProcThread->mEndLock,
+                seconds(1)) == OK);
+        flushNoShutdown();
+    }
+
+    bool hasProcessingBuffer() {
+        bool hasProcBuffer = false;
+        for (uint32_t i = 0; i < mInputBufferNum; i++) {
+            if (mInput[i].mStatus == VPP_BUFFER_PROCESSING)
+                hasProcBuffer = true;
+            if (mInput[i].mStatus != VPP_BUFFER_PROCESSING && mInput[i].mStatus != VPP_BUFFER_FREE)
+                postAndResetInput(i);
+        }
+        for (uint32_t i = 0; i < mOutputBufferNum; i++) {
+            if ((mOutput[i].mStatus != VPP_BUFFER_PROCESSING) && (mOutput[i].mStatus != VPP_BUFFER_FREE)
+                    && (mOutput[i].mStatus != VPP_BUFFER_END_FLAG)) {
+                mOutput[i].resetBuffer(mOutput[i].mGraphicBuffer);
+                // VPPProcessor notifies from the release callback, with mLock held
+                mProcThread->notify(VPPProcThread::EVENT_OUTPUT_FREE);
+            }
+        }
+        mInputLoadPoint = 0;
+        mOutputLoadPoint = 0;
+        return hasProcBuffer;
+    }
+
+    void flushNoShutdown() {
+        for (uint32_t i = 0; i < mInputBufferNum; i++) {
+            EXPECT(mInput[i].mStatus != VPP_BUFFER_PROCESSING);
+            if (mInput[i].mStatus != VPP_BUFFER_FREE)
+                postAndResetInput(i);
+        }
+        for (uint32_t i = 0; i < mOutputBufferNum; i++) {
+            EXPECT(mOutput[i].mStatus != VPP_BUFFER_PROCESSING);
+            if (mOutput[i].mStatus != VPP_BUFFER_FREE)
+                mOutput[i].resetBuffer(mOutput[i].mGraphicBuffer);
+        }
+    }
+
+    // feed the frames as fast as VPP takes them, then set EOS and drain
+    void play(uint32_t frames, int64_t firstTimeUs, bool eos) {
+        int64_t timeUs = firstTimeUs;
+        for (uint32_t fed = 0; fed < frames; step()) {
+            if (setBufferToVPP(timeUs)) {
+                timeUs += FRAME_US;
+                fed++;
+            }
+        }
+        if (!eos)
+            return;
+        setEOS();
+        nsecs_t timeout = systemTime() + seconds(2);
+        while (isFlushing() && systemTime() < timeout)
+            step();
+        EXPECT(!isFlushing());
+        // outputs filled by the last tasks
+        for (int i = 0; i < 20; i++)
+            step();
+    }
+
+    bool allFree() {
+        for (uint32_t i = 0; i < mInputBufferNum; i++) {
+            if (mInput[i].mStatus != VPP_BUFFER_FREE)
+                return false;
+        }
+        for (uint32_t i = 0; i < mOutputBufferNum; i++) {
+            if (mOutput[i].mStatus != VPP_BUFFER_FREE
+                    && mOutput[i].mStatus != VPP_BUFFER_RENDERING)
+                return false;
+        }
+        return true;
+    }
+
+private:
+    void postAndResetInput(uint32_t index) {
+        if (mInput[index].mGraphicBuffer != NULL)
+            mNumReturnedInputs++;
+        mInput[index].resetBuffer(NULL);
+    }
+
+    struct RenderEntry {
+        RenderEntry() : index(0), releaseTime(0) {}
+        RenderEntry(uint32_t i, nsecs_t t) : index(i), releaseTime(t) {}
+        uint32_t index;
+        nsecs_t releaseTime;
+    };
+
+public:
+    VPPBuffer mInput[VPPBuffer::MAX_VPP_BUFFER_NUMBER];
+    VPPBuffer mOutput[VPPBuffer::MAX_VPP_BUFFER_NUMBER];
+    uint32_t mInputBufferNum;
+    uint32_t mOutputBufferNum;
+    uint32_t mInputLoadPoint;
+    uint32_t mOutputLoadPoint;
+    uint32_t mNumReturnedInputs;
+    Vector<int64_t> mRendered;
+    VPPStageStats mOutputWaitStats;
+    VPPWorker *mWorker;
+    sp<VPPProcThread> mProcThread;
+
+private:
+    List<RenderEntry> mRenderQueue;
+};
+
+static bool isIncreasing(const Vector<int64_t> &times, size_t from)
+{
+    for (size_t i = from + 1; i < times.size(); i++) {
+        if (times[i] <= times[i - 1])
+            return false;
+    }
+    return true;
+}
+
+static void test_playback(uint32_t numForwardReferences, FRC_RATE frcRate)
+{
+    Player player(numForwardReferences, frcRate);
+    uint32_t process, fill, rendering;
+    nsecs_t start = systemTime();
+
+    player.play(NUM_FRAMES, 0, true);
+    nsecs_t elapsed = systemTime() - start;
+
+    // the first input gives one output, the others frcRate
+    uint32_t expected = 1 + (NUM_FRAMES - 1) * frcRate;
+    EXPECT(player.mRendered.size() == expected);
+    EXPECT(isIncreasing(player.mRendered, 0));
+    if (frcRate == FRC_RATE_1X) {
+        for (size_t i = 0; i < player.mRendered.size(); i++)
+            EXPECT(player.mRendered[i] == (int64_t)i * FRAME_US);
+    }
+    EXPECT(player.mNumReturnedInputs == NUM_FRAMES);
+    EXPECT(player.allFree());
+    EXPECT(player.mOutputWaitStats.count() == expected);
+
+    // idle: no task in VSP, the thread waits for an event
+    vspCounters(&process, &fill, &rendering);
+    usleep(50000);
+    uint32_t process2, fill2, rendering2;
+    vspCounters(&process2, &fill2, &rendering2);
+    EXPECT(process2 == process && fill2 == fill);
+    EXPECT(player.isWaiting());
+
+    // the tasks rendering on VSP are queried about once per millisecond
+    EXPECT(rendering <= ns2us(elapsed) / 1000 * 2 + NUM_FRAMES * 4);
+
+    printf("refs %u frc %d: %u frames in %lld ms, %u process, %u fill, "
+           "%u fill while rendering\n", numForwardReferences, frcRate,
+           (uint32_t)player.mRendered.size(), (long long)ns2ms(elapsed),
+           process, fill, rendering);
+    player.mOutputWaitStats.dump();
+}
+
+static void test_seek()
+{
+    Player player(1, FRC_RATE_1X);
+
+    player.play(NUM_FRAMES / 2, 0, false);
+    size_t before = player.mRendered.size();
+    player.seek();
+    EXPECT(!player.isFlushing());
+    EXPECT(player.allFree());
+
+    // the frames after seek all come out, none from before
+    const int64_t seekTimeUs = 10000000ll;
+    player.play(NUM_FRAMES, seekTimeUs, true);
+    size_t count = 0;
+    for (size_t i = before; i < player.mRendered.size(); i++) {
+        if (player.mRendered[i] >= seekTimeUs)
+            count++;
+    }
+    EXPECT(count == NUM_FRAMES);
+    EXPECT(player.mRendered[player.mRendered.size() - 1] ==
+            seekTimeUs + (NUM_FRAMES - 1) * FRAME_US);
+    EXPECT(isIncreasing(player.mRendered, player.mRendered.size() - count));
+    EXPECT(player.allFree());
+
+    // seek while nothing is processing returns at once
+    player.seek();
+    EXPECT(!player.isFlushing());
+}
+
+int main()
+{
+    test_playback(0, FRC_RATE_1X);
+    test_playback(2, FRC_RATE_1X);
+    test_playback(1, FRC_RATE_2X);
+    test_seek();
+
+    if (gFailures) {
+        fprintf(stderr, "%d checks failed\n", gFailures);
+        return EXIT_FAILURE;
+    }
+
+    printf("all checks passed\n");
+    return EXIT_SUCCESS;
+}
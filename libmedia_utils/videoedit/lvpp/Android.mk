@@ -25,7 +25,8 @@ LOCAL_COPY_HEADERS_TO := videoeditornv12
 LOCAL_COPY_HEADERS := VideoEditorToolsNV12.h
 
 LOCAL_SRC_FILES:=          \
-    VideoEditorToolsNV12.c
+    VideoEditorToolsNV12.c \
+    VideoEditorToolsNV12Kernels.c
 
 LOCAL_MODULE_TAGS := optional
 
@@ -53,3 +54,4 @@ LOCAL_LDLIBS := \
 
 include $(BUILD_STATIC_LIBRARY)
 
+include $(LOCAL_PATH)/test/Android.mk
@@ -19,6 +19,7 @@
 #include <utils/Log.h>
 
 #include "VideoEditorToolsNV12.h"
+#include "VideoEditorToolsNV12Kernels.h"
 #define M4VIFI_ALLOC_FAILURE 10
 
 static M4VIFI_UInt8 M4VIFI_SemiplanarYUV420toYUV420_X86(void *user_data,
@@ -29,6 +30,7 @@ static M4VIFI_UInt8 M4VIFI_SemiplanarYUV420toYUV420_X86(void *user_data,
      M4VIFI_UInt8 *p_buf_src, *p_buf_dest, *p_buf_src_u, *p_buf_src_v;
      M4VIFI_UInt8 *p_buf_dest_u,*p_buf_dest_v,*p_buf_src_uv;
      M4VIFI_UInt8     return_code = M4VIFI_OK;
+     const M4VIFI_NV12Kernels *k = M4VIFI_NV12GetKernels();
 
      /* the filter is implemented with the assumption that the width is equal to stride */
      if(PlaneIn[0].u_width != PlaneIn[0].u_stride)
@@ -45,6 +47,13 @@ static M4VIFI_UInt8 M4VIFI_SemiplanarYUV420toYUV420_X86(void *user_data,
      p_buf_dest_u  = &(PlaneOut[1].pac_data[PlaneOut[1].u_topleft]);
      p_buf_dest_v  = &(PlaneOut[2].pac_data[PlaneOut[2].u_topleft]);
 
+     if (k != NULL)
+     {
+        k->deinterleave(p_buf_src_uv, p_buf_dest_u, p_buf_dest_v,
+            PlaneOut[1].u_width*PlaneOut[1].u_height);
+        return return_code;
+     }
+
      for(i = 0; i < PlaneOut[1].u_width*PlaneOut[1].u_height; i++)
      {
         *p_buf_dest_u++ = *p_buf_src_uv++;
@@ -101,6 +110,10 @@ static M4VIFI_UInt8 M4VIFI_ResizeBilinearYUV420toYUV420_X86(void *pUserData,
     M4VIFI_UInt8    u8Hflag = 0;
     M4VIFI_UInt32   loop = 0;
 
+    const M4VIFI_NV12Kernels *k = M4VIFI_NV12GetKernels();
+    M4VIFI_NV12Resampler resampler;
+    M4OSA_Bool      bKernels;
+
     /*
      If input width is equal to output width and input height equal to
      output height then M4VIFI_YUV420toYUV420 is called.
@@ -230,6 +243,10 @@ static M4VIFI_UInt8 M4VIFI_ResizeBilinearYUV420toYUV420_X86(void *pUserData,
 
         u32_height = u32_height_out;
 
+        /* The kernels resample whole rows, the loop below is the fallback */
+        bKernels = (k != NULL) && (M4VIFI_NV12ResamplerInit(&resampler, k,
+            u32_width_out, u32_x_accum_start, u32_x_inc, 0) == 0);
+
         /*
         Bilinear interpolation linearly interpolates along each row, and
         then uses that result in a linear interpolation donw each column.
@@ -246,27 +263,34 @@ static M4VIFI_UInt8 M4VIFI_ResizeBilinearYUV420toYUV420_X86(void *pUserData,
             /* Vertical weight factor */
             u32_y_frac = (u32_y_accum>>12)&15;
 
-            /* Reinit accumulator */
-            u32_x_accum = u32_x_accum_start;
+            if (bKernels) {
+                M4VIFI_NV12ResamplerRow(&resampler, pu8_data_in, u32_stride_in,
+                    u32_y_frac, pu8_data_out);
+                pu8_data_out += u32_width_out;
+                u32_temp_value = pu8_data_out[-1];
+            } else {
+                /* Reinit accumulator */
+                u32_x_accum = u32_x_accum_start;
 
-            u32_width = u32_width_out;
+                u32_width = u32_width_out;
 
-            do { /* Scan along each row */
-                pu8_src_top = pu8_data_in + (u32_x_accum >> 16);
-                pu8_src_bottom = pu8_src_top + u32_stride_in;
-                u32_x_frac = (u32_x_accum >> 12)&15; /* Horizontal weight factor */
+                do { /* Scan along each row */
+                    pu8_src_top = pu8_data_in + (u32_x_accum >> 16);
+                    pu8_src_bottom = pu8_src_top + u32_stride_in;
+                    u32_x_frac = (u32_x_accum >> 12)&15; /* Horizontal weight factor */
 
-                /* Weighted combination */
-                u32_temp_value = (M4VIFI_UInt8)(((pu8_src_top[0]*(16-u32_x_frac) +
-                                                 pu8_src_top[1]*u32_x_frac)*(16-u32_y_frac) +
-                                                (pu8_src_bottom[0]*(16-u32_x_frac) +
-                                                 pu8_src_bottom[1]*u32_x_frac)*u32_y_frac )>>8);
+                    /* Weighted combination */
+                    u32_temp_value = (M4VIFI_UInt8)(((pu8_src_top[0]*(16-u32_x_frac) +
+                                                     pu8_src_top[1]*u32_x_frac)*(16-u32_y_frac) +
+                                                    (pu8_src_bottom[0]*(16-u32_x_frac) +
+                                                     pu8_src_bottom[1]*u32_x_frac)*u32_y_frac )>>8);
 
-                *pu8_data_out++ = (M4VIFI_UInt8)u32_temp_value;
+                    *pu8_data_out++ = (M4VIFI_UInt8)u32_temp_value;
 
-                /* Update horizontal accumulator */
-                u32_x_accum += u32_x_inc;
-            } while(--u32_width);
+                    /* Update horizontal accumulator */
+                    u32_x_accum += u32_x_inc;
+                } while(--u32_width);
+            }
 
             /*
                This u8Wflag flag gets in to effect if input and output
@@ -298,6 +322,10 @@ static M4VIFI_UInt8 M4VIFI_ResizeBilinearYUV420toYUV420_X86(void *pUserData,
                 *pu8_data_out++ = (M4VIFI_UInt8)*pu8dum++;
             }
         }
+
+        if (bKernels) {
+            M4VIFI_NV12ResamplerDeinit(&resampler);
+        }
     }
 
     return M4VIFI_OK;
@@ -355,6 +383,11 @@ static M4VIFI_UInt8 M4VIFI_ResizeBilinearYUV420toBGR565_X86(void* pContext,
     M4VIFI_UInt8    *pu8_src_top_Y,*pu8_src_top_U,*pu8_src_top_V ;
     M4VIFI_UInt8    *pu8_src_bottom_Y, *pu8_src_bottom_U, *pu8_src_bottom_V;
 
+    const M4VIFI_NV12Kernels *k = M4VIFI_NV12GetKernels();
+    M4VIFI_NV12Resampler resamplerY, resamplerUV;
+    M4OSA_Bool      bKernels;
+    M4VIFI_UInt8    *pu8_samples, *pu8_Y0, *pu8_Y1, *pu8_U, *pu8_V;
+
     /* Check for the YUV width and height are even */
     u32_check_size = IS_EVEN(pPlaneIn[0].u_height);
     if( u32_check_size == FALSE )
@@ -491,6 +524,45 @@ static M4VIFI_UInt8 M4VIFI_ResizeBilinearYUV420toBGR565_X86(void* pContext,
 
     pu32_rgb_data_start = (M4VIFI_UInt32*)pu8_data_out;
 
+    /*
+        The kernels resample the rows of each row pair in one go, then the
+        colour conversion is done per pixel as in the loop below
+    */
+    bKernels = M4OSA_FALSE;
+    pu8_samples = M4OSA_NULL;
+    if (k != M4OSA_NULL)
+    {
+        pu8_samples = (M4VIFI_UInt8 *)M4OSA_32bitAlignedMalloc(3 * u32_width_out, 12420,
+            (M4OSA_Char*)("M4VIFI_ResizeBilinearYUV420toBGR565: samples"));
+        if ((pu8_samples != M4OSA_NULL) &&
+            (M4VIFI_NV12ResamplerInit(&resamplerY, k, u32_width_out,
+                u32_x_accum_start, u32_x_inc[YPlane], 0) == 0))
+        {
+            bKernels = (M4VIFI_NV12ResamplerInit(&resamplerUV, k, u32_width2_RGB,
+                u32_x_accum_start, u32_x_inc[UPlane], 0) == 0);
+            if (!bKernels)
+            {
+                M4VIFI_NV12ResamplerDeinit(&resamplerY);
+            }
+        }
+        if (!bKernels)
+        {
+            free(pu8_samples);
+            pu8_samples = M4OSA_NULL;
+        }
+    }
+    if (bKernels)
+    {
+        pu8_Y0 = pu8_samples;
+        pu8_Y1 = pu8_Y0 + u32_width_out;
+        pu8_U = pu8_Y1 + u32_width_out;
+        pu8_V = pu8_U + u32_width2_RGB;
+    }
+    else
+    {
+        pu8_Y0 = pu8_Y1 = pu8_U = pu8_V = M4OSA_NULL;
+    }
+
     /*
         Bilinear interpolation linearly interpolates along each row, and then uses that
         result in a linear interpolation donw each column. Each estimated pixel in the
@@ -526,142 +598,234 @@ static M4VIFI_UInt8 M4VIFI_ResizeBilinearYUV420toBGR565_X86(void* pContext,
         }
         u32_rgb_temp4 = (u32_rgb_temp3 >> 12) & 15;
 
-        for (u32_col = u32_width_out; u32_col != 0; u32_col -= 2)
+        if (bKernels)
+        {
+            M4VIFI_NV12ResamplerRow(&resamplerY, pu8_data_in[YPlane],
+                u32_stride_in[YPlane], u32_y_frac_Y, pu8_Y0);
+            M4VIFI_NV12ResamplerRow(&resamplerY, pu8_data_in1[YPlane],
+                u32_stride_in[YPlane], u32_rgb_temp4, pu8_Y1);
+            M4VIFI_NV12ResamplerRow(&resamplerUV, pu8_data_in[UPlane],
+                u32_stride_in[UPlane], u32_y_frac_U, pu8_U);
+            M4VIFI_NV12ResamplerRow(&resamplerUV, pu8_data_in[VPlane],
+                u32_stride_in[VPlane], u32_y_frac_U, pu8_V);
+
+            for (u32_col = 0; u32_col < u32_width_out; u32_col += 2)
+            {
+                U_32 = pu8_U[u32_col >> 1];
+                V_32 = pu8_V[u32_col >> 1];
+
+                /* YUV to RGB */
+                Y_32 = pu8_Y0[u32_col];
+                #ifdef __RGB_V1__
+                        Yval_32 = Y_32*37;
+                #else   /* __RGB_V1__v */
+                        Yval_32 = Y_32*0x2568;
+                #endif /* __RGB_V1__v */
+
+                DEMATRIX(u8_Red,u8_Green,u8_Blue,Yval_32,U_32,V_32);
+
+                /* Pack 8 bit R,G,B to RGB565 */
+                #ifdef  LITTLE_ENDIAN
+                        u32_rgb_temp1 = PACK_BGR565(0,u8_Red,u8_Green,u8_Blue);
+                #else   /* LITTLE_ENDIAN */
+                        u32_rgb_temp1 = PACK_BGR565(16,u8_Red,u8_Green,u8_Blue);
+                #endif  /* LITTLE_ENDIAN */
+
+                /* YUV to RGB */
+                Y_32 = pu8_Y1[u32_col];
+                #ifdef __RGB_V1__
+                        Yval_32 = Y_32*37;
+                #else   /* __RGB_V1__v */
+                        Yval_32 = Y_32*0x2568;
+                #endif  /* __RGB_V1__v */
+
+                DEMATRIX(u8_Red,u8_Green,u8_Blue,Yval_32,U_32,V_32);
+
+                /* Pack 8 bit R,G,B to RGB565 */
+                #ifdef  LITTLE_ENDIAN
+                        u32_rgb_temp2 = PACK_BGR565(0,u8_Red,u8_Green,u8_Blue);
+                #else   /* LITTLE_ENDIAN */
+                        u32_rgb_temp2 = PACK_BGR565(16,u8_Red,u8_Green,u8_Blue);
+                #endif  /* LITTLE_ENDIAN */
+
+                /* YUV to RGB */
+                Y_32 = pu8_Y0[u32_col + 1];
+                #ifdef __RGB_V1__
+                        Yval_32 = Y_32*37;
+                #else   /* __RGB_V1__v */
+                        Yval_32 = Y_32*0x2568;
+                #endif  /* __RGB_V1__v */
+
+                DEMATRIX(u8_Red,u8_Green,u8_Blue,Yval_32,U_32,V_32);
+
+                /* Pack 8 bit R,G,B to RGB565 */
+                #ifdef  LITTLE_ENDIAN
+                        *(pu32_rgb_data_current)++ = u32_rgb_temp1 |
+                                                         PACK_BGR565(16,u8_Red,u8_Green,u8_Blue);
+                #else   /* LITTLE_ENDIAN */
+                        *(pu32_rgb_data_current)++ = u32_rgb_temp1 |
+                                                         PACK_BGR565(0,u8_Red,u8_Green,u8_Blue);
+                #endif  /* LITTLE_ENDIAN */
+
+                /* YUV to RGB */
+                Y_32 = pu8_Y1[u32_col + 1];
+                #ifdef __RGB_V1__
+                        Yval_32=Y_32*37;
+                #else   /* __RGB_V1__v */
+                        Yval_32=Y_32*0x2568;
+                #endif  /* __RGB_V1__v */
+
+                DEMATRIX(u8_Red,u8_Green,u8_Blue,Yval_32,U_32,V_32);
+
+                /* Pack 8 bit R,G,B to RGB565 */
+                #ifdef  LITTLE_ENDIAN
+                        *(pu32_rgb_data_next)++ = u32_rgb_temp2 |
+                                                      PACK_BGR565(16,u8_Red,u8_Green,u8_Blue);
+                #else   /* LITTLE_ENDIAN */
+                        *(pu32_rgb_data_next)++ = u32_rgb_temp2 |
+                                                      PACK_BGR565(0,u8_Red,u8_Green,u8_Blue);
+                #endif  /* LITTLE_ENDIAN */
+            }
+        }
+        else
         {
+            for (u32_col = u32_width_out; u32_col != 0; u32_col -= 2)
+            {
+
+                /* Input Y plane elements */
+                pu8_src_top_Y = pu8_data_in[YPlane] + (u32_x_accum_Y >> 16);
+                pu8_src_bottom_Y = pu8_src_top_Y + u32_stride_in[YPlane];
 
-            /* Input Y plane elements */
-            pu8_src_top_Y = pu8_data_in[YPlane] + (u32_x_accum_Y >> 16);
-            pu8_src_bottom_Y = pu8_src_top_Y + u32_stride_in[YPlane];
+                /* Input U Plane elements */
+                pu8_src_top_U = pu8_data_in[UPlane] + (u32_x_accum_U >> 16);
+                pu8_src_bottom_U = pu8_src_top_U + u32_stride_in[UPlane];
 
-            /* Input U Plane elements */
-            pu8_src_top_U = pu8_data_in[UPlane] + (u32_x_accum_U >> 16);
-            pu8_src_bottom_U = pu8_src_top_U + u32_stride_in[UPlane];
+                pu8_src_top_V = pu8_data_in[VPlane] + (u32_x_accum_U >> 16);
+                pu8_src_bottom_V = pu8_src_top_V + u32_stride_in[VPlane];
 
-            pu8_src_top_V = pu8_data_in[VPlane] + (u32_x_accum_U >> 16);
-            pu8_src_bottom_V = pu8_src_top_V + u32_stride_in[VPlane];
+                /* Horizontal weight factor for Y plane */
+                u32_x_frac_Y = (u32_x_accum_Y >> 12)&15;
+                /* Horizontal weight factor for U and V planes */
+                u32_x_frac_U = (u32_x_accum_U >> 12)&15;
+
+                /* Weighted combination */
+                U_32 = (((pu8_src_top_U[0]*(16-u32_x_frac_U) + pu8_src_top_U[1]*u32_x_frac_U)
+                        *(16-u32_y_frac_U) + (pu8_src_bottom_U[0]*(16-u32_x_frac_U)
+                        + pu8_src_bottom_U[1]*u32_x_frac_U)*u32_y_frac_U ) >> 8);
 
-            /* Horizontal weight factor for Y plane */
-            u32_x_frac_Y = (u32_x_accum_Y >> 12)&15;
-            /* Horizontal weight factor for U and V planes */
-            u32_x_frac_U = (u32_x_accum_U >> 12)&15;
+                V_32 = (((pu8_src_top_V[0]*(16-u32_x_frac_U) + pu8_src_top_V[1]*u32_x_frac_U)
+                        *(16-u32_y_frac_U)+ (pu8_src_bottom_V[0]*(16-u32_x_frac_U)
+                        + pu8_src_bottom_V[1]*u32_x_frac_U)*u32_y_frac_U ) >> 8);
 
-            /* Weighted combination */
-            U_32 = (((pu8_src_top_U[0]*(16-u32_x_frac_U) + pu8_src_top_U[1]*u32_x_frac_U)
-                    *(16-u32_y_frac_U) + (pu8_src_bottom_U[0]*(16-u32_x_frac_U)
-                    + pu8_src_bottom_U[1]*u32_x_frac_U)*u32_y_frac_U ) >> 8);
+                Y_32 = (((pu8_src_top_Y[0]*(16-u32_x_frac_Y) + pu8_src_top_Y[1]*u32_x_frac_Y)
+                        *(16-u32_y_frac_Y) + (pu8_src_bottom_Y[0]*(16-u32_x_frac_Y)
+                        + pu8_src_bottom_Y[1]*u32_x_frac_Y)*u32_y_frac_Y ) >> 8);
 
-            V_32 = (((pu8_src_top_V[0]*(16-u32_x_frac_U) + pu8_src_top_V[1]*u32_x_frac_U)
-                    *(16-u32_y_frac_U)+ (pu8_src_bottom_V[0]*(16-u32_x_frac_U)
-                    + pu8_src_bottom_V[1]*u32_x_frac_U)*u32_y_frac_U ) >> 8);
+                u32_x_accum_U += (u32_x_inc[UPlane]);
 
-            Y_32 = (((pu8_src_top_Y[0]*(16-u32_x_frac_Y) + pu8_src_top_Y[1]*u32_x_frac_Y)
-                    *(16-u32_y_frac_Y) + (pu8_src_bottom_Y[0]*(16-u32_x_frac_Y)
-                    + pu8_src_bottom_Y[1]*u32_x_frac_Y)*u32_y_frac_Y ) >> 8);
-
-            u32_x_accum_U += (u32_x_inc[UPlane]);
-
-            /* YUV to RGB */
-            #ifdef __RGB_V1__
-                    Yval_32 = Y_32*37;
-            #else   /* __RGB_V1__v */
-                    Yval_32 = Y_32*0x2568;
-            #endif /* __RGB_V1__v */
+                /* YUV to RGB */
+                #ifdef __RGB_V1__
+                        Yval_32 = Y_32*37;
+                #else   /* __RGB_V1__v */
+                        Yval_32 = Y_32*0x2568;
+                #endif /* __RGB_V1__v */
 
-                    DEMATRIX(u8_Red,u8_Green,u8_Blue,Yval_32,U_32,V_32);
+                        DEMATRIX(u8_Red,u8_Green,u8_Blue,Yval_32,U_32,V_32);
 
-            /* Pack 8 bit R,G,B to RGB565 */
-            #ifdef  LITTLE_ENDIAN
-                    u32_rgb_temp1 = PACK_BGR565(0,u8_Red,u8_Green,u8_Blue);
-            #else   /* LITTLE_ENDIAN */
-                    u32_rgb_temp1 = PACK_BGR565(16,u8_Red,u8_Green,u8_Blue);
-            #endif  /* LITTLE_ENDIAN */
+                /* Pack 8 bit R,G,B to RGB565 */
+                #ifdef  LITTLE_ENDIAN
+                        u32_rgb_temp1 = PACK_BGR565(0,u8_Red,u8_Green,u8_Blue);
+                #else   /* LITTLE_ENDIAN */
+                        u32_rgb_temp1 = PACK_BGR565(16,u8_Red,u8_Green,u8_Blue);
+                #endif  /* LITTLE_ENDIAN */
 
 
-            pu8_src_top_Y = pu8_data_in1[YPlane]+(u32_x_accum_Y >> 16);
-            pu8_src_bottom_Y = pu8_src_top_Y + u32_stride_in[YPlane];
+                pu8_src_top_Y = pu8_data_in1[YPlane]+(u32_x_accum_Y >> 16);
+                pu8_src_bottom_Y = pu8_src_top_Y + u32_stride_in[YPlane];
 
-            /* Weighted combination */
-            Y_32 = (((pu8_src_top_Y[0]*(16-u32_x_frac_Y) + pu8_src_top_Y[1]*u32_x_frac_Y)
-                    *(16-u32_rgb_temp4) + (pu8_src_bottom_Y[0]*(16-u32_x_frac_Y)
-                    + pu8_src_bottom_Y[1]*u32_x_frac_Y)*u32_rgb_temp4 ) >> 8);
+                /* Weighted combination */
+                Y_32 = (((pu8_src_top_Y[0]*(16-u32_x_frac_Y) + pu8_src_top_Y[1]*u32_x_frac_Y)
+                        *(16-u32_rgb_temp4) + (pu8_src_bottom_Y[0]*(16-u32_x_frac_Y)
+                        + pu8_src_bottom_Y[1]*u32_x_frac_Y)*u32_rgb_temp4 ) >> 8);
 
-            u32_x_accum_Y += u32_x_inc[YPlane];
+                u32_x_accum_Y += u32_x_inc[YPlane];
 
-            /* Horizontal weight factor */
-            u32_x_frac_Y = (u32_x_accum_Y >> 12)&15;
+                /* Horizontal weight factor */
+                u32_x_frac_Y = (u32_x_accum_Y >> 12)&15;
 
-            /* YUV to RGB */
-            #ifdef __RGB_V1__
-                    Yval_32 = Y_32*37;
-            #else   /* __RGB_V1__v */
-                    Yval_32 = Y_32*0x2568;
-            #endif  /* __RGB_V1__v */
+                /* YUV to RGB */
+                #ifdef __RGB_V1__
+                        Yval_32 = Y_32*37;
+                #else   /* __RGB_V1__v */
+                        Yval_32 = Y_32*0x2568;
+                #endif  /* __RGB_V1__v */
 
-            DEMATRIX(u8_Red,u8_Green,u8_Blue,Yval_32,U_32,V_32);
+                DEMATRIX(u8_Red,u8_Green,u8_Blue,Yval_32,U_32,V_32);
 
-            /* Pack 8 bit R,G,B to RGB565 */
-            #ifdef  LITTLE_ENDIAN
-                    u32_rgb_temp2 = PACK_BGR565(0,u8_Red,u8_Green,u8_Blue);
-            #else   /* LITTLE_ENDIAN */
-                    u32_rgb_temp2 = PACK_BGR565(16,u8_Red,u8_Green,u8_Blue);
-            #endif  /* LITTLE_ENDIAN */
+                /* Pack 8 bit R,G,B to RGB565 */
+                #ifdef  LITTLE_ENDIAN
+                        u32_rgb_temp2 = PACK_BGR565(0,u8_Red,u8_Green,u8_Blue);
+                #else   /* LITTLE_ENDIAN */
+                        u32_rgb_temp2 = PACK_BGR565(16,u8_Red,u8_Green,u8_Blue);
+                #endif  /* LITTLE_ENDIAN */
 
 
-            pu8_src_top_Y = pu8_data_in[YPlane] + (u32_x_accum_Y >> 16) ;
-            pu8_src_bottom_Y = pu8_src_top_Y + u32_stride_in[YPlane];
+                pu8_src_top_Y = pu8_data_in[YPlane] + (u32_x_accum_Y >> 16) ;
+                pu8_src_bottom_Y = pu8_src_top_Y + u32_stride_in[YPlane];
 
-            /* Weighted combination */
-            Y_32 = (((pu8_src_top_Y[0]*(16-u32_x_frac_Y) + pu8_src_top_Y[1]*u32_x_frac_Y)
-                    *(16-u32_y_frac_Y) + (pu8_src_bottom_Y[0]*(16-u32_x_frac_Y)
-                    + pu8_src_bottom_Y[1]*u32_x_frac_Y)*u32_y_frac_Y ) >> 8);
+                /* Weighted combination */
+                Y_32 = (((pu8_src_top_Y[0]*(16-u32_x_frac_Y) + pu8_src_top_Y[1]*u32_x_frac_Y)
+                        *(16-u32_y_frac_Y) + (pu8_src_bottom_Y[0]*(16-u32_x_frac_Y)
+                        + pu8_src_bottom_Y[1]*u32_x_frac_Y)*u32_y_frac_Y ) >> 8);
 
-            /* YUV to RGB */
-            #ifdef __RGB_V1__
-                    Yval_32 = Y_32*37;
-            #else   /* __RGB_V1__v */
-                    Yval_32 = Y_32*0x2568;
-            #endif  /* __RGB_V1__v */
+                /* YUV to RGB */
+                #ifdef __RGB_V1__
+                        Yval_32 = Y_32*37;
+                #else   /* __RGB_V1__v */
+                        Yval_32 = Y_32*0x2568;
+                #endif  /* __RGB_V1__v */
 
-            DEMATRIX(u8_Red,u8_Green,u8_Blue,Yval_32,U_32,V_32);
+                DEMATRIX(u8_Red,u8_Green,u8_Blue,Yval_32,U_32,V_32);
 
-            /* Pack 8 bit R,G,B to RGB565 */
-            #ifdef  LITTLE_ENDIAN
-                    *(pu32_rgb_data_current)++ = u32_rgb_temp1 |
-                                                     PACK_BGR565(16,u8_Red,u8_Green,u8_Blue);
-            #else   /* LITTLE_ENDIAN */
-                    *(pu32_rgb_data_current)++ = u32_rgb_temp1 |
-                                                     PACK_BGR565(0,u8_Red,u8_Green,u8_Blue);
-            #endif  /* LITTLE_ENDIAN */
+                /* Pack 8 bit R,G,B to RGB565 */
+                #ifdef  LITTLE_ENDIAN
+                        *(pu32_rgb_data_current)++ = u32_rgb_temp1 |
+                                                         PACK_BGR565(16,u8_Red,u8_Green,u8_Blue);
+                #else   /* LITTLE_ENDIAN */
+                        *(pu32_rgb_data_current)++ = u32_rgb_temp1 |
+                                                         PACK_BGR565(0,u8_Red,u8_Green,u8_Blue);
+                #endif  /* LITTLE_ENDIAN */
 
 
-            pu8_src_top_Y = pu8_data_in1[YPlane]+ (u32_x_accum_Y >> 16);
-            pu8_src_bottom_Y = pu8_src_top_Y + u32_stride_in[YPlane];
-
-            /* Weighted combination */
-            Y_32 = (((pu8_src_top_Y[0]*(16-u32_x_frac_Y) + pu8_src_top_Y[1]*u32_x_frac_Y)
-                    *(16-u32_rgb_temp4) + (pu8_src_bottom_Y[0]*(16-u32_x_frac_Y)
-                    + pu8_src_bottom_Y[1]*u32_x_frac_Y)*u32_rgb_temp4 )>>8);
-
-            u32_x_accum_Y += u32_x_inc[YPlane];
-            /* YUV to RGB */
-            #ifdef __RGB_V1__
-                    Yval_32=Y_32*37;
-            #else   /* __RGB_V1__v */
-                    Yval_32=Y_32*0x2568;
-            #endif  /* __RGB_V1__v */
+                pu8_src_top_Y = pu8_data_in1[YPlane]+ (u32_x_accum_Y >> 16);
+                pu8_src_bottom_Y = pu8_src_top_Y + u32_stride_in[YPlane];
 
-            DEMATRIX(u8_Red,u8_Green,u8_Blue,Yval_32,U_32,V_32);
-
-            /* Pack 8 bit R,G,B to RGB565 */
-            #ifdef  LITTLE_ENDIAN
-                    *(pu32_rgb_data_next)++ = u32_rgb_temp2 |
-                                                  PACK_BGR565(16,u8_Red,u8_Green,u8_Blue);
-            #else   /* LITTLE_ENDIAN */
-                    *(pu32_rgb_data_next)++ = u32_rgb_temp2 |
-                                                  PACK_BGR565(0,u8_Red,u8_Green,u8_Blue);
-            #endif  /* LITTLE_ENDIAN */
-
-        }   /* End of horizontal scanning */
+                /* Weighted combination */
+                Y_32 = (((pu8_src_top_Y[0]*(16-u32_x_frac_Y) + pu8_src_top_Y[1]*u32_x_frac_Y)
+                        *(16-u32_rgb_temp4) + (pu8_src_bottom_Y[0]*(16-u32_x_frac_Y)
+                        + pu8_src_bottom_Y[1]*u32_x_frac_Y)*u32_rgb_temp4 )>>8);
+
+                u32_x_accum_Y += u32_x_inc[YPlane];
+                /* YUV to RGB */
+                #ifdef __RGB_V1__
+                        Yval_32=Y_32*37;
+                #else   /* __RGB_V1__v */
+                        Yval_32=Y_32*0x2568;
+                #endif  /* __RGB_V1__v */
+
+                DEMATRIX(u8_Red,u8_Green,u8_Blue,Yval_32,U_32,V_32);
+
+                /* Pack 8 bit R,G,B to RGB565 */
+                #ifdef  LITTLE_ENDIAN
+                        *(pu32_rgb_data_next)++ = u32_rgb_temp2 |
+                                                      PACK_BGR565(16,u8_Red,u8_Green,u8_Blue);
+                #else   /* LITTLE_ENDIAN */
+                        *(pu32_rgb_data_next)++ = u32_rgb_temp2 |
+                                                      PACK_BGR565(0,u8_Red,u8_Green,u8_Blue);
+                #endif  /* LITTLE_ENDIAN */
+
+            }   /* End of horizontal scanning */
+        }
 
         u32_y_accum_Y  =  u32_rgb_temp3 + (u32_y_inc[YPlane]);
         u32_y_accum_U += (u32_y_inc[UPlane]);
@@ -690,6 +854,13 @@ static M4VIFI_UInt8 M4VIFI_ResizeBilinearYUV420toBGR565_X86(void* pContext,
         pu32_rgb_data_start += u32_stride_out;
 
     }   /* End of vertical scanning */
+
+    if (bKernels)
+    {
+        M4VIFI_NV12ResamplerDeinit(&resamplerY);
+        M4VIFI_NV12ResamplerDeinit(&resamplerUV);
+        free(pu8_samples);
+    }
     return M4VIFI_OK;
 }
 
@@ -726,6 +897,9 @@ M4VIFI_UInt8 M4VIFI_RGB888toNV12(void *pUserData,
     M4VIFI_UInt8    *pu8_yn, *pu8_ys, *pu8_u, *pu8_v;
     M4VIFI_UInt8    *pu8_y_data, *pu8_u_data, *pu8_v_data;
     M4VIFI_UInt8    *pu8_rgbn_data, *pu8_rgbn;
+    M4VIFI_UInt32   u32_done;
+
+    const M4VIFI_NV12Kernels *k = M4VIFI_NV12GetKernels();
 
     /* check sizes */
     if( (PlaneIn->u_height != PlaneOut[0].u_height)         ||
@@ -771,8 +945,22 @@ M4VIFI_UInt8 M4VIFI_RGB888toNV12(void *pUserData,
 
         pu8_rgbn= pu8_rgbn_data;
 
+        u32_col = u32_width;
+
+        /* The kernels convert the first pixels of the two rows, the loop below does the rest */
+        if (k != M4OSA_NULL)
+        {
+            u32_done = k->rgbToNV12(pu8_rgbn, u32_stride_rgb, pu8_yn, u32_stride_Y, pu8_u, u32_width);
+            pu8_rgbn += u32_done * CST_RGB_24_SIZE;
+            pu8_yn += u32_done;
+            pu8_ys += u32_done;
+            pu8_u += u32_done;
+            pu8_v += u32_done;
+            u32_col -= u32_done;
+        }
+
         /* loop on each column of the output image*/
-        for (u32_col = u32_width; u32_col != 0 ; u32_col -=2)
+        for (; u32_col != 0 ; u32_col -=2)
         {
             /* get RGB samples of 4 pixels */
             GET_RGB24(i32_r00, i32_g00, i32_b00, pu8_rgbn, 0);
@@ -906,6 +1094,10 @@ M4VIFI_UInt8 M4VIFI_ResizeBilinearNV12toNV12(void *pUserData,
     M4VIFI_UInt8    u8Hflag = 0;
     M4VIFI_UInt32   loop = 0;
 
+    const M4VIFI_NV12Kernels *k = M4VIFI_NV12GetKernels();
+    M4VIFI_NV12Resampler resampler;
+    M4OSA_Bool      bKernels;
+
     ALOGV("M4VIFI_ResizeBilinearNV12toNV12 begin");
     /*
      If input width is equal to output width and input height equal to
@@ -1044,6 +1236,14 @@ M4VIFI_UInt8 M4VIFI_ResizeBilinearNV12toNV12(void *pUserData,
 
         u32_height = u32_height_out;
 
+        /*
+        The kernels resample whole rows (of UV pairs for the chroma plane),
+        the loops below are the fallback
+        */
+        bKernels = (k != NULL) && (M4VIFI_NV12ResamplerInit(&resampler, k,
+            u32_plane == 0 ? u32_width_out : u32_width_out >> 1,
+            u32_x_accum_start, u32_x_inc, u32_plane) == 0);
+
         /*
         Bilinear interpolation linearly interpolates along each row, and
         then uses that result in a linear interpolation donw each column.
@@ -1066,27 +1266,34 @@ M4VIFI_UInt8 M4VIFI_ResizeBilinearNV12toNV12(void *pUserData,
                 /* Vertical weight factor */
                 u32_y_frac = (u32_y_accum>>12)&15;
 
-                /* Reinit accumulator */
-                u32_x_accum = u32_x_accum_start;
-
-                u32_width = u32_width_out;
-
-                do { /* Scan along each row */
-                    pu8_src_top = pu8_data_in + (u32_x_accum >> 16);
-                    pu8_src_bottom = pu8_src_top + u32_stride_in;
-                    u32_x_frac = (u32_x_accum >> 12)&15; /* Horizontal weight factor */
-
-                    /* Weighted combination */
-                    u32_temp_value = (M4VIFI_UInt8)(((pu8_src_top[0]*(16-u32_x_frac) +
-                                                     pu8_src_top[1]*u32_x_frac)*(16-u32_y_frac) +
-                                                    (pu8_src_bottom[0]*(16-u32_x_frac) +
-                                                     pu8_src_bottom[1]*u32_x_frac)*u32_y_frac )>>8);
-
-                    *pu8_data_out++ = (M4VIFI_UInt8)u32_temp_value;
-
-                    /* Update horizontal accumulator */
-                    u32_x_accum += u32_x_inc;
-                } while(--u32_width);
+                if (bKernels) {
+                    M4VIFI_NV12ResamplerRow(&resampler, pu8_data_in, u32_stride_in,
+                        u32_y_frac, pu8_data_out);
+                    pu8_data_out += u32_width_out;
+                    u32_temp_value = pu8_data_out[-1];
+                } else {
+                    /* Reinit accumulator */
+                    u32_x_accum = u32_x_accum_start;
+
+                    u32_width = u32_width_out;
+
+                    do { /* Scan along each row */
+                        pu8_src_top = pu8_data_in + (u32_x_accum >> 16);
+                        pu8_src_bottom = pu8_src_top + u32_stride_in;
+                        u32_x_frac = (u32_x_accum >> 12)&15; /* Horizontal weight factor */
+
+                        /* Weighted combination */
+                        u32_temp_value = (M4VIFI_UInt8)(((pu8_src_top[0]*(16-u32_x_frac) +
+                                                         pu8_src_top[1]*u32_x_frac)*(16-u32_y_frac) +
+                                                        (pu8_src_bottom[0]*(16-u32_x_frac) +
+                                                         pu8_src_bottom[1]*u32_x_frac)*u32_y_frac )>>8);
+
+                        *pu8_data_out++ = (M4VIFI_UInt8)u32_temp_value;
+
+                        /* Update horizontal accumulator */
+                        u32_x_accum += u32_x_inc;
+                    } while(--u32_width);
+                }
 
                 /*
                    This u8Wflag flag gets in to effect if input and output
@@ -1128,37 +1335,45 @@ M4VIFI_UInt8 M4VIFI_ResizeBilinearNV12toNV12(void *pUserData,
                 /* Vertical weight factor */
                 u32_y_frac = (u32_y_accum>>12)&15;
 
-                /* Reinit accumulator */
-                u32_x_accum = u32_x_accum_start;
-
-                u32_width = u32_width_out;
-
-                do { /* Scan along each row */
-                    pu8_src_top = pu8_data_in + ((u32_x_accum >> 16) << 1);
-                    pu8_src_bottom = pu8_src_top + u32_stride_in;
-                    u32_x_frac = (u32_x_accum >> 12)&15;
-
-                    /* U planar weighted combination */
-                    u32_temp_value1 = (M4VIFI_UInt8)(((pu8_src_top[0]*(16-u32_x_frac) +
-                                                 pu8_src_top[2]*u32_x_frac)*(16-u32_y_frac) +
-                                                (pu8_src_bottom[0]*(16-u32_x_frac) +
-                                                 pu8_src_bottom[2]*u32_x_frac)*u32_y_frac )>>8);
-                    *pu8_data_out++ = (M4VIFI_UInt8)u32_temp_value1;
+                if (bKernels) {
+                    M4VIFI_NV12ResamplerRow(&resampler, pu8_data_in, u32_stride_in,
+                        u32_y_frac, pu8_data_out);
+                    pu8_data_out += u32_width_out;
+                    u32_temp_value1 = pu8_data_out[-2];
+                    u32_temp_value = pu8_data_out[-1];
+                } else {
+                    /* Reinit accumulator */
+                    u32_x_accum = u32_x_accum_start;
+
+                    u32_width = u32_width_out;
+
+                    do { /* Scan along each row */
+                        pu8_src_top = pu8_data_in + ((u32_x_accum >> 16) << 1);
+                        pu8_src_bottom = pu8_src_top + u32_stride_in;
+                        u32_x_frac = (u32_x_accum >> 12)&15;
+
+                        /* U planar weighted combination */
+                        u32_temp_value1 = (M4VIFI_UInt8)(((pu8_src_top[0]*(16-u32_x_frac) +
+                                                     pu8_src_top[2]*u32_x_frac)*(16-u32_y_frac) +
+                                                    (pu8_src_bottom[0]*(16-u32_x_frac) +
+                                                     pu8_src_bottom[2]*u32_x_frac)*u32_y_frac )>>8);
+                        *pu8_data_out++ = (M4VIFI_UInt8)u32_temp_value1;
 
-                    pu8_src_top = pu8_src_top + 1;
-                    pu8_src_bottom = pu8_src_bottom + 1;
+                        pu8_src_top = pu8_src_top + 1;
+                        pu8_src_bottom = pu8_src_bottom + 1;
 
-                    /* V planar weighted combination */
-                    u32_temp_value = (M4VIFI_UInt8)(((pu8_src_top[0]*(16-u32_x_frac) +
-                                                 pu8_src_top[2]*u32_x_frac)*(16-u32_y_frac) +
-                                                (pu8_src_bottom[0]*(16-u32_x_frac) +
-                                                 pu8_src_bottom[2]*u32_x_frac)*u32_y_frac )>>8);
-                    *pu8_data_out++ = (M4VIFI_UInt8)u32_temp_value;
+                        /* V planar weighted combination */
+                        u32_temp_value = (M4VIFI_UInt8)(((pu8_src_top[0]*(16-u32_x_frac) +
+                                                     pu8_src_top[2]*u32_x_frac)*(16-u32_y_frac) +
+                                                    (pu8_src_bottom[0]*(16-u32_x_frac) +
+                                                     pu8_src_bottom[2]*u32_x_frac)*u32_y_frac )>>8);
+                        *pu8_data_out++ = (M4VIFI_UInt8)u32_temp_value;
 
-                    /* Update horizontal accumulator */
-                    u32_x_accum += u32_x_inc;
-                    u32_width -= 2;
-                } while(u32_width);
+                        /* Update horizontal accumulator */
+                        u32_x_accum += u32_x_inc;
+                        u32_width -= 2;
+                    } while(u32_width);
+                }
 
                 /*
                    This u8Wflag flag gets in to effect if input and output
@@ -1190,11 +1405,69 @@ M4VIFI_UInt8 M4VIFI_ResizeBilinearNV12toNV12(void *pUserData,
                 memcpy((void *)pu8_data_out,(void *)pu8dum,u32_width_out+u8Wflag+1);
             }
         }
+
+        if (bKernels) {
+            M4VIFI_NV12ResamplerDeinit(&resampler);
+        }
     }
     ALOGV("M4VIFI_ResizeBilinearNV12toNV12 end");
     return M4VIFI_OK;
 }
 
+/**
+ ***********************************************************************************************
+ * M4OSA_Bool M4VIFI_RotateNV12WithKernels(M4OSA_UInt32 degrees, M4VIFI_ImagePlane *pPlaneIn,
+ *                                                              M4VIFI_ImagePlane *pPlaneOut)
+ * @brief   Rotates a NV12 image clockwise with the SIMD kernels.
+ * @note    Only out of place rotations of planes whose sizes match the rotation
+ *          are done, the others are left to the scalar loops.
+ * @param   degrees: (IN) 90, 180 or 270
+ * @param   pPlaneIn: (IN) Pointer to NV12 plane buffer
+ * @param   pPlaneOut: (OUT) Pointer to NV12 plane buffer
+ * @return  M4OSA_TRUE if the image has been rotated
+ ***********************************************************************************************
+*/
+static M4OSA_Bool M4VIFI_RotateNV12WithKernels(M4OSA_UInt32 degrees,
+    M4VIFI_ImagePlane *pPlaneIn, M4VIFI_ImagePlane *pPlaneOut)
+{
+    const M4VIFI_NV12Kernels *k = M4VIFI_NV12GetKernels();
+    M4VIFI_UInt32 u32_width = pPlaneIn[0].u_width;
+    M4VIFI_UInt32 u32_height = pPlaneIn[0].u_height;
+    M4VIFI_UInt32 u32_width_out = (degrees == 180) ? u32_width : u32_height;
+    M4VIFI_UInt32 u32_height_out = (degrees == 180) ? u32_height : u32_width;
+    M4VIFI_UInt8 *pu8_src[2], *pu8_dest[2];
+    M4VIFI_UInt32 u32_plane;
+
+    if (k == M4OSA_NULL)
+        return M4OSA_FALSE;
+
+    if ((IS_EVEN(u32_width) == FALSE) || (IS_EVEN(u32_height) == FALSE) ||
+        (pPlaneOut[0].u_width != u32_width_out) ||
+        (pPlaneOut[0].u_height != u32_height_out) ||
+        (pPlaneIn[1].u_width != u32_width) ||
+        (pPlaneIn[1].u_height != (u32_height >> 1)) ||
+        (pPlaneOut[1].u_width != u32_width_out) ||
+        (pPlaneOut[1].u_height != (u32_height_out >> 1)))
+        return M4OSA_FALSE;
+
+    for (u32_plane = 0; u32_plane < 2; u32_plane++) {
+        pu8_src[u32_plane] =
+            &(pPlaneIn[u32_plane].pac_data[pPlaneIn[u32_plane].u_topleft]);
+        pu8_dest[u32_plane] =
+            &(pPlaneOut[u32_plane].pac_data[pPlaneOut[u32_plane].u_topleft]);
+        if (pu8_src[u32_plane] == pu8_dest[u32_plane])
+            return M4OSA_FALSE;
+    }
+
+    /**< Luma as 1 byte elements, chroma as 2 byte UV elements */
+    k->rotatePlane(degrees, 1, u32_width, u32_height,
+        pu8_src[0], pPlaneIn[0].u_stride, pu8_dest[0], pPlaneOut[0].u_stride);
+    k->rotatePlane(degrees, 2, u32_width >> 1, u32_height >> 1,
+        pu8_src[1], pPlaneIn[1].u_stride, pu8_dest[1], pPlaneOut[1].u_stride);
+
+    return M4OSA_TRUE;
+}
+
 M4VIFI_UInt8 M4VIFI_Rotate90LeftNV12toNV12(void* pUserData,
     M4VIFI_ImagePlane *pPlaneIn, M4VIFI_ImagePlane *pPlaneOut)
 {
@@ -1202,6 +1475,9 @@ M4VIFI_UInt8 M4VIFI_Rotate90LeftNV12toNV12(void* pUserData,
     M4VIFI_UInt32 i,j, u_stride;
     M4VIFI_UInt8 *p_buf_src, *p_buf_dest;
 
+    if (M4VIFI_RotateNV12WithKernels(270, pPlaneIn, pPlaneOut))
+        return M4VIFI_OK;
+
     /**< Loop on Y,U and V planes */
     for (plane_number = 0; plane_number < 2; plane_number++) {
         /**< Get adresses of first valid pixel in input and output buffer */
@@ -1264,6 +1540,9 @@ M4VIFI_UInt8 M4VIFI_Rotate90RightNV12toNV12(void* pUserData,
     M4VIFI_UInt32 i,j, u_stride;
     M4VIFI_UInt8 *p_buf_src, *p_buf_dest;
 
+    if (M4VIFI_RotateNV12WithKernels(90, pPlaneIn, pPlaneOut))
+        return M4VIFI_OK;
+
     /**< Loop on Y,U and V planes */
     for (plane_number = 0; plane_number < 2; plane_number++) {
         /**< Get adresses of first valid pixel in input and output buffer */
@@ -1321,6 +1600,9 @@ M4VIFI_UInt8 M4VIFI_Rotate180NV12toNV12(void* pUserData,
     M4VIFI_UInt8 *p_buf_src, *p_buf_dest, temp_pix1;
     M4VIFI_UInt16 *p16_buf_src, *p16_buf_dest, temp_pix2;
 
+    if (M4VIFI_RotateNV12WithKernels(180, pPlaneIn, pPlaneOut))
+        return M4VIFI_OK;
+
     /**< Loop on Y,U and V planes */
     for (plane_number = 0; plane_number < 2; plane_number++) {
         /**< Get adresses of first valid pixel in input and output buffer */
@@ -1541,7 +1823,11 @@ M4VIFI_UInt8 M4VIFI_ResizeBilinearNV12toBGR565(void *pUserData,
 
     mVideoWidth  = pPlaneIn[0].u_width;
     mVideoHeight = pPlaneIn[0].u_height;
-    mFrameSize   = mVideoWidth * mVideoHeight * 3/2;
+    /*
+     One more chroma row: the bilinear loops read the row below the last
+     one of the V plane, which would be past the end of the buffer
+    */
+    mFrameSize   = mVideoWidth * mVideoHeight * 3/2 + mVideoWidth/2;
 
     M4OSA_UInt8 *pData = (M4OSA_UInt8 *)M4OSA_32bitAlignedMalloc(
                              mFrameSize,
@@ -1553,6 +1839,8 @@ M4VIFI_UInt8 M4VIFI_ResizeBilinearNV12toBGR565(void *pUserData,
         ALOGE("Error: Fail to allocate tempBuffer!");
         return M4VIFI_ALLOC_FAILURE;
     }
+    memset((void *)(pData + mVideoWidth * mVideoHeight * 3/2), 0, mVideoWidth/2);
+
     pPlaneTmp[0].pac_data   = pData;
     pPlaneTmp[0].u_height   = pPlaneIn[0].u_height;
     pPlaneTmp[0].u_width    = pPlaneIn[0].u_width;
@@ -0,0 +1,670 @@
+/*
+ * Copyright (C) 2014 Intel Corporation.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "VideoEditorToolsNV12Kernels"
+#include <utils/Log.h>
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#define M4VIFI_NV12_X86 1
+#endif
+
+#include "VideoEditorToolsNV12Kernels.h"
+
+/*
+ * The bilinear sums are at most 255 * 16 * 16, so both blends fit 16 bit
+ * lanes: the vertical one is a multiply-add of interleaved top and bottom
+ * bytes, the horizontal one a multiply-add of the two neighbours loaded
+ * as one 32 bit word.
+ *
+ * Only the rotations by 90 and 270 degrees have AVX2 versions, which do
+ * two tiles at once. The AVX2 set uses the SSSE3 kernels for the rest:
+ * 256 bit row blends, deinterleaves and 180 degree rotations measured no
+ * faster, and the horizontal blends with gathers were slower than the
+ * SSSE3 ones, which load the neighbours one by one.
+ *
+ * The RGB to NV12 conversion computes the products of the Y24, U24 and
+ * V24 macros exactly in 32 bit lanes. Their coefficients do not fit 16
+ * bits, so each one is split as hi * 65536 + lo with lo in int16 range:
+ * two multiply-adds, the hi one shifted by 16. CLIP is the saturation of
+ * the packs. U and V of the four pixels are clipped before they are
+ * averaged, as the scalar loop does.
+ *
+ * Rotations by 90 and 270 degrees transpose tiles of 16 bytes per row
+ * (16x16 luma or 8x8 UV elements) in registers, walked in blocks of
+ * BLOCK x BLOCK elements so that the rows of a block stay in L1. The
+ * elements which do not fill a tile are moved one by one.
+ */
+
+#ifdef M4VIFI_NV12_X86
+
+#define BLOCK 64    /* elements, multiple of every tile size */
+
+/* Scalar versions, the tails of the SIMD kernels */
+
+static void blendRows_c(const uint8_t *top, const uint8_t *bottom,
+        uint32_t yfrac, uint16_t *rows, uint32_t n)
+{
+    uint32_t i;
+
+    for (i = 0; i < n; i++)
+        rows[i] = (uint16_t)(top[i] * (16 - yfrac) + bottom[i] * yfrac);
+}
+
+static void blendColumns_c(const uint16_t *rows, const uint32_t *offsets,
+        const uint32_t *weights, uint8_t *out, uint32_t n)
+{
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+        const uint16_t *s = rows + offsets[i];
+        uint32_t w = weights[i];
+        out[i] = (uint8_t)((s[0] * (w & 0xffff) + s[1] * (w >> 16)) >> 8);
+    }
+}
+
+static void blendPairs_c(const uint16_t *rows, const uint32_t *offsets,
+        const uint32_t *weights, uint8_t *out, uint32_t n)
+{
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+        const uint16_t *s = rows + offsets[i];
+        uint32_t w = weights[i];
+        out[2 * i] = (uint8_t)((s[0] * (w & 0xffff) + s[2] * (w >> 16)) >> 8);
+        out[2 * i + 1] = (uint8_t)((s[1] * (w & 0xffff) + s[3] * (w >> 16)) >> 8);
+    }
+}
+
+static void deinterleave_c(const uint8_t *uv, uint8_t *u, uint8_t *v, uint32_t n)
+{
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+        u[i] = uv[2 * i];
+        v[i] = uv[2 * i + 1];
+    }
+}
+
+/* Rotates the source elements in [x0, x1) x [y0, y1) of a w x h plane */
+static void rotateRegion(int degrees, int e, uint32_t w, uint32_t h,
+        const uint8_t *src, uint32_t sstride, uint8_t *dst, uint32_t dstride,
+        uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1)
+{
+    uint32_t x, y;
+
+    for (y = y0; y < y1; y++) {
+        const uint8_t *s = src + (size_t)y * sstride + x0 * e;
+        uint8_t *d;
+        ptrdiff_t dstep;
+
+        switch (degrees) {
+        case 90:
+            d = dst + (size_t)x0 * dstride + (h - 1 - y) * e;
+            dstep = dstride;
+            break;
+        case 180:
+            d = dst + (size_t)(h - 1 - y) * dstride + (w - 1 - x0) * e;
+            dstep = -e;
+            break;
+        default: /* 270 */
+            d = dst + (size_t)(w - 1 - x0) * dstride + y * e;
+            dstep = -(ptrdiff_t)dstride;
+            break;
+        }
+
+        for (x = x0; x < x1; x++) {
+            d[0] = s[0];
+            if (e == 2)
+                d[1] = s[1];
+            s += e;
+            d += dstep;
+        }
+    }
+}
+
+#define SSSE3 __attribute__((target("ssse3")))
+#define AVX2 __attribute__((target("avx2")))
+
+static inline uint32_t load32(const uint16_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+SSSE3 static void blendRows_ssse3(const uint8_t *top, const uint8_t *bottom,
+        uint32_t yfrac, uint16_t *rows, uint32_t n)
+{
+    const __m128i w = _mm_set1_epi16((int16_t)((16 - yfrac) | (yfrac << 8)));
+    uint32_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m128i t = _mm_loadu_si128((const __m128i *)(top + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(bottom + i));
+        _mm_storeu_si128((__m128i *)(rows + i),
+                _mm_maddubs_epi16(_mm_unpacklo_epi8(t, b), w));
+        _mm_storeu_si128((__m128i *)(rows + i + 8),
+                _mm_maddubs_epi16(_mm_unpackhi_epi8(t, b), w));
+    }
+    blendRows_c(top + i, bottom + i, yfrac, rows + i, n - i);
+}
+
+SSSE3 static void blendColumns_ssse3(const uint16_t *rows, const uint32_t *offsets,
+        const uint32_t *weights, uint8_t *out, uint32_t n)
+{
+    uint32_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        const uint32_t *o = offsets + i;
+        __m128i a = _mm_setr_epi32(load32(rows + o[0]), load32(rows + o[1]),
+                load32(rows + o[2]), load32(rows + o[3]));
+        __m128i b = _mm_setr_epi32(load32(rows + o[4]), load32(rows + o[5]),
+                load32(rows + o[6]), load32(rows + o[7]));
+        a = _mm_madd_epi16(a, _mm_loadu_si128((const __m128i *)(weights + i)));
+        b = _mm_madd_epi16(b, _mm_loadu_si128((const __m128i *)(weights + i + 4)));
+        a = _mm_packs_epi32(_mm_srli_epi32(a, 8), _mm_srli_epi32(b, 8));
+        _mm_storel_epi64((__m128i *)(out + i), _mm_packus_epi16(a, a));
+    }
+    blendColumns_c(rows, offsets + i, weights + i, out + i, n - i);
+}
+
+SSSE3 static void blendPairs_ssse3(const uint16_t *rows, const uint32_t *offsets,
+        const uint32_t *weights, uint8_t *out, uint32_t n)
+{
+    /* U0 V0 U1 V1 -> U0 U1 V0 V1 in each half */
+    const __m128i order = _mm_setr_epi8(0, 1, 4, 5, 2, 3, 6, 7,
+            8, 9, 12, 13, 10, 11, 14, 15);
+    uint32_t i;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+        const uint32_t *o = offsets + i;
+        __m128i w = _mm_loadu_si128((const __m128i *)(weights + i));
+        __m128i a = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)(rows + o[0])),
+                _mm_loadl_epi64((const __m128i *)(rows + o[1])));
+        __m128i b = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)(rows + o[2])),
+                _mm_loadl_epi64((const __m128i *)(rows + o[3])));
+        a = _mm_madd_epi16(_mm_shuffle_epi8(a, order), _mm_unpacklo_epi32(w, w));
+        b = _mm_madd_epi16(_mm_shuffle_epi8(b, order), _mm_unpackhi_epi32(w, w));
+        a = _mm_packs_epi32(_mm_srli_epi32(a, 8), _mm_srli_epi32(b, 8));
+        _mm_storel_epi64((__m128i *)(out + 2 * i), _mm_packus_epi16(a, a));
+    }
+    blendPairs_c(rows, offsets + i, weights + i, out + 2 * i, n - i);
+}
+
+SSSE3 static void deinterleave_ssse3(const uint8_t *uv, uint8_t *u, uint8_t *v, uint32_t n)
+{
+    const __m128i split = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14,
+            1, 3, 5, 7, 9, 11, 13, 15);
+    uint32_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(uv + 2 * i)), split);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(uv + 2 * i + 16)), split);
+        _mm_storeu_si128((__m128i *)(u + i), _mm_unpacklo_epi64(a, b));
+        _mm_storeu_si128((__m128i *)(v + i), _mm_unpackhi_epi64(a, b));
+    }
+    deinterleave_c(uv + 2 * i, u + i, v + i, n - i);
+}
+
+/* R G and B of pixels 0-3 of a row from the bytes of pixels 0-5, and of
+   pixels 4-7 from the bytes of pixels 2-7: R G pairs and B in 32 bit lanes */
+#define RGB_RG_LO   0, -1, 1, -1, 3, -1, 4, -1, 6, -1, 7, -1, 9, -1, 10, -1
+#define RGB_RG_HI   4, -1, 5, -1, 7, -1, 8, -1, 10, -1, 11, -1, 13, -1, 14, -1
+#define RGB_B_LO    2, -1, -1, -1, 5, -1, -1, -1, 8, -1, -1, -1, 11, -1, -1, -1
+#define RGB_B_HI    6, -1, -1, -1, 9, -1, -1, -1, 12, -1, -1, -1, 15, -1, -1, -1
+
+/* coefficients of R and G as 16 bit pairs, of B alone in a 32 bit lane */
+#define RGB_COEFFS(r, g) _mm_set1_epi32((int32_t)(((uint32_t)(uint16_t)(g) << 16) | (uint16_t)(r)))
+#define RGB_COEFF_B(b) _mm_set1_epi32((uint16_t)(b))
+
+/* (c * rgb) >> 15 of four pixels, c split as hi * 65536 + lo */
+SSSE3 static inline __m128i rgbDot(__m128i rg, __m128i b, __m128i rgLo, __m128i bLo,
+        __m128i rgHi, __m128i bHi)
+{
+    __m128i lo = _mm_add_epi32(_mm_madd_epi16(rg, rgLo), _mm_madd_epi16(b, bLo));
+    __m128i hi = _mm_add_epi32(_mm_madd_epi16(rg, rgHi), _mm_madd_epi16(b, bHi));
+    return _mm_srai_epi32(_mm_add_epi32(lo, _mm_slli_epi32(hi, 16)), 15);
+}
+
+/* Y, U and V of 8 pixels, clipped, in 16 bit lanes */
+SSSE3 static inline void rgbToYuv8(const uint8_t *s, __m128i *y, __m128i *u, __m128i *v)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(255);
+    const __m128i c128 = _mm_set1_epi32(128);
+    __m128i lo = _mm_loadu_si128((const __m128i *)s);
+    __m128i hi = _mm_loadu_si128((const __m128i *)(s + 8));
+    __m128i rg0 = _mm_shuffle_epi8(lo, _mm_setr_epi8(RGB_RG_LO));
+    __m128i rg1 = _mm_shuffle_epi8(hi, _mm_setr_epi8(RGB_RG_HI));
+    __m128i b0 = _mm_shuffle_epi8(lo, _mm_setr_epi8(RGB_B_LO));
+    __m128i b1 = _mm_shuffle_epi8(hi, _mm_setr_epi8(RGB_B_HI));
+    __m128i a, b;
+
+    /* Y24: 80593 = 65536 + 15057, 77855 = 65536 + 12319, 30728 */
+    a = rgbDot(rg0, b0, RGB_COEFFS(15057, 12319), RGB_COEFF_B(30728),
+            RGB_COEFFS(1, 1), zero);
+    b = rgbDot(rg1, b1, RGB_COEFFS(15057, 12319), RGB_COEFF_B(30728),
+            RGB_COEFFS(1, 1), zero);
+    *y = _mm_packs_epi32(a, b);
+
+    /* U24: -45483 = -65536 + 20053, -43936 = -65536 + 21600,
+       134771 = 2 * 65536 + 3699 */
+    a = rgbDot(rg0, b0, RGB_COEFFS(20053, 21600), RGB_COEFF_B(3699),
+            RGB_COEFFS(-1, -1), RGB_COEFF_B(2));
+    b = rgbDot(rg1, b1, RGB_COEFFS(20053, 21600), RGB_COEFF_B(3699),
+            RGB_COEFFS(-1, -1), RGB_COEFF_B(2));
+    *u = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(_mm_add_epi32(a, c128),
+            _mm_add_epi32(b, c128)), zero), max);
+
+    /* V24: 134771 = 2 * 65536 + 3699, -55532 = -65536 + 10004, -21917 */
+    a = rgbDot(rg0, b0, RGB_COEFFS(3699, 10004), RGB_COEFF_B(-21917),
+            RGB_COEFFS(2, -1), zero);
+    b = rgbDot(rg1, b1, RGB_COEFFS(3699, 10004), RGB_COEFF_B(-21917),
+            RGB_COEFFS(2, -1), zero);
+    *v = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(_mm_add_epi32(a, c128),
+            _mm_add_epi32(b, c128)), zero), max);
+}
+
+SSSE3 static uint32_t rgbToNV12_ssse3(const uint8_t *rgb, uint32_t rgbStride,
+        uint8_t *y, uint32_t yStride, uint8_t *uv, uint32_t n)
+{
+    const __m128i two = _mm_set1_epi16(2);
+    uint32_t i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m128i y0, u0, v0, y1, u1, v1, c;
+
+        rgbToYuv8(rgb + 3 * i, &y0, &u0, &v0);
+        rgbToYuv8(rgb + rgbStride + 3 * i, &y1, &u1, &v1);
+        _mm_storel_epi64((__m128i *)(y + i), _mm_packus_epi16(y0, y0));
+        _mm_storel_epi64((__m128i *)(y + yStride + i), _mm_packus_epi16(y1, y1));
+
+        /* sums of the 2x2 pixels: U0-3 then V0-3, interleaved */
+        c = _mm_hadd_epi16(_mm_add_epi16(u0, u1), _mm_add_epi16(v0, v1));
+        c = _mm_srli_epi16(_mm_add_epi16(c, two), 2);
+        c = _mm_unpacklo_epi16(c, _mm_srli_si128(c, 8));
+        _mm_storel_epi64((__m128i *)(uv + i), _mm_packus_epi16(c, c));
+    }
+    return i;
+}
+
+/*
+ * Register transposes. One round of unpacks with r[i] and r[i + N/2]
+ * rotates the bits of (register index, element index) by one, log2(N)
+ * rounds swap them: the rows become the columns.
+ */
+
+SSSE3 static inline void transpose16x16_u8(__m128i *r)
+{
+    __m128i o[16];
+    int round, i;
+
+    for (round = 0; round < 4; round++) {
+        for (i = 0; i < 8; i++) {
+            o[2 * i] = _mm_unpacklo_epi8(r[i], r[i + 8]);
+            o[2 * i + 1] = _mm_unpackhi_epi8(r[i], r[i + 8]);
+        }
+        memcpy(r, o, sizeof(o));
+    }
+}
+
+SSSE3 static inline void transpose8x8_u16(__m128i *r)
+{
+    __m128i o[8];
+    int round, i;
+
+    for (round = 0; round < 3; round++) {
+        for (i = 0; i < 4; i++) {
+            o[2 * i] = _mm_unpacklo_epi16(r[i], r[i + 4]);
+            o[2 * i + 1] = _mm_unpackhi_epi16(r[i], r[i + 4]);
+        }
+        memcpy(r, o, sizeof(o));
+    }
+}
+
+/* lane-wise: two independent tiles side by side */
+AVX2 static inline void transpose16x16_u8_x2(__m256i *r)
+{
+    __m256i o[16];
+    int round, i;
+
+    for (round = 0; round < 4; round++) {
+        for (i = 0; i < 8; i++) {
+            o[2 * i] = _mm256_unpacklo_epi8(r[i], r[i + 8]);
+            o[2 * i + 1] = _mm256_unpackhi_epi8(r[i], r[i + 8]);
+        }
+        memcpy(r, o, sizeof(o));
+    }
+}
+
+AVX2 static inline void transpose8x8_u16_x2(__m256i *r)
+{
+    __m256i o[8];
+    int round, i;
+
+    for (round = 0; round < 3; round++) {
+        for (i = 0; i < 4; i++) {
+            o[2 * i] = _mm256_unpacklo_epi16(r[i], r[i + 4]);
+            o[2 * i + 1] = _mm256_unpackhi_epi16(r[i], r[i + 4]);
+        }
+        memcpy(r, o, sizeof(o));
+    }
+}
+
+/*
+ * Tile kernels: load T rows of 16 bytes from s, stepping sstep, and store
+ * the T transposed rows at d, stepping dstep. The wide kernels do two
+ * tiles side by side, the second one is stored T rows further.
+ */
+
+typedef void (*TileKernel)(const uint8_t *s, ptrdiff_t sstep, uint8_t *d, ptrdiff_t dstep);
+
+SSSE3 static void tile_u8_ssse3(const uint8_t *s, ptrdiff_t sstep, uint8_t *d, ptrdiff_t dstep)
+{
+    __m128i r[16];
+    int i;
+
+    for (i = 0; i < 16; i++)
+        r[i] = _mm_loadu_si128((const __m128i *)(s + i * sstep));
+    transpose16x16_u8(r);
+    for (i = 0; i < 16; i++)
+        _mm_storeu_si128((__m128i *)(d + i * dstep), r[i]);
+}
+
+SSSE3 static void tile_u16_ssse3(const uint8_t *s, ptrdiff_t sstep, uint8_t *d, ptrdiff_t dstep)
+{
+    __m128i r[8];
+    int i;
+
+    for (i = 0; i < 8; i++)
+        r[i] = _mm_loadu_si128((const __m128i *)(s + i * sstep));
+    transpose8x8_u16(r);
+    for (i = 0; i < 8; i++)
+        _mm_storeu_si128((__m128i *)(d + i * dstep), r[i]);
+}
+
+AVX2 static void wideTile_u8_avx2(const uint8_t *s, ptrdiff_t sstep, uint8_t *d, ptrdiff_t dstep)
+{
+    __m256i r[16];
+    int i;
+
+    for (i = 0; i < 16; i++)
+        r[i] = _mm256_loadu_si256((const __m256i *)(s + i * sstep));
+    transpose16x16_u8_x2(r);
+    for (i = 0; i < 16; i++) {
+        _mm_storeu_si128((__m128i *)(d + i * dstep), _mm256_castsi256_si128(r[i]));
+        _mm_storeu_si128((__m128i *)(d + (16 + i) * dstep), _mm256_extracti128_si256(r[i], 1));
+    }
+}
+
+AVX2 static void wideTile_u16_avx2(const uint8_t *s, ptrdiff_t sstep, uint8_t *d, ptrdiff_t dstep)
+{
+    __m256i r[8];
+    int i;
+
+    for (i = 0; i < 8; i++)
+        r[i] = _mm256_loadu_si256((const __m256i *)(s + i * sstep));
+    transpose8x8_u16_x2(r);
+    for (i = 0; i < 8; i++) {
+        _mm_storeu_si128((__m128i *)(d + i * dstep), _mm256_castsi256_si128(r[i]));
+        _mm_storeu_si128((__m128i *)(d + (8 + i) * dstep), _mm256_extracti128_si256(r[i], 1));
+    }
+}
+
+/*
+ * Rotation by 90 or 270 degrees with tile kernels, @wide may be NULL.
+ * The tile rows are laid out so that the target columns they write start
+ * on a tile boundary, the leftover source rows are on the top for 90
+ * degrees and on the bottom for 270 degrees.
+ */
+static void rotateTiles(int degrees, int e, uint32_t w, uint32_t h,
+        const uint8_t *src, uint32_t sstride, uint8_t *dst, uint32_t dstride,
+        TileKernel tile, TileKernel wide)
+{
+    const uint32_t t = 16 / e;
+    const uint32_t wt = w - w % t;
+    const uint32_t y0 = degrees == 90 ? h % t : 0;
+    const uint32_t y1 = y0 + h - h % t;
+    uint32_t bx, by, x, y;
+
+    for (by = y0; by < y1; by += BLOCK) {
+        const uint32_t yEnd = by + BLOCK < y1 ? by + BLOCK : y1;
+        for (bx = 0; bx < wt; bx += BLOCK) {
+            const uint32_t xEnd = bx + BLOCK < wt ? bx + BLOCK : wt;
+            for (y = by; y < yEnd; y += t) {
+                /* 90: read the rows bottom up, the first target row is column x
+                   270: read the rows top down, the first target row is w - 1 - x */
+                const uint8_t *s;
+                ptrdiff_t sstep, dstep;
+                uint8_t *d;
+
+                if (degrees == 90) {
+                    s = src + (size_t)(y + t - 1) * sstride;
+                    sstep = -(ptrdiff_t)sstride;
+                    d = dst + (h - t - y) * e;
+                    dstep = dstride;
+                } else {
+                    s = src + (size_t)y * sstride;
+                    sstep = sstride;
+                    d = dst + y * e;
+                    dstep = -(ptrdiff_t)dstride;
+                }
+
+                x = bx;
+                if (wide) {
+                    for (; x + 2 * t <= xEnd; x += 2 * t)
+                        wide(s + x * e, sstep,
+                                d + (size_t)(degrees == 90 ? x : w - 1 - x) * dstride, dstep);
+                }
+                for (; x < xEnd; x += t)
+                    tile(s + x * e, sstep,
+                            d + (size_t)(degrees == 90 ? x : w - 1 - x) * dstride, dstep);
+            }
+        }
+    }
+
+    /* leftover columns, then leftover rows */
+    if (wt < w)
+        rotateRegion(degrees, e, w, h, src, sstride, dst, dstride, wt, 0, w, h);
+    if (y0 > 0)
+        rotateRegion(degrees, e, w, h, src, sstride, dst, dstride, 0, 0, wt, y0);
+    if (y1 < h)
+        rotateRegion(degrees, e, w, h, src, sstride, dst, dstride, 0, y1, wt, h);
+}
+
+/* 180 degrees: every row is reversed into the mirrored row */
+SSSE3 static void rotate180_ssse3(int e, uint32_t w, uint32_t h,
+        const uint8_t *src, uint32_t sstride, uint8_t *dst, uint32_t dstride)
+{
+    const __m128i mask = e == 1 ?
+        _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0) :
+        _mm_setr_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1);
+    const uint32_t n = 16 / e;
+    const uint32_t x0 = w % n;   /* the target rows are written from their start */
+    uint32_t x, y;
+
+    for (y = 0; y < h; y++) {
+        const uint8_t *s = src + (size_t)y * sstride;
+        uint8_t *d = dst + (size_t)(h - 1 - y) * dstride;
+        for (x = x0; x < w; x += n) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(s + x * e));
+            _mm_storeu_si128((__m128i *)(d + (w - n - x) * e), _mm_shuffle_epi8(v, mask));
+        }
+    }
+    if (x0 > 0)
+        rotateRegion(180, e, w, h, src, sstride, dst, dstride, 0, 0, x0, h);
+}
+
+static void rotatePlane_ssse3(int degrees, int e, uint32_t w, uint32_t h,
+        const uint8_t *src, uint32_t sstride, uint8_t *dst, uint32_t dstride)
+{
+    if (degrees == 180)
+        rotate180_ssse3(e, w, h, src, sstride, dst, dstride);
+    else
+        rotateTiles(degrees, e, w, h, src, sstride, dst, dstride,
+                e == 1 ? tile_u8_ssse3 : tile_u16_ssse3, NULL);
+}
+
+static void rotatePlane_avx2(int degrees, int e, uint32_t w, uint32_t h,
+        const uint8_t *src, uint32_t sstride, uint8_t *dst, uint32_t dstride)
+{
+    if (degrees == 180)
+        rotate180_ssse3(e, w, h, src, sstride, dst, dstride);
+    else
+        rotateTiles(degrees, e, w, h, src, sstride, dst, dstride,
+                e == 1 ? tile_u8_ssse3 : tile_u16_ssse3,
+                e == 1 ? wideTile_u8_avx2 : wideTile_u16_avx2);
+}
+
+static const M4VIFI_NV12Kernels sKernelSets[M4VIFI_NV12_ISA_NUM] = {
+    [M4VIFI_NV12_ISA_SSSE3] = {
+        M4VIFI_NV12_ISA_SSSE3, "ssse3",
+        blendRows_ssse3, blendColumns_ssse3, blendPairs_ssse3,
+        deinterleave_ssse3, rotatePlane_ssse3, rgbToNV12_ssse3,
+    },
+    [M4VIFI_NV12_ISA_AVX2] = {
+        M4VIFI_NV12_ISA_AVX2, "avx2",
+        blendRows_ssse3, blendColumns_ssse3, blendPairs_ssse3,
+        deinterleave_ssse3, rotatePlane_avx2, rgbToNV12_ssse3,
+    },
+};
+
+#endif /* M4VIFI_NV12_X86 */
+
+static int isaSupported(int isa)
+{
+    switch (isa) {
+    case M4VIFI_NV12_ISA_C:
+        return 1;
+#ifdef M4VIFI_NV12_X86
+    case M4VIFI_NV12_ISA_SSSE3:
+        return __builtin_cpu_supports("ssse3");
+    case M4VIFI_NV12_ISA_AVX2:
+        /* the AVX2 set finishes rows with, and reuses, SSSE3 kernels */
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("ssse3");
+#endif
+    default:
+        return 0;
+    }
+}
+
+static const M4VIFI_NV12Kernels *kernelsOf(int isa)
+{
+#ifdef M4VIFI_NV12_X86
+    if (isa != M4VIFI_NV12_ISA_C)
+        return &sKernelSets[isa];
+#endif
+    return NULL;
+}
+
+static pthread_once_t sKernelsOnce = PTHREAD_ONCE_INIT;
+static const M4VIFI_NV12Kernels *sKernels = NULL;
+
+static void selectKernels(void)
+{
+    int isa;
+
+#ifdef M4VIFI_NV12_X86
+    __builtin_cpu_init();
+#endif
+    for (isa = M4VIFI_NV12_ISA_NUM - 1; isa > M4VIFI_NV12_ISA_C; isa--) {
+        if (isaSupported(isa))
+            break;
+    }
+    sKernels = kernelsOf(isa);
+    ALOGD("NV12 tools kernels: %s", sKernels ? sKernels->name : "c");
+}
+
+const M4VIFI_NV12Kernels *M4VIFI_NV12GetKernels(void)
+{
+    pthread_once(&sKernelsOnce, selectKernels);
+    return sKernels;
+}
+
+int M4VIFI_NV12SetIsa(int isa)
+{
+    pthread_once(&sKernelsOnce, selectKernels);
+    if (isa < 0 || isa >= M4VIFI_NV12_ISA_NUM || !isaSupported(isa))
+        return -1;
+    sKernels = kernelsOf(isa);
+    return 0;
+}
+
+int M4VIFI_NV12ResamplerInit(M4VIFI_NV12Resampler *r, const M4VIFI_NV12Kernels *k,
+        uint32_t count, uint32_t xaccum, uint32_t xinc, int interleaved)
+{
+    uint32_t i, last = 0;
+
+    memset(r, 0, sizeof(*r));
+    if (count == 0)
+        return -1;
+
+    r->kernels = k;
+    r->count = count;
+    r->interleaved = interleaved ? 1 : 0;
+    r->offsets = (uint32_t *)malloc(count * sizeof(uint32_t));
+    r->weights = (uint32_t *)malloc(count * sizeof(uint32_t));
+    if (r->offsets == NULL || r->weights == NULL)
+        goto fail;
+
+    for (i = 0; i < count; i++) {
+        uint32_t frac = (xaccum >> 12) & 15;
+        uint32_t o = interleaved ? (xaccum >> 16) << 1 : xaccum >> 16;
+
+        r->offsets[i] = o;
+        r->weights[i] = (16 - frac) | frac << 16;
+        if (o > last)
+            last = o;
+        xaccum += xinc;
+    }
+
+    /* the right neighbour of the last sample */
+    r->span = last + (interleaved ? 4 : 2);
+    r->rows = (uint16_t *)malloc(r->span * sizeof(uint16_t));
+    if (r->rows == NULL)
+        goto fail;
+    return 0;
+
+fail:
+    M4VIFI_NV12ResamplerDeinit(r);
+    return -1;
+}
+
+void M4VIFI_NV12ResamplerRow(const M4VIFI_NV12Resampler *r, const uint8_t *top,
+        uint32_t stride, uint32_t yfrac, uint8_t *out)
+{
+    const M4VIFI_NV12Kernels *k = r->kernels;
+
+    k->blendRows(top, top + stride, yfrac, r->rows, r->span);
+    if (r->interleaved)
+        k->blendPairs(r->rows, r->offsets, r->weights, out, r->count);
+    else
+        k->blendColumns(r->rows, r->offsets, r->weights, out, r->count);
+}
+
+void M4VIFI_NV12ResamplerDeinit(M4VIFI_NV12Resampler *r)
+{
+    free(r->offsets);
+    free(r->weights);
+    free(r->rows);
+    memset(r, 0, sizeof(*r));
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2014 Intel Corporation.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VIDEO_EDITOR_TOOLS_NV12_KERNELS_H
+#define VIDEO_EDITOR_TOOLS_NV12_KERNELS_H
+
+#include <stdint.h>
+
+/*
+ * SIMD kernels of the NV12 tools. The M4VIFI functions run them when the
+ * CPU supports one of the instruction sets below, and their own scalar
+ * loops otherwise. Every kernel gives the same bytes as the scalar loops.
+ */
+
+enum {
+    M4VIFI_NV12_ISA_C = 0,
+    M4VIFI_NV12_ISA_SSSE3,
+    M4VIFI_NV12_ISA_AVX2,
+    M4VIFI_NV12_ISA_NUM
+};
+
+typedef struct {
+    int isa;
+    const char *name;
+
+    /* rows[i] = top[i] * (16 - yfrac) + bottom[i] * yfrac, i < n */
+    void (*blendRows)(const uint8_t *top, const uint8_t *bottom,
+            uint32_t yfrac, uint16_t *rows, uint32_t n);
+
+    /* out[i] = (rows[o] * (16 - xfrac) + rows[o + 1] * xfrac) >> 8, with
+       o = offsets[i] and weights[i] = (16 - xfrac) | xfrac << 16, i < n */
+    void (*blendColumns)(const uint16_t *rows, const uint32_t *offsets,
+            const uint32_t *weights, uint8_t *out, uint32_t n);
+
+    /* same on n interleaved UV pairs: U from rows[o], rows[o + 2] and
+       V from rows[o + 1], rows[o + 3] */
+    void (*blendPairs)(const uint16_t *rows, const uint32_t *offsets,
+            const uint32_t *weights, uint8_t *out, uint32_t n);
+
+    /* splits n interleaved UV pairs */
+    void (*deinterleave)(const uint8_t *uv, uint8_t *u, uint8_t *v, uint32_t n);
+
+    /* rotates a w x h plane of 1 (luma) or 2 (UV) byte elements clockwise
+       by 90, 180 or 270 degrees, strides in bytes */
+    void (*rotatePlane)(int degrees, int elementSize, uint32_t w, uint32_t h,
+            const uint8_t *src, uint32_t sstride, uint8_t *dst, uint32_t dstride);
+
+    /* converts the first pixels of two rows of 3 byte R G B samples to two
+       luma rows and one row of UV pairs, as M4VIFI_RGB888toNV12. Returns
+       the number of pixels done, a multiple of 8 up to n */
+    uint32_t (*rgbToNV12)(const uint8_t *rgb, uint32_t rgbStride,
+            uint8_t *y, uint32_t yStride, uint8_t *uv, uint32_t n);
+} M4VIFI_NV12Kernels;
+
+/* Kernels for the CPU, picked on first use. NULL if the scalar loops
+   must be used. */
+const M4VIFI_NV12Kernels *M4VIFI_NV12GetKernels(void);
+
+/* Forces the kernels of an instruction set, for tests and benchmarks.
+   Returns -1 if the CPU or the build does not support it. */
+int M4VIFI_NV12SetIsa(int isa);
+
+/*
+ * Bilinear resampling of rows with the kernels. The horizontal positions
+ * of a scaled row are the same for every row, they are computed once:
+ * each output row is a vertical blend of two input rows followed by a
+ * horizontal blend at these positions, which adds the same products as
+ * the scalar loops.
+ */
+typedef struct {
+    const M4VIFI_NV12Kernels *kernels;
+    uint32_t count;         /* output samples (or UV pairs) per row */
+    uint32_t interleaved;   /* interleaved UV pairs */
+    uint32_t span;          /* input bytes read per row */
+    uint32_t *offsets;
+    uint32_t *weights;
+    uint16_t *rows;
+} M4VIFI_NV12Resampler;
+
+/* Positions of @count samples from the 16.16 accumulator @xaccum stepping
+   by @xinc. Returns -1 on allocation failure. */
+int M4VIFI_NV12ResamplerInit(M4VIFI_NV12Resampler *r, const M4VIFI_NV12Kernels *k,
+        uint32_t count, uint32_t xaccum, uint32_t xinc, int interleaved);
+
+/* One output row from the input rows @top and @top + @stride */
+void M4VIFI_NV12ResamplerRow(const M4VIFI_NV12Resampler *r, const uint8_t *top,
+        uint32_t stride, uint32_t yfrac, uint8_t *out);
+
+void M4VIFI_NV12ResamplerDeinit(M4VIFI_NV12Resampler *r);
+
+#endif
@@ -0,0 +1,58 @@
+LOCAL_PATH := $(call my-dir)
+
+# check and benchmark of the NV12 tools kernels
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := VideoEditorToolsNV12Test.c
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/.. \
+    $(call include-path-for, osal) \
+    $(call include-path-for, vss-common) \
+    $(call include-path-for, vss-mcs) \
+    $(call include-path-for, vss) \
+    $(call include-path-for, vss-stagefrightshells) \
+    $(call include-path-for, lvpp)
+
+LOCAL_STATIC_LIBRARIES := \
+    liblvpp_intel \
+    libvideoeditor_videofilters
+
+LOCAL_SHARED_LIBRARIES := \
+    libcutils \
+    libutils \
+    liblog \
+    libvideoeditor_osal
+
+LOCAL_MODULE := lvpp_nv12_test
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_EXECUTABLE)
+
+# same check and benchmark on the build host, the OSAL and filters
+# functions the tools use are stubbed
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    VideoEditorToolsNV12Test.c \
+    VideoEditorToolsNV12HostStubs.c \
+    ../VideoEditorToolsNV12.c \
+    ../VideoEditorToolsNV12Kernels.c
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/.. \
+    $(call include-path-for, osal) \
+    $(call include-path-for, vss-common) \
+    $(call include-path-for, vss-mcs) \
+    $(call include-path-for, vss) \
+    $(call include-path-for, vss-stagefrightshells) \
+    $(call include-path-for, lvpp)
+
+LOCAL_STATIC_LIBRARIES := liblog
+
+LOCAL_LDLIBS := -lpthread -lrt
+
+LOCAL_MODULE := lvpp_nv12_test_host
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2014 Intel Corporation.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * What the NV12 tools take from the video editor OSAL and filters
+ * libraries, which are only built for the target, for lvpp_nv12_test_host.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "VideoEditorToolsNV12.h"
+
+/* saturates x in [-CLIP_RANGE, 255 + CLIP_RANGE], Y24 alone reaches 1472 */
+#define CLIP_RANGE 2048
+
+static M4VIFI_UInt8 sClipTable[CLIP_RANGE + 256 + CLIP_RANGE];
+
+CNST M4VIFI_UInt8 *M4VIFI_ClipTable_zero = sClipTable + CLIP_RANGE;
+
+static void __attribute__((constructor)) initClipTable(void)
+{
+    int i;
+
+    for (i = 0; i < (int)sizeof(sClipTable); i++) {
+        int x = i - CLIP_RANGE;
+        sClipTable[i] = (M4VIFI_UInt8)(x < 0 ? 0 : x > 255 ? 255 : x);
+    }
+}
+
+M4OSA_MemAddr32 M4OSA_32bitAlignedMalloc(M4OSA_UInt32 size, M4OSA_CoreID coreID,
+    M4OSA_Char *string)
+{
+    return (M4OSA_MemAddr32)malloc(size);
+}
+
+/* only called by the resize functions when the size does not change */
+M4VIFI_UInt8 M4VIFI_YUV420toYUV420(void *pUserData,
+    M4VIFI_ImagePlane *pPlaneIn, M4VIFI_ImagePlane *pPlaneOut)
+{
+    int p;
+    M4VIFI_UInt32 y;
+
+    for (p = 0; p < 3; p++) {
+        for (y = 0; y < pPlaneOut[p].u_height; y++)
+            memcpy(pPlaneOut[p].pac_data + pPlaneOut[p].u_topleft + y * pPlaneOut[p].u_stride,
+                pPlaneIn[p].pac_data + pPlaneIn[p].u_topleft + y * pPlaneIn[p].u_stride,
+                pPlaneOut[p].u_width);
+    }
+    return M4VIFI_OK;
+}
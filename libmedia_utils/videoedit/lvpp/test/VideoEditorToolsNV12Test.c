@@ -0,0 +1,441 @@
+/*
+ * Copyright (C) 2014 Intel Corporation.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Test and benchmark of the SIMD kernels of the NV12 tools.
+ *
+ * The M4VIFI functions are run with every instruction set the CPU
+ * supports, on geometries with and without padding and with sizes which
+ * do not fill the SIMD registers. Their output must be the same bytes as
+ * the scalar loops, bytes outside the images untouched. The scalar output
+ * of the resize and rotation cases is also checked against golden CRCs of
+ * fixed input images, so that a change of the scalar loops is caught too.
+ * Then each set is timed on 720p and 1080p frames scaled to preview sizes,
+ * on 1080p rotations and on RGB888 conversions.
+ *
+ * lvpp_nv12_test_host is the same on the build host.
+ *
+ * usage: lvpp_nv12_test [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "VideoEditorToolsNV12.h"
+#include "VideoEditorToolsNV12Kernels.h"
+
+#define FILL 0xa5   /* bytes outside the images */
+
+typedef M4VIFI_UInt8 (*Filter)(void *pUserData,
+    M4VIFI_ImagePlane *pPlaneIn, M4VIFI_ImagePlane *pPlaneOut);
+
+enum { FORMAT_NV12, FORMAT_YUV420, FORMAT_BGR565, FORMAT_RGB24 };
+
+typedef struct {
+    M4VIFI_ImagePlane plane[3];
+    M4VIFI_UInt8 *data;
+    size_t size;
+} Image;
+
+static const char *isaName[M4VIFI_NV12_ISA_NUM] = { "c", "ssse3", "avx2" };
+static int errors;
+
+static long long nowNs(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static unsigned int crc32(const M4VIFI_UInt8 *p, size_t n)
+{
+    unsigned int crc = 0xffffffff;
+    size_t i;
+    int b;
+
+    for (i = 0; i < n; i++) {
+        crc ^= p[i];
+        for (b = 0; b < 8; b++)
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+    }
+    return ~crc;
+}
+
+static void setPlane(M4VIFI_ImagePlane *plane, M4VIFI_UInt8 *data,
+    M4VIFI_UInt32 w, M4VIFI_UInt32 h, M4VIFI_UInt32 stride)
+{
+    plane->pac_data = data;
+    plane->u_width = w;
+    plane->u_height = h;
+    plane->u_stride = stride;
+    plane->u_topleft = 0;
+}
+
+/* @w x @h image, @pad bytes at the end of the rows */
+static void imageInit(Image *img, int format, M4VIFI_UInt32 w, M4VIFI_UInt32 h,
+    M4VIFI_UInt32 pad)
+{
+    M4VIFI_UInt32 stride;
+
+    memset(img, 0, sizeof(*img));
+    switch (format) {
+    case FORMAT_NV12:
+        stride = w + pad;
+        img->size = stride * h * 3 / 2;
+        img->data = malloc(img->size);
+        setPlane(&img->plane[0], img->data, w, h, stride);
+        setPlane(&img->plane[1], img->data + stride * h, w, h / 2, stride);
+        break;
+    case FORMAT_YUV420:
+        stride = w + pad;
+        img->size = stride * h * 3 / 2;
+        img->data = malloc(img->size);
+        setPlane(&img->plane[0], img->data, w, h, stride);
+        setPlane(&img->plane[1], img->data + stride * h, w / 2, h / 2, stride / 2);
+        setPlane(&img->plane[2], img->data + stride * h * 5 / 4, w / 2, h / 2, stride / 2);
+        break;
+    case FORMAT_RGB24:
+        stride = w * 3 + pad;
+        img->size = stride * h;
+        img->data = malloc(img->size);
+        setPlane(&img->plane[0], img->data, w, h, stride);
+        break;
+    default: /* FORMAT_BGR565 */
+        stride = (w * 2 + pad + 3) & ~3;
+        img->size = stride * h;
+        img->data = malloc(img->size);
+        setPlane(&img->plane[0], img->data, w, h, stride);
+        break;
+    }
+    memset(img->data, FILL, img->size);
+}
+
+static void imageFree(Image *img)
+{
+    free(img->data);
+    img->data = NULL;
+}
+
+/* the same pseudo random image on every run: a gradient and noise */
+static void imageFill(Image *img, unsigned int seed)
+{
+    size_t i;
+
+    for (i = 0; i < img->size; i++) {
+        seed = seed * 1103515245 + 12345;
+        img->data[i] = (M4VIFI_UInt8)(i / 7 + ((seed >> 16) & 63));
+    }
+}
+
+/*
+ * Runs @filter with every instruction set on @in. Returns the CRC of the
+ * scalar output, 0 if it does not return M4VIFI_OK.
+ */
+static unsigned int checkFilter(const char *what, Filter filter, Image *in,
+    int format, M4VIFI_UInt32 w, M4VIFI_UInt32 h, M4VIFI_UInt32 pad)
+{
+    Image expected, result;
+    unsigned int crc = 0;
+    int isa;
+
+    imageInit(&expected, format, w, h, pad);
+    M4VIFI_NV12SetIsa(M4VIFI_NV12_ISA_C);
+    if (filter(NULL, in->plane, expected.plane) != M4VIFI_OK) {
+        printf("%s: scalar filter failed\n", what);
+        errors++;
+        imageFree(&expected);
+        return 0;
+    }
+    crc = crc32(expected.data, expected.size);
+
+    for (isa = M4VIFI_NV12_ISA_C + 1; isa < M4VIFI_NV12_ISA_NUM; isa++) {
+        if (M4VIFI_NV12SetIsa(isa) != 0)
+            continue;   /* not supported here */
+        imageInit(&result, format, w, h, pad);
+        if (filter(NULL, in->plane, result.plane) != M4VIFI_OK ||
+            memcmp(expected.data, result.data, expected.size)) {
+            size_t i = 0;
+            while (i < expected.size && expected.data[i] == result.data[i])
+                i++;
+            printf("%s: %s differs at byte %u of %u\n", what, isaName[isa],
+                (unsigned)i, (unsigned)expected.size);
+            errors++;
+        }
+        imageFree(&result);
+    }
+
+    M4VIFI_NV12SetIsa(M4VIFI_NV12_ISA_C);
+    imageFree(&expected);
+    return crc;
+}
+
+static void checkGolden(const char *what, unsigned int crc, unsigned int golden)
+{
+    if (crc != golden) {
+        printf("%s: crc %08x, golden %08x\n", what, crc, golden);
+        errors++;
+    }
+}
+
+typedef struct {
+    M4VIFI_UInt32 win, hin, inPad;
+    M4VIFI_UInt32 wout, hout, outPad;
+    unsigned int golden;    /* CRC of the NV12 output */
+    unsigned int goldenYUV; /* CRC of the YUV420 output, without input padding */
+} ResizeCase;
+
+static void testResize(void)
+{
+    static const ResizeCase cases[] = {
+        /* preview sizes */
+        { 1280, 720, 0, 640, 360, 0, 0x95d73b78, 0x84e10809 },
+        { 1280, 720, 0, 854, 480, 10, 0x706bdd22, 0xb4168dc9 },
+        { 1920, 1080, 0, 640, 360, 0, 0x3070f8c6, 0xa66b504a },
+        { 1920, 1080, 64, 960, 540, 32, 0xfb5602ac, 0x00000000 },
+        { 1920, 1088, 0, 1280, 720, 0, 0x3b92a858, 0x530e770c },
+        /* upscales */
+        { 640, 360, 0, 1280, 720, 0, 0xade16fe1, 0xd2539949 },
+        { 176, 144, 16, 352, 288, 8, 0x5a43195a, 0x00000000 },
+        /* one dimension kept, the last column or row is replicated */
+        { 320, 240, 0, 320, 180, 0, 0xfa73ee11, 0x0fda094b },
+        { 320, 240, 0, 240, 240, 4, 0xc6fbcc3f, 0x8c19d70f },
+        /* sizes which do not fill the registers */
+        { 34, 18, 6, 22, 10, 2, 0xd8e84fa2, 0x00000000 },
+        { 100, 66, 28, 62, 38, 14, 0xb6c9d796, 0x00000000 },
+    };
+    char what[96];
+    size_t c;
+
+    for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        const ResizeCase *rc = &cases[c];
+        Image in;
+        unsigned int crc;
+
+        imageInit(&in, FORMAT_NV12, rc->win, rc->hin, rc->inPad);
+        imageFill(&in, c + 1);
+
+        snprintf(what, sizeof(what), "resize NV12 %ux%u to NV12 %ux%u",
+            rc->win, rc->hin, rc->wout, rc->hout);
+        crc = checkFilter(what, M4VIFI_ResizeBilinearNV12toNV12, &in,
+            FORMAT_NV12, rc->wout, rc->hout, rc->outPad);
+        checkGolden(what, crc, rc->golden);
+
+        /* the planar conversions only take rows without padding */
+        if (rc->inPad != 0) {
+            imageFree(&in);
+            continue;
+        }
+
+        snprintf(what, sizeof(what), "resize NV12 %ux%u to YUV420 %ux%u",
+            rc->win, rc->hin, rc->wout, rc->hout);
+        crc = checkFilter(what, M4VIFI_ResizeBilinearNV12toYUV420, &in,
+            FORMAT_YUV420, rc->wout, rc->hout, rc->outPad);
+        checkGolden(what, crc, rc->goldenYUV);
+
+        /*
+         The colour conversion is the one of the video editor filters, its
+         output is only compared between the instruction sets
+        */
+        snprintf(what, sizeof(what), "resize NV12 %ux%u to BGR565 %ux%u",
+            rc->win, rc->hin, rc->wout, rc->hout);
+        checkFilter(what, M4VIFI_ResizeBilinearNV12toBGR565, &in,
+            FORMAT_BGR565, rc->wout, rc->hout, rc->outPad);
+
+        imageFree(&in);
+    }
+}
+
+typedef struct {
+    M4VIFI_UInt32 width, height, inPad, outPad;
+    unsigned int golden[3]; /* CRC of the output, left, right and 180 */
+} RotateCase;
+
+static void testRotate(void)
+{
+    static const RotateCase cases[] = {
+        { 2, 2, 0, 0, { 0x1ae57248, 0x154668e9, 0xcea4395f } },
+        { 16, 16, 0, 0, { 0xaa188b46, 0x5ce581e8, 0x2e04751c } },
+        { 18, 10, 0, 0, { 0xeb8ca2ab, 0x76b03cb3, 0xe6856268 } },
+        { 34, 50, 6, 2, { 0xfe880ba3, 0xda0733dc, 0x63a6360c } },
+        { 100, 66, 28, 14, { 0x66d71ab8, 0xa61d4230, 0x6733f219 } },
+        { 176, 144, 0, 0, { 0x5fef5472, 0x13b11c20, 0xb81a0b6e } },
+        { 352, 288, 160, 224, { 0x3259b3c7, 0xe5972f64, 0x1c67d683 } },
+        { 1280, 720, 0, 48, { 0xd060d07e, 0xed8c6354, 0x450005ca } },
+        { 1920, 1080, 0, 8, { 0x0393a635, 0x4cdd279e, 0xa51938d5 } },
+    };
+    static const Filter filters[3] = {
+        M4VIFI_Rotate90LeftNV12toNV12,
+        M4VIFI_Rotate90RightNV12toNV12,
+        M4VIFI_Rotate180NV12toNV12,
+    };
+    static const char *names[3] = { "left", "right", "180" };
+    char what[96];
+    size_t c;
+    int r;
+
+    for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        const RotateCase *rc = &cases[c];
+        Image in;
+
+        imageInit(&in, FORMAT_NV12, rc->width, rc->height, rc->inPad);
+        imageFill(&in, c + 100);
+
+        for (r = 0; r < 3; r++) {
+            M4VIFI_UInt32 w = r == 2 ? rc->width : rc->height;
+            M4VIFI_UInt32 h = r == 2 ? rc->height : rc->width;
+            unsigned int crc;
+
+            snprintf(what, sizeof(what), "rotate %s %ux%u", names[r],
+                rc->width, rc->height);
+            crc = checkFilter(what, filters[r], &in, FORMAT_NV12, w, h, rc->outPad);
+            checkGolden(what, crc, rc->golden[r]);
+        }
+
+        imageFree(&in);
+    }
+}
+
+/*
+ The colour conversion macros come from the video editor filters, like the
+ one of the BGR565 outputs its output is only compared between the
+ instruction sets
+*/
+static void testRGB888(void)
+{
+    static const M4VIFI_UInt32 sizes[][3] = {
+        /* width, height, padding of the rows */
+        { 2, 2, 0 }, { 8, 2, 0 }, { 18, 4, 3 }, { 62, 38, 14 },
+        { 176, 144, 0 }, { 640, 360, 7 }, { 1280, 720, 0 },
+    };
+    char what[96];
+    size_t c;
+
+    for (c = 0; c < sizeof(sizes) / sizeof(sizes[0]); c++) {
+        const M4VIFI_UInt32 *sz = sizes[c];
+        Image in;
+
+        imageInit(&in, FORMAT_RGB24, sz[0], sz[1], sz[2]);
+        imageFill(&in, c + 200);
+        snprintf(what, sizeof(what), "RGB888 %ux%u to NV12", sz[0], sz[1]);
+        checkFilter(what, M4VIFI_RGB888toNV12, &in, FORMAT_NV12, sz[0], sz[1], sz[2]);
+        imageFree(&in);
+    }
+}
+
+/* in place rotations by 180 degrees are left to the scalar loops */
+static void testRotate180InPlace(void)
+{
+    Image in, expected;
+    int isa;
+
+    imageInit(&in, FORMAT_NV12, 176, 144, 16);
+    imageInit(&expected, FORMAT_NV12, 176, 144, 16);
+    imageFill(&in, 7);
+    memcpy(expected.data, in.data, in.size);
+    M4VIFI_NV12SetIsa(M4VIFI_NV12_ISA_C);
+    M4VIFI_Rotate180NV12toNV12(NULL, expected.plane, expected.plane);
+
+    for (isa = M4VIFI_NV12_ISA_C + 1; isa < M4VIFI_NV12_ISA_NUM; isa++) {
+        if (M4VIFI_NV12SetIsa(isa) != 0)
+            continue;
+        imageFill(&in, 7);
+        M4VIFI_Rotate180NV12toNV12(NULL, in.plane, in.plane);
+        if (memcmp(expected.data, in.data, in.size)) {
+            printf("rotate 180 in place: %s differs\n", isaName[isa]);
+            errors++;
+        }
+    }
+
+    M4VIFI_NV12SetIsa(M4VIFI_NV12_ISA_C);
+    imageFree(&in);
+    imageFree(&expected);
+}
+
+static void benchmarkFilter(const char *what, Filter filter, int iterations,
+    M4VIFI_UInt32 win, M4VIFI_UInt32 hin, int format,
+    M4VIFI_UInt32 wout, M4VIFI_UInt32 hout)
+{
+    Image in, out;
+    int isa, i;
+
+    imageInit(&in, filter == M4VIFI_RGB888toNV12 ? FORMAT_RGB24 : FORMAT_NV12, win, hin, 0);
+    imageFill(&in, 1);
+    imageInit(&out, format, wout, hout, 0);
+
+    for (isa = 0; isa < M4VIFI_NV12_ISA_NUM; isa++) {
+        long long start, ns;
+
+        if (M4VIFI_NV12SetIsa(isa) != 0)
+            continue;
+        filter(NULL, in.plane, out.plane);
+        start = nowNs();
+        for (i = 0; i < iterations; i++)
+            filter(NULL, in.plane, out.plane);
+        ns = (nowNs() - start) / iterations;
+        printf("  %-36s %-6s %7.3f ms/frame\n", what, isaName[isa], ns / 1e6);
+    }
+
+    M4VIFI_NV12SetIsa(M4VIFI_NV12_ISA_C);
+    imageFree(&in);
+    imageFree(&out);
+}
+
+static void benchmark(int iterations)
+{
+    printf("%d iterations\n", iterations);
+    benchmarkFilter("NV12 720p to NV12 640x360", M4VIFI_ResizeBilinearNV12toNV12,
+        iterations, 1280, 720, FORMAT_NV12, 640, 360);
+    benchmarkFilter("NV12 1080p to NV12 640x360", M4VIFI_ResizeBilinearNV12toNV12,
+        iterations, 1920, 1080, FORMAT_NV12, 640, 360);
+    benchmarkFilter("NV12 1080p to NV12 960x540", M4VIFI_ResizeBilinearNV12toNV12,
+        iterations, 1920, 1080, FORMAT_NV12, 960, 540);
+    benchmarkFilter("NV12 720p to NV12 1080p", M4VIFI_ResizeBilinearNV12toNV12,
+        iterations, 1280, 720, FORMAT_NV12, 1920, 1080);
+    benchmarkFilter("NV12 720p to BGR565 640x360", M4VIFI_ResizeBilinearNV12toBGR565,
+        iterations, 1280, 720, FORMAT_BGR565, 640, 360);
+    benchmarkFilter("NV12 1080p to BGR565 854x480", M4VIFI_ResizeBilinearNV12toBGR565,
+        iterations, 1920, 1080, FORMAT_BGR565, 854, 480);
+    benchmarkFilter("NV12 1080p to YUV420 640x360", M4VIFI_ResizeBilinearNV12toYUV420,
+        iterations, 1920, 1080, FORMAT_YUV420, 640, 360);
+    benchmarkFilter("NV12 1080p rotate left", M4VIFI_Rotate90LeftNV12toNV12,
+        iterations, 1920, 1080, FORMAT_NV12, 1080, 1920);
+    benchmarkFilter("NV12 1080p rotate right", M4VIFI_Rotate90RightNV12toNV12,
+        iterations, 1920, 1080, FORMAT_NV12, 1080, 1920);
+    benchmarkFilter("NV12 1080p rotate 180", M4VIFI_Rotate180NV12toNV12,
+        iterations, 1920, 1080, FORMAT_NV12, 1920, 1080);
+    benchmarkFilter("RGB888 720p to NV12", M4VIFI_RGB888toNV12,
+        iterations, 1280, 720, FORMAT_NV12, 1280, 720);
+    benchmarkFilter("RGB888 1080p to NV12", M4VIFI_RGB888toNV12,
+        iterations, 1920, 1080, FORMAT_NV12, 1920, 1080);
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 50;
+
+    testResize();
+    testRotate();
+    testRotate180InPlace();
+    testRGB888();
+
+    if (iterations > 0)
+        benchmark(iterations);
+
+    printf("%s\n", errors ? "FAILED" : "PASSED");
+    return errors ? 1 : 0;
+}
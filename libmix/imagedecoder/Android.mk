@@ -73,6 +73,36 @@ LOCAL_MODULE_TAGS := optional
 include $(BUILD_EXECUTABLE)
 endif
 
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES += \
+    test/testscans.cpp
+LOCAL_C_INCLUDES += \
+    $(TARGET_OUT_HEADERS)/libva
+LOCAL_SHARED_LIBRARIES += \
+    libcutils \
+    libutils \
+    libva-android     \
+    libva             \
+    libva-tpi         \
+    libmix_imagedecoder        \
+    libhardware
+LOCAL_CFLAGS += -Wno-multichar
+LOCAL_MODULE:= testjpegscans
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES += \
+    JPEGParser.cpp \
+    test/testparser.cpp
+LOCAL_STATIC_LIBRARIES += \
+    libutils \
+    libcutils \
+    liblog
+LOCAL_MODULE:= testjpegparser
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_HOST_EXECUTABLE)
+
 include $(CLEAR_VARS)
 LOCAL_SRC_FILES += \
     JPEGDecoder_libjpeg_wrapper.cpp
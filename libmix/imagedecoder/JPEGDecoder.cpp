@@ -331,6 +331,8 @@ JpegDecodeStatus JpegDecoder::parseHeader(JpegInfo &jpginfo)
 
     uint8_t marker;
     uint32_t rollbackoff;
+    // Huffman tables (bit class * 16 + id) selected by the scans parsed so far
+    uint32_t huffman_in_use = 0;
     rollbackoff = mBsParser->getByteOffset();
     ROLLBACK_IF_FAIL(mBsParser->tryGetNextMarker(&marker));
 
@@ -351,11 +353,7 @@ JpegDecodeStatus JpegDecoder::parseHeader(JpegInfo &jpginfo)
                     memset(data, 0, sizeof data);
                     ROLLBACK_IF_FAIL(mBsParser->tryReadBytes(&len, 2));
                     ROLLBACK_IF_FAIL(mBsParser->getRemainingBytes() >= len);
-                    mBsParser->tryReadNextByte(&data[0]);
-                    mBsParser->tryReadNextByte(&data[1]);
-                    mBsParser->tryReadNextByte(&data[2]);
-                    mBsParser->tryReadNextByte(&data[3]);
-                    mBsParser->tryReadNextByte(&data[4]);
+                    mBsParser->tryCopyBytes(data, sizeof data);
                     if (data[0] == 0x4A &&
                         data[1] == 0x46 &&
                         data[2] == 0x49 &&
@@ -393,11 +391,7 @@ JpegDecodeStatus JpegDecoder::parseHeader(JpegInfo &jpginfo)
                     memset(data, 0, sizeof data);
                     ROLLBACK_IF_FAIL(mBsParser->tryReadBytes(&len, 2));
                     ROLLBACK_IF_FAIL(mBsParser->getRemainingBytes() >= 12);
-                    mBsParser->tryReadNextByte(&data[0]);
-                    mBsParser->tryReadNextByte(&data[1]);
-                    mBsParser->tryReadNextByte(&data[2]);
-                    mBsParser->tryReadNextByte(&data[3]);
-                    mBsParser->tryReadNextByte(&data[4]);
+                    mBsParser->tryCopyBytes(data, sizeof data);
                     if (data[0] == 0x41 &&
                         data[1] == 0x64 &&
                         data[2] == 0x6F &&
@@ -421,17 +415,17 @@ JpegDecodeStatus JpegDecoder::parseHeader(JpegInfo &jpginfo)
             // Store offset to DQT data to avoid parsing bitstream in user mode
             case CODE_DQT: {
                 VTRACE("%s DQT at 0x%08x", __FUNCTION__, mBsParser->getByteOffset());
-                //if (jpginfo.dqt_ind < 4) {
-                jpginfo.dqt_byte_offset[jpginfo.dqt_ind] = mBsParser->getByteOffset() - jpginfo.soi_offset;
-                jpginfo.dqt_ind++;
+                if (jpginfo.dqt_ind >= sizeof(jpginfo.dqt_byte_offset) / sizeof(jpginfo.dqt_byte_offset[0])) {
+                    ETRACE("ERROR: Decoder does not support more than %zu DQT markers\n",
+                        sizeof(jpginfo.dqt_byte_offset) / sizeof(jpginfo.dqt_byte_offset[0]));
+                    return JD_QUANTTABLE_NUM_UNSUPPORTED;
+                }
+                uint32_t dqt_offset = mBsParser->getByteOffset() - jpginfo.soi_offset;
                 uint32_t bytes_to_burn;
                 ROLLBACK_IF_FAIL(mBsParser->tryReadBytes(&bytes_to_burn, 2));
                 bytes_to_burn -= 2;
                 ROLLBACK_IF_FAIL(mBsParser->tryBurnBytes(bytes_to_burn));
-                //} else {
-                //    ETRACE("ERROR: Decoder does not support more than 4 Quant Tables\n");
-                //    return JD_CODEC_UNSUPPORTED;
-                //}
+                jpginfo.dqt_byte_offset[jpginfo.dqt_ind++] = dqt_offset;
                 jpginfo.dqt_parsed = true;
                 break;
             }
@@ -528,38 +522,73 @@ JpegDecodeStatus JpegDecoder::parseHeader(JpegInfo &jpginfo)
             }
             case CODE_DHT: {
                 VTRACE("%s DHT at 0x%08x", __FUNCTION__, mBsParser->getByteOffset());
-                //if (jpginfo.dht_ind < 4) {
-                jpginfo.dht_byte_offset[jpginfo.dht_ind] = mBsParser->getByteOffset() - jpginfo.soi_offset;
-                jpginfo.dht_ind++;
+                if (jpginfo.dht_ind >= sizeof(jpginfo.dht_byte_offset) / sizeof(jpginfo.dht_byte_offset[0])) {
+                    ETRACE("ERROR: Decoder does not support more than %zu DHT markers\n",
+                        sizeof(jpginfo.dht_byte_offset) / sizeof(jpginfo.dht_byte_offset[0]));
+                    return JD_HUFFTABLE_NUM_UNSUPPORTED;
+                }
+                uint32_t dht_offset = mBsParser->getByteOffset() - jpginfo.soi_offset;
                 uint32_t bytes_to_burn;
                 if (!mBsParser->tryReadBytes(&bytes_to_burn, 2)) {
                     VTRACE("%s failed to read 2 bytes from 0x%08x, remaining 0x%08x, total 0x%08x",
                         __FUNCTION__, mBsParser->getByteOffset(),
                         mBsParser->getRemainingBytes(), jpginfo.bufsize);
-                    jpginfo.dht_ind--;
                     goto rollback;
                 }
                 bytes_to_burn -= 2;
+                if (huffman_in_use) {
+                    // All the tables are loaded once per picture, a table can't change
+                    // after a scan that selects it
+                    ROLLBACK_IF_FAIL((mBsParser->getRemainingBytes() >= bytes_to_burn));
+                    uint32_t dht_end = mBsParser->getByteOffset() + bytes_to_burn;
+                    while (mBsParser->getByteOffset() + 17 <= dht_end) {
+                        uint8_t table_info;
+                        uint8_t num_codes[16];
+                        ROLLBACK_IF_FAIL(mBsParser->tryReadNextByte(&table_info));
+                        ROLLBACK_IF_FAIL(mBsParser->tryCopyBytes(num_codes, sizeof num_codes));
+                        uint32_t table_class = table_info >> 4;
+                        uint32_t table_id = table_info & 0xf;
+                        if (table_class < TABLE_CLASS_NUM &&
+                            (huffman_in_use & (1u << (table_class * 16 + table_id)))) {
+                            ETRACE("ERROR: Huffman table %u/%u redefined after a scan using it\n",
+                                table_class, table_id);
+                            return JD_ERROR_BITSTREAM;
+                        }
+                        uint32_t table_entries = 0;
+                        for (uint32_t bit_ind = 0; bit_ind < 16; bit_ind++)
+                            table_entries += num_codes[bit_ind];
+                        if (mBsParser->getByteOffset() + table_entries > dht_end) {
+                            ETRACE("ERROR: DHT at 0x%08x is truncated\n", dht_offset);
+                            return JD_ERROR_BITSTREAM;
+                        }
+                        ROLLBACK_IF_FAIL(mBsParser->tryBurnBytes(table_entries));
+                    }
+                    bytes_to_burn = dht_end - mBsParser->getByteOffset();
+                }
                 if (!mBsParser->tryBurnBytes(bytes_to_burn)) {
                     VTRACE("%s failed to burn %x bytes from 0x%08x, remaining 0x%08x, total 0x%08x",
                         __FUNCTION__, bytes_to_burn, mBsParser->getByteOffset(),
                         mBsParser->getRemainingBytes(), jpginfo.bufsize);
-                    jpginfo.dht_ind--;
                     goto rollback;
                 }
-                //} else {
-                //    ETRACE("ERROR: Decoder does not support more than 4 Huff Tables\n");
-                //    return JD_ERROR_BITSTREAM;
-                //}
+                jpginfo.dht_byte_offset[jpginfo.dht_ind++] = dht_offset;
                 jpginfo.dht_parsed = true;
                 break;
             }
             // Parse component information in SOS marker
             case CODE_SOS: {
                 VTRACE("%s SOS at 0x%08x", __FUNCTION__, mBsParser->getByteOffset());
+                if (jpginfo.scan_ind >= JPEG_MAX_COMPONENTS) {
+                    ETRACE("ERROR: Decoder does not support more than %d scans\n", JPEG_MAX_COMPONENTS);
+                    return JD_ERROR_BITSTREAM;
+                }
                 ROLLBACK_IF_FAIL(mBsParser->tryBurnBytes(2));
                 uint8_t component_in_scan;
                 ROLLBACK_IF_FAIL(mBsParser->tryReadNextByte(&component_in_scan));
+                if (component_in_scan > JPEG_MAX_COMPONENTS) {
+                    ETRACE("ERROR: %u components in scan\n", component_in_scan);
+                    return JD_ERROR_BITSTREAM;
+                }
                 uint8_t comp_ind = 0;
                 ROLLBACK_IF_FAIL((mBsParser->getRemainingBytes() >= (uint32_t)(2 * component_in_scan + 3)));
                 for (comp_ind = 0; comp_ind < component_in_scan; comp_ind++) {
@@ -576,6 +605,7 @@ JpegDecodeStatus JpegDecoder::parseHeader(JpegInfo &jpginfo)
                     ROLLBACK_IF_FAIL(mBsParser->tryReadNextByte(&huffman_tables));
                     jpginfo.slice_param_buf[jpginfo.scan_ind].components[comp_ind].dc_table_selector = huffman_tables >> 4;
                     jpginfo.slice_param_buf[jpginfo.scan_ind].components[comp_ind].ac_table_selector = huffman_tables & 0xf;
+                    huffman_in_use |= (1u << (huffman_tables >> 4)) | (1u << (16 + (huffman_tables & 0xf)));
                 }
                 uint8_t curr_byte;
                 ROLLBACK_IF_FAIL(mBsParser->tryReadNextByte(&curr_byte)); // Ss
@@ -613,6 +643,10 @@ JpegDecodeStatus JpegDecoder::parseHeader(JpegInfo &jpginfo)
                 ROLLBACK_IF_FAIL(mBsParser->tryReadBytes(&size, 2));
                 uint32_t ri;
                 ROLLBACK_IF_FAIL(mBsParser->tryReadBytes(&ri, 2));
+                if (jpginfo.scan_ind >= JPEG_MAX_COMPONENTS) {
+                    ETRACE("ERROR: DRI after scan %d, decoder does not support more scans\n", JPEG_MAX_COMPONENTS);
+                    return JD_ERROR_BITSTREAM;
+                }
                 jpginfo.slice_param_buf[jpginfo.scan_ind].restart_interval = ri;
                 ROLLBACK_IF_FAIL(mBsParser->tryBurnBytes(size - 4));
                 jpginfo.dri_parsed = true;
@@ -682,10 +716,6 @@ JpegDecodeStatus JpegDecoder::parseHeader(JpegInfo &jpginfo)
                 return JD_SUCCESS;
             }
         }
-        else if (marker == 0) {
-            VTRACE("%s: got non-marker %x at offset 0x%08x", __FUNCTION__, marker, mBsParser->getByteOffset());
-            return JD_SUCCESS;
-        }
 
         // If the EOI code is found, store the byte offset before the parsing finishes
         if( marker == CODE_EOI ) {
@@ -1180,10 +1210,7 @@ JpegDecodeStatus JpegDecoder::parseTableData(JpegInfo &jpginfo) {
 
             if (table_id < JPEG_MAX_QUANT_TABLES) {
                 // Pull Quant table data from bitstream
-                uint32_t byte_ind;
-                for (byte_ind = 0; byte_ind < table_length; byte_ind++) {
-                    REPORT_BS_ERR_IF_FAIL(mBsParser->tryReadNextByte(&jpginfo.qmatrix_buf.quantiser_table[table_id][byte_ind]));
-                }
+                REPORT_BS_ERR_IF_FAIL(mBsParser->tryCopyBytes(jpginfo.qmatrix_buf.quantiser_table[table_id], table_length));
             } else {
                 ETRACE("%s DQT table ID is not supported", __FUNCTION__);
                 REPORT_BS_ERR_IF_FAIL(mBsParser->tryBurnBytes(table_length));
@@ -1222,11 +1249,9 @@ JpegDecodeStatus JpegDecoder::parseTableData(JpegInfo &jpginfo) {
                     // Create table of code values
                     REPORT_BS_ERR_IF_FAIL(mBsParser->tryBurnBytes(16));
                     table_bytes -= 16;
-                    uint32_t tbl_ind;
-                    for (tbl_ind = 0; tbl_ind < table_entries; tbl_ind++) {
-                        REPORT_BS_ERR_IF_FAIL(mBsParser->tryReadNextByte(&jpginfo.hufman_table_buf.huffman_table[table_id].dc_values[tbl_ind]));
-                        table_bytes--;
-                    }
+                    REPORT_BS_ERR_IF_FAIL((table_entries <= sizeof(jpginfo.hufman_table_buf.huffman_table[table_id].dc_values)));
+                    REPORT_BS_ERR_IF_FAIL(mBsParser->tryCopyBytes(jpginfo.hufman_table_buf.huffman_table[table_id].dc_values, table_entries));
+                    table_bytes -= table_entries;
 
                 } else { // for AC class
                     //const uint8_t* bits = mBsParser->getCurrentIndex();
@@ -1241,11 +1266,9 @@ JpegDecodeStatus JpegDecoder::parseTableData(JpegInfo &jpginfo) {
                     // Create table of code values
                     REPORT_BS_ERR_IF_FAIL(mBsParser->tryBurnBytes(16));
                     table_bytes -= 16;
-                    uint32_t tbl_ind = 0;
-                    for (tbl_ind = 0; tbl_ind < table_entries; tbl_ind++) {
-                        REPORT_BS_ERR_IF_FAIL(mBsParser->tryReadNextByte(&jpginfo.hufman_table_buf.huffman_table[table_id].ac_values[tbl_ind]));
-                        table_bytes--;
-                    }
+                    REPORT_BS_ERR_IF_FAIL((table_entries <= sizeof(jpginfo.hufman_table_buf.huffman_table[table_id].ac_values)));
+                    REPORT_BS_ERR_IF_FAIL(mBsParser->tryCopyBytes(jpginfo.hufman_table_buf.huffman_table[table_id].ac_values, table_entries));
+                    table_bytes -= table_entries;
                 }//end of else
             } else {
                 // Find out the number of entries in the table
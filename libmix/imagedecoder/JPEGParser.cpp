@@ -20,6 +20,9 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 bool endOfBuffer(CJPEGParse* parser);
 
@@ -211,3 +214,57 @@ void parserInitialize(CJPEGParse* parser, android::Vector<uint8_t> *inputs) {
     parser->getRemainingBytes = getRemainingBytesStr;
 }
 
+
+static inline bool isMarkerCode(uint8_t code) {
+    return code != 0x00 && code != 0xff;
+}
+
+static inline bool addMarker(const uint8_t* buf, uint32_t offset, uint32_t stop_offset,
+                             android::Vector<JpegMarker> *markers) {
+    JpegMarker marker;
+    marker.offset = offset;
+    marker.code = buf[offset + 1];
+    markers->add(marker);
+    return offset >= stop_offset;
+}
+
+uint32_t scanMarkers(const uint8_t* buf, uint32_t size, uint32_t start, uint32_t stop_offset,
+                     android::Vector<JpegMarker> *markers) {
+    // the code follows the 0xFF, so the last byte never starts a marker
+    uint32_t end = size > 0 ? size - 1 : 0;
+    uint32_t i = start;
+
+#ifdef __SSE2__
+    // 64 bytes per test: 0xFF is rare in entropy coded data
+    const __m128i ff = _mm_set1_epi8((char)0xff);
+    for (; i + 64 <= end; i += 64) {
+        const __m128i* p = (const __m128i*)(buf + i);
+        __m128i c0 = _mm_cmpeq_epi8(_mm_loadu_si128(p), ff);
+        __m128i c1 = _mm_cmpeq_epi8(_mm_loadu_si128(p + 1), ff);
+        __m128i c2 = _mm_cmpeq_epi8(_mm_loadu_si128(p + 2), ff);
+        __m128i c3 = _mm_cmpeq_epi8(_mm_loadu_si128(p + 3), ff);
+        if (!_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(c0, c1), _mm_or_si128(c2, c3))))
+            continue;
+        uint64_t mask = (uint64_t)_mm_movemask_epi8(c0)
+                      | (uint64_t)_mm_movemask_epi8(c1) << 16
+                      | (uint64_t)_mm_movemask_epi8(c2) << 32
+                      | (uint64_t)_mm_movemask_epi8(c3) << 48;
+        while (mask) {
+            uint32_t offset = i + __builtin_ctzll(mask);
+            mask &= mask - 1;
+            if (isMarkerCode(buf[offset + 1]) && addMarker(buf, offset, stop_offset, markers))
+                return offset + 1;
+        }
+    }
+#endif
+    while (i < end) {
+        const uint8_t* ff_byte = (const uint8_t*)memchr(buf + i, 0xff, end - i);
+        if (ff_byte == NULL)
+            break;
+        uint32_t offset = ff_byte - buf;
+        i = offset + 1;
+        if (isMarkerCode(buf[offset + 1]) && addMarker(buf, offset, stop_offset, markers))
+            return offset + 1;
+    }
+    return size;
+}
@@ -18,6 +18,7 @@
 #define _JPEG_PARSE_H_
 
 #include <stdint.h>
+#include <string.h>
 #include <utils/Vector.h>
 using namespace std;
 // Marker Codes
@@ -86,31 +87,74 @@ struct CJPEGParse {
 void parserInitialize(CJPEGParse* parser, const uint8_t* stream_buff, uint32_t buff_size);
 void parserInitialize(CJPEGParse* parser, android::Vector<uint8_t> *inputs);
 
+// A marker: 0xFF at offset, then code, neither 0x00 (stuffing) nor 0xFF (fill)
+struct JpegMarker {
+    uint32_t offset;
+    uint8_t code;
+};
+
+/*
+ * Appends to markers the markers found from byte start on, 64 bytes at a
+ * time with SSE2, until one at or after stop_offset is found or the end of
+ * the buffer. Returns the offset to resume the scan from.
+ */
+uint32_t scanMarkers(const uint8_t* buf, uint32_t size, uint32_t start, uint32_t stop_offset,
+                     android::Vector<JpegMarker> *markers);
+
 class JpegBitstreamParser
 {
 public:
+    JpegBitstreamParser()
+        : use_vector(false),
+          scanned(0)
+    {
+        memset(&parser, 0, sizeof(parser));
+    }
     void set(android::Vector<uint8_t>* inputs)
     {
         parserInitialize(&parser, inputs);
         use_vector = true;
+        markers.clear();
+        scanned = 0;
     }
     void set(const uint8_t *buf, uint32_t bufsize)
     {
         parserInitialize(&parser, buf, bufsize);
         use_vector = false;
+        markers.clear();
+        scanned = 0;
     }
     bool tryReadNextByte(uint8_t *byte)
     {
         if (parser.getRemainingBytes(&parser) >= 1) {
-            *byte = parser.readNextByte(&parser);
+            *byte = data()[parser.parse_index++];
             return true;
         }
         return false;
     }
+    // big endian field of 1 to 4 bytes
     bool tryReadBytes(uint32_t *bytes, uint32_t bytes_to_read)
     {
-        if (parser.getRemainingBytes(&parser) >= bytes_to_read) {
-            *bytes = parser.readBytes(&parser, bytes_to_read);
+        if (bytes_to_read > 4 || parser.getRemainingBytes(&parser) < bytes_to_read)
+            return false;
+        const uint8_t *p = data() + parser.parse_index;
+        uint32_t value = 0;
+        switch (bytes_to_read) {
+        case 4: value = (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3]; break;
+        case 3: value = p[0] << 16 | p[1] << 8 | p[2]; break;
+        case 2: value = p[0] << 8 | p[1]; break;
+        case 1: value = p[0]; break;
+        default: break;
+        }
+        *bytes = value;
+        parser.parse_index += bytes_to_read;
+        return true;
+    }
+    bool tryCopyBytes(uint8_t *dst, uint32_t bytes_to_copy)
+    {
+        if (parser.getRemainingBytes(&parser) >= bytes_to_copy) {
+            memcpy(dst, data() + parser.parse_index, bytes_to_copy);
+            parser.parse_index += bytes_to_copy;
             return true;
         }
         return false;
@@ -123,36 +167,45 @@ public:
         }
         return false;
     }
+    /*
+     * Moves past the next marker, skipping stuffed and fill bytes, and
+     * returns its code. The markers are looked up in the marker table,
+     * which is extended on demand: a header-only parse scans no further
+     * than SOS.
+     */
     bool tryGetNextMarker(uint8_t *marker)
     {
-        uint32_t rollbackoff = parser.getByteOffset(&parser);
-        while (!parser.endOfBuffer(&parser)) {
-            if (tryReadNextByte(marker)) {
-                if (*marker == 0xff) {
-                    //rollbackoff = parser.parse_index - 1;
-                    break;
-                }
-            } else {
-                goto rollback;
-            }
+        uint32_t offset = parser.parse_index;
+        uint32_t size = bufferSize();
+        // first indexed marker at or after offset
+        size_t lo = 0, hi = markers.size();
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (markers[mid].offset < offset)
+                lo = mid + 1;
+            else
+                hi = mid;
         }
-        /* check the next byte to make sure we don't miss the real marker*/
-        if (tryReadNextByte(marker)) {
-            if (*marker == 0xff) {
-                if (tryReadNextByte(marker)) {
-                    return true;
-                }
-                else
-                    goto rollback;
-            }
-            else {
-                return true;
-            }
+        if (lo == markers.size() && scanned < size) {
+            scanned = scanMarkers(data(), size, scanned, offset, &markers);
+            while (lo < markers.size() && markers[lo].offset < offset)
+                lo++;
         }
-        else goto rollback;
-rollback:
-        parser.parse_index = rollbackoff;
-        return false;
+        if (lo == markers.size())
+            return false;
+        *marker = markers[lo].code;
+        parser.parse_index = markers[lo].offset + 2;
+        if (parser.parse_index == size)
+            parser.end_of_buff = true;
+        return true;
+    }
+    // every marker of the buffer
+    const android::Vector<JpegMarker>& getMarkers()
+    {
+        uint32_t size = bufferSize();
+        if (scanned < size)
+            scanned = scanMarkers(data(), size, scanned, size, &markers);
+        return markers;
     }
     uint32_t getByteOffset()
     {
@@ -197,10 +250,22 @@ rollback:
         parser.stream_buff = NULL;
         parser.buff_size = 0;
         use_vector = false;
+        markers.clear();
+        scanned = 0;
     }
 private:
+    const uint8_t* data() const
+    {
+        return use_vector ? parser.inputs->array() : parser.stream_buff;
+    }
+    uint32_t bufferSize() const
+    {
+        return use_vector ? parser.inputs->size() : parser.buff_size;
+    }
     CJPEGParse parser;
     bool use_vector;
+    android::Vector<JpegMarker> markers;
+    uint32_t scanned;
 };
 #endif // _JPEG_PARSE_H_
 
@@ -0,0 +1,246 @@
+/*
+* Copyright (c) 2014 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * Host test and benchmark of the JPEG marker table.
+ *
+ * A JPEG-like stream is generated with stuffed and fill bytes, restart
+ * markers, and fake markers inside an APP1 payload. Walking it segment by
+ * segment with tryGetNextMarker must give exactly the generated markers;
+ * scanMarkers must find the same markers as a byte by byte search, from
+ * any start offset. Then indexing a camera sized stream is timed against
+ * the byte by byte getNextMarker.
+ *
+ * usage: testjpegparser [stream size in MB]
+ */
+
+#include "../JPEGParser.h"
+#include <utils/Timers.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace android;
+
+struct Generated {
+    Vector<uint8_t> bytes;
+    Vector<JpegMarker> markers;     // the ones a segment walk must meet
+    uint32_t fakes;                 // markers inside the APP1 payload
+};
+
+static void putMarker(Generated &g, uint8_t code, bool fill = false)
+{
+    if (fill)
+        g.bytes.add(0xff);
+    JpegMarker m;
+    m.offset = g.bytes.size();
+    m.code = code;
+    g.markers.add(m);
+    g.bytes.add(0xff);
+    g.bytes.add(code);
+}
+
+static void putSegment(Generated &g, uint8_t code, uint32_t payload, bool fake_markers = false)
+{
+    putMarker(g, code);
+    g.bytes.add((payload + 2) >> 8);
+    g.bytes.add((payload + 2) & 0xff);
+    for (uint32_t i = 0; i < payload; i++) {
+        if (fake_markers && i % 97 == 0 && i + 1 < payload) {
+            g.bytes.add(0xff);
+            g.bytes.add(CODE_SOI + (i & 1));
+            g.fakes++;
+            i++;
+        } else {
+            g.bytes.add(rand() & 0x7f);
+        }
+    }
+}
+
+// entropy coded data, 0xFF stuffed, with a restart marker every rst_interval bytes
+static void putEntropy(Generated &g, uint32_t size, uint32_t rst_interval)
+{
+    uint32_t rst = 0;
+    for (uint32_t i = 1; i <= size; i++) {
+        uint8_t byte = rand() % 200 ? rand() % 0xff : 0xff;
+        g.bytes.add(byte);
+        if (byte == 0xff)
+            g.bytes.add(0);
+        if (rst_interval && i % rst_interval == 0 && i < size)
+            putMarker(g, CODE_RST0 + (rst++ & 7), (i / rst_interval) % 3 == 0);
+    }
+}
+
+static void generate(Generated &g, uint32_t entropy_size)
+{
+    g.fakes = 0;
+    putMarker(g, CODE_SOI);
+    putSegment(g, CODE_APP0, 14);
+    putSegment(g, CODE_APP1, 4000, true);
+    putSegment(g, CODE_DQT, 65);
+    putSegment(g, CODE_SOF_BASELINE, 15);
+    putSegment(g, CODE_DHT, 418);
+    putSegment(g, CODE_DRI, 2);
+    putSegment(g, CODE_SOS, 10);
+    putEntropy(g, entropy_size, 1024);
+    putMarker(g, CODE_EOI, true);
+}
+
+static bool hasLength(uint8_t code)
+{
+    return code != CODE_SOI && code != CODE_EOI && (code < CODE_RST0 || code > CODE_RST7);
+}
+
+static int testWalk(const Generated &g, bool use_vector)
+{
+    JpegBitstreamParser parser;
+    Vector<uint8_t> inputs = g.bytes;
+    if (use_vector)
+        parser.set(&inputs);
+    else
+        parser.set(g.bytes.array(), g.bytes.size());
+
+    uint32_t n = 0;
+    uint8_t code;
+    while (parser.tryGetNextMarker(&code)) {
+        if (n >= g.markers.size() || code != g.markers[n].code
+            || parser.getByteOffset() != g.markers[n].offset + 2) {
+            printf("walk: marker %u is %02x at %u, expected %02x at %u\n", n, code,
+                   parser.getByteOffset() - 2, n < g.markers.size() ? g.markers[n].code : 0,
+                   n < g.markers.size() ? g.markers[n].offset : 0);
+            return 1;
+        }
+        n++;
+        if (code == CODE_EOI)
+            break;
+        if (hasLength(code)) {
+            uint32_t len;
+            if (!parser.tryReadBytes(&len, 2) || !parser.tryBurnBytes(len - 2)) {
+                printf("walk: cannot skip segment %02x\n", code);
+                return 1;
+            }
+        }
+    }
+    if (n != g.markers.size() || !parser.endOfBuffer()) {
+        printf("walk: %u markers, expected %zu, end of buffer %d\n", n, g.markers.size(),
+               parser.endOfBuffer());
+        return 1;
+    }
+    if (parser.getMarkers().size() != g.markers.size() + g.fakes) {
+        printf("table: %zu markers, expected %zu\n", parser.getMarkers().size(),
+               g.markers.size() + g.fakes);
+        return 1;
+    }
+    return 0;
+}
+
+static int testReads()
+{
+    static const uint8_t buf[] = { 0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0, 0x00 };
+    JpegBitstreamParser parser;
+    parser.set(buf, sizeof(buf));
+    uint32_t v1, v2, v3, v4;
+    uint8_t copy[2];
+    bool ok = parser.tryReadBytes(&v1, 1) && parser.tryReadBytes(&v2, 2)
+           && parser.tryReadBytes(&v3, 3) && parser.tryCopyBytes(copy, 2);
+    // as before, the last byte of the buffer cannot be read
+    ok = ok && !parser.tryReadBytes(&v4, 1) && !parser.tryCopyBytes(copy, 1);
+    parser.set(buf, sizeof(buf));
+    ok = ok && parser.tryReadBytes(&v4, 4) && !parser.tryReadBytes(&v4, 5);
+    if (!ok || v1 != 0x12 || v2 != 0x3456 || v3 != 0x789abc || v4 != 0x12345678
+        || copy[0] != 0xde || copy[1] != 0xf0) {
+        printf("reads: %x %x %x %x %x %x\n", v1, v2, v3, v4, copy[0], copy[1]);
+        return 1;
+    }
+    return 0;
+}
+
+static int testScan()
+{
+    const uint32_t size = 300;
+    uint8_t buf[size];
+    for (uint32_t i = 0; i < size; i++) {
+        int r = rand() % 4;
+        buf[i] = r == 0 ? 0xff : r == 1 ? 0 : rand() & 0xff;
+    }
+    for (uint32_t start = 0; start < 40; start++) {
+        Vector<JpegMarker> markers;
+        uint32_t resume = start;
+        // stop at every marker, as tryGetNextMarker does
+        while (resume < size)
+            resume = scanMarkers(buf, size, resume, resume, &markers);
+        uint32_t n = 0;
+        for (uint32_t i = start; i + 1 < size; i++) {
+            if (buf[i] != 0xff || buf[i + 1] == 0 || buf[i + 1] == 0xff)
+                continue;
+            if (n >= markers.size() || markers[n].offset != i || markers[n].code != buf[i + 1]) {
+                printf("scan from %u: marker %u at %u missed\n", start, n, i);
+                return 1;
+            }
+            n++;
+        }
+        if (n != markers.size()) {
+            printf("scan from %u: %zu markers, expected %u\n", start, markers.size(), n);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void benchmark(uint32_t megabytes)
+{
+    Generated g;
+    generate(g, megabytes << 20);
+    CJPEGParse old_parser;
+    JpegBitstreamParser parser;
+
+    nsecs_t start = systemTime();
+    parserInitialize(&old_parser, g.bytes.array(), g.bytes.size());
+    uint32_t old_count = 0;
+    while (!old_parser.endOfBuffer(&old_parser)) {
+        if (old_parser.getNextMarker(&old_parser) != 0)
+            old_count++;
+    }
+    nsecs_t byte_walk = systemTime() - start;
+
+    start = systemTime();
+    parser.set(g.bytes.array(), g.bytes.size());
+    uint32_t count = parser.getMarkers().size();
+    nsecs_t table = systemTime() - start;
+
+    printf("%zu bytes, %u markers (%u by the byte walk)\n", g.bytes.size(), count, old_count);
+    printf("  byte walk      %8.3f ms\n", byte_walk / 1e6);
+    printf("  marker table   %8.3f ms\n", table / 1e6);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t megabytes = argc > 1 ? atoi(argv[1]) : 4;
+    int errors = 0;
+    Generated g;
+
+    srand(1);
+    generate(g, 100000);
+    errors += testWalk(g, false);
+    errors += testWalk(g, true);
+    errors += testReads();
+    errors += testScan();
+    if (megabytes > 0)
+        benchmark(megabytes);
+
+    printf("%s\n", errors ? "FAILED" : "PASSED");
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,195 @@
+/*
+* Copyright (c) 2014 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * Header parsing of JPEG streams with several scans.
+ *
+ * A 4:2:0 baseline stream is generated with one scan per component, the
+ * entropy coded data between scans being random bytes without 0xFF. The
+ * parser must give one slice per scan, each running up to the next scan,
+ * and reject the streams it can't describe to the hardware: more scans than
+ * slice parameter buffers, a DRI after the last of them, and a Huffman table
+ * redefined after a scan that selects it.
+ *
+ * usage: testjpegscans
+ */
+
+#include "../JPEGDecoder.h"
+#include "../JPEGParser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace android;
+
+static void putMarker(Vector<uint8_t> &bytes, uint8_t code)
+{
+    bytes.add(0xff);
+    bytes.add(code);
+}
+
+static void putSegment(Vector<uint8_t> &bytes, uint8_t code, const uint8_t *payload, uint32_t size)
+{
+    putMarker(bytes, code);
+    bytes.add((size + 2) >> 8);
+    bytes.add((size + 2) & 0xff);
+    bytes.appendArray(payload, size);
+}
+
+// one code of one bit per table, coding the value 0
+static void putHuffmanTables(Vector<uint8_t> &bytes, uint8_t dc_id, uint8_t ac_id)
+{
+    uint8_t payload[2 * 18];
+    memset(payload, 0, sizeof(payload));
+    payload[0] = dc_id;
+    payload[1] = 1;
+    payload[18] = 0x10 | ac_id;
+    payload[19] = 1;
+    putSegment(bytes, CODE_DHT, payload, sizeof(payload));
+}
+
+static void putScan(Vector<uint8_t> &bytes, uint8_t component_id, uint8_t tables)
+{
+    const uint8_t payload[] = { 1, component_id, tables, 0, 0x3f, 0 };
+    putSegment(bytes, CODE_SOS, payload, sizeof(payload));
+    for (int i = 0; i < 200; i++)
+        bytes.add(rand() % 0xff);
+}
+
+static void putHeaders(Vector<uint8_t> &bytes)
+{
+    uint8_t dqt[65];
+    memset(dqt, 1, sizeof(dqt));
+    dqt[0] = 0;
+    // 64x64, Y 2x2, Cb 1x1, Cr 1x1, all on quantisation table 0
+    const uint8_t sof[] = { 8, 0, 64, 0, 64, 3, 1, 0x22, 0, 2, 0x11, 0, 3, 0x11, 0 };
+
+    putMarker(bytes, CODE_SOI);
+    putSegment(bytes, CODE_DQT, dqt, sizeof(dqt));
+    putSegment(bytes, CODE_SOF_BASELINE, sof, sizeof(sof));
+    putHuffmanTables(bytes, 0, 0);
+}
+
+static JpegDecodeStatus parse(JpegDecoder &decoder, JpegInfo &jpginfo, Vector<uint8_t> &bytes)
+{
+    memset(&jpginfo, 0, sizeof(JpegInfo));
+    jpginfo.buf = (uint8_t *)bytes.array();
+    jpginfo.bufsize = bytes.size();
+    jpginfo.need_header_only = false;
+    jpginfo.use_vector_input = false;
+    return decoder.parse(jpginfo);
+}
+
+static int expect(const char *name, JpegDecodeStatus st, JpegDecodeStatus expected)
+{
+    if (st != expected) {
+        printf("%s: status %d, expected %d\n", name, st, expected);
+        return 1;
+    }
+    return 0;
+}
+
+static int testScans(JpegDecoder &decoder, uint32_t scans)
+{
+    Vector<uint8_t> bytes;
+    Vector<uint32_t> offsets;
+    JpegInfo jpginfo;
+    char name[32];
+
+    putHeaders(bytes);
+    for (uint32_t i = 0; i < scans; i++) {
+        putScan(bytes, 1 + i % 3, 0);
+        offsets.add(bytes.size() - 200);
+    }
+    putMarker(bytes, CODE_EOI);
+
+    snprintf(name, sizeof(name), "%u scans", scans);
+    if (scans > JPEG_MAX_COMPONENTS)
+        return expect(name, parse(decoder, jpginfo, bytes), JD_ERROR_BITSTREAM);
+    if (expect(name, parse(decoder, jpginfo, bytes), JD_SUCCESS))
+        return 1;
+    if (jpginfo.scan_ctrl_count != scans) {
+        printf("%s: %u slices\n", name, jpginfo.scan_ctrl_count);
+        return 1;
+    }
+    for (uint32_t i = 0; i < scans; i++) {
+        const VASliceParameterBufferJPEGBaseline &slice = jpginfo.slice_param_buf[i];
+        // up to the data of the next scan, or to the end of the EOI marker
+        uint32_t end = i + 1 < scans ? offsets[i + 1] : bytes.size();
+        if (slice.slice_data_offset != offsets[i] || slice.slice_data_offset + slice.slice_data_size != end
+            || slice.num_components != 1 || slice.components[0].component_selector != 1 + i % 3) {
+            printf("%s: slice %u at %u, %u bytes, component %u\n", name, i,
+                   slice.slice_data_offset, slice.slice_data_size, slice.components[0].component_selector);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int testRestartAfterLastScan(JpegDecoder &decoder)
+{
+    const uint8_t dri[] = { 0, 4 };
+    Vector<uint8_t> bytes;
+    JpegInfo jpginfo;
+
+    putHeaders(bytes);
+    for (uint32_t i = 0; i < JPEG_MAX_COMPONENTS; i++)
+        putScan(bytes, 1 + i % 3, 0);
+    putSegment(bytes, CODE_DRI, dri, sizeof(dri));
+    putMarker(bytes, CODE_EOI);
+    return expect("DRI after the last scan", parse(decoder, jpginfo, bytes), JD_ERROR_BITSTREAM);
+}
+
+static int testTablesBetweenScans(JpegDecoder &decoder)
+{
+    Vector<uint8_t> bytes;
+    JpegInfo jpginfo;
+    int errors = 0;
+
+    // new tables for the chroma scans are fine
+    putHeaders(bytes);
+    putScan(bytes, 1, 0x00);
+    putHuffmanTables(bytes, 1, 1);
+    putScan(bytes, 2, 0x11);
+    putScan(bytes, 3, 0x11);
+    putMarker(bytes, CODE_EOI);
+    errors += expect("new tables between scans", parse(decoder, jpginfo, bytes), JD_SUCCESS);
+
+    // but the tables of the luma scan can't change
+    bytes.clear();
+    putHeaders(bytes);
+    putScan(bytes, 1, 0x00);
+    putHuffmanTables(bytes, 1, 0);
+    putScan(bytes, 2, 0x10);
+    putMarker(bytes, CODE_EOI);
+    errors += expect("table redefined between scans", parse(decoder, jpginfo, bytes), JD_ERROR_BITSTREAM);
+    return errors;
+}
+
+int main(int, char **)
+{
+    JpegDecoder decoder;
+    int errors = 0;
+
+    srand(1);
+    for (uint32_t scans = 1; scans <= JPEG_MAX_COMPONENTS + 2; scans++)
+        errors += testScans(decoder, scans);
+    errors += testRestartAfterLastScan(decoder);
+    errors += testTablesBetweenScans(decoder);
+
+    printf("%s\n", errors ? "FAILED" : "PASSED");
+    return errors ? 1 : 0;
+}
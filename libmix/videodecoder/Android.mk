@@ -8,6 +8,9 @@ endif
 LOCAL_SRC_FILES := \
     VideoDecoderHost.cpp \
     VideoDecoderBase.cpp \
+    VideoOutputQueue.cpp \
+    VideoRawDataPool.cpp \
+    VideoFrameCopy.cpp \
     VideoDecoderWMV.cpp \
     VideoDecoderMPEG4.cpp \
     VideoDecoderAVC.cpp \
@@ -88,3 +91,26 @@ LOCAL_CFLAGS += -DUSE_SW_MPEG4
 endif
 
 include $(BUILD_SHARED_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := \
+    VideoOutputQueue.cpp \
+    VideoDecoderTrace.cpp \
+    test/VideoOutputQueueTest.cpp
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH) \
+    $(TARGET_OUT_HEADERS)/libva
+LOCAL_MODULE := videooutputqueue_test
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := \
+    VideoRawDataPool.cpp \
+    VideoFrameCopy.cpp \
+    VideoDecoderTrace.cpp \
+    test/VideoRawDataTest.cpp
+LOCAL_C_INCLUDES := $(LOCAL_PATH)
+LOCAL_MODULE := videorawdata_test
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_HOST_EXECUTABLE)
@@ -19,13 +19,8 @@
 #include <string.h>
 #include <va/va_android.h>
 #include <va/va_tpi.h>
-#ifdef  __SSE4_1__
-#include "use_util_sse4.h"
-#endif
+#include "VideoFrameCopy.h"
 
-#define INVALID_PTS ((uint64_t)-1)
-#define MAXIMUM_POC  0x7FFFFFFF
-#define MINIMUM_POC  0x80000000
 #define ANDROID_DISPLAY_HANDLE 0x18C34078
 
 VideoDecoderBase::VideoDecoderBase(const char *mimeType, _vbp_parser_type type)
@@ -54,8 +49,6 @@ VideoDecoderBase::VideoDecoderBase(const char *mimeType, _vbp_parser_type type)
       mRotationDegrees(0),
       mNumSurfaces(0),
       mSurfaceBuffers(NULL),
-      mOutputHead(NULL),
-      mOutputTail(NULL),
       mSurfaces(NULL),
       mVASurfaceAttrib(NULL),
       mSurfaceUserPtr(NULL),
@@ -159,6 +152,7 @@ Decode_Status VideoDecoderBase::reset(VideoConfigBuffer *buffer) {
 
 void VideoDecoderBase::stop(void) {
     terminateVA();
+    mRawDataPool.clear();
 
     mCurrentPTS = INVALID_PTS;
     mAcquiredBuffer = NULL;
@@ -190,14 +184,14 @@ void VideoDecoderBase::flush(void) {
 
     endDecodingFrame(true);
 
-    VideoSurfaceBuffer *p = mOutputHead;
+    VideoSurfaceBuffer *p = mOutputQueue.head();
     // check if there's buffer with DRC flag in the output queue
     while (p) {
         if (p->renderBuffer.flag & IS_RESOLUTION_CHANGE) {
             mSizeChanged = true;
             break;
         }
-        p = p->next;
+        p = mOutputQueue.next(p);
     }
     // avoid setting mSurfaceAcquirePos  to 0 as it may cause tearing
     // (surface is still being rendered)
@@ -207,8 +201,7 @@ void VideoDecoderBase::flush(void) {
     mAcquiredBuffer = NULL;
     mLastReference = NULL;
     mForwardReference = NULL;
-    mOutputHead = NULL;
-    mOutputTail = NULL;
+    mOutputQueue.clear();
     mDecodingFrame = false;
 
     // flush vbp parser
@@ -242,13 +235,7 @@ const VideoFormatInfo* VideoDecoderBase::getFormatInfo(void) {
 }
 
 int VideoDecoderBase::getOutputQueueLength(void) {
-    VideoSurfaceBuffer *p = mOutputHead;
-    int i = 0;
-    while (p) {
-        p = p->next;
-        i++;
-    }
-    return i;
+    return mOutputQueue.size();
 }
 
 const VideoRenderBuffer* VideoDecoderBase::getOutput(bool draining, VideoErrorBuffer *outErrBuf) {
@@ -263,24 +250,21 @@ const VideoRenderBuffer* VideoDecoderBase::getOutput(bool draining, VideoErrorBu
         endDecodingFrame(false);
     }
 
-    if (mOutputHead == NULL) {
+    if (mOutputQueue.isEmpty()) {
         return NULL;
     }
 
     // output by position (the first buffer)
-    VideoSurfaceBuffer *outputByPos = mOutputHead;
+    VideoSurfaceBuffer *outputByPos = mOutputQueue.head();
 
     if (mLowDelay) {
-        mOutputHead = mOutputHead->next;
-        if (mOutputHead == NULL) {
-            mOutputTail = NULL;
-        }
+        mOutputQueue.remove(outputByPos);
         vaStatus = vaSetTimestampForSurface(mVADisplay, outputByPos->renderBuffer.surface, outputByPos->renderBuffer.timeStamp);
         if (useGraphicBuffer && !mUseGEN) {
             vaSyncSurface(mVADisplay, outputByPos->renderBuffer.surface);
             fillDecodingErrors(&(outputByPos->renderBuffer));
         }
-        if (draining && mOutputTail == NULL) {
+        if (draining && mOutputQueue.isEmpty()) {
             outputByPos->renderBuffer.flag |= IS_EOS;
         }
         drainDecodingErrors(outErrBuf, &(outputByPos->renderBuffer));
@@ -307,28 +291,12 @@ const VideoRenderBuffer* VideoDecoderBase::getOutput(bool draining, VideoErrorBu
 
     if (output != outputByPts) {
         // swap time stamp
-        uint64_t ts = output->renderBuffer.timeStamp;
-        output->renderBuffer.timeStamp = outputByPts->renderBuffer.timeStamp;
-        outputByPts->renderBuffer.timeStamp = ts;
+        int64_t ts = output->renderBuffer.timeStamp;
+        mOutputQueue.setTimeStamp(output, outputByPts->renderBuffer.timeStamp);
+        mOutputQueue.setTimeStamp(outputByPts, ts);
     }
 
-    if (output != outputByPos) {
-        // remove this output from middle or end of the list
-        VideoSurfaceBuffer *p = outputByPos;
-        while (p->next != output) {
-            p = p->next;
-        }
-        p->next = output->next;
-        if (mOutputTail == output) {
-            mOutputTail = p;
-        }
-    } else {
-        // remove this output from head of the list
-        mOutputHead = mOutputHead->next;
-        if (mOutputHead == NULL) {
-            mOutputTail = NULL;
-        }
-    }
+    mOutputQueue.remove(output);
     //VTRACE("Output POC %d for display (pts = %.2f)", output->pictureOrder, output->renderBuffer.timeStamp/1E6);
     vaStatus = vaSetTimestampForSurface(mVADisplay, output->renderBuffer.surface, output->renderBuffer.timeStamp);
 
@@ -337,7 +305,7 @@ const VideoRenderBuffer* VideoDecoderBase::getOutput(bool draining, VideoErrorBu
         fillDecodingErrors(&(output->renderBuffer));
     }
 
-    if (draining && mOutputTail == NULL) {
+    if (draining && mOutputQueue.isEmpty()) {
         output->renderBuffer.flag |= IS_EOS;
     }
 
@@ -348,189 +316,20 @@ const VideoRenderBuffer* VideoDecoderBase::getOutput(bool draining, VideoErrorBu
 
 VideoSurfaceBuffer* VideoDecoderBase::findOutputByPts(bool draining) {
     // output by presentation time stamp - buffer with the smallest time stamp is output
-    VideoSurfaceBuffer *p = mOutputHead;
-    VideoSurfaceBuffer *outputByPts = NULL;
-    uint64_t pts = INVALID_PTS;
-    do {
-        if ((uint64_t)(p->renderBuffer.timeStamp) <= pts) {
-            // find buffer with the smallest PTS
-            pts = p->renderBuffer.timeStamp;
-            outputByPts = p;
-        }
-        p = p->next;
-    } while (p != NULL);
-
-    return outputByPts;
+    return mOutputQueue.findByPts();
 }
 
 VideoSurfaceBuffer* VideoDecoderBase::findOutputByPct(bool draining) {
     // output by picture coding type (PCT)
     // if there is more than one reference frame, the first reference frame is ouput, otherwise,
     // output non-reference frame if there is any.
-
-    VideoSurfaceBuffer *p = mOutputHead;
-    VideoSurfaceBuffer *outputByPct = NULL;
-    int32_t reference = 0;
-    do {
-        if (p->referenceFrame) {
-            reference++;
-            if (reference > 1) {
-                // mOutputHead must be a reference frame
-                outputByPct = mOutputHead;
-                break;
-            }
-        } else {
-            // first non-reference frame
-            outputByPct = p;
-            break;
-        }
-        p = p->next;
-    } while (p != NULL);
-
-    if (outputByPct == NULL && draining) {
-        outputByPct = mOutputHead;
-    }
-    return  outputByPct;
+    return mOutputQueue.findByPct(draining);
 }
 
-#if 0
 VideoSurfaceBuffer* VideoDecoderBase::findOutputByPoc(bool draining) {
     // output by picture order count (POC)
-    // Output criteria:
-    // if there is IDR frame (POC == 0), all the frames before IDR must be output;
-    // Otherwise, if draining flag is set or list is full, frame with the least POC is output;
-    // Otherwise, NOTHING is output
-
-    int32_t dpbFullness = 0;
-    for (int32_t i = 0; i < mNumSurfaces; i++) {
-        // count num of reference frames
-        if (mSurfaceBuffers[i].asReferernce) {
-            dpbFullness++;
-        }
-    }
-
-    if (mAcquiredBuffer && mAcquiredBuffer->asReferernce) {
-        // frame is being decoded and is not ready for output yet
-        dpbFullness--;
-    }
-
-    VideoSurfaceBuffer *p = mOutputHead;
-    while (p != NULL) {
-        // count dpbFullness with non-reference frame in the output queue
-        if (p->asReferernce == false) {
-            dpbFullness++;
-        }
-        p = p->next;
-    }
-
-Retry:
-    p = mOutputHead;
-    VideoSurfaceBuffer *outputByPoc = NULL;
-    int32_t count = 0;
-    int32_t poc = MAXIMUM_POC;
-
-    do {
-        if (p->pictureOrder == 0) {
-            // output picture with the least POC before IDR
-            if (outputByPoc != NULL) {
-                mNextOutputPOC = outputByPoc->pictureOrder + 1;
-                return outputByPoc;
-            } else {
-                mNextOutputPOC = MINIMUM_POC;
-            }
-        }
-
-        // POC of  the output candidate must not be less than mNextOutputPOC
-        if (p->pictureOrder < mNextOutputPOC) {
-            break;
-        }
-
-        if (p->pictureOrder < poc) {
-            // update the least POC.
-            poc = p->pictureOrder;
-            outputByPoc = p;
-        }
-        count++;
-        p = p->next;
-    } while (p != NULL && count < mOutputWindowSize);
-
-    if (draining == false && dpbFullness < mOutputWindowSize) {
-        // list is not  full and we are not  in draining state
-        // if DPB is already full, one frame must be output
-        return NULL;
-    }
-
-    if (outputByPoc == NULL) {
-        mNextOutputPOC = MINIMUM_POC;
-        goto Retry;
-    }
-
-    // for debugging purpose
-    if (outputByPoc->pictureOrder != 0 && outputByPoc->pictureOrder < mNextOutputPOC) {
-        ETRACE("Output POC is not incremental, expected %d, actual %d", mNextOutputPOC, outputByPoc->pictureOrder);
-        //gaps_in_frame_num_value_allowed_flag is not currently supported
-    }
-
-    mNextOutputPOC = outputByPoc->pictureOrder + 1;
-
-    return outputByPoc;
+    return mOutputQueue.findByPoc(draining, mOutputWindowSize, &mNextOutputPOC);
 }
-#else
-VideoSurfaceBuffer* VideoDecoderBase::findOutputByPoc(bool draining) {
-    VideoSurfaceBuffer *output = NULL;
-    VideoSurfaceBuffer *p = mOutputHead;
-    int32_t count = 0;
-    int32_t poc = MAXIMUM_POC;
-    VideoSurfaceBuffer *outputleastpoc = mOutputHead;
-    do {
-        count++;
-        if (p->pictureOrder == 0) {
-            // any picture before this POC (new IDR) must be output
-            if (output == NULL) {
-                mNextOutputPOC = MINIMUM_POC;
-                // looking for any POC with negative value
-            } else {
-                mNextOutputPOC = output->pictureOrder + 1;
-                break;
-            }
-        }
-        if (p->pictureOrder < poc && p->pictureOrder >= mNextOutputPOC) {
-            // this POC meets ouput criteria.
-            poc = p->pictureOrder;
-            output = p;
-            outputleastpoc = p;
-        }
-        if (poc == mNextOutputPOC || count == mOutputWindowSize) {
-            if (output != NULL) {
-                // this indicates two cases:
-                // 1) the next output POC is found.
-                // 2) output queue is full and there is at least one buffer meeting the output criteria.
-                mNextOutputPOC = output->pictureOrder + 1;
-                break;
-            } else {
-                // this indicates output queue is full and no buffer in the queue meets the output criteria
-                // restart processing as queue is FULL and output criteria is changed. (next output POC is 0)
-                mNextOutputPOC = MINIMUM_POC;
-                count = 0;
-                poc = MAXIMUM_POC;
-                p = mOutputHead;
-                continue;
-            }
-        }
-        if (p->next == NULL) {
-            output = NULL;
-        }
-
-        p = p->next;
-    } while (p != NULL);
-
-    if (draining == true && output == NULL) {
-        output = outputleastpoc;
-    }
-
-    return output;
-}
-#endif
 
 bool VideoDecoderBase::checkBufferAvail(void) {
     if (!mInitialized) {
@@ -673,13 +472,7 @@ Decode_Status VideoDecoderBase::outputSurfaceBuffer(void) {
     }
     // add to the output list
     if (mShowFrame) {
-        if (mOutputHead == NULL) {
-            mOutputHead = mAcquiredBuffer;
-        } else {
-            mOutputTail->next = mAcquiredBuffer;
-        }
-        mOutputTail = mAcquiredBuffer;
-        mOutputTail->next = NULL;
+        mOutputQueue.push(mAcquiredBuffer);
     }
 
     //VTRACE("Pushing POC %d to queue (pts = %.2f)", mAcquiredBuffer->pictureOrder, mAcquiredBuffer->renderBuffer.timeStamp/1E6);
@@ -704,15 +497,12 @@ Decode_Status VideoDecoderBase::releaseSurfaceBuffer(void) {
 
 void VideoDecoderBase::flushSurfaceBuffers(void) {
     endDecodingFrame(true);
-    VideoSurfaceBuffer *p = NULL;
-    while (mOutputHead) {
-        mOutputHead->renderBuffer.renderDone = true;
-        p = mOutputHead;
-        mOutputHead = mOutputHead->next;
-        p->next = NULL;
-    }
-    mOutputHead = NULL;
-    mOutputTail = NULL;
+    VideoSurfaceBuffer *p = mOutputQueue.head();
+    while (p) {
+        p->renderBuffer.renderDone = true;
+        p = mOutputQueue.next(p);
+    }
+    mOutputQueue.clear();
 }
 
 Decode_Status VideoDecoderBase::endDecodingFrame(bool dropFrame) {
@@ -1004,6 +794,9 @@ Decode_Status VideoDecoderBase::setupVA(int32_t numSurface, VAProfile profile, i
         return DECODE_MEMORY_FAIL;
     }
     initSurfaceBuffer(true);
+    if (!mOutputQueue.init(mSurfaceBuffers, mNumSurfaces)) {
+        return DECODE_MEMORY_FAIL;
+    }
 
     if ((int32_t)profile == VAProfileSoftwareDecoding) {
         // derive user pointer from surface for direct access
@@ -1039,12 +832,12 @@ Decode_Status VideoDecoderBase::terminateVA(void) {
         return DECODE_SUCCESS;
     }
 
+    mOutputQueue.deinit();
     if (mSurfaceBuffers) {
         for (int32_t i = 0; i < mNumSurfaces; i++) {
             if (mSurfaceBuffers[i].renderBuffer.rawData) {
-                if (mSurfaceBuffers[i].renderBuffer.rawData->data) {
-                    delete [] mSurfaceBuffers[i].renderBuffer.rawData->data;
-                }
+                // kept in the pool for the next surfaces until stop
+                mRawDataPool.release(mSurfaceBuffers[i].renderBuffer.rawData->data);
                 delete mSurfaceBuffers[i].renderBuffer.rawData;
             }
             if (mSurfaceBuffers[i].mappedData) {
@@ -1218,12 +1011,12 @@ Decode_Status VideoDecoderBase::getRawDataFromSurface(VideoRenderBuffer *renderB
         }
 
         if (rawData->data != NULL && rawData->size != size) {
-            delete [] rawData->data;
+            mRawDataPool.release(rawData->data);
             rawData->data = NULL;
             rawData->size = 0;
         }
         if (rawData->data == NULL) {
-            rawData->data = new uint8_t [size];
+            rawData->data = mRawDataPool.acquire(size);
             if (rawData->data == NULL) {
                 return DECODE_MEMORY_FAIL;
             }
@@ -1246,49 +1039,20 @@ Decode_Status VideoDecoderBase::getRawDataFromSurface(VideoRenderBuffer *renderB
         *pSize = size;
     }
     if (!mIsSoftwareDecoder) {
-        if (size == (int32_t)vaImage.data_size) {
-#ifdef  __SSE4_1__
-            stream_memcpy(pRawData, pBuf, size);
-#else
-            memcpy(pRawData, pBuf, size);
-#endif
-        } else {
-            // copy Y data
-            uint8_t *src = (uint8_t*)pBuf;
-            uint8_t *dst = pRawData;
-            int32_t row = 0;
-            for (row = 0; row < cropHeight; row++) {
-#ifdef  __SSE4_1__
-                stream_memcpy(dst, src, cropWidth);
-#else
-                memcpy(dst, src, cropWidth);
-#endif
-                dst += cropWidth;
-                src += vaImage.pitches[0];
-            }
-            // copy interleaved V and  U data
-            src = (uint8_t*)pBuf + vaImage.offsets[1];
-            for (row = 0; row < cropHeight / 2; row++) {
-#ifdef  __SSE4_1__
-                stream_memcpy(dst, src, cropWidth);
-#else
-                memcpy(dst, src, cropWidth);
-#endif
-                dst += cropWidth;
-                src += vaImage.pitches[1];
-            }
-        }
+        // Y, then interleaved U and V; one block per plane if the pitch is the width
+        uint8_t *src = (uint8_t*)pBuf;
+        videoFrameCopyPlane(pRawData, cropWidth, src, vaImage.pitches[0], cropWidth, cropHeight);
+        src = (uint8_t*)pBuf + vaImage.offsets[1];
+        videoFrameCopyPlane(pRawData + cropWidth * cropHeight, cropWidth, src, vaImage.pitches[1],
+                cropWidth, cropHeight / 2);
     } else {
         uint8_t *src = (uint8_t*)pBuf;
         uint8_t *srcu, *srcv;
         uint8_t *dst = pRawData;
         int32_t row = 0;
         // YV12 format
-        for (row = 0; row < cropHeight; row++) {
-            memcpy(dst, src, cropWidth);
-            dst += cropWidth;
-            src += vaImage.pitches[0];
-        }
+        videoFrameCopyPlane(dst, cropWidth, src, vaImage.pitches[0], cropWidth, cropHeight);
+        dst += cropWidth * cropHeight;
         srcv = (uint8_t*)pBuf + vaImage.offsets[1];
         srcu = (uint8_t*)pBuf + vaImage.offsets[1]*5/4;
         for (row = 0; row < cropHeight / 2; row++) {
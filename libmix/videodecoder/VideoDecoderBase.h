@@ -21,6 +21,8 @@
 #include <va/va_tpi.h>
 #include "VideoDecoderDefs.h"
 #include "VideoDecoderInterface.h"
+#include "VideoOutputQueue.h"
+#include "VideoRawDataPool.h"
 #include <pthread.h>
 
 
@@ -166,13 +168,13 @@ protected:
 
 private:
     bool mRawOutput; // whether to output NV12 raw data
+    VideoRawDataPool mRawDataPool; // raw data buffers of the surface buffers
     bool mManageReference;  // this should stay true for VC1/MP4 decoder, and stay false for AVC decoder. AVC  handles reference frame using DPB
     OUTPUT_METHOD mOutputMethod;
 
     int32_t mNumSurfaces;
     VideoSurfaceBuffer *mSurfaceBuffers;
-    VideoSurfaceBuffer *mOutputHead; // head of output buffer list
-    VideoSurfaceBuffer *mOutputTail;  // tail of output buffer list
+    VideoOutputQueue mOutputQueue; // decoded buffers waiting for output
     VASurfaceID *mSurfaces; // surfaces array
     VASurfaceAttribExternalBuffers *mVASurfaceAttrib;
     uint8_t **mSurfaceUserPtr; // mapped user space pointer
@@ -188,6 +190,8 @@ protected:
     void setOutputMethod(OUTPUT_METHOD method) {mOutputMethod = method;}
     void setOutputWindowSize(int32_t size) {mOutputWindowSize = (size < OUTPUT_WINDOW_SIZE) ? size : OUTPUT_WINDOW_SIZE;}
     void querySurfaceRenderStatus(VideoSurfaceBuffer* surface);
+    // time stamp of a buffer which may be waiting for output
+    void setOutputTimeStamp(VideoSurfaceBuffer *buffer, int64_t timeStamp) {mOutputQueue.setTimeStamp(buffer, timeStamp);}
     void enableLowDelayMode(bool enable) {mLowDelay = enable;}
     void setRotationDegrees(int32_t rotationDegrees);
     void setRenderRect(void);
@@ -239,7 +239,7 @@ Decode_Status VideoDecoderMPEG4::beginDecodingFrame(vbp_data_mp42 *data) {
 
         if (mExpectingNVOP) {
             // P frame is already in queue, just need to update time stamp.
-            mLastReference->renderBuffer.timeStamp = mCurrentPTS;
+            setOutputTimeStamp(mLastReference, mCurrentPTS);
             mExpectingNVOP = false;
         }
         else {
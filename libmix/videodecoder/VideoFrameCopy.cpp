@@ -0,0 +1,152 @@
+/*
+* Copyright (c) 2014 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "VideoFrameCopy.h"
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#define VIDEO_FRAME_COPY_X86 1
+#endif
+
+// A kernel copies size contiguous bytes. Planes whose pitches are the width
+// are one call, others one call per row.
+typedef void (*CopyKernel)(uint8_t *dst, const uint8_t *src, size_t size);
+
+static void copy_c(uint8_t *dst, const uint8_t *src, size_t size) {
+    memcpy(dst, src, size);
+}
+
+#ifdef VIDEO_FRAME_COPY_X86
+
+#define SSE4_1 __attribute__((target("sse4.1")))
+
+// bytes to copy before src is aligned to alignment, at most size
+static inline size_t headSize(const uint8_t *src, size_t size, size_t alignment) {
+    size_t head = (alignment - ((uintptr_t)src & (alignment - 1))) & (alignment - 1);
+    return head < size ? head : size;
+}
+
+SSE4_1 static void copy_sse4_1(uint8_t *dst, const uint8_t *src, size_t size) {
+    // streaming loads need an aligned source, the destination may be unaligned
+    size_t i = headSize(src, size, 16);
+    memcpy(dst, src, i);
+    for (; i + 64 <= size; i += 64) {
+        __m128i x0 = _mm_stream_load_si128((__m128i *)(src + i));
+        __m128i x1 = _mm_stream_load_si128((__m128i *)(src + i + 16));
+        __m128i x2 = _mm_stream_load_si128((__m128i *)(src + i + 32));
+        __m128i x3 = _mm_stream_load_si128((__m128i *)(src + i + 48));
+        _mm_storeu_si128((__m128i *)(dst + i), x0);
+        _mm_storeu_si128((__m128i *)(dst + i + 16), x1);
+        _mm_storeu_si128((__m128i *)(dst + i + 32), x2);
+        _mm_storeu_si128((__m128i *)(dst + i + 48), x3);
+    }
+    for (; i + 16 <= size; i += 16) {
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_stream_load_si128((__m128i *)(src + i)));
+    }
+    memcpy(dst + i, src + i, size - i);
+}
+
+#endif // VIDEO_FRAME_COPY_X86
+
+struct CopyKernels {
+    const char *name;
+    CopyKernel copy;
+};
+
+static const CopyKernels sKernels[VIDEO_FRAME_COPY_ISA_NUM] = {
+    { "c", copy_c },
+#ifdef VIDEO_FRAME_COPY_X86
+    { "sse4.1", copy_sse4_1 },
+#else
+    { "sse4.1", NULL },
+#endif
+};
+
+// Host measurements (videorawdata_test, cached memory) have memcpy ahead of
+// any SIMD loop, so no kernel is picked at run time. Streaming loads are kept
+// for builds targeting SSE4.1, where the surfaces are write-combining.
+#if defined(VIDEO_FRAME_COPY_X86) && defined(__SSE4_1__)
+static const CopyKernels *const sDefaultKernels = &sKernels[VIDEO_FRAME_COPY_ISA_SSE4_1];
+#else
+static const CopyKernels *const sDefaultKernels = &sKernels[VIDEO_FRAME_COPY_ISA_C];
+#endif
+
+static pthread_once_t sCpuOnce = PTHREAD_ONCE_INIT;
+
+static void initCpu(void) {
+#ifdef VIDEO_FRAME_COPY_X86
+    __builtin_cpu_init();
+#endif
+}
+
+static bool isaSupported(int isa) {
+    switch (isa) {
+    case VIDEO_FRAME_COPY_ISA_C:
+        return true;
+#ifdef VIDEO_FRAME_COPY_X86
+    case VIDEO_FRAME_COPY_ISA_SSE4_1:
+        pthread_once(&sCpuOnce, initCpu);
+        return __builtin_cpu_supports("sse4.1");
+#endif
+    default:
+        return false;
+    }
+}
+
+static void copyPlane(const CopyKernels *k, uint8_t *dst, int32_t dstPitch,
+                      const uint8_t *src, int32_t srcPitch, int32_t width, int32_t height) {
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+#ifdef VIDEO_FRAME_COPY_X86
+    // make the writes to the write-combining surface visible before reading it
+    _mm_mfence();
+#endif
+    if (dstPitch == width && srcPitch == width) {
+        k->copy(dst, src, (size_t)width * height);
+        return;
+    }
+    for (int32_t row = 0; row < height; row++) {
+        k->copy(dst, src, width);
+        dst += dstPitch;
+        src += srcPitch;
+    }
+}
+
+void videoFrameCopyPlane(uint8_t *dst, int32_t dstPitch,
+                         const uint8_t *src, int32_t srcPitch,
+                         int32_t width, int32_t height) {
+    copyPlane(sDefaultKernels, dst, dstPitch, src, srcPitch, width, height);
+}
+
+bool videoFrameCopyPlaneIsa(int isa, uint8_t *dst, int32_t dstPitch,
+                            const uint8_t *src, int32_t srcPitch,
+                            int32_t width, int32_t height) {
+    if (isa < 0 || isa >= VIDEO_FRAME_COPY_ISA_NUM || !isaSupported(isa)) {
+        return false;
+    }
+    copyPlane(&sKernels[isa], dst, dstPitch, src, srcPitch, width, height);
+    return true;
+}
+
+const char* videoFrameCopyIsaName(int isa) {
+    if (isa < 0 || isa >= VIDEO_FRAME_COPY_ISA_NUM) {
+        return "unknown";
+    }
+    return sKernels[isa].name;
+}
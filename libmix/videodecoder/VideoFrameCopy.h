@@ -0,0 +1,47 @@
+/*
+* Copyright (c) 2014 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef VIDEO_FRAME_COPY_H_
+#define VIDEO_FRAME_COPY_H_
+
+#include <stdint.h>
+
+enum VideoFrameCopyIsa {
+    VIDEO_FRAME_COPY_ISA_C = 0,
+    VIDEO_FRAME_COPY_ISA_SSE4_1,   // streaming loads, for write-combining surfaces
+    VIDEO_FRAME_COPY_ISA_NUM
+};
+
+// Copies height rows of width bytes from a plane of srcPitch bytes per row to
+// a plane of dstPitch bytes per row. When both pitches are the width, the
+// plane is copied as one block. Rows are copied with memcpy, or with the
+// SSE4.1 streaming loads when the build targets SSE4.1, as stream_memcpy did:
+// they only pay off on the uncached (write-combining) surface mappings of the
+// target and lose to memcpy on cached memory. No alignment is required.
+void videoFrameCopyPlane(uint8_t *dst, int32_t dstPitch,
+                         const uint8_t *src, int32_t srcPitch,
+                         int32_t width, int32_t height);
+
+// Same as videoFrameCopyPlane() with the kernel of a given VideoFrameCopyIsa,
+// returns false if the CPU or the build does not support it.
+bool videoFrameCopyPlaneIsa(int isa, uint8_t *dst, int32_t dstPitch,
+                            const uint8_t *src, int32_t srcPitch,
+                            int32_t width, int32_t height);
+
+// name of a VideoFrameCopyIsa, for traces
+const char* videoFrameCopyIsaName(int isa);
+
+#endif // VIDEO_FRAME_COPY_H_
@@ -0,0 +1,422 @@
+/*
+* Copyright (c) 2014 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "VideoOutputQueue.h"
+#include "VideoDecoderTrace.h"
+#include <string.h>
+
+VideoOutputQueue::VideoOutputQueue()
+    : mBuffers(NULL),
+      mCapacity(0),
+      mSize(0),
+      mNextOrder(0),
+      mQueued(NULL),
+      mHead(NULL),
+      mTail(NULL),
+      mReference(NULL),
+      mPtsHeap(NULL),
+      mPtsPositions(NULL) {
+    memset(&mDecodeList, 0, sizeof(mDecodeList));
+    memset(&mReferenceList, 0, sizeof(mReferenceList));
+    memset(&mNonReferenceList, 0, sizeof(mNonReferenceList));
+}
+
+VideoOutputQueue::~VideoOutputQueue() {
+    deinit();
+}
+
+bool VideoOutputQueue::init(VideoSurfaceBuffer *buffers, int32_t count) {
+    deinit();
+    if (buffers == NULL || count <= 0) {
+        return false;
+    }
+
+    mQueued = new bool [count];
+    if (mQueued == NULL) {
+        return false;
+    }
+    mBuffers = buffers;
+    mCapacity = count;
+    if (count < HEAP_MIN_BUFFERS) {
+        clear();
+        return true;
+    }
+
+    // one allocation for the links and the heap positions
+    int32_t *indexes = new int32_t [count * 5];
+    mReference = new bool [count];
+    mPtsHeap = new PtsEntry [count];
+    if (indexes == NULL || mReference == NULL || mPtsHeap == NULL) {
+        delete [] indexes;
+        deinit();
+        return false;
+    }
+    mDecodeList.prev = indexes;
+    mDecodeList.next = indexes + count;
+    // a buffer is either in the reference or in the non-reference list
+    mReferenceList.prev = mNonReferenceList.prev = indexes + count * 2;
+    mReferenceList.next = mNonReferenceList.next = indexes + count * 3;
+    mPtsPositions = indexes + count * 4;
+    clear();
+    return true;
+}
+
+void VideoOutputQueue::deinit(void) {
+    delete [] mQueued;
+    delete [] mDecodeList.prev;
+    delete [] mReference;
+    delete [] mPtsHeap;
+    memset(&mDecodeList, 0, sizeof(mDecodeList));
+    memset(&mReferenceList, 0, sizeof(mReferenceList));
+    memset(&mNonReferenceList, 0, sizeof(mNonReferenceList));
+    mQueued = NULL;
+    mHead = NULL;
+    mTail = NULL;
+    mReference = NULL;
+    mPtsHeap = NULL;
+    mPtsPositions = NULL;
+    mBuffers = NULL;
+    mCapacity = 0;
+    mSize = 0;
+}
+
+void VideoOutputQueue::clear(void) {
+    for (int32_t i = 0; i < mCapacity; i++) {
+        mQueued[i] = false;
+    }
+    mHead = mTail = NULL;
+    mSize = 0;
+    mNextOrder = 0;
+    if (mPtsHeap == NULL) {
+        return;
+    }
+    for (int32_t i = 0; i < mCapacity; i++) {
+        mDecodeList.prev[i] = -1;
+        mDecodeList.next[i] = -1;
+        mReferenceList.prev[i] = -1;
+        mReferenceList.next[i] = -1;
+        mPtsPositions[i] = -1;
+    }
+    mDecodeList.head = mDecodeList.tail = -1;
+    mReferenceList.head = mReferenceList.tail = -1;
+    mNonReferenceList.head = mNonReferenceList.tail = -1;
+}
+
+int32_t VideoOutputQueue::indexOf(const VideoSurfaceBuffer *buffer) const {
+    if (buffer < mBuffers || buffer >= mBuffers + mCapacity) {
+        return -1;
+    }
+    return buffer - mBuffers;
+}
+
+void VideoOutputQueue::listAppend(List &list, int32_t index) {
+    list.prev[index] = list.tail;
+    list.next[index] = -1;
+    if (list.tail >= 0) {
+        list.next[list.tail] = index;
+    } else {
+        list.head = index;
+    }
+    list.tail = index;
+}
+
+void VideoOutputQueue::listRemove(List &list, int32_t index) {
+    if (list.prev[index] >= 0) {
+        list.next[list.prev[index]] = list.next[index];
+    } else {
+        list.head = list.next[index];
+    }
+    if (list.next[index] >= 0) {
+        list.prev[list.next[index]] = list.prev[index];
+    } else {
+        list.tail = list.prev[index];
+    }
+    list.prev[index] = -1;
+    list.next[index] = -1;
+}
+
+inline bool VideoOutputQueue::ptsBefore(const PtsEntry &a, const PtsEntry &b) {
+    if (a.timeStamp != b.timeStamp) {
+        return a.timeStamp < b.timeStamp;
+    }
+    // the list kept the last one of equal time stamps
+    return (int32_t)(b.order - a.order) < 0;
+}
+
+void VideoOutputQueue::heapMove(int32_t position) {
+    // move the hole up, then down, and put the entry there
+    PtsEntry entry = mPtsHeap[position];
+    int32_t i = position;
+    while (i > 0 && ptsBefore(entry, mPtsHeap[(i - 1) / 2])) {
+        mPtsHeap[i] = mPtsHeap[(i - 1) / 2];
+        mPtsPositions[mPtsHeap[i].index] = i;
+        i = (i - 1) / 2;
+    }
+    if (i == position) {
+        for (;;) {
+            int32_t child = i * 2 + 1;
+            if (child >= mSize) {
+                break;
+            }
+            if (child + 1 < mSize && ptsBefore(mPtsHeap[child + 1], mPtsHeap[child])) {
+                child++;
+            }
+            if (!ptsBefore(mPtsHeap[child], entry)) {
+                break;
+            }
+            mPtsHeap[i] = mPtsHeap[child];
+            mPtsPositions[mPtsHeap[i].index] = i;
+            i = child;
+        }
+    }
+    mPtsHeap[i] = entry;
+    mPtsPositions[entry.index] = i;
+}
+
+void VideoOutputQueue::push(VideoSurfaceBuffer *buffer) {
+    int32_t index = indexOf(buffer);
+    if (index < 0 || mQueued[index]) {
+        ETRACE("Buffer %p can't be queued for output.", buffer);
+        return;
+    }
+    mQueued[index] = true;
+
+    if (mPtsHeap == NULL) {
+        if (mHead == NULL) {
+            mHead = buffer;
+        } else {
+            mTail->next = buffer;
+        }
+        mTail = buffer;
+        mTail->next = NULL;
+        mSize++;
+        return;
+    }
+
+    listAppend(mDecodeList, index);
+    mReference[index] = buffer->referenceFrame;
+    listAppend(mReference[index] ? mReferenceList : mNonReferenceList, index);
+
+    PtsEntry &entry = mPtsHeap[mSize];
+    entry.timeStamp = buffer->renderBuffer.timeStamp;
+    entry.order = mNextOrder++;
+    entry.index = index;
+    mSize++;
+    heapMove(mSize - 1);
+}
+
+void VideoOutputQueue::remove(VideoSurfaceBuffer *buffer) {
+    int32_t index = indexOf(buffer);
+    if (index < 0 || !mQueued[index]) {
+        return;
+    }
+    mQueued[index] = false;
+
+    if (mPtsHeap == NULL) {
+        if (buffer == mHead) {
+            mHead = mHead->next;
+            if (mHead == NULL) {
+                mTail = NULL;
+            }
+        } else {
+            // remove it from the middle or the end of the list
+            VideoSurfaceBuffer *p = mHead;
+            while (p->next != buffer) {
+                p = p->next;
+            }
+            p->next = buffer->next;
+            if (mTail == buffer) {
+                mTail = p;
+            }
+        }
+        mSize--;
+        return;
+    }
+
+    listRemove(mDecodeList, index);
+    listRemove(mReference[index] ? mReferenceList : mNonReferenceList, index);
+
+    int32_t position = mPtsPositions[index];
+    mPtsPositions[index] = -1;
+    mSize--;
+    if (position != mSize) {
+        mPtsHeap[position] = mPtsHeap[mSize];
+        heapMove(position);
+    }
+}
+
+void VideoOutputQueue::setTimeStamp(VideoSurfaceBuffer *buffer, int64_t timeStamp) {
+    buffer->renderBuffer.timeStamp = timeStamp;
+    int32_t index = indexOf(buffer);
+    if (mPtsHeap != NULL && index >= 0 && mQueued[index]) {
+        int32_t position = mPtsPositions[index];
+        if (mPtsHeap[position].timeStamp != (uint64_t)timeStamp) {
+            mPtsHeap[position].timeStamp = timeStamp;
+            heapMove(position);
+        }
+    }
+}
+
+VideoSurfaceBuffer* VideoOutputQueue::head(void) const {
+    if (mPtsHeap == NULL) {
+        return mHead;
+    }
+    return mDecodeList.head >= 0 ? mBuffers + mDecodeList.head : NULL;
+}
+
+VideoSurfaceBuffer* VideoOutputQueue::next(VideoSurfaceBuffer *buffer) const {
+    if (mPtsHeap == NULL) {
+        return buffer->next;
+    }
+    int32_t next = mDecodeList.next[buffer - mBuffers];
+    return next >= 0 ? mBuffers + next : NULL;
+}
+
+VideoSurfaceBuffer* VideoOutputQueue::walkByPts(void) const {
+    VideoSurfaceBuffer *p = mHead;
+    VideoSurfaceBuffer *outputByPts = NULL;
+    uint64_t pts = INVALID_PTS;
+    do {
+        if ((uint64_t)(p->renderBuffer.timeStamp) <= pts) {
+            // find buffer with the smallest PTS
+            pts = p->renderBuffer.timeStamp;
+            outputByPts = p;
+        }
+        p = p->next;
+    } while (p != NULL);
+
+    return outputByPts;
+}
+
+VideoSurfaceBuffer* VideoOutputQueue::walkByPct(bool draining) const {
+    VideoSurfaceBuffer *p = mHead;
+    VideoSurfaceBuffer *outputByPct = NULL;
+    int32_t reference = 0;
+    do {
+        if (p->referenceFrame) {
+            reference++;
+            if (reference > 1) {
+                // mHead must be a reference frame
+                outputByPct = mHead;
+                break;
+            }
+        } else {
+            // first non-reference frame
+            outputByPct = p;
+            break;
+        }
+        p = p->next;
+    } while (p != NULL);
+
+    if (outputByPct == NULL && draining) {
+        outputByPct = mHead;
+    }
+    return outputByPct;
+}
+
+VideoSurfaceBuffer* VideoOutputQueue::findByPts(void) const {
+    if (mSize == 0) {
+        return NULL;
+    }
+    if (mPtsHeap == NULL) {
+        return walkByPts();
+    }
+    return mBuffers + mPtsHeap[0].index;
+}
+
+VideoSurfaceBuffer* VideoOutputQueue::findByPct(bool draining) const {
+    if (mPtsHeap == NULL) {
+        return mSize > 0 ? walkByPct(draining) : NULL;
+    }
+    // if there is more than one reference frame before the first non-reference frame,
+    // the first frame is output (it must be a reference frame); otherwise the first
+    // non-reference frame is output if there is any.
+    int32_t secondReference = -1;
+    if (mReferenceList.head >= 0) {
+        secondReference = mReferenceList.next[mReferenceList.head];
+    }
+    int32_t nonReference = mNonReferenceList.head;
+    if (nonReference >= 0) {
+        if (secondReference < 0 || (int32_t)(mPtsHeap[mPtsPositions[nonReference]].order -
+                mPtsHeap[mPtsPositions[secondReference]].order) < 0) {
+            return mBuffers + nonReference;
+        }
+    }
+    if (secondReference >= 0 || (draining && mSize > 0)) {
+        return head();
+    }
+    return NULL;
+}
+
+VideoSurfaceBuffer* VideoOutputQueue::findByPoc(bool draining, int32_t windowSize, int32_t *nextOutputPoc) const {
+    // the search ends at the latest at windowSize buffers from the head,
+    // (twice if the window has no buffer meeting the output criteria)
+    VideoSurfaceBuffer *output = NULL;
+    VideoSurfaceBuffer *p = head();
+    int32_t count = 0;
+    int32_t poc = MAXIMUM_POC;
+    VideoSurfaceBuffer *outputleastpoc = head();
+    if (p == NULL) {
+        return NULL;
+    }
+    do {
+        count++;
+        if (p->pictureOrder == 0) {
+            // any picture before this POC (new IDR) must be output
+            if (output == NULL) {
+                *nextOutputPoc = MINIMUM_POC;
+                // looking for any POC with negative value
+            } else {
+                *nextOutputPoc = output->pictureOrder + 1;
+                break;
+            }
+        }
+        if (p->pictureOrder < poc && p->pictureOrder >= *nextOutputPoc) {
+            // this POC meets ouput criteria.
+            poc = p->pictureOrder;
+            output = p;
+            outputleastpoc = p;
+        }
+        if (poc == *nextOutputPoc || count == windowSize) {
+            if (output != NULL) {
+                // this indicates two cases:
+                // 1) the next output POC is found.
+                // 2) output queue is full and there is at least one buffer meeting the output criteria.
+                *nextOutputPoc = output->pictureOrder + 1;
+                break;
+            } else {
+                // this indicates output queue is full and no buffer in the queue meets the output criteria
+                // restart processing as queue is FULL and output criteria is changed. (next output POC is 0)
+                *nextOutputPoc = MINIMUM_POC;
+                count = 0;
+                poc = MAXIMUM_POC;
+                p = head();
+                continue;
+            }
+        }
+        if (next(p) == NULL) {
+            output = NULL;
+        }
+
+        p = next(p);
+    } while (p != NULL);
+
+    if (draining == true && output == NULL) {
+        output = outputleastpoc;
+    }
+
+    return output;
+}
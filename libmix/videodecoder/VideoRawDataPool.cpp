@@ -0,0 +1,116 @@
+/*
+* Copyright (c) 2014 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "VideoRawDataPool.h"
+#include "VideoDecoderTrace.h"
+#include <stdlib.h>
+#include <string.h>
+
+VideoRawDataPool::VideoRawDataPool()
+    : mCount(0),
+      mAllocations(0),
+      mReuses(0) {
+    memset(mBuffers, 0, sizeof(mBuffers));
+}
+
+VideoRawDataPool::~VideoRawDataPool() {
+    for (int32_t i = 0; i < mCount; i++) {
+        if (mBuffers[i].inUse) {
+            WTRACE("Raw data buffer %p is still in use.", mBuffers[i].data);
+        }
+        free(mBuffers[i].data);
+    }
+}
+
+int32_t VideoRawDataPool::sizeClass(int32_t size) {
+    if (size <= ALIGNMENT) {
+        return ALIGNMENT;
+    }
+    // a quarter of the highest power of two not above size
+    int32_t step = 1 << (29 - __builtin_clz((uint32_t)size));
+    if (step < ALIGNMENT) {
+        step = ALIGNMENT;
+    }
+    return (size + step - 1) & ~(step - 1);
+}
+
+void VideoRawDataPool::freeBuffer(int32_t i) {
+    free(mBuffers[i].data);
+    mBuffers[i] = mBuffers[--mCount];
+}
+
+uint8_t* VideoRawDataPool::acquire(int32_t size) {
+    if (size <= 0) {
+        return NULL;
+    }
+    int32_t capacity = sizeClass(size);
+    for (int32_t i = 0; i < mCount; i++) {
+        if (!mBuffers[i].inUse && mBuffers[i].capacity == capacity) {
+            mBuffers[i].inUse = true;
+            mReuses++;
+            return mBuffers[i].data;
+        }
+    }
+
+    // smaller free buffers are left from a former resolution
+    for (int32_t i = mCount - 1; i >= 0; i--) {
+        if (!mBuffers[i].inUse && mBuffers[i].capacity < capacity) {
+            freeBuffer(i);
+        }
+    }
+    for (int32_t i = mCount - 1; i >= 0 && mCount == MAX_BUFFERS; i--) {
+        if (!mBuffers[i].inUse) {
+            freeBuffer(i);
+        }
+    }
+
+    void *data = NULL;
+    if (posix_memalign(&data, ALIGNMENT, capacity) != 0) {
+        ETRACE("Failed to allocate %d bytes of raw data.", capacity);
+        return NULL;
+    }
+    mAllocations++;
+    if (mCount == MAX_BUFFERS) {
+        // all in use, not pooled: freed on release
+        return (uint8_t *)data;
+    }
+    mBuffers[mCount].data = (uint8_t *)data;
+    mBuffers[mCount].capacity = capacity;
+    mBuffers[mCount].inUse = true;
+    mCount++;
+    return (uint8_t *)data;
+}
+
+void VideoRawDataPool::release(uint8_t *data) {
+    if (data == NULL) {
+        return;
+    }
+    for (int32_t i = 0; i < mCount; i++) {
+        if (mBuffers[i].data == data) {
+            mBuffers[i].inUse = false;
+            return;
+        }
+    }
+    free(data);
+}
+
+void VideoRawDataPool::clear(void) {
+    for (int32_t i = mCount - 1; i >= 0; i--) {
+        if (!mBuffers[i].inUse) {
+            freeBuffer(i);
+        }
+    }
+}
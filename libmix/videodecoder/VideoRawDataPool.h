@@ -0,0 +1,66 @@
+/*
+* Copyright (c) 2014 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef VIDEO_RAW_DATA_POOL_H_
+#define VIDEO_RAW_DATA_POOL_H_
+
+#include <stdint.h>
+
+// Buffers for the raw data (NV12) exported from decoded surfaces.
+//
+// Buffer sizes are rounded up to size classes of a quarter of a power of two,
+// so frames of about the same size share buffers. A released buffer is kept
+// and given again for a size of its class, across stop and start of VA (e.g.
+// on resolution change) until clear(). Buffers are 64 bytes aligned.
+//
+// The pool is not thread safe, it is used by the decoding thread.
+class VideoRawDataPool {
+public:
+    VideoRawDataPool();
+    ~VideoRawDataPool();
+
+    // NULL if out of memory
+    uint8_t* acquire(int32_t size);
+    void release(uint8_t *data);
+    // frees the buffers which are not in use
+    void clear(void);
+
+    // buffers allocated and buffers given again since the pool was created
+    uint32_t getAllocationCount(void) const { return mAllocations; }
+    uint32_t getReuseCount(void) const { return mReuses; }
+
+    static int32_t sizeClass(int32_t size);
+
+private:
+    enum {
+        MAX_BUFFERS = 64,
+        ALIGNMENT = 64,
+    };
+    struct Buffer {
+        uint8_t *data;
+        int32_t capacity;
+        bool inUse;
+    };
+
+    void freeBuffer(int32_t i);
+
+    Buffer mBuffers[MAX_BUFFERS];
+    int32_t mCount;
+    uint32_t mAllocations;
+    uint32_t mReuses;
+};
+
+#endif // VIDEO_RAW_DATA_POOL_H_
@@ -0,0 +1,492 @@
+/*
+* Copyright (c) 2014 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * Host test and benchmark of VideoOutputQueue.
+ *
+ * Decode orders (AVC with B pyramids, IDRs and leading pictures, MPEG-4
+ * IBBP, random ones with equal time stamps) are replayed through the
+ * output selection of VideoDecoderBase twice: once with the former linked
+ * list and its findOutputByPts/Pct/Poc, kept here as the reference, once
+ * with VideoOutputQueue, below and from HEAP_MIN_BUFFERS surfaces. Every
+ * output buffer, time stamp and EOS flag must be the same, draining included.
+ *
+ * usage: videooutputqueue_test [surfaces [frames]]
+ */
+
+#include "VideoOutputQueue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_SURFACES 64
+#define OUTPUT_WINDOW_SIZE 8  // as in VideoDecoderBase.h
+
+struct Frame {
+    int32_t poc;
+    bool reference;
+    int64_t pts;
+};
+
+enum Method { BY_PCT, BY_POC };
+
+// the output list and selection of VideoDecoderBase before VideoOutputQueue
+struct ListDecoder {
+    VideoSurfaceBuffer buffers[MAX_SURFACES];
+    VideoSurfaceBuffer *mOutputHead;
+    VideoSurfaceBuffer *mOutputTail;
+    int32_t mNextOutputPOC;
+    int32_t mOutputWindowSize;
+
+    void push(VideoSurfaceBuffer *p) {
+        if (mOutputHead == NULL) {
+            mOutputHead = p;
+        } else {
+            mOutputTail->next = p;
+        }
+        mOutputTail = p;
+        mOutputTail->next = NULL;
+    }
+
+    // virtual in VideoDecoderBase, not inlined
+    __attribute__((noinline)) VideoSurfaceBuffer* findOutputByPts() {
+        VideoSurfaceBuffer *p = mOutputHead;
+        VideoSurfaceBuffer *outputByPts = NULL;
+        uint64_t pts = INVALID_PTS;
+        do {
+            if ((uint64_t)(p->renderBuffer.timeStamp) <= pts) {
+                pts = p->renderBuffer.timeStamp;
+                outputByPts = p;
+            }
+            p = p->next;
+        } while (p != NULL);
+        return outputByPts;
+    }
+
+    __attribute__((noinline)) VideoSurfaceBuffer* findOutputByPct(bool draining) {
+        VideoSurfaceBuffer *p = mOutputHead;
+        VideoSurfaceBuffer *outputByPct = NULL;
+        int32_t reference = 0;
+        do {
+            if (p->referenceFrame) {
+                reference++;
+                if (reference > 1) {
+                    outputByPct = mOutputHead;
+                    break;
+                }
+            } else {
+                outputByPct = p;
+                break;
+            }
+            p = p->next;
+        } while (p != NULL);
+
+        if (outputByPct == NULL && draining) {
+            outputByPct = mOutputHead;
+        }
+        return  outputByPct;
+    }
+
+    __attribute__((noinline)) VideoSurfaceBuffer* findOutputByPoc(bool draining) {
+        VideoSurfaceBuffer *output = NULL;
+        VideoSurfaceBuffer *p = mOutputHead;
+        int32_t count = 0;
+        int32_t poc = MAXIMUM_POC;
+        VideoSurfaceBuffer *outputleastpoc = mOutputHead;
+        do {
+            count++;
+            if (p->pictureOrder == 0) {
+                if (output == NULL) {
+                    mNextOutputPOC = MINIMUM_POC;
+                } else {
+                    mNextOutputPOC = output->pictureOrder + 1;
+                    break;
+                }
+            }
+            if (p->pictureOrder < poc && p->pictureOrder >= mNextOutputPOC) {
+                poc = p->pictureOrder;
+                output = p;
+                outputleastpoc = p;
+            }
+            if (poc == mNextOutputPOC || count == mOutputWindowSize) {
+                if (output != NULL) {
+                    mNextOutputPOC = output->pictureOrder + 1;
+                    break;
+                } else {
+                    mNextOutputPOC = MINIMUM_POC;
+                    count = 0;
+                    poc = MAXIMUM_POC;
+                    p = mOutputHead;
+                    continue;
+                }
+            }
+            if (p->next == NULL) {
+                output = NULL;
+            }
+            p = p->next;
+        } while (p != NULL);
+
+        if (draining == true && output == NULL) {
+            output = outputleastpoc;
+        }
+        return output;
+    }
+
+    VideoSurfaceBuffer* getOutput(Method method, bool draining) {
+        if (mOutputHead == NULL) {
+            return NULL;
+        }
+        VideoSurfaceBuffer *outputByPos = mOutputHead;
+        VideoSurfaceBuffer *outputByPts = findOutputByPts();
+        VideoSurfaceBuffer *output = method == BY_POC ? findOutputByPoc(draining) : findOutputByPct(draining);
+        if (output == NULL) {
+            return NULL;
+        }
+        if (output != outputByPts) {
+            uint64_t ts = output->renderBuffer.timeStamp;
+            output->renderBuffer.timeStamp = outputByPts->renderBuffer.timeStamp;
+            outputByPts->renderBuffer.timeStamp = ts;
+        }
+        if (output != outputByPos) {
+            VideoSurfaceBuffer *p = outputByPos;
+            while (p->next != output) {
+                p = p->next;
+            }
+            p->next = output->next;
+            if (mOutputTail == output) {
+                mOutputTail = p;
+            }
+        } else {
+            mOutputHead = mOutputHead->next;
+            if (mOutputHead == NULL) {
+                mOutputTail = NULL;
+            }
+        }
+        if (draining && mOutputTail == NULL) {
+            output->renderBuffer.flag |= IS_EOS;
+        }
+        return output;
+    }
+
+    bool queued(int32_t index) {
+        for (VideoSurfaceBuffer *p = mOutputHead; p; p = p->next) {
+            if (p == buffers + index) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// the output selection of VideoDecoderBase with VideoOutputQueue
+struct QueueDecoder {
+    VideoSurfaceBuffer buffers[MAX_SURFACES];
+    VideoOutputQueue mOutputQueue;
+    int32_t mNextOutputPOC;
+    int32_t mOutputWindowSize;
+
+    VideoSurfaceBuffer* getOutput(Method method, bool draining) {
+        if (mOutputQueue.isEmpty()) {
+            return NULL;
+        }
+        VideoSurfaceBuffer *outputByPts = mOutputQueue.findByPts();
+        VideoSurfaceBuffer *output = method == BY_POC ?
+            mOutputQueue.findByPoc(draining, mOutputWindowSize, &mNextOutputPOC) :
+            mOutputQueue.findByPct(draining);
+        if (output == NULL) {
+            return NULL;
+        }
+        if (output != outputByPts) {
+            int64_t ts = output->renderBuffer.timeStamp;
+            mOutputQueue.setTimeStamp(output, outputByPts->renderBuffer.timeStamp);
+            mOutputQueue.setTimeStamp(outputByPts, ts);
+        }
+        mOutputQueue.remove(output);
+        if (draining && mOutputQueue.isEmpty()) {
+            output->renderBuffer.flag |= IS_EOS;
+        }
+        return output;
+    }
+};
+
+static ListDecoder sList;
+static QueueDecoder sQueue;
+
+static void resetDecoders(int32_t surfaces, int32_t windowSize) {
+    memset(sList.buffers, 0, sizeof(sList.buffers));
+    memset(sQueue.buffers, 0, sizeof(sQueue.buffers));
+    sList.mOutputHead = NULL;
+    sList.mOutputTail = NULL;
+    sList.mNextOutputPOC = MINIMUM_POC;
+    sList.mOutputWindowSize = windowSize;
+    sQueue.mOutputQueue.init(sQueue.buffers, surfaces);
+    sQueue.mNextOutputPOC = MINIMUM_POC;
+    sQueue.mOutputWindowSize = windowSize;
+}
+
+static void fill(VideoSurfaceBuffer *buffer, const Frame &frame) {
+    buffer->pictureOrder = frame.poc;
+    buffer->referenceFrame = frame.reference;
+    buffer->renderBuffer.timeStamp = frame.pts;
+    buffer->renderBuffer.flag = 0;
+}
+
+static bool compareOutput(const char *name, int32_t step, VideoSurfaceBuffer *a, VideoSurfaceBuffer *b) {
+    int32_t ia = a ? a - sList.buffers : -1;
+    int32_t ib = b ? b - sQueue.buffers : -1;
+    if (ia != ib || (a && (a->renderBuffer.timeStamp != b->renderBuffer.timeStamp ||
+                           a->renderBuffer.flag != b->renderBuffer.flag))) {
+        printf("%s: step %d, list output %d (pts %lld, flag %x), queue output %d (pts %lld, flag %x)\n",
+               name, step, ia, a ? (long long)a->renderBuffer.timeStamp : -1LL, a ? a->renderBuffer.flag : 0,
+               ib, b ? (long long)b->renderBuffer.timeStamp : -1LL, b ? b->renderBuffer.flag : 0);
+        return false;
+    }
+    return true;
+}
+
+// decodes frames in order, outputs as a decoder thread does, then drains
+static int replay(const char *name, const Frame *frames, int32_t count, Method method,
+                  int32_t surfaces, int32_t windowSize, bool retimeStamps) {
+    resetDecoders(surfaces, windowSize);
+    int32_t step = 0;
+    int32_t acquirePos = 0;
+
+    for (int32_t i = 0; i < count; i++) {
+        // the next surface which is not waiting for output
+        int32_t index = -1;
+        for (int32_t n = 0; n < surfaces; n++) {
+            int32_t candidate = (acquirePos + n) % surfaces;
+            if (!sList.queued(candidate)) {
+                index = candidate;
+                break;
+            }
+        }
+        if (index < 0) {
+            // the decoder would wait for a surface: force an output
+            VideoSurfaceBuffer *a = sList.getOutput(method, true);
+            VideoSurfaceBuffer *b = sQueue.getOutput(method, true);
+            if (!compareOutput(name, step++, a, b)) {
+                return 1;
+            }
+            i--;
+            continue;
+        }
+        acquirePos = (index + 1) % surfaces;
+
+        fill(sList.buffers + index, frames[i]);
+        fill(sQueue.buffers + index, frames[i]);
+        sList.push(sList.buffers + index);
+        sQueue.mOutputQueue.push(sQueue.buffers + index);
+
+        if (retimeStamps && (rand() % 7) == 0) {
+            // an N-VOP updates the time stamp of the last reference, still queued
+            int64_t ts = frames[i].pts + 1000;
+            sList.buffers[index].renderBuffer.timeStamp = ts;
+            sQueue.mOutputQueue.setTimeStamp(sQueue.buffers + index, ts);
+        }
+
+        for (int32_t n = rand() % 3; n > 0; n--) {
+            VideoSurfaceBuffer *a = sList.getOutput(method, false);
+            VideoSurfaceBuffer *b = sQueue.getOutput(method, false);
+            if (!compareOutput(name, step++, a, b)) {
+                return 1;
+            }
+            if (a == NULL) {
+                break;
+            }
+        }
+        int32_t length = 0;
+        for (VideoSurfaceBuffer *p = sList.mOutputHead; p; p = p->next) {
+            length++;
+        }
+        if (sQueue.mOutputQueue.size() != length) {
+            printf("%s: queue length %d, list length %d\n", name, sQueue.mOutputQueue.size(), length);
+            return 1;
+        }
+    }
+
+    for (;;) {
+        VideoSurfaceBuffer *a = sList.getOutput(method, true);
+        VideoSurfaceBuffer *b = sQueue.getOutput(method, true);
+        if (!compareOutput(name, step++, a, b)) {
+            return 1;
+        }
+        if (a == NULL) {
+            break;
+        }
+    }
+    return 0;
+}
+
+// AVC: hierarchical B GOP of 8, IDR every idrPeriod frames, optional leading pictures
+static int32_t makeAvc(Frame *frames, int32_t count, int32_t idrPeriod, bool leading, bool ptsInDecodeOrder) {
+    static const int32_t gop[8] = { 8, 4, 2, 1, 3, 6, 5, 7 };   // display index in decode order
+    int32_t n = 0;
+    int32_t base = 0;   // display index of the last IDR
+    int64_t displayBase = 0;
+    while (n < count) {
+        // IDR
+        frames[n].poc = 0;
+        frames[n].reference = true;
+        frames[n].pts = displayBase * 33333;
+        n++;
+        base = 0;
+        for (int32_t g = 0; n < count && base + 8 < idrPeriod; g++) {
+            for (int32_t k = 0; k < 8 && n < count; k++) {
+                int32_t display = base + gop[k];
+                frames[n].poc = display * 2;
+                if (leading && g == 0 && k >= 1) {
+                    // open GOP leading pictures, shown before the IDR
+                    frames[n].poc = -(gop[k] * 2);
+                }
+                frames[n].reference = (gop[k] & 1) == 0;
+                frames[n].pts = (displayBase + display) * 33333;
+                n++;
+            }
+            base += 8;
+        }
+        displayBase += base + 1;
+    }
+    if (ptsInDecodeOrder) {
+        for (int32_t i = 0; i < n; i++) {
+            frames[i].pts = i * 33333;
+        }
+    }
+    return n;
+}
+
+// MPEG-4: I P B B P B B ..., time stamps in decode order
+static int32_t makeMpeg4(Frame *frames, int32_t count) {
+    for (int32_t i = 0; i < count; i++) {
+        int32_t k = i % 30;
+        frames[i].poc = 0;
+        frames[i].reference = k == 0 || k % 3 == 1;
+        frames[i].pts = i * 40000;
+    }
+    return count;
+}
+
+static int32_t makeRandom(Frame *frames, int32_t count) {
+    for (int32_t i = 0; i < count; i++) {
+        frames[i].poc = rand() % 5 == 0 ? 0 : rand() % 64 - 8;
+        frames[i].reference = rand() % 3 != 0;
+        // equal time stamps are common, and INVALID_PTS happens
+        frames[i].pts = rand() % 50 == 0 ? (int64_t)INVALID_PTS : rand() % 16;
+    }
+    return count;
+}
+
+static double seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// steady state: surfaces - 1 frames waiting, one output per decoded frame
+static void benchmark(int32_t surfaces, int32_t frames) {
+    Frame *order = new Frame [frames];
+    makeAvc(order, frames, 1 << 30, false, false);
+    double elapsed[2];
+    bool queued[MAX_SURFACES];
+    memset(queued, 0, sizeof(queued));
+
+    for (int32_t impl = 0; impl < 2; impl++) {
+        resetDecoders(surfaces, OUTPUT_WINDOW_SIZE);
+        double start = seconds();
+        int32_t acquirePos = 0;
+        for (int32_t i = 0; i < frames; i++) {
+            int32_t index = acquirePos;
+            acquirePos = (acquirePos + 1) % surfaces;
+            if (impl == 0) {
+                while (sList.queued(index)) {
+                    sList.getOutput(BY_PCT, true);
+                }
+                fill(sList.buffers + index, order[i]);
+                sList.push(sList.buffers + index);
+                if (i >= surfaces - 1) {
+                    sList.getOutput(BY_PCT, false);
+                }
+            } else {
+                while (queued[index]) {
+                    queued[sQueue.getOutput(BY_PCT, true) - sQueue.buffers] = false;
+                }
+                fill(sQueue.buffers + index, order[i]);
+                sQueue.mOutputQueue.push(sQueue.buffers + index);
+                queued[index] = true;
+                if (i >= surfaces - 1) {
+                    VideoSurfaceBuffer *out = sQueue.getOutput(BY_PCT, false);
+                    if (out) {
+                        queued[out - sQueue.buffers] = false;
+                    }
+                }
+            }
+        }
+        elapsed[impl] = seconds() - start;
+    }
+    printf("%d surfaces, %d frames, output by PCT and PTS\n", surfaces, frames);
+    printf("  linked list     %8.1f ns per frame\n", elapsed[0] * 1e9 / frames);
+    printf("  output queue    %8.1f ns per frame\n", elapsed[1] * 1e9 / frames);
+    delete [] order;
+}
+
+int main(int argc, char **argv) {
+    int32_t surfaces = argc > 1 ? atoi(argv[1]) : 32;
+    int32_t benchFrames = argc > 2 ? atoi(argv[2]) : 200000;
+    const int32_t count = 2000;
+    Frame frames[count];
+    int errors = 0;
+    char name[64];
+
+    if (surfaces < 2 || surfaces > MAX_SURFACES) {
+        printf("surfaces must be 2 to %d\n", MAX_SURFACES);
+        return 1;
+    }
+
+    // short queues are walked, the last two keep the heap
+    static const int32_t surfaceCounts[] = { 4, 9, 14, 19, 24, VideoOutputQueue::HEAP_MIN_BUFFERS, MAX_SURFACES };
+    srand(1);
+    for (size_t c = 0; c < sizeof(surfaceCounts) / sizeof(surfaceCounts[0]); c++) {
+        int32_t s = surfaceCounts[c];
+        for (int32_t w = 1; w <= OUTPUT_WINDOW_SIZE; w++) {
+            int32_t n = makeAvc(frames, count, 32, false, false);
+            snprintf(name, sizeof(name), "avc s%d w%d", s, w);
+            errors += replay(name, frames, n, BY_POC, s, w, false);
+
+            n = makeAvc(frames, count, 64, true, true);
+            snprintf(name, sizeof(name), "avc leading s%d w%d", s, w);
+            errors += replay(name, frames, n, BY_POC, s, w, false);
+
+            n = makeRandom(frames, count);
+            snprintf(name, sizeof(name), "random poc s%d w%d", s, w);
+            errors += replay(name, frames, n, BY_POC, s, w, true);
+        }
+        int32_t n = makeMpeg4(frames, count);
+        snprintf(name, sizeof(name), "mpeg4 s%d", s);
+        errors += replay(name, frames, n, BY_PCT, s, OUTPUT_WINDOW_SIZE, true);
+
+        n = makeRandom(frames, count);
+        snprintf(name, sizeof(name), "random pct s%d", s);
+        errors += replay(name, frames, n, BY_PCT, s, OUTPUT_WINDOW_SIZE, true);
+    }
+
+    if (benchFrames > 0) {
+        benchmark(surfaces, benchFrames);
+    }
+
+    printf("%s\n", errors ? "FAILED" : "PASSED");
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,274 @@
+/*
+* Copyright (c) 2014 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * Host test and benchmark of the raw data export of VideoDecoderBase.
+ *
+ * Every frame copy kernel the CPU supports must give the same planes as the
+ * C kernel, for odd widths, pitches and alignments. The pool must give
+ * buffers again for sizes of the same class only, and drop buffers of a
+ * former resolution. Then NV12 frames are exported from malloc-backed fake
+ * surfaces (pitch larger than the width) the former way, a new buffer per
+ * surface when its size changes, freed when VA is terminated, and a memcpy
+ * per row, and with the pool and each kernel. VA is terminated and started
+ * again every 8 rounds of the surfaces, as on a format change.
+ *
+ * usage: videorawdata_test [width height [frames]]
+ */
+
+#include "VideoFrameCopy.h"
+#include "VideoRawDataPool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int testKernels(void) {
+    static const int32_t widths[] = { 1, 15, 16, 17, 63, 64, 65, 127, 129, 255, 720, 1921 };
+    const int32_t height = 7;
+    const int32_t maxPitch = 2048 + 64;
+    uint8_t *src = new uint8_t [maxPitch * height + 64];
+    uint8_t *ref = new uint8_t [maxPitch * height + 64];
+    uint8_t *dst = new uint8_t [maxPitch * height + 64];
+    int errors = 0;
+
+    for (int32_t i = 0; i < maxPitch * height + 64; i++) {
+        src[i] = rand();
+    }
+    for (int isa = VIDEO_FRAME_COPY_ISA_C + 1; isa < VIDEO_FRAME_COPY_ISA_NUM; isa++) {
+        for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+            for (int32_t srcAlign = 0; srcAlign < 64; srcAlign += 13) {
+                for (int32_t dstAlign = 0; dstAlign < 64; dstAlign += 21) {
+                    for (int32_t pad = 0; pad < 40; pad += 39) {
+                        int32_t width = widths[w];
+                        int32_t srcPitch = width + pad;
+                        int32_t dstPitch = width + pad / 3;
+                        memset(ref, 0xa5, maxPitch * height + 64);
+                        memset(dst, 0xa5, maxPitch * height + 64);
+                        videoFrameCopyPlaneIsa(VIDEO_FRAME_COPY_ISA_C, ref + dstAlign, dstPitch,
+                                               src + srcAlign, srcPitch, width, height);
+                        if (!videoFrameCopyPlaneIsa(isa, dst + dstAlign, dstPitch,
+                                                    src + srcAlign, srcPitch, width, height)) {
+                            continue;
+                        }
+                        if (memcmp(ref, dst, maxPitch * height + 64) != 0) {
+                            printf("%s: width %d, pitches %d %d, alignments %d %d differ\n",
+                                   videoFrameCopyIsaName(isa), width, srcPitch, dstPitch,
+                                   srcAlign, dstAlign);
+                            errors++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    delete [] src;
+    delete [] ref;
+    delete [] dst;
+    return errors;
+}
+
+static int testPool(void) {
+    int errors = 0;
+
+    if (VideoRawDataPool::sizeClass(1920 * 1080 * 3 / 2) != 3145728 ||
+        VideoRawDataPool::sizeClass(1) != 64 ||
+        VideoRawDataPool::sizeClass(4096) != 4096 ||
+        VideoRawDataPool::sizeClass(4097) != 5120) {
+        printf("pool: unexpected size classes\n");
+        errors++;
+    }
+
+    VideoRawDataPool pool;
+    uint8_t *a = pool.acquire(1920 * 1080 * 3 / 2);
+    uint8_t *b = pool.acquire(1920 * 1080 * 3 / 2);
+    if (a == NULL || b == NULL || a == b || ((uintptr_t)a & 63) != 0) {
+        printf("pool: bad buffers %p %p\n", a, b);
+        errors++;
+    }
+    pool.release(a);
+    // same class
+    uint8_t *c = pool.acquire(1920 * 1088 * 3 / 2);
+    if (c != a || pool.getAllocationCount() != 2 || pool.getReuseCount() != 1) {
+        printf("pool: buffer of the same class not given again\n");
+        errors++;
+    }
+    pool.release(b);
+    pool.release(c);
+    // larger resolution: the smaller free buffers are dropped
+    uint8_t *d = pool.acquire(3840 * 2160 * 3 / 2);
+    if (d == a || d == b || pool.getAllocationCount() != 3) {
+        printf("pool: buffer of a smaller class given\n");
+        errors++;
+    }
+    // smaller resolution: the larger buffer is not given
+    pool.release(d);
+    uint8_t *e = pool.acquire(320 * 240 * 3 / 2);
+    if (e == d) {
+        printf("pool: buffer of a larger class given\n");
+        errors++;
+    }
+    pool.release(e);
+    pool.clear();
+
+    // more buffers in use than the pool keeps
+    uint8_t *many[80];
+    for (int i = 0; i < 80; i++) {
+        many[i] = pool.acquire(1000);
+        if (many[i] == NULL) {
+            errors++;
+        }
+    }
+    for (int i = 0; i < 80; i++) {
+        pool.release(many[i]);
+    }
+    return errors;
+}
+
+struct Surface {
+    uint8_t *data;
+    int32_t pitch;
+    int32_t offset;     // of the UV plane
+};
+
+// exports frames from surfaces, the former way (isa < 0) or with the pool and a kernel
+static double exportFrames(int isa, Surface *surfaces, int32_t surfaceCount, int32_t width, int32_t height,
+                           int32_t frames, uint32_t *allocations) {
+    int32_t size = width * height * 3 / 2;
+    uint8_t **rawData = new uint8_t* [surfaceCount];
+    int32_t *sizes = new int32_t [surfaceCount];
+    VideoRawDataPool pool;
+    memset(rawData, 0, sizeof(uint8_t *) * surfaceCount);
+    memset(sizes, 0, sizeof(int32_t) * surfaceCount);
+    *allocations = 0;
+
+    double start = seconds();
+    for (int32_t i = 0; i < frames; i++) {
+        Surface &s = surfaces[i % surfaceCount];
+        uint8_t *&dst = rawData[i % surfaceCount];
+        // VA terminated and started again, as on a format change
+        if ((i % (surfaceCount * 8)) == 0) {
+            for (int32_t n = 0; n < surfaceCount; n++) {
+                if (isa < 0) {
+                    delete [] rawData[n];
+                    sizes[n] = 0;
+                } else {
+                    pool.release(rawData[n]);
+                }
+                rawData[n] = NULL;
+            }
+        }
+        if (isa < 0) {
+            // a new buffer only when the size of the surface buffer changes
+            if (dst == NULL || sizes[i % surfaceCount] != size) {
+                delete [] dst;
+                dst = new uint8_t [size];
+                sizes[i % surfaceCount] = size;
+                (*allocations)++;
+            }
+            uint8_t *src = s.data;
+            uint8_t *p = dst;
+            for (int32_t row = 0; row < height; row++) {
+                memcpy(p, src, width);
+                p += width;
+                src += s.pitch;
+            }
+            src = s.data + s.offset;
+            for (int32_t row = 0; row < height / 2; row++) {
+                memcpy(p, src, width);
+                p += width;
+                src += s.pitch;
+            }
+        } else {
+            if (dst == NULL) {
+                dst = pool.acquire(size);
+            }
+            videoFrameCopyPlaneIsa(isa, dst, width, s.data, s.pitch, width, height);
+            videoFrameCopyPlaneIsa(isa, dst + width * height, width, s.data + s.offset, s.pitch,
+                                   width, height / 2);
+        }
+    }
+    double elapsed = seconds() - start;
+
+    if (isa >= 0) {
+        *allocations = pool.getAllocationCount();
+    }
+    for (int32_t n = 0; n < surfaceCount; n++) {
+        if (isa < 0) {
+            delete [] rawData[n];
+        } else {
+            pool.release(rawData[n]);
+        }
+    }
+    delete [] rawData;
+    delete [] sizes;
+    return elapsed;
+}
+
+static void benchmark(int32_t width, int32_t height, int32_t frames) {
+    const int32_t surfaceCount = 8;
+    Surface surfaces[surfaceCount];
+    int32_t pitch = (width + 255) & ~255;
+    int32_t alignedHeight = (height + 31) & ~31;
+    for (int32_t n = 0; n < surfaceCount; n++) {
+        surfaces[n].pitch = pitch;
+        surfaces[n].offset = pitch * alignedHeight;
+        surfaces[n].data = (uint8_t *)malloc(pitch * alignedHeight * 3 / 2);
+        memset(surfaces[n].data, n, pitch * alignedHeight * 3 / 2);
+    }
+
+    double bytes = (double)width * height * 3 / 2 * frames;
+    uint32_t allocations;
+    printf("%dx%d NV12 from %d byte pitch surfaces, %d frames\n", width, height, pitch, frames);
+    double elapsed = exportFrames(-1, surfaces, surfaceCount, width, height, frames, &allocations);
+    uint32_t formerAllocations = allocations;
+    printf("  new + memcpy rows  %6.2f GB/s, %u allocations\n", bytes / elapsed / 1e9, allocations);
+    for (int isa = VIDEO_FRAME_COPY_ISA_C; isa < VIDEO_FRAME_COPY_ISA_NUM; isa++) {
+        uint8_t probe;
+        if (!videoFrameCopyPlaneIsa(isa, &probe, 1, &probe, 1, 1, 1)) {
+            continue;
+        }
+        elapsed = exportFrames(isa, surfaces, surfaceCount, width, height, frames, &allocations);
+        printf("  pool + %-11s %6.2f GB/s, %u allocations (%u avoided)\n", videoFrameCopyIsaName(isa),
+               bytes / elapsed / 1e9, allocations, formerAllocations - allocations);
+    }
+    for (int32_t n = 0; n < surfaceCount; n++) {
+        free(surfaces[n].data);
+    }
+}
+
+int main(int argc, char **argv) {
+    int32_t width = argc > 2 ? atoi(argv[1]) : 1920;
+    int32_t height = argc > 2 ? atoi(argv[2]) : 1080;
+    int32_t frames = argc > 3 ? atoi(argv[3]) : 600;
+    int errors = 0;
+
+    srand(1);
+    errors += testKernels();
+    errors += testPool();
+    if (frames > 0 && width > 0 && height > 0) {
+        benchmark(width, height, frames);
+    }
+
+    printf("%s\n", errors ? "FAILED" : "PASSED");
+    return errors ? 1 : 0;
+}
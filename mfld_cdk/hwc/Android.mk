@@ -69,6 +69,8 @@ LOCAL_SRC_FILES := IntelHWComposerModule.cpp \
                    IntelVsyncEventHandler.cpp \
                    IntelFakeVsyncEvent.cpp \
                    IntelUtility.cpp \
+                   IntelLayerAssigner.cpp \
+                   IntelDamageTracker.cpp \
                    RotationBufferProvider.cpp
 LOCAL_MODULE_TAGS := eng
 LOCAL_MODULE := hwcomposer.$(TARGET_BOARD_PLATFORM)
@@ -0,0 +1,180 @@
+/*
+ * Copyright © 2012 Intel Corporation
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+#include <string.h>
+
+#include <IntelDamageTracker.h>
+
+IntelDamageTracker::IntelDamageTracker()
+    : mLastCount(0),
+      mValid(false),
+      mScreenWidth(0),
+      mScreenHeight(0),
+      mDirtyMask(0),
+      mFrames(0),
+      mNoDamageFrames(0),
+      mPartialFrames(0),
+      mFullFrames(0)
+{
+    memset(mLast, 0, sizeof(mLast));
+    memset(&mDirty, 0, sizeof(mDirty));
+    memset(&mComposedDirty, 0, sizeof(mComposedDirty));
+}
+
+IntelDamageTracker::~IntelDamageTracker()
+{
+}
+
+void IntelDamageTracker::setScreenSize(int width, int height)
+{
+    if (width == mScreenWidth && height == mScreenHeight)
+        return;
+
+    mScreenWidth = width;
+    mScreenHeight = height;
+    reset();
+}
+
+void IntelDamageTracker::reset()
+{
+    mValid = false;
+    mLastCount = 0;
+}
+
+bool IntelDamageTracker::isEmpty(const Rect& r)
+{
+    return r.right <= r.left || r.bottom <= r.top;
+}
+
+void IntelDamageTracker::unite(Rect& dst, const Rect& src)
+{
+    if (isEmpty(src))
+        return;
+
+    if (isEmpty(dst)) {
+        dst = src;
+        return;
+    }
+
+    if (src.left < dst.left) dst.left = src.left;
+    if (src.top < dst.top) dst.top = src.top;
+    if (src.right > dst.right) dst.right = src.right;
+    if (src.bottom > dst.bottom) dst.bottom = src.bottom;
+}
+
+void IntelDamageTracker::setFull(Rect& r) const
+{
+    r.left = 0;
+    r.top = 0;
+    r.right = mScreenWidth > 0 ? mScreenWidth : 0x7fff;
+    r.bottom = mScreenHeight > 0 ? mScreenHeight : 0x7fff;
+}
+
+bool IntelDamageTracker::coversScreen(const Rect& r) const
+{
+    // unknown screen size, any damage is treated as full damage
+    if (mScreenWidth <= 0 || mScreenHeight <= 0)
+        return !isEmpty(r);
+
+    return r.left <= 0 && r.top <= 0 &&
+           r.right >= mScreenWidth && r.bottom >= mScreenHeight;
+}
+
+static bool isSameRect(const IntelDamageTracker::Rect& a,
+                       const IntelDamageTracker::Rect& b)
+{
+    return a.left == b.left && a.top == b.top &&
+           a.right == b.right && a.bottom == b.bottom;
+}
+
+int IntelDamageTracker::update(const LayerState *layers,
+                               int numLayers,
+                               bool geometryChanged)
+{
+    memset(&mDirty, 0, sizeof(mDirty));
+    memset(&mComposedDirty, 0, sizeof(mComposedDirty));
+    mDirtyMask = 0;
+    mFrames++;
+
+    if (!layers || numLayers < 0)
+        numLayers = 0;
+
+    // layers were added or removed, or the list is too long to track
+    bool full = !mValid || geometryChanged ||
+                numLayers != mLastCount || numLayers > MAX_LAYERS;
+
+    for (int i = 0; !full && i < numLayers; i++) {
+        const LayerState& cur = layers[i];
+        const LayerState& last = mLast[i];
+
+        bool contentChanged = cur.handle != last.handle;
+        bool stateChanged = !isSameRect(cur.crop, last.crop) ||
+                            !isSameRect(cur.frame, last.frame) ||
+                            cur.transform != last.transform ||
+                            cur.blending != last.blending ||
+                            cur.planeAlpha != last.planeAlpha ||
+                            cur.composed != last.composed;
+
+        if (!contentChanged && !stateChanged)
+            continue;
+
+        mDirtyMask |= (1 << i);
+        unite(mDirty, last.frame);
+        unite(mDirty, cur.frame);
+
+        // a hardware plane flipping a new buffer leaves the framebuffer
+        // target alone, anything else has to be re-composed
+        if (cur.composed || last.composed || stateChanged) {
+            unite(mComposedDirty, last.frame);
+            unite(mComposedDirty, cur.frame);
+        }
+    }
+
+    if (full) {
+        setFull(mDirty);
+        setFull(mComposedDirty);
+        mDirtyMask = numLayers >= 32 ? 0xffffffff : (1u << numLayers) - 1;
+    }
+
+    if (numLayers <= MAX_LAYERS) {
+        memcpy(mLast, layers, numLayers * sizeof(LayerState));
+        mLastCount = numLayers;
+        mValid = true;
+    } else {
+        reset();
+    }
+
+    if (!full && isEmpty(mDirty)) {
+        mNoDamageFrames++;
+        return DAMAGE_NONE;
+    }
+
+    if (!full && !coversScreen(mDirty)) {
+        mPartialFrames++;
+        return DAMAGE_PARTIAL;
+    }
+
+    mFullFrames++;
+    return DAMAGE_FULL;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright © 2012 Intel Corporation
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+#ifndef __INTEL_DAMAGE_TRACKER_H__
+#define __INTEL_DAMAGE_TRACKER_H__
+
+#include <stdint.h>
+
+// IntelDamageTracker: frame level damage tracking.
+// Keeps a signature (buffer handle, crop, frame, transform, blending and
+// plane alpha) of every layer from the previous frame and computes the
+// union of the regions which changed. Damage is tracked twice: over the
+// whole screen, and over the framebuffer target only, i.e. what GLES
+// would have to re-compose. A layer on a hardware plane which only got
+// a new buffer does not damage the framebuffer target.
+class IntelDamageTracker {
+public:
+    enum {
+        MAX_LAYERS = 16,
+    };
+
+    enum {
+        DAMAGE_NONE = 0,
+        DAMAGE_PARTIAL,
+        DAMAGE_FULL,
+    };
+
+    struct Rect {
+        int left;
+        int top;
+        int right;
+        int bottom;
+    };
+
+    struct LayerState {
+        uintptr_t handle;
+        Rect crop;
+        Rect frame;
+        uint32_t transform;
+        int32_t blending;
+        uint32_t planeAlpha;
+        // layer is composited into the framebuffer target
+        bool composed;
+    };
+
+private:
+    LayerState mLast[MAX_LAYERS];
+    int mLastCount;
+    bool mValid;
+    int mScreenWidth;
+    int mScreenHeight;
+
+    Rect mDirty;
+    Rect mComposedDirty;
+    uint32_t mDirtyMask;
+
+    // statistics
+    uint32_t mFrames;
+    uint32_t mNoDamageFrames;
+    uint32_t mPartialFrames;
+    uint32_t mFullFrames;
+
+private:
+    static void unite(Rect& dst, const Rect& src);
+    static bool isEmpty(const Rect& r);
+    void setFull(Rect& r) const;
+    bool coversScreen(const Rect& r) const;
+public:
+    IntelDamageTracker();
+    ~IntelDamageTracker();
+
+    void setScreenSize(int width, int height);
+    // forget the previous frame, next update reports full damage
+    void reset();
+
+    // compare @layers with the previous frame and return DAMAGE_xxx
+    int update(const LayerState *layers, int numLayers, bool geometryChanged);
+
+    const Rect& getDirtyRect() const { return mDirty; }
+    const Rect& getComposedDirtyRect() const { return mComposedDirty; }
+    bool isComposedDirty() const { return !isEmpty(mComposedDirty); }
+    bool isComposedFull() const { return coversScreen(mComposedDirty); }
+    uint32_t getDirtyMask() const { return mDirtyMask; }
+
+    uint32_t getFrameCount() const { return mFrames; }
+    uint32_t getNoDamageCount() const { return mNoDamageFrames; }
+    uint32_t getPartialCount() const { return mPartialFrames; }
+    uint32_t getFullCount() const { return mFullFrames; }
+};
+
+#endif /*__INTEL_DAMAGE_TRACKER_H__*/
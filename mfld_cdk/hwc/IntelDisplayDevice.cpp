@@ -545,9 +545,32 @@ bool IntelDisplayDevice::isHWCLayer(hwc_layer_1_t *layer)
     return true;
 }
 
+// A layer is sandwiched when it intersects both a layer below it and a
+// layer above it (FB target excluded), so it can neither go under nor over
+// the framebuffer without breaking z order.
 bool IntelDisplayDevice::isLayerSandwiched(int index,
                                            hwc_display_contents_1_t *list)
 {
+    bool below = false;
+    bool above = false;
+
+    if (!list || index < 0 || index >= (int)list->numHwLayers - 1)
+        return false;
+
+    hwc_layer_1_t *layer = &list->hwLayers[index];
+    for (int i = 0; i < (int)list->numHwLayers - 1; i++) {
+        if (i == index)
+            continue;
+        if (!areLayersIntersecting(&list->hwLayers[i], layer))
+            continue;
+        if (i < index)
+            below = true;
+        else
+            above = true;
+        if (below && above)
+            return true;
+    }
+
     return false;
 }
 
@@ -34,6 +34,8 @@
 #include <IntelBufferManager.h>
 #include <IntelHWComposerLayer.h>
 #include <IntelHWComposerDump.h>
+#include <IntelLayerAssigner.h>
+#include <IntelDamageTracker.h>
 #include "RotationBufferProvider.h"
 
 class IntelDisplayConfig {
@@ -179,14 +181,27 @@ protected:
     bool mVideoSentToWidi;
 
 
-    buffer_handle_t mLastHandles[5];
+    // smart composition: skip FB_TARGET composition and flips when
+    // nothing composited by GLES changed since the previous frame
+    IntelDamageTracker mDamageTracker;
+    uint32_t mSmartLayerMask;
     bool mSkipComposition;
+    bool mSkipFlip;
     bool mHasGlesComposition;
     bool mHasSkipLayer;
-    void handleSmartComposition(hwc_display_contents_1_t *list);
+    uint32_t mSkippedCompositions;
+    uint32_t mSkippedFlips;
+    // @replanned: planes were assigned again in this prepare
+    void handleSmartComposition(hwc_display_contents_1_t *list, bool replanned);
 
     buffer_handle_t mPrevFlipHandles[10];
 
+    // cost based plane assignment, memoized across geometry changes
+    IntelLayerAssigner mLayerAssigner;
+    int buildAssignerInput(hwc_display_contents_1_t *list,
+                           IntelLayerAssigner::LayerInfo *layers,
+                           int *indexMap);
+
 protected:
     bool isForceOverlay(hwc_layer_1_t *layer);
     void updateZorderConfig();
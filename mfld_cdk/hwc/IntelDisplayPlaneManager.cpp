@@ -469,6 +469,22 @@ bool IntelDisplayPlaneManager::hasFreeRGBOverlays()
 	return hasFreeOverlays();
 }
 
+int IntelDisplayPlaneManager::getFreeSpriteCount()
+{
+    if (!initCheck())
+        return 0;
+
+    return __builtin_popcount(mFreeSpritePlanes | mReclaimedSpritePlanes);
+}
+
+int IntelDisplayPlaneManager::getFreeOverlayCount()
+{
+    if (!initCheck())
+        return 0;
+
+    return __builtin_popcount(mFreeOverlayPlanes | mReclaimedOverlayPlanes);
+}
+
 bool IntelDisplayPlaneManager::primaryAvailable(int pipe)
 {
     if (!initCheck())
@@ -522,6 +522,8 @@ public:
     bool hasReclaimedOverlays();
     bool hasFreeRGBOverlays();
     bool primaryAvailable(int index);
+    int getFreeSpriteCount();
+    int getFreeOverlayCount();
 
     void reclaimPlane(IntelDisplayPlane *plane);
     void disableReclaimedPlanes(int type);
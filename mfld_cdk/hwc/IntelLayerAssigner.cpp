@@ -0,0 +1,486 @@
+/*
+ * Copyright © 2012 Intel Corporation
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+#include <string.h>
+
+#include <IntelLayerAssigner.h>
+
+IntelLayerAssigner::IntelLayerAssigner()
+    : mScreenWidth(0),
+      mScreenHeight(0),
+      mLayers(0),
+      mNumLayers(0),
+      mZorderRank(RANK_ABOVE_FB),
+      mNextCacheSlot(0),
+      mSolveCount(0),
+      mCacheHits(0),
+      mNodesVisited(0)
+{
+    memset(mCaps, 0, sizeof(mCaps));
+    memset(mCache, 0, sizeof(mCache));
+    memset(&mBest, 0, sizeof(mBest));
+
+    // GLES composition always exists and owns its own pool
+    mCaps[PLANE_GLES].count = MAX_LAYERS;
+    mCaps[PLANE_GLES].rank = RANK_FB;
+    mCaps[PLANE_GLES].pool = PLANE_GLES;
+    for (int i = PLANE_OVERLAY; i < PLANE_CLASS_NUM; i++)
+        mCaps[i].pool = i;
+}
+
+IntelLayerAssigner::~IntelLayerAssigner()
+{
+}
+
+void IntelLayerAssigner::setScreenSize(int width, int height)
+{
+    if (width == mScreenWidth && height == mScreenHeight)
+        return;
+
+    mScreenWidth = width;
+    mScreenHeight = height;
+    invalidate();
+}
+
+void IntelLayerAssigner::setPlaneCaps(int planeClass, int count, int rank,
+                                      int pool, bool exclusive)
+{
+    if (planeClass <= PLANE_GLES || planeClass >= PLANE_CLASS_NUM)
+        return;
+    if (pool < 0 || pool >= PLANE_CLASS_NUM)
+        pool = planeClass;
+
+    PlaneCaps& caps = mCaps[planeClass];
+    if (caps.count == count && caps.rank == rank &&
+        caps.pool == pool && caps.exclusive == exclusive)
+        return;
+
+    caps.count = count;
+    caps.rank = rank;
+    caps.pool = pool;
+    caps.exclusive = exclusive;
+    invalidate();
+}
+
+void IntelLayerAssigner::invalidate()
+{
+    for (int i = 0; i < CACHE_SIZE; i++)
+        mCache[i].used = false;
+}
+
+bool IntelLayerAssigner::isIntersecting(const Rect& a, const Rect& b)
+{
+    if (b.right <= a.left ||
+        b.left >= a.right ||
+        b.top >= a.bottom ||
+        b.bottom <= a.top)
+        return false;
+
+    return true;
+}
+
+// A layer is sandwiched when it covers something below it and is in turn
+// covered by something above it, i.e. it cannot be moved to either side
+// of the framebuffer without breaking the z order.
+bool IntelLayerAssigner::isSandwiched(const LayerInfo *layers,
+                                      int numLayers,
+                                      int index)
+{
+    bool below = false;
+    bool above = false;
+
+    if (!layers || index < 0 || index >= numLayers)
+        return false;
+
+    for (int i = 0; i < numLayers && !(below && above); i++) {
+        if (i == index)
+            continue;
+        if (!isIntersecting(layers[i].frame, layers[index].frame))
+            continue;
+        if (i < index)
+            below = true;
+        else
+            above = true;
+    }
+
+    return below && above;
+}
+
+uint32_t IntelLayerAssigner::hash(const LayerInfo *layers,
+                                  int numLayers) const
+{
+    // FNV-1a over the fields which affect the assignment
+    uint32_t h = 2166136261u;
+
+#define HASH_WORD(w) do { h ^= (uint32_t)(w); h *= 16777619u; } while (0)
+    HASH_WORD(numLayers);
+    for (int i = 0; i < numLayers; i++) {
+        const LayerInfo& l = layers[i];
+        HASH_WORD(l.frame.left);
+        HASH_WORD(l.frame.top);
+        HASH_WORD(l.frame.right);
+        HASH_WORD(l.frame.bottom);
+        HASH_WORD(l.srcWidth);
+        HASH_WORD(l.srcHeight);
+        HASH_WORD(l.bitsPerPixel);
+        HASH_WORD(l.candidates);
+        HASH_WORD(l.mustUseHW);
+    }
+#undef HASH_WORD
+
+    return h;
+}
+
+static bool isSameLayer(const IntelLayerAssigner::LayerInfo& a,
+                        const IntelLayerAssigner::LayerInfo& b)
+{
+    return a.frame.left == b.frame.left &&
+           a.frame.top == b.frame.top &&
+           a.frame.right == b.frame.right &&
+           a.frame.bottom == b.frame.bottom &&
+           a.srcWidth == b.srcWidth &&
+           a.srcHeight == b.srcHeight &&
+           a.bitsPerPixel == b.bitsPerPixel &&
+           a.candidates == b.candidates &&
+           a.mustUseHW == b.mustUseHW;
+}
+
+const IntelLayerAssigner::Assignment*
+IntelLayerAssigner::lookup(uint32_t key, const LayerInfo *layers,
+                           int numLayers) const
+{
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        const CacheEntry& entry = mCache[i];
+        if (!entry.used || entry.hash != key || entry.numLayers != numLayers)
+            continue;
+
+        bool same = true;
+        for (int j = 0; j < numLayers && same; j++)
+            same = isSameLayer(entry.layers[j], layers[j]);
+        if (same)
+            return &entry.result;
+    }
+
+    return 0;
+}
+
+void IntelLayerAssigner::store(uint32_t key, const LayerInfo *layers,
+                               int numLayers, const Assignment& result)
+{
+    CacheEntry& entry = mCache[mNextCacheSlot];
+
+    entry.hash = key;
+    entry.numLayers = numLayers;
+    memcpy(entry.layers, layers, numLayers * sizeof(LayerInfo));
+    entry.result = result;
+    entry.used = true;
+
+    mNextCacheSlot = (mNextCacheSlot + 1) % CACHE_SIZE;
+}
+
+int64_t IntelLayerAssigner::frameBytes() const
+{
+    // scanning out the framebuffer target, 32bpp
+    return (int64_t)mScreenWidth * mScreenHeight * 4;
+}
+
+// compute intersection and cost tables for every layer in one pass
+void IntelLayerAssigner::buildConstraints()
+{
+    for (int i = 0; i < mNumLayers; i++) {
+        const LayerInfo& l = mLayers[i];
+        Rect r = l.frame;
+
+        // clip to screen when screen size is known
+        if (mScreenWidth > 0 && mScreenHeight > 0) {
+            if (r.left < 0) r.left = 0;
+            if (r.top < 0) r.top = 0;
+            if (r.right > mScreenWidth) r.right = mScreenWidth;
+            if (r.bottom > mScreenHeight) r.bottom = mScreenHeight;
+        }
+
+        int w = r.right - r.left;
+        int h = r.bottom - r.top;
+        mArea[i] = (w > 0 && h > 0) ? (int64_t)w * h : 0;
+        mSrcBytes[i] = (int64_t)l.srcWidth * l.srcHeight * l.bitsPerPixel / 8;
+
+        mBelowMask[i] = 0;
+        mAboveMask[i] = 0;
+    }
+
+    for (int i = 0; i < mNumLayers; i++) {
+        for (int j = i + 1; j < mNumLayers; j++) {
+            if (isIntersecting(mLayers[i].frame, mLayers[j].frame)) {
+                mAboveMask[i] |= (1 << j);
+                mBelowMask[j] |= (1 << i);
+            }
+        }
+    }
+}
+
+int IntelLayerAssigner::rankOf(int planeClass) const
+{
+    int rank = mCaps[planeClass].rank;
+    return rank == RANK_ZORDER_FB ? mZorderRank : rank;
+}
+
+// check whether layer @index can go to @planeClass given the placement of
+// all layers below it.
+bool IntelLayerAssigner::canPlace(int index, int planeClass) const
+{
+    const LayerInfo& l = mLayers[index];
+    const PlaneCaps& caps = mCaps[planeClass];
+    int rank = rankOf(planeClass);
+
+    if (planeClass == PLANE_GLES) {
+        if (l.mustUseHW)
+            return false;
+    } else {
+        if (!(l.candidates & (1 << planeClass)))
+            return false;
+        if (mPoolUsed[caps.pool] >= mCaps[caps.pool].count)
+            return false;
+    }
+
+    // the layer must not fall below any intersecting layer under it
+    uint32_t below = mBelowMask[index];
+    for (int j = 0; below; j++, below >>= 1) {
+        if (!(below & 1))
+            continue;
+        if (rank < rankOf(mCurrent[j]))
+            return false;
+    }
+
+    return true;
+}
+
+void IntelLayerAssigner::finish(int64_t glesPixels, int64_t bandwidth,
+                                uint32_t glesMask, Assignment& out) const
+{
+    out.numLayers = mNumLayers;
+    memcpy(out.plane, mCurrent, mNumLayers * sizeof(int));
+    out.glesMask = glesMask;
+    out.glesPixels = glesPixels;
+    out.bandwidth = bandwidth + (glesMask ? frameBytes() : 0);
+    out.cost = out.bandwidth + glesPixels * GLES_PIXEL_WEIGHT;
+    out.valid = true;
+}
+
+void IntelLayerAssigner::search(int index, int64_t glesPixels,
+                                int64_t bandwidth, uint32_t glesMask)
+{
+    mNodesVisited++;
+
+    if (index == mNumLayers) {
+        // exclusive planes (primary) cannot coexist with GLES composition
+        if (glesMask) {
+            for (int i = 0; i < mNumLayers; i++) {
+                if (mCaps[mCurrent[i]].exclusive)
+                    return;
+            }
+        }
+
+        Assignment candidate;
+        finish(glesPixels, bandwidth, glesMask, candidate);
+        if (!mBest.valid || candidate.cost < mBest.cost)
+            mBest = candidate;
+        return;
+    }
+
+    // lower bound, every remaining layer costs at least its scan out
+    if (mBest.valid) {
+        int64_t bound = bandwidth + glesPixels * GLES_PIXEL_WEIGHT;
+        for (int i = index; i < mNumLayers; i++)
+            bound += mSrcBytes[i];
+        if (bound >= mBest.cost)
+            return;
+    }
+
+    // try hardware planes first so ties prefer fewer GLES pixels
+    for (int cls = PLANE_CLASS_NUM - 1; cls >= PLANE_GLES; cls--) {
+        if (!canPlace(index, cls))
+            continue;
+
+        int pool = mCaps[cls].pool;
+        mCurrent[index] = cls;
+
+        // layer 0 is under everything else, placing it sets the overlay
+        // z order for the layers above
+        if (index == 0)
+            mZorderRank = mCaps[cls].rank == RANK_ZORDER_FB ?
+                          RANK_BELOW_FB : RANK_ABOVE_FB;
+
+        if (cls == PLANE_GLES) {
+            search(index + 1,
+                   glesPixels + mArea[index],
+                   bandwidth + mSrcBytes[index] + mArea[index] * 4,
+                   glesMask | (1 << index));
+        } else {
+            mPoolUsed[pool]++;
+            search(index + 1, glesPixels,
+                   bandwidth + mSrcBytes[index], glesMask);
+            mPoolUsed[pool]--;
+        }
+    }
+}
+
+// move layer @index to GLES composition. Raising a layer to the
+// framebuffer rank may break the z order against intersecting layers
+// above it which sit below the framebuffer, so those follow. Layers which
+// must use hardware (protected content) are never demoted, they win over
+// z order just like the forced overlay path does.
+void IntelLayerAssigner::demote(int index)
+{
+    if (mLayers[index].mustUseHW)
+        return;
+
+    if (mCurrent[index] != PLANE_GLES) {
+        mPoolUsed[mCaps[mCurrent[index]].pool]--;
+        mCurrent[index] = PLANE_GLES;
+    }
+
+    uint32_t above = mAboveMask[index];
+    for (int j = 0; above; j++, above >>= 1) {
+        if ((above & 1) && rankOf(mCurrent[j]) < RANK_FB)
+            demote(j);
+    }
+}
+
+// fallback for long layer lists, walk from the top and give each layer
+// the highest ranked hardware plane which stays below everything that
+// covers it. The overlay z order must be known before the walk: overlays
+// go above the framebuffer and stay off layer 0, unless layer 0 is a
+// protected layer which needs one.
+void IntelLayerAssigner::greedy()
+{
+    int64_t glesPixels = 0;
+    int64_t bandwidth = 0;
+    uint32_t glesMask = 0;
+    bool bottomOnOverlay = false;
+
+    memset(mPoolUsed, 0, sizeof(mPoolUsed));
+
+    if (mNumLayers > 0 && mLayers[0].mustUseHW) {
+        for (int cls = PLANE_GLES + 1; cls < PLANE_CLASS_NUM; cls++) {
+            if (mCaps[cls].rank == RANK_ZORDER_FB &&
+                (mLayers[0].candidates & (1 << cls)))
+                bottomOnOverlay = true;
+        }
+    }
+    mZorderRank = bottomOnOverlay ? RANK_BELOW_FB : RANK_ABOVE_FB;
+
+    for (int i = mNumLayers - 1; i >= 0; i--) {
+        const LayerInfo& l = mLayers[i];
+
+        // highest rank allowed by intersecting layers above
+        int maxRank = RANK_ABOVE_FB;
+        uint32_t above = mAboveMask[i];
+        for (int j = 0; above; j++, above >>= 1) {
+            if ((above & 1) && rankOf(mCurrent[j]) < maxRank)
+                maxRank = rankOf(mCurrent[j]);
+        }
+
+        int chosen = -1;
+        for (int cls = PLANE_CLASS_NUM - 1; cls > PLANE_GLES; cls--) {
+            const PlaneCaps& caps = mCaps[cls];
+            if (caps.exclusive || rankOf(cls) > maxRank)
+                continue;
+            if (i == 0 && caps.rank == RANK_ZORDER_FB && !bottomOnOverlay)
+                continue;
+            if (!(l.candidates & (1 << cls)))
+                continue;
+            if (mPoolUsed[caps.pool] >= mCaps[caps.pool].count)
+                continue;
+            if (chosen < 0 || rankOf(cls) > rankOf(chosen))
+                chosen = cls;
+        }
+
+        // protected content wins over z order, like the forced overlay path
+        for (int cls = PLANE_CLASS_NUM - 1; chosen < 0 && l.mustUseHW &&
+             cls > PLANE_GLES; cls--) {
+            if ((l.candidates & (1 << cls)) &&
+                mPoolUsed[mCaps[cls].pool] < mCaps[mCaps[cls].pool].count)
+                chosen = cls;
+        }
+
+        if (chosen > PLANE_GLES) {
+            mCurrent[i] = chosen;
+            mPoolUsed[mCaps[chosen].pool]++;
+        } else {
+            // a hardware layer covering this one must join it in GLES
+            mCurrent[i] = PLANE_GLES;
+            demote(i);
+        }
+    }
+
+    for (int i = 0; i < mNumLayers; i++) {
+        if (mCurrent[i] == PLANE_GLES) {
+            glesPixels += mArea[i];
+            bandwidth += mSrcBytes[i] + mArea[i] * 4;
+            glesMask |= (1 << i);
+        } else {
+            bandwidth += mSrcBytes[i];
+        }
+    }
+
+    finish(glesPixels, bandwidth, glesMask, mBest);
+}
+
+const IntelLayerAssigner::Assignment&
+IntelLayerAssigner::solve(const LayerInfo *layers, int numLayers)
+{
+    if (!layers || numLayers < 0)
+        numLayers = 0;
+    if (numLayers > MAX_LAYERS)
+        numLayers = MAX_LAYERS;
+
+    uint32_t key = hash(layers, numLayers);
+    const Assignment *cached = lookup(key, layers, numLayers);
+    if (cached) {
+        mCacheHits++;
+        mBest = *cached;
+        return mBest;
+    }
+
+    mSolveCount++;
+    mLayers = layers;
+    mNumLayers = numLayers;
+    memset(&mBest, 0, sizeof(mBest));
+    memset(mPoolUsed, 0, sizeof(mPoolUsed));
+    memset(mCurrent, 0, sizeof(mCurrent));
+
+    buildConstraints();
+
+    if (numLayers <= MAX_SEARCH_LAYERS)
+        search(0, 0, 0, 0);
+
+    // nothing valid (e.g. a protected layer cannot get a plane) or the
+    // list is too long for the exhaustive search
+    if (!mBest.valid)
+        greedy();
+
+    store(key, layers, numLayers, mBest);
+    mLayers = 0;
+    return mBest;
+}
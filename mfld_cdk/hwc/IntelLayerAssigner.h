@@ -0,0 +1,188 @@
+/*
+ * Copyright © 2012 Intel Corporation
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+#ifndef __INTEL_LAYER_ASSIGNER_H__
+#define __INTEL_LAYER_ASSIGNER_H__
+
+#include <stdint.h>
+
+// IntelLayerAssigner: pure logic layer-to-plane assignment engine.
+// It knows nothing about gralloc handles, DRM or plane contexts, the
+// display device describes each layer with a LayerInfo and each plane
+// class with a PlaneCaps, then asks for the assignment which minimizes
+// GLES composited pixels and memory bandwidth.
+//
+// Z-order model: every plane class has a rank relative to the framebuffer
+// target (below it, at it, or above it). Layer i sits under layer j when
+// i < j, so whenever two layers intersect the upper one must not be
+// placed on a lower rank than the bottom one. GLES composited layers take
+// the framebuffer rank.
+//
+// The overlay z order is set once per frame for all overlays of the pipe
+// (see IntelDisplayDevice::updateZorderConfig): below the framebuffer
+// when the overlay holds the bottom layer, above it otherwise. A plane
+// class with RANK_ZORDER_FB follows that rule, its rank is decided by the
+// placement of layer 0.
+class IntelLayerAssigner {
+public:
+    enum {
+        PLANE_GLES = 0,
+        PLANE_OVERLAY,
+        PLANE_RGB_OVERLAY,
+        PLANE_SPRITE,
+        PLANE_PRIMARY,
+        PLANE_CLASS_NUM,
+    };
+
+    enum {
+        RANK_BELOW_FB = 0,
+        RANK_FB,
+        RANK_ABOVE_FB,
+        // below the framebuffer when holding layer 0, above it otherwise
+        RANK_ZORDER_FB,
+    };
+
+    enum {
+        MAX_LAYERS = 16,
+        // exhaustive search is bounded, larger lists use greedy fallback
+        MAX_SEARCH_LAYERS = 10,
+        CACHE_SIZE = 4,
+        // relative cost of one GLES composited pixel against one byte of
+        // memory traffic
+        GLES_PIXEL_WEIGHT = 8,
+    };
+
+    struct Rect {
+        int left;
+        int top;
+        int right;
+        int bottom;
+    };
+
+    struct LayerInfo {
+        Rect frame;
+        int srcWidth;
+        int srcHeight;
+        int bitsPerPixel;
+        // bitmask of (1 << PLANE_xxx) the layer may be placed on;
+        // PLANE_GLES is implied unless mustUseHW is set
+        uint32_t candidates;
+        bool mustUseHW;
+    };
+
+    struct PlaneCaps {
+        int count;
+        int rank;
+        // plane classes sharing the same pool of hardware planes
+        int pool;
+        // plane may only be used when nothing is GLES composited
+        bool exclusive;
+    };
+
+    struct Assignment {
+        int numLayers;
+        int plane[MAX_LAYERS];
+        uint32_t glesMask;
+        int64_t glesPixels;
+        int64_t bandwidth;
+        int64_t cost;
+        bool valid;
+    };
+
+private:
+    struct CacheEntry {
+        uint32_t hash;
+        int numLayers;
+        LayerInfo layers[MAX_LAYERS];
+        Assignment result;
+        bool used;
+    };
+
+    PlaneCaps mCaps[PLANE_CLASS_NUM];
+    int mScreenWidth;
+    int mScreenHeight;
+
+    // intersection masks, built once per solve
+    uint32_t mBelowMask[MAX_LAYERS];
+    uint32_t mAboveMask[MAX_LAYERS];
+    int64_t mArea[MAX_LAYERS];
+    int64_t mSrcBytes[MAX_LAYERS];
+
+    // search state
+    const LayerInfo *mLayers;
+    int mNumLayers;
+    int mPoolUsed[PLANE_CLASS_NUM];
+    int mCurrent[MAX_LAYERS];
+    // rank taken by RANK_ZORDER_FB classes in the current placement
+    int mZorderRank;
+    Assignment mBest;
+
+    CacheEntry mCache[CACHE_SIZE];
+    int mNextCacheSlot;
+
+    // statistics
+    uint32_t mSolveCount;
+    uint32_t mCacheHits;
+    uint32_t mNodesVisited;
+
+private:
+    uint32_t hash(const LayerInfo *layers, int numLayers) const;
+    const Assignment* lookup(uint32_t key, const LayerInfo *layers,
+                             int numLayers) const;
+    void store(uint32_t key, const LayerInfo *layers, int numLayers,
+               const Assignment& result);
+    void buildConstraints();
+    int rankOf(int planeClass) const;
+    bool canPlace(int index, int planeClass) const;
+    void search(int index, int64_t glesPixels, int64_t bandwidth,
+                uint32_t glesMask);
+    void demote(int index);
+    void greedy();
+    void finish(int64_t glesPixels, int64_t bandwidth, uint32_t glesMask,
+                Assignment& out) const;
+    int64_t frameBytes() const;
+public:
+    IntelLayerAssigner();
+    ~IntelLayerAssigner();
+
+    void setScreenSize(int width, int height);
+    void setPlaneCaps(int planeClass, int count, int rank,
+                      int pool, bool exclusive);
+    // drop memoized results, needed when plane availability changed
+    void invalidate();
+
+    // compute the best assignment for @layers, ordered bottom to top.
+    // result is memoized, the same geometry returns without searching.
+    const Assignment& solve(const LayerInfo *layers, int numLayers);
+
+    static bool isIntersecting(const Rect& a, const Rect& b);
+    static bool isSandwiched(const LayerInfo *layers, int numLayers,
+                             int index);
+
+    uint32_t getSolveCount() const { return mSolveCount; }
+    uint32_t getCacheHits() const { return mCacheHits; }
+    uint32_t getNodesVisited() const { return mNodesVisited; }
+};
+
+#endif /*__INTEL_LAYER_ASSIGNER_H__*/
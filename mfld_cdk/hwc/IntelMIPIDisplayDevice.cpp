@@ -77,10 +77,13 @@ IntelMIPIDisplayDevice::IntelMIPIDisplayDevice(IntelBufferManager *bm,
         goto init_err;
     }
 
+    mSmartLayerMask = 0;
     mSkipComposition = false;
+    mSkipFlip = false;
     mHasGlesComposition = false;
     mHasSkipLayer = false;
-    memset(&mLastHandles[0], 0, sizeof(mLastHandles));
+    mSkippedCompositions = 0;
+    mSkippedFlips = 0;
 
     memset(&mPrevFlipHandles[0], 0, sizeof(mPrevFlipHandles));
 
@@ -474,6 +477,122 @@ out_check:
 }
 
 
+// Describe the layer list to the plane assigner. Only cheap, side effect
+// free checks are done here to build the candidate planes of each layer,
+// the full isXXXLayer() checks still run on the plane picked for it.
+// Layers sent to widi are skipped, they are not shown on MIPI.
+int IntelMIPIDisplayDevice::buildAssignerInput(hwc_display_contents_1_t *list,
+                                IntelLayerAssigner::LayerInfo *layers,
+                                int *indexMap)
+{
+    int numLayers = 0;
+
+    if (!list)
+        return 0;
+
+    drmModeFBPtr fbInfo = mDrm->getOutputFBInfo(OUTPUT_MIPI0);
+    if (fbInfo)
+        mLayerAssigner.setScreenSize(fbInfo->width, fbInfo->height);
+
+    // overlay goes below the framebuffer (holes are cleared for it) when it
+    // holds the bottom layer and above it otherwise, as updateZorderConfig()
+    // sets it; RGB overlay and sprite are blended above the framebuffer
+    int overlays = mPlaneManager->getFreeOverlayCount();
+    mLayerAssigner.setPlaneCaps(IntelLayerAssigner::PLANE_OVERLAY,
+                                overlays,
+                                IntelLayerAssigner::RANK_ZORDER_FB,
+                                IntelLayerAssigner::PLANE_OVERLAY,
+                                false);
+    mLayerAssigner.setPlaneCaps(IntelLayerAssigner::PLANE_RGB_OVERLAY,
+                                overlays,
+                                IntelLayerAssigner::RANK_ABOVE_FB,
+                                IntelLayerAssigner::PLANE_OVERLAY,
+                                false);
+    mLayerAssigner.setPlaneCaps(IntelLayerAssigner::PLANE_SPRITE,
+                                mPlaneManager->getFreeSpriteCount(),
+                                IntelLayerAssigner::RANK_ABOVE_FB,
+                                IntelLayerAssigner::PLANE_SPRITE,
+                                false);
+
+    bool allowRGBOverlay = list->numHwLayers >= 3 &&
+                           !mDrm->isHdmiConnected() &&
+                           !mDrm->isVideoPrepared() &&
+                           !mLayerList->getYUVLayerCount();
+
+    for (size_t i = 0; i < (size_t)mLayerList->getLayersCount(); i++) {
+        hwc_layer_1_t *layer = &list->hwLayers[i];
+
+        if (numLayers >= IntelLayerAssigner::MAX_LAYERS)
+            break;
+
+        if (layer->compositionType == HWC_FRAMEBUFFER_TARGET)
+            continue;
+
+        IMG_native_handle_t *grallocHandle =
+            (IMG_native_handle_t*)layer->handle;
+
+        if (layer->compositionType != HWC_BACKGROUND &&
+            grallocHandle &&
+            mExtendedModeInfo->widiExtHandle == grallocHandle)
+            continue;
+
+        IntelLayerAssigner::LayerInfo& info = layers[numLayers];
+        info.frame.left = layer->displayFrame.left;
+        info.frame.top = layer->displayFrame.top;
+        info.frame.right = layer->displayFrame.right;
+        info.frame.bottom = layer->displayFrame.bottom;
+        info.srcWidth = (int)(layer->sourceCropf.right - layer->sourceCropf.left);
+        info.srcHeight = (int)(layer->sourceCropf.bottom - layer->sourceCropf.top);
+        info.bitsPerPixel = 32;
+        info.candidates = 0;
+        info.mustUseHW = false;
+        indexMap[numLayers++] = i;
+
+        if (!isHWCLayer(layer))
+            continue;
+
+        int dstWidth = layer->displayFrame.right - layer->displayFrame.left;
+        int dstHeight = layer->displayFrame.bottom - layer->displayFrame.top;
+
+        if (mLayerList->getLayerType(i) == IntelHWComposerLayer::LAYER_TYPE_YUV) {
+            info.bitsPerPixel = 12;
+
+            bool forceOverlay = mLayerList->isProtectedLayer(i) ||
+                                mDrm->getDisplayMode() == OVERLAY_EXTEND ||
+                                isForceOverlay(layer);
+            if (forceOverlay) {
+                info.candidates = (1 << IntelLayerAssigner::PLANE_OVERLAY);
+                info.mustUseHW = true;
+            } else if (!mVideoSeekingActive &&
+                       layer->blending == HWC_BLENDING_NONE &&
+                       !(layer->flags & HWC_SKIP_LAYER) &&
+                       layer->visibleRegionScreen.numRects <= 1 &&
+                       mDrm->getDisplayMode() != OVERLAY_CLONE_MIPI0) {
+                info.candidates = (1 << IntelLayerAssigner::PLANE_OVERLAY);
+            }
+        } else if (mLayerList->getLayerType(i) == IntelHWComposerLayer::LAYER_TYPE_RGB) {
+            if (grallocHandle->uiBpp)
+                info.bitsPerPixel = grallocHandle->uiBpp;
+
+            if ((layer->flags & HWC_SKIP_LAYER) || layer->transform)
+                continue;
+            if (layer->blending != HWC_BLENDING_PREMULT &&
+                layer->blending != HWC_BLENDING_NONE)
+                continue;
+
+            if (info.srcWidth == dstWidth && info.srcHeight == dstHeight)
+                info.candidates |= (1 << IntelLayerAssigner::PLANE_SPRITE);
+
+            if (allowRGBOverlay &&
+                grallocHandle->iWidth == dstWidth &&
+                grallocHandle->iHeight == dstHeight)
+                info.candidates |= (1 << IntelLayerAssigner::PLANE_RGB_OVERLAY);
+        }
+    }
+
+    return numLayers;
+}
+
 // When the geometry changed, we need
 // 0) reclaim all allocated planes, reclaimed planes will be disabled
 //    on the start of next frame. A little bit tricky, we cannot disable the
@@ -484,6 +603,18 @@ out_check:
 void IntelMIPIDisplayDevice::onGeometryChanged(hwc_display_contents_1_t *list)
 {
     ALOGD_IF(ALLOW_HWC_PRINT, "%s\n", __func__);
+
+    // give the layers smart composition took from GLES back before
+    // planning, handleSmartComposition starts over after a re-plan. The
+    // mask is from the previous frame, the list may have shrunk since
+    int numLayers = list ? (int)list->numHwLayers - 1 : 0;
+    for (int i = 0; i < numLayers && i < IntelDamageTracker::MAX_LAYERS; i++) {
+        if (mSmartLayerMask & (1 << i))
+            list->hwLayers[i].compositionType = HWC_FRAMEBUFFER;
+    }
+    mSmartLayerMask = 0;
+    mSkipComposition = false;
+
     // reclaim all planes
     bool ret = mLayerList->invalidatePlanes();
     if (!ret) {
@@ -505,7 +636,6 @@ void IntelMIPIDisplayDevice::onGeometryChanged(hwc_display_contents_1_t *list)
     mVideoSentToWidi = false;
 
     for (size_t i = 0; list && i < (size_t)mLayerList->getLayersCount(); i++) {
-        // check whether a layer can be handled in general
         if (!isHWCLayer(&list->hwLayers[i]))
             continue;
 
@@ -519,39 +649,69 @@ void IntelMIPIDisplayDevice::onGeometryChanged(hwc_display_contents_1_t *list)
                 list->hwLayers[i].compositionType = HWC_OVERLAY;
 
             mVideoSentToWidi = true;
-            continue;
         }
+    }
+
+    IntelLayerAssigner::LayerInfo layers[IntelLayerAssigner::MAX_LAYERS];
+    int indexMap[IntelLayerAssigner::MAX_LAYERS];
+    int numLayers;
+    numLayers = buildAssignerInput(list, layers, indexMap);
+
+    const IntelLayerAssigner::Assignment *assignment;
+    assignment = &mLayerAssigner.solve(layers, numLayers);
+
+    for (int k = 0; k < numLayers; k++) {
+        size_t i = indexMap[k];
+        hwc_layer_1_t *layer = &list->hwLayers[i];
+
+        if (!isHWCLayer(layer))
+            continue;
 
-        // further check whether a layer can be handle by overlay/sprite
+        // further check whether a layer can be handle by the plane
+        // the assigner picked for it
         int flags = 0;
-        //bool hasOverlay = mPlaneManager->hasFreeOverlays();
-        bool hasRGBOverlay = mPlaneManager->hasFreeRGBOverlays();
-        bool hasSprite = mPlaneManager->hasFreeSprites();
-
-        if (/*hasOverlay &&*/ isOverlayLayer(list, i, &list->hwLayers[i], flags)) {
-            ret = overlayPrepare(i, &list->hwLayers[i], flags);
-            if (!ret) {
-                ALOGE("%s: failed to prepare overlay\n", __func__);
-                list->hwLayers[i].compositionType = HWC_FRAMEBUFFER;
-                list->hwLayers[i].hints = 0;
+        switch (assignment->plane[k]) {
+        case IntelLayerAssigner::PLANE_OVERLAY:
+            if (isOverlayLayer(list, i, layer, flags)) {
+                ret = overlayPrepare(i, layer, flags);
+                if (!ret) {
+                    ALOGE("%s: failed to prepare overlay\n", __func__);
+                    layer->compositionType = HWC_FRAMEBUFFER;
+                    layer->hints = 0;
+                }
+            } else {
+                layer->compositionType = HWC_FRAMEBUFFER;
             }
-        } else if (hasRGBOverlay &&
-                   isRGBOverlayLayer(list, i, &list->hwLayers[i], flags)) {
-            ret = rgbOverlayPrepare(i, &list->hwLayers[i], flags);
-            if (!ret) {
-                ALOGE("%s: failed to prepare RGB overlay\n", __func__);
-                list->hwLayers[i].compositionType = HWC_FRAMEBUFFER;
-                list->hwLayers[i].hints = 0;
+            break;
+        case IntelLayerAssigner::PLANE_RGB_OVERLAY:
+            if (mPlaneManager->hasFreeRGBOverlays() &&
+                isRGBOverlayLayer(list, i, layer, flags)) {
+                ret = rgbOverlayPrepare(i, layer, flags);
+                if (!ret) {
+                    ALOGE("%s: failed to prepare RGB overlay\n", __func__);
+                    layer->compositionType = HWC_FRAMEBUFFER;
+                    layer->hints = 0;
+                }
+            } else {
+                layer->compositionType = HWC_FRAMEBUFFER;
             }
-        } else if (hasSprite && isSpriteLayer(list, i, &list->hwLayers[i], flags)) {
-            ret = spritePrepare(i, &list->hwLayers[i], flags);
-            if (!ret) {
-                ALOGE("%s: failed to prepare sprite\n", __func__);
-                list->hwLayers[i].compositionType = HWC_FRAMEBUFFER;
-                list->hwLayers[i].hints = 0;
+            break;
+        case IntelLayerAssigner::PLANE_SPRITE:
+            if (mPlaneManager->hasFreeSprites() &&
+                isSpriteLayer(list, i, layer, flags)) {
+                ret = spritePrepare(i, layer, flags);
+                if (!ret) {
+                    ALOGE("%s: failed to prepare sprite\n", __func__);
+                    layer->compositionType = HWC_FRAMEBUFFER;
+                    layer->hints = 0;
+                }
+            } else {
+                layer->compositionType = HWC_FRAMEBUFFER;
             }
-        } else {
-            list->hwLayers[i].compositionType = HWC_FRAMEBUFFER;
+            break;
+        default:
+            layer->compositionType = HWC_FRAMEBUFFER;
+            break;
         }
     }
 
@@ -609,9 +769,11 @@ bool IntelMIPIDisplayDevice::prepare(hwc_display_contents_1_t *list)
     // handle geometry changing. attach display planes to layers
     // which can be handled by HWC.
     // plane control information (e.g. position) will be set here
+    bool replanned = false;
     if (!list || (list->flags & HWC_GEOMETRY_CHANGED) ||
             mHotplugEvent || forceCheckingList || isPlayerStatusChanged) {
         onGeometryChanged(list);
+        replanned = true;
         mHotplugEvent = false;
         mExtendedModeInfo->videoSentToWidi = mVideoSentToWidi;
 
@@ -646,7 +808,7 @@ bool IntelMIPIDisplayDevice::prepare(hwc_display_contents_1_t *list)
         revisitLayerList(list, false);
     }
 
-    handleSmartComposition(list);
+    handleSmartComposition(list, replanned);
 
     if (list && (list->flags & HWC_GEOMETRY_CHANGED))
 	    memset(&mPrevFlipHandles[0], 0, sizeof(mPrevFlipHandles));
@@ -654,22 +816,32 @@ bool IntelMIPIDisplayDevice::prepare(hwc_display_contents_1_t *list)
     return true;
 }
 
-void IntelMIPIDisplayDevice::handleSmartComposition(hwc_display_contents_1_t *list)
+void IntelMIPIDisplayDevice::handleSmartComposition(hwc_display_contents_1_t *list,
+                                                    bool replanned)
 {
     int i;
-    bool bDirty = false;
+    bool geometryChanged;
+
+    mSkipFlip = false;
 
     if (!list) return;
 
-    // when geometry change, set layer dirty to switch out smart composition,
-    // also update GLES composition status for later using.
+    int numLayers = list->numHwLayers - 1;
+    // planes may have moved without HWC_GEOMETRY_CHANGED (hotplug, video
+    // seeking or player status), the previous frame tells nothing then
+    geometryChanged = replanned || (list->flags & HWC_GEOMETRY_CHANGED);
+
+    // when geometry change, compositionType was reset by surface flinger
+    // and smart composition restarts. Also update GLES composition status
+    // for later using.
     // BZ96412: Video layer compositionType is maybe changed in non-geometry
     // prepare, exclude it from smart composition.
-    if (list->flags & HWC_GEOMETRY_CHANGED) {
-        bDirty = true;
+    if (geometryChanged) {
+        mSmartLayerMask = 0;
+        mSkipComposition = false;
         mHasGlesComposition = false;
         mHasSkipLayer = false;
-        for (i = 0; i < list->numHwLayers - 1; i++) {
+        for (i = 0; i < numLayers; i++) {
             mHasGlesComposition = mHasGlesComposition ||
                 (list->hwLayers[i].compositionType == HWC_FRAMEBUFFER &&
                  mLayerList->getLayerType(i) != IntelHWComposerLayer::LAYER_TYPE_YUV);
@@ -678,36 +850,83 @@ void IntelMIPIDisplayDevice::handleSmartComposition(hwc_display_contents_1_t *li
         }
     }
 
-    // Only check if there is YUV overlay, has composition on framebuffer
-    // and the layer number is limited.
-    if (mYUVOverlay < 0 || !mHasGlesComposition || mHasSkipLayer ||
-        list->numHwLayers > 6 || list->numHwLayers < 4){
-        ALOGD_IF(mSkipComposition, "Leave smart composition mode");
+    drmModeFBPtr fbInfo = mDrm->getOutputFBInfo(OUTPUT_MIPI0);
+    if (fbInfo)
+        mDamageTracker.setScreenSize(fbInfo->width, fbInfo->height);
+
+    IntelDamageTracker::LayerState states[IntelDamageTracker::MAX_LAYERS];
+    for (i = 0; i < numLayers && i < IntelDamageTracker::MAX_LAYERS; i++) {
+        hwc_layer_1_t *layer = &list->hwLayers[i];
+        IntelDamageTracker::LayerState& state = states[i];
+
+        state.handle = (uintptr_t)layer->handle;
+        state.crop.left = (int)layer->sourceCropf.left;
+        state.crop.top = (int)layer->sourceCropf.top;
+        state.crop.right = (int)layer->sourceCropf.right;
+        state.crop.bottom = (int)layer->sourceCropf.bottom;
+        state.frame.left = layer->displayFrame.left;
+        state.frame.top = layer->displayFrame.top;
+        state.frame.right = layer->displayFrame.right;
+        state.frame.bottom = layer->displayFrame.bottom;
+        state.transform = layer->transform;
+        state.blending = layer->blending;
+        state.planeAlpha = layer->planeAlpha;
+        // layers switched to HWC_OVERLAY by smart composition still
+        // belong to the framebuffer target
+        state.composed = layer->compositionType == HWC_FRAMEBUFFER ||
+                         (mSmartLayerMask & (1 << i));
+    }
+
+    int damage = mDamageTracker.update(states, numLayers, geometryChanged);
+
+    // Only skip composition if there is composition on framebuffer, no
+    // layer whose content is unknown to us, and a list we can track.
+    if (!mHasGlesComposition || mHasSkipLayer ||
+        numLayers > IntelDamageTracker::MAX_LAYERS) {
+        if (mSkipComposition) {
+            ALOGD_IF(ALLOW_HWC_PRINT, "Leave smart composition mode");
+            for (i = 0; i < numLayers; i++) {
+                if (mSmartLayerMask & (1 << i))
+                    list->hwLayers[i].compositionType = HWC_FRAMEBUFFER;
+            }
+        }
+        mSmartLayerMask = 0;
         mSkipComposition = false;
         return;
     }
 
-    // check layer update except FB_TARGET and YUV overlay
-    for (i = 0; i < list->numHwLayers - 1; i++) {
-        bDirty = bDirty ||
-            (i != mYUVOverlay && list->hwLayers[i].handle != mLastHandles[i]);
-        mLastHandles[i] = list->hwLayers[i].handle;
-    }
+    bool composedDirty = mDamageTracker.isComposedDirty();
 
     // Smart composition state change
-    if (mSkipComposition == bDirty) {
+    if (mSkipComposition == composedDirty) {
         mSkipComposition = !mSkipComposition;
 
-        if (mSkipComposition)
+        if (mSkipComposition) {
             ALOGD_IF(ALLOW_HWC_PRINT, "Enter smart composition mode");
-        else
+            for (i = 0; i < numLayers; i++) {
+                hwc_layer_1_t *layer = &list->hwLayers[i];
+                if (layer->compositionType == HWC_FRAMEBUFFER &&
+                    mLayerList->getLayerType(i) != IntelHWComposerLayer::LAYER_TYPE_YUV) {
+                    layer->compositionType = HWC_OVERLAY;
+                    mSmartLayerMask |= (1 << i);
+                }
+            }
+        } else {
             ALOGD_IF(ALLOW_HWC_PRINT, "Leave smart composition mode");
+            for (i = 0; i < numLayers; i++) {
+                if (mSmartLayerMask & (1 << i))
+                    list->hwLayers[i].compositionType = HWC_FRAMEBUFFER;
+            }
+            mSmartLayerMask = 0;
+        }
+    }
 
-        // Update compositeType
-        for (i = 0; i < list->numHwLayers - 1; i++) {
-            if (i != mYUVOverlay)
-                list->hwLayers[i].compositionType =
-                        mSkipComposition ? HWC_OVERLAY : HWC_FRAMEBUFFER;
+    if (mSkipComposition) {
+        mSkippedCompositions++;
+        // nothing changed at all, no plane needs to be flipped either
+        if (damage == IntelDamageTracker::DAMAGE_NONE) {
+            mSkipFlip = true;
+            mSkippedFlips++;
         }
     }
 }
@@ -734,6 +953,13 @@ bool IntelMIPIDisplayDevice::commit(hwc_display_contents_1_t *list,
     if (mHotplugEvent)
         return true;
 
+    // nothing was damaged since the last frame, keep scanning out the
+    // buffers already on screen
+    if (mSkipFlip) {
+        ALOGD_IF(ALLOW_HWC_PRINT, "%s: no damage, skip flip\n", __func__);
+        return true;
+    }
+
     void *context = mPlaneManager->getPlaneContexts();
     if (!context) {
         ALOGE("%s: invalid plane contexts\n", __func__);
@@ -933,6 +1159,19 @@ bool IntelMIPIDisplayDevice::dump(char *buff,
        dumpPrintf("  + mForceSwapBuffer: %d \n", mForceSwapBuffer);
        dumpPrintf("  + mForceSwapBuffer: %d \n", mForceSwapBuffer);
        dumpPrintf("  + Display Mode: %d \n", mDrm->getDisplayMode());
+       dumpPrintf("  + Smart composition: %d, skipped compositions: %d, "
+                  "skipped flips: %d \n", mSkipComposition,
+                  mSkippedCompositions, mSkippedFlips);
+       dumpPrintf("  + Damage frames: %d, no damage: %d, partial: %d, "
+                  "full: %d \n",
+                  mDamageTracker.getFrameCount(),
+                  mDamageTracker.getNoDamageCount(),
+                  mDamageTracker.getPartialCount(),
+                  mDamageTracker.getFullCount());
+       dumpPrintf("  + Plane assigner solves: %d, cache hits: %d, nodes: %d \n",
+                  mLayerAssigner.getSolveCount(),
+                  mLayerAssigner.getCacheHits(),
+                  mLayerAssigner.getNodesVisited());
     }
 
     *cur_len = mDumpLen;
@@ -16,3 +16,33 @@ LOCAL_MODULE:= hwc-overlay
 LOCAL_MODULE_TAGS := eng
 
 include $(BUILD_EXECUTABLE)
+
+# host test and latency benchmark for the plane assigner
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	layer_assigner_test.cpp \
+	../IntelLayerAssigner.cpp
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+
+LOCAL_MODULE:= hwc-layer-assigner-test
+
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# host test for the frame damage tracker
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	damage_tracker_test.cpp \
+	../IntelDamageTracker.cpp
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+
+LOCAL_MODULE:= hwc-damage-tracker-test
+
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_HOST_EXECUTABLE)
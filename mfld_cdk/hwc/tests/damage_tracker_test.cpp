@@ -0,0 +1,194 @@
+/*
+ * Copyright © 2012 Intel Corporation
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+// Host test for IntelDamageTracker.
+//
+// usage: hwc-damage-tracker-test
+
+#include <stdio.h>
+#include <string.h>
+
+#include <IntelDamageTracker.h>
+
+typedef IntelDamageTracker DT;
+
+static int sFailures = 0;
+
+#define CHECK(cond) do {                                            \
+    if (!(cond)) {                                                  \
+        printf("[FAIL] %s:%d: %s\n", __FILE__, __LINE__, #cond);    \
+        sFailures++;                                                \
+    }                                                               \
+} while (0)
+
+static DT::LayerState makeLayer(uintptr_t handle, int l, int t, int r, int b,
+                                bool composed)
+{
+    DT::LayerState s;
+    memset(&s, 0, sizeof(s));
+    s.handle = handle;
+    s.crop.right = r - l;
+    s.crop.bottom = b - t;
+    s.frame.left = l;
+    s.frame.top = t;
+    s.frame.right = r;
+    s.frame.bottom = b;
+    s.planeAlpha = 0xff;
+    s.composed = composed;
+    return s;
+}
+
+static void testFirstFrameIsFull()
+{
+    DT tracker;
+    tracker.setScreenSize(600, 1024);
+
+    DT::LayerState layers[2] = {
+        makeLayer(1, 0, 0, 600, 1024, true),
+        makeLayer(2, 0, 0, 600, 25, true),
+    };
+
+    CHECK(tracker.update(layers, 2, false) == DT::DAMAGE_FULL);
+    CHECK(tracker.isComposedFull());
+    CHECK(tracker.getDirtyMask() == 0x3);
+}
+
+static void testIdleFrame()
+{
+    DT tracker;
+    tracker.setScreenSize(600, 1024);
+
+    DT::LayerState layers[2] = {
+        makeLayer(1, 0, 0, 600, 1024, true),
+        makeLayer(2, 0, 0, 600, 25, true),
+    };
+
+    tracker.update(layers, 2, true);
+    CHECK(tracker.update(layers, 2, false) == DT::DAMAGE_NONE);
+    CHECK(!tracker.isComposedDirty());
+    CHECK(tracker.getDirtyMask() == 0);
+    CHECK(tracker.getNoDamageCount() == 1);
+}
+
+static void testPartialComposedDamage()
+{
+    DT tracker;
+    tracker.setScreenSize(600, 1024);
+
+    DT::LayerState layers[2] = {
+        makeLayer(1, 0, 0, 600, 1024, true),
+        makeLayer(2, 0, 0, 600, 25, true),
+    };
+
+    tracker.update(layers, 2, true);
+
+    // status bar got a new buffer
+    layers[1].handle = 3;
+    CHECK(tracker.update(layers, 2, false) == DT::DAMAGE_PARTIAL);
+    CHECK(tracker.isComposedDirty());
+    CHECK(!tracker.isComposedFull());
+    const DT::Rect& r = tracker.getComposedDirtyRect();
+    CHECK(r.left == 0 && r.top == 0 && r.right == 600 && r.bottom == 25);
+    CHECK(tracker.getDirtyMask() == 0x2);
+}
+
+static void testOverlayFlipKeepsFramebuffer()
+{
+    DT tracker;
+    tracker.setScreenSize(600, 1024);
+
+    DT::LayerState layers[3] = {
+        makeLayer(1, 0, 200, 600, 600, false),      // video on overlay
+        makeLayer(2, 0, 900, 600, 1024, true),      // controls
+        makeLayer(3, 0, 0, 600, 25, true),          // status bar
+    };
+
+    tracker.update(layers, 3, true);
+
+    // new video frame, nothing composed changed
+    layers[0].handle = 4;
+    CHECK(tracker.update(layers, 3, false) == DT::DAMAGE_PARTIAL);
+    CHECK(!tracker.isComposedDirty());
+
+    // overlay moves, the hole in the framebuffer moves with it
+    layers[0].frame.top = 300;
+    layers[0].frame.bottom = 700;
+    tracker.update(layers, 3, false);
+    CHECK(tracker.isComposedDirty());
+    const DT::Rect& r = tracker.getComposedDirtyRect();
+    CHECK(r.top == 200 && r.bottom == 700);
+}
+
+static void testStateChanges()
+{
+    DT tracker;
+    tracker.setScreenSize(600, 1024);
+
+    DT::LayerState layer = makeLayer(1, 100, 100, 200, 200, true);
+    tracker.update(&layer, 1, true);
+
+    layer.planeAlpha = 0x80;
+    CHECK(tracker.update(&layer, 1, false) == DT::DAMAGE_PARTIAL);
+
+    layer.transform = 4;
+    CHECK(tracker.update(&layer, 1, false) == DT::DAMAGE_PARTIAL);
+
+    layer.crop.left = 10;
+    CHECK(tracker.update(&layer, 1, false) == DT::DAMAGE_PARTIAL);
+
+    CHECK(tracker.update(&layer, 1, false) == DT::DAMAGE_NONE);
+}
+
+static void testListChanges()
+{
+    DT tracker;
+    tracker.setScreenSize(600, 1024);
+
+    DT::LayerState layers[2] = {
+        makeLayer(1, 0, 0, 600, 1024, true),
+        makeLayer(2, 0, 0, 600, 25, true),
+    };
+
+    tracker.update(layers, 2, true);
+    CHECK(tracker.update(layers, 1, false) == DT::DAMAGE_FULL);
+    CHECK(tracker.update(layers, 1, true) == DT::DAMAGE_FULL);
+
+    tracker.reset();
+    CHECK(tracker.update(layers, 1, false) == DT::DAMAGE_FULL);
+    CHECK(tracker.update(layers, 1, false) == DT::DAMAGE_NONE);
+}
+
+int main()
+{
+    testFirstFrameIsFull();
+    testIdleFrame();
+    testPartialComposedDamage();
+    testOverlayFlipKeepsFramebuffer();
+    testStateChanges();
+    testListChanges();
+
+    printf("%s: %d failure(s)\n", sFailures ? "FAIL" : "PASS", sFailures);
+    return sFailures ? 1 : 0;
+}
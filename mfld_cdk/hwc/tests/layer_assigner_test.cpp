@@ -0,0 +1,330 @@
+/*
+ * Copyright © 2012 Intel Corporation
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+// Host test and prepare() latency benchmark for IntelLayerAssigner.
+//
+// usage: hwc-layer-assigner-test [layer list file ...]
+//
+// Without arguments the built-in recorded layer lists are checked against
+// their expected assignments. A layer list file holds one layer per line,
+// bottom to top, '#' starts a comment and an empty line ends a list:
+//   left top right bottom srcW srcH bpp candidates mustUseHW
+// where candidates is a string of o (overlay), r (RGB overlay), s (sprite)
+// or '-' for GLES only.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <IntelLayerAssigner.h>
+
+typedef IntelLayerAssigner IA;
+
+#define O (1 << IA::PLANE_OVERLAY)
+#define R (1 << IA::PLANE_RGB_OVERLAY)
+#define S (1 << IA::PLANE_SPRITE)
+#define G IA::PLANE_GLES
+
+struct RecordedList {
+    const char *name;
+    int numLayers;
+    IA::LayerInfo layers[IA::MAX_LAYERS];
+    int expected[IA::MAX_LAYERS];
+};
+
+// Lists recorded from dumpsys SurfaceFlinger on a 600x1024 panel
+static const RecordedList sRecorded[] = {
+    {
+        "launcher: wallpaper, icons, status bar, nav bar",
+        4,
+        {
+            { {0, 0, 600, 1024}, 600, 1024, 32, S, false },
+            { {0, 25, 600, 976}, 600, 951, 32, 0, false },
+            { {0, 0, 600, 25}, 600, 25, 32, S | R, false },
+            { {0, 976, 600, 1024}, 600, 48, 32, S | R, false },
+        },
+        // wallpaper is covered by the GLES icons, it must stay in GLES
+        { G, G, IA::PLANE_SPRITE, IA::PLANE_RGB_OVERLAY },
+    },
+    {
+        "video playback: video, controls, status bar",
+        3,
+        {
+            { {0, 0, 600, 1024}, 1280, 720, 12, O, false },
+            { {0, 900, 600, 1024}, 600, 124, 32, 0, false },
+            { {0, 0, 600, 25}, 600, 25, 32, S, false },
+        },
+        { IA::PLANE_OVERLAY, G, IA::PLANE_SPRITE },
+    },
+    {
+        "sandwiched video: wallpaper, video, dialog",
+        3,
+        {
+            { {0, 0, 600, 1024}, 600, 1024, 32, 0, false },
+            { {0, 200, 600, 600}, 1280, 720, 12, O, false },
+            { {100, 300, 500, 500}, 400, 200, 32, 0, false },
+        },
+        // overlay is above the framebuffer when not on the bottom layer,
+        // it would hide the GLES dialog
+        { G, G, G },
+    },
+    {
+        "video over wallpaper",
+        2,
+        {
+            { {0, 0, 600, 1024}, 600, 1024, 32, 0, false },
+            { {0, 200, 600, 600}, 1280, 720, 12, O, false },
+        },
+        // overlay goes above the framebuffer holding the wallpaper
+        { G, IA::PLANE_OVERLAY },
+    },
+    {
+        "protected video: forced overlay with GLES below",
+        2,
+        {
+            { {0, 0, 600, 1024}, 600, 1024, 32, 0, false },
+            { {0, 200, 600, 600}, 1920, 1080, 12, O, true },
+        },
+        { G, IA::PLANE_OVERLAY },
+    },
+    {
+        "protected video under GLES controls, wallpaper below",
+        3,
+        {
+            { {0, 0, 600, 1024}, 600, 1024, 32, 0, false },
+            { {0, 200, 600, 600}, 1920, 1080, 12, O, true },
+            { {0, 500, 600, 600}, 600, 100, 32, 0, false },
+        },
+        // no valid ordering exists, greedy keeps the protected layer on HW
+        { G, IA::PLANE_OVERLAY, G },
+    },
+    {
+        "two sprites competing for one plane",
+        3,
+        {
+            { {0, 0, 600, 1024}, 600, 1024, 32, 0, false },
+            { {0, 0, 600, 100}, 600, 100, 32, S, false },
+            { {0, 900, 600, 1024}, 600, 124, 32, S, false },
+        },
+        // the larger layer wins the single sprite
+        { G, G, IA::PLANE_SPRITE },
+    },
+};
+
+static void setupCaps(IA& assigner)
+{
+    assigner.setScreenSize(600, 1024);
+    assigner.setPlaneCaps(IA::PLANE_OVERLAY, 1, IA::RANK_ZORDER_FB,
+                          IA::PLANE_OVERLAY, false);
+    assigner.setPlaneCaps(IA::PLANE_RGB_OVERLAY, 1, IA::RANK_ABOVE_FB,
+                          IA::PLANE_OVERLAY, false);
+    assigner.setPlaneCaps(IA::PLANE_SPRITE, 1, IA::RANK_ABOVE_FB,
+                          IA::PLANE_SPRITE, false);
+}
+
+static const char *planeName(int plane)
+{
+    switch (plane) {
+    case IA::PLANE_GLES: return "gles";
+    case IA::PLANE_OVERLAY: return "overlay";
+    case IA::PLANE_RGB_OVERLAY: return "rgb-overlay";
+    case IA::PLANE_SPRITE: return "sprite";
+    case IA::PLANE_PRIMARY: return "primary";
+    default: return "?";
+    }
+}
+
+static int64_t nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void printAssignment(const IA::Assignment& a)
+{
+    for (int i = 0; i < a.numLayers; i++)
+        printf("    layer %d -> %s\n", i, planeName(a.plane[i]));
+    printf("    gles pixels %lld, bandwidth %lld bytes, cost %lld\n",
+           (long long)a.glesPixels, (long long)a.bandwidth,
+           (long long)a.cost);
+}
+
+static bool checkRecorded()
+{
+    bool pass = true;
+
+    for (size_t n = 0; n < sizeof(sRecorded) / sizeof(sRecorded[0]); n++) {
+        const RecordedList& rec = sRecorded[n];
+        IA assigner;
+        setupCaps(assigner);
+
+        const IA::Assignment& a = assigner.solve(rec.layers, rec.numLayers);
+        bool ok = a.valid && a.numLayers == rec.numLayers;
+        for (int i = 0; ok && i < rec.numLayers; i++)
+            ok = (a.plane[i] == rec.expected[i]);
+
+        // same geometry again must come from the cache
+        assigner.solve(rec.layers, rec.numLayers);
+        ok = ok && assigner.getCacheHits() == 1 &&
+             assigner.getSolveCount() == 1;
+
+        printf("[%s] %s\n", ok ? "PASS" : "FAIL", rec.name);
+        if (!ok) {
+            printAssignment(a);
+            pass = false;
+        }
+    }
+
+    // sandwich detection
+    const RecordedList& sandwich = sRecorded[2];
+    bool ok = IA::isSandwiched(sandwich.layers, sandwich.numLayers, 1) &&
+              !IA::isSandwiched(sandwich.layers, sandwich.numLayers, 0) &&
+              !IA::isSandwiched(sandwich.layers, sandwich.numLayers, 2);
+    printf("[%s] sandwich detection\n", ok ? "PASS" : "FAIL");
+
+    return pass && ok;
+}
+
+static void benchmark(const IA::LayerInfo *layers, int numLayers,
+                      const char *name)
+{
+    const int iterations = 20000;
+    IA assigner;
+    setupCaps(assigner);
+
+    // geometry change on every frame, the memo is dropped each time
+    int64_t start = nowNs();
+    for (int i = 0; i < iterations; i++) {
+        assigner.invalidate();
+        assigner.solve(layers, numLayers);
+    }
+    int64_t cold = (nowNs() - start) / iterations;
+
+    // geometry unchanged, answered from the memo
+    start = nowNs();
+    for (int i = 0; i < iterations; i++)
+        assigner.solve(layers, numLayers);
+    int64_t warm = (nowNs() - start) / iterations;
+
+    printf("  %-50s %2d layers: solve %6lld ns, memoized %4lld ns, "
+           "%u nodes/solve\n", name, numLayers,
+           (long long)cold, (long long)warm,
+           assigner.getNodesVisited() / assigner.getSolveCount());
+}
+
+static int parseCandidates(const char *s)
+{
+    int mask = 0;
+    for (; *s; s++) {
+        switch (*s) {
+        case 'o': mask |= O; break;
+        case 'r': mask |= R; break;
+        case 's': mask |= S; break;
+        default: break;
+        }
+    }
+    return mask;
+}
+
+static bool runFile(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        printf("failed to open %s\n", path);
+        return false;
+    }
+
+    IA::LayerInfo layers[IA::MAX_LAYERS];
+    int numLayers = 0;
+    int listIndex = 0;
+    char line[256];
+    bool more = true;
+
+    while (more) {
+        more = fgets(line, sizeof(line), fp) != NULL;
+
+        IA::LayerInfo l;
+        char cand[16];
+        int must = 0;
+        if (more && line[0] != '#' &&
+            sscanf(line, "%d %d %d %d %d %d %d %15s %d",
+                   &l.frame.left, &l.frame.top, &l.frame.right,
+                   &l.frame.bottom, &l.srcWidth, &l.srcHeight,
+                   &l.bitsPerPixel, cand, &must) >= 8) {
+            l.candidates = parseCandidates(cand);
+            l.mustUseHW = must != 0;
+            if (numLayers < IA::MAX_LAYERS)
+                layers[numLayers++] = l;
+            continue;
+        }
+
+        if ((!more || line[0] == '\n') && numLayers) {
+            char name[64];
+            snprintf(name, sizeof(name), "%s #%d", path, listIndex++);
+
+            IA assigner;
+            setupCaps(assigner);
+            printf("%s\n", name);
+            printAssignment(assigner.solve(layers, numLayers));
+            benchmark(layers, numLayers, name);
+            numLayers = 0;
+        }
+    }
+
+    fclose(fp);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) {
+        bool ok = true;
+        for (int i = 1; i < argc; i++)
+            ok = runFile(argv[i]) && ok;
+        return ok ? 0 : 1;
+    }
+
+    bool pass = checkRecorded();
+
+    printf("prepare() plane assignment latency:\n");
+    for (size_t n = 0; n < sizeof(sRecorded) / sizeof(sRecorded[0]); n++)
+        benchmark(sRecorded[n].layers, sRecorded[n].numLayers,
+                  sRecorded[n].name);
+
+    // a long list of small RGB widgets to exercise the search bound
+    IA::LayerInfo many[IA::MAX_LAYERS];
+    for (int i = 0; i < IA::MAX_LAYERS; i++) {
+        IA::LayerInfo l = { {(i % 4) * 150, (i / 4) * 256,
+                             (i % 4) * 150 + 160, (i / 4) * 256 + 266},
+                            160, 266, 32, S | R, false };
+        many[i] = l;
+    }
+    benchmark(many, IA::MAX_SEARCH_LAYERS, "widgets (exhaustive)");
+    benchmark(many, IA::MAX_LAYERS, "widgets (greedy)");
+
+    return pass ? 0 : 1;
+}
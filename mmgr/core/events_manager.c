@@ -162,6 +162,10 @@ e_mmgr_errors_t events_start(mmgr_data_t *mmgr, int inst_id)
     if (E_ERR_SUCCESS != ret)
         goto out;
 
+    ret = tty_listen_fd(mmgr->epollfd, timer_get_fd(mmgr->timer), EPOLLIN);
+    if (E_ERR_SUCCESS != ret)
+        goto out;
+
     ret = tty_listen_fd(mmgr->epollfd, mdm_flash_get_fd(mmgr->flash),
                         EPOLLIN);
     if (ret != E_ERR_SUCCESS)
@@ -214,8 +218,7 @@ static e_mmgr_errors_t wait_for_event(mmgr_data_t *mmgr)
             LOG_INFO("Waiting for a new event");
             mmgr->events.nfds = epoll_wait(mmgr->epollfd, mmgr->events.ev,
                                            clients_get_allowed(mmgr->clients)
-                                           + 1,
-                                           timer_get_timeout(mmgr->timer));
+                                           + 1, -1);
             if (mmgr->events.nfds == -1) {
                 if ((errno == EBADF) || (errno == EINVAL)) {
                     LOG_ERROR("Bad configuration");
@@ -237,6 +240,8 @@ static e_mmgr_errors_t wait_for_event(mmgr_data_t *mmgr)
             mmgr->events.state = E_EVENT_IPC;
         else if (fd == mdm_mcd_get_fd(mmgr->mcd))
             mmgr->events.state = E_EVENT_MCD;
+        else if (fd == timer_get_fd(mmgr->timer))
+            mmgr->events.state = E_EVENT_TIMEOUT;
         else if (fd == bus_ev_get_fd(mmgr->events.bus_events))
             mmgr->events.state = E_EVENT_BUS;
         else if (fd == secure_get_fd(mmgr->secure))
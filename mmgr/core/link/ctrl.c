@@ -19,7 +19,6 @@
 #include "ctrl.h"
 #include "logs.h"
 #include "file.h"
-#include "delay_do.h"
 
 #include <string.h>
 
@@ -31,8 +30,12 @@ typedef struct ctrl_link {
 typedef struct ctrl_ctx {
     ctrl_link_t mdm;
     ctrl_link_t cd;
+    wheel_hdle_t *wheel;
+    wheel_timer_t reset; /* delayed ctrl_on_mdm_reset */
 } ctrl_ctx_t;
 
+static void ctrl_on_mdm_reset_elapsed(wheel_timer_t *timer, void *ctx);
+
 typedef enum e_ctrl_action {
     E_ACTION_ON,
     E_ACTION_OFF,
@@ -53,12 +56,14 @@ static inline void fill_ctrl_link(ctrl_link_t *link, e_link_t type,
  * @param [in] mdm_ctrl modem control link data
  * @param [in] cd_type core dump link type
  * @param [in] cd_ctrl core dump control link data
+ * @param [in] wheel timer wheel running the delayed operations
  *
  * @return NULL if module initialization has failed
  * @return valid ctrl_handle_t pointer otherwise
  */
 ctrl_handle_t ctrl_init(e_link_t mdm_type, const link_ctrl_t *mdm_ctrl,
-                        e_link_t cd_type, const link_ctrl_t *cd_ctrl)
+                        e_link_t cd_type, const link_ctrl_t *cd_ctrl,
+                        wheel_hdle_t *wheel)
 {
     ctrl_ctx_t *ctx = NULL;
 
@@ -67,6 +72,9 @@ ctrl_handle_t ctrl_init(e_link_t mdm_type, const link_ctrl_t *mdm_ctrl,
         if (ctx) {
             fill_ctrl_link(&ctx->mdm, mdm_type, mdm_ctrl);
             fill_ctrl_link(&ctx->cd, cd_type, cd_ctrl);
+            ctx->wheel = wheel;
+            wheel_timer_init(&ctx->reset, "CTRL_MDM_RESET",
+                             ctrl_on_mdm_reset_elapsed, ctx);
         } else {
             LOG_ERROR("memory allocation failed");
             goto err;
@@ -204,11 +212,18 @@ static e_mmgr_errors_t ctrl_on_mdm_reset_op(ctrl_ctx_t *ctx)
     return ret;
 }
 
+static void ctrl_on_mdm_reset_elapsed(wheel_timer_t *timer, void *ctx)
+{
+    (void)timer;
+    ctrl_on_mdm_reset_op((ctrl_ctx_t *)ctx);
+}
+
 /**
  * Performs the right link control operation when modem is reset
  *
  * @param [in] h power management handle
- * @param [in] delay delay in seconds before starting the operation
+ * @param [in] delay delay in seconds before starting the operation. A
+ *                   pending delayed operation is rescheduled
  *
  * @return E_ERR_SUCCESS if successful
  */
@@ -220,13 +235,7 @@ e_mmgr_errors_t ctrl_on_mdm_reset(ctrl_handle_t *h, int delay)
     ASSERT(ctx != NULL);
 
     if (delay > 0) {
-        pthread_t thr;
-        static delay_t op;
-        op.delay_sec = delay;
-        op.h = ctx;
-        op.fn = (void (*)(void *))(ctrl_on_mdm_reset_op);
-        pthread_create(&thr, NULL, delay_do, &op);
-        pthread_detach(thr);
+        wheel_start(ctx->wheel, &ctx->reset, delay * 1000);
     } else {
         ret = ctrl_on_mdm_reset_op(ctx);
     }
@@ -21,11 +21,13 @@
 
 #include "errors.h"
 #include "tcs_mmgr.h"
+#include "wheel.h"
 
 typedef void *ctrl_handle_t;
 
 ctrl_handle_t ctrl_init(e_link_t mdm_type, const link_ctrl_t *mdm_ctrl,
-                        e_link_t cd_type, const link_ctrl_t *cd_ctrl);
+                        e_link_t cd_type, const link_ctrl_t *cd_ctrl,
+                        wheel_hdle_t *wheel);
 
 e_mmgr_errors_t ctrl_dispose(ctrl_handle_t *h);
 
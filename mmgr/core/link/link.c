@@ -388,11 +388,13 @@ int link_get_ebl_baudrate(const link_hdle_t *hdle)
  * @param [in] mcdr core dump configuration. Provided by TCS
  * @param [in] bus_ev bus event handler
  * @param [in] ssic_hack @TODO: remove this
+ * @param [in] wheel timer wheel running the delayed operations
  *
  * @return valid pointer. Must be freed by calling link_dipose.
  */
 link_hdle_t *link_init(const mmgr_mdm_link_t *links, const mcdr_info_t *mcdr,
-                       const bus_ev_hdle_t *bus_ev, bool ssic_hack)
+                       const bus_ev_hdle_t *bus_ev, bool ssic_hack,
+                       wheel_hdle_t *wheel)
 {
     link_ctx_t *link = calloc(1, sizeof(link_ctx_t));
 
@@ -408,7 +410,7 @@ link_hdle_t *link_init(const mmgr_mdm_link_t *links, const mcdr_info_t *mcdr,
     link->cd_type = mcdr->link.type;
 
     link->ctrl = ctrl_init(links->baseband.type, &links->ctrl,
-                           mcdr->link.type, &mcdr->ctrl);
+                           mcdr->link.type, &mcdr->ctrl, wheel);
     link->pm = pm_init(links->baseband.type, &links->power,
                        mcdr->link.type, &mcdr->power);
 
@@ -23,11 +23,13 @@
 #include "bus_events.h"
 #include "errors.h"
 #include "tcs_mmgr.h"
+#include "wheel.h"
 
 typedef void *link_hdle_t;
 
 link_hdle_t *link_init(const mmgr_mdm_link_t *links, const mcdr_info_t *mcdr,
-                       const bus_ev_hdle_t *bus_ev, bool ssic_hack);
+                       const bus_ev_hdle_t *bus_ev, bool ssic_hack,
+                       wheel_hdle_t *wheel);
 void link_dispose(link_hdle_t *hdle);
 
 e_mmgr_errors_t link_on_mdm_down(const link_hdle_t *hdle);
@@ -22,7 +22,6 @@
 
 #include "logs.h"
 #include "mdm_mcd.h"
-#include "delay_do.h"
 #include "common.h"
 
 typedef struct mmgr_mcd_ctx {
@@ -33,8 +32,16 @@ typedef struct mmgr_mcd_ctx {
     bool ipc_ready_present;
     int filter;
     link_hdle_t *link;
+    wheel_hdle_t *wheel;
+    wheel_timer_t power_on; /* SSIC cold reset */
 } mmgr_mcd_ctx_t;
 
+static void mdm_mcd_power_on(wheel_timer_t *timer, void *ctx)
+{
+    (void)timer;
+    mdm_mcd_up((mdm_mcd_hdle_t *)ctx);
+}
+
 /**
  * Turns off the modem when the modem is declared out of service by MMGR.
  * In some platforms, the modem cannot be turned off. That is why a cold
@@ -83,13 +90,8 @@ e_mmgr_errors_t mdm_mcd_cold_reset(const mdm_mcd_hdle_t *hdle)
         if (!ioctl(mcd->fd, MDM_CTRL_POWER_OFF)) {
             LOG_INFO("MODEM OFF");
             /* wait for usb ssic interface to be removed */
-            pthread_t thr;
-            static delay_t cold_reset;
-            cold_reset.delay_sec = 8;
-            cold_reset.h = (void *)hdle;
-            cold_reset.fn = (void (*)(void *))(mdm_mcd_up);
-            pthread_create(&thr, NULL, delay_do, &cold_reset);
-            pthread_detach(thr);
+            wheel_start(mcd->wheel, &((mmgr_mcd_ctx_t *)mcd)->power_on,
+                        8000);
         } else {
             LOG_ERROR("couldn't power off modem: %s", strerror(errno));
             ret = E_ERR_FAILED;
@@ -386,6 +388,7 @@ bool mdm_mcd_is_ipc_ready_present(const mdm_mcd_hdle_t *hdle)
  * @param [in] link link control module
  * @param [in] off_allowed off_allowed boolean
  * @param [in] ssic_hack
+ * @param [in] wheel timer wheel running the delayed operations
  *
  * @return a valid pointer. must be freed by user
  */
@@ -393,7 +396,8 @@ mdm_mcd_hdle_t *mdm_mcd_init(const mmgr_mcd_t *mcd_cfg,
                              const mdm_core_t *mdm_core,
                              link_hdle_t *link,
                              bool off_allowed,
-                             bool ssic_hack)
+                             bool ssic_hack,
+                             wheel_hdle_t *wheel)
 {
     mmgr_mcd_ctx_t *mcd = calloc(1, sizeof(mmgr_mcd_ctx_t));
 
@@ -415,6 +419,9 @@ mdm_mcd_hdle_t *mdm_mcd_init(const mmgr_mcd_t *mcd_cfg,
         mcd->link = link;
         mcd->off_allowed = off_allowed;
         mcd->ssic_hack = ssic_hack;
+        mcd->wheel = wheel;
+        wheel_timer_init(&mcd->power_on, "MCD_POWER_ON", mdm_mcd_power_on,
+                         mcd);
         mcd->flashless = mdm_core->flashless;
         mcd->ipc_ready_present = mcd_cfg->board == BOARD_AOB;
 
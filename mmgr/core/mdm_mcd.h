@@ -23,6 +23,7 @@
 #include "errors.h"
 #include "link.h"
 #include "tcs.h"
+#include "wheel.h"
 
 typedef void *mdm_mcd_hdle_t;
 
@@ -38,7 +39,8 @@ typedef enum e_modem_events_type {
 
 mdm_mcd_hdle_t *mdm_mcd_init(const mmgr_mcd_t *mcd_cfg,
                              const mdm_core_t *mdm_core, link_hdle_t *link,
-                             bool off_allowed, bool ssic_hack);
+                             bool off_allowed, bool ssic_hack,
+                             wheel_hdle_t *wheel);
 
 void mdm_mcd_dispose(mdm_mcd_hdle_t *hdle);
 
@@ -218,7 +218,8 @@ static void mmgr_init(mmgr_data_t *mmgr, int inst_id)
                             &mmgr_cfg->mcdr.link)) != NULL);
 
     ASSERT((mmgr->link = link_init(&mmgr_cfg->mdm_link, &mmgr_cfg->mcdr,
-                                   mmgr->events.bus_events, ssic_hack))
+                                   mmgr->events.bus_events, ssic_hack,
+                                   timer_get_wheel(mmgr->timer)))
            != NULL);
 
     ASSERT((mmgr->mdm_dlc = mdm_dlc_init(&mmgr_cfg->com,
@@ -228,7 +229,8 @@ static void mmgr_init(mmgr_data_t *mmgr, int inst_id)
     ASSERT(E_ERR_SUCCESS == events_init(mmgr_cfg->cli.max, mmgr));
 
     ASSERT((mmgr->mcd = mdm_mcd_init(&mmgr_cfg->mcd, &cfg->mdm[mdm_id].core,
-                                     mmgr->link, !mmgr->dsda, ssic_hack))
+                                     mmgr->link, !mmgr->dsda, ssic_hack,
+                                     timer_get_wheel(mmgr->timer)))
            != NULL);
 
     ASSERT((mmgr->fw = mdm_fw_init(inst_id, &cfg->mdm[mdm_id], &mmgr_cfg->fw))
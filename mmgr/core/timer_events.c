@@ -29,69 +29,65 @@ static const char const *g_type_str[] = {
     TIMER
 };
 
-#define TIMER_INFINITE -1       /* wait indefinitely */
-
 typedef struct mmgr_timer {
-    e_timer_type_t type;
     int timeout[E_TIMER_NUM]; /* in seconds */
-    struct timespec end[E_TIMER_NUM];
+    wheel_timer_t timers[E_TIMER_NUM];
+    unsigned int elapsed;     /* bitmap of elapsed e_timer_type_t */
+    wheel_hdle_t *wheel;
     const clients_hdle_t *clients;
 } mmgr_timer_t;
 
 /**
- * Returns remaining time (in seconds) between current time
- * and end timer
+ * Called by the wheel when a timer elapses. The timeout is handled by
+ * timer_event
  */
-static inline long timer_get_elapsed(struct timespec cur, struct timespec end)
+static void timer_elapsed(wheel_timer_t *timer, void *ctx)
 {
-    return ((end.tv_sec - cur.tv_sec) * 1000) +
-           ((end.tv_nsec - cur.tv_nsec) / 1000000);
+    mmgr_timer_t *t = (mmgr_timer_t *)ctx;
+
+    t->elapsed |= 0x1 << (timer - t->timers);
 }
 
 /**
  * Checks if timer has elapsed for a specific timer
  */
-static inline bool timer_is_elapsed(mmgr_timer_t *t, e_timer_type_t type,
-                                    struct timespec *cur)
+static inline bool timer_is_elapsed(mmgr_timer_t *t, e_timer_type_t type)
 {
-    return (t->type & (0x1 << type)) &&
-           (timer_get_elapsed(*cur, t->end[type]) <= 0);
+    return t->elapsed & (0x1 << type);
 }
 
 /**
- * @brief timer_get_timeout Return current timeout value
+ * @brief timer_get_fd Returns the file descriptor to poll. It is readable
+ * when a timer has elapsed and timer_event must be called then
  *
  * @param h timer module handle
  *
- * @return current timeout value otherwise (in milliseconds)
+ * @return file descriptor
  */
-int timer_get_timeout(timer_handle_t *h)
+int timer_get_fd(timer_handle_t *h)
 {
-    int min = TIMER_INFINITE;
     mmgr_timer_t *t = (mmgr_timer_t *)h;
 
     ASSERT(t != NULL);
 
-    if (t->type != 0x0) {
-        struct timespec cur;
-        clock_gettime(CLOCK_BOOTTIME, &cur);
-
-        for (int i = 0; i < E_TIMER_NUM; i++) {
-            if (t->type & (0x1 << i)) {
-                long diff = timer_get_elapsed(cur, t->end[i]);
-                if (diff < 0)
-                    diff = 0;
-
-                if (min == TIMER_INFINITE)
-                    min = diff;
-                else if (min > diff)
-                    min = diff;
-            }
-        }
-    }
+    return wheel_get_fd(t->wheel);
+}
+
+/**
+ * Returns the timer wheel, used by the other modules to schedule delayed
+ * operations. They are run by timer_event
+ *
+ * @param [in] h timer module handle
+ *
+ * @return the wheel handle
+ */
+wheel_hdle_t *timer_get_wheel(timer_handle_t *h)
+{
+    mmgr_timer_t *t = (mmgr_timer_t *)h;
+
+    ASSERT(t != NULL);
 
-    LOG_DEBUG("timeout: %d ms", min);
-    return min;
+    return t->wheel;
 }
 
 /**
@@ -104,18 +100,15 @@ int timer_get_timeout(timer_handle_t *h)
  */
 e_mmgr_errors_t timer_start(timer_handle_t *h, e_timer_type_t type)
 {
-    struct timespec current;
     mmgr_timer_t *timer = (mmgr_timer_t *)h;
 
     ASSERT(timer != NULL);
 
-    clock_gettime(CLOCK_BOOTTIME, &current);
-
     if (timer->timeout[type] != 0) {
         LOG_DEBUG("start timer for event: %s", g_type_str[type]);
-        timer->type |= 0x01 << type;
-        timer->end[type] = current;
-        timer->end[type].tv_sec += timer->timeout[type];
+        timer->elapsed &= ~(0x1 << type);
+        wheel_start(timer->wheel, &timer->timers[type],
+                    timer->timeout[type] * 1000);
     }
 
     return E_ERR_SUCCESS;
@@ -134,7 +127,9 @@ e_mmgr_errors_t timer_stop_all(timer_handle_t *h)
 
     ASSERT(timer != NULL);
 
-    timer->type = 0x0;
+    for (int i = 0; i < E_TIMER_NUM; i++)
+        wheel_stop(timer->wheel, &timer->timers[i]);
+    timer->elapsed = 0x0;
     LOG_DEBUG("timer stopped");
 
     return E_ERR_SUCCESS;
@@ -151,13 +146,17 @@ e_mmgr_errors_t timer_stop_all(timer_handle_t *h)
 e_mmgr_errors_t timer_stop(timer_handle_t *h, e_timer_type_t type)
 {
     mmgr_timer_t *timer = (mmgr_timer_t *)h;
+    bool running = false;
 
     ASSERT(timer != NULL);
 
     LOG_DEBUG("stop timer for event: %s", g_type_str[type]);
-    timer->type &= ~(0x01 << type);
+    wheel_stop(timer->wheel, &timer->timers[type]);
+    timer->elapsed &= ~(0x1 << type);
 
-    if (timer->type == 0x0)
+    for (int i = 0; i < E_TIMER_NUM; i++)
+        running |= wheel_is_running(&timer->timers[i]);
+    if (!running)
         LOG_DEBUG("All timers stopped");
 
     return E_ERR_SUCCESS;
@@ -176,7 +175,6 @@ e_mmgr_errors_t timer_event(timer_handle_t *h, e_mmgr_state_t state,
                             bool core_dump_signal_hw_working,
                             e_timer_mdm_action_t *action)
 {
-    struct timespec cur;
     mmgr_timer_t *t = (mmgr_timer_t *)h;
     bool handled = false;
 
@@ -186,23 +184,25 @@ e_mmgr_errors_t timer_event(timer_handle_t *h, e_mmgr_state_t state,
     /* Reset modem action */
     *action = E_TIMER_NO_ACTION;
 
-    clock_gettime(CLOCK_BOOTTIME, &cur);
+    /* runs the delayed operations of the other modules too */
+    if (wheel_expire(t->wheel) > 0 && !t->elapsed)
+        handled = true;
 
-    if (timer_is_elapsed(t, E_TIMER_COLD_RESET_ACK, &cur)) {
+    if (timer_is_elapsed(t, E_TIMER_COLD_RESET_ACK)) {
         handled = true;
         clients_has_ack_cold(t->clients, E_PRINT);
         timer_stop(h, E_TIMER_COLD_RESET_ACK);
         *action |= E_TIMER_RESET;
     }
 
-    if (timer_is_elapsed(t, E_TIMER_MODEM_SHUTDOWN_ACK, &cur)) {
+    if (timer_is_elapsed(t, E_TIMER_MODEM_SHUTDOWN_ACK)) {
         handled = true;
         clients_has_ack_shtdwn(t->clients, E_PRINT);
         timer_stop(h, E_TIMER_MODEM_SHUTDOWN_ACK);
         *action |= E_TIMER_RESET | E_TIMER_START_MDM_OFF;
     }
 
-    if (timer_is_elapsed(t, E_TIMER_WAIT_FOR_IPC_READY, &cur)) {
+    if (timer_is_elapsed(t, E_TIMER_WAIT_FOR_IPC_READY)) {
         mmgr_cli_fw_update_result_t result = { .id = E_MODEM_FW_READY_TIMEOUT };
         static const char *const msg = "IPC READY not received";
 
@@ -222,7 +222,7 @@ e_mmgr_errors_t timer_event(timer_handle_t *h, e_mmgr_state_t state,
         *action |= E_TIMER_RESET;
     }
 
-    if (timer_is_elapsed(t, E_TIMER_WAIT_FOR_BUS_READY, &cur)) {
+    if (timer_is_elapsed(t, E_TIMER_WAIT_FOR_BUS_READY)) {
         const char *msg = "BUS READY (Flash Mode) not received";
 
         if (state == E_MMGR_MDM_CONF_ONGOING)
@@ -243,20 +243,20 @@ e_mmgr_errors_t timer_event(timer_handle_t *h, e_mmgr_state_t state,
         *action |= E_TIMER_RESET;
     }
 
-    if (timer_is_elapsed(t, E_TIMER_REBOOT_MODEM_DELAY, &cur)) {
+    if (timer_is_elapsed(t, E_TIMER_REBOOT_MODEM_DELAY)) {
         handled = true;
         timer_stop(h, E_TIMER_REBOOT_MODEM_DELAY);
         *action |= E_TIMER_STREAMLINE;
     }
 
-    if (timer_is_elapsed(t, E_TIMER_CORE_DUMP_IPC_RESET, &cur)) {
+    if (timer_is_elapsed(t, E_TIMER_CORE_DUMP_IPC_RESET)) {
         handled = true;
         timer_stop(h, E_TIMER_CORE_DUMP_IPC_RESET);
         LOG_DEBUG("Timeout while waiting for core dump IPC. Reset IPC");
         *action |= E_TIMER_CD_ERR;
     }
 
-    if (timer_is_elapsed(t, E_TIMER_WAIT_CORE_DUMP_READY, &cur)) {
+    if (timer_is_elapsed(t, E_TIMER_WAIT_CORE_DUMP_READY)) {
         handled = true;
         LOG_DEBUG("timeout while waiting for core dump ipc. reset modem");
         timer_stop(h, E_TIMER_WAIT_CORE_DUMP_READY);
@@ -274,19 +274,19 @@ e_mmgr_errors_t timer_event(timer_handle_t *h, e_mmgr_state_t state,
         }
     }
 
-    if (timer_is_elapsed(t, E_TIMER_MDM_FLASHING, &cur)) {
+    if (timer_is_elapsed(t, E_TIMER_MDM_FLASHING)) {
         handled = true;
         timer_stop(h, E_TIMER_MDM_FLASHING);
         *action |= E_TIMER_CANCEL_FLASHING;
     }
 
-    if (timer_is_elapsed(t, E_TIMER_CORE_DUMP_READING, &cur)) {
+    if (timer_is_elapsed(t, E_TIMER_CORE_DUMP_READING)) {
         handled = true;
         timer_stop(h, E_TIMER_CORE_DUMP_READING);
         *action |= E_TIMER_STOP_MCDR;
     }
 
-    if (timer_is_elapsed(t, E_TIMER_FMMO, &cur)) {
+    if (timer_is_elapsed(t, E_TIMER_FMMO)) {
         handled = true;
         timer_stop(h, E_TIMER_FMMO);
         *action |= E_TIMER_FINALIZE_MDM_OFF;
@@ -323,7 +323,16 @@ timer_handle_t *timer_init(const mmgr_recovery_t *recov,
     timer = calloc(1, sizeof(mmgr_timer_t));
     if (timer) {
         timer->clients = clients;
-        timer->type = 0;
+        timer->elapsed = 0x0;
+        timer->wheel = wheel_init(NULL, NULL);
+        if (!timer->wheel) {
+            free(timer);
+            return NULL;
+        }
+
+        for (int i = 0; i < E_TIMER_NUM; i++)
+            wheel_timer_init(&timer->timers[i], g_type_str[i], timer_elapsed,
+                             timer);
 
         timer->timeout[E_TIMER_COLD_RESET_ACK] = recov->cold_timeout;
         timer->timeout[E_TIMER_MODEM_SHUTDOWN_ACK] = recov->shtdwn_timeout;
@@ -354,6 +363,8 @@ e_mmgr_errors_t timer_dispose(timer_handle_t *h)
 
     /* do not use ASSERT in dispose function */
 
+    if (timer)
+        wheel_dispose(timer->wheel);
     free(timer);
 
     return E_ERR_SUCCESS;
@@ -369,12 +380,9 @@ e_mmgr_errors_t timer_dispose(timer_handle_t *h)
  */
 long timer_get_value(timer_handle_t *h, e_timer_type_t type)
 {
-    struct timespec current;
     mmgr_timer_t *t = (mmgr_timer_t *)h;
 
     ASSERT(t != NULL);
 
-    clock_gettime(CLOCK_BOOTTIME, &current);
-
-    return t->timeout[type] * 1000 - timer_get_elapsed(current, t->end[type]);
+    return wheel_get_elapsed(t->wheel, &t->timers[type]);
 }
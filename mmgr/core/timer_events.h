@@ -23,6 +23,7 @@
 #include "errors.h"
 #include "tcs_mmgr.h"
 #include "states.h"
+#include "wheel.h"
 
 typedef void *timer_handle_t;
 
@@ -76,10 +77,11 @@ e_mmgr_errors_t timer_start(timer_handle_t *h, e_timer_type_t type);
 e_mmgr_errors_t timer_stop(timer_handle_t *h, e_timer_type_t type);
 e_mmgr_errors_t timer_event(timer_handle_t *h, e_mmgr_state_t state,
                             bool core_dump_signal_hw_working,
-                            unsigned int *context);
+                            e_timer_mdm_action_t *action);
 e_mmgr_errors_t timer_stop_all(timer_handle_t *h);
 
-int timer_get_timeout(timer_handle_t *h);
+int timer_get_fd(timer_handle_t *h);
+wheel_hdle_t *timer_get_wheel(timer_handle_t *h);
 long timer_get_value(timer_handle_t *h, e_timer_type_t type);
 
 #endif                          /* __MMGR_TIMER_HEADER__ */
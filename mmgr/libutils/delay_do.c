@@ -1,29 +0,0 @@
-/* Modem Manager - common header file
-**
-** Copyright (C) Intel 2014
-**
-** Licensed under the Apache License, Version 2.0 (the "License");
-** you may not use this file except in compliance with the License.
-** You may obtain a copy of the License at
-**
-**     http://www.apache.org/licenses/LICENSE-2.0
-**
-** Unless required by applicable law or agreed to in writing, software
-** distributed under the License is distributed on an "AS IS" BASIS,
-** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
-** See the License for the specific language governing permissions and
-** limitations under the License.
-**
-*/
-
-#include <unistd.h>
-#include "delay_do.h"
-
-void *delay_do(void *param)
-{
-    delay_t *ctx = param;
-
-    sleep(ctx->delay_sec);
-    ctx->fn(ctx->h);
-    return NULL;
-}
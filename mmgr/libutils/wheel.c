@@ -0,0 +1,426 @@
+/* Modem Manager - timer wheel source file
+**
+** Copyright (C) Intel 2014
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+*/
+
+/* Hierarchical timer wheel: level 0 has one slot per tick, each slot of
+ * level n covers 64^n ticks. A timer is linked in the level matching its
+ * distance to the current tick. When the current tick crosses a boundary of
+ * level n, the slot of level n it enters is redistributed in the lower
+ * levels. Starting and stopping a timer is a list operation. The range of the
+ * wheel is 64^4 ticks (about 46 hours), farther timers wait in the last slot
+ * and are redistributed until due. */
+
+/* clock_gettime and CLOCK_BOOTTIME with glibc and -std=c99 (host builds) */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include "logs.h"
+#include "wheel.h"
+
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS 4
+#define WHEEL_RANGE (1ULL << (WHEEL_LEVELS * WHEEL_BITS))
+#define WHEEL_NEVER UINT64_MAX
+
+typedef struct wheel_ctx {
+    wheel_timer_t *slots[WHEEL_LEVELS][WHEEL_SLOTS];
+    /* bit set for each slot that may be non empty. Stopping a timer leaves
+     * its bit set, cleared when the slot is found empty */
+    uint64_t occupied[WHEEL_LEVELS];
+    uint64_t base;  /* next tick to run, earlier ticks have been run */
+    size_t count;   /* running timers */
+    wheel_clock_t clock;
+    void *clock_ctx;
+    int fd;
+    uint64_t armed; /* tick the timerfd is armed for */
+} wheel_ctx_t;
+
+static uint64_t wheel_boottime(void *unused)
+{
+    struct timespec ts;
+
+    (void)unused;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static inline uint64_t wheel_now(wheel_ctx_t *w)
+{
+    return w->clock(w->clock_ctx);
+}
+
+static inline uint64_t rotr64(uint64_t v, unsigned int s)
+{
+    return s ? (v >> s) | (v << (64 - s)) : v;
+}
+
+static inline void wheel_link(wheel_timer_t **slot, wheel_timer_t *t)
+{
+    t->next = *slot;
+    if (t->next)
+        t->next->pprev = &t->next;
+    *slot = t;
+    t->pprev = slot;
+}
+
+static inline void wheel_unlink(wheel_timer_t *t)
+{
+    *t->pprev = t->next;
+    if (t->next)
+        t->next->pprev = t->pprev;
+    t->next = NULL;
+    t->pprev = NULL;
+}
+
+/**
+ * Links a timer in the slot matching its distance to the current tick
+ */
+static void wheel_insert(wheel_ctx_t *w, wheel_timer_t *t)
+{
+    uint64_t expires = t->expires < w->base ? w->base : t->expires;
+    uint64_t delta = expires - w->base;
+    int level = 0;
+    unsigned int idx;
+
+    if (delta >= WHEEL_RANGE) {
+        expires = w->base + WHEEL_RANGE - 1;
+        delta = WHEEL_RANGE - 1;
+    }
+
+    while (delta >= (1ULL << ((level + 1) * WHEEL_BITS)))
+        level++;
+
+    idx = (expires >> (level * WHEEL_BITS)) & WHEEL_MASK;
+    wheel_link(&w->slots[level][idx], t);
+    w->occupied[level] |= 1ULL << idx;
+}
+
+/**
+ * Redistributes the slot of a level the current tick has entered
+ */
+static void wheel_cascade(wheel_ctx_t *w, int level)
+{
+    unsigned int idx = (w->base >> (level * WHEEL_BITS)) & WHEEL_MASK;
+    wheel_timer_t *t = w->slots[level][idx];
+
+    w->slots[level][idx] = NULL;
+    w->occupied[level] &= ~(1ULL << idx);
+
+    while (t) {
+        wheel_timer_t *next = t->next;
+        wheel_insert(w, t);
+        t = next;
+    }
+
+    if (!idx && (level + 1 < WHEEL_LEVELS))
+        wheel_cascade(w, level + 1);
+}
+
+static void wheel_arm(wheel_ctx_t *w, uint64_t tick)
+{
+    struct itimerspec its;
+
+    memset(&its, 0, sizeof(its));
+    if (tick != WHEEL_NEVER) {
+        uint64_t now = wheel_now(w);
+        uint64_t end = tick * WHEEL_TICK_MS;
+
+        if (end > now) {
+            its.it_value.tv_sec = (end - now) / 1000;
+            its.it_value.tv_nsec = ((end - now) % 1000) * 1000000;
+        } else {
+            /* already due. A zero value would disarm the timer */
+            its.it_value.tv_nsec = 1;
+        }
+    }
+
+    if (timerfd_settime(w->fd, 0, &its, NULL))
+        LOG_ERROR("failed to arm the timer: %s", strerror(errno));
+    w->armed = tick;
+}
+
+/**
+ * Returns the first tick a timer elapses at
+ */
+static uint64_t wheel_next_expiry(wheel_ctx_t *w)
+{
+    uint64_t next = WHEEL_NEVER;
+
+    if (!w->count)
+        return WHEEL_NEVER;
+
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        unsigned int cur = (w->base >> (level * WHEEL_BITS)) & WHEEL_MASK;
+        /* the current slot of level 0 is still to run. For the other levels,
+         * it has been redistributed and only holds timers of the next turn */
+        unsigned int first = level ? (cur + 1) & WHEEL_MASK : cur;
+        uint64_t bits = rotr64(w->occupied[level], first);
+
+        while (bits) {
+            unsigned int idx = (first + __builtin_ctzll(bits)) & WHEEL_MASK;
+            wheel_timer_t *t = w->slots[level][idx];
+
+            bits &= bits - 1;
+            if (!t) {
+                w->occupied[level] &= ~(1ULL << idx);
+                continue;
+            }
+
+            for (; t; t = t->next) {
+                if (t->expires < next)
+                    next = t->expires;
+            }
+
+            /* slots are in expiry order, except in the last level which
+             * also holds the timers beyond the range */
+            if (level + 1 < WHEEL_LEVELS)
+                break;
+        }
+    }
+
+    return next;
+}
+
+/**
+ * Runs the timers elapsed up to target tick
+ *
+ * @return the number of timers run
+ */
+static int wheel_advance(wheel_ctx_t *w, uint64_t target)
+{
+    int nb = 0;
+
+    while (w->base <= target) {
+        unsigned int idx = w->base & WHEEL_MASK;
+        uint64_t bits;
+        wheel_timer_t *pending;
+
+        if (!w->count) {
+            w->base = target + 1;
+            break;
+        }
+
+        bits = w->occupied[0] >> idx;
+        if (!bits) {
+            /* nothing left in this turn of level 0 */
+            uint64_t boundary = (w->base | WHEEL_MASK) + 1;
+            w->base = boundary <= target ? boundary : target + 1;
+            if (!(w->base & WHEEL_MASK))
+                wheel_cascade(w, 1);
+            continue;
+        } else if (!(bits & 1)) {
+            uint64_t tick = w->base + __builtin_ctzll(bits);
+            w->base = tick <= target ? tick : target + 1;
+            continue;
+        }
+
+        pending = w->slots[0][idx];
+        w->slots[0][idx] = NULL;
+        w->occupied[0] &= ~(1ULL << idx);
+        if (pending)
+            pending->pprev = &pending;
+
+        /* timers started by the functions go to the next tick */
+        w->base++;
+        if (!(w->base & WHEEL_MASK))
+            wheel_cascade(w, 1);
+
+        while (pending) {
+            wheel_timer_t *t = pending;
+            wheel_unlink(t);
+            w->count--;
+            t->fn(t, t->ctx);
+            nb++;
+        }
+    }
+
+    return nb;
+}
+
+wheel_hdle_t *wheel_init(wheel_clock_t clock, void *clock_ctx)
+{
+    wheel_ctx_t *w = calloc(1, sizeof(wheel_ctx_t));
+
+    if (!w) {
+        LOG_ERROR("memory allocation failed");
+        goto out;
+    }
+
+    w->clock = clock ? clock : wheel_boottime;
+    w->clock_ctx = clock_ctx;
+    w->base = wheel_now(w) / WHEEL_TICK_MS;
+    w->armed = WHEEL_NEVER;
+
+    /* armed with relative values computed from the wheel clock, which
+     * counts the time spent in suspend: so must the timerfd, or the timers
+     * would fire late after a resume. Kernels older than 3.15 refuse
+     * CLOCK_BOOTTIME timerfds */
+    w->fd = timerfd_create(CLOCK_BOOTTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+    if ((w->fd == CLOSED_FD) && (errno == EINVAL)) {
+        LOG_DEBUG("no boot time timer, suspend delays the timers");
+        w->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    }
+    if (w->fd == CLOSED_FD) {
+        LOG_ERROR("failed to create the timer: %s", strerror(errno));
+        free(w);
+        w = NULL;
+    }
+
+out:
+    return (wheel_hdle_t *)w;
+}
+
+void wheel_dispose(wheel_hdle_t *hdle)
+{
+    wheel_ctx_t *w = (wheel_ctx_t *)hdle;
+
+    /* do not use ASSERT in dispose function */
+
+    if (w) {
+        if (w->fd != CLOSED_FD)
+            close(w->fd);
+        free(w);
+    }
+}
+
+void wheel_timer_init(wheel_timer_t *timer, const char *name, wheel_fn_t fn,
+                      void *ctx)
+{
+    ASSERT(timer != NULL);
+    ASSERT(fn != NULL);
+
+    memset(timer, 0, sizeof(*timer));
+    timer->name = name;
+    timer->fn = fn;
+    timer->ctx = ctx;
+}
+
+e_mmgr_errors_t wheel_start(wheel_hdle_t *hdle, wheel_timer_t *timer,
+                            int timeout_ms)
+{
+    wheel_ctx_t *w = (wheel_ctx_t *)hdle;
+
+    ASSERT(w != NULL);
+    ASSERT(timer != NULL);
+
+    if (wheel_is_running(timer))
+        wheel_stop(hdle, timer);
+
+    if (timeout_ms < 0)
+        timeout_ms = 0;
+
+    timer->start = wheel_now(w);
+    timer->expires = (timer->start + timeout_ms + WHEEL_TICK_MS - 1) /
+                     WHEEL_TICK_MS;
+    wheel_insert(w, timer);
+    w->count++;
+
+    if (timer->expires < w->armed)
+        wheel_arm(w, timer->expires);
+
+    return E_ERR_SUCCESS;
+}
+
+e_mmgr_errors_t wheel_stop(wheel_hdle_t *hdle, wheel_timer_t *timer)
+{
+    wheel_ctx_t *w = (wheel_ctx_t *)hdle;
+
+    ASSERT(w != NULL);
+    ASSERT(timer != NULL);
+
+    if (wheel_is_running(timer)) {
+        wheel_unlink(timer);
+        w->count--;
+
+        /* avoid a wake up for nothing */
+        if (!w->count && (w->armed != WHEEL_NEVER))
+            wheel_arm(w, WHEEL_NEVER);
+    }
+
+    return E_ERR_SUCCESS;
+}
+
+long wheel_get_elapsed(wheel_hdle_t *hdle, const wheel_timer_t *timer)
+{
+    wheel_ctx_t *w = (wheel_ctx_t *)hdle;
+
+    ASSERT(w != NULL);
+    ASSERT(timer != NULL);
+
+    return (long)(wheel_now(w) - timer->start);
+}
+
+int wheel_expire(wheel_hdle_t *hdle)
+{
+    wheel_ctx_t *w = (wheel_ctx_t *)hdle;
+    uint64_t expirations;
+    uint64_t next;
+    int nb;
+
+    ASSERT(w != NULL);
+
+    /* non blocking: nothing to read when called before the timerfd fires */
+    if (read(w->fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN)
+        LOG_ERROR("failed to read the timer: %s", strerror(errno));
+
+    nb = wheel_advance(w, wheel_now(w) / WHEEL_TICK_MS);
+
+    /* the timerfd is one shot: rearm it even for the same tick */
+    next = wheel_next_expiry(w);
+    if ((next != WHEEL_NEVER) || (w->armed != WHEEL_NEVER))
+        wheel_arm(w, next);
+
+    return nb;
+}
+
+int wheel_get_timeout(wheel_hdle_t *hdle)
+{
+    wheel_ctx_t *w = (wheel_ctx_t *)hdle;
+    uint64_t next;
+    uint64_t now;
+    uint64_t end;
+
+    ASSERT(w != NULL);
+
+    next = wheel_next_expiry(w);
+    if (next == WHEEL_NEVER)
+        return -1;
+
+    now = wheel_now(w);
+    end = next * WHEEL_TICK_MS;
+    if (end <= now)
+        return 0;
+    if (end - now > INT_MAX)
+        return INT_MAX;
+    return (int)(end - now);
+}
+
+int wheel_get_fd(wheel_hdle_t *hdle)
+{
+    wheel_ctx_t *w = (wheel_ctx_t *)hdle;
+
+    ASSERT(w != NULL);
+
+    return w->fd;
+}
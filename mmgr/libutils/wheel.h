@@ -0,0 +1,147 @@
+/* Modem Manager - timer wheel header file
+**
+** Copyright (C) Intel 2014
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+*/
+
+#ifndef __MMGR_UTILS_WHEEL__
+#define __MMGR_UTILS_WHEEL__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "errors.h"
+
+typedef void *wheel_hdle_t;
+
+/* resolution of the wheel, timeouts are rounded up to it */
+#define WHEEL_TICK_MS 10
+
+struct wheel_timer;
+
+typedef void (*wheel_fn_t)(struct wheel_timer *timer, void *ctx);
+
+/* returns the current time in milliseconds */
+typedef uint64_t (*wheel_clock_t)(void *ctx);
+
+/**
+ * A timer is owned by its user and linked in the wheel while running. It is
+ * initialized once with wheel_timer_init.
+ */
+typedef struct wheel_timer {
+    struct wheel_timer *next;
+    struct wheel_timer **pprev; /* NULL when the timer is not running */
+    uint64_t expires;           /* in ticks */
+    uint64_t start;             /* in milliseconds */
+    const char *name;
+    wheel_fn_t fn;
+    void *ctx;
+} wheel_timer_t;
+
+/**
+ * Initializes the module
+ *
+ * @param [in] clock time source. CLOCK_BOOTTIME is used if NULL
+ * @param [in] clock_ctx parameter of the time source
+ *
+ * @return valid handler. Must be freed by wheel_dispose
+ * @return NULL otherwise
+ */
+wheel_hdle_t *wheel_init(wheel_clock_t clock, void *clock_ctx);
+
+/**
+ * Disposes the module. Running timers are dropped
+ *
+ * @param [in] hdle module handler
+ */
+void wheel_dispose(wheel_hdle_t *hdle);
+
+/**
+ * Initializes a timer
+ *
+ * @param [out] timer timer to initialize
+ * @param [in] name name of the timer, used in logs. Must remain valid
+ * @param [in] fn function called, from wheel_expire, when the timer elapses
+ * @param [in] ctx parameter of fn
+ */
+void wheel_timer_init(wheel_timer_t *timer, const char *name, wheel_fn_t fn,
+                      void *ctx);
+
+/**
+ * Starts a timer in O(1). A running timer is restarted
+ *
+ * @param [in] hdle module handler
+ * @param [in] timer timer to start
+ * @param [in] timeout_ms timeout in milliseconds
+ *
+ * @return E_ERR_SUCCESS
+ */
+e_mmgr_errors_t wheel_start(wheel_hdle_t *hdle, wheel_timer_t *timer,
+                            int timeout_ms);
+
+/**
+ * Stops a timer in O(1). Stopping a stopped timer does nothing
+ *
+ * @param [in] hdle module handler
+ * @param [in] timer timer to stop
+ *
+ * @return E_ERR_SUCCESS
+ */
+e_mmgr_errors_t wheel_stop(wheel_hdle_t *hdle, wheel_timer_t *timer);
+
+static inline bool wheel_is_running(const wheel_timer_t *timer)
+{
+    return timer->pprev != NULL;
+}
+
+/**
+ * Returns the time elapsed since the last start of a timer
+ *
+ * @param [in] hdle module handler
+ * @param [in] timer timer
+ *
+ * @return elapsed time in milliseconds
+ */
+long wheel_get_elapsed(wheel_hdle_t *hdle, const wheel_timer_t *timer);
+
+/**
+ * Runs the functions of the elapsed timers, in expiry order, and rearms the
+ * file descriptor. The functions may start and stop timers.
+ *
+ * @param [in] hdle module handler
+ *
+ * @return the number of timers run
+ */
+int wheel_expire(wheel_hdle_t *hdle);
+
+/**
+ * Returns the time before the next timer elapses
+ *
+ * @param [in] hdle module handler
+ *
+ * @return timeout in milliseconds, -1 if no timer is running
+ */
+int wheel_get_timeout(wheel_hdle_t *hdle);
+
+/**
+ * Returns the timerfd of the wheel. It is readable when a timer has elapsed
+ * and wheel_expire must be called then
+ *
+ * @param [in] hdle module handler
+ *
+ * @return file descriptor
+ */
+int wheel_get_fd(wheel_hdle_t *hdle);
+
+#endif                          /* __MMGR_UTILS_WHEEL__ */
@@ -0,0 +1,15 @@
+LOCAL_PATH:= $(call my-dir)
+
+#############################################
+# MODEM MANAGER timer wheel host test
+#############################################
+include $(CLEAR_VARS)
+LOCAL_MODULE := mmgr-wheel-test
+LOCAL_MODULE_TAGS := optional tests
+
+LOCAL_C_INCLUDES := $(MMGR_PATH)/libutils
+LOCAL_SRC_FILES := wheel_test.c ../../libutils/wheel.c
+LOCAL_CFLAGS += -Wall -Werror -Wvla -DSTDIO_LOGS \
+    -DMODULE_NAME=\"MMGR-WHEEL-TEST\" -std=gnu99
+
+include $(BUILD_HOST_EXECUTABLE)
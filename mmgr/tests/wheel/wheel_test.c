@@ -0,0 +1,295 @@
+/* Modem Manager - timer wheel test source file
+**
+** Copyright (C) Intel 2014
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+**
+*/
+
+/* The wheel is driven by a mock clock: the test moves the time and calls
+ * wheel_expire as the events manager does when the timerfd fires. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "logs.h"
+#include "wheel.h"
+
+#define NB_RANDOM_TIMERS 200
+#define NB_RANDOM_STEPS 20000
+
+static int g_failures;
+
+#define CHECK(exp) do { \
+        if (!(exp)) { \
+            fprintf(stderr, "%s:%d check failed: %s\n", __FILE__, __LINE__, \
+                    #exp); \
+            g_failures++; \
+        } \
+} while (0)
+
+typedef struct mock_clock {
+    uint64_t now; /* in milliseconds */
+} mock_clock_t;
+
+typedef struct probe {
+    wheel_timer_t timer;
+    wheel_hdle_t *wheel;
+    uint64_t deadline; /* in milliseconds */
+    uint64_t fired;    /* time of the last call, 0 if none */
+    int nb_calls;
+    int period;        /* restarted with this timeout if not 0 */
+    wheel_timer_t *victim; /* stopped by the function if not NULL */
+} probe_t;
+
+static mock_clock_t g_clock;
+static int g_order[8];
+static int g_nb_order;
+
+static uint64_t mock_now(void *ctx)
+{
+    return ((mock_clock_t *)ctx)->now;
+}
+
+static void probe_fn(wheel_timer_t *timer, void *ctx)
+{
+    probe_t *p = ctx;
+
+    CHECK(timer == &p->timer);
+    CHECK(!wheel_is_running(timer));
+    /* never early, late by less than a tick */
+    CHECK(g_clock.now >= p->deadline);
+
+    p->fired = g_clock.now;
+    p->nb_calls++;
+    if (g_nb_order < (int)(sizeof(g_order) / sizeof(g_order[0])))
+        g_order[g_nb_order++] = p->timer.name[0];
+
+    if (p->victim)
+        wheel_stop(p->wheel, p->victim);
+    if (p->period) {
+        p->deadline = g_clock.now + p->period;
+        wheel_start(p->wheel, timer, p->period);
+    }
+}
+
+static void probe_init(probe_t *p, wheel_hdle_t *wheel, const char *name)
+{
+    memset(p, 0, sizeof(*p));
+    p->wheel = wheel;
+    wheel_timer_init(&p->timer, name, probe_fn, p);
+}
+
+static void probe_start(probe_t *p, int timeout_ms)
+{
+    p->deadline = g_clock.now + timeout_ms;
+    wheel_start(p->wheel, &p->timer, timeout_ms);
+}
+
+static int advance(wheel_hdle_t *wheel, uint64_t ms)
+{
+    g_clock.now += ms;
+    return wheel_expire(wheel);
+}
+
+static void test_order(void)
+{
+    wheel_hdle_t *wheel = wheel_init(mock_now, &g_clock);
+    probe_t a, b, c;
+
+    CHECK(wheel != NULL);
+    CHECK(wheel_get_fd(wheel) != CLOSED_FD);
+    CHECK(wheel_get_timeout(wheel) == -1);
+
+    probe_init(&a, wheel, "a");
+    probe_init(&b, wheel, "b");
+    probe_init(&c, wheel, "c");
+
+    g_nb_order = 0;
+    probe_start(&a, 3000);
+    probe_start(&b, 1000);
+    probe_start(&c, 2000);
+    CHECK(wheel_get_timeout(wheel) >= 1000);
+    CHECK(wheel_get_timeout(wheel) < 1000 + WHEEL_TICK_MS);
+
+    /* nothing before the deadline */
+    CHECK(advance(wheel, 999) == 0);
+    CHECK(b.nb_calls == 0);
+    CHECK(wheel_get_elapsed(wheel, &b.timer) == 999);
+
+    CHECK(advance(wheel, 1) + advance(wheel, WHEEL_TICK_MS) == 1);
+    CHECK(b.nb_calls == 1 && b.fired >= b.deadline);
+    CHECK(!wheel_is_running(&b.timer));
+
+    /* one late call runs the elapsed timers in expiry order */
+    CHECK(advance(wheel, 5000) == 2);
+    CHECK(g_nb_order == 3);
+    CHECK(g_order[0] == 'b' && g_order[1] == 'c' && g_order[2] == 'a');
+    CHECK(wheel_get_timeout(wheel) == -1);
+
+    wheel_dispose(wheel);
+}
+
+static void test_stop_restart(void)
+{
+    wheel_hdle_t *wheel = wheel_init(mock_now, &g_clock);
+    probe_t a, b, c;
+
+    probe_init(&a, wheel, "a");
+    probe_init(&b, wheel, "b");
+    probe_init(&c, wheel, "c");
+
+    /* stop in the middle of a slot list */
+    probe_start(&a, 500);
+    probe_start(&b, 500);
+    probe_start(&c, 500);
+    wheel_stop(wheel, &b.timer);
+    wheel_stop(wheel, &b.timer);
+    CHECK(!wheel_is_running(&b.timer));
+    CHECK(advance(wheel, 1000) == 2);
+    CHECK(a.nb_calls == 1 && b.nb_calls == 0 && c.nb_calls == 1);
+
+    /* a restarted timer elapses at its new deadline */
+    probe_start(&a, 1000);
+    CHECK(advance(wheel, 600) == 0);
+    probe_start(&a, 1000);
+    CHECK(advance(wheel, 600) == 0);
+    CHECK(advance(wheel, 400 + WHEEL_TICK_MS) == 1);
+    CHECK(a.nb_calls == 2 && a.fired >= a.deadline);
+
+    /* a function stops a timer elapsing at the same tick */
+    a.victim = &b.timer;
+    b.victim = &a.timer;
+    probe_start(&a, 200);
+    probe_start(&b, 200);
+    CHECK(advance(wheel, 200 + WHEEL_TICK_MS) == 1);
+    CHECK(a.nb_calls + b.nb_calls == 3);
+
+    /* a periodic timer restarted by its function */
+    a.victim = NULL;
+    a.period = 250;
+    a.nb_calls = 0;
+    probe_start(&a, 250);
+    for (int i = 0; i < 105; i++)
+        advance(wheel, 10);
+    CHECK(a.nb_calls == 4);
+    a.period = 0;
+    wheel_stop(wheel, &a.timer);
+    CHECK(wheel_get_timeout(wheel) == -1);
+
+    /* a zero timeout elapses at the next tick */
+    probe_start(&c, 0);
+    CHECK(wheel_get_timeout(wheel) < WHEEL_TICK_MS);
+    CHECK(advance(wheel, wheel_get_timeout(wheel)) == 1);
+
+    wheel_dispose(wheel);
+}
+
+static void test_levels(void)
+{
+    static const int timeouts[] = {
+        10, 630, 640, 650, 40950, 40960, 41000, 2621430, 2621440, 3600000,
+        167772150, 200000000,
+    };
+    const int nb = sizeof(timeouts) / sizeof(timeouts[0]);
+    wheel_hdle_t *wheel = wheel_init(mock_now, &g_clock);
+    probe_t probes[sizeof(timeouts) / sizeof(timeouts[0])];
+
+    for (int i = 0; i < nb; i++) {
+        probe_init(&probes[i], wheel, "level");
+        probe_start(&probes[i], timeouts[i]);
+    }
+
+    /* each timer is due at the reported timeout, not before */
+    for (int fired = 0; fired < nb; ) {
+        int timeout = wheel_get_timeout(wheel);
+
+        CHECK(timeout > 0);
+        if (timeout > 1)
+            CHECK(advance(wheel, timeout - 1) == 0);
+        fired += advance(wheel, 1);
+    }
+
+    for (int i = 0; i < nb; i++) {
+        CHECK(probes[i].nb_calls == 1);
+        CHECK(probes[i].fired >= probes[i].deadline);
+        CHECK(probes[i].fired < probes[i].deadline + WHEEL_TICK_MS);
+    }
+
+    wheel_dispose(wheel);
+}
+
+static void test_random(void)
+{
+    wheel_hdle_t *wheel = wheel_init(mock_now, &g_clock);
+    probe_t *probes = calloc(NB_RANDOM_TIMERS, sizeof(probe_t));
+    uint64_t expected = 0, calls = 0;
+
+    srand(1);
+    for (int i = 0; i < NB_RANDOM_TIMERS; i++)
+        probe_init(&probes[i], wheel, "random");
+
+    for (int step = 0; step < NB_RANDOM_STEPS; step++) {
+        probe_t *p = &probes[rand() % NB_RANDOM_TIMERS];
+        int op = rand() % 4;
+
+        if (op == 0) {
+            if (wheel_is_running(&p->timer))
+                expected--;
+            wheel_stop(wheel, &p->timer);
+        } else if (op == 1) {
+            if (!wheel_is_running(&p->timer))
+                expected++;
+            probe_start(p, rand() % (rand() % 8 ? 1000 : 100000));
+        } else {
+            uint64_t ms = rand() % (rand() % 8 ? 50 : 50000);
+            g_clock.now += ms;
+            calls += wheel_expire(wheel);
+        }
+
+        /* due timers have run, the others have not */
+        for (int i = 0; i < NB_RANDOM_TIMERS; i++) {
+            probe_t *q = &probes[i];
+            if (wheel_is_running(&q->timer))
+                CHECK(g_clock.now < q->deadline + WHEEL_TICK_MS);
+        }
+    }
+
+    /* drain */
+    g_clock.now += 200000;
+    calls += wheel_expire(wheel);
+    CHECK(calls == expected);
+    CHECK(wheel_get_timeout(wheel) == -1);
+
+    free(probes);
+    wheel_dispose(wheel);
+}
+
+int main(void)
+{
+    /* not aligned on a tick nor on a turn of the wheel */
+    g_clock.now = 123456789;
+
+    test_order();
+    test_stop_restart();
+    test_levels();
+    test_random();
+
+    if (g_failures) {
+        fprintf(stderr, "%d checks failed\n", g_failures);
+        return EXIT_FAILURE;
+    }
+
+    printf("all checks passed\n");
+    return EXIT_SUCCESS;
+}
@@ -88,6 +88,7 @@ LOCAL_SRC_FILES += \
     pnw_cmdbuf.c \
     pnw_hostcode.c \
     pnw_hostheader.c \
+    header_bits.c \
     pnw_hostjpeg.c \
     pnw_jpeg.c \
     tng_cmdbuf.c \
@@ -134,6 +135,7 @@ LOCAL_SRC_FILES += \
     pnw_cmdbuf.c \
     pnw_hostcode.c \
     pnw_hostheader.c \
+    header_bits.c \
     pnw_hostjpeg.c \
     pnw_jpeg.c
 
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "header_bits.h"
+
+/* Layout of MTX_HEADER_ELEMENT, common to the PNW and TNG headers */
+typedef struct _HEADER_BITS_ELEMENT_ {
+    IMG_UINT32 Element_Type;
+    IMG_UINT8 Size;
+    IMG_UINT8 Bits;
+} HEADER_BITS_ELEMENT;
+
+/* floor(log2(n)) of a byte, giving the Exp-Golomb lengths of small values */
+static const IMG_UINT8 header_bits_log2[256] = {
+    0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3,
+    4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+    5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7
+};
+
+/*
+ * Exp-Golomb code of a number n is n + 1 after floor(log2(n + 1)) zeros
+ * Returns the count of zeros of code = n + 1
+ */
+static IMG_UINT32 header_bits_zeros(IMG_UINT64 code)
+{
+    IMG_UINT32 zeros = 0;
+
+    while (code > 0xFF) {
+        code >>= 8;
+        zeros += 8;
+    }
+    return zeros + header_bits_log2[code];
+}
+
+IMG_INT32 header_bits_write(IMG_UINT32 *elements, void **elt_p, IMG_UINT32 raw_type,
+                            IMG_UINT32 value, IMG_UINT32 bit_cnt)
+{
+    while (bit_cnt) {
+        HEADER_BITS_ELEMENT *elt;
+        IMG_UINT8 *bytes;
+        IMG_UINT32 size, used, count, total, i;
+        IMG_UINT64 acc;
+
+        if (*elements >= HEADER_BITS_MAX_ELEMENTS) {
+            return -1;
+        }
+        elt = (HEADER_BITS_ELEMENT *) elt_p[*elements];
+        size = elt->Size;
+
+        if (size >= HEADER_BITS_ELEMENT_BITS) {
+            /* Element maximum bits sent to element, the next one starts after its 15 bytes */
+            if (++*elements >= HEADER_BITS_MAX_ELEMENTS) {
+                return -1;
+            }
+            elt_p[*elements] = &elt->Bits + HEADER_BITS_ELEMENT_BITS / 8;
+            elt = (HEADER_BITS_ELEMENT *) elt_p[*elements];
+            elt->Element_Type = raw_type;
+            elt->Size = 0;
+            continue;
+        }
+
+        count = HEADER_BITS_ELEMENT_BITS - size;
+        if (count > bit_cnt) {
+            count = bit_cnt;
+        }
+        bytes = &elt->Bits + size / 8;
+        used = size & 7;
+
+        /* Bits already in the last byte, then the new ones, stored left aligned by bytes */
+        acc = used ? (bytes[0] >> (8 - used)) : 0;
+        acc = (acc << count) | ((value >> (bit_cnt - count)) & ((1ull << count) - 1));
+        total = used + count;
+        acc <<= (8 - (total & 7)) & 7;
+        for (i = (total + 7) / 8; i-- > 0; acc >>= 8) {
+            bytes[i] = (IMG_UINT8) acc;
+        }
+
+        elt->Size = (IMG_UINT8)(size + count);
+        bit_cnt -= count;
+    }
+    return 0;
+}
+
+IMG_INT32 header_bits_write_ue(IMG_UINT32 *elements, void **elt_p, IMG_UINT32 raw_type,
+                               IMG_UINT32 value)
+{
+    IMG_UINT64 code = (IMG_UINT64) value + 1;
+    IMG_UINT32 zeros = header_bits_zeros(code);
+
+    if (zeros < 16) {
+        return header_bits_write(elements, elt_p, raw_type, (IMG_UINT32) code, 2 * zeros + 1);
+    }
+    if (header_bits_write(elements, elt_p, raw_type, 0, zeros)) {
+        return -1;
+    }
+    if (zeros == 32) {
+        if (header_bits_write(elements, elt_p, raw_type, 1, 1)) {
+            return -1;
+        }
+        return header_bits_write(elements, elt_p, raw_type, (IMG_UINT32) code, 32);
+    }
+    return header_bits_write(elements, elt_p, raw_type, (IMG_UINT32) code, zeros + 1);
+}
+
+IMG_INT32 header_bits_write_se(IMG_UINT32 *elements, void **elt_p, IMG_UINT32 raw_type,
+                               IMG_INT32 value)
+{
+    IMG_UINT32 code_num;
+
+    if (value > 0) {
+        code_num = (IMG_UINT32) value * 2 - 1;
+    } else {
+        code_num = 0 - (IMG_UINT32) value * 2;
+    }
+    return header_bits_write_ue(elements, elt_p, raw_type, code_num);
+}
+
+static IMG_INT32 header_bits_flush(IMG_UINT32 *elements, void **elt_p, IMG_UINT32 raw_type,
+                                   IMG_UINT64 acc, IMG_UINT32 acc_bits)
+{
+    if (acc_bits > 32) {
+        if (header_bits_write(elements, elt_p, raw_type, (IMG_UINT32)(acc >> 32), acc_bits - 32)) {
+            return -1;
+        }
+        acc_bits = 32;
+    }
+    return header_bits_write(elements, elt_p, raw_type, (IMG_UINT32) acc, acc_bits);
+}
+
+IMG_INT32 header_bits_write_fields(IMG_UINT32 *elements, void **elt_p, IMG_UINT32 raw_type,
+                                   const HEADER_BITS_FIELD *fields, IMG_UINT32 count)
+{
+    IMG_UINT64 acc = 0;
+    IMG_UINT32 acc_bits = 0;
+    IMG_UINT32 i;
+
+    for (i = 0; i < count; i++) {
+        IMG_UINT64 code;
+        IMG_UINT32 bits;
+
+        switch (fields[i].coding) {
+        case HEADER_BITS_FIXED:
+            bits = fields[i].bits;
+            code = fields[i].value & ((1ull << bits) - 1);
+            break;
+        case HEADER_BITS_SE:
+            if ((IMG_INT32) fields[i].value > 0) {
+                code = (IMG_UINT64)(fields[i].value * 2 - 1) + 1;
+            } else {
+                code = (IMG_UINT64)(0 - fields[i].value * 2) + 1;
+            }
+            bits = 2 * header_bits_zeros(code) + 1;
+            break;
+        default:
+            code = (IMG_UINT64) fields[i].value + 1;
+            bits = 2 * header_bits_zeros(code) + 1;
+            break;
+        }
+
+        if (bits > 32) {
+            /* Large Exp-Golomb codes are not accumulated */
+            if (header_bits_flush(elements, elt_p, raw_type, acc, acc_bits)) {
+                return -1;
+            }
+            acc = 0;
+            acc_bits = 0;
+            if (header_bits_write_ue(elements, elt_p, raw_type, (IMG_UINT32)(code - 1))) {
+                return -1;
+            }
+            continue;
+        }
+        if (acc_bits + bits > 64) {
+            if (header_bits_flush(elements, elt_p, raw_type, acc, acc_bits)) {
+                return -1;
+            }
+            acc = 0;
+            acc_bits = 0;
+        }
+        acc = (acc << bits) | code;
+        acc_bits += bits;
+    }
+    return header_bits_flush(elements, elt_p, raw_type, acc, acc_bits);
+}
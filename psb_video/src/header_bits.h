@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Bit writer of the header elements built on the host for the PNW and TNG
+ * encoders. Bits are accumulated in a 64-bit word and stored by whole bytes,
+ * splitting raw data elements at the same positions as the former writers
+ * did bit by bit, so the headers are byte-identical.
+ */
+
+#ifndef _HEADER_BITS_H_
+#define _HEADER_BITS_H_
+
+#include "img_types.h"
+
+/* Size of the element pointer arrays of the header writers */
+#define HEADER_BITS_MAX_ELEMENTS        16
+
+/* Raw data bits per element, a full element is continued in a new one */
+#define HEADER_BITS_ELEMENT_BITS        120
+
+typedef enum {
+    HEADER_BITS_FIXED = 0,      /* value on bits, most significant bit first */
+    HEADER_BITS_UE,             /* unsigned Exp-Golomb, ue(v) */
+    HEADER_BITS_SE              /* signed Exp-Golomb, se(v) */
+} HEADER_BITS_CODING;
+
+/* Field of a batch of header bits */
+typedef struct _HEADER_BITS_FIELD_ {
+    IMG_UINT8 coding;
+    IMG_UINT8 bits;             /* for HEADER_BITS_FIXED only, up to 32 */
+    IMG_UINT32 value;
+} HEADER_BITS_FIELD;
+
+static inline HEADER_BITS_FIELD header_bits_u(IMG_UINT32 value, IMG_UINT8 bits)
+{
+    HEADER_BITS_FIELD field = { HEADER_BITS_FIXED, bits, value };
+    return field;
+}
+
+static inline HEADER_BITS_FIELD header_bits_ue(IMG_UINT32 value)
+{
+    HEADER_BITS_FIELD field = { HEADER_BITS_UE, 0, value };
+    return field;
+}
+
+static inline HEADER_BITS_FIELD header_bits_se(IMG_INT32 value)
+{
+    HEADER_BITS_FIELD field = { HEADER_BITS_SE, 0, (IMG_UINT32) value };
+    return field;
+}
+
+/*
+ * The functions below write to the raw data element elt_p[*elements], in
+ * the layout of MTX_HEADER_ELEMENT: element type, size in bits, then bits.
+ * When the element is full, a new element of type raw_type is started.
+ * Return 0 on success, -1 if there were no element left for the bits
+ */
+
+/*
+ * Writes the bit_cnt (up to 32) least significant bits of value
+ */
+IMG_INT32 header_bits_write(IMG_UINT32 *elements, void **elt_p, IMG_UINT32 raw_type,
+                            IMG_UINT32 value, IMG_UINT32 bit_cnt);
+
+/*
+ * Writes value as ue(v)
+ */
+IMG_INT32 header_bits_write_ue(IMG_UINT32 *elements, void **elt_p, IMG_UINT32 raw_type,
+                               IMG_UINT32 value);
+
+/*
+ * Writes value as se(v)
+ */
+IMG_INT32 header_bits_write_se(IMG_UINT32 *elements, void **elt_p, IMG_UINT32 raw_type,
+                               IMG_INT32 value);
+
+/*
+ * Writes the fields in turn, storing them by up to 64 bits at once
+ */
+IMG_INT32 header_bits_write_fields(IMG_UINT32 *elements, void **elt_p, IMG_UINT32 raw_type,
+                                   const HEADER_BITS_FIELD *fields, IMG_UINT32 count);
+
+#endif /* _HEADER_BITS_H_ */
@@ -32,52 +32,99 @@
 #include <string.h>
 
 #include "psb_def.h"
-#include "psb_drv_debug.h"
+
+/* The heap only depends on the C library, so that it also builds on the host */
+#ifndef ASSERT
+#ifdef DEBUG_TRACE
+#define ASSERT  assert
+#else
+#define ASSERT(x)
+#endif
+#endif
 
 #define LAST_FREE    -1
 #define ALLOCATED    -2
 #define SUSPENDED    -3
 
+#define OCCUPIED_BITS           32
+#define OCCUPIED_WORDS(size)    (((size) + OCCUPIED_BITS - 1) / OCCUPIED_BITS)
+
+/* Slabs double with the heap up to this count of objects */
+#define MAX_SLAB_OBJECTS        1024
+
+static void object_heap_set_occupied(object_heap_p heap, int index)
+{
+    heap->occupied[index / OCCUPIED_BITS] |= 1u << (index % OCCUPIED_BITS);
+}
+
+static void object_heap_clear_occupied(object_heap_p heap, int index)
+{
+    heap->occupied[index / OCCUPIED_BITS] &= ~(1u << (index % OCCUPIED_BITS));
+}
+
 /*
- * Expands the heap
+ * Expands the heap by a slab of contiguous objects
  * Return 0 on success, -1 on error
  */
 static int object_heap_expand(object_heap_p heap)
 {
     int i;
-    int malloc_error = FALSE;
-    object_base_p *new_heap_index;
+    int slab_objects;
+    int new_heap_size;
     int next_free;
-    int new_heap_size = heap->heap_size + heap->heap_increment;
+    unsigned char *slab;
+    void **new_slabs;
+    object_base_p *new_heap_index;
+    unsigned int *new_occupied;
+    int occupied_words = OCCUPIED_WORDS(heap->heap_size);
+
+    slab_objects = heap->heap_size > heap->heap_increment ? heap->heap_size : heap->heap_increment;
+    if (slab_objects > MAX_SLAB_OBJECTS) {
+        slab_objects = MAX_SLAB_OBJECTS;
+    }
+    if (slab_objects > OBJECT_HEAP_MAX_OBJECTS - heap->heap_size) {
+        slab_objects = OBJECT_HEAP_MAX_OBJECTS - heap->heap_size;
+        if (slab_objects <= 0) {
+            return -1; /* Out of object IDs */
+        }
+    }
+    new_heap_size = heap->heap_size + slab_objects;
 
+    /* Arrays grown before a failure are kept, the heap size tells what is in use */
     new_heap_index = (object_base_p *) realloc(heap->heap_index, new_heap_size * sizeof(object_base_p));
     if (NULL == new_heap_index) {
         return -1; /* Out of memory */
     }
     heap->heap_index = new_heap_index;
+
+    new_slabs = (void **) realloc(heap->slabs, (heap->slab_count + 1) * sizeof(void *));
+    if (NULL == new_slabs) {
+        return -1; /* Out of memory */
+    }
+    heap->slabs = new_slabs;
+
+    new_occupied = (unsigned int *) realloc(heap->occupied, OCCUPIED_WORDS(new_heap_size) * sizeof(unsigned int));
+    if (NULL == new_occupied) {
+        return -1; /* Out of memory */
+    }
+    memset(new_occupied + occupied_words, 0,
+           (OCCUPIED_WORDS(new_heap_size) - occupied_words) * sizeof(unsigned int));
+    heap->occupied = new_occupied;
+
+    slab = (unsigned char *) calloc(slab_objects, heap->object_size);
+    if (NULL == slab) {
+        return -1; /* Out of memory */
+    }
+    heap->slabs[heap->slab_count++] = slab;
+
     next_free = heap->next_free;
     for (i = new_heap_size; i-- > heap->heap_size;) {
-        object_base_p obj = (object_base_p) calloc(1, heap->object_size);
+        object_base_p obj = (object_base_p)(slab + (i - heap->heap_size) * heap->object_size);
         heap->heap_index[i] = obj;
-        if (NULL == obj) {
-            malloc_error = TRUE;
-            continue; /* Clean up after the loop is completely done */
-        }
         obj->id = i + heap->id_offset;
         obj->next_free = next_free;
         next_free = i;
     }
-
-    if (malloc_error) {
-        /* Clean up the mess */
-        for (i = new_heap_size; i-- > heap->heap_size;) {
-            if (heap->heap_index[i]) {
-                free(heap->heap_index[i]);
-            }
-        }
-        /* heap->heap_index is left as is */
-        return -1; /* Out of memory */
-    }
     heap->next_free = next_free;
     heap->heap_size = new_heap_size;
     return 0; /* Success */
@@ -94,6 +141,9 @@ int object_heap_init(object_heap_p heap, int object_size, int id_offset)
     heap->heap_increment = 16;
     heap->heap_index = NULL;
     heap->next_free = LAST_FREE;
+    heap->slabs = NULL;
+    heap->slab_count = 0;
+    heap->occupied = NULL;
     return object_heap_expand(heap);
 }
 
@@ -112,6 +162,7 @@ int object_heap_allocate(object_heap_p heap)
     ASSERT(heap->next_free >= 0);
 
     obj = heap->heap_index[heap->next_free];
+    object_heap_set_occupied(heap, heap->next_free);
     heap->next_free = obj->next_free;
     obj->next_free = ALLOCATED;
     return obj->id;
@@ -119,23 +170,26 @@ int object_heap_allocate(object_heap_p heap)
 
 /*
  * Lookup an object by object ID
- * Returns a pointer to the object on success, returns NULL on error
+ * Returns a pointer to the object on success, returns NULL on error,
+ * or if the object was freed or suspended
  */
 object_base_p object_heap_lookup(object_heap_p heap, int id)
 {
     object_base_p obj;
-    if ((id < heap->id_offset) || (id > (heap->heap_size + heap->id_offset))) {
+    int index;
+    if ((id & ~OBJECT_HEAP_ID_MASK) != heap->id_offset) {
         return NULL;
     }
-    id &= OBJECT_HEAP_ID_MASK;
-    obj = heap->heap_index[id];
+    index = id & OBJECT_HEAP_INDEX_MASK;
+    if (index >= heap->heap_size) {
+        return NULL;
+    }
+    obj = heap->heap_index[index];
 
-    /* Check if the object has in fact been allocated */
-#if 0
-    if (obj->next_free != ALLOCATED) {
+    /* Check if the object has in fact been allocated, with this generation */
+    if ((obj->id != id) || (obj->next_free != ALLOCATED)) {
         return NULL;
     }
-#endif
     return obj;
 }
 
@@ -155,18 +209,27 @@ object_base_p object_heap_first(object_heap_p heap, object_heap_iterator *iter)
  */
 object_base_p object_heap_next(object_heap_p heap, object_heap_iterator *iter)
 {
-    object_base_p obj;
     int i = *iter + 1;
-    while (i < heap->heap_size) {
-        obj = heap->heap_index[i];
-        if ((obj->next_free == ALLOCATED) || (obj->next_free == SUSPENDED)) {
-            *iter = i;
-            return obj;
+    int word = i / OCCUPIED_BITS;
+    unsigned int bits;
+
+    if (i >= heap->heap_size) {
+        *iter = heap->heap_size;
+        return NULL;
+    }
+    /* Skip the words without allocated nor suspended objects */
+    bits = heap->occupied[word] & (~0u << (i % OCCUPIED_BITS));
+    while (0 == bits) {
+        if (++word >= OCCUPIED_WORDS(heap->heap_size)) {
+            *iter = heap->heap_size;
+            return NULL;
         }
-        i++;
+        bits = heap->occupied[word];
     }
+    i = word * OCCUPIED_BITS + __builtin_ctz(bits);
+    ASSERT((heap->heap_index[i]->next_free == ALLOCATED) || (heap->heap_index[i]->next_free == SUSPENDED));
     *iter = i;
-    return NULL;
+    return heap->heap_index[i];
 }
 
 
@@ -178,11 +241,18 @@ void object_heap_free(object_heap_p heap, object_base_p obj)
 {
     /* Don't complain about NULL pointers */
     if (NULL != obj) {
+        int index = obj->id & OBJECT_HEAP_INDEX_MASK;
+
         /* Check if the object has in fact been allocated */
         ASSERT((obj->next_free == ALLOCATED) || (obj->next_free == SUSPENDED));
 
+        /* Next generation of the slot, so the ID of the freed object is stale */
+        obj->id = heap->id_offset
+                  | ((obj->id + (1 << OBJECT_HEAP_INDEX_BITS)) & OBJECT_HEAP_GENERATION_MASK)
+                  | index;
+        object_heap_clear_occupied(heap, index);
         obj->next_free = heap->next_free;
-        heap->next_free = obj->id & OBJECT_HEAP_ID_MASK;
+        heap->next_free = index;
     }
 }
 
@@ -191,19 +261,22 @@ void object_heap_free(object_heap_p heap, object_base_p obj)
  */
 void object_heap_destroy(object_heap_p heap)
 {
-    object_base_p obj;
     int i;
-    for (i = 0; i < heap->heap_size; i++) {
-        /* Check if object is not still allocated */
-        obj = heap->heap_index[i];
-        ASSERT(obj->next_free != ALLOCATED);
-        ASSERT(obj->next_free != SUSPENDED);
-        /* Free object itself */
-        free(obj);
+    /* Check if objects are not still allocated nor suspended */
+    for (i = 0; i < OCCUPIED_WORDS(heap->heap_size); i++) {
+        ASSERT(0 == heap->occupied[i]);
+    }
+    for (i = 0; i < heap->slab_count; i++) {
+        free(heap->slabs[i]);
     }
+    free(heap->slabs);
+    free(heap->occupied);
     free(heap->heap_index);
     heap->heap_size = 0;
     heap->heap_index = NULL;
+    heap->slabs = NULL;
+    heap->slab_count = 0;
+    heap->occupied = NULL;
     heap->next_free = LAST_FREE;
 }
 
@@ -32,6 +32,16 @@
 #define OBJECT_HEAP_OFFSET_MASK         0x7F000000
 #define OBJECT_HEAP_ID_MASK                     0x00FFFFFF
 
+/*
+ * The object ID below the offset holds the slot index in the low bits and a
+ * generation in the high bits. The generation is bumped when the object is
+ * freed, so an ID kept after its object was destroyed no longer looks it up.
+ */
+#define OBJECT_HEAP_INDEX_BITS          16
+#define OBJECT_HEAP_INDEX_MASK          0x0000FFFF
+#define OBJECT_HEAP_GENERATION_MASK     0x00FF0000
+#define OBJECT_HEAP_MAX_OBJECTS         (OBJECT_HEAP_INDEX_MASK + 1)
+
 typedef struct object_base_s *object_base_p;
 typedef struct object_heap_s *object_heap_p;
 
@@ -47,6 +57,11 @@ struct object_heap_s {
     int next_free;
     int heap_size;
     int heap_increment;
+    /* Objects are allocated by slabs of contiguous objects */
+    void **slabs;
+    int slab_count;
+    /* One bit per allocated or suspended object, for iterating */
+    unsigned int *occupied;
 };
 
 typedef int object_heap_iterator;
@@ -64,7 +79,8 @@ int object_heap_allocate(object_heap_p heap);
 
 /*
  * Lookup an allocated object by object ID
- * Returns a pointer to the object on success, returns NULL on error
+ * Returns a pointer to the object on success, returns NULL on error,
+ * or if the object was freed or suspended
  */
 object_base_p object_heap_lookup(object_heap_p heap, int id);
 
@@ -35,6 +35,7 @@
 #include "psb_def.h"
 #include "psb_drv_debug.h"
 #include "pnw_hostheader.h"
+#include "header_bits.h"
 
 
 /* Global stores the latest QP information for the DoHeader()
@@ -161,7 +162,7 @@ static void Show_Elements(
 
 /**
  * Header Writing Functions
- * Low level bit writing and ue, se functions
+ * Low level bit writing and ue, se functions, written by header_bits
  * HOST CODE
  */
 static void pnw__write_upto8bits_elements(
@@ -170,78 +171,15 @@ static void pnw__write_upto8bits_elements(
     IMG_UINT8 wrt_bits,
     IMG_UINT16 bit_cnt)
 {
-    /* This is the core function to write bits/bytes
-     * to a header stream, it writes them directly to ELEMENT structures.
+    /* Wider fields have always been written as zeros (the former mask shifted by a
+     * negative count), keep them so the headers do not change
      */
-    IMG_UINT8 *wrt_bytes_p;
-    IMG_UINT8 *size_bits_p;
-    union {
-        IMG_UINT32 UI16Input;
-        IMG_UINT8 UI8Input[2];
-    } InputVal = {0, };
-    IMG_UINT8 OutByteIndex;
-    IMG_INT16 Shift;
-
-    if (bit_cnt == 0) return;
+    if (bit_cnt > 8)
+        wrt_bits = 0;
 
     /* WA for klockwork */
-    if (mtx_hdr->Elements >= MAXNUMBERELEMENTS) {
+    if (header_bits_write(&mtx_hdr->Elements, (void **) elt_p, ELEMENT_RAWDATA, wrt_bits, bit_cnt))
         drv_debug_msg(VIDEO_DEBUG_ERROR, "mtx_hdr->Elments overflow\n");
-        return;
-    }
-
-    /* First ensure that unused bits in wrt_bits are zeroed */
-    wrt_bits &= (0x00ff >> (8 - bit_cnt));
-
-    InputVal.UI16Input = 0;
-
-    /* Pointer to the bit count field */
-    size_bits_p = &(elt_p[mtx_hdr->Elements]->Size);
-
-    /* Pointer to the space where header bits are to be written */
-    wrt_bytes_p = &(elt_p[mtx_hdr->Elements]->Bits);
-
-    OutByteIndex = (size_bits_p[0] / 8);
-
-    if (!(size_bits_p[0] & 7)) {
-        if (size_bits_p[0] >= 120) {
-            /* Element maximum bits send to element, time to start a new one */
-            mtx_hdr->Elements++; /* Increment element index */
-            /* Element pointer set to position of next element (120/8 = 15 bytes) */
-            elt_p[mtx_hdr->Elements] = (MTX_HEADER_ELEMENT *) & wrt_bytes_p[15];
-
-            /* Write ELEMENT_TYPE */
-            elt_p[mtx_hdr->Elements]->Element_Type = ELEMENT_RAWDATA;
-
-            /* Set new element size (bits) to zero */
-            elt_p[mtx_hdr->Elements]->Size = 0;
-
-            /* Begin writing to the new element */
-            pnw__write_upto8bits_elements(mtx_hdr, elt_p, wrt_bits, bit_cnt);
-            return;
-        }
-
-        wrt_bytes_p[OutByteIndex] = 0; /* Beginning a new byte, clear byte */
-    }
-
-    Shift = (IMG_INT16)((8 - bit_cnt) - (size_bits_p[0] & 7));
-
-    if (Shift >= 0) {
-        wrt_bits <<= Shift;
-        wrt_bytes_p[OutByteIndex] |= wrt_bits;
-        size_bits_p[0] = size_bits_p[0] + bit_cnt;
-    } else {
-        InputVal.UI8Input[1] = (IMG_UINT8) wrt_bits + 256;
-        InputVal.UI16Input >>= -Shift;
-
-        wrt_bytes_p[OutByteIndex] |= InputVal.UI8Input[1];
-
-        size_bits_p[0] = size_bits_p[0] + bit_cnt;
-        size_bits_p[0] = size_bits_p[0] - ((IMG_UINT8) - Shift);
-        InputVal.UI8Input[0] = InputVal.UI8Input[0] >> (8 + Shift);
-
-        pnw__write_upto8bits_elements(mtx_hdr, elt_p, InputVal.UI8Input[0], (IMG_UINT16) - Shift);
-    }
 }
 
 static void pnw__write_upto32bits_elements(
@@ -250,26 +188,8 @@ static void pnw__write_upto32bits_elements(
     IMG_UINT32 wrt_bits,
     IMG_UINT32 bit_cnt)
 {
-    IMG_UINT32 BitLp;
-    IMG_UINT32 EndByte;
-    IMG_UINT8 Bytes[4];
-
-    for (BitLp = 0; BitLp < 4; BitLp++) {
-        Bytes[BitLp] = (IMG_UINT8)(wrt_bits & 255);
-        wrt_bits = wrt_bits >> 8;
-    }
-
-    EndByte = ((bit_cnt + 7) / 8);
-
-    if ((bit_cnt) % 8)
-        pnw__write_upto8bits_elements(mtx_hdr, elt_p, Bytes[EndByte-1], (IMG_UINT8)((bit_cnt) % 8));
-    else
-        pnw__write_upto8bits_elements(mtx_hdr, elt_p, Bytes[EndByte-1], 8);
-
-    if (EndByte > 1)
-        for (BitLp = EndByte - 1; BitLp > 0; BitLp--) {
-            pnw__write_upto8bits_elements(mtx_hdr, elt_p, Bytes[BitLp-1], 8);
-        }
+    if (header_bits_write(&mtx_hdr->Elements, (void **) elt_p, ELEMENT_RAWDATA, wrt_bits, bit_cnt))
+        drv_debug_msg(VIDEO_DEBUG_ERROR, "mtx_hdr->Elments overflow\n");
 }
 
 static void pnw__generate_ue(
@@ -277,33 +197,8 @@ static void pnw__generate_ue(
     MTX_HEADER_ELEMENT **elt_p,
     IMG_UINT32 uiVal)
 {
-    IMG_UINT32 uiLp;
-    IMG_UINT8 ucZeros;
-    IMG_UINT32 uiChunk;
-
-    for (uiLp = 1, ucZeros = 0; (uiLp - 1) < uiVal ; uiLp = uiLp + uiLp, ucZeros++)
-        uiVal = uiVal - uiLp;
-
-    /* ucZeros = number of preceding zeros required
-     * uiVal = value to append after zeros and 1 bit
-     */
-
-    /* Write preceding zeros */
-    for (uiLp = (IMG_UINT32) ucZeros; uiLp + 1 > 8; uiLp -= 8)
-        pnw__write_upto8bits_elements(mtx_hdr, elt_p, 0, 8);
-
-    /* Write zeros and 1 bit set */
-    pnw__write_upto8bits_elements(mtx_hdr, elt_p, (IMG_UINT8) 1, (IMG_UINT8)(uiLp + 1));
-
-    /* Write Numeric part */
-    while (ucZeros > 8) {
-        ucZeros -= 8;
-        uiChunk = (uiVal >> ucZeros);
-        pnw__write_upto8bits_elements(mtx_hdr, elt_p, (IMG_UINT8) uiChunk, 8);
-        uiVal = uiVal - (uiChunk << ucZeros);
-    }
-
-    pnw__write_upto8bits_elements(mtx_hdr, elt_p, (IMG_UINT8) uiVal, ucZeros);
+    if (header_bits_write_ue(&mtx_hdr->Elements, (void **) elt_p, ELEMENT_RAWDATA, uiVal))
+        drv_debug_msg(VIDEO_DEBUG_ERROR, "mtx_hdr->Elments overflow\n");
 }
 
 
@@ -312,14 +207,19 @@ static void pnw__generate_se(
     MTX_HEADER_ELEMENT **elt_p,
     int iVal)
 {
-    IMG_UINT32 uiCodeNum;
-
-    if (iVal > 0)
-        uiCodeNum = (IMG_UINT32)(iVal + iVal - 1);
-    else
-        uiCodeNum = (IMG_UINT32)(-iVal - iVal);
+    if (header_bits_write_se(&mtx_hdr->Elements, (void **) elt_p, ELEMENT_RAWDATA, iVal))
+        drv_debug_msg(VIDEO_DEBUG_ERROR, "mtx_hdr->Elments overflow\n");
+}
 
-    pnw__generate_ue(mtx_hdr, elt_p, uiCodeNum);
+/* Writes fields at once, as the functions above in turn */
+static void pnw__write_fields(
+    MTX_HEADER_PARAMS *mtx_hdr,
+    MTX_HEADER_ELEMENT **elt_p,
+    const HEADER_BITS_FIELD *fields,
+    IMG_UINT32 count)
+{
+    if (header_bits_write_fields(&mtx_hdr->Elements, (void **) elt_p, ELEMENT_RAWDATA, fields, count))
+        drv_debug_msg(VIDEO_DEBUG_ERROR, "mtx_hdr->Elments overflow\n");
 }
 
 
@@ -608,26 +508,27 @@ static void pnw__H264_writebits_slice_header1(
 {
     /* GENERATES THE SECOND ELEMENT OF THE H264_SLICE_HEADER() STRUCTURE
      * The following is slice parameter set in BP/MP
+     * Fields are written at once, this header is built for every slice
      */
+    HEADER_BITS_FIELD fields[8];
+    IMG_UINT32 count = 0;
 
     /* first_mb_in_slice = First MB address in slice: ue(Range 0 -  1619) */
-    pnw__generate_ue(mtx_hdr, elt_p, (IMG_UINT32) pSlHParams->First_MB_Address);
+    fields[count++] = header_bits_ue((IMG_UINT32) pSlHParams->First_MB_Address);
 
-    pnw__generate_ue(
-        mtx_hdr, elt_p,
+    fields[count++] = header_bits_ue(
         (IMG_UINT32)((pSlHParams->SliceFrame_Type == SLHP_IDR_SLICEFRAME_TYPE) ? SLHP_I_SLICEFRAME_TYPE : pSlHParams->SliceFrame_Type));  /* slice_type ue(v): 0 for P-slice, 1 for B-slice, 2 for I-slice */
 
     /* kab: not clean change from IDR to intra, IDR should have separate flag */
 
-    pnw__write_upto8bits_elements(
-        mtx_hdr, elt_p,
+    fields[count++] = header_bits_u(
         (1 << 5) | /* pic_parameter_set_id, ue(v) = 0  (=1b) in Topaz */
         pSlHParams->Frame_Num_DO,/* frame_num (5 bits) = frame nuo. in decoding order */
         6);
 
     /* frame_mb_only_flag is always 1, so no need for field_pic_flag or bottom_field_flag */
     if (pSlHParams->SliceFrame_Type == SLHP_IDR_SLICEFRAME_TYPE)
-        pnw__generate_ue(mtx_hdr, elt_p, uiIdrPicId);/* idr_pic_id ue(v) = 0 (1b) in Topaz */
+        fields[count++] = header_bits_ue(uiIdrPicId);/* idr_pic_id ue(v) = 0 (1b) in Topaz */
 
     /* kab: Idr_pic_id only for IDR, not nessesarely for all I pictures */
 
@@ -648,11 +549,7 @@ static void pnw__H264_writebits_slice_header1(
 #endif
 
     if (pSlHParams->SliceFrame_Type == SLHP_P_SLICEFRAME_TYPE || pSlHParams->SliceFrame_Type == SLHP_B_SLICEFRAME_TYPE)
-        pnw__write_upto8bits_elements(
-            mtx_hdr,
-            elt_p,
-            0,
-            1);/* num_ref_idx_active_override_flag (1 bit) = 0 in Topaz */
+        fields[count++] = header_bits_u(0, 1);/* num_ref_idx_active_override_flag (1 bit) = 0 in Topaz */
 
     if (pSlHParams->SliceFrame_Type != SLHP_I_SLICEFRAME_TYPE &&
         pSlHParams->SliceFrame_Type != SLHP_IDR_SLICEFRAME_TYPE) {
@@ -668,11 +565,7 @@ static void pnw__H264_writebits_slice_header1(
             pnw__generate_ue(mtx_hdr, elt_p, 3);
         } else
         */
-            pnw__write_upto8bits_elements(
-                mtx_hdr,
-                elt_p,
-                0,
-                1);/* ref_pic_list_ordering_flag_I0 (1 bit) = 0 */
+            fields[count++] = header_bits_u(0, 1);/* ref_pic_list_ordering_flag_I0 (1 bit) = 0 */
     }
 
 #if 0    
@@ -686,10 +579,9 @@ static void pnw__H264_writebits_slice_header1(
 
     if (pSlHParams->SliceFrame_Type == SLHP_IDR_SLICEFRAME_TYPE) {
         /* no_output_of_prior_pics_flag (1 bit) = 0 */
-        pnw__write_upto8bits_elements(mtx_hdr, elt_p, 0, 1);
+        fields[count++] = header_bits_u(0, 1);
         /* long_term_reference_flag (1 bit)*/
-        pnw__write_upto8bits_elements(mtx_hdr, elt_p,
-                                      pSlHParams->IsLongTermRef ? 1 : 0, 1);
+        fields[count++] = header_bits_u(pSlHParams->IsLongTermRef ? 1 : 0, 1);
     } 
 #if 0
     else if (pSlHParams->UsesLongTermRef) {
@@ -710,8 +602,10 @@ static void pnw__H264_writebits_slice_header1(
     } 
 #endif
     else {
-        pnw__write_upto8bits_elements(mtx_hdr, elt_p, 0, 1);/* adaptive_ref_pic_marking_mode_flag (1 bit) = 0 */
+        fields[count++] = header_bits_u(0, 1);/* adaptive_ref_pic_marking_mode_flag (1 bit) = 0 */
     }
+
+    pnw__write_fields(mtx_hdr, elt_p, fields, count);
 }
 
 
@@ -723,6 +617,8 @@ static void pnw__H264_writebits_slice_header2(
     /* GENERATES ELEMENT OF THE H264_SLICE_HEADER() STRUCTURE
      * ELEMENT BITCOUNT: 11
      */
+    HEADER_BITS_FIELD fields[3];
+    IMG_UINT32 count = 0;
 
 #if 0
     /* Next field is generated on MTX with a special commnad (not ELEMENT_RAW) - so not defined here */
@@ -731,16 +627,15 @@ static void pnw__H264_writebits_slice_header2(
     /* pucHS=pnw__generate_se(pucHS, puiBitPos, pSlHParams->Slice_QP_Delta);  */
 #endif
 
-    pnw__generate_ue(
-        mtx_hdr,
-        elt_p,
-        pSlHParams->Disable_Deblocking_Filter_Idc); /* disable_deblocking_filter_idc ue(v) = 2?  */
+    fields[count++] = header_bits_ue(pSlHParams->Disable_Deblocking_Filter_Idc); /* disable_deblocking_filter_idc ue(v) = 2?  */
 
     if (pSlHParams->Disable_Deblocking_Filter_Idc != 1) {
-        pnw__generate_se(mtx_hdr, elt_p, 0); /* slice_alpha_c0_offset_div2 se(v) = 0 (1b) in Topaz */
-        pnw__generate_se(mtx_hdr, elt_p, 0); /* slice_beta_offset_div2 se(v) = 0 (1b) in Topaz */
+        fields[count++] = header_bits_se(0); /* slice_alpha_c0_offset_div2 se(v) = 0 (1b) in Topaz */
+        fields[count++] = header_bits_se(0); /* slice_beta_offset_div2 se(v) = 0 (1b) in Topaz */
     }
 
+    pnw__write_fields(mtx_hdr, elt_p, fields, count);
+
     /* num_slice_groups_minus1 ==0 in Topaz, so no slice_group_change_cycle field here
      * no byte alignment at end of slice headers
      */
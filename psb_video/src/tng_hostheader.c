@@ -35,6 +35,7 @@
 #include "psb_def.h"
 #include "psb_drv_debug.h"
 #include "tng_hostheader.h"
+#include "header_bits.h"
 #ifdef _TOPAZHP_PDUMP_
 #include "tng_trace.h"
 #endif
@@ -178,7 +179,7 @@ static void tng_print(unsigned char *ptmp, int num)
 
 /**
  * Header Writing Functions
- * Low level bit writing and ue, se functions
+ * Low level bit writing and ue, se functions, written by header_bits
  * HOST CODE
  */
 static void tng__write_upto8bits_elements(
@@ -187,59 +188,15 @@ static void tng__write_upto8bits_elements(
     IMG_UINT8 ui8WriteBits,
     IMG_UINT16 ui16BitCnt)
 {
-    // This is the core function to write bits/bytes to a header stream, it writes them directly to ELEMENT structures.
-    IMG_UINT8 *pui8WriteBytes;
-    IMG_UINT8 *pui8SizeBits;
-    union {
-        IMG_UINT32 UI16Input;
-        IMG_UINT8 UI8Input[2];
-    } InputVal;
-    IMG_UINT8 ui8OutByteIndex;
-    IMG_INT16 i16Shift;
-    if (ui16BitCnt==0)
-        return ;
-
-//    drv_debug_msg(VIDEO_DEBUG_GENERAL, "%s: mtx_hdr->ui32Elments overflow (%d)\n", __FUNCTION__, pMTX_Header->ui32Elements);
-    /* WA for klockwork */
+    /* Wider fields have always been written as zeros (the former mask shifted by a
+     * negative count), keep them so the headers do not change
+     */
+    if (ui16BitCnt > 8)
+        ui8WriteBits = 0;
 
-//    if (pMTX_Header->ui32Elements >= MAXNUMBERELEMENTS) {
-//        drv_debug_msg(VIDEO_DEBUG_ERROR, "%s: mtx_hdr->ui32Elments overflow (%d)\n", __FUNCTION__, pMTX_Header->ui32Elements);
-//        return;
-//    }
-    // First ensure that unused bits  in ui8WriteBits are zeroed
-    ui8WriteBits &= (0x00ff >> (8 - ui16BitCnt));
-    InputVal.UI16Input=0;
-    pui8SizeBits=&(aui32ElementPointers[pMTX_Header->ui32Elements]->ui8Size); //Pointer to the bit count field
-    pui8WriteBytes=&(aui32ElementPointers[pMTX_Header->ui32Elements]->aui8Bits); //Pointer to the space where header bits are to be written
-    ui8OutByteIndex=(pui8SizeBits[0] / 8);
-    if (!(pui8SizeBits[0]&7)) {
-        if (pui8SizeBits[0]>=120) {
-            //Element maximum bits send to element, time to start a new one
-            pMTX_Header->ui32Elements++; // Increment element index
-            aui32ElementPointers[pMTX_Header->ui32Elements]=(MTX_HEADER_ELEMENT *) &pui8WriteBytes[15]; //Element pointer set to position of next element (120/8 = 15 bytes)
-            aui32ElementPointers[pMTX_Header->ui32Elements]->Element_Type=ELEMENT_RAWDATA; //Write ELEMENT_TYPE
-            aui32ElementPointers[pMTX_Header->ui32Elements]->ui8Size=0; // Set new element size (bits) to zero
-            tng__write_upto8bits_elements(pMTX_Header,aui32ElementPointers, ui8WriteBits, ui16BitCnt); // Begin writing to the new element
-        return ;//(IMG_UINT32) ui16BitCnt;
-        }
-        pui8WriteBytes[ui8OutByteIndex]=0; // Beginning a new byte, clear byte
-    }
-    i16Shift=(IMG_INT16) ((8-ui16BitCnt)-(pui8SizeBits[0]&7));
-    if (i16Shift>=0) {
-        ui8WriteBits <<= i16Shift;
-        pui8WriteBytes[ui8OutByteIndex]|=ui8WriteBits;
-        pui8SizeBits[0]=pui8SizeBits[0]+ui16BitCnt;
-    } else {
-        InputVal.UI8Input[1]=(IMG_UINT8) ui8WriteBits+256;
-        InputVal.UI16Input >>= -i16Shift;
-        pui8WriteBytes[ui8OutByteIndex]|=InputVal.UI8Input[1];
-
-        pui8SizeBits[0]=pui8SizeBits[0]+ui16BitCnt;
-        pui8SizeBits[0]=pui8SizeBits[0]-((IMG_UINT8) -i16Shift);
-        InputVal.UI8Input[0]=InputVal.UI8Input[0] >> (8+i16Shift);
-        tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, InputVal.UI8Input[0],(IMG_UINT16) -i16Shift);
-    }
-    return ;//(IMG_UINT32) ui16BitCnt;
+    if (header_bits_write(&pMTX_Header->ui32Elements, (void **) aui32ElementPointers, ELEMENT_RAWDATA,
+                          ui8WriteBits, ui16BitCnt))
+        drv_debug_msg(VIDEO_DEBUG_ERROR, "%s: mtx_hdr->ui32Elments overflow\n", __FUNCTION__);
 }
 
 static void tng__write_upto32bits_elements(
@@ -248,25 +205,10 @@ static void tng__write_upto32bits_elements(
     IMG_UINT32 ui32WriteBits,
     IMG_UINT32 ui32BitCnt)
 {
-    IMG_UINT32 ui32BitLp;
-    IMG_UINT32 ui32EndByte;
-    IMG_UINT8 ui8Bytes[4];
     drv_debug_msg(VIDEO_DEBUG_GENERAL, "WBS(32) bits %x, cnt = %d\n", ui32WriteBits, ui32BitCnt);
-    for (ui32BitLp=0; ui32BitLp<4; ui32BitLp++) {
-        ui8Bytes[ui32BitLp]=(IMG_UINT8) (ui32WriteBits & 255);
-        ui32WriteBits = ui32WriteBits >> 8;
-    }
-
-    ui32EndByte=((ui32BitCnt+7)/8);
-    if ((ui32BitCnt)%8)
-        tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, ui8Bytes[ui32EndByte-1], (IMG_UINT8) ((ui32BitCnt)%8));
-    else
-        tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, ui8Bytes[ui32EndByte-1], 8);
-    if (ui32EndByte>1)
-        for (ui32BitLp=ui32EndByte-1; ui32BitLp>0; ui32BitLp--) {
-            tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, ui8Bytes[ui32BitLp-1], 8);
-        }
-    return ;//ui32BitCnt;
+    if (header_bits_write(&pMTX_Header->ui32Elements, (void **) aui32ElementPointers, ELEMENT_RAWDATA,
+                          ui32WriteBits, ui32BitCnt))
+        drv_debug_msg(VIDEO_DEBUG_ERROR, "%s: mtx_hdr->ui32Elments overflow\n", __FUNCTION__);
 }
 
 static void tng__generate_ue(
@@ -274,29 +216,8 @@ static void tng__generate_ue(
     MTX_HEADER_ELEMENT **aui32ElementPointers,
     IMG_UINT32 uiVal)
 {
-    IMG_UINT32 uiLp;
-    IMG_UINT8 ucZeros;
-    IMG_UINT32 uiChunk;
-
-    for (uiLp=1, ucZeros=0;  (uiLp-1) < uiVal ; uiLp=uiLp+uiLp, ucZeros++)
-        uiVal=uiVal-uiLp;
-    // ucZeros = number of preceding zeros required
-    // uiVal = value to append after zeros and 1 bit
-    //** Write preceding zeros
-    for (uiLp=(IMG_UINT32) ucZeros; uiLp+1>8; uiLp-=8)
-        tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, 0, 8);
-    //** Write zeros and 1 bit set
-    tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, (IMG_UINT8) 1, (IMG_UINT8) (uiLp+1));
-    //** Write Numeric part
-    while (ucZeros>8) {
-        ucZeros-=8;
-        uiChunk=(uiVal >> ucZeros);
-        tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, (IMG_UINT8) uiChunk, 8);
-        uiVal=uiVal-(uiChunk << ucZeros);
-    }
-    tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, (IMG_UINT8) uiVal, ucZeros);
-
-    return ;//ui32BitCnter;
+    if (header_bits_write_ue(&pMTX_Header->ui32Elements, (void **) aui32ElementPointers, ELEMENT_RAWDATA, uiVal))
+        drv_debug_msg(VIDEO_DEBUG_ERROR, "%s: mtx_hdr->ui32Elments overflow\n", __FUNCTION__);
 }
 
 static void tng__generate_se(
@@ -304,14 +225,20 @@ static void tng__generate_se(
     MTX_HEADER_ELEMENT **aui32ElementPointers,
     int iVal)
 {
-    IMG_UINT32 uiCodeNum;
+    if (header_bits_write_se(&pMTX_Header->ui32Elements, (void **) aui32ElementPointers, ELEMENT_RAWDATA, iVal))
+        drv_debug_msg(VIDEO_DEBUG_ERROR, "%s: mtx_hdr->ui32Elments overflow\n", __FUNCTION__);
+}
 
-    if (iVal > 0)
-        uiCodeNum=(IMG_UINT32) (iVal+iVal-1);
-    else
-        uiCodeNum=(IMG_UINT32) (-iVal-iVal);
-    tng__generate_ue(pMTX_Header, aui32ElementPointers, uiCodeNum);
-    return ;//ui32BitCnter;
+// Writes fields at once, as the functions above in turn
+static void tng__write_fields(
+    MTX_HEADER_PARAMS *pMTX_Header,
+    MTX_HEADER_ELEMENT **aui32ElementPointers,
+    const HEADER_BITS_FIELD *asFields,
+    IMG_UINT32 ui32Count)
+{
+    if (header_bits_write_fields(&pMTX_Header->ui32Elements, (void **) aui32ElementPointers, ELEMENT_RAWDATA,
+                                 asFields, ui32Count))
+        drv_debug_msg(VIDEO_DEBUG_ERROR, "%s: mtx_hdr->ui32Elments overflow\n", __FUNCTION__);
 }
 
 
@@ -787,6 +714,10 @@ static void tng__H264ES_writebits_slice_header(
     IMG_BOOL bCabacEnabled
 )
 {
+    // Fields between the element tokens are written at once, this header is built for every slice
+    HEADER_BITS_FIELD asFields[32];
+    IMG_UINT32 ui32Count = 0;
+
     tng__insert_element_token(pMTX_Header, aui32ElementPointers, ELEMENT_STARTCODE_RAWDATA);
     //Can be 3 or 4 bytes - always 4 bytes in our implementations
     tng__H264_writebits_startcode_prefix_element(pMTX_Header, aui32ElementPointers, pSlHParams->ui8Start_Code_Prefix_Size_Bytes);
@@ -811,97 +742,100 @@ static void tng__H264ES_writebits_slice_header(
     ///**** GENERATES THE SECOND ELEMENT OF THE H264_SLICE_HEADER() STRUCTURE ****///
     /* The following is slice parameter set in BP/MP */
     //tng__generate_ue(pMTX_Header, aui32ElementPointers, (IMG_UINT32) pSlHParams->First_MB_Address);                               //first_mb_in_slice = First MB address in slice: ue(Range 0 -  1619)
-    tng__generate_ue(pMTX_Header, aui32ElementPointers, (IMG_UINT32)((pSlHParams->SliceFrame_Type == SLHP_IDR_SLICEFRAME_TYPE) ? SLHP_I_SLICEFRAME_TYPE : pSlHParams->SliceFrame_Type));                                    //slice_type ue(v): 0 for P-slice, 1 for B-slice, 2 for I-slice
+    asFields[ui32Count++] = header_bits_ue((IMG_UINT32)((pSlHParams->SliceFrame_Type == SLHP_IDR_SLICEFRAME_TYPE) ? SLHP_I_SLICEFRAME_TYPE : pSlHParams->SliceFrame_Type));                                    //slice_type ue(v): 0 for P-slice, 1 for B-slice, 2 for I-slice
     // kab: //not clean change from IDR to intra, IDR should have separate flag
-    tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers,
+    asFields[ui32Count++] = header_bits_u(
                                   (1 << 5) |                                                                                                                                             //pic_parameter_set_id, ue(v) = 0  (=1b) in Topaz
                                   pSlHParams->Frame_Num_DO,                                                                                                               //frame_num (5 bits) = frame nuo. in decoding order
                                   6);
 
     // interlaced encoding
     if (pSlHParams->bPiCInterlace) {
-        tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, 1, 1);                                          // field_pic_flag = 1
-        tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, pSlHParams->bFieldType, 1); // bottom_field_flag (0=top field, 1=bottom field)
+        asFields[ui32Count++] = header_bits_u(1, 1);                                          // field_pic_flag = 1
+        asFields[ui32Count++] = header_bits_u(pSlHParams->bFieldType, 1); // bottom_field_flag (0=top field, 1=bottom field)
     }
 
     if (pSlHParams->SliceFrame_Type == SLHP_IDR_SLICEFRAME_TYPE)
-        tng__generate_ue(pMTX_Header, aui32ElementPointers, pSlHParams->Idr_Pic_Id);    // idr_pic_id ue(v)
+        asFields[ui32Count++] = header_bits_ue(pSlHParams->Idr_Pic_Id);    // idr_pic_id ue(v)
 
     if (pSlHParams->bPiCInterlace)
-        tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, (pSlHParams->Picture_Num_DO + pSlHParams->bFieldType), pSlHParams->log2_max_pic_order_cnt);                    // pic_order_cnt_lsb (6 bits) - picture no in display order
+        asFields[ui32Count++] = header_bits_u((pSlHParams->Picture_Num_DO + pSlHParams->bFieldType), pSlHParams->log2_max_pic_order_cnt);                    // pic_order_cnt_lsb (6 bits) - picture no in display order
     else
-        tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, pSlHParams->Picture_Num_DO, pSlHParams->log2_max_pic_order_cnt);                       // pic_order_cnt_lsb (6 bits) - picture no in display order
+        asFields[ui32Count++] = header_bits_u(pSlHParams->Picture_Num_DO, pSlHParams->log2_max_pic_order_cnt);                       // pic_order_cnt_lsb (6 bits) - picture no in display order
 
 
     if (pSlHParams->SliceFrame_Type == SLHP_B_SLICEFRAME_TYPE)
-        tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, pSlHParams->direct_spatial_mv_pred_flag, 1);// direct_spatial_mv_pred_flag (1 bit)
+        asFields[ui32Count++] = header_bits_u(pSlHParams->direct_spatial_mv_pred_flag, 1);// direct_spatial_mv_pred_flag (1 bit)
     if (pSlHParams->SliceFrame_Type == SLHP_P_SLICEFRAME_TYPE || pSlHParams->SliceFrame_Type == SLHP_B_SLICEFRAME_TYPE) {
         if (pSlHParams->SliceFrame_Type == SLHP_P_SLICEFRAME_TYPE && pSlHParams->num_ref_idx_l0_active_minus1 > 0) { //Do we have more then one reference picture?
             //Override amount of ref pics to be only 1 in L0 direction
-            tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, 1, 1);
-            tng__generate_ue(pMTX_Header, aui32ElementPointers, pSlHParams->num_ref_idx_l0_active_minus1);
+            asFields[ui32Count++] = header_bits_u(1, 1);
+            asFields[ui32Count++] = header_bits_ue(pSlHParams->num_ref_idx_l0_active_minus1);
         } else
             // num_ref_idx_active_override_flag (1 bit) = 0 in Topaz
-            tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, 0, 1);
+            asFields[ui32Count++] = header_bits_u(0, 1);
     }
     if (pSlHParams->SliceFrame_Type != SLHP_I_SLICEFRAME_TYPE && pSlHParams->SliceFrame_Type != SLHP_IDR_SLICEFRAME_TYPE) {
         if ((pSlHParams->diff_ref_pic_num[0] || pSlHParams->bRefIsLongTermRef[0])
             || ((pSlHParams->diff_ref_pic_num[1] || pSlHParams->bRefIsLongTermRef[1]) && (pSlHParams->num_ref_idx_l0_active_minus1 > 0))) {
             //Specifiy first ref pic in L0
-            tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, 1, 1); //ref_pic_list_modification_flag_l0
+            asFields[ui32Count++] = header_bits_u(1, 1); //ref_pic_list_modification_flag_l0
 
             if (pSlHParams->bRefIsLongTermRef[0]) {
-                tng__generate_ue(pMTX_Header, aui32ElementPointers, 2); // mod_of_pic_num = 2 (long term ref)
-                tng__generate_ue(pMTX_Header, aui32ElementPointers, pSlHParams->uRefLongTermRefNum[0]); // long_term_pic_num
+                asFields[ui32Count++] = header_bits_ue(2); // mod_of_pic_num = 2 (long term ref)
+                asFields[ui32Count++] = header_bits_ue(pSlHParams->uRefLongTermRefNum[0]); // long_term_pic_num
             } else if (pSlHParams->diff_ref_pic_num[0] == 0) {
                 // Can't use 0, so use MaxPicNum which will wrap to 0
-                tng__generate_ue(pMTX_Header, aui32ElementPointers, 1); // mod_of_pic_num = 1 (add to)
-                tng__generate_ue(pMTX_Header, aui32ElementPointers, 31); // abs_diff_minus_1
+                asFields[ui32Count++] = header_bits_ue(1); // mod_of_pic_num = 1 (add to)
+                asFields[ui32Count++] = header_bits_ue(31); // abs_diff_minus_1
             } else if (pSlHParams->diff_ref_pic_num[0] < 0) {
-                tng__generate_ue(pMTX_Header, aui32ElementPointers, 0); // mod_of_pic_num = 0 (subtract from)
-                tng__generate_ue(pMTX_Header, aui32ElementPointers, -pSlHParams->diff_ref_pic_num[0] - 1); // abs_diff_minus_1
+                asFields[ui32Count++] = header_bits_ue(0); // mod_of_pic_num = 0 (subtract from)
+                asFields[ui32Count++] = header_bits_ue(-pSlHParams->diff_ref_pic_num[0] - 1); // abs_diff_minus_1
             } else {
-                tng__generate_ue(pMTX_Header, aui32ElementPointers, 1); // mod_of_pic_num = 1 (add too)
-                tng__generate_ue(pMTX_Header, aui32ElementPointers, pSlHParams->diff_ref_pic_num[0] - 1); // abs_diff_minus_1
+                asFields[ui32Count++] = header_bits_ue(1); // mod_of_pic_num = 1 (add too)
+                asFields[ui32Count++] = header_bits_ue(pSlHParams->diff_ref_pic_num[0] - 1); // abs_diff_minus_1
             }
 
             if ((pSlHParams->diff_ref_pic_num[1] || pSlHParams->bRefIsLongTermRef[1]) && pSlHParams->SliceFrame_Type != SLHP_B_SLICEFRAME_TYPE) { //potentially second reference picture on P
                 if (pSlHParams->bRefIsLongTermRef[1]) {
-                    tng__generate_ue(pMTX_Header, aui32ElementPointers, 2); // mod_of_pic_num = 2 (long term ref)
-                    tng__generate_ue(pMTX_Header, aui32ElementPointers, pSlHParams->uRefLongTermRefNum[1]); // long_term_pic_num
+                    asFields[ui32Count++] = header_bits_ue(2); // mod_of_pic_num = 2 (long term ref)
+                    asFields[ui32Count++] = header_bits_ue(pSlHParams->uRefLongTermRefNum[1]); // long_term_pic_num
                 } else if (pSlHParams->diff_ref_pic_num[1] < 0) {
-                    tng__generate_ue(pMTX_Header, aui32ElementPointers, 0); // mod_of_pic_num = 0 (subtract from)
-                    tng__generate_ue(pMTX_Header, aui32ElementPointers, -pSlHParams->diff_ref_pic_num[1] - 1); // abs_diff_minus_1
+                    asFields[ui32Count++] = header_bits_ue(0); // mod_of_pic_num = 0 (subtract from)
+                    asFields[ui32Count++] = header_bits_ue(-pSlHParams->diff_ref_pic_num[1] - 1); // abs_diff_minus_1
                 } else {
-                    tng__generate_ue(pMTX_Header, aui32ElementPointers, 1); // mod_of_pic_num = 1 (add too)
-                    tng__generate_ue(pMTX_Header, aui32ElementPointers, pSlHParams->diff_ref_pic_num[1] - 1); // abs_diff_minus_1
+                    asFields[ui32Count++] = header_bits_ue(1); // mod_of_pic_num = 1 (add too)
+                    asFields[ui32Count++] = header_bits_ue(pSlHParams->diff_ref_pic_num[1] - 1); // abs_diff_minus_1
                 }
             }
 
-            tng__generate_ue(pMTX_Header, aui32ElementPointers, 3); // mod_of_pic_num = 3 (no more changes)
+            asFields[ui32Count++] = header_bits_ue(3); // mod_of_pic_num = 3 (no more changes)
         } else
-            tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, 0, 1); // ref_pic_list_ordering_flag_I0 (1 bit) = 0, no reference picture ordering in Topaz
+            asFields[ui32Count++] = header_bits_u(0, 1); // ref_pic_list_ordering_flag_I0 (1 bit) = 0, no reference picture ordering in Topaz
     }
     if (pSlHParams->SliceFrame_Type == SLHP_B_SLICEFRAME_TYPE) {
         if (pSlHParams->diff_ref_pic_num[1] || pSlHParams->bRefIsLongTermRef[1]) {
             //Specifiy first ref pic in L1
-            tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, 1, 1); //ref_pic_list_modification_flag_l1
+            asFields[ui32Count++] = header_bits_u(1, 1); //ref_pic_list_modification_flag_l1
 
             if (pSlHParams->bRefIsLongTermRef[1]) {
-                tng__generate_ue(pMTX_Header, aui32ElementPointers, 2); // mod_of_pic_num = 2 (long term ref)
-                tng__generate_ue(pMTX_Header, aui32ElementPointers, pSlHParams->uRefLongTermRefNum[1]); // long_term_pic_num
+                asFields[ui32Count++] = header_bits_ue(2); // mod_of_pic_num = 2 (long term ref)
+                asFields[ui32Count++] = header_bits_ue(pSlHParams->uRefLongTermRefNum[1]); // long_term_pic_num
             } else if (pSlHParams->diff_ref_pic_num[1] < 0) {
-                tng__generate_ue(pMTX_Header, aui32ElementPointers, 0); // mod_of_pic_num = 0 (subtract from)
-                tng__generate_ue(pMTX_Header, aui32ElementPointers, -pSlHParams->diff_ref_pic_num[1] - 1); // abs_diff_minus_1
+                asFields[ui32Count++] = header_bits_ue(0); // mod_of_pic_num = 0 (subtract from)
+                asFields[ui32Count++] = header_bits_ue(-pSlHParams->diff_ref_pic_num[1] - 1); // abs_diff_minus_1
             } else {
-                tng__generate_ue(pMTX_Header, aui32ElementPointers, 1); // mod_of_pic_num = 1 (add too)
-                tng__generate_ue(pMTX_Header, aui32ElementPointers, pSlHParams->diff_ref_pic_num[1] - 1); // abs_diff_minus_1
+                asFields[ui32Count++] = header_bits_ue(1); // mod_of_pic_num = 1 (add too)
+                asFields[ui32Count++] = header_bits_ue(pSlHParams->diff_ref_pic_num[1] - 1); // abs_diff_minus_1
             }
 
-            tng__generate_ue(pMTX_Header, aui32ElementPointers, 3); // mod_of_pic_num = 3 (no more changes)
+            asFields[ui32Count++] = header_bits_ue(3); // mod_of_pic_num = 3 (no more changes)
         } else
-            tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, 0, 1); // ref_pic_list_ordering_flag_I1 (1 bit) = 0, no reference picture ordering in Topaz
+            asFields[ui32Count++] = header_bits_u(0, 1); // ref_pic_list_ordering_flag_I1 (1 bit) = 0, no reference picture ordering in Topaz
     }
+    tng__write_fields(pMTX_Header, aui32ElementPointers, asFields, ui32Count);
+    ui32Count = 0;
+
     if (pSlHParams->weighted_pred_flag &&
         ((pSlHParams->SliceFrame_Type == SLHP_P_SLICEFRAME_TYPE) || (pSlHParams->SliceFrame_Type == SLHP_B_SLICEFRAME_TYPE))
         && (pSlHParams->weighted_bipred_idc == 1)) {
@@ -925,30 +859,33 @@ static void tng__H264ES_writebits_slice_header(
     }
 
     if (pSlHParams->SliceFrame_Type == SLHP_IDR_SLICEFRAME_TYPE) {
-        tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, 0, 1);                                                                 // no_output_of_prior_pics_flag (1 bit) = 0
-        tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, pSlHParams->bIsLongTermRef ? 1 : 0, 1);  // long_term_reference_flag (1 bit) = 0
+        asFields[ui32Count++] = header_bits_u(0, 1);                                                                 // no_output_of_prior_pics_flag (1 bit) = 0
+        asFields[ui32Count++] = header_bits_u(pSlHParams->bIsLongTermRef ? 1 : 0, 1);  // long_term_reference_flag (1 bit) = 0
     } else if (pSlHParams->bReferencePicture) {
         if (pSlHParams->bIsLongTermRef) {
-            tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, 1, 1); // adaptive_ref_pic_marking_mode_flag (1 bit) = 0
+            asFields[ui32Count++] = header_bits_u(1, 1); // adaptive_ref_pic_marking_mode_flag (1 bit) = 0
 
             // Allow a single long-term reference
-            tng__generate_ue(pMTX_Header, aui32ElementPointers, 4);                                 // memory_management_control_operation
-            tng__generate_ue(pMTX_Header, aui32ElementPointers, 2);                                 // max_long_term_frame_idx_plus1
+            asFields[ui32Count++] = header_bits_ue(4);                                 // memory_management_control_operation
+            asFields[ui32Count++] = header_bits_ue(2);                                 // max_long_term_frame_idx_plus1
 
             // Set current picture as the long-term reference
-            tng__generate_ue(pMTX_Header, aui32ElementPointers, 6);                                 // memory_management_control_operation
-            tng__generate_ue(pMTX_Header, aui32ElementPointers, pSlHParams->uLongTermRefNum);                                       // long_term_frame_idx
+            asFields[ui32Count++] = header_bits_ue(6);                                 // memory_management_control_operation
+            asFields[ui32Count++] = header_bits_ue(pSlHParams->uLongTermRefNum);                                       // long_term_frame_idx
 
             // End
-            tng__generate_ue(pMTX_Header, aui32ElementPointers, 0);                                 // memory_management_control_operation
+            asFields[ui32Count++] = header_bits_ue(0);                                 // memory_management_control_operation
         } else
-            tng__write_upto8bits_elements(pMTX_Header, aui32ElementPointers, 0, 1);         // adaptive_ref_pic_marking_mode_flag (1 bit) = 0
+            asFields[ui32Count++] = header_bits_u(0, 1);         // adaptive_ref_pic_marking_mode_flag (1 bit) = 0
     }
 
     if (bCabacEnabled && ((SLHP_P_SLICEFRAME_TYPE == pSlHParams->SliceFrame_Type) ||
                           (SLHP_B_SLICEFRAME_TYPE == pSlHParams->SliceFrame_Type))) {
-        tng__generate_ue(pMTX_Header, aui32ElementPointers, 0); // hard code cabac_init_idc value of 0
+        asFields[ui32Count++] = header_bits_ue(0); // hard code cabac_init_idc value of 0
     }
+    tng__write_fields(pMTX_Header, aui32ElementPointers, asFields, ui32Count);
+    ui32Count = 0;
+
     tng__insert_element_token(pMTX_Header, aui32ElementPointers, ELEMENT_SQP); //MTX fills this value in
     tng__insert_element_token(pMTX_Header, aui32ElementPointers, ELEMENT_RAWDATA);
 
@@ -956,11 +893,12 @@ static void tng__H264ES_writebits_slice_header(
     ///**** ELEMENT BITCOUNT: 11
     // Next field is generated on MTX with a special commnad (not ELEMENT_RAW) - so not defined here
     //pucHS=tng__generate_se(pucHS, puiBitPos, pSlHParams->Slice_QP_Delta); //slice_qp_delta se(v) = SliceQPy - (pic_init_qp_minus26+26)
-    tng__generate_ue(pMTX_Header, aui32ElementPointers, pSlHParams->Disable_Deblocking_Filter_Idc); //disable_deblocking_filter_idc ue(v) = 2?
+    asFields[ui32Count++] = header_bits_ue(pSlHParams->Disable_Deblocking_Filter_Idc); //disable_deblocking_filter_idc ue(v) = 2?
     if (pSlHParams->Disable_Deblocking_Filter_Idc != 1) {
-        tng__generate_se(pMTX_Header, aui32ElementPointers, pSlHParams->iDebAlphaOffsetDiv2); //slice_alpha_c0_offset_div2 se(v) = 0 (1b) in Topaz
-        tng__generate_se(pMTX_Header, aui32ElementPointers, pSlHParams->iDebBetaOffsetDiv2); //slice_beta_offset_div2 se(v) = 0 (1b) in Topaz
+        asFields[ui32Count++] = header_bits_se(pSlHParams->iDebAlphaOffsetDiv2); //slice_alpha_c0_offset_div2 se(v) = 0 (1b) in Topaz
+        asFields[ui32Count++] = header_bits_se(pSlHParams->iDebBetaOffsetDiv2); //slice_beta_offset_div2 se(v) = 0 (1b) in Topaz
     }
+    tng__write_fields(pMTX_Header, aui32ElementPointers, asFields, ui32Count);
     //num_slice_groups_minus1 ==0 in Topaz, so no slice_group_change_cycle field here
     // no byte alignment at end of slice headers
     return ;
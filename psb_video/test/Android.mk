@@ -0,0 +1,96 @@
+# Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the
+# "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sub license, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# The above copyright notice and this permission notice (including the
+# next paragraph) shall be included in all copies or substantial portions
+# of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+# IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+# TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+# SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+
+LOCAL_PATH := $(call my-dir)
+
+# host test of the object heap stale IDs
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    object_heap_test.c \
+    ../src/object_heap.c
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../src
+
+LOCAL_CFLAGS += -DDEBUG_TRACE
+
+LOCAL_MODULE := psb_object_heap_test
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# host benchmark of the object heap against the former heap
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    object_heap_benchmark.c \
+    ../src/object_heap.c
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../src
+
+LOCAL_CFLAGS += -O2
+
+LOCAL_LDLIBS := -lrt
+
+LOCAL_MODULE := psb_object_heap_benchmark
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# host test of the header bit writer against the golden PNW and TNG headers
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    header_bits_test.c \
+    ../src/header_bits.c
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/../src \
+    $(LOCAL_PATH)/../src/hwdefs
+
+LOCAL_CFLAGS += -DLINUX
+
+LOCAL_MODULE := psb_header_bits_test
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# host benchmark of the header bit writer against the former writer
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    header_bits_benchmark.c \
+    ../src/header_bits.c
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/../src \
+    $(LOCAL_PATH)/../src/hwdefs
+
+LOCAL_CFLAGS += -DLINUX -O2
+
+LOCAL_LDLIBS := -lrt
+
+LOCAL_MODULE := psb_header_bits_benchmark
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+ * Host benchmark of the header bit writer against the former writer, which
+ * wrote the headers by up to 8 bits at once, recursing on byte boundaries.
+ * The golden headers are built in turn, call by call and field batch by
+ * field batch, and the rate is given in headers per second.
+ *
+ * Usage: header_bits_benchmark [rounds]
+ */
+
+#include "header_bits.h"
+#include "header_bits_corpus.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ELEMENTS_EMPTY    9999
+
+typedef struct {
+    IMG_UINT32 Element_Type;
+    IMG_UINT8 Size;
+    IMG_UINT8 Bits;
+} BENCH_ELEMENT;
+
+typedef struct {
+    IMG_UINT32 Elements;
+    IMG_UINT32 words[255];
+    BENCH_ELEMENT *elt_p[HEADER_BITS_MAX_ELEMENTS];
+} BENCH_HEADER;
+
+/*
+ * Former writer, as in pnw_hostheader.c. Not inlined, as the writers are
+ * called from several header functions.
+ */
+__attribute__((noinline)) static void legacy_write_upto8bits(BENCH_HEADER *hdr, IMG_UINT32 raw_type,
+                                                             IMG_UINT8 wrt_bits, IMG_UINT16 bit_cnt)
+{
+    IMG_UINT8 *wrt_bytes_p;
+    IMG_UINT8 *size_bits_p;
+    union {
+        IMG_UINT32 UI16Input;
+        IMG_UINT8 UI8Input[2];
+    } InputVal;
+    IMG_UINT8 OutByteIndex;
+    IMG_INT16 Shift;
+
+    if (bit_cnt == 0 || hdr->Elements >= HEADER_BITS_MAX_ELEMENTS)
+        return;
+
+    wrt_bits &= (0x00ff >> (8 - bit_cnt));
+    InputVal.UI16Input = 0;
+    size_bits_p = &hdr->elt_p[hdr->Elements]->Size;
+    wrt_bytes_p = &hdr->elt_p[hdr->Elements]->Bits;
+    OutByteIndex = (size_bits_p[0] / 8);
+
+    if (!(size_bits_p[0] & 7)) {
+        if (size_bits_p[0] >= 120) {
+            if (++hdr->Elements >= HEADER_BITS_MAX_ELEMENTS)
+                return;
+            hdr->elt_p[hdr->Elements] = (BENCH_ELEMENT *) &wrt_bytes_p[15];
+            hdr->elt_p[hdr->Elements]->Element_Type = raw_type;
+            hdr->elt_p[hdr->Elements]->Size = 0;
+            legacy_write_upto8bits(hdr, raw_type, wrt_bits, bit_cnt);
+            return;
+        }
+        wrt_bytes_p[OutByteIndex] = 0;
+    }
+
+    Shift = (IMG_INT16)((8 - bit_cnt) - (size_bits_p[0] & 7));
+    if (Shift >= 0) {
+        wrt_bits <<= Shift;
+        wrt_bytes_p[OutByteIndex] |= wrt_bits;
+        size_bits_p[0] = size_bits_p[0] + bit_cnt;
+    } else {
+        InputVal.UI8Input[1] = (IMG_UINT8) wrt_bits + 256;
+        InputVal.UI16Input >>= -Shift;
+        wrt_bytes_p[OutByteIndex] |= InputVal.UI8Input[1];
+        size_bits_p[0] = size_bits_p[0] + bit_cnt;
+        size_bits_p[0] = size_bits_p[0] - ((IMG_UINT8) - Shift);
+        InputVal.UI8Input[0] = InputVal.UI8Input[0] >> (8 + Shift);
+        legacy_write_upto8bits(hdr, raw_type, InputVal.UI8Input[0], (IMG_UINT16) - Shift);
+    }
+}
+
+__attribute__((noinline)) static void legacy_write_upto32bits(BENCH_HEADER *hdr, IMG_UINT32 raw_type,
+                                                              IMG_UINT32 wrt_bits, IMG_UINT32 bit_cnt)
+{
+    IMG_UINT32 BitLp;
+    IMG_UINT32 EndByte;
+    IMG_UINT8 Bytes[4];
+
+    for (BitLp = 0; BitLp < 4; BitLp++) {
+        Bytes[BitLp] = (IMG_UINT8)(wrt_bits & 255);
+        wrt_bits = wrt_bits >> 8;
+    }
+    EndByte = ((bit_cnt + 7) / 8);
+    if (EndByte == 0)
+        return;
+    if ((bit_cnt) % 8)
+        legacy_write_upto8bits(hdr, raw_type, Bytes[EndByte - 1], (IMG_UINT8)((bit_cnt) % 8));
+    else
+        legacy_write_upto8bits(hdr, raw_type, Bytes[EndByte - 1], 8);
+    for (BitLp = EndByte - 1; BitLp > 0; BitLp--)
+        legacy_write_upto8bits(hdr, raw_type, Bytes[BitLp - 1], 8);
+}
+
+__attribute__((noinline)) static void legacy_generate_ue(BENCH_HEADER *hdr, IMG_UINT32 raw_type,
+                                                         IMG_UINT32 uiVal)
+{
+    IMG_UINT32 uiLp;
+    IMG_UINT8 ucZeros;
+    IMG_UINT32 uiChunk;
+
+    for (uiLp = 1, ucZeros = 0; (uiLp - 1) < uiVal ; uiLp = uiLp + uiLp, ucZeros++)
+        uiVal = uiVal - uiLp;
+    for (uiLp = (IMG_UINT32) ucZeros; uiLp + 1 > 8; uiLp -= 8)
+        legacy_write_upto8bits(hdr, raw_type, 0, 8);
+    legacy_write_upto8bits(hdr, raw_type, (IMG_UINT8) 1, (IMG_UINT8)(uiLp + 1));
+    while (ucZeros > 8) {
+        ucZeros -= 8;
+        uiChunk = (uiVal >> ucZeros);
+        legacy_write_upto8bits(hdr, raw_type, (IMG_UINT8) uiChunk, 8);
+        uiVal = uiVal - (uiChunk << ucZeros);
+    }
+    legacy_write_upto8bits(hdr, raw_type, (IMG_UINT8) uiVal, ucZeros);
+}
+
+__attribute__((noinline)) static void legacy_generate_se(BENCH_HEADER *hdr, IMG_UINT32 raw_type, int iVal)
+{
+    if (iVal > 0)
+        legacy_generate_ue(hdr, raw_type, (IMG_UINT32)(iVal + iVal - 1));
+    else
+        legacy_generate_ue(hdr, raw_type, (IMG_UINT32)(-iVal - iVal));
+}
+
+static void bench_insert_token(BENCH_HEADER *hdr, IMG_UINT32 raw_type, IMG_UINT32 token)
+{
+    BENCH_ELEMENT *elt;
+
+    if (hdr->Elements != BENCH_ELEMENTS_EMPTY) {
+        IMG_UINT32 offset = 4;
+
+        if (hdr->Elements >= HEADER_BITS_MAX_ELEMENTS - 1)
+            return;
+        elt = hdr->elt_p[hdr->Elements];
+        if (elt->Element_Type <= raw_type)
+            offset = (elt->Size + 8 + 31) / 32 * 4 + 4;
+        hdr->Elements++;
+        hdr->elt_p[hdr->Elements] = (BENCH_ELEMENT *)((IMG_UINT8 *) elt + offset);
+    } else {
+        hdr->Elements = 0;
+    }
+    elt = hdr->elt_p[hdr->Elements];
+    elt->Element_Type = token;
+    elt->Size = 0;
+}
+
+static void bench_init(BENCH_HEADER *hdr)
+{
+    hdr->Elements = BENCH_ELEMENTS_EMPTY;
+    hdr->elt_p[0] = (BENCH_ELEMENT *) hdr->words;
+}
+
+static void build_legacy(BENCH_HEADER *hdr, const GOLDEN_HEADER *golden)
+{
+    IMG_UINT32 i;
+
+    bench_init(hdr);
+    for (i = 0; i < golden->op_count; i++) {
+        const HEADER_OP *op = &golden->ops[i];
+
+        switch (op->type) {
+        case OP_TOKEN:
+            bench_insert_token(hdr, golden->raw_type, (IMG_UINT32) op->value);
+            break;
+        case OP_UE:
+            legacy_generate_ue(hdr, golden->raw_type, (IMG_UINT32) op->value);
+            break;
+        case OP_SE:
+            legacy_generate_se(hdr, golden->raw_type, op->value);
+            break;
+        default:
+            if (op->bits <= 8)
+                legacy_write_upto8bits(hdr, golden->raw_type, (IMG_UINT8) op->value, (IMG_UINT16) op->bits);
+            else
+                legacy_write_upto32bits(hdr, golden->raw_type, (IMG_UINT32) op->value, op->bits);
+            break;
+        }
+    }
+    hdr->Elements++;
+}
+
+static void build_calls(BENCH_HEADER *hdr, const GOLDEN_HEADER *golden)
+{
+    IMG_UINT32 i;
+
+    bench_init(hdr);
+    for (i = 0; i < golden->op_count; i++) {
+        const HEADER_OP *op = &golden->ops[i];
+
+        switch (op->type) {
+        case OP_TOKEN:
+            bench_insert_token(hdr, golden->raw_type, (IMG_UINT32) op->value);
+            break;
+        case OP_UE:
+            header_bits_write_ue(&hdr->Elements, (void **) hdr->elt_p, golden->raw_type,
+                                 (IMG_UINT32) op->value);
+            break;
+        case OP_SE:
+            header_bits_write_se(&hdr->Elements, (void **) hdr->elt_p, golden->raw_type, op->value);
+            break;
+        default:
+            header_bits_write(&hdr->Elements, (void **) hdr->elt_p, golden->raw_type,
+                              (IMG_UINT32) op->value, op->bits);
+            break;
+        }
+    }
+    hdr->Elements++;
+}
+
+/* Fields between tokens are written at once, as in the slice headers */
+static void build_fields(BENCH_HEADER *hdr, const GOLDEN_HEADER *golden)
+{
+    HEADER_BITS_FIELD fields[64];
+    IMG_UINT32 count = 0;
+    IMG_UINT32 i;
+
+    bench_init(hdr);
+    for (i = 0; i < golden->op_count; i++) {
+        const HEADER_OP *op = &golden->ops[i];
+
+        if (op->type == OP_TOKEN || count == sizeof(fields) / sizeof(fields[0])) {
+            header_bits_write_fields(&hdr->Elements, (void **) hdr->elt_p, golden->raw_type,
+                                     fields, count);
+            count = 0;
+        }
+        switch (op->type) {
+        case OP_TOKEN:
+            bench_insert_token(hdr, golden->raw_type, (IMG_UINT32) op->value);
+            break;
+        case OP_UE:
+            fields[count++] = header_bits_ue((IMG_UINT32) op->value);
+            break;
+        case OP_SE:
+            fields[count++] = header_bits_se(op->value);
+            break;
+        default:
+            fields[count++] = header_bits_u((IMG_UINT32) op->value, (IMG_UINT8) op->bits);
+            break;
+        }
+    }
+    header_bits_write_fields(&hdr->Elements, (void **) hdr->elt_p, golden->raw_type, fields, count);
+    hdr->Elements++;
+}
+
+static double now_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+/* Builds every golden header rounds times, returns the headers per second */
+static double run(void (*build)(BENCH_HEADER *, const GOLDEN_HEADER *), int rounds,
+                  const GOLDEN_HEADER *golden, IMG_UINT32 golden_count, IMG_UINT32 *checksum)
+{
+    BENCH_HEADER hdr;
+    double start, ms;
+    IMG_UINT32 i;
+    int r;
+
+    start = now_ms();
+    for (r = 0; r < rounds; r++) {
+        for (i = 0; i < golden_count; i++) {
+            build(&hdr, &golden[i]);
+            *checksum += hdr.Elements + hdr.words[1];
+        }
+    }
+    ms = now_ms() - start;
+    return ms > 0 ? rounds * golden_count * 1000.0 / ms : 0;
+}
+
+static void report(const char *name, double rate, double legacy_rate)
+{
+    printf("%-28s %12.0f /s  x%.1f\n", name, rate, legacy_rate > 0 ? rate / legacy_rate : 0);
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 100000;
+    IMG_UINT32 count = sizeof(asGoldenHeaders) / sizeof(asGoldenHeaders[0]);
+    GOLDEN_HEADER slices[sizeof(asGoldenHeaders) / sizeof(asGoldenHeaders[0])];
+    IMG_UINT32 slice_count = 0;
+    IMG_UINT32 checksum = 0;
+    double legacy_rate;
+    IMG_UINT32 i;
+
+    if (rounds <= 0) {
+        fprintf(stderr, "usage: %s [rounds]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    printf("%u headers, %d rounds\n", count, rounds);
+
+    legacy_rate = run(build_legacy, rounds, asGoldenHeaders, count, &checksum);
+    report("former writer", legacy_rate, legacy_rate);
+    report("word writer", run(build_calls, rounds, asGoldenHeaders, count, &checksum), legacy_rate);
+    report("word writer, fields", run(build_fields, rounds, asGoldenHeaders, count, &checksum), legacy_rate);
+
+    /* Slice headers alone, built for every slice of every frame */
+    for (i = 0; i < count; i++) {
+        if (strstr(asGoldenHeaders[i].name, "Slice"))
+            slices[slice_count++] = asGoldenHeaders[i];
+    }
+    legacy_rate = run(build_legacy, rounds, slices, slice_count, &checksum);
+    report("slices, former writer", legacy_rate, legacy_rate);
+    report("slices, word writer, fields", run(build_fields, rounds, slices, slice_count, &checksum),
+           legacy_rate);
+
+    printf("checksum %u\n", checksum);
+    return EXIT_SUCCESS;
+}
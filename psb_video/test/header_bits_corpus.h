@@ -0,0 +1,430 @@
+/*
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+ * Golden headers of the PNW and TNG host header writers, recorded from the
+ * former bit by bit writers. Each header is the sequence of the writer calls
+ * made by its prepare function (fixed bits, ue(v), se(v) and element tokens,
+ * nested calls excluded), then the header memory it produced. The memory was
+ * filled with 0xcd beforehand, which is kept in the bytes never written.
+ */
+
+#ifndef _HEADER_BITS_CORPUS_H_
+#define _HEADER_BITS_CORPUS_H_
+
+#include "img_types.h"
+
+typedef enum {
+    OP_U = 0,           /* value on bits */
+    OP_UE,              /* ue(value) */
+    OP_SE,              /* se(value) */
+    OP_TOKEN            /* new element of type value */
+} HEADER_OP_TYPE;
+
+typedef struct {
+    HEADER_OP_TYPE type;
+    IMG_INT32 value;
+    IMG_UINT32 bits;
+} HEADER_OP;
+
+typedef struct {
+    const char *name;
+    IMG_UINT32 raw_type;        /* ELEMENT_RAWDATA of the writer */
+    const HEADER_OP *ops;
+    IMG_UINT32 op_count;
+    const IMG_UINT8 *bytes;
+    IMG_UINT32 byte_count;
+} GOLDEN_HEADER;
+
+/* PNW H264 sequence header, 1080p main profile with VUI and cropping */
+static const HEADER_OP aPnwSequenceOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 0, 8 }, { OP_U, 0, 8 }, { OP_U, 0, 8 },
+    { OP_U, 1, 8 }, { OP_U, 103, 8 }, { OP_U, 77, 8 }, { OP_U, 0, 8 },
+    { OP_U, 41, 8 }, { OP_U, 83, 7 }, { OP_UE, 1, 0 }, { OP_U, 0, 1 },
+    { OP_UE, 119, 0 }, { OP_UE, 67, 0 }, { OP_U, 1, 1 }, { OP_U, 1, 1 },
+    { OP_U, 1, 1 }, { OP_UE, 0, 0 }, { OP_UE, 0, 0 }, { OP_UE, 0, 0 },
+    { OP_UE, 4, 0 }, { OP_U, 1, 1 }, { OP_U, 1, 1 }, { OP_U, 255, 8 },
+    { OP_U, 4, 16 }, { OP_U, 3, 16 }, { OP_U, 1, 4 }, { OP_U, 1001, 32 },
+    { OP_U, 60000, 32 }, { OP_U, 1, 1 }, { OP_U, 1, 1 }, { OP_U, 1, 1 },
+    { OP_U, 0, 4 }, { OP_U, 2, 4 }, { OP_UE, 3124, 0 }, { OP_UE, 4687, 0 },
+    { OP_U, 1, 1 }, { OP_U, 23, 5 }, { OP_U, 23, 5 }, { OP_U, 23, 5 },
+    { OP_U, 24, 5 }, { OP_U, 0, 1 }, { OP_U, 0, 1 }, { OP_U, 0, 1 },
+    { OP_U, 0, 1 }, { OP_U, 1, 1 }, { OP_U, 0, 5 },
+};
+static const IMG_UINT8 aPnwSequenceBytes[] = {
+    0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x78, 0x00, 0x00, 0x00,
+    0x01, 0x67, 0x4d, 0x00, 0x29, 0xa6, 0x80, 0x78, 0x02, 0x27, 0xe5, 0xff,
+    0x01, 0x00, 0x00, 0x00, 0x78, 0xc0, 0x01, 0x00, 0x00, 0xc4, 0x00, 0x00,
+    0x0f, 0xa4, 0x00, 0x03, 0xa9, 0x83, 0x81, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x48, 0x0c, 0x35, 0x00, 0x09, 0x28, 0x6f, 0x7b, 0xe0, 0x20,
+};
+
+/* PNW H264 sequence header, VGA baseline without VUI */
+static const HEADER_OP aPnwSequenceBaseOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 0, 8 }, { OP_U, 0, 8 }, { OP_U, 0, 8 },
+    { OP_U, 1, 8 }, { OP_U, 103, 8 }, { OP_U, 66, 8 }, { OP_U, 64, 8 },
+    { OP_U, 30, 8 }, { OP_U, 83, 7 }, { OP_UE, 1, 0 }, { OP_U, 0, 1 },
+    { OP_UE, 39, 0 }, { OP_UE, 29, 0 }, { OP_U, 1, 1 }, { OP_U, 1, 1 },
+    { OP_U, 0, 1 }, { OP_U, 0, 1 }, { OP_U, 1, 1 }, { OP_U, 0, 4 },
+};
+static const IMG_UINT8 aPnwSequenceBaseBytes[] = {
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x68, 0x00, 0x00, 0x00,
+    0x01, 0x67, 0x42, 0x40, 0x1e, 0xa6, 0x80, 0xa0, 0x3d, 0x90,
+};
+
+/* PNW H264 picture header, CABAC */
+static const HEADER_OP aPnwPictureOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 0, 8 }, { OP_U, 0, 8 }, { OP_U, 0, 8 },
+    { OP_U, 1, 8 }, { OP_U, 40, 8 }, { OP_U, 238, 8 }, { OP_U, 0, 2 },
+    { OP_TOKEN, 2, 0 }, { OP_TOKEN, 1, 0 }, { OP_SE, 0, 0 }, { OP_SE, -2, 0 },
+    { OP_U, 4, 3 }, { OP_TOKEN, 6, 0 },
+};
+static const IMG_UINT8 aPnwPictureBytes[] = {
+    0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x32, 0x00, 0x00, 0x00,
+    0x01, 0x28, 0xee, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x09, 0x96, 0x00, 0xcd, 0x06, 0x00, 0x00, 0x00, 0x00,
+};
+
+/* PNW H264 IDR slice header */
+static const HEADER_OP aPnwSliceIdrOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 0, 8 }, { OP_U, 0, 8 }, { OP_U, 0, 8 },
+    { OP_U, 1, 8 }, { OP_U, 37, 8 }, { OP_UE, 0, 0 }, { OP_UE, 2, 0 },
+    { OP_U, 32, 6 }, { OP_UE, 3, 0 }, { OP_U, 0, 1 }, { OP_U, 0, 1 },
+    { OP_TOKEN, 3, 0 }, { OP_TOKEN, 1, 0 }, { OP_UE, 0, 0 }, { OP_SE, 0, 0 },
+    { OP_SE, 0, 0 },
+};
+static const IMG_UINT8 aPnwSliceIdrBytes[] = {
+    0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x39, 0x00, 0x00, 0x00,
+    0x01, 0x25, 0xb8, 0x08, 0x00, 0xcd, 0xcd, 0xcd, 0x03, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x03, 0xe0,
+};
+
+/* PNW H264 P slice header, long term reference */
+static const HEADER_OP aPnwSlicePOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 0, 8 }, { OP_U, 0, 8 }, { OP_U, 0, 8 },
+    { OP_U, 1, 8 }, { OP_U, 33, 8 }, { OP_UE, 3600, 0 }, { OP_UE, 0, 0 },
+    { OP_U, 37, 6 }, { OP_U, 0, 1 }, { OP_U, 0, 1 }, { OP_U, 0, 1 },
+    { OP_TOKEN, 3, 0 }, { OP_TOKEN, 1, 0 }, { OP_UE, 1, 0 },
+};
+static const IMG_UINT8 aPnwSlicePBytes[] = {
+    0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x49, 0x00, 0x00, 0x00,
+    0x01, 0x21, 0x00, 0x1c, 0x23, 0x94, 0x00, 0xcd, 0x03, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x03, 0x40,
+};
+
+/* PNW H264 skipped P slice header */
+static const HEADER_OP aPnwSliceSkipOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 0, 8 }, { OP_U, 0, 8 }, { OP_U, 0, 8 },
+    { OP_U, 1, 8 }, { OP_U, 33, 8 }, { OP_UE, 3600, 0 }, { OP_UE, 0, 0 },
+    { OP_U, 37, 6 }, { OP_U, 0, 1 }, { OP_U, 0, 1 }, { OP_U, 0, 1 },
+    { OP_TOKEN, 3, 0 }, { OP_TOKEN, 1, 0 }, { OP_UE, 1, 0 }, { OP_UE, 3600, 0 },
+    { OP_TOKEN, 6, 0 },
+};
+static const IMG_UINT8 aPnwSliceSkipBytes[] = {
+    0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x49, 0x00, 0x00, 0x00,
+    0x01, 0x21, 0x00, 0x1c, 0x23, 0x94, 0x00, 0xcd, 0x03, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x1a, 0x40, 0x03, 0x84, 0x40, 0xcd, 0xcd, 0xcd,
+    0x06, 0x00, 0x00, 0x00, 0x00,
+};
+
+/* PNW MPEG4 VOL header with VBV parameters */
+static const HEADER_OP aPnwMpeg4SequenceOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 432, 32 }, { OP_U, 3, 8 }, { OP_U, 0, 8 },
+    { OP_U, 0, 8 }, { OP_U, 1, 8 }, { OP_U, 181, 8 }, { OP_U, 0, 1 },
+    { OP_U, 1, 4 }, { OP_U, 0, 1 }, { OP_U, 1, 2 }, { OP_U, 0, 8 },
+    { OP_U, 0, 8 }, { OP_U, 1, 8 }, { OP_U, 0, 8 }, { OP_U, 0, 8 },
+    { OP_U, 0, 8 }, { OP_U, 1, 8 }, { OP_U, 32, 8 }, { OP_U, 0, 1 },
+    { OP_U, 1, 8 }, { OP_U, 1, 1 }, { OP_U, 1, 4 }, { OP_U, 1, 3 },
+    { OP_U, 1, 4 }, { OP_U, 0, 1 }, { OP_U, 0, 2 }, { OP_U, 1, 1 },
+    { OP_U, 30, 16 }, { OP_U, 1, 1 }, { OP_U, 0, 1 }, { OP_U, 1, 1 },
+    { OP_U, 640, 13 }, { OP_U, 1, 1 }, { OP_U, 480, 13 }, { OP_U, 1, 1 },
+    { OP_U, 0, 1 }, { OP_U, 1, 1 }, { OP_U, 0, 1 }, { OP_U, 0, 1 },
+    { OP_U, 0, 1 }, { OP_U, 1, 1 }, { OP_U, 1, 1 }, { OP_U, 0, 1 },
+    { OP_U, 0, 1 }, { OP_TOKEN, 7, 0 },
+};
+static const IMG_UINT8 aPnwMpeg4SequenceBytes[] = {
+    0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x78, 0x00, 0x00, 0x01,
+    0xb0, 0x03, 0x00, 0x00, 0x01, 0xb5, 0x09, 0x00, 0x00, 0x01, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x69, 0x00, 0x01, 0x20, 0x00, 0xc4, 0x88, 0x80,
+    0x0f, 0x51, 0x40, 0x43, 0xc1, 0x46, 0x00, 0xcd, 0x07, 0x00, 0x00, 0x00,
+    0x00,
+};
+
+/* PNW MPEG4 P VOP header */
+static const HEADER_OP aPnwMpeg4VopOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 438, 32 }, { OP_U, 1, 2 }, { OP_U, 0, 1 },
+    { OP_U, 1, 1 }, { OP_U, 0, 15 }, { OP_U, 1, 1 }, { OP_U, 1, 1 },
+    { OP_U, 0, 1 }, { OP_U, 0, 3 }, { OP_TOKEN, 4, 0 }, { OP_TOKEN, 1, 0 },
+    { OP_U, 3, 3 },
+};
+static const IMG_UINT8 aPnwMpeg4VopBytes[] = {
+    0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x39, 0x00, 0x00, 0x01,
+    0xb6, 0x50, 0x00, 0x18, 0x00, 0xcd, 0xcd, 0xcd, 0x04, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x03, 0x60,
+};
+
+/* PNW H263 picture header */
+static const HEADER_OP aPnwH263PictureOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 32, 22 }, { OP_U, 17, 8 }, { OP_U, 1, 1 },
+    { OP_U, 0, 1 }, { OP_U, 0, 1 }, { OP_U, 0, 1 }, { OP_U, 0, 1 },
+    { OP_U, 2, 3 }, { OP_U, 1, 1 }, { OP_U, 0, 4 }, { OP_TOKEN, 4, 0 },
+    { OP_TOKEN, 1, 0 }, { OP_U, 0, 1 }, { OP_U, 0, 1 },
+};
+static const IMG_UINT8 aPnwH263PictureBytes[] = {
+    0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2b, 0x00, 0x00, 0x80,
+    0x46, 0x0a, 0x00, 0xcd, 0x04, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x02, 0x00,
+};
+
+/* PNW H264 SEI buffering period */
+static const HEADER_OP aPnwSeiBufferingOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 0, 8 }, { OP_U, 0, 8 }, { OP_U, 0, 8 },
+    { OP_U, 1, 8 }, { OP_U, 6, 8 }, { OP_U, 0, 8 }, { OP_U, 13, 8 },
+    { OP_UE, 0, 0 }, { OP_U, 90000, 24 }, { OP_U, 0, 24 }, { OP_TOKEN, 0, 0 },
+    { OP_U, 45000, 24 }, { OP_U, 0, 24 }, { OP_U, 64, 7 }, { OP_U, 128, 8 },
+};
+static const IMG_UINT8 aPnwSeiBufferingBytes[] = {
+    0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x69, 0x00, 0x00, 0x00,
+    0x01, 0x06, 0x00, 0x0d, 0x80, 0xaf, 0xc8, 0x00, 0x00, 0x00, 0x00, 0xcd,
+    0x00, 0x00, 0x00, 0x00, 0x3f, 0x00, 0xaf, 0xc8, 0x00, 0x00, 0x00, 0x81,
+    0x00,
+};
+
+/* PNW H264 SEI picture timing with clock timestamps */
+static const HEADER_OP aPnwSeiTimingOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 0, 8 }, { OP_U, 0, 8 }, { OP_U, 0, 8 },
+    { OP_U, 1, 8 }, { OP_U, 6, 8 }, { OP_U, 1, 8 }, { OP_U, 6, 8 },
+    { OP_U, 2, 24 }, { OP_U, 4, 24 }, { OP_U, 128, 8 },
+};
+static const IMG_UINT8 aPnwSeiTimingBytes[] = {
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x70, 0x00, 0x00, 0x00,
+    0x01, 0x06, 0x01, 0x06, 0x00, 0x00, 0x02, 0x00, 0x00, 0x04, 0x80,
+};
+
+/* TNG H264 sequence header, 1080p high profile with VUI and cropping */
+static const HEADER_OP aTngSequenceOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 0, 8 }, { OP_U, 0, 8 }, { OP_U, 0, 8 },
+    { OP_U, 1, 8 }, { OP_U, 103, 8 }, { OP_U, 100, 8 }, { OP_U, 0, 8 },
+    { OP_U, 41, 8 }, { OP_UE, 0, 0 }, { OP_UE, 1, 0 }, { OP_UE, 0, 0 },
+    { OP_UE, 0, 0 }, { OP_U, 0, 1 }, { OP_U, 0, 1 }, { OP_UE, 1, 0 },
+    { OP_UE, 0, 0 }, { OP_UE, 2, 0 }, { OP_UE, 2, 0 }, { OP_U, 0, 1 },
+    { OP_UE, 119, 0 }, { OP_UE, 67, 0 }, { OP_U, 1, 1 }, { OP_U, 1, 1 },
+    { OP_U, 1, 1 }, { OP_UE, 0, 0 }, { OP_UE, 0, 0 }, { OP_UE, 0, 0 },
+    { OP_UE, 4, 0 }, { OP_U, 1, 1 }, { OP_U, 1, 5 }, { OP_U, 1001, 32 },
+    { OP_U, 60000, 32 }, { OP_U, 1, 1 }, { OP_U, 1, 1 }, { OP_U, 1, 1 },
+    { OP_U, 0, 4 }, { OP_U, 2, 4 }, { OP_UE, 3124, 0 }, { OP_UE, 4687, 0 },
+    { OP_U, 1, 1 }, { OP_U, 23, 5 }, { OP_U, 23, 5 }, { OP_U, 23, 5 },
+    { OP_U, 24, 5 }, { OP_U, 0, 1 }, { OP_U, 0, 1 }, { OP_U, 0, 1 },
+    { OP_U, 0, 1 }, { OP_TOKEN, 7, 0 },
+};
+static const IMG_UINT8 aTngSequenceBytes[] = {
+    0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x78, 0x00, 0x00, 0x00,
+    0x01, 0x67, 0x64, 0x00, 0x29, 0xac, 0x56, 0xc0, 0x78, 0x02, 0x27, 0xe5,
+    0x02, 0x00, 0x00, 0x00, 0x78, 0x84, 0x00, 0x00, 0x0f, 0xa4, 0x00, 0x03,
+    0xa9, 0x83, 0x81, 0x00, 0x0c, 0x35, 0x00, 0x09, 0x02, 0x00, 0x00, 0x00,
+    0x22, 0x28, 0x6f, 0x7b, 0xe0, 0x00, 0xcd, 0xcd, 0x07, 0x00, 0x00, 0x00,
+    0x00,
+};
+
+/* TNG H264 MVC subset sequence header */
+static const HEADER_OP aTngSequenceMvcOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 0, 8 }, { OP_U, 0, 8 }, { OP_U, 0, 8 },
+    { OP_U, 1, 8 }, { OP_U, 111, 8 }, { OP_U, 118, 8 }, { OP_U, 0, 8 },
+    { OP_U, 40, 8 }, { OP_UE, 1, 0 }, { OP_UE, 1, 0 }, { OP_UE, 0, 0 },
+    { OP_UE, 0, 0 }, { OP_U, 0, 1 }, { OP_U, 0, 1 }, { OP_UE, 1, 0 },
+    { OP_UE, 0, 0 }, { OP_UE, 2, 0 }, { OP_UE, 1, 0 }, { OP_U, 0, 1 },
+    { OP_UE, 79, 0 }, { OP_UE, 44, 0 }, { OP_U, 1, 1 }, { OP_U, 1, 1 },
+    { OP_U, 1, 1 }, { OP_UE, 0, 0 }, { OP_UE, 0, 0 }, { OP_UE, 0, 0 },
+    { OP_UE, 4, 0 }, { OP_U, 0, 1 }, { OP_U, 1, 1 }, { OP_UE, 1, 0 },
+    { OP_UE, 0, 0 }, { OP_UE, 1, 0 }, { OP_UE, 1, 0 }, { OP_UE, 0, 0 },
+    { OP_UE, 0, 0 }, { OP_UE, 1, 0 }, { OP_UE, 0, 0 }, { OP_UE, 0, 0 },
+    { OP_UE, 0, 0 }, { OP_U, 40, 8 }, { OP_UE, 0, 0 }, { OP_U, 0, 3 },
+    { OP_UE, 0, 0 }, { OP_UE, 0, 0 }, { OP_UE, 0, 0 }, { OP_U, 0, 1 },
+    { OP_U, 0, 1 }, { OP_TOKEN, 7, 0 },
+};
+static const IMG_UINT8 aTngSequenceMvcBytes[] = {
+    0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x78, 0x00, 0x00, 0x00,
+    0x01, 0x6f, 0x76, 0x00, 0x28, 0x4b, 0x15, 0xa0, 0x14, 0x01, 0x6f, 0xe5,
+    0x02, 0x00, 0x00, 0x00, 0x25, 0x55, 0x2d, 0x72, 0x88, 0xe0, 0xcd, 0xcd,
+    0x07, 0x00, 0x00, 0x00, 0x00,
+};
+
+/* TNG H264 picture header, CABAC, 8x8 transform, weighted prediction */
+static const HEADER_OP aTngPictureOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 0, 8 }, { OP_U, 0, 8 }, { OP_U, 0, 8 },
+    { OP_U, 1, 8 }, { OP_U, 104, 8 }, { OP_UE, 0, 0 }, { OP_UE, 0, 0 },
+    { OP_U, 23, 5 }, { OP_U, 5, 3 }, { OP_TOKEN, 3, 0 }, { OP_TOKEN, 2, 0 },
+    { OP_SE, 0, 0 }, { OP_SE, 2, 0 }, { OP_U, 4, 3 }, { OP_U, 1, 1 },
+    { OP_U, 0, 1 }, { OP_SE, 2, 0 }, { OP_TOKEN, 7, 0 },
+};
+static const IMG_UINT8 aTngPictureBytes[] = {
+    0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x32, 0x00, 0x00, 0x00,
+    0x01, 0x68, 0xef, 0x40, 0x03, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+    0x10, 0x92, 0x44, 0xcd, 0x07, 0x00, 0x00, 0x00, 0x00,
+};
+
+/* TNG H264 IDR slice header */
+static const HEADER_OP aTngSliceIdrOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 0, 8 }, { OP_U, 0, 8 }, { OP_U, 0, 8 },
+    { OP_U, 1, 8 }, { OP_U, 5, 8 }, { OP_TOKEN, 12, 0 }, { OP_TOKEN, 2, 0 },
+    { OP_UE, 2, 0 }, { OP_U, 32, 6 }, { OP_UE, 0, 0 }, { OP_U, 0, 0 },
+    { OP_U, 0, 1 }, { OP_U, 0, 1 }, { OP_TOKEN, 4, 0 }, { OP_TOKEN, 2, 0 },
+    { OP_UE, 0, 0 }, { OP_SE, 0, 0 }, { OP_SE, 0, 0 },
+};
+static const IMG_UINT8 aTngSliceIdrBytes[] = {
+    0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00,
+    0x01, 0x05, 0xcd, 0xcd, 0x0c, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+    0x0c, 0x70, 0x40, 0xcd, 0x04, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+    0x03, 0xe0,
+};
+
+/* TNG H264 P slice header, weighted prediction on two references */
+static const HEADER_OP aTngSliceWeightedOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 0, 8 }, { OP_U, 0, 8 }, { OP_U, 0, 8 },
+    { OP_U, 1, 8 }, { OP_U, 1, 8 }, { OP_TOKEN, 12, 0 }, { OP_TOKEN, 2, 0 },
+    { OP_UE, 0, 0 }, { OP_U, 45, 6 }, { OP_U, 0, 0 }, { OP_U, 1, 1 },
+    { OP_UE, 1, 0 }, { OP_U, 0, 1 }, { OP_UE, 0, 0 }, { OP_TOKEN, 4, 0 },
+    { OP_TOKEN, 2, 0 }, { OP_UE, 2, 0 }, { OP_SE, 0, 0 }, { OP_SE, 0, 0 },
+};
+static const IMG_UINT8 aTngSliceWeightedBytes[] = {
+    0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00,
+    0x01, 0x01, 0xcd, 0xcd, 0x0c, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+    0x0d, 0xdb, 0x48, 0xcd, 0x04, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+    0x05, 0x78,
+};
+
+/* TNG H264 B field slice header, reordered long term references */
+static const HEADER_OP aTngSliceReorderedOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 0, 8 }, { OP_U, 0, 8 }, { OP_U, 0, 8 },
+    { OP_U, 1, 8 }, { OP_U, 33, 8 }, { OP_TOKEN, 12, 0 }, { OP_TOKEN, 2, 0 },
+    { OP_UE, 1, 0 }, { OP_U, 41, 6 }, { OP_U, 1, 1 }, { OP_U, 1, 1 },
+    { OP_U, 19, 6 }, { OP_U, 1, 1 }, { OP_U, 0, 1 }, { OP_U, 1, 1 },
+    { OP_UE, 1, 0 }, { OP_UE, 2, 0 }, { OP_UE, 3, 0 }, { OP_U, 1, 1 },
+    { OP_UE, 2, 0 }, { OP_UE, 0, 0 }, { OP_UE, 3, 0 }, { OP_U, 0, 1 },
+    { OP_UE, 0, 0 }, { OP_TOKEN, 4, 0 }, { OP_TOKEN, 2, 0 }, { OP_UE, 0, 0 },
+    { OP_SE, -3, 0 }, { OP_SE, 2, 0 },
+};
+static const IMG_UINT8 aTngSliceReorderedBytes[] = {
+    0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00,
+    0x01, 0x21, 0xcd, 0xcd, 0x0c, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+    0x2b, 0x54, 0xe9, 0xd4, 0xc9, 0x72, 0x20, 0xcd, 0x04, 0x00, 0x00, 0x00,
+    0x02, 0x00, 0x00, 0x00, 0x0b, 0x9c, 0x80,
+};
+
+/* TNG MPEG4 VOL header with VBV parameters */
+static const HEADER_OP aTngMpeg4SequenceOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 432, 32 }, { OP_U, 243, 8 }, { OP_TOKEN, 0, 0 },
+    { OP_U, 0, 8 }, { OP_U, 0, 8 }, { OP_U, 1, 8 }, { OP_U, 181, 8 },
+    { OP_U, 0, 1 }, { OP_U, 1, 4 }, { OP_U, 0, 1 }, { OP_U, 1, 2 },
+    { OP_TOKEN, 0, 0 }, { OP_U, 0, 8 }, { OP_U, 0, 8 }, { OP_U, 1, 8 },
+    { OP_U, 0, 8 }, { OP_TOKEN, 0, 0 }, { OP_U, 0, 8 }, { OP_U, 0, 8 },
+    { OP_U, 1, 8 }, { OP_U, 32, 8 }, { OP_U, 0, 1 }, { OP_U, 3, 8 },
+    { OP_U, 1, 1 }, { OP_U, 5, 4 }, { OP_U, 1, 3 }, { OP_U, 1, 4 },
+    { OP_U, 1, 1 }, { OP_U, 1, 2 }, { OP_U, 0, 1 }, { OP_U, 1, 1 },
+    { OP_U, 18, 15 }, { OP_U, 1, 1 }, { OP_U, 13398, 15 }, { OP_U, 1, 1 },
+    { OP_U, 120, 15 }, { OP_U, 1, 1 }, { OP_U, 3, 3 }, { OP_U, 291, 11 },
+    { OP_U, 1, 1 }, { OP_U, 1110, 15 }, { OP_U, 1, 1 }, { OP_U, 0, 2 },
+    { OP_U, 1, 1 }, { OP_U, 30, 16 }, { OP_U, 1, 1 }, { OP_U, 0, 1 },
+    { OP_U, 1, 1 }, { OP_U, 1280, 13 }, { OP_U, 1, 1 }, { OP_U, 720, 13 },
+    { OP_U, 1, 1 }, { OP_U, 0, 1 }, { OP_U, 1, 1 }, { OP_U, 0, 1 },
+    { OP_U, 0, 1 }, { OP_U, 0, 1 }, { OP_U, 0, 1 }, { OP_U, 1, 1 },
+    { OP_U, 1, 1 }, { OP_U, 0, 1 }, { OP_U, 0, 1 }, { OP_U, 0, 1 },
+    { OP_U, 0, 1 }, { OP_TOKEN, 8, 0 },
+};
+static const IMG_UINT8 aTngMpeg4SequenceBytes[] = {
+    0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x01,
+    0xb0, 0xf3, 0xcd, 0xcd, 0x00, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x01,
+    0xb5, 0x09, 0xcd, 0xcd, 0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x01,
+    0x00, 0xcd, 0xcd, 0xcd, 0x00, 0x00, 0x00, 0x00, 0x78, 0x00, 0x00, 0x01,
+    0x20, 0x01, 0xd4, 0x8d, 0x40, 0x09, 0x5a, 0x2b, 0x40, 0x3c, 0x59, 0x23,
+    0x02, 0x00, 0x00, 0x00, 0x4f, 0x84, 0x56, 0x90, 0x01, 0xea, 0x50, 0x08,
+    0xb4, 0x28, 0x60, 0xcd, 0x08, 0x00, 0x00, 0x00, 0x00,
+};
+
+/* TNG H263 picture header */
+static const HEADER_OP aTngH263PictureOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 32, 22 }, { OP_U, 200, 8 }, { OP_U, 1, 1 },
+    { OP_U, 0, 1 }, { OP_U, 0, 1 }, { OP_U, 0, 1 }, { OP_U, 0, 1 },
+    { OP_U, 3, 3 }, { OP_U, 0, 1 }, { OP_U, 0, 4 }, { OP_TOKEN, 5, 0 },
+    { OP_TOKEN, 2, 0 }, { OP_U, 0, 1 }, { OP_U, 0, 1 },
+};
+static const IMG_UINT8 aTngH263PictureBytes[] = {
+    0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2b, 0x00, 0x00, 0x83,
+    0x22, 0x0c, 0x00, 0xcd, 0x05, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+    0x02, 0x00,
+};
+
+/* TNG H264 SEI picture timing with clock timestamps */
+static const HEADER_OP aTngSeiTimingOps[] = {
+    { OP_TOKEN, 0, 0 }, { OP_U, 0, 8 }, { OP_U, 0, 8 }, { OP_U, 1, 8 },
+    { OP_U, 6, 8 }, { OP_U, 1, 8 }, { OP_U, 22, 8 }, { OP_TOKEN, 36, 0 },
+    { OP_TOKEN, 37, 0 }, { OP_TOKEN, 0, 0 }, { OP_U, 4, 4 }, { OP_U, 1, 1 },
+    { OP_U, 2, 2 }, { OP_U, 0, 1 }, { OP_U, 0, 5 }, { OP_U, 1, 1 },
+    { OP_U, 0, 1 }, { OP_U, 0, 1 }, { OP_U, 29, 8 }, { OP_U, 59, 6 },
+    { OP_U, 59, 6 }, { OP_U, 23, 5 }, { OP_U, 21, 24 }, { OP_U, 0, 1 },
+    { OP_U, 1, 1 }, { OP_U, 2, 2 }, { OP_U, 0, 1 }, { OP_U, 0, 5 },
+    { OP_U, 1, 1 }, { OP_U, 0, 1 }, { OP_U, 0, 1 }, { OP_U, 29, 8 },
+    { OP_U, 59, 6 }, { OP_U, 59, 6 }, { OP_U, 23, 5 }, { OP_U, 21, 24 },
+    { OP_TOKEN, 7, 0 }, { OP_TOKEN, 0, 0 }, { OP_U, 128, 8 },
+};
+static const IMG_UINT8 aTngSeiTimingBytes[] = {
+    0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x30, 0x00, 0x00, 0x01,
+    0x06, 0x01, 0x16, 0xcd, 0x24, 0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x78, 0x4c, 0x04, 0x1d, 0xef, 0xbb, 0x80, 0x00,
+    0x0a, 0xb0, 0x10, 0x77, 0xbe, 0xee, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+    0x07, 0x2a, 0xcd, 0xcd, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x08, 0x80,
+};
+
+#define GOLDEN_HEADER(name, raw_type) \
+    { #name, raw_type, a##name##Ops, sizeof(a##name##Ops) / sizeof(HEADER_OP), \
+      a##name##Bytes, sizeof(a##name##Bytes) }
+
+static const GOLDEN_HEADER asGoldenHeaders[] = {
+    GOLDEN_HEADER(PnwSequence, 1),
+    GOLDEN_HEADER(PnwSequenceBase, 1),
+    GOLDEN_HEADER(PnwPicture, 1),
+    GOLDEN_HEADER(PnwSliceIdr, 1),
+    GOLDEN_HEADER(PnwSliceP, 1),
+    GOLDEN_HEADER(PnwSliceSkip, 1),
+    GOLDEN_HEADER(PnwMpeg4Sequence, 1),
+    GOLDEN_HEADER(PnwMpeg4Vop, 1),
+    GOLDEN_HEADER(PnwH263Picture, 1),
+    GOLDEN_HEADER(PnwSeiBuffering, 1),
+    GOLDEN_HEADER(PnwSeiTiming, 1),
+    GOLDEN_HEADER(TngSequence, 2),
+    GOLDEN_HEADER(TngSequenceMvc, 2),
+    GOLDEN_HEADER(TngPicture, 2),
+    GOLDEN_HEADER(TngSliceIdr, 2),
+    GOLDEN_HEADER(TngSliceWeighted, 2),
+    GOLDEN_HEADER(TngSliceReordered, 2),
+    GOLDEN_HEADER(TngMpeg4Sequence, 2),
+    GOLDEN_HEADER(TngH263Picture, 2),
+    GOLDEN_HEADER(TngSeiTiming, 2),
+};
+
+#undef GOLDEN_HEADER
+
+#endif /* _HEADER_BITS_CORPUS_H_ */
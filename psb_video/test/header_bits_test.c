@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+ * Host tests of the header bit writer: the golden headers of the former
+ * PNW and TNG writers are rebuilt call by call and field batch by field
+ * batch, and the Exp-Golomb codes are checked against a bit by bit writer.
+ */
+
+#include "header_bits.h"
+#include "header_bits_corpus.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_ELEMENTS_EMPTY     9999
+#define TEST_HEADER_WORDS       256
+
+/* Layout of MTX_HEADER_PARAMS */
+typedef struct {
+    IMG_UINT32 Element_Type;
+    IMG_UINT8 Size;
+    IMG_UINT8 Bits;
+} TEST_ELEMENT;
+
+typedef struct {
+    IMG_UINT32 words[TEST_HEADER_WORDS];
+    void *elt_p[HEADER_BITS_MAX_ELEMENTS];
+} TEST_HEADER;
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            fprintf(stderr, "%s:%d: %s failed\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+static void header_init(TEST_HEADER *header)
+{
+    memset(header->words, 0xcd, sizeof(header->words));
+    header->words[0] = TEST_ELEMENTS_EMPTY;
+    header->elt_p[0] = &header->words[1];
+}
+
+/* As the insert_element_token of the writers */
+static void header_insert_token(TEST_HEADER *header, IMG_UINT32 raw_type, IMG_UINT32 token)
+{
+    IMG_UINT32 *elements = &header->words[0];
+    TEST_ELEMENT *elt;
+
+    if (*elements != TEST_ELEMENTS_EMPTY) {
+        IMG_UINT32 offset = 4;
+
+        if (*elements >= HEADER_BITS_MAX_ELEMENTS - 1)
+            return;
+        elt = (TEST_ELEMENT *) header->elt_p[*elements];
+        if (elt->Element_Type <= raw_type)
+            offset = (elt->Size + 8 + 31) / 32 * 4 + 4;
+        (*elements)++;
+        header->elt_p[*elements] = (IMG_UINT8 *) elt + offset;
+    } else {
+        *elements = 0;
+    }
+    elt = (TEST_ELEMENT *) header->elt_p[*elements];
+    elt->Element_Type = token;
+    elt->Size = 0;
+}
+
+static HEADER_BITS_FIELD header_field(const HEADER_OP *op)
+{
+    switch (op->type) {
+    case OP_UE:
+        return header_bits_ue((IMG_UINT32) op->value);
+    case OP_SE:
+        return header_bits_se(op->value);
+    default:
+        return header_bits_u((IMG_UINT32) op->value, (IMG_UINT8) op->bits);
+    }
+}
+
+static void build_golden(TEST_HEADER *header, const GOLDEN_HEADER *golden, int batch)
+{
+    HEADER_BITS_FIELD fields[64];
+    IMG_UINT32 count = 0;
+    IMG_UINT32 i;
+
+    header_init(header);
+    for (i = 0; i < golden->op_count; i++) {
+        const HEADER_OP *op = &golden->ops[i];
+        IMG_INT32 ret = 0;
+
+        if (op->type == OP_TOKEN) {
+            if (count)
+                ret = header_bits_write_fields(&header->words[0], header->elt_p, golden->raw_type,
+                                               fields, count);
+            count = 0;
+            header_insert_token(header, golden->raw_type, (IMG_UINT32) op->value);
+        } else if (batch) {
+            fields[count++] = header_field(op);
+            if (count == sizeof(fields) / sizeof(fields[0])) {
+                ret = header_bits_write_fields(&header->words[0], header->elt_p, golden->raw_type,
+                                               fields, count);
+                count = 0;
+            }
+        } else if (op->type == OP_UE) {
+            ret = header_bits_write_ue(&header->words[0], header->elt_p, golden->raw_type,
+                                       (IMG_UINT32) op->value);
+        } else if (op->type == OP_SE) {
+            ret = header_bits_write_se(&header->words[0], header->elt_p, golden->raw_type, op->value);
+        } else {
+            ret = header_bits_write(&header->words[0], header->elt_p, golden->raw_type,
+                                    (IMG_UINT32) op->value, op->bits);
+        }
+        CHECK(ret == 0);
+    }
+    if (count)
+        CHECK(0 == header_bits_write_fields(&header->words[0], header->elt_p, golden->raw_type,
+                                            fields, count));
+    /* Has been used as an index */
+    header->words[0]++;
+}
+
+static void test_golden_headers(int batch)
+{
+    TEST_HEADER header;
+    IMG_UINT32 i;
+
+    for (i = 0; i < sizeof(asGoldenHeaders) / sizeof(asGoldenHeaders[0]); i++) {
+        const GOLDEN_HEADER *golden = &asGoldenHeaders[i];
+        const IMG_UINT8 *bytes = (const IMG_UINT8 *) header.words;
+
+        build_golden(&header, golden, batch);
+        if (memcmp(bytes, golden->bytes, golden->byte_count) ||
+            bytes[golden->byte_count] != 0xcd) {
+            fprintf(stderr, "%s%s differs from the former writer\n", golden->name,
+                    batch ? " (fields)" : "");
+            failures++;
+        }
+    }
+}
+
+/* Bit by bit reference, on a plain bit string */
+static void reference_put(IMG_UINT8 *bits, IMG_UINT32 *pos, IMG_UINT64 value, IMG_UINT32 count)
+{
+    while (count--) {
+        if ((value >> count) & 1)
+            bits[*pos / 8] |= 0x80 >> (*pos % 8);
+        (*pos)++;
+    }
+}
+
+static void reference_put_ue(IMG_UINT8 *bits, IMG_UINT32 *pos, IMG_UINT32 value)
+{
+    IMG_UINT64 code = (IMG_UINT64) value + 1;
+    IMG_UINT32 zeros = 0;
+
+    while ((code >> (zeros + 1)) != 0)
+        zeros++;
+    reference_put(bits, pos, 0, zeros);
+    reference_put(bits, pos, code, zeros + 1);
+}
+
+/* Copies the raw bits of the elements of a header without tokens */
+static IMG_UINT32 header_raw_bits(TEST_HEADER *header, IMG_UINT8 *bits)
+{
+    IMG_UINT32 pos = 0;
+    IMG_UINT32 i, j;
+
+    for (i = 0; i < header->words[0]; i++) {
+        TEST_ELEMENT *elt = (TEST_ELEMENT *) header->elt_p[i];
+        const IMG_UINT8 *src = &elt->Bits;
+
+        for (j = 0; j < elt->Size; j++)
+            reference_put(bits, &pos, (src[j / 8] >> (7 - j % 8)) & 1, 1);
+    }
+    return pos;
+}
+
+static IMG_UINT32 test_value(IMG_UINT32 *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    /* Small values mostly, as in the headers, and some of any length */
+    return (*seed >> 8) >> ((*seed >> 3) % 24 + 8 * ((*seed & 7) == 0 ? 0 : 1));
+}
+
+static void test_exp_golomb_codes(void)
+{
+    static const IMG_UINT32 edges[] = {
+        0, 1, 2, 3, 6, 7, 14, 254, 255, 256, 65534, 65535, 65536,
+        0x7FFFFFFE, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFE, 0xFFFFFFFF
+    };
+    IMG_UINT32 seed = 1;
+    IMG_UINT32 round;
+
+    for (round = 0; round < 2000; round++) {
+        TEST_HEADER header;
+        HEADER_BITS_FIELD fields[24];
+        IMG_UINT8 expected[HEADER_BITS_MAX_ELEMENTS * HEADER_BITS_ELEMENT_BITS / 8];
+        IMG_UINT8 written[sizeof(expected)];
+        IMG_UINT32 pos = 0;
+        IMG_UINT32 i, count = 0;
+        int batch = round & 1;
+
+        memset(expected, 0, sizeof(expected));
+        memset(written, 0, sizeof(written));
+        header_init(&header);
+        header_insert_token(&header, 1, 0);
+
+        for (i = 0; i < 24 && pos < 800; i++) {
+            IMG_UINT32 kind = (seed >> 4) % 3;
+            IMG_UINT32 value = round < sizeof(edges) / sizeof(edges[0]) && i == 0 ?
+                               edges[round] : test_value(&seed);
+
+            if (kind == 0) {
+                IMG_UINT32 bits = value % 33;
+
+                value = test_value(&seed);
+                reference_put(expected, &pos, bits < 32 ? value & ((1u << bits) - 1) : value, bits);
+                fields[count++] = header_bits_u(value, (IMG_UINT8) bits);
+                if (!batch)
+                    CHECK(0 == header_bits_write(&header.words[0], header.elt_p, 1, value, bits));
+            } else if (kind == 1) {
+                reference_put_ue(expected, &pos, value);
+                fields[count++] = header_bits_ue(value);
+                if (!batch)
+                    CHECK(0 == header_bits_write_ue(&header.words[0], header.elt_p, 1, value));
+            } else {
+                IMG_INT32 signed_value = (IMG_INT32) value;
+
+                reference_put_ue(expected, &pos, signed_value > 0 ? (IMG_UINT32) signed_value * 2 - 1 :
+                                 0 - (IMG_UINT32) signed_value * 2);
+                fields[count++] = header_bits_se(signed_value);
+                if (!batch)
+                    CHECK(0 == header_bits_write_se(&header.words[0], header.elt_p, 1, signed_value));
+            }
+        }
+        if (batch)
+            CHECK(0 == header_bits_write_fields(&header.words[0], header.elt_p, 1, fields, count));
+        header.words[0]++;
+
+        CHECK(pos == header_raw_bits(&header, written));
+        CHECK(0 == memcmp(expected, written, sizeof(expected)));
+        /* Raw elements are split every 120 bits */
+        CHECK(header.words[0] == (pos ? (pos - 1) / HEADER_BITS_ELEMENT_BITS + 1 : 1));
+    }
+}
+
+static void test_elements_overflow(void)
+{
+    TEST_HEADER header;
+    const IMG_UINT8 *bytes = (const IMG_UINT8 *) header.words;
+    /* The last element ends 16 elements of 4 + 1 + 15 bytes after the count */
+    IMG_UINT32 end = 4 + HEADER_BITS_MAX_ELEMENTS * (5 + HEADER_BITS_ELEMENT_BITS / 8);
+    IMG_UINT32 i;
+
+    header_init(&header);
+    header_insert_token(&header, 1, 0);
+    for (i = 0; i < HEADER_BITS_MAX_ELEMENTS * HEADER_BITS_ELEMENT_BITS / 32; i++)
+        CHECK(0 == header_bits_write(&header.words[0], header.elt_p, 1, 0xFFFFFFFF, 32));
+
+    CHECK(-1 == header_bits_write(&header.words[0], header.elt_p, 1, 1, 1));
+    CHECK(-1 == header_bits_write_ue(&header.words[0], header.elt_p, 1, 5));
+    CHECK(header.words[0] == HEADER_BITS_MAX_ELEMENTS);
+    for (i = end; i < sizeof(header.words); i++)
+        CHECK(bytes[i] == 0xcd);
+}
+
+int main(void)
+{
+    test_golden_headers(0);
+    test_golden_headers(1);
+    test_exp_golomb_codes();
+    test_elements_overflow();
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("header bits tests passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Host benchmark of the object heap against the former heap, which allocated
+ * each object on its own and scanned every slot when iterating.
+ *
+ * Usage: object_heap_benchmark [objects] [rounds]
+ */
+
+#include "object_heap.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_ID_OFFSET     0x03000000
+#define LEGACY_ALLOCATED    -2
+
+/* Large as a surface object, so that objects do not share cache lines */
+struct object_bench_s {
+    struct object_base_s base;
+    int payload[62];
+};
+
+/*
+ * Former heap: one calloc per object, unchecked lookup, iterating all slots.
+ * Not inlined, as the heap functions are called from other files.
+ */
+struct legacy_heap_s {
+    int object_size;
+    int id_offset;
+    object_base_p *heap_index;
+    int next_free;
+    int heap_size;
+};
+
+__attribute__((noinline)) static void legacy_expand(struct legacy_heap_s *heap)
+{
+    int i;
+    int new_heap_size = heap->heap_size + 16;
+
+    heap->heap_index = (object_base_p *) realloc(heap->heap_index, new_heap_size * sizeof(object_base_p));
+    for (i = new_heap_size; i-- > heap->heap_size;) {
+        object_base_p obj = (object_base_p) calloc(1, heap->object_size);
+        heap->heap_index[i] = obj;
+        obj->id = i + heap->id_offset;
+        obj->next_free = heap->next_free;
+        heap->next_free = i;
+    }
+    heap->heap_size = new_heap_size;
+}
+
+__attribute__((noinline)) static int legacy_allocate(struct legacy_heap_s *heap)
+{
+    object_base_p obj;
+    if (-1 == heap->next_free) {
+        legacy_expand(heap);
+    }
+    obj = heap->heap_index[heap->next_free];
+    heap->next_free = obj->next_free;
+    obj->next_free = LEGACY_ALLOCATED;
+    return obj->id;
+}
+
+__attribute__((noinline)) static object_base_p legacy_lookup(struct legacy_heap_s *heap, int id)
+{
+    if ((id < heap->id_offset) || (id > (heap->heap_size + heap->id_offset))) {
+        return NULL;
+    }
+    return heap->heap_index[id & OBJECT_HEAP_ID_MASK];
+}
+
+__attribute__((noinline)) static object_base_p legacy_next(struct legacy_heap_s *heap, int *iter)
+{
+    int i;
+    for (i = *iter + 1; i < heap->heap_size; i++) {
+        if (heap->heap_index[i]->next_free == LEGACY_ALLOCATED) {
+            *iter = i;
+            return heap->heap_index[i];
+        }
+    }
+    *iter = i;
+    return NULL;
+}
+
+__attribute__((noinline)) static void legacy_free(struct legacy_heap_s *heap, object_base_p obj)
+{
+    obj->next_free = heap->next_free;
+    heap->next_free = obj->id & OBJECT_HEAP_ID_MASK;
+}
+
+static void legacy_destroy(struct legacy_heap_s *heap)
+{
+    int i;
+    for (i = 0; i < heap->heap_size; i++) {
+        free(heap->heap_index[i]);
+    }
+    free(heap->heap_index);
+}
+
+static double now_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+static void report(const char *name, double heap_ms, double legacy_ms)
+{
+    printf("%-28s %9.2f ms %9.2f ms  x%.1f\n", name, heap_ms, legacy_ms,
+           heap_ms > 0 ? legacy_ms / heap_ms : 0);
+}
+
+int main(int argc, char **argv)
+{
+    int objects = argc > 1 ? atoi(argv[1]) : 4096;
+    int rounds = argc > 2 ? atoi(argv[2]) : 200;
+    struct object_heap_s heap;
+    struct legacy_heap_s legacy = { sizeof(struct object_bench_s), BENCH_ID_OFFSET, NULL, -1, 0 };
+    int *ids = (int *) malloc(objects * sizeof(int));
+    int *legacy_ids = (int *) malloc(objects * sizeof(int));
+    object_heap_iterator iter;
+    object_base_p obj;
+    long checksum = 0;
+    double start, heap_ms, legacy_ms;
+    int i, r;
+
+    if (objects <= 0 || objects > OBJECT_HEAP_MAX_OBJECTS || rounds <= 0 || !ids || !legacy_ids) {
+        fprintf(stderr, "usage: %s [objects <= %d] [rounds]\n", argv[0], OBJECT_HEAP_MAX_OBJECTS);
+        return EXIT_FAILURE;
+    }
+    printf("%d objects, %d rounds            slab heap  former heap\n", objects, rounds);
+
+    /* Growing the heap from empty */
+    start = now_ms();
+    object_heap_init(&heap, sizeof(struct object_bench_s), BENCH_ID_OFFSET);
+    for (i = 0; i < objects; i++) {
+        ids[i] = object_heap_allocate(&heap);
+    }
+    heap_ms = now_ms() - start;
+    start = now_ms();
+    legacy_expand(&legacy);
+    for (i = 0; i < objects; i++) {
+        legacy_ids[i] = legacy_allocate(&legacy);
+    }
+    legacy_ms = now_ms() - start;
+    report("allocate", heap_ms, legacy_ms);
+
+    /* Looking up each object, checked against stale IDs or not */
+    start = now_ms();
+    for (r = 0; r < rounds; r++) {
+        for (i = 0; i < objects; i++) {
+            checksum += ((struct object_bench_s *) object_heap_lookup(&heap, ids[i]))->payload[0];
+        }
+    }
+    heap_ms = now_ms() - start;
+    start = now_ms();
+    for (r = 0; r < rounds; r++) {
+        for (i = 0; i < objects; i++) {
+            checksum += ((struct object_bench_s *) legacy_lookup(&legacy, legacy_ids[i]))->payload[0];
+        }
+    }
+    legacy_ms = now_ms() - start;
+    report("lookup", heap_ms, legacy_ms);
+
+    /* Iterating a heap where one object out of 64 is still allocated */
+    for (i = 0; i < objects; i++) {
+        if (i % 64) {
+            object_heap_free(&heap, object_heap_lookup(&heap, ids[i]));
+            legacy_free(&legacy, legacy_lookup(&legacy, legacy_ids[i]));
+        }
+    }
+    start = now_ms();
+    for (r = 0; r < rounds; r++) {
+        for (obj = object_heap_first(&heap, &iter); obj; obj = object_heap_next(&heap, &iter)) {
+            checksum += obj->id;
+        }
+    }
+    heap_ms = now_ms() - start;
+    start = now_ms();
+    for (r = 0; r < rounds; r++) {
+        iter = -1;
+        for (obj = legacy_next(&legacy, &iter); obj; obj = legacy_next(&legacy, &iter)) {
+            checksum += obj->id;
+        }
+    }
+    legacy_ms = now_ms() - start;
+    report("iterate sparse heap", heap_ms, legacy_ms);
+
+    /* Destroying and creating objects, as buffers of each frame */
+    start = now_ms();
+    for (r = 0; r < rounds; r++) {
+        for (i = 1; i < objects; i += 64) {
+            ids[i] = object_heap_allocate(&heap);
+        }
+        for (i = 1; i < objects; i += 64) {
+            object_heap_free(&heap, object_heap_lookup(&heap, ids[i]));
+        }
+    }
+    heap_ms = now_ms() - start;
+    start = now_ms();
+    for (r = 0; r < rounds; r++) {
+        for (i = 1; i < objects; i += 64) {
+            legacy_ids[i] = legacy_allocate(&legacy);
+        }
+        for (i = 1; i < objects; i += 64) {
+            legacy_free(&legacy, legacy_lookup(&legacy, legacy_ids[i]));
+        }
+    }
+    legacy_ms = now_ms() - start;
+    report("allocate and free", heap_ms, legacy_ms);
+
+    for (i = 0; i < objects; i += 64) {
+        object_heap_free(&heap, object_heap_lookup(&heap, ids[i]));
+    }
+    object_heap_destroy(&heap);
+    legacy_destroy(&legacy);
+    free(ids);
+    free(legacy_ids);
+
+    /* Keeps the loops from being optimized out */
+    return checksum == 42 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
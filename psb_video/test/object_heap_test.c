@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2014 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Host tests of the object heap: IDs of freed objects must not look up the
+ * object allocated again in their slot, and iterating must only visit the
+ * allocated and suspended objects.
+ */
+
+#include "object_heap.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TEST_ID_OFFSET  0x04000000
+
+struct object_test_s {
+    struct object_base_s base;
+    int value;
+};
+
+typedef struct object_test_s *object_test_p;
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            fprintf(stderr, "%s:%d: %s failed\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+#define LOOKUP(heap, id)    ((object_test_p) object_heap_lookup(heap, id))
+
+static void test_lookup_allocated(void)
+{
+    struct object_heap_s heap;
+    int id;
+
+    CHECK(0 == object_heap_init(&heap, sizeof(struct object_test_s), TEST_ID_OFFSET));
+    id = object_heap_allocate(&heap);
+    CHECK(id != -1);
+    CHECK((id & OBJECT_HEAP_OFFSET_MASK) == TEST_ID_OFFSET);
+    CHECK(NULL != LOOKUP(&heap, id));
+    CHECK(id == LOOKUP(&heap, id)->base.id);
+
+    object_heap_free(&heap, object_heap_lookup(&heap, id));
+    object_heap_destroy(&heap);
+}
+
+static void test_lookup_invalid_ids(void)
+{
+    struct object_heap_s heap;
+    int id;
+
+    CHECK(0 == object_heap_init(&heap, sizeof(struct object_test_s), TEST_ID_OFFSET));
+    id = object_heap_allocate(&heap);
+
+    /* Other heap, out of range slot, never allocated slot, VA_INVALID_ID */
+    CHECK(NULL == LOOKUP(&heap, (id & OBJECT_HEAP_ID_MASK) | 0x03000000));
+    CHECK(NULL == LOOKUP(&heap, TEST_ID_OFFSET | heap.heap_size));
+    CHECK(NULL == LOOKUP(&heap, TEST_ID_OFFSET | OBJECT_HEAP_INDEX_MASK));
+    CHECK(NULL == LOOKUP(&heap, id + 1));
+    CHECK(NULL == LOOKUP(&heap, -1));
+    CHECK(NULL == LOOKUP(&heap, 0));
+
+    object_heap_free(&heap, object_heap_lookup(&heap, id));
+    object_heap_destroy(&heap);
+}
+
+static void test_stale_id_after_free(void)
+{
+    struct object_heap_s heap;
+    int stale_id, id;
+
+    CHECK(0 == object_heap_init(&heap, sizeof(struct object_test_s), TEST_ID_OFFSET));
+    stale_id = object_heap_allocate(&heap);
+    object_heap_free(&heap, object_heap_lookup(&heap, stale_id));
+    CHECK(NULL == LOOKUP(&heap, stale_id));
+
+    /* The slot is reused at once, under another generation */
+    id = object_heap_allocate(&heap);
+    CHECK((id & OBJECT_HEAP_INDEX_MASK) == (stale_id & OBJECT_HEAP_INDEX_MASK));
+    CHECK(id != stale_id);
+    CHECK(NULL != LOOKUP(&heap, id));
+    CHECK(NULL == LOOKUP(&heap, stale_id));
+
+    object_heap_free(&heap, object_heap_lookup(&heap, id));
+    object_heap_destroy(&heap);
+}
+
+static void test_generation_wraps(void)
+{
+    struct object_heap_s heap;
+    int first_id, id, i;
+    int generations = (OBJECT_HEAP_GENERATION_MASK >> OBJECT_HEAP_INDEX_BITS) + 1;
+
+    CHECK(0 == object_heap_init(&heap, sizeof(struct object_test_s), TEST_ID_OFFSET));
+    first_id = object_heap_allocate(&heap);
+    id = first_id;
+    for (i = 1; i < generations; i++) {
+        object_heap_free(&heap, object_heap_lookup(&heap, id));
+        id = object_heap_allocate(&heap);
+        CHECK(id != first_id);
+        CHECK((id & OBJECT_HEAP_OFFSET_MASK) == TEST_ID_OFFSET);
+    }
+    /* The generation only wraps after all of them were used */
+    object_heap_free(&heap, object_heap_lookup(&heap, id));
+    id = object_heap_allocate(&heap);
+    CHECK(id == first_id);
+
+    object_heap_free(&heap, object_heap_lookup(&heap, id));
+    object_heap_destroy(&heap);
+}
+
+static void test_suspended_not_looked_up(void)
+{
+    struct object_heap_s heap;
+    object_heap_iterator iter;
+    object_base_p obj;
+    int id;
+
+    CHECK(0 == object_heap_init(&heap, sizeof(struct object_test_s), TEST_ID_OFFSET));
+    id = object_heap_allocate(&heap);
+    obj = object_heap_lookup(&heap, id);
+
+    object_heap_suspend_object(obj, 1);
+    CHECK(NULL == LOOKUP(&heap, id));
+    /* Still iterated, so that it is destroyed with its heap */
+    CHECK(obj == object_heap_first(&heap, &iter));
+
+    /* A suspended object is made valid again with the same ID */
+    object_heap_suspend_object(obj, 0);
+    CHECK(obj == object_heap_lookup(&heap, id));
+
+    object_heap_free(&heap, obj);
+    object_heap_destroy(&heap);
+}
+
+static void test_objects_kept_on_expand(void)
+{
+    struct object_heap_s heap;
+    int ids[1000];
+    object_test_p objs[1000];
+    int i;
+
+    CHECK(0 == object_heap_init(&heap, sizeof(struct object_test_s), TEST_ID_OFFSET));
+    for (i = 0; i < 1000; i++) {
+        ids[i] = object_heap_allocate(&heap);
+        objs[i] = LOOKUP(&heap, ids[i]);
+        CHECK(NULL != objs[i]);
+        objs[i]->value = i;
+    }
+    /* Objects do not move while the heap grows */
+    for (i = 0; i < 1000; i++) {
+        CHECK(objs[i] == LOOKUP(&heap, ids[i]));
+        CHECK(i == objs[i]->value);
+    }
+    CHECK(heap.slab_count < 10);
+
+    for (i = 0; i < 1000; i++) {
+        object_heap_free(&heap, (object_base_p) objs[i]);
+    }
+    object_heap_destroy(&heap);
+}
+
+static void test_iterate_live_objects(void)
+{
+    struct object_heap_s heap;
+    object_heap_iterator iter;
+    object_test_p obj;
+    int ids[200];
+    int i, count;
+
+    CHECK(0 == object_heap_init(&heap, sizeof(struct object_test_s), TEST_ID_OFFSET));
+    CHECK(NULL == object_heap_first(&heap, &iter));
+
+    for (i = 0; i < 200; i++) {
+        ids[i] = object_heap_allocate(&heap);
+    }
+    /* Keep every seventh object, and the last one */
+    for (i = 0; i < 200; i++) {
+        if ((i % 7) && (i != 199)) {
+            object_heap_free(&heap, object_heap_lookup(&heap, ids[i]));
+        }
+    }
+    count = 0;
+    obj = (object_test_p) object_heap_first(&heap, &iter);
+    while (obj) {
+        CHECK(obj == LOOKUP(&heap, obj->base.id));
+        CHECK(((obj->base.id & OBJECT_HEAP_INDEX_MASK) % 7 == 0) ||
+              (obj->base.id == ids[199]));
+        count++;
+        obj = (object_test_p) object_heap_next(&heap, &iter);
+    }
+    CHECK(count == 200 / 7 + 2);
+    /* Iterating past the end keeps returning NULL */
+    CHECK(NULL == object_heap_next(&heap, &iter));
+
+    obj = (object_test_p) object_heap_first(&heap, &iter);
+    while (obj) {
+        object_heap_free(&heap, (object_base_p) obj);
+        obj = (object_test_p) object_heap_next(&heap, &iter);
+    }
+    CHECK(NULL == object_heap_first(&heap, &iter));
+    object_heap_destroy(&heap);
+}
+
+static void test_heap_full(void)
+{
+    struct object_heap_s heap;
+    int i, id = 0;
+
+    CHECK(0 == object_heap_init(&heap, sizeof(struct object_base_s), TEST_ID_OFFSET));
+    for (i = 0; i < OBJECT_HEAP_MAX_OBJECTS; i++) {
+        id = object_heap_allocate(&heap);
+        if (-1 == id) {
+            break;
+        }
+    }
+    CHECK(i == OBJECT_HEAP_MAX_OBJECTS);
+    CHECK(-1 == object_heap_allocate(&heap));
+
+    /* A freed slot is allocated again */
+    object_heap_free(&heap, object_heap_lookup(&heap, id));
+    CHECK(-1 != object_heap_allocate(&heap));
+
+    for (i = 0; i < heap.heap_size; i++) {
+        object_heap_free(&heap, heap.heap_index[i]);
+    }
+    object_heap_destroy(&heap);
+}
+
+int main(void)
+{
+    test_lookup_allocated();
+    test_lookup_invalid_ids();
+    test_stale_id_after_free();
+    test_generation_wraps();
+    test_suspended_not_looked_up();
+    test_objects_kept_on_expand();
+    test_iterate_live_objects();
+    test_heap_full();
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("object heap tests passed\n");
+    return EXIT_SUCCESS;
+}
@@ -48,4 +48,7 @@ COMPONENT_SUPPORT_OPENCORE := false
 # utility
 -include $(WRS_OMXIL_CORE_ROOT)/utils/src/Android.mk
 
+# test
+-include $(WRS_OMXIL_CORE_ROOT)/test/Android.mk
+
 endif
@@ -64,6 +64,12 @@ class CModule {
     /* component name and roles */
     const OMX_STRING GetComponentName(void);
     OMX_ERRORTYPE GetComponentRoles(OMX_U32 *nr_roles, OMX_U8 **roles);
+    const OMX_STRING GetComponentRole(OMX_U32 index);
+
+    /* fill name and roles without loading, e.g. from the manifest */
+    OMX_ERRORTYPE SetComponentNameAndRoles(const OMX_STRING name,
+                                           OMX_U32 nr_roles,
+                                           const OMX_U8 **roles);
 
     bool QueryHavingThisRole(const OMX_STRING role);
 
@@ -71,6 +77,7 @@ class CModule {
 
     /* library symbol method and helpers */
     OMX_ERRORTYPE QueryComponentNameAndRoles(void);
+    OMX_ERRORTYPE QueryLibraryPath(OMX_STRING path, OMX_U32 len);
     OMX_ERRORTYPE InstantiateComponent(ComponentBase **instance);
 
     /* end of library symbol method and helpers */
@@ -173,64 +173,32 @@ bool CModule::QueryHavingThisRole(const OMX_STRING role)
     return false;
 }
 
-/* end of accessor */
-
-/*
- * library symbol method and helpers
- */
-OMX_ERRORTYPE CModule::InstantiateComponent(ComponentBase **instance)
+const OMX_STRING CModule::GetComponentRole(OMX_U32 index)
 {
-    ComponentBase *cbase;
-    OMX_ERRORTYPE ret;
-
-    if (!instance)
-        return OMX_ErrorBadParameter;
-    *instance = NULL;
-
-    if (!wrs_omxil_cmodule)
-        return OMX_ErrorUndefined;
-
-    ret = wrs_omxil_cmodule->ops->instantiate((void **)&cbase);
-    if (ret != OMX_ErrorNone) {
-        LOGE("%s failed to instantiate()\n", lname);
-        return ret;
-    }
-
-    cbase->SetCModule(this);
-    cbase->SetName(cname);
-    ret = cbase->SetRolesOfComponent(nr_roles, (const OMX_U8 **)roles);
-    if (ret != OMX_ErrorNone) {
-        delete cbase;
-        return ret;
-    }
+    if (!roles || index >= nr_roles)
+        return NULL;
 
-    *instance = cbase;
-    return OMX_ErrorNone;
+    return (OMX_STRING)&roles[index][0];
 }
 
-OMX_ERRORTYPE CModule::QueryComponentNameAndRoles(void)
+OMX_ERRORTYPE CModule::SetComponentNameAndRoles(const OMX_STRING name,
+                                                OMX_U32 nr_roles,
+                                                const OMX_U8 **roles)
 {
-    const char *name;
     OMX_U32 name_len;
     OMX_U32 copy_name_len;
 
-    const OMX_U8 **roles;
-    OMX_U32 nr_roles;
     OMX_U32 role_len;
     OMX_U32 copy_role_len;
     OMX_U8 **this_roles;
 
     OMX_U32 i;
-    OMX_ERRORTYPE ret;
 
     if (this->roles)
         return OMX_ErrorNone;
 
-    if (!wrs_omxil_cmodule)
-        return OMX_ErrorUndefined;
-
-    roles = (const OMX_U8 **)wrs_omxil_cmodule->roles;
-    nr_roles = wrs_omxil_cmodule->nr_roles;
+    if (!name || !roles)
+        return OMX_ErrorBadParameter;
 
     this_roles = (OMX_U8 **)malloc(sizeof(OMX_STRING) * nr_roles);
     if (!this_roles)
@@ -258,7 +226,6 @@ OMX_ERRORTYPE CModule::QueryComponentNameAndRoles(void)
     this->roles = this_roles;
     this->nr_roles = nr_roles;
 
-    name = wrs_omxil_cmodule->name;
     name_len = strlen(name);
     copy_name_len = name_len > OMX_MAX_STRINGNAME_SIZE-1 ?
         OMX_MAX_STRINGNAME_SIZE-1 : name_len;
@@ -269,4 +236,72 @@ OMX_ERRORTYPE CModule::QueryComponentNameAndRoles(void)
     return OMX_ErrorNone;
 }
 
+/* end of accessor */
+
+/*
+ * library symbol method and helpers
+ */
+OMX_ERRORTYPE CModule::InstantiateComponent(ComponentBase **instance)
+{
+    ComponentBase *cbase;
+    OMX_ERRORTYPE ret;
+
+    if (!instance)
+        return OMX_ErrorBadParameter;
+    *instance = NULL;
+
+    if (!wrs_omxil_cmodule)
+        return OMX_ErrorUndefined;
+
+    ret = wrs_omxil_cmodule->ops->instantiate((void **)&cbase);
+    if (ret != OMX_ErrorNone) {
+        LOGE("%s failed to instantiate()\n", lname);
+        return ret;
+    }
+
+    cbase->SetCModule(this);
+    cbase->SetName(cname);
+    ret = cbase->SetRolesOfComponent(nr_roles, (const OMX_U8 **)roles);
+    if (ret != OMX_ErrorNone) {
+        delete cbase;
+        return ret;
+    }
+
+    *instance = cbase;
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE CModule::QueryComponentNameAndRoles(void)
+{
+    if (this->roles)
+        return OMX_ErrorNone;
+
+    if (!wrs_omxil_cmodule)
+        return OMX_ErrorUndefined;
+
+    return SetComponentNameAndRoles((const OMX_STRING)wrs_omxil_cmodule->name,
+                                    wrs_omxil_cmodule->nr_roles,
+                                    (const OMX_U8 **)wrs_omxil_cmodule->roles);
+}
+
+OMX_ERRORTYPE CModule::QueryLibraryPath(OMX_STRING path, OMX_U32 len)
+{
+    Dl_info info;
+
+    if (!path || !len)
+        return OMX_ErrorBadParameter;
+
+    if (!wrs_omxil_cmodule)
+        return OMX_ErrorUndefined;
+
+    /* the file dlopen() resolved lname to */
+    if (!dladdr(wrs_omxil_cmodule, &info) || !info.dli_fname)
+        return OMX_ErrorUndefined;
+
+    strncpy(path, info.dli_fname, len - 1);
+    path[len - 1] = '\0';
+
+    return OMX_ErrorNone;
+}
+
 /* end of library symbol method and helpers */
@@ -66,6 +66,7 @@ CmdProcessWork::~CmdProcessWork()
 
     while ((temp = PopCmdQueue()))
         free(temp);
+    queue_free_all(&q);
 
     pthread_mutex_destroy(&lock);
 
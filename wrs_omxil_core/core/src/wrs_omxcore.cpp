@@ -21,6 +21,8 @@
 #include <string.h>
 
 #include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include <OMX_Core.h>
 #include <OMX_Component.h>
@@ -40,6 +42,264 @@ static unsigned int g_nr_instances = 0;
 static struct list *g_module_list = NULL;
 static pthread_mutex_t g_module_lock = PTHREAD_MUTEX_INITIALIZER;
 
+/*
+ * component index
+ *
+ * g_module_list in an array for OMX_ComponentNameEnum, and hash chains
+ * of the modules by component name and by role, in list order.
+ */
+#define COMPONENT_HASH_SIZE 64 /* power of 2 */
+
+static CModule **g_module_table = NULL;
+static OMX_U32 g_nr_modules = 0;
+
+static struct list *g_name_index[COMPONENT_HASH_SIZE];
+static struct list *g_role_index[COMPONENT_HASH_SIZE];
+
+/*
+ * component manifest
+ *
+ * The name and roles of a component only change with its library, so they
+ * are kept on disk and a library is dlopen()ed at OMX_Init only when its
+ * file is not in the manifest or has changed size or mtime since. One line
+ * per library, after a "wrs_omxil_manifest <version>" header:
+ *
+ *   <library> <path> <size> <mtime> <component name> <nr_roles> <roles...>
+ *
+ * WRS_OMXIL_MANIFEST overrides the manifest path, empty disables it.
+ */
+#define MANIFEST_PATH "/data/misc/media/wrs_omxil_components.manifest"
+#define MANIFEST_PATH_ENV "WRS_OMXIL_MANIFEST"
+#define MANIFEST_MAGIC "wrs_omxil_manifest"
+#define MANIFEST_VERSION 1
+
+#define MANIFEST_PATH_SIZE 256
+#define MANIFEST_MAX_ROLES 64
+
+/* fscanf() widths of OMX_MAX_STRINGNAME_SIZE and MANIFEST_PATH_SIZE */
+#define MANIFEST_NAME_FORMAT "%127s"
+#define MANIFEST_PATH_FORMAT "%255s"
+
+struct manifest_entry {
+    char lname[OMX_MAX_STRINGNAME_SIZE];
+    char path[MANIFEST_PATH_SIZE];
+    long long size;
+    long long mtime;
+
+    char cname[OMX_MAX_STRINGNAME_SIZE];
+    OMX_U32 nr_roles;
+    OMX_U8 **roles; /* follows the entry in the same allocation */
+};
+
+static const char *manifest_path(void)
+{
+    const char *path = getenv(MANIFEST_PATH_ENV);
+
+    if (!path)
+        return MANIFEST_PATH;
+
+    return path[0] ? path : NULL;
+}
+
+static struct manifest_entry *manifest_entry_alloc(OMX_U32 nr_roles)
+{
+    struct manifest_entry *mentry;
+    OMX_U8 *role;
+    OMX_U32 i;
+
+    mentry = (struct manifest_entry *)malloc(sizeof(*mentry) +
+        nr_roles * (sizeof(OMX_U8 *) + OMX_MAX_STRINGNAME_SIZE));
+    if (!mentry)
+        return NULL;
+
+    mentry->nr_roles = nr_roles;
+    mentry->roles = (OMX_U8 **)(mentry + 1);
+
+    role = (OMX_U8 *)(mentry->roles + nr_roles);
+    for (i = 0; i < nr_roles; i++, role += OMX_MAX_STRINGNAME_SIZE)
+        mentry->roles[i] = role;
+
+    return mentry;
+}
+
+static struct manifest_entry *manifest_entry_from_cmodule(CModule *cmodule)
+{
+    struct manifest_entry *mentry;
+    char path[MANIFEST_PATH_SIZE];
+    struct stat st;
+    OMX_U32 nr_roles, i;
+
+    if (cmodule->QueryLibraryPath(path, sizeof(path)) != OMX_ErrorNone)
+        return NULL;
+
+    if (stat(path, &st))
+        return NULL;
+
+    cmodule->GetComponentRoles(&nr_roles, NULL);
+    if (nr_roles > MANIFEST_MAX_ROLES)
+        return NULL;
+
+    mentry = manifest_entry_alloc(nr_roles);
+    if (!mentry)
+        return NULL;
+
+    strcpy(mentry->lname, cmodule->GetLibraryName());
+    strcpy(mentry->path, path);
+    mentry->size = st.st_size;
+    mentry->mtime = st.st_mtime;
+
+    strcpy(mentry->cname, cmodule->GetComponentName());
+    for (i = 0; i < nr_roles; i++)
+        strcpy((OMX_STRING)mentry->roles[i], cmodule->GetComponentRole(i));
+
+    return mentry;
+}
+
+static struct list *read_manifest(const char *manifest_file)
+{
+    FILE *file;
+    char magic[OMX_MAX_STRINGNAME_SIZE];
+    int version;
+    struct list *head = NULL;
+
+    file = fopen(manifest_file, "r");
+    if (!file) {
+        LOGV("no manifest %s\n", manifest_file);
+        return NULL;
+    }
+
+    if (fscanf(file, MANIFEST_NAME_FORMAT " %d", magic, &version) != 2 ||
+        strcmp(magic, MANIFEST_MAGIC) || version != MANIFEST_VERSION) {
+        LOGI("ignore manifest %s of another version\n", manifest_file);
+        fclose(file);
+        return NULL;
+    }
+
+    while (1) {
+        struct manifest_entry header, *mentry;
+        struct list *entry;
+        unsigned int nr_roles, i;
+
+        if (fscanf(file, MANIFEST_NAME_FORMAT " " MANIFEST_PATH_FORMAT
+                   " %lld %lld " MANIFEST_NAME_FORMAT " %u",
+                   header.lname, header.path, &header.size, &header.mtime,
+                   header.cname, &nr_roles) != 6)
+            break;
+
+        if (nr_roles > MANIFEST_MAX_ROLES)
+            break;
+
+        mentry = manifest_entry_alloc(nr_roles);
+        if (!mentry)
+            break;
+
+        strcpy(mentry->lname, header.lname);
+        strcpy(mentry->path, header.path);
+        mentry->size = header.size;
+        mentry->mtime = header.mtime;
+        strcpy(mentry->cname, header.cname);
+
+        for (i = 0; i < nr_roles; i++) {
+            if (fscanf(file, MANIFEST_NAME_FORMAT,
+                       (OMX_STRING)mentry->roles[i]) != 1)
+                break;
+        }
+
+        entry = i == nr_roles ? list_alloc(mentry) : NULL;
+        if (!entry) {
+            free(mentry);
+            break;
+        }
+        head = __list_add_tail(head, entry);
+    }
+
+    fclose(file);
+    return head;
+}
+
+static void write_manifest(const char *manifest_file, struct list *head)
+{
+    FILE *file;
+    char tmp_file[MANIFEST_PATH_SIZE + 16];
+    struct list *entry;
+    int ret;
+
+    /* written aside and renamed, readers never see a partial manifest */
+    snprintf(tmp_file, sizeof(tmp_file), "%s.%d", manifest_file, getpid());
+    file = fopen(tmp_file, "w");
+    if (!file) {
+        LOGV("cannot write manifest %s\n", manifest_file);
+        return;
+    }
+
+    fprintf(file, "%s %d\n", MANIFEST_MAGIC, MANIFEST_VERSION);
+    list_foreach(head, entry) {
+        struct manifest_entry *mentry =
+            static_cast<struct manifest_entry *>(entry->data);
+        OMX_U32 i;
+
+        fprintf(file, "%s %s %lld %lld %s %lu", mentry->lname, mentry->path,
+                mentry->size, mentry->mtime, mentry->cname,
+                (unsigned long)mentry->nr_roles);
+        for (i = 0; i < mentry->nr_roles; i++)
+            fprintf(file, " %s", (OMX_STRING)mentry->roles[i]);
+        fprintf(file, "\n");
+    }
+
+    ret = fclose(file);
+    if (!ret)
+        ret = rename(tmp_file, manifest_file);
+    if (ret) {
+        LOGE("failed to write manifest %s\n", manifest_file);
+        unlink(tmp_file);
+        return;
+    }
+
+    LOGI("manifest %s updated\n", manifest_file);
+}
+
+/*
+ * takes the entry of lname out of the manifest, NULL if there is none or
+ * its library has changed
+ */
+static struct manifest_entry *lookup_manifest(struct list **head,
+                                              const char *lname)
+{
+    struct list *entry;
+
+    list_foreach(*head, entry) {
+        struct manifest_entry *mentry =
+            static_cast<struct manifest_entry *>(entry->data);
+        struct stat st;
+
+        if (strcmp(mentry->lname, lname))
+            continue;
+
+        *head = __list_delete(*head, entry);
+
+        if (stat(mentry->path, &st) ||
+            st.st_size != mentry->size || st.st_mtime != mentry->mtime) {
+            LOGI("library %s changed since manifest\n", lname);
+            free(mentry);
+            return NULL;
+        }
+
+        return mentry;
+    }
+
+    return NULL;
+}
+
+static void free_manifest(struct list *head)
+{
+    struct list *entry, *next;
+
+    list_foreach_safe(head, entry, next) {
+        free(entry->data);
+        head = __list_delete(head, entry);
+    }
+}
+
 static struct list *construct_components(const char *config_file_name)
 {
     FILE *config_file;
@@ -47,6 +307,10 @@ static struct list *construct_components(const char *config_file_name)
     char config_file_path[256];
     struct list *head = NULL;
 
+    const char *manifest_file;
+    struct list *cached = NULL, *manifest = NULL;
+    bool manifest_dirty = false;
+
     strncpy(config_file_path, "/etc/", 256);
     strncat(config_file_path, config_file_name, 256);
     config_file = fopen(config_file_path, "r");
@@ -60,9 +324,16 @@ static struct list *construct_components(const char *config_file_name)
         }
     }
 
+    manifest_file = manifest_path();
+    if (manifest_file)
+        cached = read_manifest(manifest_file);
+
     while (fscanf(config_file, "%s", library_name) > 0) {
         CModule *cmodule;
         struct list *entry;
+        struct manifest_entry *mentry;
+        OMX_STRING lname = &library_name[0];
+        bool resident = false, loaded = false;
         OMX_ERRORTYPE ret;
 
         library_name[OMX_MAX_STRINGNAME_SIZE-1] = '\0';
@@ -71,38 +342,85 @@ static struct list *construct_components(const char *config_file_name)
         if (library_name[0] == '#')
             continue;
 
-        cmodule = new CModule(&library_name[0]);
+        /* keep libraries starting with + loaded, for the hot codecs */
+        if (library_name[0] == '+') {
+            resident = true;
+            lname++;
+        }
+
+        cmodule = new CModule(lname);
         if (!cmodule)
             continue;
 
-        LOGI("found component library %s\n", library_name);
+        LOGI("found component library %s\n", lname);
+
+        mentry = lookup_manifest(&cached, lname);
+        if (mentry) {
+            ret = cmodule->SetComponentNameAndRoles(mentry->cname,
+                mentry->nr_roles, (const OMX_U8 **)mentry->roles);
+            if (ret != OMX_ErrorNone)
+                goto delete_cmodule;
+        }
 
-        ret = cmodule->Load(MODULE_LAZY);
-        if (ret != OMX_ErrorNone)
-            goto delete_cmodule;
+        if (!mentry || resident) {
+            ret = cmodule->Load(resident ? MODULE_NOW : MODULE_LAZY);
+            if (ret != OMX_ErrorNone)
+                goto delete_cmodule;
+            loaded = true;
+        }
 
-        ret = cmodule->QueryComponentNameAndRoles();
-        if (ret != OMX_ErrorNone)
-            goto unload_cmodule;
+        if (!mentry) {
+            ret = cmodule->QueryComponentNameAndRoles();
+            if (ret != OMX_ErrorNone)
+                goto unload_cmodule;
+
+            mentry = manifest_entry_from_cmodule(cmodule);
+            manifest_dirty = true;
+        }
 
         entry = list_alloc(cmodule);
         if (!entry)
             goto unload_cmodule;
         head = __list_add_tail(head, entry);
 
-        cmodule->Unload();
-        LOGI("module %s:%s added to component list\n",
-             cmodule->GetLibraryName(), cmodule->GetComponentName());
+        if (mentry) {
+            entry = list_alloc(mentry);
+            if (entry)
+                manifest = __list_add_tail(manifest, entry);
+            else {
+                free(mentry);
+                manifest_dirty = true;
+            }
+        }
+
+        if (loaded && !resident)
+            cmodule->Unload();
+        LOGI("module %s:%s added to component list%s\n",
+             cmodule->GetLibraryName(), cmodule->GetComponentName(),
+             resident ? ", kept resident" : "");
 
         continue;
 
     unload_cmodule:
-        cmodule->Unload();
+        if (loaded)
+            cmodule->Unload();
     delete_cmodule:
+        free(mentry);
         delete cmodule;
     }
 
     fclose(config_file);
+
+    /* entries left over are of libraries no longer listed */
+    if (cached)
+        manifest_dirty = true;
+
+    if (manifest_file && manifest_dirty)
+        write_manifest(manifest_file, manifest);
+
+    free_manifest(cached);
+    free_manifest(manifest);
+
     return head;
 }
 
@@ -120,6 +438,96 @@ static struct list *destruct_components(struct list *head)
     return head;
 }
 
+static unsigned int component_hash(const char *string)
+{
+    unsigned int hash = 2166136261u; /* FNV-1a */
+
+    while (*string) {
+        hash ^= (unsigned char)*string++;
+        hash *= 16777619u;
+    }
+
+    return hash & (COMPONENT_HASH_SIZE - 1);
+}
+
+static void unindex_components(void)
+{
+    int i;
+
+    for (i = 0; i < COMPONENT_HASH_SIZE; i++) {
+        list_free_all(g_name_index[i]);
+        g_name_index[i] = NULL;
+        list_free_all(g_role_index[i]);
+        g_role_index[i] = NULL;
+    }
+
+    free(g_module_table);
+    g_module_table = NULL;
+    g_nr_modules = 0;
+}
+
+static int index_components(struct list *head)
+{
+    struct list *entry, *chain;
+    OMX_U32 nr_modules = 0;
+
+    g_module_table = (CModule **)malloc(sizeof(CModule *) * list_length(head));
+    if (!g_module_table)
+        return -1;
+
+    list_foreach(head, entry) {
+        CModule *cmodule = static_cast<CModule *>(entry->data);
+        OMX_STRING role;
+        OMX_U32 i;
+
+        g_module_table[nr_modules++] = cmodule;
+
+        chain = list_add_tail(g_name_index[
+            component_hash(cmodule->GetComponentName())], cmodule);
+        if (!chain)
+            goto unindex;
+        g_name_index[component_hash(cmodule->GetComponentName())] = chain;
+
+        for (i = 0; (role = cmodule->GetComponentRole(i)); i++) {
+            unsigned int hash = component_hash(role);
+            struct list *last = __list_last(g_role_index[hash]);
+
+            /* once per chain, roles of a module may share it */
+            if (last && last->data == cmodule)
+                continue;
+
+            chain = list_add_tail(g_role_index[hash], cmodule);
+            if (!chain)
+                goto unindex;
+            g_role_index[hash] = chain;
+        }
+    }
+
+    g_nr_modules = nr_modules;
+    return 0;
+
+unindex:
+    unindex_components();
+    return -1;
+}
+
+static CModule *find_component(const OMX_STRING cname)
+{
+    struct list *entry;
+
+    if (!cname)
+        return NULL;
+
+    list_foreach(g_name_index[component_hash(cname)], entry) {
+        CModule *cmodule = static_cast<CModule *>(entry->data);
+
+        if (!strcmp(cname, cmodule->GetComponentName()))
+            return cmodule;
+    }
+
+    return NULL;
+}
+
 OMX_API OMX_ERRORTYPE OMX_APIENTRY OMX_Init(void)
 {
     int ret;
@@ -136,6 +544,14 @@ OMX_API OMX_ERRORTYPE OMX_APIENTRY OMX_Init(void)
             return OMX_ErrorInsufficientResources;
         }
 
+        if (index_components(g_module_list)) {
+            g_module_list = destruct_components(g_module_list);
+            pthread_mutex_unlock(&g_module_lock);
+            LOGE("%s(): exit failure, index_components failed",
+                 __FUNCTION__);
+            return OMX_ErrorInsufficientResources;
+        }
+
         g_initialized = 1;
     }
     pthread_mutex_unlock(&g_module_lock);
@@ -151,8 +567,10 @@ OMX_API OMX_ERRORTYPE OMX_APIENTRY OMX_Deinit(void)
     LOGV("%s(): enter", __FUNCTION__);
 
     pthread_mutex_lock(&g_module_lock);
-    if (!g_nr_instances)
+    if (!g_nr_instances) {
+        unindex_components();
         g_module_list = destruct_components(g_module_list);
+    }
     else
         ret = OMX_ErrorUndefined;
     pthread_mutex_unlock(&g_module_lock);
@@ -169,19 +587,16 @@ OMX_API OMX_ERRORTYPE OMX_APIENTRY OMX_ComponentNameEnum(
     OMX_IN OMX_U32 nIndex)
 {
     CModule *cmodule;
-    ComponentBase *cbase;
-    struct list *entry;
     OMX_STRING cname;
 
     pthread_mutex_lock(&g_module_lock);
-    entry = __list_entry(g_module_list, nIndex);
-    if (!entry) {
+    if (nIndex >= g_nr_modules) {
         pthread_mutex_unlock(&g_module_lock);
         return OMX_ErrorNoMore;
     }
+    cmodule = g_module_table[nIndex];
     pthread_mutex_unlock(&g_module_lock);
 
-    cmodule = static_cast<CModule *>(entry->data);
     cname = cmodule->GetComponentName();
 
     strncpy(cComponentName, cname, nNameLength);
@@ -196,67 +611,59 @@ OMX_API OMX_ERRORTYPE OMX_APIENTRY OMX_GetHandle(
     OMX_IN OMX_PTR pAppData,
     OMX_IN OMX_CALLBACKTYPE *pCallBacks)
 {
-    struct list *entry;
+    CModule *cmodule;
+    ComponentBase *cbase = NULL;
     OMX_ERRORTYPE ret;
 
     LOGV("%s(): enter, try to get %s", __FUNCTION__, cComponentName);
 
     pthread_mutex_lock(&g_module_lock);
-    list_foreach(g_module_list, entry) {
-        CModule *cmodule;
-        OMX_STRING cname;
-
-        cmodule = static_cast<CModule *>(entry->data);
-
-        cname = cmodule->GetComponentName();
-        if (!strcmp(cComponentName, cname)) {
-            ComponentBase *cbase = NULL;
+    cmodule = find_component(cComponentName);
+    if (!cmodule) {
+        pthread_mutex_unlock(&g_module_lock);
 
-            ret = cmodule->Load(MODULE_NOW);
-            if (ret != OMX_ErrorNone) {
-                LOGE("%s(): exit failure, cmodule->Load failed\n",
-                     __FUNCTION__);
-                goto unlock_list;
-            }
+        LOGE("%s(): exit failure, %s not found", __FUNCTION__,
+             cComponentName);
+        return OMX_ErrorInvalidComponent;
+    }
 
-            ret = cmodule->InstantiateComponent(&cbase);
-            if (ret != OMX_ErrorNone){
-                LOGE("%s(): exit failure, cmodule->Instantiate failed\n",
-                     __FUNCTION__);
-                goto unload_cmodule;
-            }
+    ret = cmodule->Load(MODULE_NOW);
+    if (ret != OMX_ErrorNone) {
+        LOGE("%s(): exit failure, cmodule->Load failed\n", __FUNCTION__);
+        goto unlock_list;
+    }
 
-            ret = cbase->GetHandle(pHandle, pAppData, pCallBacks);
-            if (ret != OMX_ErrorNone) {
-                LOGE("%s(): exit failure, cbase->GetHandle failed\n",
-                     __FUNCTION__);
-                goto delete_cbase;
-            }
+    ret = cmodule->InstantiateComponent(&cbase);
+    if (ret != OMX_ErrorNone){
+        LOGE("%s(): exit failure, cmodule->Instantiate failed\n",
+             __FUNCTION__);
+        goto unload_cmodule;
+    }
 
-            cbase->SetCModule(cmodule);
+    ret = cbase->GetHandle(pHandle, pAppData, pCallBacks);
+    if (ret != OMX_ErrorNone) {
+        LOGE("%s(): exit failure, cbase->GetHandle failed\n", __FUNCTION__);
+        goto delete_cbase;
+    }
 
-            g_nr_instances++;
-            pthread_mutex_unlock(&g_module_lock);
+    cbase->SetCModule(cmodule);
 
-            LOGI("get handle of component %s successfully", cComponentName);
-            LOGV("%s(): exit done\n", __FUNCTION__);
-            return OMX_ErrorNone;
+    g_nr_instances++;
+    pthread_mutex_unlock(&g_module_lock);
 
-        delete_cbase:
-            delete cbase;
-        unload_cmodule:
-            cmodule->Unload();
-        unlock_list:
-            pthread_mutex_unlock(&g_module_lock);
+    LOGI("get handle of component %s successfully", cComponentName);
+    LOGV("%s(): exit done\n", __FUNCTION__);
+    return OMX_ErrorNone;
 
-            LOGE("%s(): exit failure, (ret : 0x%08x)\n", __FUNCTION__, ret);
-            return ret;
-        }
-    }
+delete_cbase:
+    delete cbase;
+unload_cmodule:
+    cmodule->Unload();
+unlock_list:
     pthread_mutex_unlock(&g_module_lock);
 
-    LOGE("%s(): exit failure, %s not found", __FUNCTION__, cComponentName);
-    return OMX_ErrorInvalidComponent;
+    LOGE("%s(): exit failure, (ret : 0x%08x)\n", __FUNCTION__, ret);
+    return ret;
 }
 
 OMX_API OMX_ERRORTYPE OMX_APIENTRY OMX_FreeHandle(
@@ -332,7 +739,7 @@ OMX_API OMX_ERRORTYPE OMX_GetComponentsOfRole (
     OMX_U32 nr_comps = 0, copied_nr_comps = 0;
 
     pthread_mutex_lock(&g_module_lock);
-    list_foreach(g_module_list, entry) {
+    list_foreach(role ? g_role_index[component_hash(role)] : NULL, entry) {
         CModule *cmodule;
         OMX_STRING cname;
         bool having_role;
@@ -369,37 +776,28 @@ OMX_API OMX_ERRORTYPE OMX_GetRolesOfComponent (
     OMX_INOUT OMX_U32 *pNumRoles,
     OMX_OUT OMX_U8 **roles)
 {
-    struct list *entry;
+    CModule *cmodule;
+    OMX_ERRORTYPE ret;
 
     pthread_mutex_lock(&g_module_lock);
-    list_foreach(g_module_list, entry) {
-        CModule *cmodule;
-        ComponentBase *cbase;
-        OMX_STRING cname;
-        OMX_ERRORTYPE ret;
+    cmodule = find_component(compName);
+    pthread_mutex_unlock(&g_module_lock);
 
-        cmodule = static_cast<CModule *>(entry->data);
+    if (!cmodule)
+        return OMX_ErrorInvalidComponent;
 
-        cname = cmodule->GetComponentName();
-        if (!strcmp(compName, cname)) {
-            pthread_mutex_unlock(&g_module_lock);
 #if LOG_NDEBUG
-            return cmodule->GetComponentRoles(pNumRoles, roles);
+    return cmodule->GetComponentRoles(pNumRoles, roles);
 #else
-            ret = cmodule->GetComponentRoles(pNumRoles, roles);
-            if (ret != OMX_ErrorNone) {
-                OMX_U32 i;
-
-                for (i = 0; i < *pNumRoles; i++) {
-                    LOGV("%s(): component %s has %s role", __FUNCTION__,
-                         compName, &roles[i][0]);
-                }
-            }
-            return ret;
-#endif
+    ret = cmodule->GetComponentRoles(pNumRoles, roles);
+    if (ret != OMX_ErrorNone) {
+        OMX_U32 i;
+
+        for (i = 0; i < *pNumRoles; i++) {
+            LOGV("%s(): component %s has %s role", __FUNCTION__,
+                 compName, &roles[i][0]);
         }
     }
-    pthread_mutex_unlock(&g_module_lock);
-
-    return OMX_ErrorInvalidComponent;
+    return ret;
+#endif
 }
@@ -0,0 +1,83 @@
+LOCAL_PATH := $(call my-dir)
+
+# component library stub, copied by the test as many libraries
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+	stub_component.cpp
+
+LOCAL_MODULE_TAGS := tests
+LOCAL_MODULE := libwrs_omxil_stub_component
+
+LOCAL_LDLIBS := -ldl
+
+LOCAL_C_INCLUDES := \
+	$(WRS_OMXIL_CORE_ROOT)/utils/inc \
+	$(WRS_OMXIL_CORE_ROOT)/base/inc \
+	$(WRS_OMXIL_CORE_ROOT)/core/inc/khronos/openmax/include \
+        $(TOP)/frameworks/native/include/media/openmax
+
+include $(BUILD_HOST_SHARED_LIBRARY)
+
+# host test of the component manifest and index
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+	wrs_omxcore_test.cpp \
+	../core/src/wrs_omxcore.cpp \
+	../base/src/cmodule.cpp \
+	../utils/src/list.c \
+	../utils/src/module.c
+
+LOCAL_MODULE_TAGS := tests
+LOCAL_MODULE := wrs_omxcore_test
+
+# the stubs find the load counter of the test
+LOCAL_LDFLAGS := -rdynamic
+
+LOCAL_LDLIBS := -ldl -lpthread -lrt
+
+LOCAL_C_INCLUDES := \
+	$(WRS_OMXIL_CORE_ROOT)/utils/inc \
+	$(WRS_OMXIL_CORE_ROOT)/base/inc \
+	$(WRS_OMXIL_CORE_ROOT)/core/inc/khronos/openmax/include \
+        $(TOP)/frameworks/native/include/media/openmax
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# host test of the list pool and the queues
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+	list_queue_test.c \
+	../utils/src/list.c \
+	../utils/src/queue.c
+
+LOCAL_MODULE_TAGS := tests
+LOCAL_MODULE := list_queue_test
+
+LOCAL_C_INCLUDES := \
+	$(WRS_OMXIL_CORE_ROOT)/utils/inc
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# host benchmark of the queues, counts the allocations
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+	list_queue_benchmark.c \
+	../utils/src/list.c \
+	../utils/src/queue.c
+
+LOCAL_MODULE_TAGS := tests
+LOCAL_MODULE := list_queue_benchmark
+
+LOCAL_CFLAGS := -O2
+LOCAL_LDFLAGS := -Wl,--wrap=malloc
+
+LOCAL_LDLIBS := -lrt
+
+LOCAL_C_INCLUDES := \
+	$(WRS_OMXIL_CORE_ROOT)/utils/inc
+
+include $(BUILD_HOST_EXECUTABLE)
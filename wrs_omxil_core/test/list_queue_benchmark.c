@@ -0,0 +1,294 @@
+/*
+ * list_queue_benchmark.c, host benchmark of the queues against the former
+ * malloc per node ones
+ *
+ * Copyright (c) 2014 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A buffer round trip is what a port and its work queue do per buffer:
+ * the buffer is pushed to the port queue, a work is scheduled, then the
+ * work and the buffer are popped. Linked with --wrap=malloc to count the
+ * allocations.
+ *
+ * usage: list_queue_benchmark [round trips]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <list.h>
+#include <queue.h>
+
+#define NR_BUFFERS 8  /* in flight on the port */
+#define NR_REMOVE 32  /* queue length for removals */
+
+/* volatile, malloc() is assumed not to touch the program's statics */
+static volatile unsigned long nr_mallocs;
+
+void *__real_malloc(size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    nr_mallocs++;
+    return __real_malloc(size);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void report(const char *name, double ns, unsigned long mallocs,
+                   long ops, long round_trips)
+{
+    printf("  %-28s %8.1f ns/op", name, ns / ops);
+    if (round_trips)
+        printf(" %8.3f allocs/round trip", (double)mallocs / round_trips);
+    printf("\n");
+}
+
+/*
+ * former list and queue, one node allocated per element and the work list
+ * walked to its tail
+ */
+static __attribute__((noinline)) struct list *legacy_list_alloc(void *data)
+{
+    struct list *new = malloc(sizeof(struct list));
+
+    if (new) {
+        new->prev = NULL;
+        new->next = NULL;
+        new->data = data;
+    }
+    return new;
+}
+
+static __attribute__((noinline)) struct list *
+legacy_list_add_tail(struct list *list, void *data)
+{
+    struct list *new = legacy_list_alloc(data), *last;
+
+    if (!new)
+        return NULL;
+    if (!list)
+        return new;
+
+    for (last = list; last->next; last = last->next)
+        ;
+    last->next = new;
+    new->prev = last;
+    return list;
+}
+
+static __attribute__((noinline)) struct list *
+legacy_list_delete(struct list *list, struct list *entry)
+{
+    if (entry->prev)
+        entry->prev->next = entry->next;
+    else
+        list = entry->next;
+    if (entry->next)
+        entry->next->prev = entry->prev;
+    free(entry);
+    return list;
+}
+
+static __attribute__((noinline)) int
+legacy_queue_push_tail(struct queue *queue, void *data)
+{
+    struct list *entry = legacy_list_alloc(data);
+
+    if (!entry)
+        return -1;
+    if (queue->tail) {
+        queue->tail->next = entry;
+        entry->prev = queue->tail;
+    }
+    else
+        queue->head = entry;
+    queue->tail = entry;
+    queue->length++;
+    return 0;
+}
+
+static __attribute__((noinline)) void *legacy_queue_pop_head(struct queue *queue)
+{
+    struct list *entry = queue->head;
+    void *data;
+
+    if (!entry)
+        return NULL;
+    data = entry->data;
+    queue->head = legacy_list_delete(queue->head, entry);
+    if (!queue->head)
+        queue->tail = NULL;
+    queue->length--;
+    return data;
+}
+
+static __attribute__((noinline)) struct list *
+legacy_list_delete_data(struct list *list, void *data)
+{
+    struct list *entry;
+
+    for (entry = list; entry; entry = entry->next) {
+        if (entry->data == data)
+            return legacy_list_delete(list, entry);
+    }
+    return list;
+}
+
+struct buffer {
+    int index;
+    struct list node;      /* port queue */
+    struct list work_node; /* work queue */
+};
+
+static struct buffer buffers[NR_BUFFERS];
+
+static void bench_round_trips(long round_trips)
+{
+    struct queue bufferq, works;
+    struct list *work_list = NULL;
+    unsigned long mallocs;
+    long i, ops = round_trips * 4;
+    int b;
+    double start, ns;
+
+    printf("buffer round trips, %d buffers in flight:\n", NR_BUFFERS);
+
+    /* former queue and work list */
+    __queue_init(&bufferq);
+    mallocs = nr_mallocs;
+    start = now_ns();
+    for (i = 0; i < round_trips; i += NR_BUFFERS) {
+        for (b = 0; b < NR_BUFFERS; b++) {
+            legacy_queue_push_tail(&bufferq, &buffers[b]);
+            work_list = legacy_list_add_tail(work_list, &buffers[b]);
+        }
+        for (b = 0; b < NR_BUFFERS; b++) {
+            work_list = legacy_list_delete(work_list, work_list);
+            legacy_queue_pop_head(&bufferq);
+        }
+    }
+    ns = now_ns() - start;
+    report("malloc per node", ns, nr_mallocs - mallocs, ops, round_trips);
+
+    /* pooled nodes */
+    __queue_init(&bufferq);
+    __queue_init(&works);
+    mallocs = nr_mallocs;
+    start = now_ns();
+    for (i = 0; i < round_trips; i += NR_BUFFERS) {
+        for (b = 0; b < NR_BUFFERS; b++) {
+            queue_push_tail(&bufferq, &buffers[b]);
+            queue_push_tail(&works, &buffers[b]);
+        }
+        for (b = 0; b < NR_BUFFERS; b++) {
+            queue_pop_head(&works);
+            queue_pop_head(&bufferq);
+        }
+    }
+    ns = now_ns() - start;
+    report("pooled nodes", ns, nr_mallocs - mallocs, ops, round_trips);
+    queue_free_all(&bufferq);
+    queue_free_all(&works);
+
+    /* nodes in the buffers */
+    __queue_init(&bufferq);
+    __queue_init(&works);
+    for (b = 0; b < NR_BUFFERS; b++) {
+        buffers[b].index = b;
+        __list_init(&buffers[b].node);
+        buffers[b].node.data = &buffers[b];
+        __list_init(&buffers[b].work_node);
+        buffers[b].work_node.data = &buffers[b];
+    }
+    mallocs = nr_mallocs;
+    start = now_ns();
+    for (i = 0; i < round_trips; i += NR_BUFFERS) {
+        for (b = 0; b < NR_BUFFERS; b++) {
+            __queue_push_tail(&bufferq, &buffers[b].node);
+            __queue_push_tail(&works, &buffers[b].work_node);
+        }
+        for (b = 0; b < NR_BUFFERS; b++) {
+            __queue_pop_head(&works);
+            __queue_pop_head(&bufferq);
+        }
+    }
+    ns = now_ns() - start;
+    report("intrusive nodes", ns, nr_mallocs - mallocs, ops, round_trips);
+}
+
+static void bench_remove(long removals)
+{
+    static int items[NR_REMOVE];
+    struct list *handles[NR_REMOVE];
+    struct list *list = NULL;
+    struct queue queue;
+    double start, ns;
+    long i;
+    int n;
+
+    printf("removal from the middle of %d elements:\n", NR_REMOVE);
+
+    for (n = 0; n < NR_REMOVE; n++)
+        list = legacy_list_add_tail(list, &items[n]);
+    start = now_ns();
+    for (i = 0; i < removals; i++) {
+        n = NR_REMOVE / 2 + (int)(i & 7);
+        list = legacy_list_delete_data(list, &items[n]);
+        list = legacy_list_add_tail(list, &items[n]);
+    }
+    ns = now_ns() - start;
+    report("by data, malloc per node", ns, 0, removals, 0);
+    while (list)
+        list = legacy_list_delete(list, list);
+
+    __queue_init(&queue);
+    for (n = 0; n < NR_REMOVE; n++) {
+        queue_push_tail(&queue, &items[n]);
+        handles[n] = queue.tail;
+    }
+    start = now_ns();
+    for (i = 0; i < removals; i++) {
+        n = NR_REMOVE / 2 + (int)(i & 7);
+        queue_remove(&queue, handles[n]);
+        queue_push_tail(&queue, &items[n]);
+        handles[n] = queue.tail;
+    }
+    ns = now_ns() - start;
+    report("by handle, pooled nodes", ns, 0, removals, 0);
+    queue_free_all(&queue);
+}
+
+int main(int argc, char *argv[])
+{
+    long round_trips = argc > 1 ? atol(argv[1]) : 4000000;
+
+    if (round_trips < NR_BUFFERS)
+        round_trips = NR_BUFFERS;
+    round_trips -= round_trips % NR_BUFFERS;
+
+    bench_round_trips(round_trips);
+    bench_remove(round_trips / 4);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,217 @@
+/*
+ * list_queue_test.c, host test of the list pool and the queues
+ *
+ * Copyright (c) 2014 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <list.h>
+#include <queue.h>
+
+#define NR_ITEMS 100
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            fprintf(stderr, "%s:%d: check failed: %s\n",                \
+                    __FILE__, __LINE__, #cond);                         \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+struct item {
+    int value;
+    struct list node;
+};
+
+static int items[NR_ITEMS];
+
+/* head to tail matches values[], and tail to head */
+static void check_queue(struct queue *queue, const int *values, int length)
+{
+    struct list *entry;
+    int i = 0;
+
+    CHECK(queue_length(queue) == length);
+
+    list_foreach(queue->head, entry) {
+        CHECK(i < length && entry->data == &items[values[i]]);
+        i++;
+    }
+    CHECK(i == length);
+
+    list_foreach_reverse(queue->tail, entry) {
+        i--;
+        CHECK(i >= 0 && entry->data == &items[values[i]]);
+    }
+    CHECK(i == 0);
+    CHECK(!queue->tail || !queue->tail->next);
+}
+
+static void test_pool(void)
+{
+    struct list_pool pool;
+    struct list *nodes[NR_ITEMS];
+    struct list *reused;
+    int i;
+
+    list_pool_init(&pool);
+
+    for (i = 0; i < NR_ITEMS; i++) {
+        nodes[i] = list_pool_alloc(&pool, &items[i]);
+        CHECK(nodes[i] && nodes[i]->data == &items[i]);
+        CHECK(!nodes[i]->next && !nodes[i]->prev);
+    }
+
+    /* a freed node is the next one given */
+    list_pool_free(&pool, nodes[42]);
+    reused = list_pool_alloc(&pool, &items[0]);
+    CHECK(reused == nodes[42]);
+    CHECK(reused->data == &items[0] && !reused->next && !reused->prev);
+
+    for (i = 0; i < NR_ITEMS; i++)
+        list_pool_free(&pool, nodes[i]);
+    for (i = 0; i < NR_ITEMS; i++)
+        CHECK(list_pool_alloc(&pool, NULL) != NULL);
+    CHECK(pool.free == NULL || pool.slabs != NULL);
+
+    list_pool_destroy(&pool);
+    CHECK(!pool.free && !pool.slabs);
+}
+
+static void test_queue(void)
+{
+    struct queue queue;
+    struct list *entry;
+    int i;
+
+    __queue_init(&queue);
+
+    for (i = 0; i < 4; i++)
+        CHECK(!queue_push_tail(&queue, &items[i]));
+    CHECK(!queue_push_head(&queue, &items[9]));
+    {
+        const int values[] = { 9, 0, 1, 2, 3 };
+        check_queue(&queue, values, 5);
+    }
+
+    CHECK(queue_pop_head(&queue) == &items[9]);
+    CHECK(queue_pop_tail(&queue) == &items[3]);
+    CHECK(queue.head->data == &items[0]);
+    CHECK(queue.tail->data == &items[2]);
+
+    /* removal by handle, in the middle and at both ends */
+    entry = queue.head->next;
+    CHECK(queue_remove(&queue, entry) == &items[1]);
+    {
+        const int values[] = { 0, 2 };
+        check_queue(&queue, values, 2);
+    }
+    CHECK(queue_remove(&queue, queue.tail) == &items[2]);
+    CHECK(queue_remove(&queue, queue.head) == &items[0]);
+    check_queue(&queue, NULL, 0);
+    CHECK(!queue.head && !queue.tail);
+    CHECK(queue_pop_head(&queue) == NULL);
+    CHECK(queue_pop_tail(&queue) == NULL);
+
+    for (i = 0; i < 12; i++)
+        queue_push_tail(&queue, &items[i % 3]);
+    queue_delete_all(&queue, &items[0]);
+    {
+        const int values[] = { 1, 2, 1, 2, 1, 2, 1, 2 };
+        check_queue(&queue, values, 8);
+    }
+    queue_delete_all(&queue, &items[2]);
+    queue_delete_all(&queue, &items[1]);
+    check_queue(&queue, NULL, 0);
+
+    /* push and pop reuse the nodes */
+    for (i = 0; i < NR_ITEMS; i++)
+        queue_push_tail(&queue, &items[i]);
+    for (i = 0; i < NR_ITEMS; i++)
+        CHECK(queue_pop_head(&queue) == &items[i]);
+    entry = queue.pool.free;
+    CHECK(entry != NULL);
+    queue_push_tail(&queue, &items[7]);
+    CHECK(queue.head == entry);
+
+    queue_free_all(&queue);
+    check_queue(&queue, NULL, 0);
+    CHECK(!queue.pool.slabs);
+}
+
+static void test_intrusive(void)
+{
+    struct item objects[8];
+    struct queue queue;
+    struct list *entry;
+    int i, expected;
+
+    __queue_init(&queue);
+
+    for (i = 0; i < 8; i++) {
+        objects[i].value = i;
+        __list_init(&objects[i].node);
+        objects[i].node.data = &objects[i];
+        __queue_push_tail(&queue, &objects[i].node);
+    }
+    CHECK(queue_length(&queue) == 8);
+    CHECK(!queue.pool.slabs);
+
+    /* the node is the handle of the object */
+    __queue_remove(&queue, &objects[3].node);
+    __queue_remove(&queue, &objects[7].node);
+    __queue_remove(&queue, &objects[0].node);
+    CHECK(queue_length(&queue) == 5);
+    CHECK(queue.tail == &objects[6].node);
+
+    expected = 1;
+    list_foreach(queue.head, entry) {
+        struct item *object = list_entry_of(entry, struct item, node);
+
+        CHECK(object->value == expected);
+        CHECK(entry->data == object);
+        expected += expected == 2 ? 2 : 1;
+    }
+    CHECK(expected == 7);
+
+    __queue_push_head(&queue, &objects[0].node);
+    CHECK(__queue_pop_head(&queue) == &objects[0].node);
+    CHECK(__queue_pop_tail(&queue) == &objects[6].node);
+    CHECK(queue_length(&queue) == 4);
+
+    /* caller nodes are not freed */
+    queue_free_all(&queue);
+    CHECK(queue_length(&queue) == 0 && !queue.head);
+}
+
+int main(void)
+{
+    test_pool();
+    test_queue();
+    test_intrusive();
+
+    if (failures) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+
+    printf("all checks passed\n");
+    return EXIT_SUCCESS;
+}
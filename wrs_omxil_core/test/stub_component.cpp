@@ -0,0 +1,83 @@
+/*
+ * stub_component.cpp, component library stub for the core test
+ *
+ * Copyright (c) 2014 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * The test copies this library to libstub_<n>.so, n giving the component
+ * name OMX.Stub.Component<n> and the roles stub_decoder.<n % 4> and
+ * stub_component.<n>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <dlfcn.h>
+
+#include <OMX_Core.h>
+
+#include <cmodule.h>
+
+#define STUB_NR_ROLES 2
+#define STUB_NR_DECODERS 4
+
+static char stub_name[OMX_MAX_STRINGNAME_SIZE];
+static char stub_role[STUB_NR_ROLES][OMX_MAX_STRINGNAME_SIZE];
+static const char *stub_roles[STUB_NR_ROLES] = {
+    stub_role[0],
+    stub_role[1],
+};
+
+/* no ComponentBase on the host, GetHandle stops here */
+static OMX_ERRORTYPE stub_instantiate(OMX_PTR *instance)
+{
+    *instance = NULL;
+    return OMX_ErrorNotImplemented;
+}
+
+static struct wrs_omxil_cmodule_ops_s stub_ops = {
+    stub_instantiate,
+};
+
+struct wrs_omxil_cmodule_s WRS_OMXIL_CMODULE_SYMBOL = {
+    stub_name,
+    stub_roles,
+    STUB_NR_ROLES,
+    &stub_ops,
+};
+
+__attribute__((constructor)) static void stub_init(void)
+{
+    void (*loaded)(void);
+    const char *file = "";
+    unsigned int n = 0;
+    Dl_info info;
+
+    if (dladdr(&WRS_OMXIL_CMODULE_SYMBOL, &info) && info.dli_fname) {
+        file = strrchr(info.dli_fname, '/');
+        file = file ? file + 1 : info.dli_fname;
+    }
+    sscanf(file, "libstub_%u", &n);
+
+    snprintf(stub_name, sizeof(stub_name), "OMX.Stub.Component%u", n);
+    snprintf(stub_role[0], sizeof(stub_role[0]), "stub_decoder.%u",
+             n % STUB_NR_DECODERS);
+    snprintf(stub_role[1], sizeof(stub_role[1]), "stub_component.%u", n);
+
+    /* counts the loads when the test exports it */
+    loaded = (void (*)(void))dlsym(RTLD_DEFAULT, "stub_component_loaded");
+    if (loaded)
+        loaded();
+}
@@ -0,0 +1,496 @@
+/*
+ * wrs_omxcore_test.cpp, host test of the component manifest and index
+ *
+ * Copyright (c) 2014 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Runs the core over copies of the stub component library, listed in
+ * ./wrs_omxil_components.list of a temporary directory, and reports the
+ * OMX_Init, OMX_GetHandle and lookup times with and without the manifest.
+ *
+ * usage: wrs_omxcore_test [libwrs_omxil_stub_component.so]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dlfcn.h>
+#include <libgen.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include <OMX_Core.h>
+#include <OMX_Component.h>
+
+#include <componentbase.h>
+
+#define NR_STUBS 32
+#define NR_RESIDENT 4 /* the first ones are listed with + */
+#define NR_DECODERS 4 /* see stub_component.cpp */
+#define NR_ROUNDS 20
+#define NR_LOOKUPS 100000
+
+#define STUB_LIBRARY "libwrs_omxil_stub_component.so"
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            fprintf(stderr, "%s:%d: check failed: %s\n",                \
+                    __FILE__, __LINE__, #cond);                         \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+/*
+ * The stubs cannot instantiate a component on the host, the core only needs
+ * these to link.
+ */
+void ComponentBase::SetName(const OMX_STRING name) { abort(); }
+const OMX_STRING ComponentBase::GetName(void) { abort(); }
+void ComponentBase::SetCModule(CModule *cmodule) { abort(); }
+CModule *ComponentBase::GetCModule(void) { abort(); }
+OMX_ERRORTYPE ComponentBase::SetRolesOfComponent(OMX_U32 nr_roles,
+                                                 const OMX_U8 **roles)
+{
+    abort();
+}
+OMX_ERRORTYPE ComponentBase::GetHandle(OMX_HANDLETYPE *pHandle,
+                                       OMX_PTR pAppData,
+                                       OMX_CALLBACKTYPE *pCallBacks)
+{
+    abort();
+}
+OMX_ERRORTYPE ComponentBase::FreeHandle(OMX_HANDLETYPE hComponent)
+{
+    abort();
+}
+
+/* called by each stub when loaded */
+static int g_stub_loads;
+
+extern "C" void stub_component_loaded(void)
+{
+    g_stub_loads++;
+}
+
+static char g_dir[] = "/tmp/wrs_omxcore_testXXXXXX";
+static char g_manifest[sizeof(g_dir) + 32];
+
+static double now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void stub_path(char *path, size_t len, int n)
+{
+    snprintf(path, len, "%s/libstub_%d.so", g_dir, n);
+}
+
+static int copy_file(const char *from, const char *to)
+{
+    FILE *in, *out;
+    char buf[4096];
+    size_t len;
+    int ret = 0;
+
+    in = fopen(from, "rb");
+    if (!in)
+        return -1;
+    out = fopen(to, "wb");
+    if (!out) {
+        fclose(in);
+        return -1;
+    }
+
+    while ((len = fread(buf, 1, sizeof(buf), in)) > 0) {
+        if (fwrite(buf, 1, len, out) != len)
+            ret = -1;
+    }
+
+    fclose(in);
+    if (fclose(out))
+        ret = -1;
+    return ret;
+}
+
+static int write_list(int nr_stubs)
+{
+    FILE *file;
+    char path[256];
+    int i;
+
+    file = fopen("wrs_omxil_components.list", "w");
+    if (!file)
+        return -1;
+
+    fprintf(file, "# stub components\n");
+    for (i = 0; i < nr_stubs; i++) {
+        stub_path(path, sizeof(path), i);
+        fprintf(file, "%s%s\n", i < NR_RESIDENT ? "+" : "", path);
+    }
+
+    return fclose(file);
+}
+
+static int count_lines(const char *path)
+{
+    FILE *file;
+    int c, lines = 0;
+
+    file = fopen(path, "r");
+    if (!file)
+        return -1;
+    while ((c = fgetc(file)) != EOF) {
+        if (c == '\n')
+            lines++;
+    }
+    fclose(file);
+
+    return lines;
+}
+
+static bool is_loaded(int n)
+{
+    char path[256];
+    void *handle;
+
+    stub_path(path, sizeof(path), n);
+    handle = dlopen(path, RTLD_NOW | RTLD_NOLOAD);
+    if (!handle)
+        return false;
+
+    dlclose(handle);
+    return true;
+}
+
+static int count_loaded(int nr_stubs)
+{
+    int i, loaded = 0;
+
+    for (i = 0; i < nr_stubs; i++)
+        loaded += is_loaded(i);
+
+    return loaded;
+}
+
+/* OMX_Init, returns the number of stubs it loaded */
+static int init(void)
+{
+    int loads = g_stub_loads;
+
+    CHECK(OMX_Init() == OMX_ErrorNone);
+    return g_stub_loads - loads;
+}
+
+static void test_components(int nr_stubs)
+{
+    char name[OMX_MAX_STRINGNAME_SIZE];
+    char expected[OMX_MAX_STRINGNAME_SIZE];
+    OMX_U8 role_buf[2][OMX_MAX_STRINGNAME_SIZE];
+    OMX_U8 *roles[2] = { role_buf[0], role_buf[1] };
+    OMX_U8 comp_buf[NR_STUBS][OMX_MAX_STRINGNAME_SIZE];
+    OMX_U8 *comps[NR_STUBS];
+    OMX_U32 nr;
+    int i;
+
+    /* enumeration follows the list */
+    for (i = 0; i < nr_stubs; i++) {
+        snprintf(expected, sizeof(expected), "OMX.Stub.Component%d", i);
+        CHECK(OMX_ComponentNameEnum(name, sizeof(name), i) == OMX_ErrorNone);
+        CHECK(!strcmp(name, expected));
+    }
+    CHECK(OMX_ComponentNameEnum(name, sizeof(name), nr_stubs) ==
+          OMX_ErrorNoMore);
+
+    CHECK(OMX_GetRolesOfComponent((OMX_STRING)"OMX.Stub.Component5", &nr,
+                                  NULL) == OMX_ErrorNone);
+    CHECK(nr == 2);
+    CHECK(OMX_GetRolesOfComponent((OMX_STRING)"OMX.Stub.Component5", &nr,
+                                  roles) == OMX_ErrorNone);
+    CHECK(!strcmp((char *)roles[0], "stub_decoder.1"));
+    CHECK(!strcmp((char *)roles[1], "stub_component.5"));
+    CHECK(OMX_GetRolesOfComponent((OMX_STRING)"OMX.Stub.Missing", &nr,
+                                  NULL) == OMX_ErrorInvalidComponent);
+
+    /* components of a role in list order */
+    CHECK(OMX_GetComponentsOfRole((OMX_STRING)"stub_decoder.3", &nr,
+                                  NULL) == OMX_ErrorNone);
+    CHECK(nr == (OMX_U32)(nr_stubs / NR_DECODERS));
+    for (i = 0; i < NR_STUBS; i++)
+        comps[i] = comp_buf[i];
+    CHECK(OMX_GetComponentsOfRole((OMX_STRING)"stub_decoder.3", &nr,
+                                  comps) == OMX_ErrorNone);
+    for (i = 0; i < (int)nr; i++) {
+        snprintf(expected, sizeof(expected), "OMX.Stub.Component%d",
+                 3 + i * NR_DECODERS);
+        CHECK(!strcmp((char *)comps[i], expected));
+    }
+
+    CHECK(OMX_GetComponentsOfRole((OMX_STRING)"stub_component.7", &nr,
+                                  NULL) == OMX_ErrorNone);
+    CHECK(nr == 1);
+    CHECK(OMX_GetComponentsOfRole((OMX_STRING)"stub_encoder", &nr,
+                                  NULL) == OMX_ErrorNone);
+    CHECK(nr == 0);
+}
+
+static void test_manifest(void)
+{
+    char path[256];
+    struct timeval times[2];
+    struct stat st;
+    FILE *file;
+    int loads;
+
+    unlink(g_manifest);
+
+    /* first start loads every library and writes the manifest */
+    loads = init();
+    CHECK(loads == NR_STUBS);
+    CHECK(count_lines(g_manifest) == NR_STUBS + 1);
+    test_components(NR_STUBS);
+
+    /* hot codecs stay loaded, until OMX_Deinit */
+    CHECK(count_loaded(NR_STUBS) == NR_RESIDENT);
+    CHECK(OMX_Deinit() == OMX_ErrorNone);
+    CHECK(count_loaded(NR_STUBS) == 0);
+
+    /* then only the resident ones are loaded */
+    loads = init();
+    CHECK(loads == NR_RESIDENT);
+    test_components(NR_STUBS);
+    CHECK(count_loaded(NR_STUBS) == NR_RESIDENT);
+    CHECK(OMX_Deinit() == OMX_ErrorNone);
+
+    /* a library with another mtime is loaded again */
+    stub_path(path, sizeof(path), NR_STUBS - 1);
+    times[0].tv_sec = times[1].tv_sec = time(NULL) - 3600;
+    times[0].tv_usec = times[1].tv_usec = 0;
+    CHECK(!utimes(path, times));
+    loads = init();
+    CHECK(loads == NR_RESIDENT + 1);
+    test_components(NR_STUBS);
+    CHECK(OMX_Deinit() == OMX_ErrorNone);
+    CHECK(init() == NR_RESIDENT);
+    CHECK(OMX_Deinit() == OMX_ErrorNone);
+
+    /* libraries no longer listed leave the manifest */
+    CHECK(!write_list(NR_STUBS / 2));
+    CHECK(init() == NR_RESIDENT);
+    test_components(NR_STUBS / 2);
+    CHECK(OMX_Deinit() == OMX_ErrorNone);
+    CHECK(count_lines(g_manifest) == NR_STUBS / 2 + 1);
+    CHECK(!write_list(NR_STUBS));
+    CHECK(init() == NR_RESIDENT + NR_STUBS / 2);
+    CHECK(OMX_Deinit() == OMX_ErrorNone);
+
+    /* a damaged manifest only costs the loads */
+    CHECK(!stat(g_manifest, &st) && !truncate(g_manifest, st.st_size / 2));
+    CHECK(init() > NR_RESIDENT);
+    test_components(NR_STUBS);
+    CHECK(OMX_Deinit() == OMX_ErrorNone);
+    CHECK(init() == NR_RESIDENT);
+    CHECK(OMX_Deinit() == OMX_ErrorNone);
+
+    file = fopen(g_manifest, "w");
+    CHECK(file != NULL);
+    if (file) {
+        fputs("wrs_omxil_manifest 0\n", file);
+        fclose(file);
+    }
+    CHECK(init() == NR_STUBS);
+    CHECK(OMX_Deinit() == OMX_ErrorNone);
+
+    /* disabled, the libraries are loaded every time */
+    unlink(g_manifest);
+    setenv("WRS_OMXIL_MANIFEST", "", 1);
+    CHECK(init() == NR_STUBS);
+    test_components(NR_STUBS);
+    CHECK(OMX_Deinit() == OMX_ErrorNone);
+    CHECK(access(g_manifest, F_OK));
+    CHECK(init() == NR_STUBS);
+    CHECK(OMX_Deinit() == OMX_ErrorNone);
+    setenv("WRS_OMXIL_MANIFEST", g_manifest, 1);
+}
+
+static void test_get_handle(void)
+{
+    OMX_HANDLETYPE handle = NULL;
+    OMX_CALLBACKTYPE callbacks;
+
+    CHECK(init() >= NR_RESIDENT);
+
+    /* loaded for the instance, unloaded after the stub fails it */
+    CHECK(OMX_GetHandle(&handle, (OMX_STRING)"OMX.Stub.Component9", NULL,
+                        &callbacks) == OMX_ErrorNotImplemented);
+    CHECK(!is_loaded(9));
+    CHECK(OMX_GetHandle(&handle, (OMX_STRING)"OMX.Stub.Component0", NULL,
+                        &callbacks) == OMX_ErrorNotImplemented);
+    CHECK(is_loaded(0));
+    CHECK(OMX_GetHandle(&handle, (OMX_STRING)"OMX.Stub.Missing", NULL,
+                        &callbacks) == OMX_ErrorInvalidComponent);
+
+    CHECK(OMX_Deinit() == OMX_ErrorNone);
+}
+
+static double time_init(void)
+{
+    double start, ms = 0.0;
+    int i;
+
+    for (i = 0; i < NR_ROUNDS; i++) {
+        start = now_ms();
+        OMX_Init();
+        ms += now_ms() - start;
+        OMX_Deinit();
+    }
+
+    return ms / NR_ROUNDS;
+}
+
+static double time_get_handle(const char *name)
+{
+    OMX_HANDLETYPE handle;
+    OMX_CALLBACKTYPE callbacks;
+    double start;
+    int i;
+
+    start = now_ms();
+    for (i = 0; i < NR_ROUNDS * 10; i++)
+        OMX_GetHandle(&handle, (OMX_STRING)name, NULL, &callbacks);
+
+    return (now_ms() - start) * 1e3 / (NR_ROUNDS * 10);
+}
+
+static double time_lookup(void)
+{
+    char name[OMX_MAX_STRINGNAME_SIZE];
+    OMX_U32 nr;
+    double start;
+    int i;
+
+    start = now_ms();
+    for (i = 0; i < NR_LOOKUPS; i++) {
+        snprintf(name, sizeof(name), "OMX.Stub.Component%d", i % NR_STUBS);
+        OMX_GetRolesOfComponent(name, &nr, NULL);
+        OMX_GetComponentsOfRole((OMX_STRING)"stub_decoder.2", &nr, NULL);
+    }
+
+    return (now_ms() - start) * 1e6 / NR_LOOKUPS;
+}
+
+static void report(void)
+{
+    double disabled, warm;
+    int log_fd, null_fd;
+
+    /* the core logs to stderr on the host, keep it out of the timings */
+    fflush(stderr);
+    log_fd = dup(STDERR_FILENO);
+    null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDERR_FILENO);
+    close(null_fd);
+
+    setenv("WRS_OMXIL_MANIFEST", "", 1);
+    disabled = time_init();
+    setenv("WRS_OMXIL_MANIFEST", g_manifest, 1);
+    OMX_Init();
+    OMX_Deinit();
+    warm = time_init();
+
+    printf("OMX_Init of %d libraries, %d resident:\n", NR_STUBS, NR_RESIDENT);
+    printf("  %-24s %8.3f ms\n", "without manifest", disabled);
+    printf("  %-24s %8.3f ms (%.1fx)\n", "with manifest", warm,
+           disabled / warm);
+
+    OMX_Init();
+    printf("OMX_GetHandle up to the instance:\n");
+    printf("  %-24s %8.2f us\n", "loaded on demand",
+           time_get_handle("OMX.Stub.Component31"));
+    printf("  %-24s %8.2f us\n", "resident",
+           time_get_handle("OMX.Stub.Component0"));
+    printf("name and role lookup: %.0f ns\n", time_lookup());
+    OMX_Deinit();
+
+    fflush(stderr);
+    dup2(log_fd, STDERR_FILENO);
+    close(log_fd);
+}
+
+int main(int argc, char *argv[])
+{
+    char stub[256], exe[256], path[256];
+    ssize_t len;
+    int i;
+
+    if (argc > 1) {
+        snprintf(stub, sizeof(stub), "%s", argv[1]);
+    } else {
+        /* host layout, bin/ next to lib/ */
+        len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+        exe[len > 0 ? len : 0] = '\0';
+        snprintf(stub, sizeof(stub), "%s/../lib/%s", dirname(exe),
+                 STUB_LIBRARY);
+    }
+
+    if (!mkdtemp(g_dir) || chdir(g_dir)) {
+        perror(g_dir);
+        return EXIT_FAILURE;
+    }
+    snprintf(g_manifest, sizeof(g_manifest), "%s/manifest", g_dir);
+    setenv("WRS_OMXIL_MANIFEST", g_manifest, 1);
+
+    for (i = 0; i < NR_STUBS; i++) {
+        stub_path(path, sizeof(path), i);
+        if (copy_file(stub, path)) {
+            fprintf(stderr, "cannot copy %s\n", stub);
+            return EXIT_FAILURE;
+        }
+    }
+    if (write_list(NR_STUBS)) {
+        perror("wrs_omxil_components.list");
+        return EXIT_FAILURE;
+    }
+
+    test_manifest();
+    test_get_handle();
+    if (!failures)
+        report();
+
+    for (i = 0; i < NR_STUBS; i++) {
+        stub_path(path, sizeof(path), i);
+        unlink(path);
+    }
+    unlink(g_manifest);
+    unlink("wrs_omxil_components.list");
+    rmdir(g_dir);
+
+    if (failures) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+
+    printf("all checks passed\n");
+    return EXIT_SUCCESS;
+}
@@ -19,6 +19,8 @@
 #ifndef __LIST_H
 #define __LIST_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -58,6 +60,34 @@ struct list *list_delete_all(struct list *, void *);
 struct list *list_find(struct list *, void *);
 struct list *list_find_reverse(struct list *, void *);
 
+/*
+ * intrusive list
+ *
+ * a struct list embedded in the listed object is linked by the __list_*()
+ * functions, which never allocate, and is its O(1) handle for
+ * __list_remove(). list_entry_of() gives the object back.
+ */
+#define list_entry_of(entry, type, member) \
+    ((type *)((char *)(entry) - offsetof(type, member)))
+
+/*
+ * list node pool
+ *
+ * nodes are carved from slabs owned by the pool and return to it when
+ * freed, a list churning through nodes stops allocating at its depth.
+ */
+struct list_pool {
+    struct list *free;
+    struct list *slabs;
+    int slab_length;
+};
+
+void list_pool_init(struct list_pool *);
+void list_pool_destroy(struct list_pool *);
+
+struct list *list_pool_alloc(struct list_pool *, void *);
+void list_pool_free(struct list_pool *, struct list *);
+
 #define __list_next(entry) ((entry) ? (entry->next) : NULL)
 #define __list_prev(entry) ((entry) ? (entry->prev) : NULL)
 
@@ -25,10 +25,17 @@
 extern "C" {
 #endif
 
+/*
+ * queue_*() take the nodes of data from the queue pool, they allocate only
+ * until the queue has reached its depth. __queue_*() link caller nodes,
+ * see intrusive list in list.h; a queue uses one kind or the other.
+ */
 struct queue {
 	struct list *head;
 	struct list *tail;
 	int  length;
+
+	struct list_pool pool;
 };
 
 void __queue_init(struct queue *queue);
@@ -48,6 +55,10 @@ void *queue_pop_head(struct queue *queue);
 struct list *__queue_pop_tail(struct queue *queue);
 void *queue_pop_tail(struct queue *queue);
 
+void __queue_remove(struct queue *queue, struct list *entry);
+void *queue_remove(struct queue *queue, struct list *entry);
+void queue_delete_all(struct queue *queue, void *data);
+
 inline struct list *__queue_peek_head(struct queue *queue);
 inline struct list *__queue_peek_tail(struct queue *queue);
 inline void *queue_peek_head(struct queue *queue);
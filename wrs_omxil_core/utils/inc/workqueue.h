@@ -21,6 +21,7 @@
 
 #include <pthread.h>
 #include <list.h>
+#include <queue.h>
 
 #include <thread.h>
 
@@ -97,7 +98,7 @@ private:
      */
     void DoWork(WorkableInterface *wi);
 
-    struct list *works;
+    struct queue works;
     pthread_mutex_t wlock;
     pthread_cond_t wcond;
 
@@ -270,3 +270,79 @@ struct list *list_find_reverse(struct list *list, void *data)
 
     return ptr;
 }
+
+/*
+ * list node pool
+ */
+#define LIST_POOL_FIRST_SLAB 8
+#define LIST_POOL_MAX_SLAB 128
+
+void list_pool_init(struct list_pool *pool)
+{
+    pool->free = NULL;
+    pool->slabs = NULL;
+    pool->slab_length = LIST_POOL_FIRST_SLAB;
+}
+
+void list_pool_destroy(struct list_pool *pool)
+{
+    struct list *slab, *next;
+
+    for (slab = pool->slabs; slab; slab = next) {
+        next = slab->next;
+        free(slab);
+    }
+
+    list_pool_init(pool);
+}
+
+/* the first node of a slab links the slabs, the others are free nodes */
+static int list_pool_grow(struct list_pool *pool)
+{
+    struct list *slab;
+    int i;
+
+    slab = malloc(sizeof(struct list) * pool->slab_length);
+    if (!slab)
+        return -1;
+
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+
+    for (i = pool->slab_length - 1; i > 0; i--) {
+        slab[i].next = pool->free;
+        pool->free = &slab[i];
+    }
+
+    if (pool->slab_length < LIST_POOL_MAX_SLAB)
+        pool->slab_length *= 2;
+
+    return 0;
+}
+
+struct list *list_pool_alloc(struct list_pool *pool, void *data)
+{
+    struct list *new;
+
+    if (!pool->free && list_pool_grow(pool))
+        return NULL;
+
+    new = pool->free;
+    pool->free = new->next;
+
+    new->prev = NULL;
+    new->next = NULL;
+    new->data = data;
+
+    return new;
+}
+
+void list_pool_free(struct list_pool *pool, struct list *entry)
+{
+    if (entry) {
+        entry->prev = NULL;
+        entry->data = NULL;
+        entry->next = pool->free;
+        pool->free = entry;
+    }
+}
@@ -131,7 +131,7 @@ struct module *module_open(const char *file, int flag)
 
     existing = module_find_with_name(g_module_head, file);
     if (existing) {
-        LOGE("found opened module %s with name\n", existing->name);
+        LOGV("found opened module %s with name\n", existing->name);
         existing->ref_count++;
         pthread_mutex_unlock(&g_lock);
         return existing;
@@ -25,6 +25,8 @@ inline void __queue_init(struct queue *queue)
 	queue->head = NULL;
 	queue->tail = NULL;
 	queue->length = 0;
+
+	list_pool_init(&queue->pool);
 }
 
 struct queue *queue_alloc(void)
@@ -43,11 +45,10 @@ inline void __queue_free(struct queue *queue)
 	free(queue);
 }
 
+/* the nodes of __queue_push_*() are the caller's, they are only dropped */
 void queue_free_all(struct queue *queue)
 {
-	struct list *list = queue->head;
-
-	list_free_all(list);
+	list_pool_destroy(&queue->pool);
 	__queue_init(queue);
 }
 
@@ -62,7 +63,7 @@ void __queue_push_head(struct queue *queue, struct list *entry)
 
 int queue_push_head(struct queue *queue, void *data)
 {
-	struct list *entry = list_alloc(data);
+	struct list *entry = list_pool_alloc(&queue->pool, data);
 
 	if (!entry)
 		return -1;
@@ -78,10 +79,7 @@ int queue_push_head(struct queue *queue, void *data)
 
 void __queue_push_tail(struct queue *queue, struct list *entry)
 {
-        queue->tail = list_add_tail(queue->tail, entry);
-        if (queue->tail == NULL) {
-                return;
-        }
+	queue->tail = __list_add_tail(queue->tail, entry);
 	if (queue->tail->next)
 		queue->tail = queue->tail->next;
 	else
@@ -92,7 +90,7 @@ void __queue_push_tail(struct queue *queue, struct list *entry)
 
 int queue_push_tail(struct queue *queue, void *data)
 {
-	struct list *entry = list_alloc(data);
+	struct list *entry = list_pool_alloc(&queue->pool, data);
 
 	if (!entry)
 		return -1;
@@ -131,7 +129,7 @@ void *queue_pop_head(struct queue *queue)
 	entry = __queue_pop_head(queue);
 	if (entry) {
 		data = entry->data;
-		__list_free(entry);
+		list_pool_free(&queue->pool, entry);
 	}
 
 	return data;
@@ -160,12 +158,42 @@ void *queue_pop_tail(struct queue *queue)
 	entry = __queue_pop_tail(queue);
 	if (entry) {
 		data = entry->data;
-		__list_free(entry);
+		list_pool_free(&queue->pool, entry);
 	}
 
 	return data;
 }
 
+/* entry is a handle of the queue, from __queue_push_*() or a peek */
+void __queue_remove(struct queue *queue, struct list *entry)
+{
+	if (entry == queue->tail)
+		queue->tail = entry->prev;
+	queue->head = __list_remove(queue->head, entry);
+
+	queue->length--;
+}
+
+void *queue_remove(struct queue *queue, struct list *entry)
+{
+	void *data = entry->data;
+
+	__queue_remove(queue, entry);
+	list_pool_free(&queue->pool, entry);
+
+	return data;
+}
+
+void queue_delete_all(struct queue *queue, void *data)
+{
+	struct list *entry, *next;
+
+	list_foreach_safe(queue->head, entry, next) {
+		if (entry->data == data)
+			queue_remove(queue, entry);
+	}
+}
+
 inline struct list *__queue_peek_head(struct queue *queue)
 {
 	return queue->head;
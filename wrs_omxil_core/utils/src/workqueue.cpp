@@ -24,7 +24,7 @@ WorkQueue::WorkQueue()
     stop = false;
     executing = true;
     wait_for_works = false;
-    works = NULL;
+    __queue_init(&works);
 
     pthread_mutex_init(&wlock, NULL);
     pthread_cond_init(&wcond, NULL);
@@ -38,6 +38,8 @@ WorkQueue::~WorkQueue()
 {
     StopWork();
 
+    queue_free_all(&works);
+
     pthread_cond_destroy(&wcond);
     pthread_mutex_destroy(&wlock);
 
@@ -60,8 +62,8 @@ void WorkQueue::StopWork(void)
 {
     /* discard all scheduled works */
     pthread_mutex_lock(&wlock);
-    while (works)
-        works = __list_delete(works, works);
+    while (queue_length(&works))
+        queue_pop_head(&works);
     pthread_mutex_unlock(&wlock);
 
     /*  wakeup DoWork() if it's sleeping */
@@ -113,7 +115,7 @@ void WorkQueue::Run(void)
             break;
         }
 
-        if (!works) {
+        if (!queue_length(&works)) {
             pthread_mutex_lock(&executing_lock);
             wait_for_works = true;
             /* wake up PauseWork() if it's sleeping */
@@ -131,12 +133,10 @@ void WorkQueue::Run(void)
             pthread_mutex_unlock(&executing_lock);
         }
 
-        while (works) {
-            struct list *entry = works;
+        while (queue_length(&works)) {
             WorkableInterface *wi =
-                static_cast<WorkableInterface *>(entry->data);
+                static_cast<WorkableInterface *>(queue_pop_head(&works));
 
-            works = __list_delete(works, entry);
             pthread_mutex_unlock(&wlock);
 
             /*
@@ -177,7 +177,7 @@ void WorkQueue::Work(void)
 void WorkQueue::ScheduleWork(void)
 {
     pthread_mutex_lock(&wlock);
-    works = list_add_tail(works, static_cast<WorkableInterface *>(this));
+    queue_push_tail(&works, static_cast<WorkableInterface *>(this));
     pthread_cond_signal(&wcond); /* wakeup Run() if it's sleeping */
     pthread_mutex_unlock(&wlock);
 }
@@ -186,9 +186,9 @@ void WorkQueue::ScheduleWork(WorkableInterface *wi)
 {
     pthread_mutex_lock(&wlock);
     if (wi)
-        works = list_add_tail(works, wi);
+        queue_push_tail(&works, wi);
     else
-        works = list_add_tail(works, static_cast<WorkableInterface *>(this));
+        queue_push_tail(&works, static_cast<WorkableInterface *>(this));
     pthread_cond_signal(&wcond); /* wakeup Run() if it's sleeping */
     pthread_mutex_unlock(&wlock);
 }
@@ -196,7 +196,7 @@ void WorkQueue::ScheduleWork(WorkableInterface *wi)
 void WorkQueue::CancelScheduledWork(WorkableInterface *wi)
 {
     pthread_mutex_lock(&wlock);
-    works = list_delete_all(works, wi);
+    queue_delete_all(&works, wi);
     pthread_mutex_unlock(&wlock);
 }
 
@@ -206,8 +206,8 @@ void WorkQueue::FlushWork(void)
     bool needtowait = false;
 
     pthread_mutex_lock(&wlock);
-    if (works) {
-        list_add_tail(works, &fb);
+    if (queue_length(&works)) {
+        queue_push_tail(&works, static_cast<WorkableInterface *>(&fb));
         pthread_cond_signal(&wcond); /* wakeup Run() if it's sleeping */
 
         needtowait = true;